@@ -0,0 +1,228 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-benchmark-check.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/* Checks the latest benchmark run of drives against their earlier runs,
+ * see mdu_benchmark_history_find_regressions(). Without arguments all
+ * histories in the cache directory of the user are checked, e.g.
+ *
+ *   sudo mdu-benchmark-check
+ *   mdu-benchmark-check ~/.cache/mate-disk-utility/drive-benchmark/ATA-*.history
+ *
+ * The exit status is 1 if a regression was found so this can run from
+ * cron or a monitoring system; 2 means a history couldn't be read.
+ */
+
+#include "config.h"
+
+#include "mdu/mdu.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+
+#include <stdio.h>
+#include <time.h>
+
+static gboolean opt_verbose = FALSE;
+static gchar **opt_files = NULL;
+
+static GOptionEntry entries[] = {
+        { "verbose", 'v', 0, G_OPTION_ARG_NONE, &opt_verbose, "Also list drives without regressions", NULL },
+        { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &opt_files, NULL, "[HISTORY...]" },
+        { NULL }
+};
+
+static const gchar *
+get_kind_for_display (MduBenchmarkRegressionKind kind)
+{
+        switch (kind) {
+        case MDU_BENCHMARK_REGRESSION_KIND_READ_RATE:
+                return "read rate";
+        case MDU_BENCHMARK_REGRESSION_KIND_WRITE_RATE:
+                return "write rate";
+        case MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME:
+                return "access time";
+        }
+        return "?";
+}
+
+static gchar *
+get_value_for_display (MduBenchmarkRegressionKind kind,
+                       gdouble                    value)
+{
+        if (kind == MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME)
+                return g_strdup_printf ("%.2f ms", value * 1000.0);
+        else
+                return g_strdup_printf ("%.1f MB/s", value / (1000.0 * 1000.0));
+}
+
+/* returns the number of regressions found or -1 on error */
+static gint
+check_history (const gchar *filename)
+{
+        MduBenchmarkHistory *history;
+        MduBenchmarkHistoryRun run;
+        GArray *regressions;
+        GError *error;
+        guint num_baseline_runs;
+        gchar time_buf[256];
+        time_t t;
+        gint index;
+        guint n;
+        gint ret;
+
+        ret = -1;
+        regressions = NULL;
+
+        error = NULL;
+        history = mdu_benchmark_history_new (filename, &error);
+        if (history == NULL) {
+                g_printerr ("%s: %s\n", filename, error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        /* the newest run with something to compare; random and sweep runs don't sample positions */
+        for (index = mdu_benchmark_history_get_num_runs (history) - 1; index >= 0; index--) {
+                mdu_benchmark_history_get_run (history, index, &run);
+                if (run.num_read_samples > 0 || run.num_access_samples > 0)
+                        break;
+        }
+        if (index < 0) {
+                if (opt_verbose)
+                        g_print ("%s: no transfer rate runs\n", filename);
+                ret = 0;
+                goto out;
+        }
+
+        regressions = mdu_benchmark_history_find_regressions (history, index, &num_baseline_runs);
+
+        t = run.time_collected;
+        strftime (time_buf, sizeof time_buf, "%c", localtime (&t));
+
+        if (regressions->len > 0 || opt_verbose) {
+                g_print ("%s: run of %s compared with %u earlier runs: %s\n",
+                         filename,
+                         time_buf,
+                         num_baseline_runs,
+                         regressions->len > 0 ? "REGRESSED" : "ok");
+        }
+
+        for (n = 0; n < regressions->len; n++) {
+                MduBenchmarkRegression *regression = &g_array_index (regressions, MduBenchmarkRegression, n);
+                gchar *value;
+                gchar *baseline_value;
+
+                value = get_value_for_display (regression->kind, regression->value);
+                baseline_value = get_value_for_display (regression->kind, regression->baseline_value);
+                g_print ("  %s %+.0f%% (%s vs. %s, z=%.1f) at %d%%-%d%% of the device\n",
+                         get_kind_for_display (regression->kind),
+                         100.0 * (regression->value - regression->baseline_value) / regression->baseline_value,
+                         value,
+                         baseline_value,
+                         regression->z_score,
+                         (gint) (100.0 * regression->start_offset / run.disk_size),
+                         (gint) (100.0 * regression->end_offset / run.disk_size));
+                g_free (baseline_value);
+                g_free (value);
+        }
+
+        ret = regressions->len;
+
+ out:
+        if (regressions != NULL)
+                g_array_unref (regressions);
+        if (history != NULL)
+                g_object_unref (history);
+        return ret;
+}
+
+int
+main (int argc, char *argv[])
+{
+        GOptionContext *context;
+        GError *error;
+        GPtrArray *files;
+        gchar *dirname;
+        GDir *dir;
+        const gchar *name;
+        gboolean found_regression;
+        gboolean had_error;
+        guint n;
+        gint ret;
+
+        ret = 2;
+        files = g_ptr_array_new_with_free_func (g_free);
+
+        g_type_init ();
+
+        context = g_option_context_new ("- check drives for benchmark regressions");
+        g_option_context_add_main_entries (context, entries, NULL);
+        error = NULL;
+        if (!g_option_context_parse (context, &argc, &argv, &error)) {
+                g_printerr ("Could not parse arguments: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        if (opt_files != NULL) {
+                for (n = 0; opt_files[n] != NULL; n++)
+                        g_ptr_array_add (files, g_strdup (opt_files[n]));
+        } else {
+                dirname = g_build_filename (g_get_user_cache_dir (),
+                                            "mate-disk-utility",
+                                            "drive-benchmark",
+                                            NULL);
+                dir = g_dir_open (dirname, 0, NULL);
+                if (dir != NULL) {
+                        while ((name = g_dir_read_name (dir)) != NULL) {
+                                if (g_str_has_suffix (name, ".history"))
+                                        g_ptr_array_add (files, g_build_filename (dirname, name, NULL));
+                        }
+                        g_dir_close (dir);
+                }
+                g_free (dirname);
+        }
+
+        found_regression = FALSE;
+        had_error = FALSE;
+        for (n = 0; n < files->len; n++) {
+                gint num_regressions;
+
+                num_regressions = check_history (files->pdata[n]);
+                if (num_regressions < 0)
+                        had_error = TRUE;
+                else if (num_regressions > 0)
+                        found_regression = TRUE;
+        }
+
+        if (had_error)
+                ret = 2;
+        else if (found_regression)
+                ret = 1;
+        else
+                ret = 0;
+
+ out:
+        g_ptr_array_unref (files);
+        g_strfreev (opt_files);
+        g_option_context_free (context);
+        return ret;
+}
@@ -0,0 +1,529 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-benchmark-tool.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/* Runs the same benchmarks as the drive benchmark dialog without a
+ * display, e.g. from provisioning scripts:
+ *
+ *   mdu-benchmark /dev/sdb
+ *   mdu-benchmark --mode=random --format=csv /dev/sdb > sdb-random.csv
+ *   mdu-benchmark --mode=write --force /dev/sdc
+ *
+ * Results are printed as JSON (default) or CSV and appended to the
+ * drive's MduBenchmarkHistory so they show up in the dialog and are
+ * checked by mdu-benchmark-check.
+ */
+
+#include "config.h"
+
+#include "mdu/mdu.h"
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+static gchar *opt_mode = NULL;
+static gchar *opt_format = NULL;
+static gchar *opt_io_engine = NULL;
+static gint opt_queue_depth = 32;
+static gint opt_block_size = 1024 * 1024;
+static gint opt_num_workers = 1;
+static gchar *opt_history = NULL;
+static gboolean opt_no_history = FALSE;
+static gboolean opt_force = FALSE;
+static gboolean opt_quiet = FALSE;
+static gchar **opt_device_files = NULL;
+
+static GOptionEntry entries[] = {
+        { "mode", 'm', 0, G_OPTION_ARG_STRING, &opt_mode, "What to measure: read (default), write, random or sweep", "MODE" },
+        { "format", 'f', 0, G_OPTION_ARG_STRING, &opt_format, "Output format: json (default) or csv", "FORMAT" },
+        { "io-engine", 0, 0, G_OPTION_ARG_STRING, &opt_io_engine, "I/O engine: auto (default), io_uring, libaio or threads", "ENGINE" },
+        { "queue-depth", 'q', 0, G_OPTION_ARG_INT, &opt_queue_depth, "Requests in flight per worker (default 32)", "N" },
+        { "block-size", 'b', 0, G_OPTION_ARG_INT, &opt_block_size, "Request size in bytes for the transfer rate (default 1048576)", "BYTES" },
+        { "workers", 'w', 0, G_OPTION_ARG_INT, &opt_num_workers, "Number of worker threads (default 1)", "N" },
+        { "history", 0, 0, G_OPTION_ARG_FILENAME, &opt_history, "Append the run to this history instead of the drive's", "FILE" },
+        { "no-history", 0, 0, G_OPTION_ARG_NONE, &opt_no_history, "Don't append the run to any history", NULL },
+        { "force", 0, 0, G_OPTION_ARG_NONE, &opt_force, "Required for the write benchmark", NULL },
+        { "quiet", 0, 0, G_OPTION_ARG_NONE, &opt_quiet, "Don't print progress on stderr", NULL },
+        { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &opt_device_files, NULL, "DEVICE" },
+        { NULL }
+};
+
+static const struct {
+        const gchar *name;
+        MduBenchmarkMode mode;
+        MduBenchmarkFlags flags;
+} modes[] = {
+        { "read",   MDU_BENCHMARK_MODE_TRANSFER_RATE, MDU_BENCHMARK_FLAGS_NONE },
+        { "write",  MDU_BENCHMARK_MODE_TRANSFER_RATE, MDU_BENCHMARK_FLAGS_WRITE },
+        { "random", MDU_BENCHMARK_MODE_RANDOM,        MDU_BENCHMARK_FLAGS_NONE },
+        { "sweep",  MDU_BENCHMARK_MODE_SWEEP,         MDU_BENCHMARK_FLAGS_NONE },
+};
+
+static const gchar *io_engine_names[] = {
+        "auto",      /* MDU_BENCHMARK_IO_ENGINE_AUTO */
+        "io_uring",  /* MDU_BENCHMARK_IO_ENGINE_IO_URING */
+        "libaio",    /* MDU_BENCHMARK_IO_ENGINE_LIBAIO */
+        "threads",   /* MDU_BENCHMARK_IO_ENGINE_THREADS */
+};
+
+typedef struct {
+        GMainLoop *loop;
+        gboolean success;
+        GError *error;
+        gint last_progress;
+} RunData;
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gchar *
+format_double (gdouble value)
+{
+        gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+        /* never a decimal comma, whatever the locale */
+        return g_strdup (g_ascii_formatd (buf, sizeof buf, "%.6g", value));
+}
+
+/* appends @value as a quoted JSON string */
+static void
+append_json_string (GString     *str,
+                    const gchar *value)
+{
+        const gchar *p;
+
+        g_string_append_c (str, '"');
+        for (p = value; p != NULL && *p != '\0'; p++) {
+                if (*p == '"' || *p == '\\')
+                        g_string_append_printf (str, "\\%c", *p);
+                else if ((guchar) *p < 0x20)
+                        g_string_append_printf (str, "\\u%04x", (guchar) *p);
+                else
+                        g_string_append_c (str, *p);
+        }
+        g_string_append_c (str, '"');
+}
+
+static void
+append_samples_json (GString     *str,
+                     const gchar *name,
+                     GArray      *samples,
+                     gboolean     last)
+{
+        gdouble max;
+        gdouble min;
+        gdouble avg;
+        gchar *s_max;
+        gchar *s_min;
+        gchar *s_avg;
+        guint n;
+
+        mdu_benchmark_samples_get_max_min_avg (samples, &max, &min, &avg);
+        s_max = format_double (max);
+        s_min = format_double (min);
+        s_avg = format_double (avg);
+        g_string_append_printf (str,
+                                "  \"%s\": {\"min\": %s, \"max\": %s, \"avg\": %s, \"samples\": [",
+                                name, s_min, s_max, s_avg);
+        g_free (s_max);
+        g_free (s_min);
+        g_free (s_avg);
+
+        for (n = 0; n < samples->len; n++) {
+                MduBenchmarkSample *sample = &g_array_index (samples, MduBenchmarkSample, n);
+                gchar *value;
+
+                value = format_double (sample->value);
+                g_string_append_printf (str,
+                                        "%s[%" G_GUINT64_FORMAT ", %s]",
+                                        n > 0 ? ", " : "",
+                                        sample->offset,
+                                        value);
+                g_free (value);
+        }
+        g_string_append_printf (str, "]}%s\n", last ? "" : ",");
+}
+
+/* rates are in bytes per second and times in seconds, as everywhere in MduBenchmark */
+static gchar *
+results_to_json (MduBenchmark *benchmark,
+                 const gchar  *mode_name)
+{
+        GString *str;
+        GArray *iops_results;
+        GArray *sweep_results;
+        guint n;
+
+        iops_results = mdu_benchmark_get_iops_results (benchmark);
+        sweep_results = mdu_benchmark_get_sweep_results (benchmark);
+
+        str = g_string_new (NULL);
+        g_string_append_printf (str, "{\n");
+        g_string_append_printf (str, "  \"version\": 1,\n");
+        g_string_append_printf (str, "  \"device\": ");
+        append_json_string (str, mdu_benchmark_get_device_file (benchmark));
+        g_string_append_printf (str, ",\n");
+        g_string_append_printf (str, "  \"mode\": \"%s\",\n", mode_name);
+        g_string_append_printf (str, "  \"size\": %" G_GUINT64_FORMAT ",\n", mdu_benchmark_get_size (benchmark));
+        g_string_append_printf (str, "  \"io_engine\": \"%s\",\n",
+                                io_engine_names[mdu_benchmark_get_io_engine_used (benchmark)]);
+        g_string_append_printf (str, "  \"queue_depth\": %u,\n", mdu_benchmark_get_queue_depth (benchmark));
+        g_string_append_printf (str, "  \"block_size\": %u,\n", mdu_benchmark_get_block_size (benchmark));
+        g_string_append_printf (str, "  \"workers\": %u,\n", mdu_benchmark_get_num_workers (benchmark));
+        g_string_append_printf (str, "  \"direct_io\": %s,\n", mdu_benchmark_get_direct_io (benchmark) ? "true" : "false");
+
+        append_samples_json (str, "read", mdu_benchmark_get_read_transfer_rate_samples (benchmark), FALSE);
+        append_samples_json (str, "write", mdu_benchmark_get_write_transfer_rate_samples (benchmark), FALSE);
+        append_samples_json (str, "access_time", mdu_benchmark_get_access_time_samples (benchmark), FALSE);
+
+        g_string_append_printf (str, "  \"iops\": [");
+        for (n = 0; n < iops_results->len; n++) {
+                MduBenchmarkIopsResult *result = &g_array_index (iops_results, MduBenchmarkIopsResult, n);
+                gchar *iops;
+                gchar *p50;
+                gchar *p99;
+                gchar *p999;
+
+                iops = format_double (result->iops);
+                p50 = format_double (mdu_benchmark_histogram_get_percentile (&result->latency, 50.0));
+                p99 = format_double (mdu_benchmark_histogram_get_percentile (&result->latency, 99.0));
+                p999 = format_double (mdu_benchmark_histogram_get_percentile (&result->latency, 99.9));
+                g_string_append_printf (str,
+                                        "%s\n    {\"queue_depth\": %u, \"iops\": %s, "
+                                        "\"latency_p50\": %s, \"latency_p99\": %s, \"latency_p999\": %s}",
+                                        n > 0 ? "," : "",
+                                        result->queue_depth,
+                                        iops, p50, p99, p999);
+                g_free (iops);
+                g_free (p50);
+                g_free (p99);
+                g_free (p999);
+        }
+        g_string_append_printf (str, "%s],\n", iops_results->len > 0 ? "\n  " : "");
+
+        g_string_append_printf (str, "  \"sweep\": [");
+        for (n = 0; n < sweep_results->len; n++) {
+                MduBenchmarkSweepPoint *point = &g_array_index (sweep_results, MduBenchmarkSweepPoint, n);
+                gchar *rate;
+
+                rate = format_double (point->transfer_rate);
+                g_string_append_printf (str,
+                                        "%s\n    {\"block_size\": %u, \"transfer_rate\": %s}",
+                                        n > 0 ? "," : "",
+                                        point->block_size,
+                                        rate);
+                g_free (rate);
+        }
+        g_string_append_printf (str, "%s],\n", sweep_results->len > 0 ? "\n  " : "");
+        g_string_append_printf (str, "  \"optimal_block_size\": %u\n",
+                                mdu_benchmark_sweep_get_optimal_block_size (sweep_results));
+        g_string_append_printf (str, "}\n");
+
+        return g_string_free (str, FALSE);
+}
+
+static void
+append_samples_csv (GString     *str,
+                    const gchar *series,
+                    GArray      *samples)
+{
+        guint n;
+
+        for (n = 0; n < samples->len; n++) {
+                MduBenchmarkSample *sample = &g_array_index (samples, MduBenchmarkSample, n);
+                gchar *value;
+
+                value = format_double (sample->value);
+                g_string_append_printf (str, "%s,%" G_GUINT64_FORMAT ",%s\n", series, sample->offset, value);
+                g_free (value);
+        }
+}
+
+/* One row per data point so the output can be fed to a spreadsheet or
+ * gnuplot as is; x is the offset for samples, the queue depth for iops
+ * and the request size for sweep points
+ */
+static gchar *
+results_to_csv (MduBenchmark *benchmark)
+{
+        GString *str;
+        GArray *iops_results;
+        GArray *sweep_results;
+        guint n;
+
+        iops_results = mdu_benchmark_get_iops_results (benchmark);
+        sweep_results = mdu_benchmark_get_sweep_results (benchmark);
+
+        str = g_string_new ("series,x,value\n");
+        append_samples_csv (str, "read", mdu_benchmark_get_read_transfer_rate_samples (benchmark));
+        append_samples_csv (str, "write", mdu_benchmark_get_write_transfer_rate_samples (benchmark));
+        append_samples_csv (str, "access_time", mdu_benchmark_get_access_time_samples (benchmark));
+        for (n = 0; n < iops_results->len; n++) {
+                MduBenchmarkIopsResult *result = &g_array_index (iops_results, MduBenchmarkIopsResult, n);
+                gchar *iops;
+                gchar *p99;
+
+                iops = format_double (result->iops);
+                p99 = format_double (mdu_benchmark_histogram_get_percentile (&result->latency, 99.0));
+                g_string_append_printf (str, "iops,%u,%s\n", result->queue_depth, iops);
+                g_string_append_printf (str, "latency_p99,%u,%s\n", result->queue_depth, p99);
+                g_free (iops);
+                g_free (p99);
+        }
+        for (n = 0; n < sweep_results->len; n++) {
+                MduBenchmarkSweepPoint *point = &g_array_index (sweep_results, MduBenchmarkSweepPoint, n);
+                gchar *rate;
+
+                rate = format_double (point->transfer_rate);
+                g_string_append_printf (str, "sweep,%u,%s\n", point->block_size, rate);
+                g_free (rate);
+        }
+
+        return g_string_free (str, FALSE);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Same history the dialog uses, i.e. keyed on the drive's identity */
+static MduBenchmarkHistory *
+open_history (const gchar  *device_file,
+              GError      **error)
+{
+        MduBenchmarkHistory *ret;
+        MduPool *pool;
+        MduDevice *device;
+
+        ret = NULL;
+        pool = NULL;
+        device = NULL;
+
+        if (opt_history != NULL) {
+                ret = mdu_benchmark_history_new (opt_history, error);
+                goto out;
+        }
+
+        pool = mdu_pool_new_for_device_file (device_file, error);
+        if (pool == NULL)
+                goto out;
+
+        device = mdu_pool_get_by_device_file (pool, device_file);
+        if (device == NULL || !mdu_device_is_drive (device)) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "%s is not a drive, use --history to pick a history",
+                             device_file);
+                goto out;
+        }
+
+        ret = mdu_benchmark_history_new_for_drive (mdu_device_drive_get_vendor (device),
+                                                   mdu_device_drive_get_model (device),
+                                                   mdu_device_drive_get_serial (device),
+                                                   mdu_device_drive_get_wwn (device),
+                                                   error);
+
+ out:
+        if (device != NULL)
+                g_object_unref (device);
+        if (pool != NULL)
+                g_object_unref (pool);
+        return ret;
+}
+
+static void
+on_progress_changed (MduBenchmark *benchmark,
+                     gpointer      user_data)
+{
+        RunData *data = user_data;
+        gint progress;
+
+        progress = (gint) (mdu_benchmark_get_progress (benchmark) * 100.0);
+        if (progress != data->last_progress) {
+                g_printerr ("\r%s: %3d%%", mdu_benchmark_get_device_file (benchmark), progress);
+                data->last_progress = progress;
+        }
+}
+
+static void
+run_cb (GObject      *source_object,
+        GAsyncResult *res,
+        gpointer      user_data)
+{
+        RunData *data = user_data;
+
+        data->success = mdu_benchmark_run_finish (MDU_BENCHMARK (source_object), res, &data->error);
+        g_main_loop_quit (data->loop);
+}
+
+int
+main (int argc, char *argv[])
+{
+        GOptionContext *context;
+        GError *error;
+        MduBenchmark *benchmark;
+        MduBenchmarkHistory *history;
+        MduBenchmarkHistoryRun run;
+        RunData data;
+        const gchar *device_file;
+        gchar *output;
+        gint mode_index;
+        gint io_engine;
+        guint n;
+        gint ret;
+
+        ret = 1;
+        benchmark = NULL;
+        history = NULL;
+        output = NULL;
+        memset (&data, 0, sizeof (RunData));
+
+        g_type_init ();
+        g_thread_init (NULL);
+
+        context = g_option_context_new ("- benchmark a drive");
+        g_option_context_add_main_entries (context, entries, NULL);
+        error = NULL;
+        if (!g_option_context_parse (context, &argc, &argv, &error)) {
+                g_printerr ("Could not parse arguments: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        if (opt_device_files == NULL || g_strv_length (opt_device_files) != 1) {
+                g_printerr ("Exactly one device file must be given\n");
+                goto out;
+        }
+        device_file = opt_device_files[0];
+
+        mode_index = -1;
+        for (n = 0; n < G_N_ELEMENTS (modes); n++) {
+                if (g_strcmp0 (opt_mode != NULL ? opt_mode : "read", modes[n].name) == 0)
+                        mode_index = n;
+        }
+        if (mode_index < 0) {
+                g_printerr ("Unknown mode `%s'\n", opt_mode);
+                goto out;
+        }
+
+        io_engine = -1;
+        for (n = 0; n < G_N_ELEMENTS (io_engine_names); n++) {
+                if (g_strcmp0 (opt_io_engine != NULL ? opt_io_engine : "auto", io_engine_names[n]) == 0)
+                        io_engine = n;
+        }
+        if (io_engine < 0) {
+                g_printerr ("Unknown I/O engine `%s'\n", opt_io_engine);
+                goto out;
+        }
+
+        if (opt_format != NULL && g_strcmp0 (opt_format, "json") != 0 && g_strcmp0 (opt_format, "csv") != 0) {
+                g_printerr ("Unknown format `%s'\n", opt_format);
+                goto out;
+        }
+
+        if (opt_queue_depth < 1 || opt_block_size < 512 || opt_num_workers < 1) {
+                g_printerr ("Queue depth, block size and number of workers must be positive\n");
+                goto out;
+        }
+
+        /* the dialog asks for confirmation too */
+        if ((modes[mode_index].flags & MDU_BENCHMARK_FLAGS_WRITE) && !opt_force) {
+                g_printerr ("The write benchmark writes to all of %s and requires that it is not in use.\n"
+                            "Use --force to run it anyway\n",
+                            device_file);
+                goto out;
+        }
+
+        /* open the history first so a bad --history doesn't waste a long run */
+        if (!opt_no_history) {
+                history = open_history (device_file, &error);
+                if (history == NULL) {
+                        g_printerr ("Error opening benchmark history: %s\n", error->message);
+                        g_error_free (error);
+                        goto out;
+                }
+        }
+
+        benchmark = mdu_benchmark_new (device_file);
+        mdu_benchmark_set_mode (benchmark, modes[mode_index].mode);
+        mdu_benchmark_set_io_engine (benchmark, io_engine);
+        mdu_benchmark_set_queue_depth (benchmark, opt_queue_depth);
+        mdu_benchmark_set_block_size (benchmark, opt_block_size);
+        mdu_benchmark_set_num_workers (benchmark, opt_num_workers);
+
+        data.loop = g_main_loop_new (NULL, FALSE);
+        data.last_progress = -1;
+        if (!opt_quiet) {
+                g_signal_connect (benchmark,
+                                  "progress-changed",
+                                  G_CALLBACK (on_progress_changed),
+                                  &data);
+        }
+        mdu_benchmark_run_async (benchmark,
+                                 modes[mode_index].flags,
+                                 NULL,
+                                 run_cb,
+                                 &data);
+        g_main_loop_run (data.loop);
+        if (!opt_quiet && data.last_progress >= 0)
+                g_printerr ("\n");
+
+        if (!data.success) {
+                g_printerr ("Error benchmarking %s: %s\n", device_file, data.error->message);
+                g_error_free (data.error);
+                goto out;
+        }
+
+        if (g_strcmp0 (opt_format, "csv") == 0)
+                output = results_to_csv (benchmark);
+        else
+                output = results_to_json (benchmark, modes[mode_index].name);
+        g_print ("%s", output);
+
+        if (history != NULL) {
+                mdu_benchmark_history_run_init_from_benchmark (&run, benchmark, modes[mode_index].flags);
+                if (!mdu_benchmark_history_append_run (history, &run, &error)) {
+                        g_printerr ("Error saving benchmark data: %s\n", error->message);
+                        g_error_free (error);
+                        goto out;
+                }
+        }
+
+        ret = 0;
+
+ out:
+        if (data.loop != NULL)
+                g_main_loop_unref (data.loop);
+        if (benchmark != NULL)
+                g_object_unref (benchmark);
+        if (history != NULL)
+                g_object_unref (history);
+        g_free (output);
+        g_free (opt_mode);
+        g_free (opt_format);
+        g_free (opt_io_engine);
+        g_free (opt_history);
+        g_strfreev (opt_device_files);
+        g_option_context_free (context);
+        return ret;
+}
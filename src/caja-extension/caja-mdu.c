@@ -35,24 +35,151 @@ static void caja_mdu_class_init    (CajaMduClass *klass);
 static GType caja_mdu_type = 0;
 
 
+/* Context menus are built synchronously on the UI thread so resolving a device file must be
+ * cheap. We keep a single pool for the local machine and an index from device file to device,
+ * kept up to date by the ::device-added, ::device-removed and ::device-changed signals of the
+ * pool. The pool is created with mdu_pool_new_for_address_async() from an idle callback when
+ * the extension is instantiated, so talking to the daemon never blocks caja. Until the pool
+ * is ready no menu items are offered.
+ */
+static GHashTable *device_file_to_device = NULL;
+static MduPool *pool = NULL;
+static gboolean pool_pending = FALSE;
+
+static void
+index_add_device (MduDevice *device)
+{
+        const gchar *device_file;
+
+        device_file = mdu_device_get_device_file (device);
+        if (device_file != NULL && strlen (device_file) > 0)
+                g_hash_table_insert (device_file_to_device, g_strdup (device_file), g_object_ref (device));
+
+        device_file = mdu_device_get_device_file_presentation (device);
+        if (device_file != NULL && strlen (device_file) > 0)
+                g_hash_table_insert (device_file_to_device, g_strdup (device_file), g_object_ref (device));
+}
+
+static gboolean
+index_remove_device_func (gpointer key,
+                          gpointer value,
+                          gpointer user_data)
+{
+        return value == user_data;
+}
+
+static void
+index_remove_device (MduDevice *device)
+{
+        g_hash_table_foreach_remove (device_file_to_device, index_remove_device_func, device);
+}
+
+static void
+on_device_added (MduPool   *pool,
+                 MduDevice *device,
+                 gpointer   user_data)
+{
+        index_add_device (device);
+}
+
+static void
+on_device_removed (MduPool   *pool,
+                   MduDevice *device,
+                   gpointer   user_data)
+{
+        index_remove_device (device);
+}
+
+static void
+on_device_changed (MduPool   *pool,
+                   MduDevice *device,
+                   gpointer   user_data)
+{
+        index_remove_device (device);
+        index_add_device (device);
+}
+
+static void
+on_pool_ready (GObject      *source_object,
+               GAsyncResult *res,
+               gpointer      user_data)
+{
+        GError *error;
+        GList *devices;
+        GList *l;
+
+        pool_pending = FALSE;
+
+        error = NULL;
+        pool = mdu_pool_new_for_address_finish (res, &error);
+        if (pool == NULL) {
+                g_warning ("Error connecting to the disks daemon: %s", error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        /* the pool is kept for the lifetime of the extension so the index stays current */
+        g_signal_connect (pool, "device-added", G_CALLBACK (on_device_added), NULL);
+        g_signal_connect (pool, "device-removed", G_CALLBACK (on_device_removed), NULL);
+        g_signal_connect (pool, "device-changed", G_CALLBACK (on_device_changed), NULL);
+
+        devices = mdu_pool_get_devices (pool);
+        for (l = devices; l != NULL; l = l->next)
+                index_add_device (MDU_DEVICE (l->data));
+        g_list_foreach (devices, (GFunc) g_object_unref, NULL);
+        g_list_free (devices);
+
+ out:
+        ;
+}
+
+static gboolean
+warm_pool_in_idle (gpointer user_data)
+{
+        mdu_pool_new_for_address_async (NULL, NULL, 0, NULL, on_pool_ready, NULL);
+        return FALSE;
+}
+
+/* starts creating the pool unless it exists or is being created */
+static void
+ensure_pool (void)
+{
+        if (pool != NULL || pool_pending)
+                goto out;
+
+        if (device_file_to_device == NULL)
+                device_file_to_device = g_hash_table_new_full (g_str_hash,
+                                                               g_str_equal,
+                                                               g_free,
+                                                               g_object_unref);
+
+        pool_pending = TRUE;
+        g_idle_add (warm_pool_in_idle, NULL);
+
+ out:
+        ;
+}
+
 static MduDevice *
 get_device_for_device_file (const gchar *device_file)
 {
-        MduPool *pool;
         MduDevice *device;
 
-        pool = NULL;
         device = NULL;
 
         if (device_file == NULL || strlen (device_file) <= 1)
                 goto out;
 
-        pool = mdu_pool_new ();
-        device = mdu_pool_get_by_device_file (pool, device_file);
+        /* if the pool isn't ready yet, it will be next time */
+        ensure_pool ();
+        if (pool == NULL)
+                goto out;
+
+        device = g_hash_table_lookup (device_file_to_device, device_file);
+        if (device != NULL)
+                g_object_ref (device);
 
  out:
-        if (pool != NULL)
-                g_object_unref (pool);
         return device;
 }
 
@@ -256,6 +383,7 @@ caja_mdu_menu_provider_iface_init (CajaMenuProviderIface *iface)
 static void
 caja_mdu_instance_init (CajaMdu *mdu)
 {
+        ensure_pool ();
 }
 
 static void
@@ -260,9 +260,12 @@ main (int argc, char *argv[])
                 goto out;
         }
 
-        pool = mdu_pool_new ();
+        /* we only need the device and what it's stacked on, see mdu_pool_new_for_device_file() */
+        pool = mdu_pool_new_for_device_file (device_file, &error);
         if (pool == NULL) {
-                g_warning ("Unable to get device pool");
+                g_warning ("Unable to get device pool: %s", error->message);
+                g_error_free (error);
+                error = NULL;
                 goto out;
         }
 
@@ -122,11 +122,19 @@ message_received (UniqueApp         *app,
 const char *volume_to_show = NULL;
 const char *drive_to_show = NULL;
 const char *dbus_address = NULL;
+char **hosts_to_connect = NULL;
+gint max_connections = 0;
+gint connect_timeout = -1;
+gboolean no_compression = FALSE;
 
 static GOptionEntry entries[] = {
         { "show-volume", 0, 0, G_OPTION_ARG_FILENAME, &volume_to_show, N_("Volume to show"), N_("DEVICE") },
         { "show-drive", 0, 0, G_OPTION_ARG_FILENAME, &drive_to_show, N_("Drive to show"), N_("DEVICE") },
         { "address", 'a', 0, G_OPTION_ARG_STRING, &dbus_address, "D-Bus address to connect to", NULL },
+        { "connect", 'c', 0, G_OPTION_ARG_STRING_ARRAY, &hosts_to_connect, N_("Remote host to connect to (may be given multiple times)"), N_("[USER@]HOST") },
+        { "max-connections", 0, 0, G_OPTION_ARG_INT, &max_connections, N_("Number of remote hosts to connect to at the same time"), N_("NUM") },
+        { "connect-timeout", 0, 0, G_OPTION_ARG_INT, &connect_timeout, N_("Seconds to wait for a remote host to connect (0 to wait forever)"), N_("SECONDS") },
+        { "no-compression", 0, 0, G_OPTION_ARG_NONE, &no_compression, N_("Do not compress the traffic to remote hosts"), NULL },
         { NULL }
 };
 
@@ -143,6 +151,11 @@ main (int argc, char **argv)
         ret = 1;
         shell = NULL;
 
+#if !GLIB_CHECK_VERSION (2, 32, 0)
+        /* the drive benchmark runs in a separate thread, see MduBenchmark */
+        g_thread_init (NULL);
+#endif
+
         error = NULL;
         if (!gtk_init_with_args (&argc, &argv, "", entries, GETTEXT_PACKAGE, &error)) {
                 g_printerr ("%s\n", error->message);
@@ -191,6 +204,35 @@ main (int argc, char **argv)
         gtk_widget_show_all (mdu_shell_get_toplevel (shell));
         mdu_shell_update (shell);
 
+        if (max_connections > 0)
+                mdu_shell_set_max_connections (shell, max_connections);
+        if (connect_timeout >= 0)
+                mdu_shell_set_connect_timeout (shell, connect_timeout);
+        if (hosts_to_connect != NULL) {
+                guint n;
+
+                for (n = 0; hosts_to_connect[n] != NULL; n++) {
+                        gchar *user_name;
+                        gchar *address;
+                        gchar *s;
+
+                        s = strchr (hosts_to_connect[n], '@');
+                        if (s != NULL) {
+                                user_name = g_strndup (hosts_to_connect[n], s - hosts_to_connect[n]);
+                                address = g_strdup (s + 1);
+                        } else {
+                                user_name = NULL;
+                                address = g_strdup (hosts_to_connect[n]);
+                        }
+                        mdu_shell_add_host (shell,
+                                            user_name,
+                                            address,
+                                            no_compression ? MDU_POOL_CONNECT_FLAGS_NONE : MDU_POOL_CONNECT_FLAGS_COMPRESS);
+                        g_free (user_name);
+                        g_free (address);
+                }
+        }
+
         if (volume_to_show) {
                 if (!show_volume (shell, volume_to_show))
                         goto out;
@@ -0,0 +1,280 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-section-fleet.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib/gi18n.h>
+
+#include <string.h>
+
+#include <mdu-gtk/mdu-gtk.h>
+#include "mdu-section-fleet.h"
+
+struct _MduSectionFleetPrivate
+{
+        GtkWidget *heading_label;
+        GtkWidget *tree_view;
+};
+
+G_DEFINE_TYPE (MduSectionFleet, mdu_section_fleet, MDU_TYPE_SECTION)
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+mdu_section_fleet_finalize (GObject *object)
+{
+        //MduSectionFleet *section = MDU_SECTION_FLEET (object);
+
+        if (G_OBJECT_CLASS (mdu_section_fleet_parent_class)->finalize != NULL)
+                G_OBJECT_CLASS (mdu_section_fleet_parent_class)->finalize (object);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+mdu_section_fleet_update (MduSection *_section)
+{
+        MduSectionFleet *section = MDU_SECTION_FLEET (_section);
+        MduFleetModel *model;
+        MduPresentable *p;
+        MduPool *pool;
+        GtkTreeIter iter;
+
+        p = mdu_section_get_presentable (_section);
+        pool = mdu_presentable_get_pool (p);
+        model = mdu_shell_get_fleet_model (mdu_section_get_shell (_section));
+
+        /* the model updates itself; all we need is to point out the host being shown */
+        if (mdu_fleet_model_get_iter_for_pool (model, pool, &iter)) {
+                gtk_tree_selection_select_iter (gtk_tree_view_get_selection (GTK_TREE_VIEW (section->priv->tree_view)),
+                                                &iter);
+        }
+
+        g_object_unref (pool);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+size_data_func (GtkTreeViewColumn *column,
+                GtkCellRenderer   *renderer,
+                GtkTreeModel      *model,
+                GtkTreeIter       *iter,
+                gpointer           user_data)
+{
+        guint64 size;
+        gchar *s;
+
+        gtk_tree_model_get (model, iter,
+                            GPOINTER_TO_INT (user_data), &size,
+                            -1);
+        s = mdu_util_get_size_for_display (size, FALSE, FALSE);
+        g_object_set (renderer, "text", s, NULL);
+        g_free (s);
+}
+
+static void
+count_data_func (GtkTreeViewColumn *column,
+                 GtkCellRenderer   *renderer,
+                 GtkTreeModel      *model,
+                 GtkTreeIter       *iter,
+                 gpointer           user_data)
+{
+        gint model_column = GPOINTER_TO_INT (user_data);
+        guint count;
+        gchar *s;
+
+        gtk_tree_model_get (model, iter,
+                            model_column, &count,
+                            -1);
+
+        /* make problems stand out */
+        if (count > 0 &&
+            (model_column == MDU_FLEET_MODEL_COLUMN_NUM_DEGRADED_ARRAYS ||
+             model_column == MDU_FLEET_MODEL_COLUMN_NUM_SMART_FAILURES)) {
+                s = g_strdup_printf ("<b>%u</b>", count);
+        } else if (count == 0 && model_column != MDU_FLEET_MODEL_COLUMN_NUM_DRIVES) {
+                s = g_strdup ("–");
+        } else {
+                s = g_strdup_printf ("%u", count);
+        }
+        g_object_set (renderer, "markup", s, NULL);
+        g_free (s);
+}
+
+static void
+append_column (MduSectionFleet        *section,
+               const gchar            *title,
+               MduFleetModelColumn     model_column,
+               GtkTreeCellDataFunc     data_func)
+{
+        GtkTreeViewColumn *column;
+        GtkCellRenderer *renderer;
+
+        column = gtk_tree_view_column_new ();
+        gtk_tree_view_column_set_title (column, title);
+        gtk_tree_view_column_set_sort_column_id (column, model_column);
+        renderer = gtk_cell_renderer_text_new ();
+        gtk_tree_view_column_pack_start (column, renderer, TRUE);
+        if (data_func != NULL) {
+                g_object_set (renderer, "xalign", 1.0, NULL);
+                gtk_tree_view_column_set_cell_data_func (column,
+                                                         renderer,
+                                                         data_func,
+                                                         GINT_TO_POINTER (model_column),
+                                                         NULL);
+        } else {
+                gtk_tree_view_column_set_expand (column, TRUE);
+                gtk_tree_view_column_add_attribute (column, renderer, "text", model_column);
+        }
+        gtk_tree_view_append_column (GTK_TREE_VIEW (section->priv->tree_view), column);
+}
+
+static void
+on_row_activated (GtkTreeView       *tree_view,
+                  GtkTreePath       *path,
+                  GtkTreeViewColumn *column,
+                  gpointer           user_data)
+{
+        MduSectionFleet *section = MDU_SECTION_FLEET (user_data);
+        GtkTreeModel *model;
+        GtkTreeIter iter;
+        MduPool *pool;
+        GList *presentables;
+        GList *l;
+
+        model = gtk_tree_view_get_model (tree_view);
+        if (!gtk_tree_model_get_iter (model, &iter, path))
+                goto out;
+
+        gtk_tree_model_get (model, &iter,
+                            MDU_FLEET_MODEL_COLUMN_POOL, &pool,
+                            -1);
+
+        /* jump to the host */
+        presentables = mdu_pool_get_presentables (pool);
+        for (l = presentables; l != NULL; l = l->next) {
+                MduPresentable *p = MDU_PRESENTABLE (l->data);
+                if (MDU_IS_MACHINE (p)) {
+                        mdu_shell_select_presentable (mdu_section_get_shell (MDU_SECTION (section)), p);
+                        break;
+                }
+        }
+        g_list_foreach (presentables, (GFunc) g_object_unref, NULL);
+        g_list_free (presentables);
+        g_object_unref (pool);
+
+ out:
+        ;
+}
+
+static void
+mdu_section_fleet_constructed (GObject *object)
+{
+        MduSectionFleet *section = MDU_SECTION_FLEET (object);
+        GtkWidget *align;
+        GtkWidget *label;
+        GtkWidget *scrolled_window;
+        GtkWidget *tree_view;
+        MduFleetModel *model;
+
+        model = mdu_shell_get_fleet_model (mdu_section_get_shell (MDU_SECTION (section)));
+
+        gtk_box_set_spacing (GTK_BOX (section), 12);
+
+        /*------------------------------------- */
+
+        label = gtk_label_new (NULL);
+        gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+        gtk_label_set_markup (GTK_LABEL (label), _("<b>Hosts</b>"));
+        gtk_box_pack_start (GTK_BOX (section), label, FALSE, FALSE, 0);
+        section->priv->heading_label = label;
+
+        align = gtk_alignment_new (0.5, 0.5, 1.0, 1.0);
+        gtk_alignment_set_padding (GTK_ALIGNMENT (align), 0, 0, 12, 0);
+        gtk_box_pack_start (GTK_BOX (section), align, FALSE, FALSE, 0);
+
+        tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (model));
+        gtk_tree_view_set_rules_hint (GTK_TREE_VIEW (tree_view), TRUE);
+        section->priv->tree_view = tree_view;
+
+        /* Translators: Column headers in the host summary shown when a machine is selected */
+        append_column (section, _("Host"), MDU_FLEET_MODEL_COLUMN_NAME, NULL);
+        append_column (section, _("Drives"), MDU_FLEET_MODEL_COLUMN_NUM_DRIVES, count_data_func);
+        append_column (section, _("Capacity"), MDU_FLEET_MODEL_COLUMN_CAPACITY, size_data_func);
+        append_column (section, _("Unallocated"), MDU_FLEET_MODEL_COLUMN_UNALLOCATED, size_data_func);
+        append_column (section, _("Degraded Arrays"), MDU_FLEET_MODEL_COLUMN_NUM_DEGRADED_ARRAYS, count_data_func);
+        append_column (section, _("Failing Disks"), MDU_FLEET_MODEL_COLUMN_NUM_SMART_FAILURES, count_data_func);
+        append_column (section, _("Jobs"), MDU_FLEET_MODEL_COLUMN_NUM_JOBS, count_data_func);
+
+        g_signal_connect (tree_view,
+                          "row-activated",
+                          G_CALLBACK (on_row_activated),
+                          section);
+
+        scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+        gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                        GTK_POLICY_NEVER,
+                                        GTK_POLICY_AUTOMATIC);
+        gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scrolled_window),
+                                             GTK_SHADOW_IN);
+        gtk_widget_set_size_request (scrolled_window, -1, 250);
+        gtk_container_add (GTK_CONTAINER (scrolled_window), tree_view);
+        gtk_container_add (GTK_CONTAINER (align), scrolled_window);
+
+        /* -------------------------------------------------------------------------------- */
+
+        gtk_widget_show_all (GTK_WIDGET (section));
+
+        if (G_OBJECT_CLASS (mdu_section_fleet_parent_class)->constructed != NULL)
+                G_OBJECT_CLASS (mdu_section_fleet_parent_class)->constructed (object);
+}
+
+static void
+mdu_section_fleet_class_init (MduSectionFleetClass *klass)
+{
+        GObjectClass *gobject_class;
+        MduSectionClass *section_class;
+
+        gobject_class = G_OBJECT_CLASS (klass);
+        section_class = MDU_SECTION_CLASS (klass);
+
+        gobject_class->finalize    = mdu_section_fleet_finalize;
+        gobject_class->constructed = mdu_section_fleet_constructed;
+        section_class->update      = mdu_section_fleet_update;
+
+        g_type_class_add_private (klass, sizeof (MduSectionFleetPrivate));
+}
+
+static void
+mdu_section_fleet_init (MduSectionFleet *section)
+{
+        section->priv = G_TYPE_INSTANCE_GET_PRIVATE (section, MDU_TYPE_SECTION_FLEET, MduSectionFleetPrivate);
+}
+
+GtkWidget *
+mdu_section_fleet_new (MduShell       *shell,
+                       MduPresentable *presentable)
+{
+        return GTK_WIDGET (g_object_new (MDU_TYPE_SECTION_FLEET,
+                                         "shell", shell,
+                                         "presentable", presentable,
+                                         NULL));
+}
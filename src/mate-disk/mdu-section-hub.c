@@ -184,6 +184,24 @@ mdu_section_hub_update (MduSection *_section)
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+static void
+mdu_section_hub_on_benchmark_button_clicked (MduButtonElement *button_element,
+                                             gpointer          user_data)
+{
+        MduSection *section = MDU_SECTION (user_data);
+        GtkWindow *toplevel;
+        GtkWidget *dialog;
+
+        toplevel = GTK_WINDOW (mdu_shell_get_toplevel (mdu_section_get_shell (MDU_SECTION (section))));
+        dialog = mdu_concurrent_benchmark_dialog_new (toplevel,
+                                                      MDU_HUB (mdu_section_get_presentable (MDU_SECTION (section))));
+        gtk_widget_show_all (dialog);
+        gtk_dialog_run (GTK_DIALOG (dialog));
+        gtk_widget_destroy (dialog);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
 static void
 mdu_section_hub_constructed (GObject *object)
 {
@@ -196,6 +214,7 @@ mdu_section_hub_constructed (GObject *object)
         MduDevice *d;
         GPtrArray *elements;
         MduDetailsElement *element;
+        MduButtonElement *button_element;
 
         p = mdu_section_get_presentable (MDU_SECTION (section));
         d = mdu_presentable_get_device (p);
@@ -248,6 +267,23 @@ mdu_section_hub_constructed (GObject *object)
 
         /* -------------------------------------------------------------------------------- */
 
+        elements = g_ptr_array_new_with_free_func (g_object_unref);
+
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("_Benchmark Drives"),
+                                                 _("Measure the throughput of the drives at the same time"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (mdu_section_hub_on_benchmark_button_clicked),
+                          section);
+        g_ptr_array_add (elements, button_element);
+
+        table = mdu_button_table_new (2, elements);
+        g_ptr_array_unref (elements);
+        gtk_box_pack_start (GTK_BOX (vbox), table, FALSE, FALSE, 0);
+
+        /* -------------------------------------------------------------------------------- */
+
         gtk_widget_show_all (GTK_WIDGET (section));
 
         if (d != NULL)
@@ -50,6 +50,7 @@ struct _MduSectionLinuxMdDrivePrivate
         MduButtonElement *edit_components_button;
         MduButtonElement *check_button;
         MduButtonElement *benchmark_button;
+        MduButtonElement *components_benchmark_button;
 };
 
 G_DEFINE_TYPE (MduSectionLinuxMdDrive, mdu_section_linux_md_drive, MDU_TYPE_SECTION)
@@ -200,6 +201,7 @@ mdu_section_linux_md_drive_update (MduSection *_section)
         gboolean show_edit_components_button;
         gboolean show_check_button;
         gboolean show_benchmark_button;
+        gboolean show_components_benchmark_button;
         GList *slaves;
         MduDevice *slave;
         const gchar *level;
@@ -214,6 +216,7 @@ mdu_section_linux_md_drive_update (MduSection *_section)
         show_edit_components_button = FALSE;
         show_check_button = FALSE;
         show_benchmark_button = FALSE;
+        show_components_benchmark_button = FALSE;
 
         p = mdu_section_get_presentable (_section);
         d = mdu_presentable_get_device (p);
@@ -274,6 +277,7 @@ mdu_section_linux_md_drive_update (MduSection *_section)
                 show_format_button = TRUE;
                 show_check_button = TRUE;
                 show_benchmark_button = TRUE;
+                show_components_benchmark_button = TRUE;
                 show_edit_components_button = TRUE;
                 show_md_stop_button = TRUE;
         } else {
@@ -292,6 +296,7 @@ mdu_section_linux_md_drive_update (MduSection *_section)
         mdu_button_element_set_visible (section->priv->edit_components_button, show_edit_components_button);
         mdu_button_element_set_visible (section->priv->check_button, show_check_button);
         mdu_button_element_set_visible (section->priv->benchmark_button, show_benchmark_button);
+        mdu_button_element_set_visible (section->priv->components_benchmark_button, show_components_benchmark_button);
 
         if (d != NULL)
                 g_object_unref (d);
@@ -917,6 +922,24 @@ on_check_button_clicked (MduButtonElement *button_element,
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+static void
+on_components_benchmark_button_clicked (MduButtonElement *button_element,
+                                        gpointer          user_data)
+{
+        MduSectionLinuxMdDrive *section = MDU_SECTION_LINUX_MD_DRIVE (user_data);
+        GtkWindow *toplevel;
+        GtkWidget *dialog;
+
+        toplevel = GTK_WINDOW (mdu_shell_get_toplevel (mdu_section_get_shell (MDU_SECTION (section))));
+        dialog = mdu_concurrent_benchmark_dialog_new_for_linux_md_drive (toplevel,
+                                                                         MDU_LINUX_MD_DRIVE (mdu_section_get_presentable (MDU_SECTION (section))));
+        gtk_widget_show_all (dialog);
+        gtk_dialog_run (GTK_DIALOG (dialog));
+        gtk_widget_destroy (dialog);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
 static void
 mdu_section_linux_md_drive_constructed (GObject *object)
 {
@@ -1059,6 +1082,16 @@ mdu_section_linux_md_drive_constructed (GObject *object)
         g_ptr_array_add (elements, button_element);
         section->priv->benchmark_button = button_element;
 
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("Benchmark Co_mponents"),
+                                                 _("Read all components at the same time to find slow ones"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (on_components_benchmark_button_clicked),
+                          section);
+        g_ptr_array_add (elements, button_element);
+        section->priv->components_benchmark_button = button_element;
+
         table = mdu_button_table_new (2, elements);
         g_ptr_array_unref (elements);
         gtk_container_add (GTK_CONTAINER (align), table);
@@ -65,6 +65,7 @@ struct _MduSectionVolumesPrivate
         MduButtonElement *fs_mount_button;
         MduButtonElement *fs_unmount_button;
         MduButtonElement *fs_check_button;
+        MduButtonElement *fs_benchmark_button;
         MduButtonElement *fs_change_label_button;
         MduButtonElement *format_button;
         MduButtonElement *partition_edit_button;
@@ -1319,6 +1320,32 @@ on_fsck_button_clicked (MduButtonElement *button_element,
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+static void
+on_fs_benchmark_button_clicked (MduButtonElement *button_element,
+                                gpointer          user_data)
+{
+        MduSectionVolumes *section = MDU_SECTION_VOLUMES (user_data);
+        MduPresentable *v;
+        GtkWindow *toplevel;
+        GtkWidget *dialog;
+
+        v = mdu_volume_grid_get_selected (MDU_VOLUME_GRID (section->priv->grid));
+        if (v == NULL || !MDU_IS_VOLUME (v))
+                goto out;
+
+        toplevel = GTK_WINDOW (mdu_shell_get_toplevel (mdu_section_get_shell (MDU_SECTION (section))));
+        dialog = mdu_filesystem_benchmark_dialog_new (toplevel, MDU_VOLUME (v));
+        gtk_widget_show_all (dialog);
+        gtk_dialog_run (GTK_DIALOG (dialog));
+        gtk_widget_destroy (dialog);
+
+ out:
+        if (v != NULL)
+                g_object_unref (v);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
 static void
 on_usage_element_activated (MduDetailsElement *element,
                             const gchar       *uri,
@@ -1816,6 +1843,7 @@ mdu_section_volumes_update (MduSection *_section)
         gboolean show_fs_mount_button;
         gboolean show_fs_unmount_button;
         gboolean show_fs_check_button;
+        gboolean show_fs_benchmark_button;
         gboolean show_fs_change_label_button;
         gboolean show_format_button;
         gboolean show_partition_edit_button;
@@ -1844,6 +1872,7 @@ mdu_section_volumes_update (MduSection *_section)
         show_fs_mount_button = FALSE;
         show_fs_unmount_button = FALSE;
         show_fs_check_button = FALSE;
+        show_fs_benchmark_button = FALSE;
         show_fs_change_label_button = FALSE;
         show_format_button = FALSE;
         show_partition_edit_button = FALSE;
@@ -2166,6 +2195,8 @@ mdu_section_volumes_update (MduSection *_section)
                         g_object_unref (pool);
 
                         show_fs_unmount_button = TRUE;
+                        /* the benchmark writes to the mount point from this process */
+                        show_fs_benchmark_button = (ssh_address == NULL);
                 } else {
                         mdu_details_element_set_text (section->priv->fs_mount_point_element, _("Not Mounted"));
                         show_fs_mount_button = TRUE;
@@ -2245,6 +2276,7 @@ mdu_section_volumes_update (MduSection *_section)
         mdu_button_element_set_visible (section->priv->fs_mount_button, show_fs_mount_button);
         mdu_button_element_set_visible (section->priv->fs_unmount_button, show_fs_unmount_button);
         mdu_button_element_set_visible (section->priv->fs_check_button, show_fs_check_button);
+        mdu_button_element_set_visible (section->priv->fs_benchmark_button, show_fs_benchmark_button);
         mdu_button_element_set_visible (section->priv->fs_change_label_button, show_fs_change_label_button);
         mdu_button_element_set_visible (section->priv->format_button, show_format_button);
         mdu_button_element_set_visible (section->priv->partition_edit_button, show_partition_edit_button);
@@ -2423,6 +2455,16 @@ mdu_section_volumes_constructed (GObject *object)
         g_ptr_array_add (button_elements, button_element);
         section->priv->fs_check_button = button_element;
 
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("_Benchmark Filesystem"),
+                                                 _("Measure the performance of the filesystem"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (on_fs_benchmark_button_clicked),
+                          section);
+        g_ptr_array_add (button_elements, button_element);
+        section->priv->fs_benchmark_button = button_element;
+
         /* TODO: better icon */
         button_element = mdu_button_element_new (GTK_STOCK_BOLD,
                                                  _("Edit Filesystem _Label"),
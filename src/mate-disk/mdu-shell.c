@@ -40,12 +40,17 @@
 #include "mdu-section-drive.h"
 #include "mdu-section-volumes.h"
 #include "mdu-section-hub.h"
+#include "mdu-section-fleet.h"
 
 static gboolean add_pool (MduShell     *shell,
                           const gchar  *ssh_user_name,
                           const gchar  *ssh_address,
                           GError      **error);
 
+/* defaults for connecting to remote hosts, see mdu_shell_add_host() */
+#define MDU_SHELL_DEFAULT_MAX_CONNECTIONS  8
+#define MDU_SHELL_DEFAULT_CONNECT_TIMEOUT  120
+
 struct _MduShellPrivate
 {
         gchar *ssh_address;
@@ -53,9 +58,21 @@ struct _MduShellPrivate
         GtkWidget *app_window;
         GPtrArray *pools;
 
+        /* hosts waiting to be connected to (ConnectData) and the number of connections in progress */
+        GQueue *pending_connections;
+        guint num_connecting;
+        guint max_connections;
+        guint connect_timeout;
+
+        /* browses for hosts in the background so "Connect to Server" can list them right away */
+        MduHostDiscovery *host_discovery;
+
         MduPoolTreeModel *model;
         GtkWidget *tree_view;
 
+        /* per-host summary, see MduSectionFleet */
+        MduFleetModel *fleet_model;
+
         /* -------------------------------------------------------------------------------- */
 
         GtkWidget *sections_vbox;
@@ -77,7 +94,13 @@ G_DEFINE_TYPE (MduShell, mdu_shell, G_TYPE_OBJECT);
 static void
 mdu_shell_finalize (MduShell *shell)
 {
+        /* pending and in-progress connections hold a reference to the shell */
+        g_queue_free (shell->priv->pending_connections);
         g_free (shell->priv->ssh_address);
+        if (shell->priv->host_discovery != NULL)
+                g_object_unref (shell->priv->host_discovery);
+        if (shell->priv->fleet_model != NULL)
+                g_object_unref (shell->priv->fleet_model);
         if (G_OBJECT_CLASS (parent_class)->finalize)
                 (* G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (shell));
 }
@@ -102,6 +125,10 @@ mdu_shell_init (MduShell *shell)
         shell->priv = G_TYPE_INSTANCE_GET_PRIVATE (shell, MDU_TYPE_SHELL, MduShellPrivate);
 
         shell->priv->pools = g_ptr_array_new ();
+
+        shell->priv->pending_connections = g_queue_new ();
+        shell->priv->max_connections = MDU_SHELL_DEFAULT_MAX_CONNECTIONS;
+        shell->priv->connect_timeout = MDU_SHELL_DEFAULT_CONNECT_TIMEOUT;
 }
 
 MduShell *
@@ -142,6 +169,12 @@ mdu_shell_get_selected_presentable (MduShell *shell)
         return shell->priv->presentable_now_showing;
 }
 
+MduFleetModel *
+mdu_shell_get_fleet_model (MduShell *shell)
+{
+        return shell->priv->fleet_model;
+}
+
 void
 mdu_shell_select_presentable (MduShell *shell, MduPresentable *presentable)
 {
@@ -224,7 +257,11 @@ compute_sections_to_show (MduShell *shell)
 
         sections_to_show = NULL;
         if (shell->priv->presentable_now_showing != NULL) {
-                if (MDU_IS_HUB (shell->priv->presentable_now_showing)) {
+                if (MDU_IS_MACHINE (shell->priv->presentable_now_showing)) {
+
+                        sections_to_show = g_list_append (sections_to_show, (gpointer) MDU_TYPE_SECTION_FLEET);
+
+                } else if (MDU_IS_HUB (shell->priv->presentable_now_showing)) {
 
                         sections_to_show = g_list_append (sections_to_show, (gpointer) MDU_TYPE_SECTION_HUB);
 
@@ -741,32 +778,17 @@ on_file_connect_action (GtkAction *action,
         if (response == GTK_RESPONSE_OK) {
                 const gchar *user_name;
                 const gchar *address;
-                GError *error;
+                MduPoolConnectFlags flags;
 
                 user_name = mdu_connect_to_server_dialog_get_user_name (MDU_CONNECT_TO_SERVER_DIALOG (dialog));
                 address = mdu_connect_to_server_dialog_get_address (MDU_CONNECT_TO_SERVER_DIALOG (dialog));
+                flags = MDU_POOL_CONNECT_FLAGS_NONE;
+                if (mdu_connect_to_server_dialog_get_compress (MDU_CONNECT_TO_SERVER_DIALOG (dialog)))
+                        flags |= MDU_POOL_CONNECT_FLAGS_COMPRESS;
 
-                gtk_widget_destroy (dialog);
-
-                error = NULL;
-                if (!add_pool (shell, user_name, address, &error)) {
-                        GtkWidget *dialog;
-                        gchar *s;
+                mdu_shell_add_host (shell, user_name, address, flags);
 
-                        s = g_strdup_printf (_("Error connecting to “%s”"), address);
-
-                        dialog = mdu_error_dialog_new (GTK_WINDOW (mdu_shell_get_toplevel (shell)),
-                                                       NULL,
-                                                       s,
-                                                       error);
-                        g_free (s);
-                        gtk_widget_show_all (dialog);
-                        gtk_window_present (GTK_WINDOW (dialog));
-                        gtk_dialog_run (GTK_DIALOG (dialog));
-                        gtk_widget_destroy (dialog);
-
-                        g_error_free (error);
-                }
+                gtk_widget_destroy (dialog);
         } else {
                 gtk_widget_destroy (dialog);
         }
@@ -1045,6 +1067,31 @@ pool_disconnected (MduPool  *pool,
         g_object_unref (pool);
 
         mdu_pool_tree_model_set_pools (shell->priv->model, shell->priv->pools);
+        mdu_fleet_model_set_pools (shell->priv->fleet_model, shell->priv->pools);
+}
+
+/* takes ownership of @pool */
+static void
+shell_add_pool (MduShell *shell,
+                MduPool  *pool)
+{
+        g_signal_connect (pool, "presentable-added", (GCallback) presentable_added, shell);
+        g_signal_connect (pool, "presentable-removed", (GCallback) presentable_removed, shell);
+        g_signal_connect (pool, "disconnected", (GCallback) pool_disconnected, shell);
+
+        g_ptr_array_add (shell->priv->pools, pool);
+
+        if (shell->priv->model != NULL) {
+                MduPresentable *selected_presentable;
+
+                selected_presentable = mdu_shell_get_selected_presentable (shell);
+
+                mdu_pool_tree_model_set_pools (shell->priv->model, shell->priv->pools);
+                mdu_fleet_model_set_pools (shell->priv->fleet_model, shell->priv->pools);
+
+                if (selected_presentable != NULL)
+                        mdu_shell_select_presentable (shell, selected_presentable);
+        }
 }
 
 static gboolean
@@ -1062,27 +1109,198 @@ add_pool (MduShell     *shell,
         if (pool == NULL)
                 goto out;
 
-        g_signal_connect (pool, "presentable-added", (GCallback) presentable_added, shell);
-        g_signal_connect (pool, "presentable-removed", (GCallback) presentable_removed, shell);
-        g_signal_connect (pool, "disconnected", (GCallback) pool_disconnected, shell);
+        shell_add_pool (shell, pool);
 
-        g_ptr_array_add (shell->priv->pools, pool);
+        ret = TRUE;
 
-        if (shell->priv->model != NULL) {
-                MduPresentable *selected_presentable;
+ out:
+        return ret;
+}
 
-                selected_presentable = mdu_shell_get_selected_presentable (shell);
+/* ---------------------------------------------------------------------------------------------------- */
 
-                mdu_pool_tree_model_set_pools (shell->priv->model, shell->priv->pools);
+typedef struct {
+        MduShell *shell;
+        gchar *ssh_user_name;
+        gchar *ssh_address;
+        MduPoolConnectFlags flags;
+        GCancellable *cancellable;
+        guint timeout_id;
+        gboolean timed_out;
+} ConnectData;
 
-                if (selected_presentable != NULL)
-                        mdu_shell_select_presentable (shell, selected_presentable);
+static void
+connect_data_free (ConnectData *data)
+{
+        if (data->timeout_id > 0)
+                g_source_remove (data->timeout_id);
+        if (data->cancellable != NULL)
+                g_object_unref (data->cancellable);
+        g_object_unref (data->shell);
+        g_free (data->ssh_user_name);
+        g_free (data->ssh_address);
+        g_free (data);
+}
+
+static void
+show_connect_error (MduShell    *shell,
+                    const gchar *ssh_address,
+                    GError      *error)
+{
+        GtkWidget *dialog;
+        gchar *s;
+
+        s = g_strdup_printf (_("Error connecting to “%s”"), ssh_address);
+
+        /* not modal - with many hosts several of these may show up */
+        dialog = mdu_error_dialog_new (GTK_WINDOW (mdu_shell_get_toplevel (shell)),
+                                       NULL,
+                                       s,
+                                       error);
+        g_free (s);
+        g_signal_connect (dialog, "response", G_CALLBACK (gtk_widget_destroy), NULL);
+        gtk_widget_show_all (dialog);
+        gtk_window_present (GTK_WINDOW (dialog));
+}
+
+static void start_pending_connections (MduShell *shell);
+
+static gboolean
+on_connect_timeout (gpointer user_data)
+{
+        ConnectData *data = user_data;
+
+        data->timeout_id = 0;
+        data->timed_out = TRUE;
+        g_cancellable_cancel (data->cancellable);
+
+        return FALSE;
+}
+
+static void
+on_pool_connected (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+        ConnectData *data = user_data;
+        MduShell *shell = data->shell;
+        MduPool *pool;
+        GError *error;
+
+        error = NULL;
+        pool = mdu_pool_new_for_address_finish (res, &error);
+        if (pool != NULL) {
+                shell_add_pool (shell, pool);
+        } else {
+                if (data->timed_out) {
+                        g_error_free (error);
+                        error = g_error_new (MDU_ERROR,
+                                             MDU_ERROR_FAILED,
+                                             _("Timed out after %u seconds"),
+                                             shell->priv->connect_timeout);
+                }
+                show_connect_error (shell, data->ssh_address, error);
+                g_error_free (error);
         }
 
-        ret = TRUE;
+        shell->priv->num_connecting--;
+        g_object_ref (shell);
+        connect_data_free (data);
+        start_pending_connections (shell);
+        g_object_unref (shell);
+}
 
- out:
-        return ret;
+static void
+start_pending_connections (MduShell *shell)
+{
+        ConnectData *data;
+
+        while (shell->priv->num_connecting < shell->priv->max_connections &&
+               (data = g_queue_pop_head (shell->priv->pending_connections)) != NULL) {
+
+                data->cancellable = g_cancellable_new ();
+                if (shell->priv->connect_timeout > 0)
+                        data->timeout_id = g_timeout_add_seconds (shell->priv->connect_timeout,
+                                                                  on_connect_timeout,
+                                                                  data);
+                shell->priv->num_connecting++;
+
+                mdu_pool_new_for_address_async (data->ssh_user_name,
+                                                data->ssh_address,
+                                                data->flags,
+                                                data->cancellable,
+                                                on_pool_connected,
+                                                data);
+        }
+}
+
+/**
+ * mdu_shell_add_host:
+ * @shell: A #MduShell.
+ * @ssh_user_name: The user name to connect as or %NULL for the current user.
+ * @ssh_address: The host to connect to.
+ * @flags: Flags from #MduPoolConnectFlags.
+ *
+ * Connects to @ssh_address in the background and adds its devices to
+ * the tree once connected. Up to mdu_shell_set_max_connections() hosts
+ * are connected to at the same time; the rest are queued. Errors are
+ * reported in a dialog.
+ */
+void
+mdu_shell_add_host (MduShell            *shell,
+                    const gchar         *ssh_user_name,
+                    const gchar         *ssh_address,
+                    MduPoolConnectFlags  flags)
+{
+        ConnectData *data;
+
+        g_return_if_fail (MDU_IS_SHELL (shell));
+        g_return_if_fail (ssh_address != NULL);
+
+        data = g_new0 (ConnectData, 1);
+        data->shell = g_object_ref (shell);
+        data->ssh_user_name = g_strdup (ssh_user_name);
+        data->ssh_address = g_strdup (ssh_address);
+        data->flags = flags;
+        g_queue_push_tail (shell->priv->pending_connections, data);
+
+        start_pending_connections (shell);
+}
+
+/**
+ * mdu_shell_set_max_connections:
+ * @shell: A #MduShell.
+ * @max_connections: Maximum number of hosts to connect to at the same time.
+ *
+ * Sets how many hosts added with mdu_shell_add_host() are connected to
+ * concurrently. The default is 8.
+ */
+void
+mdu_shell_set_max_connections (MduShell *shell,
+                               guint     max_connections)
+{
+        g_return_if_fail (MDU_IS_SHELL (shell));
+
+        shell->priv->max_connections = MAX (max_connections, 1);
+        start_pending_connections (shell);
+}
+
+/**
+ * mdu_shell_set_connect_timeout:
+ * @shell: A #MduShell.
+ * @seconds: Timeout in seconds or 0 to wait forever.
+ *
+ * Sets how long to wait for the ssh connection to a host added with
+ * mdu_shell_add_host() to be established. This includes the time it
+ * takes the user to authenticate. The default is 120 seconds.
+ */
+void
+mdu_shell_set_connect_timeout (MduShell *shell,
+                               guint     seconds)
+{
+        g_return_if_fail (MDU_IS_SHELL (shell));
+
+        shell->priv->connect_timeout = seconds;
 }
 
 static void
@@ -1107,6 +1325,8 @@ create_window (MduShell *shell)
                 g_critical ("Bailing out");
         }
 
+        shell->priv->host_discovery = mdu_host_discovery_get_default ();
+
         shell->priv->app_window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
         gtk_window_set_resizable (GTK_WINDOW (shell->priv->app_window), TRUE);
         gtk_window_set_default_size (GTK_WINDOW (shell->priv->app_window), 800, 600);
@@ -1132,6 +1352,7 @@ create_window (MduShell *shell)
         shell->priv->model = mdu_pool_tree_model_new (shell->priv->pools,
                                                       NULL,
                                                       MDU_POOL_TREE_MODEL_FLAGS_NO_VOLUMES);
+        shell->priv->fleet_model = mdu_fleet_model_new (shell->priv->pools);
         shell->priv->tree_view = mdu_pool_tree_view_new (shell->priv->model,
                                                          MDU_POOL_TREE_VIEW_FLAGS_NONE);
         g_object_unref (shell->priv->model);
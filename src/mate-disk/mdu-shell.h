@@ -26,6 +26,7 @@
 #include <gtk/gtk.h>
 
 #include <mdu/mdu.h>
+#include <mdu-gtk/mdu-gtk.h>
 
 #define MDU_TYPE_SHELL             (mdu_shell_get_type ())
 #define MDU_SHELL(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), MDU_TYPE_SHELL, MduShell))
@@ -59,8 +60,17 @@ GtkWidget      *mdu_shell_get_toplevel                      (MduShell       *she
 MduPool        *mdu_shell_get_pool_for_selected_presentable (MduShell       *shell);
 void            mdu_shell_update                            (MduShell       *shell);
 MduPresentable *mdu_shell_get_selected_presentable          (MduShell       *shell);
+MduFleetModel  *mdu_shell_get_fleet_model                   (MduShell       *shell);
 void            mdu_shell_select_presentable                (MduShell       *shell,
                                                              MduPresentable *presentable);
+void            mdu_shell_add_host                          (MduShell       *shell,
+                                                             const gchar    *ssh_user_name,
+                                                             const gchar    *ssh_address,
+                                                             MduPoolConnectFlags flags);
+void            mdu_shell_set_max_connections               (MduShell       *shell,
+                                                             guint           max_connections);
+void            mdu_shell_set_connect_timeout               (MduShell       *shell,
+                                                             guint           seconds);
 void            mdu_shell_raise_error                       (MduShell       *shell,
                                                              MduPresentable *presentable,
                                                              GError         *error,
@@ -0,0 +1,1492 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-concurrent-benchmark-dialog.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "mdu-concurrent-benchmark-dialog.h"
+#include "mdu-details-table.h"
+#include "mdu-details-element.h"
+#include "mdu-button-element.h"
+#include "mdu-button-table.h"
+
+/* Reads from all drives behind a hub at the same time to find out whether
+ * the adapter, expander or bus limits the aggregate throughput. Each drive
+ * is read sequentially (see MDU_BENCHMARK_MODE_SEQUENTIAL) and the bytes
+ * transferred are polled every SAMPLE_INTERVAL_MSEC to draw per-drive and
+ * aggregate throughput over time.
+ *
+ * Optionally each drive is then read alone with the same parameters; the
+ * sum of those rates is what the hub would deliver if it didn't limit
+ * anything so the ratio of the two is the scaling efficiency.
+ *
+ * For a Linux MD RAID array the components are read at the same time
+ * instead, never written to. A RAID array is as fast as its slowest
+ * component so those reading well below their peers are pointed out,
+ * and the array itself is read alone at the end for comparison.
+ */
+
+#define SAMPLE_INTERVAL_MSEC 500
+
+/* same parameters for the concurrent and the individual runs */
+#define QUEUE_DEPTH 32
+#define BLOCK_SIZE  (1024 * 1024)
+
+/* a RAID component reading at less than this fraction of the median of
+ * the other components is pointed out as slow
+ */
+#define OUTLIER_FRACTION 0.70
+
+/* Tango palette; drives beyond this reuse the colors */
+static const gchar *member_colors[] = {
+        "#3465a4",
+        "#cc0000",
+        "#73d216",
+        "#f57900",
+        "#75507b",
+        "#c17d11",
+        "#edd400",
+        "#555753",
+};
+
+typedef struct {
+        MduPresentable *drive;
+        MduDevice *device;
+        gchar *name;
+        GdkColor color;
+
+        /* whether we can open the device file */
+        gboolean accessible;
+        gboolean selected;
+
+        /* non-NULL while the drive is being read */
+        MduBenchmark *benchmark;
+        guint64 last_bytes_transferred;
+
+        /* bytes per second for every SAMPLE_INTERVAL_MSEC of the concurrent run */
+        GArray *rates;
+
+        /* mean read rate while reading with the others and alone, or 0 if not measured */
+        gdouble together_rate;
+        gdouble alone_rate;
+
+        /* the RAID array itself, only ever read alone */
+        gboolean is_array;
+        /* a RAID component much slower than the others, see OUTLIER_FRACTION */
+        gboolean is_outlier;
+        /* median together_rate of the other components, or 0 if there are none */
+        gdouble peer_rate;
+} Member;
+
+enum {
+        PHASE_IDLE,
+        PHASE_TOGETHER,
+        PHASE_ALONE
+};
+
+enum {
+        MEMBER_COLUMN,
+        SELECTED_COLUMN,
+        ACCESSIBLE_COLUMN,
+        NAME_COLUMN,
+        COLOR_COLUMN,
+        TOGETHER_COLUMN,
+        TOGETHER_COLOR_COLUMN,
+        ALONE_COLUMN,
+        N_COLUMNS
+};
+
+struct MduConcurrentBenchmarkDialogPrivate
+{
+        gboolean deleted;
+
+        /* whether the presentable is a MduLinuxMdDrive rather than a MduHub */
+        gboolean is_linux_md;
+
+        /* Member for each drive, in the same order as the rows of @store */
+        GPtrArray *members;
+        GtkListStore *store;
+
+        GtkWidget *drawing_area;
+        GtkWidget *alone_check_button;
+        MduButtonElement *start_button;
+
+        MduDetailsElement *aggregate_element;
+        MduDetailsElement *sum_alone_element;
+        MduDetailsElement *scaling_element;
+        MduDetailsElement *array_element;
+        MduDetailsElement *outliers_element;
+        MduDetailsElement *status_element;
+
+        gint phase;
+        GCancellable *cancellable;
+        guint num_running;
+        /* the member being read alone in PHASE_ALONE */
+        guint alone_index;
+        gboolean do_alone;
+        /* the first error of the run, if any */
+        GError *error;
+
+        /* for sampling the concurrent run */
+        GTimer *timer;
+        gdouble last_sample_time;
+        guint sample_timeout_id;
+        /* sum of the rates of all members for every sample */
+        GArray *aggregate_rates;
+};
+
+G_DEFINE_TYPE (MduConcurrentBenchmarkDialog, mdu_concurrent_benchmark_dialog, MDU_TYPE_DIALOG)
+
+static gboolean on_drawing_area_expose_event (GtkWidget      *widget,
+                                              GdkEventExpose *event,
+                                              gpointer        user_data);
+static void start_next_alone (MduConcurrentBenchmarkDialog *dialog);
+static void update_dialog (MduConcurrentBenchmarkDialog *dialog);
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+member_free (Member *member)
+{
+        g_object_unref (member->drive);
+        g_object_unref (member->device);
+        g_free (member->name);
+        g_array_unref (member->rates);
+        /* a running benchmark holds a ref to the dialog so we never get here with one */
+        g_warn_if_fail (member->benchmark == NULL);
+        g_free (member);
+}
+
+static void
+mdu_concurrent_benchmark_dialog_finalize (GObject *object)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (object);
+
+        g_ptr_array_unref (dialog->priv->members);
+        g_object_unref (dialog->priv->store);
+        g_array_unref (dialog->priv->aggregate_rates);
+        g_timer_destroy (dialog->priv->timer);
+        if (dialog->priv->error != NULL)
+                g_error_free (dialog->priv->error);
+
+        if (G_OBJECT_CLASS (mdu_concurrent_benchmark_dialog_parent_class)->finalize != NULL)
+                G_OBJECT_CLASS (mdu_concurrent_benchmark_dialog_parent_class)->finalize (object);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Drives can be behind an expander which in turn is behind the adapter */
+static void
+collect_drives (MduPool         *pool,
+                MduPresentable  *presentable,
+                GList          **drives)
+{
+        GList *enclosed_presentables;
+        GList *l;
+
+        enclosed_presentables = mdu_pool_get_enclosed_presentables (pool, presentable);
+        for (l = enclosed_presentables; l != NULL; l = l->next) {
+                MduPresentable *p = MDU_PRESENTABLE (l->data);
+
+                if (MDU_IS_HUB (p))
+                        collect_drives (pool, p, drives);
+                else if (MDU_IS_DRIVE (p))
+                        *drives = g_list_prepend (*drives, g_object_ref (p));
+        }
+        g_list_foreach (enclosed_presentables, (GFunc) g_object_unref, NULL);
+        g_list_free (enclosed_presentables);
+}
+
+static void
+add_member (MduConcurrentBenchmarkDialog *dialog,
+            MduPresentable               *drive,
+            MduDevice                    *device,
+            gchar                        *name,
+            gboolean                      is_array)
+{
+        Member *member;
+        GtkTreeIter iter;
+        gboolean remote;
+
+        /* the benchmark runs in this process so the devices must be on this machine */
+        remote = (mdu_pool_get_ssh_address (mdu_dialog_get_pool (MDU_DIALOG (dialog))) != NULL);
+
+        member = g_new0 (Member, 1);
+        member->drive = g_object_ref (drive);
+        member->device = device;
+        member->name = name;
+        member->is_array = is_array;
+        gdk_color_parse (member_colors[dialog->priv->members->len % G_N_ELEMENTS (member_colors)],
+                         &member->color);
+        member->accessible = !remote && g_access (mdu_device_get_device_file (device), R_OK) == 0;
+        member->selected = member->accessible;
+        member->rates = g_array_new (FALSE, FALSE, sizeof (gdouble));
+        g_ptr_array_add (dialog->priv->members, member);
+
+        gtk_list_store_append (dialog->priv->store, &iter);
+        gtk_list_store_set (dialog->priv->store, &iter,
+                            MEMBER_COLUMN, member,
+                            SELECTED_COLUMN, member->selected,
+                            ACCESSIBLE_COLUMN, member->accessible,
+                            NAME_COLUMN, member->name,
+                            COLOR_COLUMN, member_colors[(dialog->priv->members->len - 1) % G_N_ELEMENTS (member_colors)],
+                            TOGETHER_COLUMN, "–",
+                            ALONE_COLUMN, "–",
+                            -1);
+}
+
+static void
+add_hub_members (MduConcurrentBenchmarkDialog *dialog)
+{
+        MduPool *pool;
+        GList *drives;
+        GList *l;
+
+        pool = mdu_dialog_get_pool (MDU_DIALOG (dialog));
+
+        drives = NULL;
+        collect_drives (pool, mdu_dialog_get_presentable (MDU_DIALOG (dialog)), &drives);
+        drives = g_list_sort (drives, (GCompareFunc) mdu_presentable_compare);
+
+        for (l = drives; l != NULL; l = l->next) {
+                MduPresentable *drive = MDU_PRESENTABLE (l->data);
+                MduDevice *device;
+
+                device = mdu_presentable_get_device (drive);
+                if (device == NULL)
+                        continue;
+                if (!mdu_device_is_media_available (device)) {
+                        g_object_unref (device);
+                        continue;
+                }
+
+                add_member (dialog, drive, device, mdu_presentable_get_vpd_name (drive), FALSE);
+        }
+
+        g_list_foreach (drives, (GFunc) g_object_unref, NULL);
+        g_list_free (drives);
+}
+
+/* Components are usually partitions so they are named after the drive
+ * they are on, along with the device file to tell them apart
+ */
+static gchar *
+get_component_name (MduPresentable *volume,
+                    MduDevice      *device)
+{
+        MduPresentable *p;
+        MduPresentable *enclosing;
+        gchar *vpd_name;
+        gchar *ret;
+
+        p = g_object_ref (volume);
+        while (p != NULL && !MDU_IS_DRIVE (p)) {
+                enclosing = mdu_presentable_get_enclosing_presentable (p);
+                g_object_unref (p);
+                p = enclosing;
+        }
+        if (p == NULL)
+                p = g_object_ref (volume);
+
+        vpd_name = mdu_presentable_get_vpd_name (p);
+        /* Translators: The name of a RAID component in the benchmark dialog.
+         * First %s is the name of the drive it is on (e.g. "WDC WD1002FAEX-0")
+         * Second %s is the device file (e.g. "/dev/sdb1")
+         */
+        ret = g_strdup_printf (_("%s (%s)"), vpd_name, mdu_device_get_device_file (device));
+        g_free (vpd_name);
+        g_object_unref (p);
+
+        return ret;
+}
+
+static void
+add_linux_md_members (MduConcurrentBenchmarkDialog *dialog)
+{
+        MduLinuxMdDrive *md_drive;
+        MduPool *pool;
+        MduDevice *device;
+        GList *slaves;
+        GList *l;
+
+        pool = mdu_dialog_get_pool (MDU_DIALOG (dialog));
+        md_drive = MDU_LINUX_MD_DRIVE (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+
+        slaves = mdu_linux_md_drive_get_slaves (md_drive);
+        for (l = slaves; l != NULL; l = l->next) {
+                MduDevice *slave = MDU_DEVICE (l->data);
+                MduLinuxMdDriveSlaveFlags flags;
+                MduPresentable *volume;
+
+                /* only what the array is actually reading from */
+                flags = mdu_linux_md_drive_get_slave_flags (md_drive, slave);
+                if (flags & (MDU_LINUX_MD_DRIVE_SLAVE_FLAGS_NOT_ATTACHED | MDU_LINUX_MD_DRIVE_SLAVE_FLAGS_FAULTY))
+                        continue;
+
+                volume = mdu_pool_get_volume_by_device (pool, slave);
+                if (volume == NULL)
+                        volume = mdu_pool_get_drive_by_device (pool, slave);
+                if (volume == NULL)
+                        continue;
+
+                add_member (dialog,
+                            volume,
+                            g_object_ref (slave),
+                            get_component_name (volume, slave),
+                            FALSE);
+                g_object_unref (volume);
+        }
+        g_list_foreach (slaves, (GFunc) g_object_unref, NULL);
+        g_list_free (slaves);
+
+        /* and last the array itself, if it is running */
+        device = mdu_presentable_get_device (MDU_PRESENTABLE (md_drive));
+        if (device != NULL) {
+                add_member (dialog,
+                            MDU_PRESENTABLE (md_drive),
+                            device,
+                            mdu_presentable_get_vpd_name (MDU_PRESENTABLE (md_drive)),
+                            TRUE);
+        }
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gdouble
+get_mean_read_rate (MduBenchmark *benchmark)
+{
+        GArray *samples;
+        gdouble sum;
+        guint n;
+
+        samples = mdu_benchmark_get_read_transfer_rate_samples (benchmark);
+        if (samples->len == 0)
+                return 0.0;
+
+        sum = 0.0;
+        for (n = 0; n < samples->len; n++)
+                sum += g_array_index (samples, MduBenchmarkSample, n).value;
+        return sum / samples->len;
+}
+
+/* the RAID array is left out of the concurrent run, reading it would slow down the components */
+static gboolean
+member_runs_together (Member *member)
+{
+        return member->selected && !member->is_array;
+}
+
+/* the array is always read alone, the drives or components only if asked to */
+static gboolean
+member_runs_alone (MduConcurrentBenchmarkDialog *dialog,
+                   Member                       *member)
+{
+        return member->selected && (dialog->priv->do_alone || member->is_array);
+}
+
+static gdouble
+get_progress (MduConcurrentBenchmarkDialog *dialog)
+{
+        guint num_together;
+        guint num_alone;
+        gdouble together_done;
+        gdouble alone_done;
+        guint n;
+
+        num_together = 0;
+        num_alone = 0;
+        together_done = 0.0;
+        alone_done = 0.0;
+        for (n = 0; n < dialog->priv->members->len; n++) {
+                Member *member = dialog->priv->members->pdata[n];
+
+                if (member_runs_together (member)) {
+                        num_together++;
+                        if (dialog->priv->phase == PHASE_TOGETHER && member->benchmark != NULL)
+                                together_done += mdu_benchmark_get_progress (member->benchmark);
+                        else if (dialog->priv->phase == PHASE_ALONE)
+                                together_done += 1.0;
+                }
+
+                if (member_runs_alone (dialog, member)) {
+                        num_alone++;
+                        if (dialog->priv->phase != PHASE_ALONE)
+                                continue;
+                        if (member->benchmark != NULL)
+                                alone_done += mdu_benchmark_get_progress (member->benchmark);
+                        else if (n < dialog->priv->alone_index)
+                                alone_done += 1.0;
+                }
+        }
+
+        /* the concurrent run counts as one unit, each individual run as another */
+        if (num_together > 0)
+                together_done /= num_together;
+        if (num_together + num_alone == 0)
+                return 0.0;
+        return CLAMP ((together_done + alone_done) / ((num_together > 0 ? 1 : 0) + num_alone), 0.0, 1.0);
+}
+
+static void
+sample_rates (MduConcurrentBenchmarkDialog *dialog)
+{
+        gdouble now;
+        gdouble dt;
+        gdouble aggregate;
+        guint n;
+
+        now = g_timer_elapsed (dialog->priv->timer, NULL);
+        dt = now - dialog->priv->last_sample_time;
+        if (dt <= 0.0)
+                goto out;
+        dialog->priv->last_sample_time = now;
+
+        aggregate = 0.0;
+        for (n = 0; n < dialog->priv->members->len; n++) {
+                Member *member = dialog->priv->members->pdata[n];
+                guint64 bytes_transferred;
+                gdouble rate;
+
+                if (!member_runs_together (member))
+                        continue;
+
+                /* a drive that finished early contributes nothing for the rest of the run */
+                rate = 0.0;
+                if (member->benchmark != NULL) {
+                        bytes_transferred = mdu_benchmark_get_bytes_transferred (member->benchmark);
+                        rate = (bytes_transferred - member->last_bytes_transferred) / dt;
+                        member->last_bytes_transferred = bytes_transferred;
+                }
+                g_array_append_val (member->rates, rate);
+                aggregate += rate;
+        }
+        g_array_append_val (dialog->priv->aggregate_rates, aggregate);
+
+ out:
+        ;
+}
+
+static gboolean
+on_sample_timeout (gpointer user_data)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (user_data);
+
+        if (dialog->priv->phase == PHASE_TOGETHER)
+                sample_rates (dialog);
+
+        if (!dialog->priv->deleted) {
+                update_dialog (dialog);
+                gtk_widget_queue_draw (dialog->priv->drawing_area);
+        }
+
+        return TRUE;
+}
+
+static void
+benchmark_finished (MduConcurrentBenchmarkDialog *dialog)
+{
+        GtkWidget *error_dialog;
+        GError *error;
+
+        dialog->priv->phase = PHASE_IDLE;
+        g_source_remove (dialog->priv->sample_timeout_id);
+        dialog->priv->sample_timeout_id = 0;
+        g_timer_stop (dialog->priv->timer);
+        g_object_unref (dialog->priv->cancellable);
+        dialog->priv->cancellable = NULL;
+
+        error = dialog->priv->error;
+        dialog->priv->error = NULL;
+
+        if (dialog->priv->deleted)
+                goto out;
+
+        update_dialog (dialog);
+        gtk_widget_queue_draw (dialog->priv->drawing_area);
+
+        if (error != NULL &&
+            !(error->domain == MDU_ERROR && error->code == MDU_ERROR_CANCELLED)) {
+                error_dialog = mdu_error_dialog_new (GTK_WINDOW (dialog),
+                                                     mdu_dialog_get_presentable (MDU_DIALOG (dialog)),
+                                                     _("Error benchmarking drives"),
+                                                     error);
+                gtk_widget_show_all (error_dialog);
+                gtk_window_present (GTK_WINDOW (error_dialog));
+                gtk_dialog_run (GTK_DIALOG (error_dialog));
+                gtk_widget_destroy (error_dialog);
+        }
+
+ out:
+        if (error != NULL)
+                g_error_free (error);
+}
+
+/* Individual runs are ordinary sequential reads of the drive so they go
+ * into its history like any other benchmark. RAID components that are
+ * partitions have no history of their own.
+ */
+static void
+append_to_history (Member       *member,
+                   MduBenchmark *benchmark)
+{
+        MduBenchmarkHistory *history;
+        MduBenchmarkHistoryRun run;
+        GError *error;
+
+        error = NULL;
+        history = NULL;
+        if (!mdu_device_is_drive (member->device))
+                goto out;
+
+        history = mdu_benchmark_history_new_for_drive (mdu_device_drive_get_vendor (member->device),
+                                                       mdu_device_drive_get_model (member->device),
+                                                       mdu_device_drive_get_serial (member->device),
+                                                       mdu_device_drive_get_wwn (member->device),
+                                                       &error);
+        if (history == NULL)
+                goto out;
+
+        mdu_benchmark_history_run_init_from_benchmark (&run, benchmark, MDU_BENCHMARK_FLAGS_NONE);
+        if (!mdu_benchmark_history_append_run (history, &run, &error))
+                goto out;
+
+ out:
+        if (error != NULL) {
+                g_warning ("Error saving benchmark data: %s", error->message);
+                g_error_free (error);
+        }
+        if (history != NULL)
+                g_object_unref (history);
+}
+
+static void
+benchmark_run_cb (GObject      *source_object,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (user_data);
+        MduBenchmark *benchmark = MDU_BENCHMARK (source_object);
+        Member *member;
+        GError *error;
+        guint n;
+
+        member = NULL;
+        for (n = 0; n < dialog->priv->members->len; n++) {
+                Member *m = dialog->priv->members->pdata[n];
+                if (m->benchmark == benchmark) {
+                        member = m;
+                        break;
+                }
+        }
+        g_assert (member != NULL);
+
+        /* pick up the bytes of the last partial interval before the benchmark goes away */
+        if (dialog->priv->phase == PHASE_TOGETHER && dialog->priv->num_running == 1)
+                sample_rates (dialog);
+
+        error = NULL;
+        if (!mdu_benchmark_run_finish (benchmark, res, &error)) {
+                /* one drive failing makes the comparison meaningless */
+                g_cancellable_cancel (dialog->priv->cancellable);
+                if (dialog->priv->error == NULL)
+                        dialog->priv->error = error;
+                else
+                        g_error_free (error);
+        } else if (dialog->priv->phase == PHASE_TOGETHER) {
+                member->together_rate = get_mean_read_rate (benchmark);
+        } else {
+                member->alone_rate = get_mean_read_rate (benchmark);
+                append_to_history (member, benchmark);
+        }
+
+        member->benchmark = NULL;
+        g_object_unref (benchmark);
+        dialog->priv->num_running--;
+
+        if (dialog->priv->num_running > 0)
+                goto out;
+
+        if (dialog->priv->error != NULL || g_cancellable_is_cancelled (dialog->priv->cancellable)) {
+                benchmark_finished (dialog);
+        } else if (dialog->priv->phase == PHASE_TOGETHER) {
+                dialog->priv->phase = PHASE_ALONE;
+                dialog->priv->alone_index = 0;
+                start_next_alone (dialog);
+        } else {
+                dialog->priv->alone_index++;
+                start_next_alone (dialog);
+        }
+
+ out:
+        g_object_unref (dialog);
+}
+
+static void
+start_member (MduConcurrentBenchmarkDialog *dialog,
+              Member                       *member)
+{
+        g_warn_if_fail (member->benchmark == NULL);
+
+        member->benchmark = mdu_benchmark_new (mdu_device_get_device_file (member->device));
+        mdu_benchmark_set_mode (member->benchmark, MDU_BENCHMARK_MODE_SEQUENTIAL);
+        mdu_benchmark_set_queue_depth (member->benchmark, QUEUE_DEPTH);
+        mdu_benchmark_set_block_size (member->benchmark, BLOCK_SIZE);
+        member->last_bytes_transferred = 0;
+
+        dialog->priv->num_running++;
+        mdu_benchmark_run_async (member->benchmark,
+                                 MDU_BENCHMARK_FLAGS_NONE,
+                                 dialog->priv->cancellable,
+                                 benchmark_run_cb,
+                                 g_object_ref (dialog));
+}
+
+static void
+start_next_alone (MduConcurrentBenchmarkDialog *dialog)
+{
+        guint n;
+
+        for (n = dialog->priv->alone_index; n < dialog->priv->members->len; n++) {
+                Member *member = dialog->priv->members->pdata[n];
+
+                if (member_runs_alone (dialog, member)) {
+                        dialog->priv->alone_index = n;
+                        start_member (dialog, member);
+                        goto out;
+                }
+        }
+
+        benchmark_finished (dialog);
+
+ out:
+        ;
+}
+
+static void
+start_benchmark (MduConcurrentBenchmarkDialog *dialog)
+{
+        guint n;
+
+        g_warn_if_fail (dialog->priv->phase == PHASE_IDLE);
+
+        dialog->priv->cancellable = g_cancellable_new ();
+        dialog->priv->do_alone = gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (dialog->priv->alone_check_button));
+        dialog->priv->phase = PHASE_TOGETHER;
+        g_array_set_size (dialog->priv->aggregate_rates, 0);
+
+        for (n = 0; n < dialog->priv->members->len; n++) {
+                Member *member = dialog->priv->members->pdata[n];
+
+                g_array_set_size (member->rates, 0);
+                member->together_rate = 0.0;
+                member->alone_rate = 0.0;
+                member->is_outlier = FALSE;
+                if (member_runs_together (member))
+                        start_member (dialog, member);
+        }
+
+        g_timer_start (dialog->priv->timer);
+        dialog->priv->last_sample_time = 0.0;
+        dialog->priv->sample_timeout_id = g_timeout_add (SAMPLE_INTERVAL_MSEC, on_sample_timeout, dialog);
+
+        /* e.g. only the RAID array is selected */
+        if (dialog->priv->num_running == 0) {
+                dialog->priv->phase = PHASE_ALONE;
+                dialog->priv->alone_index = 0;
+                start_next_alone (dialog);
+        }
+
+        update_dialog (dialog);
+        gtk_widget_queue_draw (dialog->priv->drawing_area);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+on_start_clicked (MduButtonElement *button_element,
+                  gpointer          user_data)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (user_data);
+
+        if (dialog->priv->phase == PHASE_IDLE)
+                start_benchmark (dialog);
+}
+
+static void
+on_status_element_activated (MduDetailsElement    *element,
+                             const gchar          *uri,
+                             gpointer              user_data)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (user_data);
+
+        if (dialog->priv->cancellable != NULL)
+                g_cancellable_cancel (dialog->priv->cancellable);
+}
+
+static void
+on_selected_toggled (GtkCellRendererToggle *renderer,
+                     gchar                 *path_string,
+                     gpointer               user_data)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (user_data);
+        GtkTreeIter iter;
+        Member *member;
+
+        if (dialog->priv->phase != PHASE_IDLE)
+                goto out;
+
+        if (!gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (dialog->priv->store), &iter, path_string))
+                goto out;
+
+        gtk_tree_model_get (GTK_TREE_MODEL (dialog->priv->store), &iter,
+                            MEMBER_COLUMN, &member,
+                            -1);
+        member->selected = !member->selected;
+        gtk_list_store_set (dialog->priv->store, &iter,
+                            SELECTED_COLUMN, member->selected,
+                            -1);
+
+        update_dialog (dialog);
+
+ out:
+        ;
+}
+
+static gboolean
+on_delete_event (GtkWidget *widget,
+                 GdkEvent  *event,
+                 gpointer   user_data)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (user_data);
+
+        dialog->priv->deleted = TRUE;
+
+        /* don't keep hammering the disks from threads no-one can see */
+        if (dialog->priv->cancellable != NULL)
+                g_cancellable_cancel (dialog->priv->cancellable);
+
+        return FALSE; /* propagate further */
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+mdu_concurrent_benchmark_dialog_constructed (GObject *object)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (object);
+        GtkWidget *content_area;
+        GtkWidget *align;
+        GtkWidget *vbox;
+        GtkWidget *vbox2;
+        GtkWidget *hbox;
+        GtkWidget *table;
+        GtkWidget *drawing_area;
+        GtkWidget *scrolled_window;
+        GtkWidget *tree_view;
+        GtkWidget *check_button;
+        GtkTreeViewColumn *column;
+        GtkCellRenderer *renderer;
+        GPtrArray *elements;
+        MduButtonElement *button_element;
+        MduDetailsElement *element;
+        gchar *s;
+        gchar *name;
+        gchar *vpd_name;
+
+        g_signal_connect (dialog,
+                          "delete-event",
+                          G_CALLBACK (on_delete_event),
+                          dialog);
+
+        dialog->priv->is_linux_md = MDU_IS_LINUX_MD_DRIVE (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+
+        name = mdu_presentable_get_name (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+        vpd_name = mdu_presentable_get_vpd_name (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+        if (dialog->priv->is_linux_md) {
+                /* Translators: The title of the concurrent benchmark dialog for a RAID array.
+                 * First %s is the name for the array (e.g. "2.0 TB RAID Array")
+                 * Second %s is the VPD name for the array (e.g. "RAID-5 Array")
+                 */
+                s = g_strdup_printf (_("%s (%s) – Benchmark Components"), name, vpd_name);
+        } else {
+                /* Translators: The title of the concurrent benchmark dialog.
+                 * First %s is the name for the hub (e.g. "SATA Host Adapter")
+                 * Second %s is the VPD name for the hub (e.g. "Intel 82801 SATA AHCI Controller")
+                 */
+                s = g_strdup_printf (_("%s (%s) – Benchmark Drives"), name, vpd_name);
+        }
+        gtk_window_set_title (GTK_WINDOW (dialog), s);
+        g_free (s);
+        g_free (vpd_name);
+        g_free (name);
+
+        content_area = gtk_dialog_get_content_area (GTK_DIALOG (dialog));
+
+        align = gtk_alignment_new (0.5, 0.5, 1.0, 1.0);
+        gtk_alignment_set_padding (GTK_ALIGNMENT (align), 12, 12, 12, 12);
+        gtk_box_pack_start (GTK_BOX (content_area), align, TRUE, TRUE, 0);
+
+        vbox = gtk_vbox_new (FALSE, 12);
+        gtk_container_add (GTK_CONTAINER (align), vbox);
+
+        /* ---------------------------------------------------------------------------------------------------- */
+
+        hbox = gtk_hbox_new (FALSE, 12);
+        gtk_box_pack_start (GTK_BOX (vbox), hbox, TRUE, TRUE, 0);
+
+        drawing_area = gtk_drawing_area_new ();
+        dialog->priv->drawing_area = drawing_area;
+        gtk_box_pack_start (GTK_BOX (hbox), drawing_area, TRUE, TRUE, 0);
+        g_signal_connect (drawing_area,
+                          "expose-event",
+                          G_CALLBACK (on_drawing_area_expose_event),
+                          dialog);
+        gtk_widget_set_size_request (drawing_area,
+                                     400,
+                                     300);
+
+        /* ---------------------------------------------------------------------------------------------------- */
+
+        dialog->priv->store = gtk_list_store_new (N_COLUMNS,
+                                                  G_TYPE_POINTER,
+                                                  G_TYPE_BOOLEAN,
+                                                  G_TYPE_BOOLEAN,
+                                                  G_TYPE_STRING,
+                                                  G_TYPE_STRING,
+                                                  G_TYPE_STRING,
+                                                  G_TYPE_STRING,
+                                                  G_TYPE_STRING);
+        if (dialog->priv->is_linux_md)
+                add_linux_md_members (dialog);
+        else
+                add_hub_members (dialog);
+
+        scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+        gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                        GTK_POLICY_NEVER,
+                                        GTK_POLICY_AUTOMATIC);
+        gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scrolled_window),
+                                             GTK_SHADOW_IN);
+        gtk_box_pack_start (GTK_BOX (hbox), scrolled_window, FALSE, TRUE, 0);
+
+        tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (dialog->priv->store));
+        gtk_tree_view_set_rules_hint (GTK_TREE_VIEW (tree_view), TRUE);
+        gtk_container_add (GTK_CONTAINER (scrolled_window), tree_view);
+
+        column = gtk_tree_view_column_new ();
+        gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+        if (dialog->priv->is_linux_md) {
+                /* Translators: Column header for the components of a RAID array in the concurrent benchmark dialog */
+                gtk_tree_view_column_set_title (column, _("Component"));
+        } else {
+                /* Translators: Column header for the drives in the concurrent benchmark dialog */
+                gtk_tree_view_column_set_title (column, _("Drive"));
+        }
+        gtk_tree_view_column_set_expand (column, TRUE);
+        renderer = gtk_cell_renderer_toggle_new ();
+        gtk_tree_view_column_pack_start (column, renderer, FALSE);
+        gtk_tree_view_column_set_attributes (column,
+                                             renderer,
+                                             "active", SELECTED_COLUMN,
+                                             "activatable", ACCESSIBLE_COLUMN,
+                                             "sensitive", ACCESSIBLE_COLUMN,
+                                             NULL);
+        g_signal_connect (renderer,
+                          "toggled",
+                          G_CALLBACK (on_selected_toggled),
+                          dialog);
+        renderer = gtk_cell_renderer_text_new ();
+        gtk_tree_view_column_pack_start (column, renderer, TRUE);
+        /* the color matches the drive's line in the graph */
+        gtk_tree_view_column_set_attributes (column,
+                                             renderer,
+                                             "text", NAME_COLUMN,
+                                             "foreground", COLOR_COLUMN,
+                                             "sensitive", ACCESSIBLE_COLUMN,
+                                             NULL);
+
+        column = gtk_tree_view_column_new ();
+        gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+        /* Translators: Column header for the read rate of a drive while all drives are read */
+        gtk_tree_view_column_set_title (column, _("Together"));
+        renderer = gtk_cell_renderer_text_new ();
+        gtk_tree_view_column_pack_start (column, renderer, FALSE);
+        /* slow RAID components are shown in red */
+        gtk_tree_view_column_set_attributes (column,
+                                             renderer,
+                                             "text", TOGETHER_COLUMN,
+                                             "foreground", TOGETHER_COLOR_COLUMN,
+                                             NULL);
+
+        column = gtk_tree_view_column_new ();
+        gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+        /* Translators: Column header for the read rate of a drive when read on its own */
+        gtk_tree_view_column_set_title (column, _("Alone"));
+        renderer = gtk_cell_renderer_text_new ();
+        gtk_tree_view_column_pack_start (column, renderer, FALSE);
+        gtk_tree_view_column_set_attributes (column,
+                                             renderer,
+                                             "text", ALONE_COLUMN,
+                                             NULL);
+
+        /* ---------------------------------------------------------------------------------------------------- */
+
+        align = gtk_alignment_new (0.5, 0.5, 1.0, 1.0);
+        gtk_alignment_set_padding (GTK_ALIGNMENT (align), 0, 0, 36, 0);
+        gtk_box_pack_start (GTK_BOX (vbox), align, FALSE, FALSE, 0);
+
+        vbox2 = gtk_vbox_new (FALSE, 12);
+        gtk_container_add (GTK_CONTAINER (align), vbox2);
+
+        if (dialog->priv->is_linux_md) {
+                check_button = gtk_check_button_new_with_mnemonic (_("Also benchmark each component _alone for comparison"));
+                gtk_widget_set_tooltip_text (check_button,
+                                             _("After reading all components at the same time, read each component "
+                                               "on its own to find out how much they slow each other down"));
+        } else {
+                check_button = gtk_check_button_new_with_mnemonic (_("Also benchmark each drive _alone for comparison"));
+                gtk_widget_set_tooltip_text (check_button,
+                                             _("After reading all drives at the same time, read each drive on its own "
+                                               "to find out how much the hub limits the throughput"));
+        }
+        gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (check_button), TRUE);
+        gtk_box_pack_start (GTK_BOX (vbox2), check_button, FALSE, FALSE, 0);
+        dialog->priv->alone_check_button = check_button;
+
+        elements = g_ptr_array_new_with_free_func (g_object_unref);
+
+        element = mdu_details_element_new (_("Aggregate Read Rate:"), NULL,
+                                           _("The sum of the read rates of all drives while read at the same time"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->aggregate_element = element;
+
+        element = mdu_details_element_new (_("Sum of Individual Rates:"), NULL,
+                                           _("The sum of the read rates of the drives when each is read on its own"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->sum_alone_element = element;
+
+        element = mdu_details_element_new (_("Scaling:"), NULL,
+                                           _("The aggregate read rate compared with the sum of the individual "
+                                             "rates. Well below 100% means that the hub or the bus it is "
+                                             "attached to is the bottleneck"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->scaling_element = element;
+
+        if (dialog->priv->is_linux_md) {
+                element = mdu_details_element_new (_("Array Read Rate:"), NULL,
+                                                   _("The read rate of the RAID array itself, read after the components"));
+                g_ptr_array_add (elements, element);
+                dialog->priv->array_element = element;
+
+                element = mdu_details_element_new (_("Slow Components:"), NULL,
+                                                   _("Components reading much slower than the others while all are "
+                                                     "read at the same time. The array can't be faster than its "
+                                                     "slowest component"));
+                g_ptr_array_add (elements, element);
+                dialog->priv->outliers_element = element;
+        }
+
+        element = mdu_details_element_new (_("Status:"), NULL, NULL);
+        g_ptr_array_add (elements, element);
+        dialog->priv->status_element = element;
+        g_signal_connect (element,
+                          "activated",
+                          G_CALLBACK (on_status_element_activated),
+                          dialog);
+
+        table = mdu_details_table_new (2, elements);
+        g_ptr_array_unref (elements);
+        gtk_box_pack_start (GTK_BOX (vbox2), table, FALSE, FALSE, 0);
+
+        elements = g_ptr_array_new_with_free_func (g_object_unref);
+
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("Start _Benchmark"),
+                                                 _("Read all selected drives at the same time"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (on_start_clicked),
+                          dialog);
+        g_ptr_array_add (elements, button_element);
+        dialog->priv->start_button = button_element;
+
+        table = mdu_button_table_new (2, elements);
+        g_ptr_array_unref (elements);
+        gtk_box_pack_start (GTK_BOX (vbox2), table, FALSE, FALSE, 0);
+
+        update_dialog (dialog);
+
+        if (G_OBJECT_CLASS (mdu_concurrent_benchmark_dialog_parent_class)->constructed != NULL)
+                G_OBJECT_CLASS (mdu_concurrent_benchmark_dialog_parent_class)->constructed (object);
+}
+
+static void
+mdu_concurrent_benchmark_dialog_class_init (MduConcurrentBenchmarkDialogClass *klass)
+{
+        GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+        g_type_class_add_private (klass, sizeof (MduConcurrentBenchmarkDialogPrivate));
+
+        object_class->constructed  = mdu_concurrent_benchmark_dialog_constructed;
+        object_class->finalize     = mdu_concurrent_benchmark_dialog_finalize;
+}
+
+static void
+mdu_concurrent_benchmark_dialog_init (MduConcurrentBenchmarkDialog *dialog)
+{
+        dialog->priv = G_TYPE_INSTANCE_GET_PRIVATE (dialog, MDU_TYPE_CONCURRENT_BENCHMARK_DIALOG, MduConcurrentBenchmarkDialogPrivate);
+
+        dialog->priv->members = g_ptr_array_new_with_free_func ((GDestroyNotify) member_free);
+        dialog->priv->aggregate_rates = g_array_new (FALSE, FALSE, sizeof (gdouble));
+        dialog->priv->timer = g_timer_new ();
+        g_timer_stop (dialog->priv->timer);
+}
+
+GtkWidget *
+mdu_concurrent_benchmark_dialog_new (GtkWindow *parent,
+                                     MduHub    *hub)
+{
+        return GTK_WIDGET (g_object_new (MDU_TYPE_CONCURRENT_BENCHMARK_DIALOG,
+                                         "transient-for", parent,
+                                         "presentable", hub,
+                                         NULL));
+}
+
+GtkWidget *
+mdu_concurrent_benchmark_dialog_new_for_linux_md_drive (GtkWindow       *parent,
+                                                        MduLinuxMdDrive *drive)
+{
+        return GTK_WIDGET (g_object_new (MDU_TYPE_CONCURRENT_BENCHMARK_DIALOG,
+                                         "transient-for", parent,
+                                         "presentable", drive,
+                                         NULL));
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gdouble
+measure_width (cairo_t     *cr,
+               const gchar *s)
+{
+        cairo_text_extents_t te;
+        cairo_select_font_face (cr, "sans",
+                                CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size (cr, 8.0);
+        cairo_text_extents (cr, s, &te);
+        return te.width;
+}
+
+static gdouble
+measure_height (cairo_t     *cr,
+                const gchar *s)
+{
+        cairo_text_extents_t te;
+        cairo_select_font_face (cr, "sans",
+                                CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size (cr, 8.0);
+        cairo_text_extents (cr, s, &te);
+        return te.height;
+}
+
+static void
+draw_rates (cairo_t *cr,
+            GArray  *rates,
+            guint    num_x_samples,
+            gdouble  max_visible_speed,
+            gdouble  gx,
+            gdouble  gy,
+            gdouble  gw,
+            gdouble  gh)
+{
+        gdouble x, y;
+        guint n;
+
+        for (n = 0; n < rates->len; n++) {
+                gdouble rate = g_array_index (rates, gdouble, n);
+
+                /* a sample covers the interval before it */
+                x = gx + gw * (n + 1) / num_x_samples;
+                y = gy + gh - gh * rate / max_visible_speed;
+                if (n == 0)
+                        cairo_move_to (cr, gx, y);
+                cairo_line_to (cr, x, y);
+        }
+        cairo_stroke (cr);
+}
+
+/* Read rate over time: a thin line for each drive and a thick one for the sum */
+static gboolean
+on_drawing_area_expose_event (GtkWidget      *widget,
+                              GdkEventExpose *event,
+                              gpointer        user_data)
+{
+        MduConcurrentBenchmarkDialog *dialog = MDU_CONCURRENT_BENCHMARK_DIALOG (user_data);
+        GtkAllocation allocation;
+        cairo_t *cr;
+        gdouble width, height;
+        gdouble gx, gy, gw, gh;
+        gdouble w;
+        gdouble x, y;
+        gdouble x_marker_height;
+        gdouble max_speed;
+        gdouble speed_res;
+        gdouble max_visible_speed;
+        guint num_y_markers;
+        guint num_x_markers;
+        guint num_x_samples;
+        guint secs_per_x_marker;
+        gchar *s;
+        guint n;
+
+        max_speed = 0.0;
+        for (n = 0; n < dialog->priv->aggregate_rates->len; n++)
+                max_speed = MAX (max_speed, g_array_index (dialog->priv->aggregate_rates, gdouble, n));
+        /* same scale steps as the transfer rate graph */
+        speed_res = (floor (((gdouble) max_speed) / (100 * 1000 * 1000)) + 1) * 1000 * 1000;
+        speed_res *= 10.0;
+        num_y_markers = (max_speed / speed_res) + 1;
+        max_visible_speed = speed_res * num_y_markers;
+
+        /* the sequential benchmark runs for 30 seconds; grow if a drive is slow to finish */
+        num_x_samples = MAX (30 * 1000 / SAMPLE_INTERVAL_MSEC, dialog->priv->aggregate_rates->len);
+        secs_per_x_marker = 5 * (1 + num_x_samples * SAMPLE_INTERVAL_MSEC / 1000 / 40);
+        num_x_markers = num_x_samples * SAMPLE_INTERVAL_MSEC / 1000 / secs_per_x_marker;
+
+        gtk_widget_get_allocation (widget, &allocation);
+        width = allocation.width;
+        height = allocation.height;
+
+        cr = gdk_cairo_create (gtk_widget_get_window (widget));
+
+        cairo_select_font_face (cr, "sans",
+                                CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size (cr, 8.0);
+        cairo_set_line_width (cr, 1.0);
+
+        cairo_rectangle (cr,
+                         event->area.x, event->area.y,
+                         event->area.width, event->area.height);
+        cairo_clip (cr);
+
+        /* make room for the y markers on the left and the x markers below */
+        s = g_strdup_printf (_("%d MB/s"), (gint) (max_visible_speed / (1000 * 1000)));
+        gx = ceil (measure_width (cr, s)) + 2 * 3;
+        gy = ceil (measure_height (cr, s) / 2.0);
+        g_free (s);
+        x_marker_height = ceil (measure_height (cr, "000 s")) + 10;
+        w = ceil (measure_width (cr, "000 s") / 2.0);
+        gw = width - gx - w;
+        gh = height - gy - x_marker_height;
+
+        /* y markers ("%d MB/s") */
+        for (n = 0; n <= num_y_markers; n++) {
+                cairo_text_extents_t te;
+
+                /* Translators: This is used in the benchmark graph - %d is megabytes per second */
+                s = g_strdup_printf (_("%d MB/s"), (gint) (n * speed_res / (1000 * 1000)));
+                cairo_text_extents (cr, s, &te);
+                x = gx / 2.0;
+                y = gy + gh - gh * n / num_y_markers;
+                cairo_move_to (cr,
+                               x - te.x_bearing - te.width/2,
+                               y - te.y_bearing - te.height/2);
+                cairo_set_source_rgb (cr, 0, 0, 0);
+                cairo_show_text (cr, s);
+                g_free (s);
+        }
+
+        /* x markers (elapsed time) */
+        for (n = 0; n <= num_x_markers; n++) {
+                cairo_text_extents_t te;
+                guint secs;
+
+                secs = n * secs_per_x_marker;
+                x = gx + gw * secs * 1000 / SAMPLE_INTERVAL_MSEC / num_x_samples;
+                y = gy + gh + x_marker_height / 2.0;
+                /* Translators: This is used in the concurrent benchmark graph - %u is seconds since the start */
+                s = g_strdup_printf (_("%u s"), secs);
+                cairo_text_extents (cr, s, &te);
+                cairo_move_to (cr,
+                               x - te.x_bearing - te.width/2,
+                               y - te.y_bearing - te.height/2);
+                cairo_set_source_rgb (cr, 0, 0, 0);
+                cairo_show_text (cr, s);
+                g_free (s);
+        }
+
+        /* graph area and grid */
+        cairo_set_source_rgb (cr, 1, 1, 1);
+        cairo_rectangle (cr, gx + 0.5, gy + 0.5, gw, gh);
+        cairo_fill_preserve (cr);
+        cairo_set_source_rgba (cr, 0, 0, 0, 0.25);
+        cairo_stroke_preserve (cr);
+        cairo_clip (cr);
+        for (n = 1; n < num_y_markers; n++) {
+                y = gy + ceil (n * gh / num_y_markers);
+                cairo_move_to (cr, gx + 0.5, y + 0.5);
+                cairo_line_to (cr, gx + gw + 0.5, y + 0.5);
+                cairo_stroke (cr);
+        }
+
+        /* each drive in the color of its row */
+        cairo_set_line_width (cr, 1.5);
+        for (n = 0; n < dialog->priv->members->len; n++) {
+                Member *member = dialog->priv->members->pdata[n];
+
+                gdk_cairo_set_source_color (cr, &member->color);
+                draw_rates (cr, member->rates, num_x_samples, max_visible_speed, gx, gy, gw, gh);
+        }
+
+        /* and the sum on top */
+        cairo_set_source_rgb (cr, 0, 0, 0);
+        cairo_set_line_width (cr, 2.5);
+        draw_rates (cr, dialog->priv->aggregate_rates, num_x_samples, max_visible_speed, gx, gy, gw, gh);
+
+        cairo_destroy (cr);
+
+        /* propagate event further */
+        return FALSE;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gint
+compare_rates (gconstpointer a,
+               gconstpointer b)
+{
+        gdouble rate_a = *((const gdouble *) a);
+        gdouble rate_b = *((const gdouble *) b);
+
+        if (rate_a < rate_b)
+                return -1;
+        else if (rate_a > rate_b)
+                return 1;
+        return 0;
+}
+
+/* Compares each component with the median of the others rather than the
+ * mean so a single slow component doesn't drag down the rate it is
+ * compared with. Only the concurrent run counts since that is how the
+ * array reads from its components.
+ */
+static void
+find_outliers (MduConcurrentBenchmarkDialog *dialog)
+{
+        GArray *rates;
+        guint n;
+        guint m;
+
+        rates = g_array_new (FALSE, FALSE, sizeof (gdouble));
+        for (n = 0; n < dialog->priv->members->len; n++) {
+                Member *member = dialog->priv->members->pdata[n];
+
+                member->is_outlier = FALSE;
+                member->peer_rate = 0.0;
+                if (member->is_array || member->together_rate <= 0.0)
+                        continue;
+
+                g_array_set_size (rates, 0);
+                for (m = 0; m < dialog->priv->members->len; m++) {
+                        Member *other = dialog->priv->members->pdata[m];
+
+                        if (m == n || other->is_array || other->together_rate <= 0.0)
+                                continue;
+                        g_array_append_val (rates, other->together_rate);
+                }
+                if (rates->len == 0)
+                        continue;
+
+                g_array_sort (rates, compare_rates);
+                if (rates->len % 2 == 1)
+                        member->peer_rate = g_array_index (rates, gdouble, rates->len / 2);
+                else
+                        member->peer_rate = (g_array_index (rates, gdouble, rates->len / 2 - 1) +
+                                             g_array_index (rates, gdouble, rates->len / 2)) / 2.0;
+
+                member->is_outlier = member->together_rate < OUTLIER_FRACTION * member->peer_rate;
+        }
+        g_array_unref (rates);
+}
+
+static void
+update_dialog (MduConcurrentBenchmarkDialog *dialog)
+{
+        gdouble together_sum;
+        gdouble alone_sum;
+        guint num_selected;
+        guint num_together;
+        guint num_alone;
+        gdouble array_rate;
+        GString *outliers;
+        GtkTreeIter iter;
+        gchar *s;
+        guint n;
+
+        if (dialog->priv->deleted)
+                goto out;
+
+        if (dialog->priv->is_linux_md)
+                find_outliers (dialog);
+
+        together_sum = 0.0;
+        alone_sum = 0.0;
+        num_selected = 0;
+        num_together = 0;
+        num_alone = 0;
+        array_rate = 0.0;
+        outliers = g_string_new (NULL);
+        for (n = 0; n < dialog->priv->members->len; n++) {
+                Member *member = dialog->priv->members->pdata[n];
+                gchar *together_text;
+                gchar *alone_text;
+
+                if (member->selected)
+                        num_selected++;
+
+                /* the array is not part of the aggregate, it's reported on its own */
+                if (member->is_array) {
+                        array_rate = member->alone_rate;
+                        alone_text = member->alone_rate > 0.0 ? mdu_util_get_speed_for_display (member->alone_rate) : g_strdup ("–");
+                        if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (dialog->priv->store), &iter, NULL, n)) {
+                                gtk_list_store_set (dialog->priv->store, &iter,
+                                                    TOGETHER_COLUMN, "–",
+                                                    ALONE_COLUMN, alone_text,
+                                                    -1);
+                        }
+                        g_free (alone_text);
+                        continue;
+                }
+
+                if (member->together_rate > 0.0) {
+                        s = mdu_util_get_speed_for_display (member->together_rate);
+                        if (member->is_outlier) {
+                                /* Translators: Read rate of a slow RAID component and how it compares with
+                                 * the others, e.g. "55.2 MB/s (-45%)"
+                                 */
+                                together_text = g_strdup_printf (_("%s (%+.0f%%)"),
+                                                                 s,
+                                                                 100.0 * (member->together_rate - member->peer_rate) / member->peer_rate);
+                                if (outliers->len > 0)
+                                        g_string_append (outliers, ", ");
+                                g_string_append (outliers, member->name);
+                                g_free (s);
+                        } else {
+                                together_text = s;
+                        }
+                        together_sum += member->together_rate;
+                        num_together++;
+                } else {
+                        together_text = g_strdup ("–");
+                }
+                if (member->alone_rate > 0.0) {
+                        alone_text = mdu_util_get_speed_for_display (member->alone_rate);
+                        alone_sum += member->alone_rate;
+                        num_alone++;
+                } else {
+                        alone_text = g_strdup ("–");
+                }
+
+                if (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (dialog->priv->store), &iter, NULL, n)) {
+                        gtk_list_store_set (dialog->priv->store, &iter,
+                                            TOGETHER_COLUMN, together_text,
+                                            TOGETHER_COLOR_COLUMN, member->is_outlier ? "#cc0000" : NULL,
+                                            ALONE_COLUMN, alone_text,
+                                            -1);
+                }
+                g_free (together_text);
+                g_free (alone_text);
+        }
+
+        if (dialog->priv->is_linux_md) {
+                if (array_rate > 0.0) {
+                        s = mdu_util_get_speed_for_display (array_rate);
+                        mdu_details_element_set_text (dialog->priv->array_element, s);
+                        g_free (s);
+                } else {
+                        mdu_details_element_set_text (dialog->priv->array_element, "–");
+                }
+
+                if (outliers->len > 0)
+                        mdu_details_element_set_text (dialog->priv->outliers_element, outliers->str);
+                else if (num_together > 1)
+                        /* Translators: Shown when no RAID component is much slower than the others */
+                        mdu_details_element_set_text (dialog->priv->outliers_element, _("None"));
+                else
+                        mdu_details_element_set_text (dialog->priv->outliers_element, "–");
+        }
+        g_string_free (outliers, TRUE);
+
+        if (num_together > 0) {
+                s = mdu_util_get_speed_for_display (together_sum);
+                mdu_details_element_set_text (dialog->priv->aggregate_element, s);
+                g_free (s);
+        } else {
+                mdu_details_element_set_text (dialog->priv->aggregate_element, "–");
+        }
+
+        /* only comparable if every drive of the concurrent run was also read alone */
+        if (num_alone > 0 && num_alone == num_together) {
+                s = mdu_util_get_speed_for_display (alone_sum);
+                mdu_details_element_set_text (dialog->priv->sum_alone_element, s);
+                g_free (s);
+                /* Translators: The aggregate read rate in percent of the sum of the individual rates */
+                s = g_strdup_printf (_("%.0f%%"), 100.0 * together_sum / alone_sum);
+                mdu_details_element_set_text (dialog->priv->scaling_element, s);
+                g_free (s);
+        } else {
+                mdu_details_element_set_text (dialog->priv->sum_alone_element, "–");
+                mdu_details_element_set_text (dialog->priv->scaling_element, "–");
+        }
+
+        if (dialog->priv->phase != PHASE_IDLE) {
+                mdu_details_element_set_progress (dialog->priv->status_element, get_progress (dialog));
+                mdu_details_element_set_text (dialog->priv->status_element, NULL);
+                mdu_details_element_set_action_text (dialog->priv->status_element,
+                                                     /* Translators: Text used in the hyperlink in the status
+                                                      * table to cancel the benchmark */
+                                                     _("Cancel"));
+                mdu_details_element_set_action_tooltip (dialog->priv->status_element,
+                                                        /* Translators: Tooptip for the "Cancel" hyperlink */
+                                                        _("Cancels the currently running benchmark"));
+        } else {
+                mdu_details_element_set_progress (dialog->priv->status_element, -1.0);
+                if (dialog->priv->members->len == 0)
+                        mdu_details_element_set_text (dialog->priv->status_element, _("No drives with media"));
+                else if (num_selected == 0)
+                        mdu_details_element_set_text (dialog->priv->status_element, _("No drives selected"));
+                else
+                        mdu_details_element_set_text (dialog->priv->status_element, _("Idle"));
+                mdu_details_element_set_action_text (dialog->priv->status_element, NULL);
+                mdu_details_element_set_action_tooltip (dialog->priv->status_element, NULL);
+        }
+
+        mdu_button_element_set_visible (dialog->priv->start_button,
+                                        dialog->priv->phase == PHASE_IDLE && num_selected > 0);
+        gtk_widget_set_sensitive (dialog->priv->alone_check_button, dialog->priv->phase == PHASE_IDLE);
+
+ out:
+        ;
+}
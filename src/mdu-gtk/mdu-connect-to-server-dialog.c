@@ -24,7 +24,6 @@
 
 #include "config.h"
 #include <glib/gi18n-lib.h>
-#include <avahi-ui/avahi-ui.h>
 
 #include "mdu-connect-to-server-dialog.h"
 
@@ -32,6 +31,9 @@ struct MduConnectToServerDialogPrivate
 {
         GtkWidget *hostname_entry;
         GtkWidget *username_entry;
+        GtkWidget *compress_check_button;
+
+        MduHostDiscovery *discovery;
 };
 
 enum
@@ -39,6 +41,7 @@ enum
         PROP_0,
         PROP_USER_NAME,
         PROP_ADDRESS,
+        PROP_COMPRESS,
 };
 
 G_DEFINE_TYPE (MduConnectToServerDialog, mdu_connect_to_server_dialog, GTK_TYPE_DIALOG);
@@ -48,7 +51,10 @@ static void mdu_connect_to_server_dialog_constructed (GObject *object);
 static void
 mdu_connect_to_server_dialog_finalize (GObject *object)
 {
-        //MduConnectToServerDialog *dialog = MDU_CONNECT_TO_SERVER_DIALOG (object);
+        MduConnectToServerDialog *dialog = MDU_CONNECT_TO_SERVER_DIALOG (object);
+
+        if (dialog->priv->discovery != NULL)
+                g_object_unref (dialog->priv->discovery);
 
         if (G_OBJECT_CLASS (mdu_connect_to_server_dialog_parent_class)->finalize != NULL)
                 G_OBJECT_CLASS (mdu_connect_to_server_dialog_parent_class)->finalize (object);
@@ -71,6 +77,10 @@ mdu_connect_to_server_dialog_get_property (GObject    *object,
                 g_value_take_string (value, mdu_connect_to_server_dialog_get_address (dialog));
                 break;
 
+        case PROP_COMPRESS:
+                g_value_set_boolean (value, mdu_connect_to_server_dialog_get_compress (dialog));
+                break;
+
         default:
                 G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
                 break;
@@ -109,6 +119,17 @@ mdu_connect_to_server_dialog_class_init (MduConnectToServerDialogClass *klass)
                                                               G_PARAM_STATIC_NAME |
                                                               G_PARAM_STATIC_NICK |
                                                               G_PARAM_STATIC_BLURB));
+
+        g_object_class_install_property (object_class,
+                                         PROP_COMPRESS,
+                                         g_param_spec_boolean ("compress",
+                                                               _("Compress"),
+                                                               _("Whether to compress the traffic"),
+                                                               TRUE,
+                                                               G_PARAM_READABLE |
+                                                               G_PARAM_STATIC_NAME |
+                                                               G_PARAM_STATIC_NICK |
+                                                               G_PARAM_STATIC_BLURB));
 }
 
 static void
@@ -141,35 +162,274 @@ mdu_connect_to_server_dialog_get_address  (MduConnectToServerDialog *dialog)
         return g_strdup (gtk_entry_get_text (GTK_ENTRY (dialog->priv->hostname_entry)));
 }
 
+gboolean
+mdu_connect_to_server_dialog_get_compress (MduConnectToServerDialog *dialog)
+{
+        g_return_val_if_fail (MDU_IS_CONNECT_TO_SERVER_DIALOG (dialog), FALSE);
+        return gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (dialog->priv->compress_check_button));
+}
+
 /* ---------------------------------------------------------------------------------------------------- */
 
+static gint
+host_compare_func (GtkTreeModel *model,
+                   GtkTreeIter  *a,
+                   GtkTreeIter  *b,
+                   gpointer      user_data)
+{
+        gboolean present_a;
+        gboolean present_b;
+        guint64 last_seen_a;
+        guint64 last_seen_b;
+        gchar *name_a;
+        gchar *name_b;
+        gint ret;
+
+        gtk_tree_model_get (model, a,
+                            MDU_HOST_DISCOVERY_COLUMN_PRESENT, &present_a,
+                            MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, &last_seen_a,
+                            MDU_HOST_DISCOVERY_COLUMN_NAME, &name_a,
+                            -1);
+        gtk_tree_model_get (model, b,
+                            MDU_HOST_DISCOVERY_COLUMN_PRESENT, &present_b,
+                            MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, &last_seen_b,
+                            MDU_HOST_DISCOVERY_COLUMN_NAME, &name_b,
+                            -1);
+
+        /* hosts currently on the network first, then most recently seen */
+        if (present_a != present_b)
+                ret = present_a ? -1 : 1;
+        else if (!present_a && last_seen_a != last_seen_b)
+                ret = last_seen_a > last_seen_b ? -1 : 1;
+        else
+                ret = g_utf8_collate (name_a, name_b);
+
+        g_free (name_a);
+        g_free (name_b);
+        return ret;
+}
+
+static gboolean
+host_visible_func (GtkTreeModel *model,
+                   GtkTreeIter  *iter,
+                   gpointer      user_data)
+{
+        gchar *host_name;
+        gboolean ret;
+
+        /* can't connect to something we haven't resolved yet */
+        gtk_tree_model_get (model, iter,
+                            MDU_HOST_DISCOVERY_COLUMN_HOST_NAME, &host_name,
+                            -1);
+        ret = (host_name != NULL);
+        g_free (host_name);
+        return ret;
+}
+
+static gchar *
+format_last_seen (guint64 last_seen)
+{
+        GTimeVal now;
+        gint64 age;
+        gchar *s;
+
+        g_get_current_time (&now);
+        age = now.tv_sec - (gint64) last_seen;
+
+        if (age < 60 * 60) {
+                s = g_strdup (_("Last seen less than an hour ago"));
+        } else if (age < 24 * 60 * 60) {
+                s = g_strdup_printf (dngettext (GETTEXT_PACKAGE,
+                                                "Last seen %d hour ago",
+                                                "Last seen %d hours ago",
+                                                (gint) (age / 60 / 60)),
+                                     (gint) (age / 60 / 60));
+        } else {
+                s = g_strdup_printf (dngettext (GETTEXT_PACKAGE,
+                                                "Last seen %d day ago",
+                                                "Last seen %d days ago",
+                                                (gint) (age / 24 / 60 / 60)),
+                                     (gint) (age / 24 / 60 / 60));
+        }
+        return s;
+}
+
+static void
+host_text_data_func (GtkCellLayout   *cell_layout,
+                     GtkCellRenderer *renderer,
+                     GtkTreeModel    *model,
+                     GtkTreeIter     *iter,
+                     gpointer         user_data)
+{
+        gchar *name;
+        gchar *host_name;
+        gchar *address;
+        guint64 last_seen;
+        gboolean present;
+        gchar *status;
+        gchar *markup;
+
+        gtk_tree_model_get (model, iter,
+                            MDU_HOST_DISCOVERY_COLUMN_NAME, &name,
+                            MDU_HOST_DISCOVERY_COLUMN_HOST_NAME, &host_name,
+                            MDU_HOST_DISCOVERY_COLUMN_ADDRESS, &address,
+                            MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, &last_seen,
+                            MDU_HOST_DISCOVERY_COLUMN_PRESENT, &present,
+                            -1);
+
+        if (present)
+                /* Translators: Shown for a discovered host that is currently on the network */
+                status = g_strdup (_("Online"));
+        else
+                status = format_last_seen (last_seen);
+
+        if (address != NULL)
+                markup = g_markup_printf_escaped ("<b>%s</b>\n"
+                                                  "<small>%s (%s) – %s</small>",
+                                                  name, host_name, address, status);
+        else
+                markup = g_markup_printf_escaped ("<b>%s</b>\n"
+                                                  "<small>%s – %s</small>",
+                                                  name, host_name, status);
+
+        g_object_set (renderer,
+                      "markup", markup,
+                      "sensitive", present,
+                      NULL);
+
+        g_free (markup);
+        g_free (status);
+        g_free (name);
+        g_free (host_name);
+        g_free (address);
+}
+
+static void
+on_host_row_activated (GtkTreeView       *tree_view,
+                       GtkTreePath       *path,
+                       GtkTreeViewColumn *column,
+                       gpointer           user_data)
+{
+        GtkDialog *host_dialog = GTK_DIALOG (user_data);
+
+        gtk_dialog_response (host_dialog, GTK_RESPONSE_OK);
+}
+
+static void
+on_host_selection_changed (GtkTreeSelection *selection,
+                           gpointer          user_data)
+{
+        GtkDialog *host_dialog = GTK_DIALOG (user_data);
+
+        gtk_dialog_set_response_sensitive (host_dialog,
+                                           GTK_RESPONSE_OK,
+                                           gtk_tree_selection_get_selected (selection, NULL, NULL));
+}
+
 static void
 on_dns_sd_clicked (GtkButton *button,
                    gpointer   user_data)
 {
         MduConnectToServerDialog *dialog = MDU_CONNECT_TO_SERVER_DIALOG (user_data);
-        GtkWidget *service_dialog;
+        GtkWidget *host_dialog;
+        GtkWidget *scrolled_window;
+        GtkWidget *tree_view;
+        GtkTreeModel *filter_model;
+        GtkTreeModel *sort_model;
+        GtkTreeViewColumn *column;
+        GtkCellRenderer *renderer;
+        GtkTreeSelection *selection;
+        GtkTreeIter iter;
         gint response;
 
-        service_dialog = aui_service_dialog_new (_("Choose Server"),
-                                                 gtk_window_get_transient_for (GTK_WINDOW (dialog)),
-                                                 GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
-                                                 GTK_STOCK_OK, GTK_RESPONSE_OK,
+        host_dialog = gtk_dialog_new_with_buttons (_("Choose Server"),
+                                                   GTK_WINDOW (dialog),
+                                                   GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+                                                   GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+                                                   GTK_STOCK_OK, GTK_RESPONSE_OK,
+                                                   NULL);
+        gtk_container_set_border_width (GTK_CONTAINER (host_dialog), 6);
+        gtk_window_set_default_size (GTK_WINDOW (host_dialog), 400, 300);
+
+        /* The model is kept up to date in the background by the discovery
+         * service (see mdu_connect_to_server_dialog_constructed()) so it is
+         * populated right away and keeps updating while the dialog is open
+         */
+        filter_model = gtk_tree_model_filter_new (mdu_host_discovery_get_model (dialog->priv->discovery), NULL);
+        gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter_model),
+                                                host_visible_func,
+                                                NULL,
+                                                NULL);
+        sort_model = gtk_tree_model_sort_new_with_model (filter_model);
+        gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (sort_model),
+                                                 host_compare_func,
+                                                 NULL,
                                                  NULL);
+        gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                              GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID,
+                                              GTK_SORT_ASCENDING);
+
+        tree_view = gtk_tree_view_new_with_model (sort_model);
+        gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (tree_view), FALSE);
+
+        column = gtk_tree_view_column_new ();
+        renderer = gtk_cell_renderer_pixbuf_new ();
+        g_object_set (renderer,
+                      "icon-name", "network-server",
+                      "stock-size", GTK_ICON_SIZE_DND,
+                      NULL);
+        gtk_tree_view_column_pack_start (column, renderer, FALSE);
+        renderer = gtk_cell_renderer_text_new ();
+        gtk_tree_view_column_pack_start (column, renderer, TRUE);
+        gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (column),
+                                            renderer,
+                                            host_text_data_func,
+                                            NULL,
+                                            NULL);
+        gtk_tree_view_append_column (GTK_TREE_VIEW (tree_view), column);
+
+        scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+        gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                        GTK_POLICY_NEVER,
+                                        GTK_POLICY_AUTOMATIC);
+        gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scrolled_window),
+                                             GTK_SHADOW_IN);
+        gtk_container_add (GTK_CONTAINER (scrolled_window), tree_view);
+        gtk_box_pack_start (GTK_BOX (gtk_dialog_get_content_area (GTK_DIALOG (host_dialog))),
+                            scrolled_window,
+                            TRUE,
+                            TRUE,
+                            0);
 
-        aui_service_dialog_set_browse_service_types (AUI_SERVICE_DIALOG (service_dialog),
-                                                     "_udisks-ssh._tcp",
-                                                     NULL);
-        gtk_widget_show_all (service_dialog);
-        response = gtk_dialog_run (GTK_DIALOG (service_dialog));
-
-        if (response == GTK_RESPONSE_OK) {
-                const gchar *hostname;
-                hostname = aui_service_dialog_get_host_name (AUI_SERVICE_DIALOG (service_dialog));
-                gtk_entry_set_text (GTK_ENTRY (dialog->priv->hostname_entry), hostname);
+        selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (tree_view));
+        gtk_tree_selection_set_mode (selection, GTK_SELECTION_BROWSE);
+        g_signal_connect (selection,
+                          "changed",
+                          G_CALLBACK (on_host_selection_changed),
+                          host_dialog);
+        g_signal_connect (tree_view,
+                          "row-activated",
+                          G_CALLBACK (on_host_row_activated),
+                          host_dialog);
+        gtk_dialog_set_default_response (GTK_DIALOG (host_dialog), GTK_RESPONSE_OK);
+        on_host_selection_changed (selection, host_dialog);
+
+        gtk_widget_show_all (host_dialog);
+        response = gtk_dialog_run (GTK_DIALOG (host_dialog));
+
+        if (response == GTK_RESPONSE_OK && gtk_tree_selection_get_selected (selection, NULL, &iter)) {
+                gchar *host_name;
+
+                gtk_tree_model_get (sort_model, &iter,
+                                    MDU_HOST_DISCOVERY_COLUMN_HOST_NAME, &host_name,
+                                    -1);
+                gtk_entry_set_text (GTK_ENTRY (dialog->priv->hostname_entry), host_name);
+                g_free (host_name);
         }
 
-        gtk_widget_destroy (service_dialog);
+        gtk_widget_destroy (host_dialog);
+        g_object_unref (sort_model);
+        g_object_unref (filter_model);
 }
 
 /* ---------------------------------------------------------------------------------------------------- */
@@ -212,6 +472,9 @@ mdu_connect_to_server_dialog_constructed (GObject *object)
 
         gtk_window_set_title (GTK_WINDOW (dialog), _("Connect to Server"));
 
+        /* Usually already running in the background, see mdu-shell.c */
+        dialog->priv->discovery = mdu_host_discovery_get_default ();
+
         gtk_dialog_add_button (GTK_DIALOG (dialog), GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL);
         button = gtk_dialog_add_button (GTK_DIALOG (dialog),
                                         GTK_STOCK_CONNECT,
@@ -305,6 +568,17 @@ mdu_connect_to_server_dialog_constructed (GObject *object)
 
         row++;
 
+        button = gtk_check_button_new_with_mnemonic (_("_Compress traffic"));
+        gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (button), TRUE);
+        gtk_table_attach (GTK_TABLE (table), button, 1, 2, row, row + 1,
+                          GTK_EXPAND | GTK_FILL, GTK_EXPAND | GTK_FILL, 2, 2);
+        dialog->priv->compress_check_button = button;
+        /* Translators: This is the tooltip for the "Compress traffic" check button
+         */
+        gtk_widget_set_tooltip_text (button, _("Speeds up connecting over slow links at the cost of some CPU time. Turn off for fast local networks."));
+
+        row++;
+
         gtk_dialog_set_default_response (GTK_DIALOG (dialog), GTK_RESPONSE_OK);
         gtk_dialog_set_response_sensitive (GTK_DIALOG (dialog),
                                            GTK_RESPONSE_OK,
@@ -54,6 +54,7 @@ GType       mdu_connect_to_server_dialog_get_type      (void) G_GNUC_CONST;
 GtkWidget*  mdu_connect_to_server_dialog_new           (GtkWindow                 *parent);
 gchar      *mdu_connect_to_server_dialog_get_user_name (MduConnectToServerDialog  *dialog);
 gchar      *mdu_connect_to_server_dialog_get_address   (MduConnectToServerDialog  *dialog);
+gboolean    mdu_connect_to_server_dialog_get_compress  (MduConnectToServerDialog  *dialog);
 
 G_END_DECLS
 
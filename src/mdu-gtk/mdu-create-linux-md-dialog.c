@@ -30,6 +30,7 @@
 #include "mdu-create-linux-md-dialog.h"
 #include "mdu-size-widget.h"
 #include "mdu-disk-selection-widget.h"
+#include "mdu-drive-benchmark-dialog.h"
 
 struct MduCreateLinuxMdDialogPrivate
 {
@@ -59,6 +60,11 @@ struct MduCreateLinuxMdDialogPrivate
         guint num_disks_needed;
         guint stripe_size;
 
+        /* set once the user picks a stripe size; until then we follow the
+         * block size sweep of the selected disks, if any
+         */
+        gboolean stripe_size_chosen;
+        gboolean suggesting_stripe_size;
 };
 
 enum
@@ -434,9 +440,62 @@ on_stripe_size_combo_box_changed (GtkWidget *combo_box,
                 break;
         }
 
+        if (!dialog->priv->suggesting_stripe_size)
+                dialog->priv->stripe_size_chosen = TRUE;
+
         update (dialog);
 }
 
+static void
+suggest_stripe_size (MduCreateLinuxMdDialog *dialog,
+                     gint                    index)
+{
+        dialog->priv->suggesting_stripe_size = TRUE;
+        gtk_combo_box_set_active (GTK_COMBO_BOX (dialog->priv->stripe_size_combo_box), index);
+        dialog->priv->suggesting_stripe_size = FALSE;
+}
+
+/* Suggests the smallest of the optimal block sizes of the selected disks as
+ * the stripe size; a smaller chunk would split requests the slowest disk
+ * only handles well when they are at least that big.
+ */
+static void
+suggest_stripe_size_from_benchmarks (MduCreateLinuxMdDialog *dialog)
+{
+        GPtrArray *selected_disks;
+        guint optimal_block_size;
+        guint block_size;
+        gint index;
+        guint n;
+
+        if (dialog->priv->stripe_size_chosen)
+                goto out;
+
+        optimal_block_size = 0;
+        selected_disks = mdu_disk_selection_widget_get_selected_drives (MDU_DISK_SELECTION_WIDGET (dialog->priv->disk_selection_widget));
+        for (n = 0; n < selected_disks->len; n++) {
+                block_size = mdu_drive_benchmark_dialog_get_optimal_block_size (MDU_PRESENTABLE (selected_disks->pdata[n]));
+                if (block_size > 0 && (optimal_block_size == 0 || block_size < optimal_block_size))
+                        optimal_block_size = block_size;
+        }
+        g_ptr_array_unref (selected_disks);
+
+        if (optimal_block_size == 0) {
+                gtk_widget_set_tooltip_text (dialog->priv->stripe_size_combo_box, NULL);
+                goto out;
+        }
+
+        /* keep in sync with where combo box is constructed in constructed() - entry N is 4 KiB << N */
+        for (index = 0; index < 8 && (4096U << (index + 1)) <= optimal_block_size; index++)
+                ;
+        suggest_stripe_size (dialog, index);
+        gtk_widget_set_tooltip_text (dialog->priv->stripe_size_combo_box,
+                                     _("Suggested by the block size benchmark of the selected disks"));
+
+ out:
+        ;
+}
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 static void
@@ -476,6 +535,7 @@ on_disk_selection_widget_changed (MduDiskSelectionWidget *widget,
                                   gpointer                user_data)
 {
         MduCreateLinuxMdDialog *dialog = MDU_CREATE_LINUX_MD_DIALOG (user_data);
+        suggest_stripe_size_from_benchmarks (dialog);
         update (dialog);
 }
 
@@ -737,7 +797,7 @@ mdu_create_linux_md_dialog_constructed (GObject *object)
         /* Calls on_level_combo_box_changed() which calls update() */
         gtk_combo_box_set_active (GTK_COMBO_BOX (dialog->priv->level_combo_box), 0);
         /* keep in sync with "..stripe_size = 512 * 1024;" above */
-        gtk_combo_box_set_active (GTK_COMBO_BOX (dialog->priv->stripe_size_combo_box), 7);
+        suggest_stripe_size (dialog, 7);
 
         /* select a sane size for the dialog and allow resizing */
         gtk_widget_set_size_request (GTK_WIDGET (dialog), 500, 550);
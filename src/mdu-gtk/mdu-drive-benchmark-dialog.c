@@ -23,10 +23,12 @@
 #include <glib/gi18n-lib.h>
 
 #include <glib/gstdio.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <unistd.h>
 #include <math.h>
 #include <dbus/dbus-glib.h>
 
@@ -40,12 +42,15 @@
 
 /* gah, omgwtf, dbus-glib - this will be much nicer when we switch to GVariant */
 
-/* For now we store the benchmark data in $HOME/.cache - once DKD
- * grows a message subsystem (e.g. a database storing time-stamped
- * messages/events on a per device basis) we can switch to using
- * that.
+/* Every run is appended to the drive's MduBenchmarkHistory in
+ * $HOME/.cache - once DKD grows a message subsystem (e.g. a database
+ * storing time-stamped messages/events on a per device basis) we can
+ * switch to using that.
  */
 
+/* same layout as MduBenchmarkSample so the points can be passed to
+ * mdu_benchmark_history_append_run() as is
+ */
 typedef struct {
         guint64 offset;
         gdouble value;
@@ -58,48 +63,18 @@ typedef struct {
         GArray *read_transfer_rate_samples;
         GArray *write_transfer_rate_samples;
         GArray *access_time_samples;
-} BenchmarkData;
 
-static void
-benchmark_get_max_min_avg (GArray *array,
-                           gdouble *out_max,
-                           gdouble *out_min,
-                           gdouble *out_avg)
-{
-        guint n;
-        gdouble max;
-        gdouble min;
-        gdouble avg;
-        gdouble sum;
-
-        if (array->len == 0) {
-                max = 0;
-                min = 0;
-                avg = 0;
-                goto out;
-        }
-        max = -G_MAXDOUBLE;
-        min = G_MAXDOUBLE;
-        sum = 0;
+        /* random reads at different queue depths, see MDU_BENCHMARK_MODE_RANDOM */
+        GArray *iops_results;
 
-        for (n = 0; n < array->len; n++) {
-                BenchmarkPoint *point = &g_array_index (array, BenchmarkPoint, n);
-                if (point->value > max)
-                        max = point->value;
-                if (point->value < min)
-                        min = point->value;
-                sum += point->value;
-        }
-        avg = sum / array->len;
+        /* read rate for each request size, see MDU_BENCHMARK_MODE_SWEEP */
+        GArray *sweep_points;
+        /* the request size picked from @sweep_points or 0 */
+        guint optimal_block_size;
+} BenchmarkData;
 
- out:
-        if (out_max != NULL)
-                *out_max = max;
-        if (out_min != NULL)
-                *out_min = min;
-        if (out_avg != NULL)
-                *out_avg = avg;
-}
+/* keep in sync with the queue depths used in mdu-benchmark.c */
+static const guint iops_queue_depths[] = {1, 4, 32};
 
 static void
 benchmark_data_free (BenchmarkData *data)
@@ -107,9 +82,61 @@ benchmark_data_free (BenchmarkData *data)
         g_array_unref (data->read_transfer_rate_samples);
         g_array_unref (data->write_transfer_rate_samples);
         g_array_unref (data->access_time_samples);
+        g_array_unref (data->iops_results);
+        g_array_unref (data->sweep_points);
         g_free (data);
 }
 
+/* Carries over the results @data doesn't have from @previous. This way
+ * running the random I/O benchmark or the block size sweep doesn't
+ * throw away the transfer rate results and vice versa.
+ */
+static void
+benchmark_data_merge (BenchmarkData *data,
+                      BenchmarkData *previous)
+{
+        GArray *tmp;
+
+        if (data->read_transfer_rate_samples->len == 0 && data->access_time_samples->len == 0) {
+                tmp = data->read_transfer_rate_samples;
+                data->read_transfer_rate_samples = previous->read_transfer_rate_samples;
+                previous->read_transfer_rate_samples = tmp;
+                tmp = data->write_transfer_rate_samples;
+                data->write_transfer_rate_samples = previous->write_transfer_rate_samples;
+                previous->write_transfer_rate_samples = tmp;
+                tmp = data->access_time_samples;
+                data->access_time_samples = previous->access_time_samples;
+                previous->access_time_samples = tmp;
+        }
+
+        if (data->iops_results->len == 0) {
+                tmp = data->iops_results;
+                data->iops_results = previous->iops_results;
+                previous->iops_results = tmp;
+        }
+
+        if (data->sweep_points->len == 0) {
+                tmp = data->sweep_points;
+                data->sweep_points = previous->sweep_points;
+                previous->sweep_points = tmp;
+                data->optimal_block_size = previous->optimal_block_size;
+        }
+}
+
+static const MduBenchmarkIopsResult *
+benchmark_data_get_iops_result (BenchmarkData *data,
+                                guint          queue_depth)
+{
+        guint n;
+
+        for (n = 0; n < data->iops_results->len; n++) {
+                MduBenchmarkIopsResult *result = &g_array_index (data->iops_results, MduBenchmarkIopsResult, n);
+                if (result->queue_depth == queue_depth)
+                        return result;
+        }
+        return NULL;
+}
+
 G_GNUC_UNUSED static void
 benchmark_data_print (BenchmarkData *data)
 {
@@ -198,6 +225,8 @@ benchmark_data_from_dbus (MduDevice    *device,
                                                        FALSE,
                                                        sizeof (BenchmarkPoint),
                                                        access_time_results->len);
+        data->iops_results = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkIopsResult));
+        data->sweep_points = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSweepPoint));
 
         benchmark_convert (read_transfer_rate_results,
                            data->read_transfer_rate_samples);
@@ -209,249 +238,182 @@ benchmark_data_from_dbus (MduDevice    *device,
         return data;
 }
 
-static BenchmarkData *
-benchmark_data_load (MduDevice   *device,
-                     GError     **error)
+static void
+benchmark_copy_samples (GArray *in,
+                        GArray *out)
 {
-        BenchmarkData *data;
-        gchar *filename;
-        gchar *s;
-        gchar *s2;
-        gchar *contents;
-        gchar **lines;
         guint n;
 
-        contents = NULL;
-        lines = NULL;
+        for (n = 0; n < in->len; n++) {
+                MduBenchmarkSample *sample = &g_array_index (in, MduBenchmarkSample, n);
+                BenchmarkPoint point;
+
+                point.offset = sample->offset;
+                point.value = sample->value;
+                g_array_append_val (out, point);
+        }
+}
+
+static BenchmarkData *
+benchmark_data_from_benchmark (MduBenchmark *benchmark)
+{
+        BenchmarkData *data;
 
         data = g_new0 (BenchmarkData, 1);
         data->time_collected = time (NULL);
-        data->disk_size = mdu_device_get_size (device);
-        data->read_transfer_rate_samples = g_array_new (FALSE,
-                                                        FALSE,
-                                                        sizeof (BenchmarkPoint));
-        data->write_transfer_rate_samples = g_array_new (FALSE,
-                                                         FALSE,
-                                                         sizeof (BenchmarkPoint));
-        data->access_time_samples = g_array_new (FALSE,
-                                                 FALSE,
-                                                 sizeof (BenchmarkPoint));
-
-
-        s = g_strdup_printf ("%s/mate-disk-utility/drive-benchmark",
-                             g_get_user_cache_dir ());
-        s2 = g_strdup_printf ("%s-%s-%s-%s",
-                              mdu_device_drive_get_vendor (device),
-                              mdu_device_drive_get_model (device),
-                              mdu_device_drive_get_revision (device),
-                              mdu_device_drive_get_serial (device));
-        filename = g_strdup_printf ("%s/%s",
-                                    s, s2);
-        g_free (s);
-        g_free (s2);
-
-        if (!g_file_get_contents (filename,
-                                  &contents,
-                                  NULL,
-                                  error)) {
-                benchmark_data_free (data);
-                data = NULL;
-                goto out;
-        }
-
-        lines = g_strsplit (contents, "\n", 0);
-        for (n = 0; lines != NULL && lines[n] != NULL; n++) {
-                const gchar *line = lines[n];
-                gchar **samples;
-                guint m;
-
-                if (sscanf (line, "time_collected=%" G_GUINT64_FORMAT,
-                            &(data->time_collected)) == 1) {
-                        ;
-                } else if (sscanf (line, "disk_size=%" G_GUINT64_FORMAT,
-                                   &(data->disk_size)) == 1) {
-                        ;
-                } else if (g_str_has_prefix (line, "read_transfer_rate_samples=")) {
-                        samples = g_strsplit (line + sizeof "read_transfer_rate_samples=" - 1, ":", 0);
-                        for (m = 0; samples != NULL && samples[m] != NULL; m++) {
-                                const gchar *sample = samples[m];
-                                BenchmarkPoint point;
-
-                                if (sscanf (sample, "%" G_GUINT64_FORMAT ";%lf",
-                                            &(point.offset),
-                                            &(point.value)) != 2) {
-                                        g_set_error (error,
-                                                     MDU_ERROR,
-                                                     MDU_ERROR_FAILED,
-                                                     "Bogus read_transfer_rate sample %d `%s'",
-                                                     m,
-                                                     sample);
-                                        benchmark_data_free (data);
-                                        data = NULL;
-                                        goto out;
-                                }
-                                g_array_append_val (data->read_transfer_rate_samples, point);
-                        }
-                        g_strfreev (samples);
-
-                } else if (g_str_has_prefix (line, "write_transfer_rate_samples=")) {
-                        samples = g_strsplit (line + sizeof "write_transfer_rate_samples=" - 1, ":", 0);
-                        for (m = 0; samples != NULL && samples[m] != NULL; m++) {
-                                const gchar *sample = samples[m];
-                                BenchmarkPoint point;
-
-                                if (sscanf (sample, "%" G_GUINT64_FORMAT ";%lf",
-                                            &(point.offset),
-                                            &(point.value)) != 2) {
-                                        g_set_error (error,
-                                                     MDU_ERROR,
-                                                     MDU_ERROR_FAILED,
-                                                     "Bogus write_transfer_rate sample %d `%s'",
-                                                     m,
-                                                     sample);
-                                        benchmark_data_free (data);
-                                        data = NULL;
-                                        goto out;
-                                }
-                                g_array_append_val (data->write_transfer_rate_samples, point);
-                        }
-                        g_strfreev (samples);
-
-                } else if (g_str_has_prefix (line, "access_time_samples=")) {
-                        samples = g_strsplit (line + sizeof "access_time_samples=" - 1, ":", 0);
-                        for (m = 0; samples != NULL && samples[m] != NULL; m++) {
-                                const gchar *sample = samples[m];
-                                BenchmarkPoint point;
-
-                                if (sscanf (sample, "%" G_GUINT64_FORMAT ";%lf",
-                                            &(point.offset),
-                                            &(point.value)) != 2) {
-                                        g_set_error (error,
-                                                     MDU_ERROR,
-                                                     MDU_ERROR_FAILED,
-                                                     "Bogus access_time sample %d `%s'",
-                                                     m,
-                                                     sample);
-                                        benchmark_data_free (data);
-                                        data = NULL;
-                                        goto out;
-                                }
-                                g_array_append_val (data->access_time_samples, point);
-                        }
-                        g_strfreev (samples);
-                } else if (strlen (line) > 0) {
-                        g_set_error (error,
-                                     MDU_ERROR,
-                                     MDU_ERROR_FAILED,
-                                     "Unable to parse line `%s'", line);
-                        benchmark_data_free (data);
-                        data = NULL;
-                        goto out;
-                }
-        }
+        data->disk_size = mdu_benchmark_get_size (benchmark);
+        data->read_transfer_rate_samples = g_array_new (FALSE, FALSE, sizeof (BenchmarkPoint));
+        data->write_transfer_rate_samples = g_array_new (FALSE, FALSE, sizeof (BenchmarkPoint));
+        data->access_time_samples = g_array_new (FALSE, FALSE, sizeof (BenchmarkPoint));
+        data->iops_results = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkIopsResult));
+        data->sweep_points = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSweepPoint));
+
+        benchmark_copy_samples (mdu_benchmark_get_read_transfer_rate_samples (benchmark),
+                                data->read_transfer_rate_samples);
+        benchmark_copy_samples (mdu_benchmark_get_write_transfer_rate_samples (benchmark),
+                                data->write_transfer_rate_samples);
+        benchmark_copy_samples (mdu_benchmark_get_access_time_samples (benchmark),
+                                data->access_time_samples);
+        g_array_append_vals (data->iops_results,
+                             mdu_benchmark_get_iops_results (benchmark)->data,
+                             mdu_benchmark_get_iops_results (benchmark)->len);
+        g_array_append_vals (data->sweep_points,
+                             mdu_benchmark_get_sweep_results (benchmark)->data,
+                             mdu_benchmark_get_sweep_results (benchmark)->len);
+        data->optimal_block_size = mdu_benchmark_sweep_get_optimal_block_size (data->sweep_points);
 
- out:
-        g_free (filename);
-        g_free (contents);
-        g_strfreev (lines);
         return data;
 }
 
-static gboolean
-benchmark_data_save (BenchmarkData  *data,
-                     MduDevice      *device,
-                     GError        **error)
+static MduBenchmarkHistory *
+benchmark_history_open (MduDevice  *device,
+                        GError    **error)
+{
+        return mdu_benchmark_history_new_for_drive (mdu_device_drive_get_vendor (device),
+                                                    mdu_device_drive_get_model (device),
+                                                    mdu_device_drive_get_serial (device),
+                                                    mdu_device_drive_get_wwn (device),
+                                                    error);
+}
+
+static void
+benchmark_copy_history_samples (const MduBenchmarkSample *samples,
+                                guint                     num_samples,
+                                GArray                   *out)
 {
-        gboolean ret;
-        gchar *filename;
-        GString *str;
-        gchar *s;
-        gchar *s2;
         guint n;
 
-        str = NULL;
-        filename = NULL;
-        ret = FALSE;
+        for (n = 0; n < num_samples; n++) {
+                BenchmarkPoint point;
 
-        s = g_strdup_printf ("%s/mate-disk-utility/drive-benchmark",
-                             g_get_user_cache_dir ());
-        if (g_mkdir_with_parents (s, 0755) != 0) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             "Error creating directory %s: %m",
-                             s);
-                g_free (s);
-                goto out;
+                point.offset = samples[n].offset;
+                point.value = samples[n].value;
+                g_array_append_val (out, point);
         }
+}
 
-        s2 = g_strdup_printf ("%s-%s-%s-%s",
-                              mdu_device_drive_get_vendor (device),
-                              mdu_device_drive_get_model (device),
-                              mdu_device_drive_get_revision (device),
-                              mdu_device_drive_get_serial (device));
-        filename = g_strdup_printf ("%s/%s",
-                                    s, s2);
-        g_free (s);
-        g_free (s2);
-
-        str = g_string_new (NULL);
-        g_string_append_printf (str, "time_collected=%" G_GUINT64_FORMAT "\n", data->time_collected);
-        g_string_append_printf (str, "disk_size=%" G_GUINT64_FORMAT "\n", data->disk_size);
+/* Returns the index of the newest run in @history with transfer rate
+ * results or -1 if there is none.
+ */
+static gint
+benchmark_history_find_transfer_rate_run (MduBenchmarkHistory *history)
+{
+        MduBenchmarkHistoryRun run;
+        gint n;
 
-        g_string_append (str, "read_transfer_rate_samples=");
-        for (n = 0; n < data->read_transfer_rate_samples->len; n++) {
-                BenchmarkPoint *point = &g_array_index (data->read_transfer_rate_samples, BenchmarkPoint, n);
-                if (n > 0)
-                        g_string_append_c (str, ':');
-                g_string_append_printf (str,
-                                        "%" G_GUINT64_FORMAT ";%f",
-                                        point->offset,
-                                        point->value);
+        for (n = mdu_benchmark_history_get_num_runs (history) - 1; n >= 0; n--) {
+                mdu_benchmark_history_get_run (history, n, &run);
+                if (run.num_read_samples > 0 || run.num_access_samples > 0)
+                        return n;
         }
-        g_string_append_c (str, '\n');
+        return -1;
+}
 
-        g_string_append (str, "write_transfer_rate_samples=");
-        for (n = 0; n < data->write_transfer_rate_samples->len; n++) {
-                BenchmarkPoint *point = &g_array_index (data->write_transfer_rate_samples, BenchmarkPoint, n);
-                if (n > 0)
-                        g_string_append_c (str, ':');
-                g_string_append_printf (str,
-                                        "%" G_GUINT64_FORMAT ";%f",
-                                        point->offset,
-                                        point->value);
-        }
-        g_string_append_c (str, '\n');
+/* Like benchmark_data_merge() the newest results of each kind are
+ * shown, even if they come from different runs.
+ */
+static BenchmarkData *
+benchmark_data_from_history (MduBenchmarkHistory *history)
+{
+        BenchmarkData *data;
+        MduBenchmarkHistoryRun run;
+        gboolean have_iops;
+        gboolean have_sweep;
+        gint transfer_rate_index;
+        gint n;
 
-        g_string_append (str, "access_time_samples=");
-        for (n = 0; n < data->access_time_samples->len; n++) {
-                BenchmarkPoint *point = &g_array_index (data->access_time_samples, BenchmarkPoint, n);
-                if (n > 0)
-                        g_string_append_c (str, ':');
-                g_string_append_printf (str,
-                                        "%" G_GUINT64_FORMAT ";%f",
-                                        point->offset,
-                                        point->value);
-        }
-        g_string_append_c (str, '\n');
-
-        if (!g_file_set_contents (filename,
-                                  str->str,
-                                  -1,
-                                  error))
+        data = NULL;
+
+        n = mdu_benchmark_history_get_num_runs (history) - 1;
+        if (n < 0)
                 goto out;
 
-        ret = TRUE;
+        mdu_benchmark_history_get_run (history, n, &run);
+
+        data = g_new0 (BenchmarkData, 1);
+        data->time_collected = run.time_collected;
+        data->disk_size = run.disk_size;
+        data->read_transfer_rate_samples = g_array_new (FALSE, FALSE, sizeof (BenchmarkPoint));
+        data->write_transfer_rate_samples = g_array_new (FALSE, FALSE, sizeof (BenchmarkPoint));
+        data->access_time_samples = g_array_new (FALSE, FALSE, sizeof (BenchmarkPoint));
+        data->iops_results = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkIopsResult));
+        data->sweep_points = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSweepPoint));
+
+        transfer_rate_index = benchmark_history_find_transfer_rate_run (history);
+        if (transfer_rate_index >= 0) {
+                mdu_benchmark_history_get_run (history, transfer_rate_index, &run);
+                /* the graph is scaled to the size of the device at the time */
+                data->disk_size = run.disk_size;
+                benchmark_copy_history_samples (run.read_samples, run.num_read_samples,
+                                                data->read_transfer_rate_samples);
+                benchmark_copy_history_samples (run.write_samples, run.num_write_samples,
+                                                data->write_transfer_rate_samples);
+                benchmark_copy_history_samples (run.access_samples, run.num_access_samples,
+                                                data->access_time_samples);
+        }
+
+        have_iops = FALSE;
+        have_sweep = FALSE;
+        for (; n >= 0 && !(have_iops && have_sweep); n--) {
+                mdu_benchmark_history_get_run (history, n, &run);
+                if (!have_iops && run.num_iops_results > 0) {
+                        g_array_append_vals (data->iops_results, run.iops_results, run.num_iops_results);
+                        have_iops = TRUE;
+                }
+                if (!have_sweep && run.num_sweep_points > 0) {
+                        g_array_append_vals (data->sweep_points, run.sweep_points, run.num_sweep_points);
+                        data->optimal_block_size = mdu_benchmark_sweep_get_optimal_block_size (data->sweep_points);
+                        have_sweep = TRUE;
+                }
+        }
 
  out:
-        g_free (filename);
-        if (str != NULL)
-                g_string_free (str, TRUE);
-        return ret;
+        return data;
 }
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+/* where things go in the transfer rate graph, see graph_compute_layout() */
+typedef struct {
+        gdouble width;
+        gdouble height;
+
+        /* the area with the curves */
+        gdouble gx;
+        gdouble gy;
+        gdouble gw;
+        gdouble gh;
+        gdouble x_marker_height;
+
+        guint num_y_markers;
+        gdouble speed_res;
+        gdouble max_visible_speed;
+        gdouble time_res;
+        gdouble max_visible_time;
+
+        guint64 disk_size;
+} GraphLayout;
+
 struct MduDriveBenchmarkDialogPrivate
 {
         gulong device_changed_signal_handler_id;
@@ -460,9 +422,29 @@ struct MduDriveBenchmarkDialogPrivate
         gboolean deleted;
 
         GtkWidget *drawing_area;
+        GtkWidget *sweep_drawing_area;
 
         BenchmarkData *benchmark_data;
 
+        /* samples of the running in-process benchmark, drawn as they come in */
+        BenchmarkData *live_data;
+
+        /* the transfer rate graph as last drawn or NULL if it needs to be
+         * redone; it's drawn on top of a copy of the static layer which has
+         * the markers, grid and earlier runs and only changes with the scales
+         */
+        cairo_surface_t *graph_surface;
+        cairo_surface_t *graph_static_surface;
+        GraphLayout graph_layout;
+
+        /* all runs of the drive or NULL if the history couldn't be opened */
+        MduBenchmarkHistory *history;
+        GtkWidget *show_previous_runs_check_button;
+
+        /* MduBenchmarkRegression of the shown transfer rate run vs. earlier ones */
+        GArray *regressions;
+        guint num_baseline_runs;
+
         /* elements for benchmark results */
         MduDetailsElement *read_min_element;
         MduDetailsElement *write_min_element;
@@ -472,8 +454,41 @@ struct MduDriveBenchmarkDialogPrivate
         MduDetailsElement *write_avg_element;
         MduDetailsElement *updated_element;
         MduDetailsElement *access_avg_element;
+        MduDetailsElement *access_percentiles_element;
+        MduDetailsElement *iops_elements[G_N_ELEMENTS (iops_queue_depths)];
+        MduDetailsElement *optimal_block_size_element;
+        MduDetailsElement *regressions_element;
+
+        /* settings for the in-process benchmark */
+        GtkWidget *settings_expander;
+        GtkWidget *queue_depth_spin_button;
+        GtkWidget *block_size_combo_box;
+        GtkWidget *num_workers_spin_button;
+
+        /* non-NULL while the in-process benchmark is running */
+        MduBenchmark *benchmark;
+        GCancellable *cancellable;
+};
+
+/* keep in sync with the entries in the block size combo box */
+static const guint block_sizes[] = {
+        4 * 1024,
+        64 * 1024,
+        128 * 1024,
+        512 * 1024,
+        1024 * 1024,
+        4 * 1024 * 1024,
+        8 * 1024 * 1024,
 };
 
+#define DEFAULT_BLOCK_SIZE_INDEX 4
+
+/* how many earlier read rate curves to draw when showing previous runs */
+#define MAX_PREVIOUS_RUNS 10
+
+/* see mdu_benchmark_history_find_regressions() */
+#define MIN_BASELINE_RUNS 3
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 G_DEFINE_TYPE (MduDriveBenchmarkDialog, mdu_drive_benchmark_dialog, MDU_TYPE_DIALOG)
@@ -484,8 +499,19 @@ static gdouble is_benchmarking (MduDriveBenchmarkDialog *dialog,
 static gboolean on_drawing_area_expose_event (GtkWidget      *widget,
                                               GdkEventExpose *event,
                                               gpointer        user_data);
+static gboolean on_sweep_drawing_area_expose_event (GtkWidget      *widget,
+                                                    GdkEventExpose *event,
+                                                    gpointer        user_data);
 
 static void update_dialog (MduDriveBenchmarkDialog *dialog);
+static void update_show_previous_runs (MduDriveBenchmarkDialog *dialog);
+static void update_regressions (MduDriveBenchmarkDialog *dialog);
+static void graph_invalidate_static (MduDriveBenchmarkDialog *dialog);
+static void on_benchmark_progress_changed (MduBenchmark *benchmark, gpointer user_data);
+static void on_benchmark_sample_added (MduBenchmark             *benchmark,
+                                       MduBenchmarkSampleKind    kind,
+                                       const MduBenchmarkSample *sample,
+                                       gpointer                  user_data);
 static void on_device_changed (MduDevice *device, gpointer user_data);
 static void on_device_job_changed (MduDevice *device, gpointer user_data);
 
@@ -500,6 +526,16 @@ mdu_drive_benchmark_dialog_finalize (GObject *object)
         if (dialog->priv->benchmark_data != NULL) {
                 benchmark_data_free (dialog->priv->benchmark_data);
         }
+        if (dialog->priv->live_data != NULL)
+                benchmark_data_free (dialog->priv->live_data);
+        if (dialog->priv->graph_surface != NULL)
+                cairo_surface_destroy (dialog->priv->graph_surface);
+        if (dialog->priv->graph_static_surface != NULL)
+                cairo_surface_destroy (dialog->priv->graph_static_surface);
+        if (dialog->priv->history != NULL)
+                g_object_unref (dialog->priv->history);
+        if (dialog->priv->regressions != NULL)
+                g_array_unref (dialog->priv->regressions);
 
         if (G_OBJECT_CLASS (mdu_drive_benchmark_dialog_parent_class)->finalize != NULL)
                 G_OBJECT_CLASS (mdu_drive_benchmark_dialog_parent_class)->finalize (object);
@@ -507,20 +543,21 @@ mdu_drive_benchmark_dialog_finalize (GObject *object)
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+/* takes ownership of @data; @run describes the same results and is appended to the history */
 static void
-benchmark_cb (MduDevice    *device,
-              GPtrArray    *read_transfer_rate_results,
-              GPtrArray    *write_transfer_rate_results,
-              GPtrArray    *access_time_results,
-              GError       *error,
-              gpointer      user_data)
+benchmark_finished (MduDriveBenchmarkDialog      *dialog,
+                    BenchmarkData                *data,
+                    const MduBenchmarkHistoryRun *run,
+                    GError                       *error)
 {
-        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+        MduDevice *device;
         GError *local_error;
-        GtkAllocation allocation;
+
+        device = mdu_dialog_get_device (MDU_DIALOG (dialog));
 
         if (error != NULL) {
-                if (!(error->domain == MDU_ERROR && error->code == MDU_ERROR_CANCELLED)) {
+                if (!(error->domain == MDU_ERROR && error->code == MDU_ERROR_CANCELLED) &&
+                    !dialog->priv->deleted) {
                         GtkWidget *error_dialog;
                         error_dialog = mdu_error_dialog_new_for_drive (GTK_WINDOW (dialog),
                                                                        device,
@@ -531,54 +568,343 @@ benchmark_cb (MduDevice    *device,
                         gtk_dialog_run (GTK_DIALOG (error_dialog));
                         gtk_widget_destroy (error_dialog);
                 }
-                g_error_free (error);
                 goto out;
         }
 
         if (dialog->priv->benchmark_data != NULL) {
+                benchmark_data_merge (data, dialog->priv->benchmark_data);
                 benchmark_data_free (dialog->priv->benchmark_data);
         }
-        dialog->priv->benchmark_data = benchmark_data_from_dbus (device,
-                                                                 read_transfer_rate_results,
-                                                                 write_transfer_rate_results,
-                                                                 access_time_results);
-        g_ptr_array_unref (read_transfer_rate_results);
-        g_ptr_array_unref (write_transfer_rate_results);
-        g_ptr_array_unref (access_time_results);
+        dialog->priv->benchmark_data = data;
 
         /*benchmark_data_print (dialog->priv->benchmark_data);*/
 
         local_error = NULL;
-        if (!benchmark_data_save (dialog->priv->benchmark_data, device, &local_error)) {
-                g_warning ("Error saving benchmark data: %s", local_error->message);
-                g_error_free (local_error);
+        if (dialog->priv->history == NULL ||
+            !mdu_benchmark_history_append_run (dialog->priv->history, run, &local_error)) {
+                g_warning ("Error saving benchmark data: %s",
+                           local_error != NULL ? local_error->message : "No history");
+                if (local_error != NULL)
+                        g_error_free (local_error);
         }
+        update_show_previous_runs (dialog);
+        update_regressions (dialog);
 
  out:
         if (!dialog->priv->deleted) {
                 update_dialog (dialog);
-                gtk_widget_get_allocation (dialog->priv->drawing_area, &allocation);
-                gtk_widget_queue_draw_area (dialog->priv->drawing_area,
-                                            0,
-                                            0,
-                                            allocation.width,
-                                            allocation.height);
+                graph_invalidate_static (dialog);
+                gtk_widget_queue_draw (dialog->priv->sweep_drawing_area);
+        }
+}
+
+static void
+benchmark_cb (MduDevice    *device,
+              GPtrArray    *read_transfer_rate_results,
+              GPtrArray    *write_transfer_rate_results,
+              GPtrArray    *access_time_results,
+              GError       *error,
+              gpointer      user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+
+        BenchmarkData *data;
+        MduBenchmarkHistoryRun run;
+
+        if (error != NULL) {
+                benchmark_finished (dialog, NULL, NULL, error);
+                g_error_free (error);
+                goto out;
+        }
+
+        data = benchmark_data_from_dbus (device,
+                                         read_transfer_rate_results,
+                                         write_transfer_rate_results,
+                                         access_time_results);
+
+        /* the daemon doesn't tell how it measured, hence queue_depth 0 */
+        memset (&run, 0, sizeof (MduBenchmarkHistoryRun));
+        run.time_collected = data->time_collected;
+        run.disk_size = data->disk_size;
+        run.mode = MDU_BENCHMARK_MODE_TRANSFER_RATE;
+        run.flags = data->write_transfer_rate_samples->len > 0 ? MDU_BENCHMARK_FLAGS_WRITE : MDU_BENCHMARK_FLAGS_NONE;
+        run.read_samples = (const MduBenchmarkSample *) data->read_transfer_rate_samples->data;
+        run.num_read_samples = data->read_transfer_rate_samples->len;
+        run.write_samples = (const MduBenchmarkSample *) data->write_transfer_rate_samples->data;
+        run.num_write_samples = data->write_transfer_rate_samples->len;
+        run.access_samples = (const MduBenchmarkSample *) data->access_time_samples->data;
+        run.num_access_samples = data->access_time_samples->len;
+
+        benchmark_finished (dialog, data, &run, NULL);
+        g_ptr_array_unref (read_transfer_rate_results);
+        g_ptr_array_unref (write_transfer_rate_results);
+        g_ptr_array_unref (access_time_results);
+
+ out:
+        g_object_unref (dialog);
+}
+
+static void
+benchmark_run_cb (GObject      *source_object,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+        MduBenchmark *benchmark = MDU_BENCHMARK (source_object);
+        MduBenchmarkHistoryRun run;
+        MduBenchmarkFlags flags;
+        GError *error;
+
+        g_signal_handlers_disconnect_by_func (benchmark, on_benchmark_progress_changed, dialog);
+        g_signal_handlers_disconnect_by_func (benchmark, on_benchmark_sample_added, dialog);
+        dialog->priv->benchmark = NULL;
+        if (dialog->priv->live_data != NULL) {
+                benchmark_data_free (dialog->priv->live_data);
+                dialog->priv->live_data = NULL;
+        }
+        g_object_unref (dialog->priv->cancellable);
+        dialog->priv->cancellable = NULL;
+
+        error = NULL;
+        if (!mdu_benchmark_run_finish (benchmark, res, &error)) {
+                benchmark_finished (dialog, NULL, NULL, error);
+                g_error_free (error);
+        } else {
+                flags = MDU_BENCHMARK_FLAGS_NONE;
+                if (mdu_benchmark_get_write_transfer_rate_samples (benchmark)->len > 0)
+                        flags |= MDU_BENCHMARK_FLAGS_WRITE;
+                mdu_benchmark_history_run_init_from_benchmark (&run, benchmark, flags);
+                benchmark_finished (dialog, benchmark_data_from_benchmark (benchmark), &run, NULL);
         }
+
+        g_object_unref (benchmark);
         g_object_unref (dialog);
 }
 
+/* Whether the benchmark can run in this process instead of in the daemon.
+ * This requires that the device is on this machine and that we have
+ * access to it, e.g. a loop device set up by the user or when running
+ * as root. Otherwise the daemon runs the benchmark after authorization.
+ */
+static gboolean
+can_benchmark_in_process (MduDriveBenchmarkDialog *dialog,
+                          gboolean                 do_write)
+{
+        MduDevice *device;
+        gboolean ret;
+
+        ret = FALSE;
+
+        if (mdu_pool_get_ssh_address (mdu_dialog_get_pool (MDU_DIALOG (dialog))) != NULL)
+                goto out;
+
+        device = mdu_dialog_get_device (MDU_DIALOG (dialog));
+        if (g_access (mdu_device_get_device_file (device), do_write ? R_OK | W_OK : R_OK) != 0)
+                goto out;
+
+        ret = TRUE;
+
+ out:
+        return ret;
+}
+
+/* Where a non-destructive write benchmark writes, see find_write_target() */
+typedef struct {
+        /* MduBenchmarkRegion for the unallocated space on the drive */
+        GArray *regions;
+
+        /* otherwise a directory on a filesystem of the drive and where that starts */
+        gchar *scratch_directory;
+        guint64 scratch_offset;
+} WriteTarget;
+
+static void
+write_target_free_contents (WriteTarget *target)
+{
+        g_array_unref (target->regions);
+        g_free (target->scratch_directory);
+}
+
+static void
+find_write_target_add_enclosed (MduPool        *pool,
+                                MduPresentable *presentable,
+                                gboolean        can_write_device,
+                                WriteTarget    *target)
+{
+        GList *enclosed;
+        GList *l;
+
+        enclosed = mdu_pool_get_enclosed_presentables (pool, presentable);
+        for (l = enclosed; l != NULL; l = l->next) {
+                MduPresentable *p = MDU_PRESENTABLE (l->data);
+                MduDevice *d;
+                const gchar *mount_path;
+
+                if (MDU_IS_VOLUME_HOLE (p)) {
+                        if (can_write_device) {
+                                MduBenchmarkRegion region;
+
+                                region.offset = mdu_presentable_get_offset (p);
+                                region.size = mdu_presentable_get_size (p);
+                                g_array_append_val (target->regions, region);
+                        }
+                } else if (MDU_IS_VOLUME (p)) {
+                        d = mdu_presentable_get_device (p);
+                        if (d != NULL) {
+                                mount_path = mdu_device_get_mount_path (d);
+                                if (target->scratch_directory == NULL &&
+                                    mdu_device_is_mounted (d) &&
+                                    !mdu_device_is_read_only (d) &&
+                                    mount_path != NULL &&
+                                    g_access (mount_path, W_OK) == 0) {
+                                        target->scratch_directory = g_strdup (mount_path);
+                                        target->scratch_offset = mdu_presentable_get_offset (p);
+                                }
+                                g_object_unref (d);
+                        }
+
+                        /* e.g. the logical partitions and holes in an extended partition */
+                        find_write_target_add_enclosed (pool, p, can_write_device, target);
+                }
+        }
+        g_list_foreach (enclosed, (GFunc) g_object_unref, NULL);
+        g_list_free (enclosed);
+}
+
+/* Finds somewhere to measure the write rate without touching any data:
+ * the unallocated space on the drive, as shown in the volume grid, or
+ * else a temporary file on a mounted filesystem of the drive. Free with
+ * write_target_free_contents().
+ */
+static gboolean
+find_write_target (MduDriveBenchmarkDialog *dialog,
+                   WriteTarget             *target)
+{
+        MduDevice *device;
+        gboolean can_write_device;
+
+        device = mdu_dialog_get_device (MDU_DIALOG (dialog));
+
+        target->regions = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkRegion));
+        target->scratch_directory = NULL;
+        target->scratch_offset = 0;
+
+        can_write_device = (g_access (mdu_device_get_device_file (device), R_OK | W_OK) == 0);
+        find_write_target_add_enclosed (mdu_dialog_get_pool (MDU_DIALOG (dialog)),
+                                        mdu_dialog_get_presentable (MDU_DIALOG (dialog)),
+                                        can_write_device,
+                                        target);
+
+        /* the raw drive tells more than a filesystem on it */
+        if (target->regions->len > 0) {
+                g_free (target->scratch_directory);
+                target->scratch_directory = NULL;
+        }
+
+        return target->regions->len > 0 || target->scratch_directory != NULL;
+}
+
+/* @write_target is only used with @do_write and means the benchmark must run in-process */
+static void
+start_benchmark (MduDriveBenchmarkDialog *dialog,
+                 MduBenchmarkMode         mode,
+                 gboolean                 do_write,
+                 const WriteTarget       *write_target)
+{
+        MduDevice *device;
+        const gchar *options[1] = {NULL};
+        gint block_size_index;
+
+        device = mdu_dialog_get_device (MDU_DIALOG (dialog));
+
+        if (write_target == NULL && !can_benchmark_in_process (dialog, do_write)) {
+                /* the daemon only knows how to measure the transfer rate */
+                g_warn_if_fail (mode == MDU_BENCHMARK_MODE_TRANSFER_RATE);
+                mdu_device_op_drive_benchmark (device,
+                                               do_write,
+                                               options,
+                                               benchmark_cb,
+                                               g_object_ref (dialog));
+                goto out;
+        }
+
+        g_warn_if_fail (dialog->priv->benchmark == NULL);
+
+        dialog->priv->benchmark = mdu_benchmark_new (mdu_device_get_device_file (device));
+        dialog->priv->cancellable = g_cancellable_new ();
+
+        mdu_benchmark_set_mode (dialog->priv->benchmark, mode);
+        mdu_benchmark_set_queue_depth (dialog->priv->benchmark,
+                                       gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (dialog->priv->queue_depth_spin_button)));
+        mdu_benchmark_set_num_workers (dialog->priv->benchmark,
+                                       gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (dialog->priv->num_workers_spin_button)));
+        block_size_index = gtk_combo_box_get_active (GTK_COMBO_BOX (dialog->priv->block_size_combo_box));
+        if (block_size_index < 0)
+                block_size_index = DEFAULT_BLOCK_SIZE_INDEX;
+        mdu_benchmark_set_block_size (dialog->priv->benchmark, block_sizes[block_size_index]);
+        if (write_target != NULL && write_target->scratch_directory != NULL) {
+                mdu_benchmark_set_scratch_directory (dialog->priv->benchmark,
+                                                     write_target->scratch_directory,
+                                                     write_target->scratch_offset);
+        } else if (write_target != NULL) {
+                mdu_benchmark_set_write_regions (dialog->priv->benchmark,
+                                                 (const MduBenchmarkRegion *) write_target->regions->data,
+                                                 write_target->regions->len);
+        }
+
+        g_signal_connect (dialog->priv->benchmark,
+                          "progress-changed",
+                          G_CALLBACK (on_benchmark_progress_changed),
+                          dialog);
+
+        /* draw the transfer rate graph as the samples come in */
+        if (mode == MDU_BENCHMARK_MODE_TRANSFER_RATE) {
+                dialog->priv->live_data = benchmark_data_from_benchmark (dialog->priv->benchmark);
+                dialog->priv->live_data->disk_size = mdu_device_get_size (device);
+                g_signal_connect (dialog->priv->benchmark,
+                                  "sample-added",
+                                  G_CALLBACK (on_benchmark_sample_added),
+                                  dialog);
+                graph_invalidate_static (dialog);
+        }
+
+        mdu_benchmark_run_async (dialog->priv->benchmark,
+                                 do_write ? MDU_BENCHMARK_FLAGS_WRITE : MDU_BENCHMARK_FLAGS_NONE,
+                                 dialog->priv->cancellable,
+                                 benchmark_run_cb,
+                                 g_object_ref (dialog));
+
+        update_dialog (dialog);
+
+ out:
+        ;
+}
+
 static void
 on_run_benchmark_clicked (MduButtonElement *button_element,
                           gpointer          user_data)
 {
         MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
-        const gchar *options[1] = {NULL};
 
-        mdu_device_op_drive_benchmark (mdu_dialog_get_device (MDU_DIALOG (dialog)),
-                                       FALSE,
-                                       options,
-                                       benchmark_cb,
-                                       g_object_ref (dialog));
+        start_benchmark (dialog, MDU_BENCHMARK_MODE_TRANSFER_RATE, FALSE, NULL);
+}
+
+static void
+on_run_random_benchmark_clicked (MduButtonElement *button_element,
+                                 gpointer          user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+
+        start_benchmark (dialog, MDU_BENCHMARK_MODE_RANDOM, FALSE, NULL);
+}
+
+static void
+on_run_sweep_benchmark_clicked (MduButtonElement *button_element,
+                                gpointer          user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+
+        start_benchmark (dialog, MDU_BENCHMARK_MODE_SWEEP, FALSE, NULL);
 }
 
 static void
@@ -586,7 +912,6 @@ on_run_write_benchmark_clicked (MduButtonElement *button_element,
                                 gpointer          user_data)
 {
         MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
-        const gchar *options[1] = {NULL};
         GtkWidget *confirmation_dialog;
         gint response;
 
@@ -600,27 +925,115 @@ on_run_write_benchmark_clicked (MduButtonElement *button_element,
         if (response != GTK_RESPONSE_OK)
                 goto out;
 
-        mdu_device_op_drive_benchmark (mdu_dialog_get_device (MDU_DIALOG (dialog)),
-                                       TRUE,
-                                       options,
-                                       benchmark_cb,
-                                       g_object_ref (dialog));
+        start_benchmark (dialog, MDU_BENCHMARK_MODE_TRANSFER_RATE, TRUE, NULL);
 
  out:
         gtk_widget_destroy (confirmation_dialog);
 }
 
-static gboolean
-on_delete_event (GtkWidget *widget,
-                 GdkEvent  *event,
-                 gpointer   user_data)
+static void
+on_run_non_destructive_write_benchmark_clicked (MduButtonElement *button_element,
+                                                gpointer          user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+        WriteTarget write_target;
+        GtkWidget *error_dialog;
+        GError *error;
+
+        if (!find_write_target (dialog, &write_target)) {
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_NOT_SUPPORTED,
+                                     _("There is no unallocated space and no writable filesystem on the drive"));
+                error_dialog = mdu_error_dialog_new_for_drive (GTK_WINDOW (dialog),
+                                                               mdu_dialog_get_device (MDU_DIALOG (dialog)),
+                                                               _("Error benchmarking drive"),
+                                                               error);
+                gtk_widget_show_all (error_dialog);
+                gtk_window_present (GTK_WINDOW (error_dialog));
+                gtk_dialog_run (GTK_DIALOG (error_dialog));
+                gtk_widget_destroy (error_dialog);
+                g_error_free (error);
+                goto out;
+        }
+
+        start_benchmark (dialog, MDU_BENCHMARK_MODE_TRANSFER_RATE, TRUE, &write_target);
+
+ out:
+        write_target_free_contents (&write_target);
+}
+
+static gboolean
+on_delete_event (GtkWidget *widget,
+                 GdkEvent  *event,
+                 gpointer   user_data)
 {
         MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
 
         dialog->priv->deleted = TRUE;
+
+        /* don't keep hammering the disk from a thread no-one can see */
+        if (dialog->priv->cancellable != NULL)
+                g_cancellable_cancel (dialog->priv->cancellable);
+
         return FALSE; /* propagate further */
 }
 
+static void
+on_show_previous_runs_toggled (GtkToggleButton *toggle_button,
+                               gpointer         user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+
+        graph_invalidate_static (dialog);
+}
+
+/* Only offer to show previous runs if there are any */
+static void
+update_show_previous_runs (MduDriveBenchmarkDialog *dialog)
+{
+        MduBenchmarkHistoryRun run;
+        gboolean have_previous;
+        gint current;
+        gint n;
+
+        have_previous = FALSE;
+        if (dialog->priv->history != NULL) {
+                current = benchmark_history_find_transfer_rate_run (dialog->priv->history);
+                for (n = current - 1; n >= 0 && !have_previous; n--) {
+                        mdu_benchmark_history_get_run (dialog->priv->history, n, &run);
+                        if (run.num_read_samples > 0)
+                                have_previous = TRUE;
+                }
+        }
+        gtk_widget_set_sensitive (dialog->priv->show_previous_runs_check_button, have_previous);
+}
+
+static void
+update_regressions (MduDriveBenchmarkDialog *dialog)
+{
+        gint current;
+
+        if (dialog->priv->regressions != NULL) {
+                g_array_unref (dialog->priv->regressions);
+                dialog->priv->regressions = NULL;
+        }
+        dialog->priv->num_baseline_runs = 0;
+
+        if (dialog->priv->history == NULL)
+                goto out;
+
+        current = benchmark_history_find_transfer_rate_run (dialog->priv->history);
+        if (current < 0)
+                goto out;
+
+        dialog->priv->regressions = mdu_benchmark_history_find_regressions (dialog->priv->history,
+                                                                            current,
+                                                                            &dialog->priv->num_baseline_runs);
+
+ out:
+        ;
+}
+
 static void
 cancel_job_cb (MduDevice  *device,
                GError     *error,
@@ -638,7 +1051,9 @@ on_updated_element_activated (MduDetailsElement    *element,
 {
         MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
 
-        if (is_benchmarking (dialog, NULL)) {
+        if (dialog->priv->cancellable != NULL) {
+                g_cancellable_cancel (dialog->priv->cancellable);
+        } else if (is_benchmarking (dialog, NULL)) {
                 mdu_device_op_cancel_job (mdu_dialog_get_device (MDU_DIALOG (dialog)),
                                           cancel_job_cb,
                                           dialog);
@@ -653,15 +1068,22 @@ mdu_drive_benchmark_dialog_constructed (GObject *object)
         GtkWidget *align;
         GtkWidget *vbox;
         GtkWidget *vbox2;
+        GtkWidget *hbox;
         GtkWidget *table;
         GError *error;
         GtkWidget *drawing_area;
         GPtrArray *elements;
         MduButtonElement *button_element;
         MduDetailsElement *element;
+        GtkWidget *expander;
+        GtkWidget *label;
+        GtkWidget *spin_button;
+        GtkWidget *combo_box;
+        GtkWidget *check_button;
         gchar *s;
         gchar *name;
         gchar *vpd_name;
+        guint n;
 
         dialog->priv->device_changed_signal_handler_id = g_signal_connect (mdu_dialog_get_device (MDU_DIALOG (dialog)),
                                                                            "changed",
@@ -701,9 +1123,12 @@ mdu_drive_benchmark_dialog_constructed (GObject *object)
 
         /* ---------------------------------------------------------------------------------------------------- */
 
+        hbox = gtk_hbox_new (FALSE, 12);
+        gtk_box_pack_start (GTK_BOX (vbox), hbox, TRUE, TRUE, 0);
+
         drawing_area = gtk_drawing_area_new ();
         dialog->priv->drawing_area = drawing_area;
-        gtk_box_pack_start (GTK_BOX (vbox), drawing_area, TRUE, TRUE, 0);
+        gtk_box_pack_start (GTK_BOX (hbox), drawing_area, TRUE, TRUE, 0);
 
         g_signal_connect (drawing_area,
                           "expose-event",
@@ -715,6 +1140,21 @@ mdu_drive_benchmark_dialog_constructed (GObject *object)
                                      400,
                                      300);
 
+        /* read rate vs. request size; only shown once there is a block size sweep */
+        drawing_area = gtk_drawing_area_new ();
+        dialog->priv->sweep_drawing_area = drawing_area;
+        gtk_box_pack_start (GTK_BOX (hbox), drawing_area, FALSE, TRUE, 0);
+        gtk_widget_set_no_show_all (drawing_area, TRUE);
+
+        g_signal_connect (drawing_area,
+                          "expose-event",
+                          G_CALLBACK (on_sweep_drawing_area_expose_event),
+                          dialog);
+
+        gtk_widget_set_size_request (drawing_area,
+                                     250,
+                                     300);
+
         /* ---------------------------------------------------------------------------------------------------- */
 
         align = gtk_alignment_new (0.5, 0.5, 1.0, 1.0);
@@ -724,6 +1164,16 @@ mdu_drive_benchmark_dialog_constructed (GObject *object)
         vbox2 = gtk_vbox_new (FALSE, 12);
         gtk_container_add (GTK_CONTAINER (align), vbox2);
 
+        check_button = gtk_check_button_new_with_mnemonic (_("Show _previous runs"));
+        gtk_widget_set_tooltip_text (check_button,
+                                     _("Also draw the read rate measured by earlier benchmarks of the drive"));
+        g_signal_connect (check_button,
+                          "toggled",
+                          G_CALLBACK (on_show_previous_runs_toggled),
+                          dialog);
+        gtk_box_pack_start (GTK_BOX (vbox2), check_button, FALSE, FALSE, 0);
+        dialog->priv->show_previous_runs_check_button = check_button;
+
         /* ---------------------------------------------------------------------------------------------------- */
 
         elements = g_ptr_array_new_with_free_func (g_object_unref);
@@ -766,6 +1216,29 @@ mdu_drive_benchmark_dialog_constructed (GObject *object)
         g_ptr_array_add (elements, element);
         dialog->priv->access_avg_element = element;
 
+        element = mdu_details_element_new (_("Access Time Percentiles:"), NULL, NULL);
+        g_ptr_array_add (elements, element);
+        dialog->priv->access_percentiles_element = element;
+
+        for (n = 0; n < G_N_ELEMENTS (iops_queue_depths); n++) {
+                /* Translators: Heading for the result of the random read benchmark.
+                 * %u is the number of requests in flight, e.g. 32
+                 */
+                s = g_strdup_printf (_("Random Reads (QD%u):"), iops_queue_depths[n]);
+                element = mdu_details_element_new (s, NULL, NULL);
+                g_free (s);
+                g_ptr_array_add (elements, element);
+                dialog->priv->iops_elements[n] = element;
+        }
+
+        element = mdu_details_element_new (_("Optimal Block Size:"), NULL, NULL);
+        g_ptr_array_add (elements, element);
+        dialog->priv->optimal_block_size_element = element;
+
+        element = mdu_details_element_new (_("Regressions:"), NULL, NULL);
+        g_ptr_array_add (elements, element);
+        dialog->priv->regressions_element = element;
+
         table = mdu_details_table_new (2, elements);
         g_ptr_array_unref (elements);
         gtk_box_pack_start (GTK_BOX (vbox2), table, FALSE, FALSE, 0);
@@ -792,24 +1265,122 @@ mdu_drive_benchmark_dialog_constructed (GObject *object)
                           dialog);
         g_ptr_array_add (elements, button_element);
 
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("Start _Non-Destructive Write Benchmark"),
+                                                 _("Measure write rate in unallocated space or on a temporary file"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (on_run_non_destructive_write_benchmark_clicked),
+                          dialog);
+        /* the daemon can only write to the whole drive */
+        mdu_button_element_set_visible (button_element, can_benchmark_in_process (dialog, FALSE));
+        g_ptr_array_add (elements, button_element);
+
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("Start Ra_ndom I/O Benchmark"),
+                                                 _("Measure random read IOPS and latency"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (on_run_random_benchmark_clicked),
+                          dialog);
+        /* the daemon can't do this one */
+        mdu_button_element_set_visible (button_element, can_benchmark_in_process (dialog, FALSE));
+        g_ptr_array_add (elements, button_element);
+
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("Start Block Size S_weep"),
+                                                 _("Measure read rate for request sizes from 4 KiB to 8 MiB"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (on_run_sweep_benchmark_clicked),
+                          dialog);
+        /* nor this one */
+        mdu_button_element_set_visible (button_element, can_benchmark_in_process (dialog, FALSE));
+        g_ptr_array_add (elements, button_element);
+
         table = mdu_button_table_new (2, elements);
         g_ptr_array_unref (elements);
         gtk_box_pack_start (GTK_BOX (vbox2), table, FALSE, FALSE, 0);
 
         /* ---------------------------------------------------------------------------------------------------- */
 
+        /* settings for the in-process benchmark; the daemon doesn't take any */
+        expander = gtk_expander_new_with_mnemonic (_("_Settings"));
+        gtk_box_pack_start (GTK_BOX (vbox2), expander, FALSE, FALSE, 0);
+        dialog->priv->settings_expander = expander;
+
+        align = gtk_alignment_new (0.5, 0.5, 1.0, 1.0);
+        gtk_alignment_set_padding (GTK_ALIGNMENT (align), 6, 0, 12, 0);
+        gtk_container_add (GTK_CONTAINER (expander), align);
+
+        table = gtk_table_new (3, 2, FALSE);
+        gtk_table_set_col_spacings (GTK_TABLE (table), 12);
+        gtk_table_set_row_spacings (GTK_TABLE (table), 6);
+        gtk_container_add (GTK_CONTAINER (align), table);
+
+        label = gtk_label_new (NULL);
+        gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+        gtk_label_set_markup_with_mnemonic (GTK_LABEL (label), _("_Queue Depth:"));
+        gtk_table_attach (GTK_TABLE (table), label, 0, 1, 0, 1,
+                          GTK_FILL, GTK_EXPAND | GTK_FILL, 2, 2);
+        spin_button = gtk_spin_button_new_with_range (1, 256, 1);
+        gtk_spin_button_set_value (GTK_SPIN_BUTTON (spin_button), 32);
+        gtk_widget_set_tooltip_text (spin_button, _("The number of requests each worker keeps in flight"));
+        gtk_table_attach (GTK_TABLE (table), spin_button, 1, 2, 0, 1,
+                          GTK_FILL, GTK_EXPAND | GTK_FILL, 2, 2);
+        gtk_label_set_mnemonic_widget (GTK_LABEL (label), spin_button);
+        dialog->priv->queue_depth_spin_button = spin_button;
+
+        label = gtk_label_new (NULL);
+        gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+        gtk_label_set_markup_with_mnemonic (GTK_LABEL (label), _("_Block Size:"));
+        gtk_table_attach (GTK_TABLE (table), label, 0, 1, 1, 2,
+                          GTK_FILL, GTK_EXPAND | GTK_FILL, 2, 2);
+        combo_box = gtk_combo_box_new_text ();
+        for (n = 0; n < G_N_ELEMENTS (block_sizes); n++) {
+                s = mdu_util_get_size_for_display (block_sizes[n], FALSE, FALSE);
+                gtk_combo_box_append_text (GTK_COMBO_BOX (combo_box), s);
+                g_free (s);
+        }
+        gtk_combo_box_set_active (GTK_COMBO_BOX (combo_box), DEFAULT_BLOCK_SIZE_INDEX);
+        gtk_widget_set_tooltip_text (combo_box, _("The size of each request when measuring the transfer rate"));
+        gtk_table_attach (GTK_TABLE (table), combo_box, 1, 2, 1, 2,
+                          GTK_FILL, GTK_EXPAND | GTK_FILL, 2, 2);
+        gtk_label_set_mnemonic_widget (GTK_LABEL (label), combo_box);
+        dialog->priv->block_size_combo_box = combo_box;
+
+        label = gtk_label_new (NULL);
+        gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+        gtk_label_set_markup_with_mnemonic (GTK_LABEL (label), _("_Workers:"));
+        gtk_table_attach (GTK_TABLE (table), label, 0, 1, 2, 3,
+                          GTK_FILL, GTK_EXPAND | GTK_FILL, 2, 2);
+        spin_button = gtk_spin_button_new_with_range (1, 64, 1);
+        gtk_spin_button_set_value (GTK_SPIN_BUTTON (spin_button), 1);
+        gtk_widget_set_tooltip_text (spin_button, _("The number of threads submitting requests in parallel"));
+        gtk_table_attach (GTK_TABLE (table), spin_button, 1, 2, 2, 3,
+                          GTK_FILL, GTK_EXPAND | GTK_FILL, 2, 2);
+        gtk_label_set_mnemonic_widget (GTK_LABEL (label), spin_button);
+        dialog->priv->num_workers_spin_button = spin_button;
+
+        /* the settings only apply when the benchmark runs in this process */
+        gtk_widget_set_no_show_all (expander, !can_benchmark_in_process (dialog, FALSE));
+
+        /* ---------------------------------------------------------------------------------------------------- */
+
         /* load data from cache, if available */
         error = NULL;
-        dialog->priv->benchmark_data = benchmark_data_load (mdu_dialog_get_device (MDU_DIALOG (dialog)), &error);
-        if (dialog->priv->benchmark_data == NULL) {
-                if (!(error->domain == G_FILE_ERROR && error->code == G_FILE_ERROR_NOENT)) {
-                        g_warning ("Unable to load existing benchmark results: %s", error->message);
-                }
+        dialog->priv->history = benchmark_history_open (mdu_dialog_get_device (MDU_DIALOG (dialog)), &error);
+        if (dialog->priv->history == NULL) {
+                g_warning ("Unable to load existing benchmark results: %s", error->message);
                 g_error_free (error);
         } else {
-                /*benchmark_data_print (dialog->priv->benchmark_data);*/
+                dialog->priv->benchmark_data = benchmark_data_from_history (dialog->priv->history);
+                /*if (dialog->priv->benchmark_data != NULL)
+                        benchmark_data_print (dialog->priv->benchmark_data);*/
         }
 
+        update_show_previous_runs (dialog);
+        update_regressions (dialog);
         update_dialog (dialog);
 
         if (G_OBJECT_CLASS (mdu_drive_benchmark_dialog_parent_class)->constructed != NULL)
@@ -863,35 +1434,73 @@ measure_height (cairo_t     *cr,
         return te.height;
 }
 
-static gboolean
-on_drawing_area_expose_event (GtkWidget      *widget,
-                              GdkEventExpose *event,
-                              gpointer        user_data)
+static gchar *
+graph_get_speed_marker (const GraphLayout *layout,
+                        guint              n)
 {
-        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
-        GtkAllocation allocation;
-        cairo_t *cr;
-        gdouble width, height;
-        gdouble gx, gy, gw, gh;
-        guint n;
-        gdouble w, h;
-        gdouble x, y;
-        gdouble x_marker_height;
-        guint64 size;
-        gchar *s;
+        /* Translators: This is used in the benchmark graph - %d is megabytes per second */
+        return g_strdup_printf (_("%d MB/s"), (gint) (n * layout->speed_res / (1000 * 1000)));
+}
+
+static gchar *
+graph_get_time_marker (const GraphLayout *layout,
+                       guint              n)
+{
+        /* Translators: This is used in the benchmark graph - %g is number of milliseconds */
+        return g_strdup_printf (_("%3g ms"), n * layout->time_res * 1000.0);
+}
+
+/* The part of the benchmark data the transfer rate graph shows; the samples
+ * of the running benchmark if there is one
+ */
+static BenchmarkData *
+graph_get_data (MduDriveBenchmarkDialog *dialog)
+{
+        if (dialog->priv->live_data != NULL)
+                return dialog->priv->live_data;
+        return dialog->priv->benchmark_data;
+}
+
+/* Earlier runs with a read rate are drawn behind the current one, newest
+ * first, starting below the returned index. Returns -1 if they are not shown.
+ */
+static gint
+graph_get_first_previous_run (MduDriveBenchmarkDialog *dialog)
+{
+        if (dialog->priv->history == NULL ||
+            !gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (dialog->priv->show_previous_runs_check_button)))
+                return -1;
+
+        /* while running, the newest stored run is a previous one too */
+        if (dialog->priv->live_data != NULL)
+                return mdu_benchmark_history_get_num_runs (dialog->priv->history);
+
+        return benchmark_history_find_transfer_rate_run (dialog->priv->history);
+}
+
+/* Picks the scales so that everything in the graph fits */
+static void
+graph_compute_scales (MduDriveBenchmarkDialog *dialog,
+                      gdouble                  width,
+                      gdouble                  height,
+                      GraphLayout             *layout)
+{
+        BenchmarkData *data;
         gdouble max_speed;
-        gdouble max_visible_speed;
-        gdouble speed_res;
         gdouble max_time;
+        gdouble speed_res;
         gdouble time_res;
-        gdouble max_visible_time;
-        gchar **y_left_markers;
-        gchar **y_right_markers;
+        gint first_previous_run;
+        MduBenchmarkHistoryRun run;
+        guint num_previous_runs;
         guint num_y_markers;
-        GPtrArray *p;
-        GPtrArray *p2;
+        gint m;
+        guint n;
 
-        if (dialog->priv->benchmark_data == NULL) {
+        data = graph_get_data (dialog);
+        first_previous_run = graph_get_first_previous_run (dialog);
+
+        if (data == NULL) {
                 max_speed = 100 * 1000 * 1000;
                 max_time = 50 / 1000.0;
         } else {
@@ -899,29 +1508,38 @@ on_drawing_area_expose_event (GtkWidget      *widget,
                 gdouble write_transfer_rate_max;
                 gdouble access_time_max;
 
-                benchmark_get_max_min_avg (dialog->priv->benchmark_data->read_transfer_rate_samples,
-                                           &read_transfer_rate_max,
-                                           NULL,
-                                           NULL);
-                benchmark_get_max_min_avg (dialog->priv->benchmark_data->write_transfer_rate_samples,
-                                           &write_transfer_rate_max,
-                                           NULL,
-                                           NULL);
+                mdu_benchmark_samples_get_max_min_avg (data->read_transfer_rate_samples,
+                                                       &read_transfer_rate_max,
+                                                       NULL,
+                                                       NULL);
+                mdu_benchmark_samples_get_max_min_avg (data->write_transfer_rate_samples,
+                                                       &write_transfer_rate_max,
+                                                       NULL,
+                                                       NULL);
 
-                benchmark_get_max_min_avg (dialog->priv->benchmark_data->access_time_samples,
-                                           &access_time_max,
-                                           NULL,
-                                           NULL);
+                mdu_benchmark_samples_get_max_min_avg (data->access_time_samples,
+                                                       &access_time_max,
+                                                       NULL,
+                                                       NULL);
 
                 max_speed = MAX (read_transfer_rate_max, write_transfer_rate_max);
 
                 max_time = access_time_max;
+
+                num_previous_runs = 0;
+                for (m = first_previous_run - 1; m >= 0 && num_previous_runs < MAX_PREVIOUS_RUNS; m--) {
+                        mdu_benchmark_history_get_run (dialog->priv->history, m, &run);
+                        if (run.num_read_samples == 0)
+                                continue;
+                        for (n = 0; n < run.num_read_samples; n++)
+                                max_speed = MAX (max_speed, run.read_samples[n].value);
+                        num_previous_runs++;
+                }
         }
 
         speed_res = (floor (((gdouble) max_speed) / (100 * 1000 * 1000)) + 1) * 1000 * 1000;
         speed_res *= 10.0;
         num_y_markers = (max_speed / speed_res) + 1;
-        max_visible_speed = speed_res * num_y_markers;
 
         time_res = max_time / num_y_markers;
         if (time_res < 0.0001) {
@@ -937,55 +1555,49 @@ on_drawing_area_expose_event (GtkWidget      *widget,
         } else {
                 time_res = ceil (((gdouble) time_res) / 0.005) * 0.005;
         }
-        max_visible_time = time_res * num_y_markers;
-
-        /*g_debug ("max_visible_speed=%f, max_speed=%f, speed_res=%f", max_visible_speed, max_speed, speed_res);*/
-        /*g_debug ("max_visible_time=%f, max_time=%f, time_res=%f", max_visible_time, max_time, time_res);*/
-
-        p = g_ptr_array_new ();
-        p2 = g_ptr_array_new ();
-        for (n = 0; n <= num_y_markers; n++) {
-                gdouble val;
-
-                val = n * speed_res;
-                /* Translators: This is used in the benchmark graph - %d is megabytes per second */
-                s = g_strdup_printf (_("%d MB/s"), (gint) (val / (1000 * 1000)));
-                g_ptr_array_add (p, s);
-
-                val = n * time_res;
-                /* Translators: This is used in the benchmark graph - %g is number of milliseconds */
-                s = g_strdup_printf (_("%3g ms"), val * 1000.0);
-                g_ptr_array_add (p2, s);
-        }
-        g_ptr_array_add (p, NULL);
-        g_ptr_array_add (p2, NULL);
-        y_left_markers = (gchar **) g_ptr_array_free (p, FALSE);
-        y_right_markers = (gchar **) g_ptr_array_free (p2, FALSE);
-
-        size = mdu_device_get_size (mdu_dialog_get_device (MDU_DIALOG (dialog)));
-
-        gtk_widget_get_allocation (widget, &allocation);
-        width = allocation.width;
-        height = allocation.height;
 
-        cr = gdk_cairo_create (gtk_widget_get_window (widget));
+        /*g_debug ("max_visible_speed=%f, max_speed=%f, speed_res=%f", speed_res * num_y_markers, max_speed, speed_res);*/
+        /*g_debug ("max_visible_time=%f, max_time=%f, time_res=%f", time_res * num_y_markers, max_time, time_res);*/
+
+        layout->width = width;
+        layout->height = height;
+        layout->num_y_markers = num_y_markers;
+        layout->speed_res = speed_res;
+        layout->max_visible_speed = speed_res * num_y_markers;
+        layout->time_res = time_res;
+        layout->max_visible_time = time_res * num_y_markers;
+        layout->disk_size = data != NULL ? data->disk_size : 0;
+}
 
-        cairo_select_font_face (cr, "sans",
-                                CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-        cairo_set_font_size (cr, 8.0);
-        cairo_set_line_width (cr, 1.0);
+/* Whether a graph drawn with @a can be reused for @b */
+static gboolean
+graph_layout_has_same_scales (const GraphLayout *a,
+                              const GraphLayout *b)
+{
+        return a->width == b->width &&
+                a->height == b->height &&
+                a->num_y_markers == b->num_y_markers &&
+                a->speed_res == b->speed_res &&
+                a->time_res == b->time_res;
+}
 
-        cairo_rectangle (cr,
-                         event->area.x, event->area.y,
-                         event->area.width, event->area.height);
-        cairo_clip (cr);
+/* Works out where the graph area goes for the scales in @layout, leaving
+ * room for the markers
+ */
+static void
+graph_compute_layout (cairo_t     *cr,
+                      GraphLayout *layout)
+{
+        gdouble width, height;
+        gdouble gx, gy, gw, gh;
+        gdouble w, h;
+        guint num_y_markers;
+        gchar *s;
+        guint n;
 
-#if 0
-        cairo_set_source_rgb (cr, 0.25, 0.25, 0.25);
-        cairo_rectangle (cr, 0, 0, width, height);
-        cairo_set_line_width (cr, 0.0);
-	cairo_fill (cr);
-#endif
+        width = layout->width;
+        height = layout->height;
+        num_y_markers = layout->num_y_markers;
 
         gx = 0;
         gy = 0;
@@ -997,49 +1609,182 @@ on_drawing_area_expose_event (GtkWidget      *widget,
         gx +=  w;
         gw -=  w;
         w = ceil (measure_width (cr, "100%") / 2.0);
-        x_marker_height = ceil (measure_height (cr, "100%")) + 10;
+        layout->x_marker_height = ceil (measure_height (cr, "100%")) + 10;
         gw -= w;
-        gh -= x_marker_height;
+        gh -= layout->x_marker_height;
 
-        /* make horizontal room for left y markers ("%d MB/s") */
         for (n = 0; n <= num_y_markers; n++) {
-                w = ceil (measure_width (cr, y_left_markers[n])) + 2 * 3;
+                /* make horizontal room for left y markers ("%d MB/s") */
+                s = graph_get_speed_marker (layout, n);
+                w = ceil (measure_width (cr, s)) + 2 * 3;
                 if (w > gx) {
                         gdouble needed = w - gx;
                         gx += needed;
                         gw -= needed;
                 }
-        }
-        /* make vertical room for top-left y marker */
-        h = ceil (measure_height (cr, y_left_markers[num_y_markers]) / 2.0);
-        if (h > gy) {
-                gdouble needed = h - gy;
-                gy += needed;
-                gh -= needed;
+                /* make vertical room for top-left y marker */
+                if (n == num_y_markers) {
+                        h = ceil (measure_height (cr, s) / 2.0);
+                        if (h > gy) {
+                                gdouble needed = h - gy;
+                                gy += needed;
+                                gh -= needed;
+                        }
+                }
+                g_free (s);
         }
 
-        /* make horizontal room for right y markers ("%d ms") */
         for (n = 0; n <= num_y_markers; n++) {
-                w = ceil (measure_width (cr, y_right_markers[n])) + 2 * 3;
+                /* make horizontal room for right y markers ("%d ms") */
+                s = graph_get_time_marker (layout, n);
+                w = ceil (measure_width (cr, s)) + 2 * 3;
                 if (w > width - (gx + gw)) {
                         gdouble needed = w - (width - (gx + gw));
                         gw -= needed;
                 }
+                /* make vertical room for top-right y marker */
+                if (n == num_y_markers) {
+                        h = ceil (measure_height (cr, s) / 2.0);
+                        if (h > gy) {
+                                gdouble needed = h - gy;
+                                gy += needed;
+                                gh -= needed;
+                        }
+                }
+                g_free (s);
         }
-        /* make vertical room for top-right y marker */
-        h = ceil (measure_height (cr, y_right_markers[num_y_markers]) / 2.0);
-        if (h > gy) {
-                gdouble needed = h - gy;
-                gy += needed;
-                gh -= needed;
+
+        layout->gx = gx;
+        layout->gy = gy;
+        layout->gw = gw;
+        layout->gh = gh;
+}
+
+static void
+graph_set_font (cairo_t *cr)
+{
+        cairo_select_font_face (cr, "sans",
+                                CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size (cr, 8.0);
+}
+
+static gdouble
+graph_get_x (const GraphLayout *layout,
+             guint64            offset)
+{
+        return layout->gx + layout->gw * offset / layout->disk_size;
+}
+
+static gdouble
+graph_get_y (const GraphLayout *layout,
+             gdouble            value,
+             gdouble            max_visible_value)
+{
+        return layout->gy + layout->gh - layout->gh * value / max_visible_value;
+}
+
+/* Draws the line from the previous sample to @point, or just moves there
+ * if it's the first one
+ */
+static void
+graph_line_to (cairo_t              *cr,
+               const GraphLayout    *layout,
+               const BenchmarkPoint *point,
+               gdouble               max_visible_value,
+               gboolean              first)
+{
+        gdouble x, y;
+
+        x = graph_get_x (layout, point->offset);
+        y = graph_get_y (layout, point->value, max_visible_value);
+        if (first)
+                cairo_move_to (cr, x, y);
+        else
+                cairo_line_to (cr, x, y);
+}
+
+static void
+graph_draw_access_time_sample (cairo_t              *cr,
+                               const GraphLayout    *layout,
+                               const BenchmarkPoint *point,
+                               const BenchmarkPoint *prev_point)
+{
+        gdouble x, y;
+
+        x = graph_get_x (layout, point->offset);
+        y = graph_get_y (layout, point->value, layout->max_visible_time);
+
+        /*g_debug ("time = %f @ %f", point->value, x);*/
+
+        cairo_set_line_width (cr, 0.5);
+        cairo_set_source_rgba (cr, 0.4, 1.0, 0.4, 0.5);
+        cairo_arc (cr, x, y, 1.5, 0, 2 * M_PI);
+        cairo_fill (cr);
+
+        if (prev_point != NULL) {
+                cairo_set_source_rgba (cr, 0.2, 0.5, 0.2, 0.10);
+                cairo_move_to (cr,
+                               graph_get_x (layout, prev_point->offset),
+                               graph_get_y (layout, prev_point->value, layout->max_visible_time));
+                cairo_line_to (cr, x, y);
+                cairo_stroke (cr);
         }
+}
+
+static void
+graph_set_write_style (cairo_t *cr)
+{
+        cairo_set_source_rgb (cr, 1.0, 0.5, 0.5);
+        cairo_set_line_width (cr, 2.0);
+}
+
+static void
+graph_set_read_style (cairo_t *cr)
+{
+        cairo_set_source_rgb (cr, 0.5, 0.5, 1.0);
+        cairo_set_line_width (cr, 1.5);
+}
+
+/* Draws what only depends on the scales and the history: the markers, the
+ * grid and the read rates of earlier runs
+ */
+static void
+graph_draw_static (MduDriveBenchmarkDialog *dialog,
+                   cairo_t                 *cr,
+                   const GraphLayout       *layout)
+{
+        gdouble gx, gy, gw, gh;
+        gdouble x, y;
+        gint first_previous_run;
+        MduBenchmarkHistoryRun run;
+        guint num_previous_runs;
+        gchar *s;
+        gint m;
+        guint n;
+
+        first_previous_run = graph_get_first_previous_run (dialog);
+
+        gx = layout->gx;
+        gy = layout->gy;
+        gw = layout->gw;
+        gh = layout->gh;
+
+        graph_set_font (cr);
+        cairo_set_line_width (cr, 1.0);
+
+#if 0
+        cairo_set_source_rgb (cr, 0.25, 0.25, 0.25);
+        cairo_rectangle (cr, 0, 0, layout->width, layout->height);
+        cairo_set_line_width (cr, 0.0);
+	cairo_fill (cr);
+#endif
 
         /* draw x markers ("%d%%") + vertical grid */
         for (n = 0; n <= 10; n++) {
                 cairo_text_extents_t te;
 
                 x = gx + ceil (n * gw / 10.0);
-                y = gy + gh + x_marker_height/2.0;
+                y = gy + gh + layout->x_marker_height/2.0;
 
                 s = g_strdup_printf ("%d%%", n * 10);
 
@@ -1055,35 +1800,37 @@ on_drawing_area_expose_event (GtkWidget      *widget,
         }
 
         /* draw left y markers ("%d MB/s") */
-        for (n = 0; n <= num_y_markers; n++) {
+        for (n = 0; n <= layout->num_y_markers; n++) {
                 cairo_text_extents_t te;
 
                 x = gx/2.0;
-                y = gy + gh - gh * n / num_y_markers;
+                y = gy + gh - gh * n / layout->num_y_markers;
 
-                s = y_left_markers[n];
+                s = graph_get_speed_marker (layout, n);
                 cairo_text_extents (cr, s, &te);
                 cairo_move_to (cr,
                                x - te.x_bearing - te.width/2,
                                y - te.y_bearing - te.height/2);
                 cairo_set_source_rgb (cr, 0, 0, 0);
                 cairo_show_text (cr, s);
+                g_free (s);
         }
 
         /* draw right y markers ("%d ms") */
-        for (n = 0; n <= num_y_markers; n++) {
+        for (n = 0; n <= layout->num_y_markers; n++) {
                 cairo_text_extents_t te;
 
-                x = gx + gw + (width - (gx + gw))/2.0;
-                y = gy + gh - gh * n / num_y_markers;
+                x = gx + gw + (layout->width - (gx + gw))/2.0;
+                y = gy + gh - gh * n / layout->num_y_markers;
 
-                s = y_right_markers[n];
+                s = graph_get_time_marker (layout, n);
                 cairo_text_extents (cr, s, &te);
                 cairo_move_to (cr,
                                x - te.x_bearing - te.width/2,
                                y - te.y_bearing - te.height/2);
                 cairo_set_source_rgb (cr, 0, 0, 0);
                 cairo_show_text (cr, s);
+                g_free (s);
         }
 
         /* fill graph area */
@@ -1104,51 +1851,26 @@ on_drawing_area_expose_event (GtkWidget      *widget,
                 cairo_stroke (cr);
         }
         /* horizontal lines */
-        for (n = 1; n < num_y_markers; n++) {
-                y = gy + ceil (n * gh / num_y_markers);
+        for (n = 1; n < layout->num_y_markers; n++) {
+                y = gy + ceil (n * gh / layout->num_y_markers);
                 cairo_move_to (cr, gx + 0.5, y + 0.5);
                 cairo_line_to (cr, gx + gw + 0.5, y + 0.5);
                 cairo_stroke (cr);
         }
 
-        if (dialog->priv->benchmark_data != NULL) {
-                BenchmarkData *data = dialog->priv->benchmark_data;
-                gdouble prev_x;
-                gdouble prev_y;
-
-                /* draw access time dots + lines */
-                cairo_set_line_width (cr, 0.5);
-                for (n = 0; n < data->access_time_samples->len; n++) {
-                        BenchmarkPoint *point = &g_array_index (data->access_time_samples, BenchmarkPoint, n);
-
-                        x = gx + gw * point->offset / data->disk_size;
-                        y = gy + gh - gh * point->value / max_visible_time;
-
-                        /*g_debug ("time = %f @ %f", point->value, x);*/
-
-                        cairo_set_source_rgba (cr, 0.4, 1.0, 0.4, 0.5);
-                        cairo_arc (cr, x, y, 1.5, 0, 2 * M_PI);
-                        cairo_fill (cr);
-
-                        if (n > 0) {
-                                cairo_set_source_rgba (cr, 0.2, 0.5, 0.2, 0.10);
-                                cairo_move_to (cr, prev_x, prev_y);
-                                cairo_line_to (cr, x, y);
-                                cairo_stroke (cr);
-                        }
-
-                        prev_x = x;
-                        prev_y = y;
-                }
-
-                /* draw write transfer rate graph */
-                cairo_set_source_rgb (cr, 1.0, 0.5, 0.5);
-                cairo_set_line_width (cr, 2.0);
-                for (n = 0; n < data->write_transfer_rate_samples->len; n++) {
-                        BenchmarkPoint *point = &g_array_index (data->write_transfer_rate_samples, BenchmarkPoint, n);
-
-                        x = gx + gw * point->offset / data->disk_size;
-                        y = gy + gh - gh * point->value / max_visible_speed;
+        /* draw read transfer rate graphs of previous runs, fading out with age */
+        cairo_set_line_width (cr, 1.0);
+        num_previous_runs = 0;
+        for (m = first_previous_run - 1; m >= 0 && num_previous_runs < MAX_PREVIOUS_RUNS; m--) {
+                mdu_benchmark_history_get_run (dialog->priv->history, m, &run);
+                if (run.num_read_samples == 0 || run.disk_size == 0)
+                        continue;
+
+                cairo_set_source_rgba (cr, 0.5, 0.5, 1.0,
+                                       0.5 * (MAX_PREVIOUS_RUNS - num_previous_runs) / MAX_PREVIOUS_RUNS);
+                for (n = 0; n < run.num_read_samples; n++) {
+                        x = gx + gw * run.read_samples[n].offset / run.disk_size;
+                        y = graph_get_y (layout, run.read_samples[n].value, layout->max_visible_speed);
 
                         if (n == 0)
                                 cairo_move_to (cr, x, y);
@@ -1156,38 +1878,462 @@ on_drawing_area_expose_event (GtkWidget      *widget,
                                 cairo_line_to (cr, x, y);
                 }
                 cairo_stroke (cr);
+                num_previous_runs++;
+        }
+}
 
-                /* draw read transfer rate graph */
-                cairo_set_source_rgb (cr, 0.5, 0.5, 1.0);
-                cairo_set_line_width (cr, 1.5);
-                for (n = 0; n < data->read_transfer_rate_samples->len; n++) {
-                        BenchmarkPoint *point = &g_array_index (data->read_transfer_rate_samples, BenchmarkPoint, n);
+/* Draws the results of the current run on top of graph_draw_static() */
+static void
+graph_draw_data (MduDriveBenchmarkDialog *dialog,
+                 cairo_t                 *cr,
+                 const GraphLayout       *layout)
+{
+        BenchmarkData *data;
+        gdouble x;
+        guint n;
 
-                        x = gx + gw * point->offset / data->disk_size;
-                        y = gy + gh - gh * point->value / max_visible_speed;
+        data = graph_get_data (dialog);
+        if (data == NULL) {
+                /* TODO: draw some text saying we don't have any data */
+                goto out;
+        }
 
-                        if (n == 0)
-                                cairo_move_to (cr, x, y);
-                        else
-                                cairo_line_to (cr, x, y);
+        cairo_rectangle (cr, layout->gx + 0.5, layout->gy + 0.5, layout->gw, layout->gh);
+        cairo_clip (cr);
+
+        /* shade the ranges where the drive got slower */
+        if (dialog->priv->regressions != NULL && dialog->priv->live_data == NULL) {
+                for (n = 0; n < dialog->priv->regressions->len; n++) {
+                        MduBenchmarkRegression *regression = &g_array_index (dialog->priv->regressions,
+                                                                             MduBenchmarkRegression,
+                                                                             n);
+                        gdouble x2;
+
+                        x = graph_get_x (layout, regression->start_offset);
+                        x2 = graph_get_x (layout, regression->end_offset);
+                        cairo_set_source_rgba (cr, 1.0, 0.0, 0.0, 0.08);
+                        cairo_rectangle (cr, x, layout->gy, x2 - x, layout->gh);
+                        cairo_fill (cr);
                 }
+        }
+
+        /* draw access time dots + lines */
+        for (n = 0; n < data->access_time_samples->len; n++) {
+                graph_draw_access_time_sample (cr,
+                                               layout,
+                                               &g_array_index (data->access_time_samples, BenchmarkPoint, n),
+                                               n > 0 ? &g_array_index (data->access_time_samples, BenchmarkPoint, n - 1) : NULL);
+        }
+
+        /* draw write transfer rate graph */
+        graph_set_write_style (cr);
+        for (n = 0; n < data->write_transfer_rate_samples->len; n++) {
+                graph_line_to (cr,
+                               layout,
+                               &g_array_index (data->write_transfer_rate_samples, BenchmarkPoint, n),
+                               layout->max_visible_speed,
+                               n == 0);
+        }
+        cairo_stroke (cr);
+
+        /* draw read transfer rate graph */
+        graph_set_read_style (cr);
+        for (n = 0; n < data->read_transfer_rate_samples->len; n++) {
+                graph_line_to (cr,
+                               layout,
+                               &g_array_index (data->read_transfer_rate_samples, BenchmarkPoint, n),
+                               layout->max_visible_speed,
+                               n == 0);
+        }
+        cairo_stroke (cr);
+
+ out:
+        ;
+}
+
+/* Throws away the results drawn into the graph, e.g. when they changed. The
+ * static layer is kept if the scales stay the same.
+ */
+static void
+graph_invalidate (MduDriveBenchmarkDialog *dialog)
+{
+        if (dialog->priv->graph_surface != NULL) {
+                cairo_surface_destroy (dialog->priv->graph_surface);
+                dialog->priv->graph_surface = NULL;
+        }
+        gtk_widget_queue_draw (dialog->priv->drawing_area);
+}
+
+/* Throws away the whole graph, e.g. when earlier runs are shown or hidden */
+static void
+graph_invalidate_static (MduDriveBenchmarkDialog *dialog)
+{
+        if (dialog->priv->graph_static_surface != NULL) {
+                cairo_surface_destroy (dialog->priv->graph_static_surface);
+                dialog->priv->graph_static_surface = NULL;
+        }
+        graph_invalidate (dialog);
+}
+
+/* Draws a sample of the running benchmark onto the cached graph. Only the
+ * new segment is drawn and only the area it covers is exposed; if the
+ * sample doesn't fit the scales the whole graph is redone instead.
+ */
+static void
+graph_add_sample (MduDriveBenchmarkDialog *dialog,
+                  MduBenchmarkSampleKind   kind,
+                  GArray                  *samples)
+{
+        const GraphLayout *layout = &dialog->priv->graph_layout;
+        BenchmarkPoint *point;
+        BenchmarkPoint *prev_point;
+        gdouble max_visible_value;
+        gdouble from_x, from_y, to_x, to_y;
+        cairo_t *cr;
+
+        if (dialog->priv->graph_surface == NULL)
+                goto out;
+
+        point = &g_array_index (samples, BenchmarkPoint, samples->len - 1);
+        prev_point = samples->len > 1 ? &g_array_index (samples, BenchmarkPoint, samples->len - 2) : NULL;
+
+        if (kind == MDU_BENCHMARK_SAMPLE_KIND_ACCESS_TIME)
+                max_visible_value = layout->max_visible_time;
+        else
+                max_visible_value = layout->max_visible_speed;
+        if (point->value > max_visible_value) {
+                graph_invalidate (dialog);
+                goto out;
+        }
+
+        cr = cairo_create (dialog->priv->graph_surface);
+        cairo_rectangle (cr, layout->gx + 0.5, layout->gy + 0.5, layout->gw, layout->gh);
+        cairo_clip (cr);
+
+        if (kind == MDU_BENCHMARK_SAMPLE_KIND_ACCESS_TIME) {
+                graph_draw_access_time_sample (cr, layout, point, prev_point);
+        } else if (prev_point != NULL) {
+                if (kind == MDU_BENCHMARK_SAMPLE_KIND_WRITE_TRANSFER_RATE)
+                        graph_set_write_style (cr);
+                else
+                        graph_set_read_style (cr);
+                graph_line_to (cr, layout, prev_point, max_visible_value, TRUE);
+                graph_line_to (cr, layout, point, max_visible_value, FALSE);
                 cairo_stroke (cr);
+        }
 
-        } else {
-                /* TODO: draw some text saying we don't have any data */
+        cairo_destroy (cr);
+
+        /* the area covered by the new segment, with room for line width and dots */
+        to_x = graph_get_x (layout, point->offset);
+        to_y = graph_get_y (layout, point->value, max_visible_value);
+        from_x = to_x;
+        from_y = to_y;
+        if (prev_point != NULL) {
+                from_x = graph_get_x (layout, prev_point->offset);
+                from_y = graph_get_y (layout, prev_point->value, max_visible_value);
+        }
+        gtk_widget_queue_draw_area (dialog->priv->drawing_area,
+                                    floor (MIN (from_x, to_x)) - 3,
+                                    floor (MIN (from_y, to_y)) - 3,
+                                    ceil (fabs (to_x - from_x)) + 7,
+                                    ceil (fabs (to_y - from_y)) + 7);
+
+ out:
+        ;
+}
+
+static gboolean
+on_drawing_area_expose_event (GtkWidget      *widget,
+                              GdkEventExpose *event,
+                              gpointer        user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+        GtkAllocation allocation;
+        GraphLayout layout;
+        cairo_t *cr;
+        cairo_t *surface_cr;
+
+        gtk_widget_get_allocation (widget, &allocation);
+
+        cr = gdk_cairo_create (gtk_widget_get_window (widget));
+
+        /* only draw the graph when something changed, otherwise just copy it */
+        if (dialog->priv->graph_surface != NULL &&
+            (dialog->priv->graph_layout.width != allocation.width ||
+             dialog->priv->graph_layout.height != allocation.height)) {
+                cairo_surface_destroy (dialog->priv->graph_surface);
+                dialog->priv->graph_surface = NULL;
         }
+        if (dialog->priv->graph_surface == NULL) {
+                /* the static layer is kept as long as the size and the scales stay the same */
+                graph_compute_scales (dialog, allocation.width, allocation.height, &layout);
+                if (dialog->priv->graph_static_surface != NULL &&
+                    !graph_layout_has_same_scales (&layout, &dialog->priv->graph_layout)) {
+                        cairo_surface_destroy (dialog->priv->graph_static_surface);
+                        dialog->priv->graph_static_surface = NULL;
+                }
+                if (dialog->priv->graph_static_surface == NULL) {
+                        dialog->priv->graph_static_surface = cairo_surface_create_similar (cairo_get_target (cr),
+                                                                                           CAIRO_CONTENT_COLOR_ALPHA,
+                                                                                           allocation.width,
+                                                                                           allocation.height);
+                        surface_cr = cairo_create (dialog->priv->graph_static_surface);
+                        graph_set_font (surface_cr);
+                        graph_compute_layout (surface_cr, &layout);
+                        graph_draw_static (dialog, surface_cr, &layout);
+                        cairo_destroy (surface_cr);
+                        dialog->priv->graph_layout = layout;
+                } else {
+                        dialog->priv->graph_layout.disk_size = layout.disk_size;
+                }
 
+                dialog->priv->graph_surface = cairo_surface_create_similar (cairo_get_target (cr),
+                                                                            CAIRO_CONTENT_COLOR_ALPHA,
+                                                                            allocation.width,
+                                                                            allocation.height);
+                surface_cr = cairo_create (dialog->priv->graph_surface);
+                cairo_set_source_surface (surface_cr, dialog->priv->graph_static_surface, 0, 0);
+                cairo_paint (surface_cr);
+                graph_draw_data (dialog, surface_cr, &dialog->priv->graph_layout);
+                cairo_destroy (surface_cr);
+        }
 
+        cairo_rectangle (cr,
+                         event->area.x, event->area.y,
+                         event->area.width, event->area.height);
+        cairo_clip (cr);
+        cairo_set_source_surface (cr, dialog->priv->graph_surface, 0, 0);
+        cairo_paint (cr);
 
         cairo_destroy (cr);
 
-        g_strfreev (y_left_markers);
-        g_strfreev (y_right_markers);
+        /* propagate event further */
+        return FALSE;
+}
+
+/* Draws the read rate as a function of the request size. The request
+ * sizes double from one point to the next so they are evenly spaced.
+ */
+static gboolean
+on_sweep_drawing_area_expose_event (GtkWidget      *widget,
+                                    GdkEventExpose *event,
+                                    gpointer        user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+        BenchmarkData *data = dialog->priv->benchmark_data;
+        GtkAllocation allocation;
+        cairo_t *cr;
+        gdouble width, height;
+        gdouble gx, gy, gw, gh;
+        gdouble w;
+        gdouble x, y;
+        gdouble x_marker_height;
+        gdouble max_speed;
+        gdouble speed_res;
+        gdouble max_visible_speed;
+        guint num_y_markers;
+        guint num_points;
+        gchar *s;
+        guint n;
+
+        if (data == NULL || data->sweep_points->len == 0)
+                goto out;
+
+        num_points = data->sweep_points->len;
+
+        max_speed = 0.0;
+        for (n = 0; n < num_points; n++) {
+                MduBenchmarkSweepPoint *point = &g_array_index (data->sweep_points, MduBenchmarkSweepPoint, n);
+                max_speed = MAX (max_speed, point->transfer_rate);
+        }
+        /* same scale steps as the transfer rate graph */
+        speed_res = (floor (((gdouble) max_speed) / (100 * 1000 * 1000)) + 1) * 1000 * 1000;
+        speed_res *= 10.0;
+        num_y_markers = (max_speed / speed_res) + 1;
+        max_visible_speed = speed_res * num_y_markers;
+
+        gtk_widget_get_allocation (widget, &allocation);
+        width = allocation.width;
+        height = allocation.height;
+
+        cr = gdk_cairo_create (gtk_widget_get_window (widget));
+
+        cairo_select_font_face (cr, "sans",
+                                CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        cairo_set_font_size (cr, 8.0);
+        cairo_set_line_width (cr, 1.0);
+
+        cairo_rectangle (cr,
+                         event->area.x, event->area.y,
+                         event->area.width, event->area.height);
+        cairo_clip (cr);
+
+        /* make room for the y markers on the left and the x markers below */
+        s = g_strdup_printf (_("%d MB/s"), (gint) (max_visible_speed / (1000 * 1000)));
+        gx = ceil (measure_width (cr, s)) + 2 * 3;
+        gy = ceil (measure_height (cr, s) / 2.0);
+        g_free (s);
+        x_marker_height = ceil (measure_height (cr, "8.0 MiB")) + 10;
+        w = ceil (measure_width (cr, "8.0 MiB") / 2.0);
+        gw = width - gx - w;
+        gh = height - gy - x_marker_height;
+
+        /* y markers ("%d MB/s") */
+        for (n = 0; n <= num_y_markers; n++) {
+                cairo_text_extents_t te;
+
+                /* Translators: This is used in the benchmark graph - %d is megabytes per second */
+                s = g_strdup_printf (_("%d MB/s"), (gint) (n * speed_res / (1000 * 1000)));
+                cairo_text_extents (cr, s, &te);
+                x = gx / 2.0;
+                y = gy + gh - gh * n / num_y_markers;
+                cairo_move_to (cr,
+                               x - te.x_bearing - te.width/2,
+                               y - te.y_bearing - te.height/2);
+                cairo_set_source_rgb (cr, 0, 0, 0);
+                cairo_show_text (cr, s);
+                g_free (s);
+        }
+
+        /* x markers (request sizes); every other one so they don't overlap */
+        for (n = 0; n < num_points; n += 2) {
+                MduBenchmarkSweepPoint *point = &g_array_index (data->sweep_points, MduBenchmarkSweepPoint, n);
+                cairo_text_extents_t te;
+
+                x = gx + (num_points > 1 ? gw * n / (num_points - 1) : gw / 2.0);
+                y = gy + gh + x_marker_height / 2.0;
+                s = mdu_util_get_size_for_display (point->block_size, TRUE, FALSE);
+                cairo_text_extents (cr, s, &te);
+                cairo_move_to (cr,
+                               x - te.x_bearing - te.width/2,
+                               y - te.y_bearing - te.height/2);
+                cairo_set_source_rgb (cr, 0, 0, 0);
+                cairo_show_text (cr, s);
+                g_free (s);
+        }
+
+        /* graph area and grid */
+        cairo_set_source_rgb (cr, 1, 1, 1);
+        cairo_rectangle (cr, gx + 0.5, gy + 0.5, gw, gh);
+        cairo_fill_preserve (cr);
+        cairo_set_source_rgba (cr, 0, 0, 0, 0.25);
+        cairo_stroke_preserve (cr);
+        cairo_clip (cr);
+        for (n = 1; n < num_y_markers; n++) {
+                y = gy + ceil (n * gh / num_y_markers);
+                cairo_move_to (cr, gx + 0.5, y + 0.5);
+                cairo_line_to (cr, gx + gw + 0.5, y + 0.5);
+                cairo_stroke (cr);
+        }
+
+        /* the curve, in the color of the read transfer rate graph */
+        cairo_set_source_rgb (cr, 0.5, 0.5, 1.0);
+        cairo_set_line_width (cr, 1.5);
+        for (n = 0; n < num_points; n++) {
+                MduBenchmarkSweepPoint *point = &g_array_index (data->sweep_points, MduBenchmarkSweepPoint, n);
+
+                x = gx + (num_points > 1 ? gw * n / (num_points - 1) : gw / 2.0);
+                y = gy + gh - gh * point->transfer_rate / max_visible_speed;
+                if (n == 0)
+                        cairo_move_to (cr, x, y);
+                else
+                        cairo_line_to (cr, x, y);
+        }
+        cairo_stroke (cr);
+
+        /* mark the optimum */
+        for (n = 0; n < num_points; n++) {
+                MduBenchmarkSweepPoint *point = &g_array_index (data->sweep_points, MduBenchmarkSweepPoint, n);
 
+                if (point->block_size != data->optimal_block_size)
+                        continue;
+
+                x = gx + (num_points > 1 ? gw * n / (num_points - 1) : gw / 2.0);
+                y = gy + gh - gh * point->transfer_rate / max_visible_speed;
+                cairo_set_source_rgba (cr, 0.2, 0.5, 0.2, 0.5);
+                cairo_set_line_width (cr, 1.0);
+                cairo_move_to (cr, floor (x) + 0.5, gy);
+                cairo_line_to (cr, floor (x) + 0.5, gy + gh);
+                cairo_stroke (cr);
+                cairo_set_source_rgb (cr, 0.2, 0.5, 0.2);
+                cairo_arc (cr, x, y, 3.0, 0, 2 * M_PI);
+                cairo_fill (cr);
+        }
+
+        cairo_destroy (cr);
+
+ out:
         /* propagate event further */
         return FALSE;
 }
 
+/* ---------------------------------------------------------------------------------------------------- */
+
+/**
+ * mdu_drive_benchmark_dialog_get_optimal_block_size:
+ * @presentable: A #MduPresentable.
+ *
+ * Looks up the optimal request size found by the last block size sweep
+ * of the drive @presentable is on, if any. This is used to suggest
+ * alignments and RAID chunk sizes elsewhere.
+ *
+ * Returns: The size in bytes or 0 if the drive hasn't been swept.
+ */
+guint
+mdu_drive_benchmark_dialog_get_optimal_block_size (MduPresentable *presentable)
+{
+        MduPresentable *p;
+        MduPresentable *enclosing;
+        MduDevice *device;
+        MduBenchmarkHistory *history;
+        MduBenchmarkHistoryRun run;
+        GArray *sweep_points;
+        guint ret;
+        gint n;
+
+        g_return_val_if_fail (MDU_IS_PRESENTABLE (presentable), 0);
+
+        ret = 0;
+        device = NULL;
+
+        p = g_object_ref (presentable);
+        while (p != NULL && !MDU_IS_DRIVE (p)) {
+                enclosing = mdu_presentable_get_enclosing_presentable (p);
+                g_object_unref (p);
+                p = enclosing;
+        }
+        if (p == NULL)
+                goto out;
+
+        device = mdu_presentable_get_device (p);
+        if (device == NULL)
+                goto out;
+
+        history = benchmark_history_open (device, NULL);
+        if (history == NULL)
+                goto out;
+
+        for (n = mdu_benchmark_history_get_num_runs (history) - 1; n >= 0; n--) {
+                mdu_benchmark_history_get_run (history, n, &run);
+                if (run.num_sweep_points > 0) {
+                        sweep_points = g_array_sized_new (FALSE, FALSE, sizeof (MduBenchmarkSweepPoint), run.num_sweep_points);
+                        g_array_append_vals (sweep_points, run.sweep_points, run.num_sweep_points);
+                        ret = mdu_benchmark_sweep_get_optimal_block_size (sweep_points);
+                        g_array_unref (sweep_points);
+                        break;
+                }
+        }
+        g_object_unref (history);
+
+ out:
+        if (device != NULL)
+                g_object_unref (device);
+        if (p != NULL)
+                g_object_unref (p);
+        return ret;
+}
+
 
 /* ---------------------------------------------------------------------------------------------------- */
 
@@ -1200,6 +2346,13 @@ is_benchmarking (MduDriveBenchmarkDialog *dialog,
 
         ret = FALSE;
 
+        if (dialog->priv->benchmark != NULL) {
+                if (out_progress != NULL)
+                        *out_progress = mdu_benchmark_get_progress (dialog->priv->benchmark) * 100.0;
+                ret = TRUE;
+                goto out;
+        }
+
         d = mdu_dialog_get_device (MDU_DIALOG (dialog));
         if (!mdu_device_job_in_progress (d))
                 goto out;
@@ -1216,10 +2369,174 @@ is_benchmarking (MduDriveBenchmarkDialog *dialog,
         return ret;
 }
 
+static gchar *
+get_latency_for_display (gdouble secs)
+{
+        if (secs < 0.001) {
+                /* Translators: A latency, %.0f is the number of microseconds */
+                return g_strdup_printf (_("%.0f µs"), secs * 1000000.0);
+        } else {
+                /* Translators: A latency, %.1f is the number of milliseconds */
+                return g_strdup_printf (_("%.1f ms"), secs * 1000.0);
+        }
+}
+
+static gchar *
+get_percentiles_for_display (const MduBenchmarkHistogram *histogram)
+{
+        gchar *p50;
+        gchar *p99;
+        gchar *p999;
+        gchar *ret;
+
+        p50 = get_latency_for_display (mdu_benchmark_histogram_get_percentile (histogram, 50.0));
+        p99 = get_latency_for_display (mdu_benchmark_histogram_get_percentile (histogram, 99.0));
+        p999 = get_latency_for_display (mdu_benchmark_histogram_get_percentile (histogram, 99.9));
+        /* Translators: Latency percentiles, each %s is a latency, e.g. "0.2 ms" */
+        ret = g_strdup_printf (_("p50 %s, p99 %s, p99.9 %s"), p50, p99, p999);
+        g_free (p50);
+        g_free (p99);
+        g_free (p999);
+
+        return ret;
+}
+
+static gchar *
+get_regression_for_display (const MduBenchmarkRegression *regression,
+                            guint64                       disk_size,
+                            gboolean                      long_string)
+{
+        gchar *ret;
+        gchar *value;
+        gchar *baseline_value;
+        gint change;
+        gint start;
+        gint end;
+
+        change = (gint) (100.0 * (regression->value - regression->baseline_value) / regression->baseline_value);
+        start = (gint) (100.0 * regression->start_offset / disk_size);
+        end = (gint) (100.0 * regression->end_offset / disk_size);
+
+        if (regression->kind == MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME) {
+                value = get_latency_for_display (regression->value);
+                baseline_value = get_latency_for_display (regression->baseline_value);
+        } else {
+                value = mdu_util_get_speed_for_display (regression->value);
+                baseline_value = mdu_util_get_speed_for_display (regression->baseline_value);
+        }
+
+        switch (regression->kind) {
+        case MDU_BENCHMARK_REGRESSION_KIND_READ_RATE:
+                if (long_string) {
+                        /* Translators: Describes a drop in read rate found by comparing benchmark runs.
+                         * First %s is the rate measured, second %s the usual rate (e.g. "80 MB/s").
+                         * The %d are the range of the drive, in percent.
+                         */
+                        ret = g_strdup_printf (_("Read rate %s instead of %s at %d%%–%d%%"),
+                                               value, baseline_value, start, end);
+                } else {
+                        /* Translators: Short form of the above, %+d is the change in percent, e.g. -35 */
+                        ret = g_strdup_printf (_("Read %+d%% at %d%%–%d%%"), change, start, end);
+                }
+                break;
+        case MDU_BENCHMARK_REGRESSION_KIND_WRITE_RATE:
+                if (long_string) {
+                        /* Translators: Like the read rate above */
+                        ret = g_strdup_printf (_("Write rate %s instead of %s at %d%%–%d%%"),
+                                               value, baseline_value, start, end);
+                } else {
+                        /* Translators: Like the read rate above */
+                        ret = g_strdup_printf (_("Write %+d%% at %d%%–%d%%"), change, start, end);
+                }
+                break;
+        default:
+                if (long_string) {
+                        /* Translators: Like the read rate above, the %s are e.g. "12.1 ms" */
+                        ret = g_strdup_printf (_("Access time %s instead of %s at %d%%–%d%%"),
+                                               value, baseline_value, start, end);
+                } else {
+                        /* Translators: Like the read rate above */
+                        ret = g_strdup_printf (_("Access time %+d%% at %d%%–%d%%"), change, start, end);
+                }
+                break;
+        }
+
+        g_free (value);
+        g_free (baseline_value);
+        return ret;
+}
+
+static void
+update_regressions_element (MduDriveBenchmarkDialog *dialog)
+{
+        GString *text;
+        GString *tooltip;
+        guint64 disk_size;
+        gchar *s;
+        guint n;
+
+        if (dialog->priv->regressions == NULL || dialog->priv->num_baseline_runs < MIN_BASELINE_RUNS) {
+                mdu_details_element_set_text (dialog->priv->regressions_element, "–");
+                mdu_details_element_set_tooltip (dialog->priv->regressions_element,
+                                                 _("Regressions are looked for once there are at least three "
+                                                   "earlier benchmarks with the same settings"));
+                goto out;
+        }
+
+        if (dialog->priv->regressions->len == 0) {
+                /* Translators: Shown when the last benchmark is in line with the earlier ones */
+                mdu_details_element_set_text (dialog->priv->regressions_element, _("None"));
+                s = g_strdup_printf (dngettext (GETTEXT_PACKAGE,
+                                                "Compared with %d earlier benchmark",
+                                                "Compared with %d earlier benchmarks",
+                                                dialog->priv->num_baseline_runs),
+                                     dialog->priv->num_baseline_runs);
+                mdu_details_element_set_tooltip (dialog->priv->regressions_element, s);
+                g_free (s);
+                goto out;
+        }
+
+        disk_size = dialog->priv->benchmark_data != NULL ? dialog->priv->benchmark_data->disk_size : 0;
+        if (disk_size == 0)
+                disk_size = mdu_device_get_size (mdu_dialog_get_device (MDU_DIALOG (dialog)));
+
+        text = g_string_new (NULL);
+        tooltip = g_string_new (NULL);
+        g_string_append_printf (tooltip,
+                                dngettext (GETTEXT_PACKAGE,
+                                           "Significantly worse than the last %d benchmark with the same settings:",
+                                           "Significantly worse than the last %d benchmarks with the same settings:",
+                                           dialog->priv->num_baseline_runs),
+                                dialog->priv->num_baseline_runs);
+        for (n = 0; n < dialog->priv->regressions->len; n++) {
+                MduBenchmarkRegression *regression = &g_array_index (dialog->priv->regressions,
+                                                                     MduBenchmarkRegression,
+                                                                     n);
+                if (n > 0)
+                        g_string_append (text, ", ");
+                s = get_regression_for_display (regression, disk_size, FALSE);
+                g_string_append (text, s);
+                g_free (s);
+
+                s = get_regression_for_display (regression, disk_size, TRUE);
+                g_string_append_c (tooltip, '\n');
+                g_string_append (tooltip, s);
+                g_free (s);
+        }
+        mdu_details_element_set_text (dialog->priv->regressions_element, text->str);
+        mdu_details_element_set_tooltip (dialog->priv->regressions_element, tooltip->str);
+        g_string_free (text, TRUE);
+        g_string_free (tooltip, TRUE);
+
+ out:
+        ;
+}
+
 static void
 update_dialog (MduDriveBenchmarkDialog *dialog)
 {
         gdouble progress;
+        guint n;
 
         if (dialog->priv->deleted)
                 goto out;
@@ -1235,6 +2552,14 @@ update_dialog (MduDriveBenchmarkDialog *dialog)
                 /* Translators: This is used for the "Last Benchmark" element when we don't have benchmark data */
                 mdu_details_element_set_text (dialog->priv->updated_element, _("Never"));
                 mdu_details_element_set_text (dialog->priv->access_avg_element, "–");
+                mdu_details_element_set_text (dialog->priv->access_percentiles_element, "–");
+                for (n = 0; n < G_N_ELEMENTS (iops_queue_depths); n++) {
+                        mdu_details_element_set_text (dialog->priv->iops_elements[n], "–");
+                        mdu_details_element_set_tooltip (dialog->priv->iops_elements[n], NULL);
+                }
+                mdu_details_element_set_text (dialog->priv->optimal_block_size_element, "–");
+                mdu_details_element_set_tooltip (dialog->priv->optimal_block_size_element, NULL);
+                gtk_widget_hide (dialog->priv->sweep_drawing_area);
                 mdu_details_element_set_time (dialog->priv->updated_element, 0);
         } else {
                 gdouble read_min;
@@ -1246,19 +2571,19 @@ update_dialog (MduDriveBenchmarkDialog *dialog)
                 gdouble access_avg;
                 gchar *s;
 
-                benchmark_get_max_min_avg (dialog->priv->benchmark_data->read_transfer_rate_samples,
-                                           &read_max,
-                                           &read_min,
-                                           &read_avg);
-                benchmark_get_max_min_avg (dialog->priv->benchmark_data->write_transfer_rate_samples,
-                                           &write_max,
-                                           &write_min,
-                                           &write_avg);
+                mdu_benchmark_samples_get_max_min_avg (dialog->priv->benchmark_data->read_transfer_rate_samples,
+                                                       &read_max,
+                                                       &read_min,
+                                                       &read_avg);
+                mdu_benchmark_samples_get_max_min_avg (dialog->priv->benchmark_data->write_transfer_rate_samples,
+                                                       &write_max,
+                                                       &write_min,
+                                                       &write_avg);
 
-                benchmark_get_max_min_avg (dialog->priv->benchmark_data->access_time_samples,
-                                           NULL,
-                                           NULL,
-                                           &access_avg);
+                mdu_benchmark_samples_get_max_min_avg (dialog->priv->benchmark_data->access_time_samples,
+                                                       NULL,
+                                                       NULL,
+                                                       &access_avg);
 
                 s = mdu_util_get_speed_for_display (read_min);
                 mdu_details_element_set_text (dialog->priv->read_min_element, s);
@@ -1289,10 +2614,109 @@ update_dialog (MduDriveBenchmarkDialog *dialog)
                 mdu_details_element_set_text (dialog->priv->access_avg_element, s);
                 g_free (s);
 
+                if (dialog->priv->benchmark_data->access_time_samples->len > 0) {
+                        MduBenchmarkHistogram *histogram;
+
+                        histogram = g_new0 (MduBenchmarkHistogram, 1);
+                        for (n = 0; n < dialog->priv->benchmark_data->access_time_samples->len; n++) {
+                                BenchmarkPoint *point = &g_array_index (dialog->priv->benchmark_data->access_time_samples,
+                                                                        BenchmarkPoint,
+                                                                        n);
+                                mdu_benchmark_histogram_add_value (histogram, point->value * G_USEC_PER_SEC);
+                        }
+                        s = get_percentiles_for_display (histogram);
+                        mdu_details_element_set_text (dialog->priv->access_percentiles_element, s);
+                        g_free (s);
+                        g_free (histogram);
+                } else {
+                        mdu_details_element_set_text (dialog->priv->access_percentiles_element, "–");
+                }
+
+                for (n = 0; n < G_N_ELEMENTS (iops_queue_depths); n++) {
+                        const MduBenchmarkIopsResult *result;
+                        gchar *percentiles;
+                        gchar *min_str;
+                        gchar *avg_str;
+                        gchar *max_str;
+
+                        result = benchmark_data_get_iops_result (dialog->priv->benchmark_data, iops_queue_depths[n]);
+                        if (result == NULL || result->latency.num_values == 0) {
+                                mdu_details_element_set_text (dialog->priv->iops_elements[n], "–");
+                                mdu_details_element_set_tooltip (dialog->priv->iops_elements[n], NULL);
+                                continue;
+                        }
+
+                        percentiles = get_percentiles_for_display (&result->latency);
+                        /* Translators: Result of the random read benchmark.
+                         * %.0f is the number of reads per second.
+                         * %s is the latency percentiles, e.g. "p50 0.2 ms, p99 1.1 ms, p99.9 4.0 ms"
+                         */
+                        s = g_strdup_printf (_("%.0f IOPS – %s"), result->iops, percentiles);
+                        mdu_details_element_set_text (dialog->priv->iops_elements[n], s);
+                        g_free (s);
+                        g_free (percentiles);
+
+                        min_str = get_latency_for_display (result->latency.min_usec / ((gdouble) G_USEC_PER_SEC));
+                        avg_str = get_latency_for_display (result->latency.sum_usec / ((gdouble) G_USEC_PER_SEC) /
+                                                           result->latency.num_values);
+                        max_str = get_latency_for_display (result->latency.max_usec / ((gdouble) G_USEC_PER_SEC));
+                        /* Translators: Tooltip for the result of the random read benchmark.
+                         * The %s are latencies, e.g. "0.2 ms"
+                         */
+                        s = g_strdup_printf (_("Latency: minimum %s, average %s, maximum %s"),
+                                             min_str, avg_str, max_str);
+                        mdu_details_element_set_tooltip (dialog->priv->iops_elements[n], s);
+                        g_free (s);
+                        g_free (min_str);
+                        g_free (avg_str);
+                        g_free (max_str);
+                }
+
+                if (dialog->priv->benchmark_data->optimal_block_size > 0) {
+                        gchar *size_str;
+                        gchar *speed_str;
+
+                        speed_str = NULL;
+                        for (n = 0; n < dialog->priv->benchmark_data->sweep_points->len; n++) {
+                                MduBenchmarkSweepPoint *point = &g_array_index (dialog->priv->benchmark_data->sweep_points,
+                                                                                MduBenchmarkSweepPoint,
+                                                                                n);
+                                if (point->block_size == dialog->priv->benchmark_data->optimal_block_size)
+                                        speed_str = mdu_util_get_speed_for_display (point->transfer_rate);
+                        }
+                        size_str = mdu_util_get_size_for_display (dialog->priv->benchmark_data->optimal_block_size, TRUE, FALSE);
+                        if (speed_str != NULL) {
+                                /* Translators: Result of the block size sweep.
+                                 * First %s is the request size, e.g. "512 KiB".
+                                 * Second %s is the read rate at that size, e.g. "120 MB/s".
+                                 */
+                                s = g_strdup_printf (_("%s (%s)"), size_str, speed_str);
+                        } else {
+                                s = g_strdup (size_str);
+                        }
+                        mdu_details_element_set_text (dialog->priv->optimal_block_size_element, s);
+                        mdu_details_element_set_tooltip (dialog->priv->optimal_block_size_element,
+                                                         _("The smallest request size reaching 95% of the highest "
+                                                           "read rate. Partitions and RAID chunks should be "
+                                                           "aligned to a multiple of this size."));
+                        g_free (s);
+                        g_free (size_str);
+                        g_free (speed_str);
+                } else {
+                        mdu_details_element_set_text (dialog->priv->optimal_block_size_element, "–");
+                        mdu_details_element_set_tooltip (dialog->priv->optimal_block_size_element, NULL);
+                }
+                if (dialog->priv->benchmark_data->sweep_points->len > 0)
+                        gtk_widget_show (dialog->priv->sweep_drawing_area);
+                else
+                        gtk_widget_hide (dialog->priv->sweep_drawing_area);
+
                 mdu_details_element_set_time (dialog->priv->updated_element,
                                               dialog->priv->benchmark_data->time_collected);
         }
 
+        update_regressions_element (dialog);
+
         if (is_benchmarking (dialog, &progress)) {
                 gdouble fraction;
 
@@ -1334,6 +2758,55 @@ on_device_changed (MduDevice *device,
                 update_dialog (dialog);
 }
 
+static void
+on_benchmark_progress_changed (MduBenchmark *benchmark,
+                               gpointer      user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+
+        if (!dialog->priv->deleted)
+                update_dialog (dialog);
+}
+
+static void
+on_benchmark_sample_added (MduBenchmark             *benchmark,
+                           MduBenchmarkSampleKind    kind,
+                           const MduBenchmarkSample *sample,
+                           gpointer                  user_data)
+{
+        MduDriveBenchmarkDialog *dialog = MDU_DRIVE_BENCHMARK_DIALOG (user_data);
+        BenchmarkPoint point;
+        GArray *samples;
+
+        if (dialog->priv->live_data == NULL)
+                goto out;
+
+        switch (kind) {
+        case MDU_BENCHMARK_SAMPLE_KIND_READ_TRANSFER_RATE:
+                samples = dialog->priv->live_data->read_transfer_rate_samples;
+                break;
+        case MDU_BENCHMARK_SAMPLE_KIND_WRITE_TRANSFER_RATE:
+                samples = dialog->priv->live_data->write_transfer_rate_samples;
+                break;
+        case MDU_BENCHMARK_SAMPLE_KIND_ACCESS_TIME:
+                samples = dialog->priv->live_data->access_time_samples;
+                break;
+        default:
+                g_warn_if_reached ();
+                goto out;
+        }
+
+        point.offset = sample->offset;
+        point.value = sample->value;
+        g_array_append_val (samples, point);
+
+        if (!dialog->priv->deleted)
+                graph_add_sample (dialog, kind, samples);
+
+ out:
+        ;
+}
+
 static void
 on_device_job_changed (MduDevice *device,
                        gpointer   user_data)
@@ -58,6 +58,8 @@ GType       mdu_drive_benchmark_dialog_get_type (void) G_GNUC_CONST;
 GtkWidget*  mdu_drive_benchmark_dialog_new      (GtkWindow *parent,
                                                  MduDrive  *drive);
 
+guint       mdu_drive_benchmark_dialog_get_optimal_block_size (MduPresentable *presentable);
+
 G_END_DECLS
 
 #endif /* __MDU_DRIVE_BENCHMARK_DIALOG_H */
@@ -0,0 +1,744 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-filesystem-benchmark-dialog.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <string.h>
+#include <time.h>
+
+#include "mdu-filesystem-benchmark-dialog.h"
+#include "mdu-details-table.h"
+#include "mdu-details-element.h"
+#include "mdu-button-element.h"
+#include "mdu-button-table.h"
+
+/* Measures a mounted filesystem through a temporary file, see
+ * MDU_BENCHMARK_MODE_FILESYSTEM. Runs are kept per filesystem UUID and
+ * the results are shown next to the latest raw benchmark of the drive
+ * the filesystem is on, so what encryption, LVM or RAID costs can be
+ * read off directly.
+ */
+
+/* order of the results of mdu_benchmark_get_iops_results() in MDU_BENCHMARK_MODE_FILESYSTEM */
+enum {
+        IOPS_RANDOM_READ,
+        IOPS_RANDOM_WRITE,
+        IOPS_FSYNC,
+        NUM_IOPS
+};
+
+/* the queue depth random reads are compared at, same as MDU_BENCHMARK_MODE_FILESYSTEM uses */
+#define COMPARE_QUEUE_DEPTH 32
+
+typedef struct {
+        guint64 time_collected;
+        gboolean direct_io;
+        gdouble read_rate;
+        gdouble write_rate;
+        MduBenchmarkIopsResult iops[NUM_IOPS];
+} Results;
+
+struct MduFilesystemBenchmarkDialogPrivate
+{
+        gboolean deleted;
+
+        /* NULL if the filesystem has no UUID to keep the results under */
+        MduBenchmarkHistory *history;
+
+        /* the latest run, if any */
+        gboolean have_results;
+        Results results;
+
+        /* the drive the filesystem is on and its latest raw results, 0 if not known */
+        gchar *drive_name;
+        gdouble drive_read_rate;
+        gdouble drive_write_rate;
+        gdouble drive_random_read_iops;
+        gchar *layers;
+
+        /* non-NULL while the benchmark is running */
+        MduBenchmark *benchmark;
+        GCancellable *cancellable;
+
+        MduDetailsElement *drive_element;
+        MduDetailsElement *layers_element;
+        MduDetailsElement *read_element;
+        MduDetailsElement *write_element;
+        MduDetailsElement *random_read_element;
+        MduDetailsElement *random_write_element;
+        MduDetailsElement *fsync_element;
+        MduDetailsElement *updated_element;
+        MduDetailsElement *status_element;
+        MduButtonElement *start_button;
+};
+
+G_DEFINE_TYPE (MduFilesystemBenchmarkDialog, mdu_filesystem_benchmark_dialog, MDU_TYPE_DIALOG)
+
+static void update_dialog (MduFilesystemBenchmarkDialog *dialog);
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+mdu_filesystem_benchmark_dialog_finalize (GObject *object)
+{
+        MduFilesystemBenchmarkDialog *dialog = MDU_FILESYSTEM_BENCHMARK_DIALOG (object);
+
+        /* a running benchmark holds a ref to the dialog so we never get here with one */
+        g_warn_if_fail (dialog->priv->benchmark == NULL);
+
+        if (dialog->priv->history != NULL)
+                g_object_unref (dialog->priv->history);
+        g_free (dialog->priv->drive_name);
+        g_free (dialog->priv->layers);
+
+        if (G_OBJECT_CLASS (mdu_filesystem_benchmark_dialog_parent_class)->finalize != NULL)
+                G_OBJECT_CLASS (mdu_filesystem_benchmark_dialog_parent_class)->finalize (object);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gdouble
+get_mean (const MduBenchmarkSample *samples,
+          guint                     num_samples)
+{
+        gdouble sum;
+        guint n;
+
+        if (num_samples == 0)
+                return 0.0;
+
+        sum = 0.0;
+        for (n = 0; n < num_samples; n++)
+                sum += samples[n].value;
+        return sum / num_samples;
+}
+
+static gboolean
+results_init_from_history_run (Results                      *results,
+                               const MduBenchmarkHistoryRun *run)
+{
+        if (run->mode != MDU_BENCHMARK_MODE_FILESYSTEM || run->num_iops_results < NUM_IOPS)
+                return FALSE;
+
+        memset (results, 0, sizeof (Results));
+        results->time_collected = run->time_collected;
+        results->direct_io = run->direct_io;
+        results->read_rate = get_mean (run->read_samples, run->num_read_samples);
+        results->write_rate = get_mean (run->write_samples, run->num_write_samples);
+        memcpy (results->iops, run->iops_results, NUM_IOPS * sizeof (MduBenchmarkIopsResult));
+        return TRUE;
+}
+
+static void
+load_history (MduFilesystemBenchmarkDialog *dialog)
+{
+        MduDevice *device;
+        MduBenchmarkHistoryRun run;
+        const gchar *uuid;
+        GError *error;
+        gint n;
+
+        device = mdu_dialog_get_device (MDU_DIALOG (dialog));
+        uuid = mdu_device_id_get_uuid (device);
+        if (uuid == NULL || strlen (uuid) == 0)
+                goto out;
+
+        error = NULL;
+        dialog->priv->history = mdu_benchmark_history_new_for_volume (uuid, &error);
+        if (dialog->priv->history == NULL) {
+                g_warning ("Error loading benchmark data: %s", error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        for (n = mdu_benchmark_history_get_num_runs (dialog->priv->history) - 1; n >= 0; n--) {
+                mdu_benchmark_history_get_run (dialog->priv->history, n, &run);
+                if (results_init_from_history_run (&dialog->priv->results, &run)) {
+                        dialog->priv->have_results = TRUE;
+                        break;
+                }
+        }
+
+ out:
+        ;
+}
+
+/* Finds the drive under the filesystem and what sits in between. Partitions
+ * don't count as a layer since they cost nothing; an LVM2 volume group may
+ * span several drives so there is nothing to compare with.
+ */
+static void
+find_drive (MduFilesystemBenchmarkDialog *dialog)
+{
+        MduPresentable *p;
+        MduPresentable *enclosing;
+        MduDevice *device;
+        MduDevice *drive_device;
+        MduBenchmarkHistory *history;
+        MduBenchmarkHistoryRun run;
+        GPtrArray *layers;
+        gint n;
+
+        layers = g_ptr_array_new ();
+        drive_device = NULL;
+        history = NULL;
+
+        p = g_object_ref (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+        while (p != NULL && !MDU_IS_DRIVE (p)) {
+                if (MDU_IS_LINUX_LVM2_VOLUME (p)) {
+                        /* Translators: A layer between a filesystem and the drive it is on */
+                        g_ptr_array_add (layers, _("LVM2"));
+                } else {
+                        device = mdu_presentable_get_device (p);
+                        if (device != NULL && mdu_device_is_luks_cleartext (device)) {
+                                /* Translators: A layer between a filesystem and the drive it is on */
+                                g_ptr_array_add (layers, _("Encryption"));
+                        }
+                        if (device != NULL)
+                                g_object_unref (device);
+                }
+                enclosing = mdu_presentable_get_enclosing_presentable (p);
+                g_object_unref (p);
+                p = enclosing;
+        }
+        if (p == NULL)
+                goto out;
+
+        if (MDU_IS_LINUX_MD_DRIVE (p)) {
+                /* Translators: A layer between a filesystem and the drive it is on */
+                g_ptr_array_add (layers, _("RAID"));
+        }
+
+        drive_device = mdu_presentable_get_device (p);
+        if (drive_device == NULL)
+                goto out;
+
+        dialog->priv->drive_name = mdu_presentable_get_vpd_name (p);
+
+        history = mdu_benchmark_history_new_for_drive (mdu_device_drive_get_vendor (drive_device),
+                                                       mdu_device_drive_get_model (drive_device),
+                                                       mdu_device_drive_get_serial (drive_device),
+                                                       mdu_device_drive_get_wwn (drive_device),
+                                                       NULL);
+        if (history == NULL)
+                goto out;
+
+        /* the newest result of each kind, like the drive benchmark dialog shows */
+        for (n = mdu_benchmark_history_get_num_runs (history) - 1; n >= 0; n--) {
+                guint m;
+
+                mdu_benchmark_history_get_run (history, n, &run);
+                if (dialog->priv->drive_read_rate == 0.0 && run.num_read_samples > 0 &&
+                    (run.mode == MDU_BENCHMARK_MODE_TRANSFER_RATE || run.mode == MDU_BENCHMARK_MODE_SEQUENTIAL))
+                        dialog->priv->drive_read_rate = get_mean (run.read_samples, run.num_read_samples);
+                if (dialog->priv->drive_write_rate == 0.0 && run.num_write_samples > 0)
+                        dialog->priv->drive_write_rate = get_mean (run.write_samples, run.num_write_samples);
+                if (dialog->priv->drive_random_read_iops == 0.0 && run.mode == MDU_BENCHMARK_MODE_RANDOM) {
+                        for (m = 0; m < run.num_iops_results; m++) {
+                                if (run.iops_results[m].queue_depth == COMPARE_QUEUE_DEPTH)
+                                        dialog->priv->drive_random_read_iops = run.iops_results[m].iops;
+                        }
+                }
+        }
+
+ out:
+        if (layers->len > 0) {
+                g_ptr_array_add (layers, NULL);
+                /* Translators: Separates the layers between a filesystem and its drive, e.g. "Encryption, LVM2" */
+                dialog->priv->layers = g_strjoinv (_(", "), (gchar **) layers->pdata);
+        }
+        g_ptr_array_free (layers, TRUE);
+        if (history != NULL)
+                g_object_unref (history);
+        if (drive_device != NULL)
+                g_object_unref (drive_device);
+        if (p != NULL)
+                g_object_unref (p);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+append_to_history (MduFilesystemBenchmarkDialog *dialog,
+                   MduBenchmark                 *benchmark)
+{
+        MduBenchmarkHistoryRun run;
+        GError *error;
+
+        mdu_benchmark_history_run_init_from_benchmark (&run, benchmark, MDU_BENCHMARK_FLAGS_WRITE);
+        dialog->priv->have_results = results_init_from_history_run (&dialog->priv->results, &run);
+
+        if (dialog->priv->history == NULL)
+                goto out;
+
+        error = NULL;
+        if (!mdu_benchmark_history_append_run (dialog->priv->history, &run, &error)) {
+                g_warning ("Error saving benchmark data: %s", error->message);
+                g_error_free (error);
+        }
+
+ out:
+        ;
+}
+
+static void
+on_benchmark_progress_changed (MduBenchmark *benchmark,
+                               gpointer      user_data)
+{
+        MduFilesystemBenchmarkDialog *dialog = MDU_FILESYSTEM_BENCHMARK_DIALOG (user_data);
+
+        update_dialog (dialog);
+}
+
+static void
+benchmark_run_cb (GObject      *source_object,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+        MduFilesystemBenchmarkDialog *dialog = MDU_FILESYSTEM_BENCHMARK_DIALOG (user_data);
+        MduBenchmark *benchmark = MDU_BENCHMARK (source_object);
+        GtkWidget *error_dialog;
+        GError *error;
+
+        g_signal_handlers_disconnect_by_func (benchmark, on_benchmark_progress_changed, dialog);
+
+        error = NULL;
+        if (mdu_benchmark_run_finish (benchmark, res, &error))
+                append_to_history (dialog, benchmark);
+
+        dialog->priv->benchmark = NULL;
+        g_object_unref (benchmark);
+        g_object_unref (dialog->priv->cancellable);
+        dialog->priv->cancellable = NULL;
+
+        if (dialog->priv->deleted)
+                goto out;
+
+        update_dialog (dialog);
+
+        if (error != NULL &&
+            !(error->domain == MDU_ERROR && error->code == MDU_ERROR_CANCELLED)) {
+                error_dialog = mdu_error_dialog_new (GTK_WINDOW (dialog),
+                                                     mdu_dialog_get_presentable (MDU_DIALOG (dialog)),
+                                                     _("Error benchmarking filesystem"),
+                                                     error);
+                gtk_widget_show_all (error_dialog);
+                gtk_window_present (GTK_WINDOW (error_dialog));
+                gtk_dialog_run (GTK_DIALOG (error_dialog));
+                gtk_widget_destroy (error_dialog);
+        }
+
+ out:
+        if (error != NULL)
+                g_error_free (error);
+        g_object_unref (dialog);
+}
+
+static void
+start_benchmark (MduFilesystemBenchmarkDialog *dialog)
+{
+        const gchar *mount_path;
+
+        g_warn_if_fail (dialog->priv->benchmark == NULL);
+
+        mount_path = mdu_device_get_mount_path (mdu_dialog_get_device (MDU_DIALOG (dialog)));
+        if (mount_path == NULL)
+                goto out;
+
+        dialog->priv->cancellable = g_cancellable_new ();
+        dialog->priv->benchmark = mdu_benchmark_new (mount_path);
+        mdu_benchmark_set_mode (dialog->priv->benchmark, MDU_BENCHMARK_MODE_FILESYSTEM);
+        g_signal_connect (dialog->priv->benchmark,
+                          "progress-changed",
+                          G_CALLBACK (on_benchmark_progress_changed),
+                          dialog);
+        mdu_benchmark_run_async (dialog->priv->benchmark,
+                                 MDU_BENCHMARK_FLAGS_NONE,
+                                 dialog->priv->cancellable,
+                                 benchmark_run_cb,
+                                 g_object_ref (dialog));
+
+        update_dialog (dialog);
+
+ out:
+        ;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+on_start_clicked (MduButtonElement *button_element,
+                  gpointer          user_data)
+{
+        MduFilesystemBenchmarkDialog *dialog = MDU_FILESYSTEM_BENCHMARK_DIALOG (user_data);
+
+        if (dialog->priv->benchmark == NULL)
+                start_benchmark (dialog);
+}
+
+static void
+on_status_element_activated (MduDetailsElement    *element,
+                             const gchar          *uri,
+                             gpointer              user_data)
+{
+        MduFilesystemBenchmarkDialog *dialog = MDU_FILESYSTEM_BENCHMARK_DIALOG (user_data);
+
+        if (dialog->priv->cancellable != NULL)
+                g_cancellable_cancel (dialog->priv->cancellable);
+}
+
+static gboolean
+on_delete_event (GtkWidget *widget,
+                 GdkEvent  *event,
+                 gpointer   user_data)
+{
+        MduFilesystemBenchmarkDialog *dialog = MDU_FILESYSTEM_BENCHMARK_DIALOG (user_data);
+
+        dialog->priv->deleted = TRUE;
+
+        /* don't keep writing to the filesystem from a thread no-one can see */
+        if (dialog->priv->cancellable != NULL)
+                g_cancellable_cancel (dialog->priv->cancellable);
+
+        return FALSE; /* propagate further */
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+mdu_filesystem_benchmark_dialog_constructed (GObject *object)
+{
+        MduFilesystemBenchmarkDialog *dialog = MDU_FILESYSTEM_BENCHMARK_DIALOG (object);
+        GtkWidget *content_area;
+        GtkWidget *align;
+        GtkWidget *vbox;
+        GtkWidget *table;
+        GPtrArray *elements;
+        MduButtonElement *button_element;
+        MduDetailsElement *element;
+        gchar *s;
+        gchar *name;
+        gchar *vpd_name;
+
+        g_signal_connect (dialog,
+                          "delete-event",
+                          G_CALLBACK (on_delete_event),
+                          dialog);
+
+        load_history (dialog);
+        find_drive (dialog);
+
+        name = mdu_presentable_get_name (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+        vpd_name = mdu_presentable_get_vpd_name (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+        /* Translators: The title of the filesystem benchmark dialog.
+         * First %s is the name for the volume (e.g. "Home")
+         * Second %s is the VPD name for the volume (e.g. "42 GB ext4")
+         */
+        s = g_strdup_printf (_("%s (%s) – Benchmark Filesystem"), name, vpd_name);
+        gtk_window_set_title (GTK_WINDOW (dialog), s);
+        g_free (s);
+        g_free (vpd_name);
+        g_free (name);
+
+        content_area = gtk_dialog_get_content_area (GTK_DIALOG (dialog));
+
+        align = gtk_alignment_new (0.5, 0.5, 1.0, 1.0);
+        gtk_alignment_set_padding (GTK_ALIGNMENT (align), 12, 12, 12, 12);
+        gtk_box_pack_start (GTK_BOX (content_area), align, TRUE, TRUE, 0);
+
+        vbox = gtk_vbox_new (FALSE, 12);
+        gtk_container_add (GTK_CONTAINER (align), vbox);
+
+        elements = g_ptr_array_new_with_free_func (g_object_unref);
+
+        element = mdu_details_element_new (_("Drive:"), NULL,
+                                           _("The drive the filesystem is on. The results are compared "
+                                             "with the latest benchmark of the drive"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->drive_element = element;
+
+        element = mdu_details_element_new (_("Layers:"), NULL,
+                                           _("What is between the filesystem and the drive"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->layers_element = element;
+
+        element = mdu_details_element_new (_("Sequential Read:"), NULL,
+                                           _("The average rate of reading the test file"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->read_element = element;
+
+        element = mdu_details_element_new (_("Sequential Write:"), NULL,
+                                           _("The average rate of writing the test file, including "
+                                             "the time to flush it to the drive"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->write_element = element;
+
+        s = g_strdup_printf (_("Random Reads (QD%u):"), COMPARE_QUEUE_DEPTH);
+        element = mdu_details_element_new (s, NULL,
+                                           _("4 KiB reads at random offsets of the test file"));
+        g_free (s);
+        g_ptr_array_add (elements, element);
+        dialog->priv->random_read_element = element;
+
+        s = g_strdup_printf (_("Random Writes (QD%u):"), COMPARE_QUEUE_DEPTH);
+        element = mdu_details_element_new (s, NULL,
+                                           _("4 KiB writes at random offsets of the test file, including "
+                                             "the time to flush them to the drive"));
+        g_free (s);
+        g_ptr_array_add (elements, element);
+        dialog->priv->random_write_element = element;
+
+        element = mdu_details_element_new (_("Sync Latency:"), NULL,
+                                           _("How long writing 4 KiB and waiting for it to reach the "
+                                             "drive with fsync() takes, like a database committing"));
+        g_ptr_array_add (elements, element);
+        dialog->priv->fsync_element = element;
+
+        element = mdu_details_element_new (_("Last Benchmark:"), NULL, NULL);
+        g_ptr_array_add (elements, element);
+        dialog->priv->updated_element = element;
+
+        element = mdu_details_element_new (_("Status:"), NULL, NULL);
+        g_ptr_array_add (elements, element);
+        dialog->priv->status_element = element;
+        g_signal_connect (element,
+                          "activated",
+                          G_CALLBACK (on_status_element_activated),
+                          dialog);
+
+        table = mdu_details_table_new (1, elements);
+        g_ptr_array_unref (elements);
+        gtk_box_pack_start (GTK_BOX (vbox), table, FALSE, FALSE, 0);
+
+        elements = g_ptr_array_new_with_free_func (g_object_unref);
+
+        button_element = mdu_button_element_new ("gtk-execute",
+                                                 _("Start _Benchmark"),
+                                                 _("Write, read and sync a temporary file on the filesystem. "
+                                                   "Up to 1 GB of free space is used, the file is deleted "
+                                                   "when done"));
+        g_signal_connect (button_element,
+                          "clicked",
+                          G_CALLBACK (on_start_clicked),
+                          dialog);
+        g_ptr_array_add (elements, button_element);
+        dialog->priv->start_button = button_element;
+
+        table = mdu_button_table_new (2, elements);
+        g_ptr_array_unref (elements);
+        gtk_box_pack_start (GTK_BOX (vbox), table, FALSE, FALSE, 0);
+
+        update_dialog (dialog);
+
+        if (G_OBJECT_CLASS (mdu_filesystem_benchmark_dialog_parent_class)->constructed != NULL)
+                G_OBJECT_CLASS (mdu_filesystem_benchmark_dialog_parent_class)->constructed (object);
+}
+
+static void
+mdu_filesystem_benchmark_dialog_class_init (MduFilesystemBenchmarkDialogClass *klass)
+{
+        GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+        g_type_class_add_private (klass, sizeof (MduFilesystemBenchmarkDialogPrivate));
+
+        object_class->constructed  = mdu_filesystem_benchmark_dialog_constructed;
+        object_class->finalize     = mdu_filesystem_benchmark_dialog_finalize;
+}
+
+static void
+mdu_filesystem_benchmark_dialog_init (MduFilesystemBenchmarkDialog *dialog)
+{
+        dialog->priv = G_TYPE_INSTANCE_GET_PRIVATE (dialog, MDU_TYPE_FILESYSTEM_BENCHMARK_DIALOG, MduFilesystemBenchmarkDialogPrivate);
+}
+
+GtkWidget *
+mdu_filesystem_benchmark_dialog_new (GtkWindow *parent,
+                                     MduVolume *volume)
+{
+        return GTK_WIDGET (g_object_new (MDU_TYPE_FILESYSTEM_BENCHMARK_DIALOG,
+                                         "transient-for", parent,
+                                         "presentable", volume,
+                                         NULL));
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gchar *
+get_latency_for_display (gdouble secs)
+{
+        if (secs < 0.001) {
+                /* Translators: A latency, %.0f is the number of microseconds */
+                return g_strdup_printf (_("%.0f µs"), secs * 1000000.0);
+        } else {
+                /* Translators: A latency, %.1f is the number of milliseconds */
+                return g_strdup_printf (_("%.1f ms"), secs * 1000.0);
+        }
+}
+
+/* Appends how @value compares with what the drive does on its own, if known */
+static gchar *
+get_compared_for_display (gchar   *value_str,
+                          gdouble  value,
+                          gdouble  drive_value)
+{
+        gchar *ret;
+
+        if (drive_value <= 0.0)
+                return value_str;
+
+        /* Translators: A filesystem benchmark result compared with the raw drive.
+         * %s is the result, e.g. "120.5 MB/s" or "8000 IOPS"
+         * %+.0f is the difference in percent, e.g. "-12"
+         */
+        ret = g_strdup_printf (_("%s (%+.0f%% vs. drive)"),
+                               value_str,
+                               100.0 * (value - drive_value) / drive_value);
+        g_free (value_str);
+        return ret;
+}
+
+static void
+set_iops_for_display (MduDetailsElement            *element,
+                      const MduBenchmarkIopsResult *result,
+                      gdouble                       drive_iops)
+{
+        gchar *p99;
+        gchar *s;
+
+        if (result->latency.num_values == 0) {
+                mdu_details_element_set_text (element, "–");
+                return;
+        }
+
+        p99 = get_latency_for_display (mdu_benchmark_histogram_get_percentile (&result->latency, 99.0));
+        /* Translators: Result of a random I/O benchmark.
+         * %.0f is the number of requests per second.
+         * %s is the 99th percentile of the latency, e.g. "1.1 ms"
+         */
+        s = g_strdup_printf (_("%.0f IOPS – p99 %s"), result->iops, p99);
+        s = get_compared_for_display (s, result->iops, drive_iops);
+        mdu_details_element_set_text (element, s);
+        g_free (s);
+        g_free (p99);
+}
+
+static void
+update_dialog (MduFilesystemBenchmarkDialog *dialog)
+{
+        Results *results = &dialog->priv->results;
+        gchar time_buf[256];
+        time_t t;
+        gchar *s;
+        gchar *avg_str;
+        gchar *p99_str;
+
+        if (dialog->priv->deleted)
+                goto out;
+
+        if (dialog->priv->drive_name != NULL) {
+                mdu_details_element_set_text (dialog->priv->drive_element, dialog->priv->drive_name);
+        } else {
+                mdu_details_element_set_text (dialog->priv->drive_element, "–");
+        }
+        /* Translators: Shown when there is nothing between a filesystem and its drive except a partition */
+        mdu_details_element_set_text (dialog->priv->layers_element,
+                                      dialog->priv->layers != NULL ? dialog->priv->layers : _("None"));
+
+        if (dialog->priv->have_results) {
+                s = mdu_util_get_speed_for_display (results->read_rate);
+                s = get_compared_for_display (s, results->read_rate, dialog->priv->drive_read_rate);
+                mdu_details_element_set_text (dialog->priv->read_element, s);
+                g_free (s);
+
+                s = mdu_util_get_speed_for_display (results->write_rate);
+                s = get_compared_for_display (s, results->write_rate, dialog->priv->drive_write_rate);
+                mdu_details_element_set_text (dialog->priv->write_element, s);
+                g_free (s);
+
+                set_iops_for_display (dialog->priv->random_read_element,
+                                      &results->iops[IOPS_RANDOM_READ],
+                                      dialog->priv->drive_random_read_iops);
+                /* the drive benchmark never writes at random */
+                set_iops_for_display (dialog->priv->random_write_element,
+                                      &results->iops[IOPS_RANDOM_WRITE],
+                                      0.0);
+
+                if (results->iops[IOPS_FSYNC].latency.num_values > 0) {
+                        const MduBenchmarkHistogram *latency = &results->iops[IOPS_FSYNC].latency;
+
+                        avg_str = get_latency_for_display (latency->sum_usec / ((gdouble) G_USEC_PER_SEC) /
+                                                           latency->num_values);
+                        p99_str = get_latency_for_display (mdu_benchmark_histogram_get_percentile (latency, 99.0));
+                        /* Translators: Result of the fsync() benchmark, each %s is a latency, e.g. "2.1 ms" */
+                        s = g_strdup_printf (_("average %s, p99 %s"), avg_str, p99_str);
+                        mdu_details_element_set_text (dialog->priv->fsync_element, s);
+                        g_free (s);
+                        g_free (avg_str);
+                        g_free (p99_str);
+                } else {
+                        mdu_details_element_set_text (dialog->priv->fsync_element, "–");
+                }
+
+                t = results->time_collected;
+                strftime (time_buf, sizeof time_buf, "%c", localtime (&t));
+                if (results->direct_io) {
+                        mdu_details_element_set_text (dialog->priv->updated_element, time_buf);
+                } else {
+                        /* Translators: When the filesystem was benchmarked, if it doesn't support O_DIRECT.
+                         * %s is the date and time.
+                         */
+                        s = g_strdup_printf (_("%s (through the page cache)"), time_buf);
+                        mdu_details_element_set_text (dialog->priv->updated_element, s);
+                        g_free (s);
+                }
+        } else {
+                mdu_details_element_set_text (dialog->priv->read_element, "–");
+                mdu_details_element_set_text (dialog->priv->write_element, "–");
+                mdu_details_element_set_text (dialog->priv->random_read_element, "–");
+                mdu_details_element_set_text (dialog->priv->random_write_element, "–");
+                mdu_details_element_set_text (dialog->priv->fsync_element, "–");
+                mdu_details_element_set_text (dialog->priv->updated_element, "–");
+        }
+
+        if (dialog->priv->benchmark != NULL) {
+                mdu_details_element_set_progress (dialog->priv->status_element,
+                                                  mdu_benchmark_get_progress (dialog->priv->benchmark));
+                mdu_details_element_set_text (dialog->priv->status_element, NULL);
+                mdu_details_element_set_action_text (dialog->priv->status_element,
+                                                     /* Translators: Text used in the hyperlink in the status
+                                                      * table to cancel the benchmark */
+                                                     _("Cancel"));
+                mdu_details_element_set_action_tooltip (dialog->priv->status_element,
+                                                        /* Translators: Tooptip for the "Cancel" hyperlink */
+                                                        _("Cancels the currently running benchmark"));
+        } else {
+                mdu_details_element_set_progress (dialog->priv->status_element, -1.0);
+                mdu_details_element_set_text (dialog->priv->status_element, _("Idle"));
+                mdu_details_element_set_action_text (dialog->priv->status_element, NULL);
+                mdu_details_element_set_action_tooltip (dialog->priv->status_element, NULL);
+        }
+
+        mdu_button_element_set_visible (dialog->priv->start_button, dialog->priv->benchmark == NULL);
+
+ out:
+        ;
+}
@@ -0,0 +1,653 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/*
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <string.h>
+
+#include "mdu-gtk.h"
+#include "mdu-fleet-model.h"
+
+/**
+ * SECTION:mdu-fleet-model
+ * @title: MduFleetModel
+ * @short_description: Per-host summary of a set of pools
+ *
+ * #MduFleetModel has one row per #MduPool with summary statistics for
+ * the host, see #MduFleetModelColumn.
+ *
+ * The statistics are maintained incrementally: each device contributes
+ * a fixed amount to the totals of its pool and when a device is added,
+ * removed or changed only that contribution is subtracted and re-added.
+ * Rows are updated from an idle handler so a burst of signals (e.g. a
+ * host with hundreds of devices connecting) results in a single row
+ * update.
+ */
+
+/* What a single device adds to the totals of its pool */
+typedef struct
+{
+        guint   num_drives;
+        guint64 capacity;
+        gint64  unallocated;    /* negative for partitions */
+        guint   num_degraded_arrays;
+        guint   num_smart_failures;
+        guint   num_jobs;
+} Counts;
+
+typedef struct
+{
+        MduPool *pool;
+        GtkTreeIter iter;
+
+        Counts totals;
+
+        /* object path -> Counts */
+        GHashTable *object_path_to_counts;
+
+        /* object path of partition -> object path of its slave */
+        GHashTable *partition_to_slave;
+        /* object path of slave -> set of object paths of its partitions */
+        GHashTable *slave_to_partitions;
+
+        gboolean dirty;
+} PoolSummary;
+
+struct MduFleetModelPrivate
+{
+        /* MduPool -> PoolSummary */
+        GHashTable *pool_to_summary;
+
+        guint flush_idle_id;
+};
+
+G_DEFINE_TYPE (MduFleetModel, mdu_fleet_model, GTK_TYPE_LIST_STORE)
+
+enum
+{
+        PROP_0,
+        PROP_POOLS,
+};
+
+static void on_device_added   (MduPool   *pool,
+                               MduDevice *device,
+                               gpointer   user_data);
+static void on_device_removed (MduPool   *pool,
+                               MduDevice *device,
+                               gpointer   user_data);
+static void on_device_changed (MduPool   *pool,
+                               MduDevice *device,
+                               gpointer   user_data);
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+pool_summary_free (PoolSummary *summary)
+{
+        g_hash_table_unref (summary->object_path_to_counts);
+        g_hash_table_unref (summary->partition_to_slave);
+        g_hash_table_unref (summary->slave_to_partitions);
+        g_object_unref (summary->pool);
+        g_free (summary);
+}
+
+static void
+disconnect_from_pool (MduFleetModel *model,
+                      MduPool       *pool)
+{
+        g_signal_handlers_disconnect_by_func (pool, on_device_added, model);
+        g_signal_handlers_disconnect_by_func (pool, on_device_removed, model);
+        g_signal_handlers_disconnect_by_func (pool, on_device_changed, model);
+}
+
+static void
+mdu_fleet_model_finalize (GObject *object)
+{
+        MduFleetModel *model = MDU_FLEET_MODEL (object);
+        GHashTableIter hash_iter;
+        MduPool *pool;
+
+        if (model->priv->flush_idle_id > 0)
+                g_source_remove (model->priv->flush_idle_id);
+
+        g_hash_table_iter_init (&hash_iter, model->priv->pool_to_summary);
+        while (g_hash_table_iter_next (&hash_iter, (gpointer) &pool, NULL))
+                disconnect_from_pool (model, pool);
+        g_hash_table_unref (model->priv->pool_to_summary);
+
+        if (G_OBJECT_CLASS (mdu_fleet_model_parent_class)->finalize != NULL)
+                G_OBJECT_CLASS (mdu_fleet_model_parent_class)->finalize (object);
+}
+
+static void
+mdu_fleet_model_set_property (GObject      *object,
+                              guint         prop_id,
+                              const GValue *value,
+                              GParamSpec   *pspec)
+{
+        MduFleetModel *model = MDU_FLEET_MODEL (object);
+
+        switch (prop_id) {
+        case PROP_POOLS:
+                mdu_fleet_model_set_pools (model, g_value_get_boxed (value));
+                break;
+
+        default:
+                G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+                break;
+        }
+}
+
+static void
+mdu_fleet_model_class_init (MduFleetModelClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        gobject_class->finalize     = mdu_fleet_model_finalize;
+        gobject_class->set_property = mdu_fleet_model_set_property;
+
+        g_type_class_add_private (klass, sizeof (MduFleetModelPrivate));
+
+        /**
+         * MduFleetModel:pools:
+         *
+         * The pools to summarize.
+         */
+        g_object_class_install_property (gobject_class,
+                                         PROP_POOLS,
+                                         g_param_spec_boxed ("pools",
+                                                             NULL,
+                                                             NULL,
+                                                             G_TYPE_PTR_ARRAY,
+                                                             G_PARAM_WRITABLE |
+                                                             G_PARAM_CONSTRUCT));
+}
+
+static void
+mdu_fleet_model_init (MduFleetModel *model)
+{
+        GType column_types[8];
+
+        model->priv = G_TYPE_INSTANCE_GET_PRIVATE (model,
+                                                   MDU_TYPE_FLEET_MODEL,
+                                                   MduFleetModelPrivate);
+
+        model->priv->pool_to_summary = g_hash_table_new_full (g_direct_hash,
+                                                              g_direct_equal,
+                                                              NULL,
+                                                              (GDestroyNotify) pool_summary_free);
+
+        column_types[0] = MDU_TYPE_POOL;
+        column_types[1] = G_TYPE_STRING;
+        column_types[2] = G_TYPE_UINT;
+        column_types[3] = G_TYPE_UINT64;
+        column_types[4] = G_TYPE_UINT64;
+        column_types[5] = G_TYPE_UINT;
+        column_types[6] = G_TYPE_UINT;
+        column_types[7] = G_TYPE_UINT;
+
+        gtk_list_store_set_column_types (GTK_LIST_STORE (model),
+                                         G_N_ELEMENTS (column_types),
+                                         column_types);
+}
+
+/**
+ * mdu_fleet_model_new:
+ * @pools: A #GPtrArray of #MduPool objects.
+ *
+ * Creates a new #MduFleetModel summarizing @pools.
+ *
+ * Returns: A #MduFleetModel. Free with g_object_unref().
+ */
+MduFleetModel *
+mdu_fleet_model_new (GPtrArray *pools)
+{
+        return MDU_FLEET_MODEL (g_object_new (MDU_TYPE_FLEET_MODEL,
+                                              "pools", pools,
+                                              NULL));
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gboolean
+is_counted_drive (MduDevice *device)
+{
+        /* Only count physical drives - RAID arrays, multipath devices and
+         * loop devices are backed by drives that are already counted
+         */
+        return mdu_device_is_drive (device) &&
+                !mdu_device_is_linux_md (device) &&
+                !mdu_device_is_linux_dmmp (device) &&
+                !mdu_device_is_linux_loop (device) &&
+                !mdu_device_is_optical_disc (device);
+}
+
+static void
+compute_counts (MduPool   *pool,
+                MduDevice *device,
+                Counts    *counts)
+{
+        memset (counts, '\0', sizeof (Counts));
+
+        if (is_counted_drive (device)) {
+                const gchar *usage;
+
+                counts->num_drives = 1;
+                if (mdu_device_is_media_available (device)) {
+                        counts->capacity = mdu_device_get_size (device);
+
+                        /* The whole drive is unallocated if it's blank; with a partition table
+                         * the partitions subtract from it, see below
+                         */
+                        usage = mdu_device_id_get_usage (device);
+                        if (mdu_device_is_partition_table (device) || usage == NULL || strlen (usage) == 0)
+                                counts->unallocated = mdu_device_get_size (device);
+                }
+
+                if (mdu_device_drive_ata_smart_get_is_available (device) &&
+                    mdu_device_drive_ata_smart_get_time_collected (device) > 0) {
+                        const gchar *status;
+
+                        /* same statuses as the notification daemon warns about */
+                        status = mdu_device_drive_ata_smart_get_status (device);
+                        if (g_strcmp0 (status, "BAD_SECTOR_MANY") == 0 ||
+                            g_strcmp0 (status, "BAD_ATTRIBUTE_NOW") == 0 ||
+                            g_strcmp0 (status, "BAD_STATUS") == 0)
+                                counts->num_smart_failures = 1;
+                }
+        }
+
+        if (mdu_device_is_partition (device)) {
+                gboolean is_logical;
+
+                /* logical partitions are inside the extended partition which is already subtracted */
+                is_logical = g_strcmp0 (mdu_device_partition_get_scheme (device), "mbr") == 0 &&
+                        mdu_device_partition_get_number (device) >= 5;
+                if (!is_logical) {
+                        MduDevice *slave;
+
+                        /* The drive may not have been added yet so only skip partitions
+                         * that are known to be on something that isn't counted
+                         */
+                        slave = mdu_pool_get_by_object_path (pool, mdu_device_partition_get_slave (device));
+                        if (slave == NULL || is_counted_drive (slave))
+                                counts->unallocated = - (gint64) mdu_device_partition_get_size (device);
+                        if (slave != NULL)
+                                g_object_unref (slave);
+                }
+        }
+
+        if (mdu_device_is_linux_md (device) && mdu_device_linux_md_is_degraded (device))
+                counts->num_degraded_arrays = 1;
+
+        if (mdu_device_job_in_progress (device))
+                counts->num_jobs = 1;
+}
+
+static void
+counts_add (Counts       *totals,
+            const Counts *counts,
+            gint          sign)
+{
+        totals->num_drives          += sign * (gint) counts->num_drives;
+        totals->capacity            += sign * (gint64) counts->capacity;
+        totals->unallocated         += sign * counts->unallocated;
+        totals->num_degraded_arrays += sign * (gint) counts->num_degraded_arrays;
+        totals->num_smart_failures  += sign * (gint) counts->num_smart_failures;
+        totals->num_jobs            += sign * (gint) counts->num_jobs;
+}
+
+static gboolean
+counts_equal (const Counts *a,
+              const Counts *b)
+{
+        return a->num_drives == b->num_drives &&
+                a->capacity == b->capacity &&
+                a->unallocated == b->unallocated &&
+                a->num_degraded_arrays == b->num_degraded_arrays &&
+                a->num_smart_failures == b->num_smart_failures &&
+                a->num_jobs == b->num_jobs;
+}
+
+/* records that @object_path is a partition on @slave, or no partition at all if @slave is %NULL */
+static void
+index_partition (PoolSummary *summary,
+                 const gchar *object_path,
+                 const gchar *slave)
+{
+        const gchar *old_slave;
+        GHashTable *partitions;
+
+        old_slave = g_hash_table_lookup (summary->partition_to_slave, object_path);
+        if (g_strcmp0 (old_slave, slave) == 0)
+                goto out;
+
+        if (old_slave != NULL) {
+                partitions = g_hash_table_lookup (summary->slave_to_partitions, old_slave);
+                g_hash_table_remove (partitions, object_path);
+                if (g_hash_table_size (partitions) == 0)
+                        g_hash_table_remove (summary->slave_to_partitions, old_slave);
+                g_hash_table_remove (summary->partition_to_slave, object_path);
+        }
+
+        if (slave != NULL) {
+                partitions = g_hash_table_lookup (summary->slave_to_partitions, slave);
+                if (partitions == NULL) {
+                        partitions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+                        g_hash_table_insert (summary->slave_to_partitions, g_strdup (slave), partitions);
+                }
+                g_hash_table_insert (partitions, g_strdup (object_path), NULL);
+                g_hash_table_insert (summary->partition_to_slave, g_strdup (object_path), g_strdup (slave));
+        }
+
+ out:
+        ;
+}
+
+static gboolean
+on_flush_idle (gpointer user_data)
+{
+        MduFleetModel *model = MDU_FLEET_MODEL (user_data);
+        GHashTableIter hash_iter;
+        PoolSummary *summary;
+
+        model->priv->flush_idle_id = 0;
+
+        g_hash_table_iter_init (&hash_iter, model->priv->pool_to_summary);
+        while (g_hash_table_iter_next (&hash_iter, NULL, (gpointer) &summary)) {
+                if (!summary->dirty)
+                        continue;
+                summary->dirty = FALSE;
+
+                gtk_list_store_set (GTK_LIST_STORE (model),
+                                    &summary->iter,
+                                    MDU_FLEET_MODEL_COLUMN_NUM_DRIVES, summary->totals.num_drives,
+                                    MDU_FLEET_MODEL_COLUMN_CAPACITY, summary->totals.capacity,
+                                    MDU_FLEET_MODEL_COLUMN_UNALLOCATED, (guint64) MAX (summary->totals.unallocated, 0),
+                                    MDU_FLEET_MODEL_COLUMN_NUM_DEGRADED_ARRAYS, summary->totals.num_degraded_arrays,
+                                    MDU_FLEET_MODEL_COLUMN_NUM_SMART_FAILURES, summary->totals.num_smart_failures,
+                                    MDU_FLEET_MODEL_COLUMN_NUM_JOBS, summary->totals.num_jobs,
+                                    -1);
+        }
+
+        return FALSE;
+}
+
+static void
+mark_dirty (MduFleetModel *model,
+            PoolSummary   *summary)
+{
+        summary->dirty = TRUE;
+        if (model->priv->flush_idle_id == 0)
+                model->priv->flush_idle_id = g_idle_add (on_flush_idle, model);
+}
+
+/* Returns TRUE if @device is new to @model or started or stopped being counted as a drive.
+ * This affects what the partitions on @device contribute, see compute_counts().
+ */
+static gboolean
+update_device (MduFleetModel *model,
+               MduPool       *pool,
+               MduDevice     *device,
+               gboolean       removed)
+{
+        PoolSummary *summary;
+        Counts *counts;
+        Counts new_counts;
+        const gchar *object_path;
+        gboolean ret;
+
+        ret = FALSE;
+
+        summary = g_hash_table_lookup (model->priv->pool_to_summary, pool);
+        if (summary == NULL)
+                goto out;
+
+        object_path = mdu_device_get_object_path (device);
+
+        counts = g_hash_table_lookup (summary->object_path_to_counts, object_path);
+        if (counts != NULL)
+                counts_add (&summary->totals, counts, -1);
+
+        if (removed) {
+                index_partition (summary, object_path, NULL);
+                if (counts != NULL)
+                        g_hash_table_remove (summary->object_path_to_counts, object_path);
+        } else {
+                index_partition (summary,
+                                 object_path,
+                                 mdu_device_is_partition (device) ? mdu_device_partition_get_slave (device) : NULL);
+
+                compute_counts (pool, device, &new_counts);
+                ret = counts == NULL || counts->num_drives != new_counts.num_drives;
+                if (counts == NULL) {
+                        counts = g_new (Counts, 1);
+                        g_hash_table_insert (summary->object_path_to_counts, g_strdup (object_path), counts);
+                } else if (counts_equal (counts, &new_counts)) {
+                        /* most changes (e.g. a job making progress) don't affect the summary */
+                        counts_add (&summary->totals, counts, 1);
+                        goto out;
+                }
+                *counts = new_counts;
+                counts_add (&summary->totals, counts, 1);
+        }
+
+        mark_dirty (model, summary);
+
+ out:
+        return ret;
+}
+
+/* recomputes the partitions on @device, e.g. when they were added before @device */
+static void
+update_partitions (MduFleetModel *model,
+                   MduPool       *pool,
+                   MduDevice     *device)
+{
+        PoolSummary *summary;
+        GHashTable *partitions;
+        GHashTableIter hash_iter;
+        const gchar *partition_object_path;
+        GList *devices;
+        GList *l;
+
+        if (!mdu_device_is_partition_table (device))
+                goto out;
+
+        summary = g_hash_table_lookup (model->priv->pool_to_summary, pool);
+        if (summary == NULL)
+                goto out;
+
+        partitions = g_hash_table_lookup (summary->slave_to_partitions, mdu_device_get_object_path (device));
+        if (partitions == NULL)
+                goto out;
+
+        /* collect the partitions first since updating them may update the index */
+        devices = NULL;
+        g_hash_table_iter_init (&hash_iter, partitions);
+        while (g_hash_table_iter_next (&hash_iter, (gpointer) &partition_object_path, NULL)) {
+                MduDevice *partition;
+
+                partition = mdu_pool_get_by_object_path (pool, partition_object_path);
+                if (partition != NULL)
+                        devices = g_list_prepend (devices, partition);
+        }
+        for (l = devices; l != NULL; l = l->next)
+                update_device (model, pool, MDU_DEVICE (l->data), FALSE);
+        g_list_foreach (devices, (GFunc) g_object_unref, NULL);
+        g_list_free (devices);
+
+ out:
+        ;
+}
+
+static void
+on_device_added (MduPool   *pool,
+                 MduDevice *device,
+                 gpointer   user_data)
+{
+        MduFleetModel *model = MDU_FLEET_MODEL (user_data);
+
+        if (update_device (model, pool, device, FALSE))
+                update_partitions (model, pool, device);
+}
+
+static void
+on_device_removed (MduPool   *pool,
+                   MduDevice *device,
+                   gpointer   user_data)
+{
+        update_device (MDU_FLEET_MODEL (user_data), pool, device, TRUE);
+}
+
+static void
+on_device_changed (MduPool   *pool,
+                   MduDevice *device,
+                   gpointer   user_data)
+{
+        MduFleetModel *model = MDU_FLEET_MODEL (user_data);
+
+        if (update_device (model, pool, device, FALSE))
+                update_partitions (model, pool, device);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+add_pool (MduFleetModel *model,
+          MduPool       *pool)
+{
+        PoolSummary *summary;
+        const gchar *ssh_address;
+        GList *devices;
+        GList *l;
+
+        summary = g_new0 (PoolSummary, 1);
+        summary->pool = g_object_ref (pool);
+        summary->object_path_to_counts = g_hash_table_new_full (g_str_hash,
+                                                                g_str_equal,
+                                                                g_free,
+                                                                g_free);
+        summary->partition_to_slave = g_hash_table_new_full (g_str_hash,
+                                                             g_str_equal,
+                                                             g_free,
+                                                             g_free);
+        summary->slave_to_partitions = g_hash_table_new_full (g_str_hash,
+                                                              g_str_equal,
+                                                              g_free,
+                                                              (GDestroyNotify) g_hash_table_unref);
+        g_hash_table_insert (model->priv->pool_to_summary, pool, summary);
+
+        ssh_address = mdu_pool_get_ssh_address (pool);
+        gtk_list_store_append (GTK_LIST_STORE (model), &summary->iter);
+        gtk_list_store_set (GTK_LIST_STORE (model),
+                            &summary->iter,
+                            MDU_FLEET_MODEL_COLUMN_POOL, pool,
+                            MDU_FLEET_MODEL_COLUMN_NAME, ssh_address != NULL ? ssh_address : g_get_host_name (),
+                            -1);
+
+        /* all devices are known at this point so, unlike for ::device-added, the
+         * partitions don't need to be updated again once their table is counted
+         */
+        devices = mdu_pool_get_devices (pool);
+        for (l = devices; l != NULL; l = l->next)
+                update_device (model, pool, MDU_DEVICE (l->data), FALSE);
+        g_list_foreach (devices, (GFunc) g_object_unref, NULL);
+        g_list_free (devices);
+
+        g_signal_connect (pool, "device-added", G_CALLBACK (on_device_added), model);
+        g_signal_connect (pool, "device-removed", G_CALLBACK (on_device_removed), model);
+        g_signal_connect (pool, "device-changed", G_CALLBACK (on_device_changed), model);
+        g_signal_connect (pool, "device-job-changed", G_CALLBACK (on_device_changed), model);
+}
+
+/**
+ * mdu_fleet_model_set_pools:
+ * @model: A #MduFleetModel.
+ * @pools: A #GPtrArray of #MduPool objects.
+ *
+ * Changes the pools summarized by @model. Pools that were already in
+ * @model keep their row and statistics; only the devices of pools new
+ * to @model are looked at.
+ */
+void
+mdu_fleet_model_set_pools (MduFleetModel *model,
+                           GPtrArray     *pools)
+{
+        GHashTableIter hash_iter;
+        GHashTable *new_pools;
+        PoolSummary *summary;
+        MduPool *pool;
+        guint n;
+
+        g_return_if_fail (MDU_IS_FLEET_MODEL (model));
+
+        new_pools = g_hash_table_new (g_direct_hash, g_direct_equal);
+        for (n = 0; pools != NULL && n < pools->len; n++)
+                g_hash_table_insert (new_pools, pools->pdata[n], pools->pdata[n]);
+
+        /* remove the pools that went away */
+        g_hash_table_iter_init (&hash_iter, model->priv->pool_to_summary);
+        while (g_hash_table_iter_next (&hash_iter, (gpointer) &pool, (gpointer) &summary)) {
+                if (g_hash_table_lookup (new_pools, pool) != NULL)
+                        continue;
+                disconnect_from_pool (model, pool);
+                gtk_list_store_remove (GTK_LIST_STORE (model), &summary->iter);
+                g_hash_table_iter_remove (&hash_iter);
+        }
+
+        /* and add the new ones, in order */
+        for (n = 0; pools != NULL && n < pools->len; n++) {
+                pool = MDU_POOL (pools->pdata[n]);
+                if (g_hash_table_lookup (model->priv->pool_to_summary, pool) == NULL)
+                        add_pool (model, pool);
+        }
+
+        g_hash_table_unref (new_pools);
+}
+
+/**
+ * mdu_fleet_model_get_iter_for_pool:
+ * @model: A #MduFleetModel.
+ * @pool: A #MduPool.
+ * @out_iter: Return location for the #GtkTreeIter.
+ *
+ * Gets the row for @pool.
+ *
+ * Returns: %TRUE if @out_iter was set, %FALSE if @pool is not in @model.
+ */
+gboolean
+mdu_fleet_model_get_iter_for_pool (MduFleetModel *model,
+                                   MduPool       *pool,
+                                   GtkTreeIter   *out_iter)
+{
+        PoolSummary *summary;
+
+        g_return_val_if_fail (MDU_IS_FLEET_MODEL (model), FALSE);
+
+        summary = g_hash_table_lookup (model->priv->pool_to_summary, pool);
+        if (summary == NULL)
+                return FALSE;
+
+        if (out_iter != NULL)
+                *out_iter = summary->iter;
+        return TRUE;
+}
@@ -0,0 +1,62 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/*
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#if !defined (__MDU_GTK_INSIDE_MDU_GTK_H) && !defined (MDU_GTK_COMPILATION)
+#error "Only <mdu-gtk/mdu-gtk.h> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef MDU_FLEET_MODEL_H
+#define MDU_FLEET_MODEL_H
+
+#include <mdu-gtk/mdu-gtk-types.h>
+
+#define MDU_TYPE_FLEET_MODEL             (mdu_fleet_model_get_type ())
+#define MDU_FLEET_MODEL(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), MDU_TYPE_FLEET_MODEL, MduFleetModel))
+#define MDU_FLEET_MODEL_CLASS(obj)       (G_TYPE_CHECK_CLASS_CAST ((obj), MDU_FLEET_MODEL,  MduFleetModelClass))
+#define MDU_IS_FLEET_MODEL(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MDU_TYPE_FLEET_MODEL))
+#define MDU_IS_FLEET_MODEL_CLASS(obj)    (G_TYPE_CHECK_CLASS_TYPE ((obj), MDU_TYPE_FLEET_MODEL))
+#define MDU_FLEET_MODEL_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), MDU_TYPE_FLEET_MODEL, MduFleetModelClass))
+
+typedef struct MduFleetModelClass       MduFleetModelClass;
+typedef struct MduFleetModelPrivate     MduFleetModelPrivate;
+
+struct MduFleetModel
+{
+        GtkListStore parent;
+
+        /* private */
+        MduFleetModelPrivate *priv;
+};
+
+struct MduFleetModelClass
+{
+        GtkListStoreClass parent_class;
+};
+
+
+GType          mdu_fleet_model_get_type          (void) G_GNUC_CONST;
+MduFleetModel *mdu_fleet_model_new               (GPtrArray     *pools);
+void           mdu_fleet_model_set_pools         (MduFleetModel *model,
+                                                  GPtrArray     *pools);
+gboolean       mdu_fleet_model_get_iter_for_pool (MduFleetModel *model,
+                                                  MduPool       *pool,
+                                                  GtkTreeIter   *out_iter);
+
+#endif /* MDU_FLEET_MODEL_H */
@@ -481,6 +481,7 @@ mdu_format_dialog_constructed (GObject *object)
         gchar *s;
         gchar *s2;
         GtkWidget *check_button;
+        guint optimal_block_size;
 
         ret = FALSE;
 
@@ -685,6 +686,30 @@ mdu_format_dialog_constructed (GObject *object)
 	gtk_box_pack_start (GTK_BOX (hbox), label, FALSE, FALSE, 0);
 #endif
 
+        /* if the drive has been through a block size sweep, point out what alignment works best */
+        optimal_block_size = mdu_drive_benchmark_dialog_get_optimal_block_size (mdu_dialog_get_presentable (MDU_DIALOG (dialog)));
+        if (optimal_block_size > 0) {
+                hbox = gtk_hbox_new (FALSE, 6);
+                gtk_box_pack_start (GTK_BOX (vbox2), hbox, FALSE, FALSE, 0);
+                image = gtk_image_new_from_stock (GTK_STOCK_DIALOG_INFO, GTK_ICON_SIZE_MENU);
+                gtk_misc_set_alignment (GTK_MISC (image), 0.5, 0.0);
+                gtk_box_pack_start (GTK_BOX (hbox), image, FALSE, FALSE, 0);
+                label = gtk_label_new (NULL);
+                s2 = mdu_util_get_size_for_display (optimal_block_size, TRUE, FALSE);
+                /* Translators: Shown in the format and create partition dialogs.
+                 * The %s is a size, e.g. "512 KiB".
+                 */
+                s = g_strdup_printf (_("The drive reads fastest with requests of %s or more. "
+                                       "Align partitions and filesystem stripes to a multiple of %s."),
+                                     s2, s2);
+                gtk_label_set_text (GTK_LABEL (label), s);
+                g_free (s);
+                g_free (s2);
+                gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+                gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+                gtk_box_pack_start (GTK_BOX (hbox), label, FALSE, FALSE, 0);
+        }
+
         /* nuke dialog if device is yanked */
         dialog->priv->removed_signal_handler_id = g_signal_connect (mdu_dialog_get_presentable (MDU_DIALOG (dialog)),
                                                                     "removed",
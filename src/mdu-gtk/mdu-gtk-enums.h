@@ -41,6 +41,8 @@
  * @MDU_POOL_TREE_MODEL_COLUMN_VISIBLE: Whether the item is visible.
  * @MDU_POOL_TREE_MODEL_COLUMN_TOGGLED: Whether the item is toggled.
  * @MDU_POOL_TREE_MODEL_COLUMN_CAN_BE_TOGGLED: Whether the item can be toggled.
+ * @MDU_POOL_TREE_MODEL_COLUMN_STATUS: Status line for the connection to a remote host, e.g. traffic
+ * and round-trip times. Only set for the #MduMachine of remote pools, %NULL otherwise.
  *
  * Columns used in #MduPoolTreeModel.
  */
@@ -53,6 +55,7 @@ typedef enum {
         MDU_POOL_TREE_MODEL_COLUMN_VISIBLE,
         MDU_POOL_TREE_MODEL_COLUMN_TOGGLED,
         MDU_POOL_TREE_MODEL_COLUMN_CAN_BE_TOGGLED,
+        MDU_POOL_TREE_MODEL_COLUMN_STATUS,
 } MduPoolTreeModelColumn;
 
 typedef enum {
@@ -119,4 +122,50 @@ typedef enum {
         MDU_ADD_COMPONENT_LINUX_MD_FLAGS_EXPANSION = (1<<1)
 } MduAddComponentLinuxMdFlags;
 
+/**
+ * MduHostDiscoveryColumn:
+ * @MDU_HOST_DISCOVERY_COLUMN_NAME: The DNS-SD service name, e.g. "Storage on fileserver".
+ * @MDU_HOST_DISCOVERY_COLUMN_HOST_NAME: The host name the service resolved to, e.g. "fileserver.local".
+ * @MDU_HOST_DISCOVERY_COLUMN_ADDRESS: The address the service resolved to or %NULL if not yet resolved.
+ * @MDU_HOST_DISCOVERY_COLUMN_PORT: The port the SSH server is listening on.
+ * @MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN: When the host was last seen, in seconds since the Epoch.
+ * @MDU_HOST_DISCOVERY_COLUMN_PRESENT: Whether the host is currently announced on the network.
+ *
+ * Columns used in the model returned by mdu_host_discovery_get_model().
+ */
+typedef enum {
+        MDU_HOST_DISCOVERY_COLUMN_NAME,
+        MDU_HOST_DISCOVERY_COLUMN_HOST_NAME,
+        MDU_HOST_DISCOVERY_COLUMN_ADDRESS,
+        MDU_HOST_DISCOVERY_COLUMN_PORT,
+        MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN,
+        MDU_HOST_DISCOVERY_COLUMN_PRESENT,
+} MduHostDiscoveryColumn;
+
+/**
+ * MduFleetModelColumn:
+ * @MDU_FLEET_MODEL_COLUMN_POOL: The #MduPool for the host.
+ * @MDU_FLEET_MODEL_COLUMN_NAME: The name of the host, e.g. "widget.mate.org".
+ * @MDU_FLEET_MODEL_COLUMN_NUM_DRIVES: Number of physical drives.
+ * @MDU_FLEET_MODEL_COLUMN_CAPACITY: Total size of the media in the physical drives, in bytes.
+ * @MDU_FLEET_MODEL_COLUMN_UNALLOCATED: Space on the physical drives not used by any partition or
+ * other content, in bytes.
+ * @MDU_FLEET_MODEL_COLUMN_NUM_DEGRADED_ARRAYS: Number of degraded RAID arrays.
+ * @MDU_FLEET_MODEL_COLUMN_NUM_SMART_FAILURES: Number of drives where ATA SMART data indicates the drive
+ * is failing.
+ * @MDU_FLEET_MODEL_COLUMN_NUM_JOBS: Number of devices with a job in progress.
+ *
+ * Columns used in #MduFleetModel.
+ */
+typedef enum {
+        MDU_FLEET_MODEL_COLUMN_POOL,
+        MDU_FLEET_MODEL_COLUMN_NAME,
+        MDU_FLEET_MODEL_COLUMN_NUM_DRIVES,
+        MDU_FLEET_MODEL_COLUMN_CAPACITY,
+        MDU_FLEET_MODEL_COLUMN_UNALLOCATED,
+        MDU_FLEET_MODEL_COLUMN_NUM_DEGRADED_ARRAYS,
+        MDU_FLEET_MODEL_COLUMN_NUM_SMART_FAILURES,
+        MDU_FLEET_MODEL_COLUMN_NUM_JOBS,
+} MduFleetModelColumn;
+
 #endif /* MDU_GTK_ENUMS_H */
@@ -62,7 +62,11 @@ typedef struct MduDiskSelectionWidget         MduDiskSelectionWidget;
 typedef struct MduAddComponentLinuxMdDialog   MduAddComponentLinuxMdDialog;
 typedef struct MduEditLinuxMdDialog           MduEditLinuxMdDialog;
 typedef struct MduDriveBenchmarkDialog        MduDriveBenchmarkDialog;
+typedef struct MduConcurrentBenchmarkDialog   MduConcurrentBenchmarkDialog;
+typedef struct MduFilesystemBenchmarkDialog   MduFilesystemBenchmarkDialog;
 typedef struct MduConnectToServerDialog       MduConnectToServerDialog;
+typedef struct MduHostDiscovery               MduHostDiscovery;
+typedef struct MduFleetModel                  MduFleetModel;
 typedef struct MduEditLinuxLvm2Dialog         MduEditLinuxLvm2Dialog;
 typedef struct MduAddPvLinuxLvm2Dialog        MduAddPvLinuxLvm2Dialog;
 
@@ -32,6 +32,7 @@
 #include <mdu-gtk/mdu-time-label.h>
 #include <mdu-gtk/mdu-pool-tree-view.h>
 #include <mdu-gtk/mdu-pool-tree-model.h>
+#include <mdu-gtk/mdu-fleet-model.h>
 #include <mdu-gtk/mdu-size-widget.h>
 #include <mdu-gtk/mdu-create-linux-md-dialog.h>
 #include <mdu-gtk/mdu-ata-smart-dialog.h>
@@ -54,7 +55,10 @@
 #include <mdu-gtk/mdu-edit-linux-md-dialog.h>
 #include <mdu-gtk/mdu-edit-linux-lvm2-dialog.h>
 #include <mdu-gtk/mdu-drive-benchmark-dialog.h>
+#include <mdu-gtk/mdu-concurrent-benchmark-dialog.h>
+#include <mdu-gtk/mdu-filesystem-benchmark-dialog.h>
 #include <mdu-gtk/mdu-connect-to-server-dialog.h>
+#include <mdu-gtk/mdu-host-discovery.h>
 #include <mdu-gtk/mdu-create-linux-lvm2-volume-dialog.h>
 #include <mdu-gtk/mdu-add-pv-linux-lvm2-dialog.h>
 #undef __MDU_GTK_INSIDE_MDU_GTK_H
@@ -0,0 +1,659 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/*
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+
+#include <avahi-client/client.h>
+#include <avahi-client/lookup.h>
+#include <avahi-common/error.h>
+#include <avahi-glib/glib-watch.h>
+#include <avahi-glib/glib-malloc.h>
+
+#include "mdu-host-discovery.h"
+
+/**
+ * SECTION:mdu-host-discovery
+ * @title: MduHostDiscovery
+ * @short_description: Discover hosts running udisks
+ *
+ * #MduHostDiscovery browses the network for hosts announcing the
+ * <literal>_udisks-ssh._tcp</literal> DNS-SD service for as long as
+ * the object is alive. Every announced service is resolved as soon as
+ * it shows up, all in parallel, so the address is usually known by the
+ * time the user gets to look at the list.
+ *
+ * Hosts are never removed from the model while the object is alive;
+ * instead the %MDU_HOST_DISCOVERY_COLUMN_PRESENT column is cleared
+ * when the host goes away. The list is persisted in the user cache
+ * directory so it can be shown instantly the next time, before the
+ * network has been browsed. Hosts that have not been seen for a
+ * month are dropped.
+ */
+
+#define SERVICE_TYPE "_udisks-ssh._tcp"
+
+/* Forget about hosts that haven't been seen for this long */
+#define MAX_AGE_DAYS 30
+
+/* Coalesce writes of the cache file */
+#define SAVE_DELAY_SECONDS 2
+
+/* While hosts are present, refresh their last-seen time this often */
+#define REFRESH_INTERVAL_SECONDS (5 * 60)
+
+struct MduHostDiscoveryPrivate
+{
+        GtkListStore *model;
+
+        /* service name -> GtkTreeIter* (iters persist in a GtkListStore) */
+        GHashTable *name_to_iter;
+
+        /* service name -> number of interface/protocol pairs the service is announced on */
+        GHashTable *name_to_num_instances;
+
+        AvahiGLibPoll *poll;
+        AvahiClient *client;
+        AvahiServiceBrowser *browser;
+
+        /* resolvers in flight */
+        GList *resolvers;
+
+        guint save_timeout_id;
+        guint refresh_timeout_id;
+};
+
+G_DEFINE_TYPE (MduHostDiscovery, mdu_host_discovery, G_TYPE_OBJECT);
+
+static MduHostDiscovery *the_discovery = NULL;
+
+static void load_cache           (MduHostDiscovery *discovery);
+static void save_cache           (MduHostDiscovery *discovery);
+static void stop_browsing        (MduHostDiscovery *discovery);
+static void on_client_state_changed (AvahiClient      *client,
+                                     AvahiClientState  state,
+                                     void             *user_data);
+
+static void
+mdu_host_discovery_finalize (GObject *object)
+{
+        MduHostDiscovery *discovery = MDU_HOST_DISCOVERY (object);
+
+        stop_browsing (discovery);
+        if (discovery->priv->client != NULL)
+                avahi_client_free (discovery->priv->client);
+        if (discovery->priv->poll != NULL)
+                avahi_glib_poll_free (discovery->priv->poll);
+
+        /* stop_browsing() schedules a save if hosts were present; we save right away instead */
+        if (discovery->priv->save_timeout_id > 0) {
+                g_source_remove (discovery->priv->save_timeout_id);
+                discovery->priv->save_timeout_id = 0;
+        }
+
+        /* this also records the last-seen time of the hosts still present */
+        save_cache (discovery);
+
+        g_hash_table_unref (discovery->priv->name_to_iter);
+        g_hash_table_unref (discovery->priv->name_to_num_instances);
+        g_object_unref (discovery->priv->model);
+
+        if (the_discovery == discovery)
+                the_discovery = NULL;
+
+        if (G_OBJECT_CLASS (mdu_host_discovery_parent_class)->finalize != NULL)
+                G_OBJECT_CLASS (mdu_host_discovery_parent_class)->finalize (object);
+}
+
+static void
+mdu_host_discovery_class_init (MduHostDiscoveryClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        gobject_class->finalize = mdu_host_discovery_finalize;
+
+        g_type_class_add_private (klass, sizeof (MduHostDiscoveryPrivate));
+}
+
+static void
+mdu_host_discovery_init (MduHostDiscovery *discovery)
+{
+        GType column_types[6];
+        int error;
+
+        discovery->priv = G_TYPE_INSTANCE_GET_PRIVATE (discovery,
+                                                       MDU_TYPE_HOST_DISCOVERY,
+                                                       MduHostDiscoveryPrivate);
+
+        column_types[0] = G_TYPE_STRING;
+        column_types[1] = G_TYPE_STRING;
+        column_types[2] = G_TYPE_STRING;
+        column_types[3] = G_TYPE_UINT;
+        column_types[4] = G_TYPE_UINT64;
+        column_types[5] = G_TYPE_BOOLEAN;
+        discovery->priv->model = gtk_list_store_newv (G_N_ELEMENTS (column_types), column_types);
+
+        discovery->priv->name_to_iter = g_hash_table_new_full (g_str_hash,
+                                                               g_str_equal,
+                                                               g_free,
+                                                               (GDestroyNotify) gtk_tree_iter_free);
+        discovery->priv->name_to_num_instances = g_hash_table_new_full (g_str_hash,
+                                                                        g_str_equal,
+                                                                        g_free,
+                                                                        NULL);
+
+        /* Populate from what we saw last time before touching the network */
+        load_cache (discovery);
+
+        avahi_set_allocator (avahi_glib_allocator ());
+        discovery->priv->poll = avahi_glib_poll_new (NULL, G_PRIORITY_DEFAULT);
+
+        /* With AVAHI_CLIENT_NO_FAIL the client waits for the daemon to
+         * appear (and reappear after restarts) instead of failing
+         */
+        discovery->priv->client = avahi_client_new (avahi_glib_poll_get (discovery->priv->poll),
+                                                    AVAHI_CLIENT_NO_FAIL,
+                                                    on_client_state_changed,
+                                                    discovery,
+                                                    &error);
+        if (discovery->priv->client == NULL) {
+                g_warning ("Error creating Avahi client: %s", avahi_strerror (error));
+        }
+}
+
+/**
+ * mdu_host_discovery_get_default:
+ *
+ * Gets the #MduHostDiscovery object shared by everything in the
+ * process, creating it and starting to browse the network if it
+ * doesn't exist already. Keep a reference for as long as discovery
+ * should keep running in the background.
+ *
+ * Returns: A #MduHostDiscovery. Free with g_object_unref().
+ */
+MduHostDiscovery *
+mdu_host_discovery_get_default (void)
+{
+        if (the_discovery == NULL) {
+                the_discovery = MDU_HOST_DISCOVERY (g_object_new (MDU_TYPE_HOST_DISCOVERY, NULL));
+        } else {
+                g_object_ref (the_discovery);
+        }
+        return the_discovery;
+}
+
+/**
+ * mdu_host_discovery_get_model:
+ * @discovery: A #MduHostDiscovery.
+ *
+ * Gets the model with the discovered hosts. See #MduHostDiscoveryColumn
+ * for the columns. The model is updated as hosts come and go.
+ *
+ * Returns: A #GtkTreeModel owned by @discovery. Do not free.
+ */
+GtkTreeModel *
+mdu_host_discovery_get_model (MduHostDiscovery *discovery)
+{
+        g_return_val_if_fail (MDU_IS_HOST_DISCOVERY (discovery), NULL);
+        return GTK_TREE_MODEL (discovery->priv->model);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gchar *
+get_cache_filename (void)
+{
+        return g_build_filename (g_get_user_cache_dir (),
+                                 "mate-disk-utility",
+                                 "discovered-hosts",
+                                 NULL);
+}
+
+static guint64
+get_now (void)
+{
+        GTimeVal now;
+
+        g_get_current_time (&now);
+        return now.tv_sec;
+}
+
+static void
+get_iter_for_name (MduHostDiscovery *discovery,
+                   const gchar      *name,
+                   GtkTreeIter      *out_iter)
+{
+        GtkTreeIter *iter;
+
+        iter = g_hash_table_lookup (discovery->priv->name_to_iter, name);
+        if (iter == NULL) {
+                GtkTreeIter new_iter;
+
+                gtk_list_store_append (discovery->priv->model, &new_iter);
+                gtk_list_store_set (discovery->priv->model, &new_iter,
+                                    MDU_HOST_DISCOVERY_COLUMN_NAME, name,
+                                    -1);
+                iter = gtk_tree_iter_copy (&new_iter);
+                g_hash_table_insert (discovery->priv->name_to_iter, g_strdup (name), iter);
+        }
+        *out_iter = *iter;
+}
+
+static void
+load_cache (MduHostDiscovery *discovery)
+{
+        GKeyFile *key_file;
+        gchar *filename;
+        gchar **groups;
+        guint64 now;
+        guint n;
+
+        groups = NULL;
+        now = get_now ();
+
+        filename = get_cache_filename ();
+        key_file = g_key_file_new ();
+        if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, NULL))
+                goto out;
+
+        groups = g_key_file_get_groups (key_file, NULL);
+        for (n = 0; groups != NULL && groups[n] != NULL; n++) {
+                const gchar *name = groups[n];
+                GtkTreeIter iter;
+                gchar *host_name;
+                gchar *address;
+                guint64 last_seen;
+                gint port;
+                gchar *s;
+
+                s = g_key_file_get_value (key_file, name, "LastSeen", NULL);
+                last_seen = s != NULL ? g_ascii_strtoull (s, NULL, 10) : 0;
+                g_free (s);
+                host_name = g_key_file_get_string (key_file, name, "HostName", NULL);
+                if (host_name == NULL || last_seen + MAX_AGE_DAYS * 24 * 60 * 60 < now) {
+                        g_free (host_name);
+                        continue;
+                }
+                address = g_key_file_get_string (key_file, name, "Address", NULL);
+                port = g_key_file_get_integer (key_file, name, "Port", NULL);
+
+                get_iter_for_name (discovery, name, &iter);
+                gtk_list_store_set (discovery->priv->model, &iter,
+                                    MDU_HOST_DISCOVERY_COLUMN_HOST_NAME, host_name,
+                                    MDU_HOST_DISCOVERY_COLUMN_ADDRESS, address,
+                                    MDU_HOST_DISCOVERY_COLUMN_PORT, (guint) port,
+                                    MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, last_seen,
+                                    MDU_HOST_DISCOVERY_COLUMN_PRESENT, FALSE,
+                                    -1);
+                g_free (host_name);
+                g_free (address);
+        }
+
+ out:
+        g_strfreev (groups);
+        g_key_file_free (key_file);
+        g_free (filename);
+}
+
+static void
+save_cache (MduHostDiscovery *discovery)
+{
+        GtkTreeModel *model = GTK_TREE_MODEL (discovery->priv->model);
+        GKeyFile *key_file;
+        GtkTreeIter iter;
+        GError *error;
+        gchar *filename;
+        gchar *dirname;
+        gchar *data;
+        gsize length;
+        guint64 now;
+
+        now = get_now ();
+        key_file = g_key_file_new ();
+
+        if (gtk_tree_model_get_iter_first (model, &iter)) {
+                do {
+                        gchar *name;
+                        gchar *host_name;
+                        gchar *address;
+                        guint port;
+                        guint64 last_seen;
+                        gboolean present;
+                        gchar *s;
+
+                        gtk_tree_model_get (model, &iter,
+                                            MDU_HOST_DISCOVERY_COLUMN_NAME, &name,
+                                            MDU_HOST_DISCOVERY_COLUMN_HOST_NAME, &host_name,
+                                            MDU_HOST_DISCOVERY_COLUMN_ADDRESS, &address,
+                                            MDU_HOST_DISCOVERY_COLUMN_PORT, &port,
+                                            MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, &last_seen,
+                                            MDU_HOST_DISCOVERY_COLUMN_PRESENT, &present,
+                                            -1);
+
+                        /* hosts that are still around were seen just now */
+                        if (present) {
+                                last_seen = now;
+                                gtk_list_store_set (discovery->priv->model, &iter,
+                                                    MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, last_seen,
+                                                    -1);
+                        }
+
+                        /* not much use remembering a service we never managed to resolve */
+                        if (host_name != NULL) {
+                                g_key_file_set_string (key_file, name, "HostName", host_name);
+                                if (address != NULL)
+                                        g_key_file_set_string (key_file, name, "Address", address);
+                                g_key_file_set_integer (key_file, name, "Port", port);
+                                s = g_strdup_printf ("%" G_GUINT64_FORMAT, last_seen);
+                                g_key_file_set_value (key_file, name, "LastSeen", s);
+                                g_free (s);
+                        }
+
+                        g_free (name);
+                        g_free (host_name);
+                        g_free (address);
+                } while (gtk_tree_model_iter_next (model, &iter));
+        }
+
+        filename = get_cache_filename ();
+        dirname = g_path_get_dirname (filename);
+        if (g_mkdir_with_parents (dirname, 0755) != 0) {
+                g_warning ("Error creating directory %s: %m", dirname);
+                goto out;
+        }
+
+        data = g_key_file_to_data (key_file, &length, NULL);
+        error = NULL;
+        if (!g_file_set_contents (filename, data, length, &error)) {
+                g_warning ("Error writing %s: %s", filename, error->message);
+                g_error_free (error);
+        }
+        g_free (data);
+
+ out:
+        g_free (dirname);
+        g_free (filename);
+        g_key_file_free (key_file);
+}
+
+static gboolean
+on_save_timeout (gpointer user_data)
+{
+        MduHostDiscovery *discovery = MDU_HOST_DISCOVERY (user_data);
+
+        discovery->priv->save_timeout_id = 0;
+        save_cache (discovery);
+        return FALSE;
+}
+
+static void
+schedule_save (MduHostDiscovery *discovery)
+{
+        if (discovery->priv->save_timeout_id == 0)
+                discovery->priv->save_timeout_id = g_timeout_add_seconds (SAVE_DELAY_SECONDS,
+                                                                          on_save_timeout,
+                                                                          discovery);
+}
+
+static gboolean
+on_refresh_timeout (gpointer user_data)
+{
+        MduHostDiscovery *discovery = MDU_HOST_DISCOVERY (user_data);
+
+        schedule_save (discovery);
+        return TRUE;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+set_present (MduHostDiscovery *discovery,
+             const gchar      *name,
+             gboolean          present)
+{
+        GtkTreeIter iter;
+
+        get_iter_for_name (discovery, name, &iter);
+        gtk_list_store_set (discovery->priv->model, &iter,
+                            MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, get_now (),
+                            MDU_HOST_DISCOVERY_COLUMN_PRESENT, present,
+                            -1);
+        schedule_save (discovery);
+}
+
+static void
+on_resolver_event (AvahiServiceResolver   *resolver,
+                   AvahiIfIndex            interface,
+                   AvahiProtocol           protocol,
+                   AvahiResolverEvent      event,
+                   const char             *name,
+                   const char             *type,
+                   const char             *domain,
+                   const char             *host_name,
+                   const AvahiAddress     *address,
+                   uint16_t                port,
+                   AvahiStringList        *txt,
+                   AvahiLookupResultFlags  flags,
+                   void                   *user_data)
+{
+        MduHostDiscovery *discovery = MDU_HOST_DISCOVERY (user_data);
+        char address_str[AVAHI_ADDRESS_STR_MAX];
+        GtkTreeIter iter;
+
+        if (event != AVAHI_RESOLVER_FOUND) {
+                g_warning ("Error resolving service `%s': %s",
+                           name,
+                           avahi_strerror (avahi_client_errno (discovery->priv->client)));
+                goto out;
+        }
+
+        /* the service may have gone away while we were resolving it */
+        if (g_hash_table_lookup (discovery->priv->name_to_num_instances, name) == NULL)
+                goto out;
+
+        avahi_address_snprint (address_str, sizeof address_str, address);
+
+        get_iter_for_name (discovery, name, &iter);
+        gtk_list_store_set (discovery->priv->model, &iter,
+                            MDU_HOST_DISCOVERY_COLUMN_HOST_NAME, host_name,
+                            MDU_HOST_DISCOVERY_COLUMN_ADDRESS, address_str,
+                            MDU_HOST_DISCOVERY_COLUMN_PORT, (guint) port,
+                            MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, get_now (),
+                            MDU_HOST_DISCOVERY_COLUMN_PRESENT, TRUE,
+                            -1);
+        schedule_save (discovery);
+
+ out:
+        discovery->priv->resolvers = g_list_remove (discovery->priv->resolvers, resolver);
+        avahi_service_resolver_free (resolver);
+}
+
+static void
+on_browser_event (AvahiServiceBrowser    *browser,
+                  AvahiIfIndex            interface,
+                  AvahiProtocol           protocol,
+                  AvahiBrowserEvent       event,
+                  const char             *name,
+                  const char             *type,
+                  const char             *domain,
+                  AvahiLookupResultFlags  flags,
+                  void                   *user_data)
+{
+        MduHostDiscovery *discovery = MDU_HOST_DISCOVERY (user_data);
+        AvahiServiceResolver *resolver;
+        guint num_instances;
+
+        switch (event) {
+        case AVAHI_BROWSER_NEW:
+                num_instances = GPOINTER_TO_UINT (g_hash_table_lookup (discovery->priv->name_to_num_instances,
+                                                                       name));
+                g_hash_table_insert (discovery->priv->name_to_num_instances,
+                                     g_strdup (name),
+                                     GUINT_TO_POINTER (num_instances + 1));
+                if (num_instances == 0)
+                        set_present (discovery, name, TRUE);
+
+                /* Kick off resolving right away - Avahi handles any number
+                 * of resolvers concurrently so a burst of announcements is
+                 * resolved in parallel rather than one host at a time
+                 */
+                resolver = avahi_service_resolver_new (discovery->priv->client,
+                                                       interface,
+                                                       protocol,
+                                                       name,
+                                                       type,
+                                                       domain,
+                                                       AVAHI_PROTO_UNSPEC,
+                                                       0,
+                                                       on_resolver_event,
+                                                       discovery);
+                if (resolver == NULL) {
+                        g_warning ("Error creating resolver for service `%s': %s",
+                                   name,
+                                   avahi_strerror (avahi_client_errno (discovery->priv->client)));
+                } else {
+                        discovery->priv->resolvers = g_list_prepend (discovery->priv->resolvers, resolver);
+                }
+                break;
+
+        case AVAHI_BROWSER_REMOVE:
+                num_instances = GPOINTER_TO_UINT (g_hash_table_lookup (discovery->priv->name_to_num_instances,
+                                                                       name));
+                if (num_instances <= 1) {
+                        g_hash_table_remove (discovery->priv->name_to_num_instances, name);
+                        set_present (discovery, name, FALSE);
+                } else {
+                        g_hash_table_insert (discovery->priv->name_to_num_instances,
+                                             g_strdup (name),
+                                             GUINT_TO_POINTER (num_instances - 1));
+                }
+                break;
+
+        case AVAHI_BROWSER_FAILURE:
+                g_warning ("Error browsing for " SERVICE_TYPE " services: %s",
+                           avahi_strerror (avahi_client_errno (discovery->priv->client)));
+                stop_browsing (discovery);
+                break;
+
+        case AVAHI_BROWSER_ALL_FOR_NOW:
+        case AVAHI_BROWSER_CACHE_EXHAUSTED:
+                break;
+        }
+}
+
+static void
+start_browsing (MduHostDiscovery *discovery)
+{
+        if (discovery->priv->browser != NULL)
+                goto out;
+
+        discovery->priv->browser = avahi_service_browser_new (discovery->priv->client,
+                                                              AVAHI_IF_UNSPEC,
+                                                              AVAHI_PROTO_UNSPEC,
+                                                              SERVICE_TYPE,
+                                                              NULL,
+                                                              0,
+                                                              on_browser_event,
+                                                              discovery);
+        if (discovery->priv->browser == NULL) {
+                g_warning ("Error browsing for " SERVICE_TYPE " services: %s",
+                           avahi_strerror (avahi_client_errno (discovery->priv->client)));
+                goto out;
+        }
+
+        if (discovery->priv->refresh_timeout_id == 0)
+                discovery->priv->refresh_timeout_id = g_timeout_add_seconds (REFRESH_INTERVAL_SECONDS,
+                                                                             on_refresh_timeout,
+                                                                             discovery);
+
+ out:
+        ;
+}
+
+static void
+stop_browsing (MduHostDiscovery *discovery)
+{
+        GHashTableIter hash_iter;
+        const gchar *name;
+
+        g_list_foreach (discovery->priv->resolvers, (GFunc) avahi_service_resolver_free, NULL);
+        g_list_free (discovery->priv->resolvers);
+        discovery->priv->resolvers = NULL;
+
+        if (discovery->priv->browser != NULL) {
+                avahi_service_browser_free (discovery->priv->browser);
+                discovery->priv->browser = NULL;
+        }
+
+        if (discovery->priv->refresh_timeout_id > 0) {
+                g_source_remove (discovery->priv->refresh_timeout_id);
+                discovery->priv->refresh_timeout_id = 0;
+        }
+
+        /* We can no longer tell whether the hosts are around */
+        g_hash_table_iter_init (&hash_iter, discovery->priv->name_to_num_instances);
+        while (g_hash_table_iter_next (&hash_iter, (gpointer) &name, NULL)) {
+                GtkTreeIter iter;
+
+                get_iter_for_name (discovery, name, &iter);
+                gtk_list_store_set (discovery->priv->model, &iter,
+                                    MDU_HOST_DISCOVERY_COLUMN_LAST_SEEN, get_now (),
+                                    MDU_HOST_DISCOVERY_COLUMN_PRESENT, FALSE,
+                                    -1);
+        }
+        if (g_hash_table_size (discovery->priv->name_to_num_instances) > 0) {
+                g_hash_table_remove_all (discovery->priv->name_to_num_instances);
+                schedule_save (discovery);
+        }
+}
+
+static void
+on_client_state_changed (AvahiClient      *client,
+                         AvahiClientState  state,
+                         void             *user_data)
+{
+        MduHostDiscovery *discovery = MDU_HOST_DISCOVERY (user_data);
+
+        /* Note that this is called from within avahi_client_new() before
+         * discovery->priv->client is set
+         */
+        discovery->priv->client = client;
+
+        switch (state) {
+        case AVAHI_CLIENT_S_RUNNING:
+                start_browsing (discovery);
+                break;
+
+        case AVAHI_CLIENT_FAILURE:
+                g_warning ("Avahi client failure: %s", avahi_strerror (avahi_client_errno (client)));
+                stop_browsing (discovery);
+                break;
+
+        case AVAHI_CLIENT_CONNECTING:
+                /* daemon went away (or isn't running yet); we'll get S_RUNNING when it's back */
+                stop_browsing (discovery);
+                break;
+
+        case AVAHI_CLIENT_S_REGISTERING:
+        case AVAHI_CLIENT_S_COLLISION:
+                break;
+        }
+}
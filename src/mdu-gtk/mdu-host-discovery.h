@@ -0,0 +1,61 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/*
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#if !defined (__MDU_GTK_INSIDE_MDU_GTK_H) && !defined (MDU_GTK_COMPILATION)
+#error "Only <mdu-gtk/mdu-gtk.h> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef MDU_HOST_DISCOVERY_H
+#define MDU_HOST_DISCOVERY_H
+
+#include <mdu-gtk/mdu-gtk-types.h>
+
+G_BEGIN_DECLS
+
+#define MDU_TYPE_HOST_DISCOVERY             (mdu_host_discovery_get_type ())
+#define MDU_HOST_DISCOVERY(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), MDU_TYPE_HOST_DISCOVERY, MduHostDiscovery))
+#define MDU_HOST_DISCOVERY_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), MDU_TYPE_HOST_DISCOVERY, MduHostDiscoveryClass))
+#define MDU_IS_HOST_DISCOVERY(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MDU_TYPE_HOST_DISCOVERY))
+#define MDU_IS_HOST_DISCOVERY_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), MDU_TYPE_HOST_DISCOVERY))
+#define MDU_HOST_DISCOVERY_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), MDU_TYPE_HOST_DISCOVERY, MduHostDiscoveryClass))
+
+typedef struct MduHostDiscoveryClass       MduHostDiscoveryClass;
+typedef struct MduHostDiscoveryPrivate     MduHostDiscoveryPrivate;
+
+struct MduHostDiscovery
+{
+        GObject parent;
+
+        /*< private >*/
+        MduHostDiscoveryPrivate *priv;
+};
+
+struct MduHostDiscoveryClass
+{
+        GObjectClass parent_class;
+};
+
+GType             mdu_host_discovery_get_type    (void) G_GNUC_CONST;
+MduHostDiscovery *mdu_host_discovery_get_default (void);
+GtkTreeModel     *mdu_host_discovery_get_model   (MduHostDiscovery *discovery);
+
+G_END_DECLS
+
+#endif /* MDU_HOST_DISCOVERY_H */
@@ -34,6 +34,10 @@ struct MduPoolTreeModelPrivate
         MduPresentable *root;
         MduPoolTreeModelFlags flags;
         gboolean constructed;
+
+        /* status lines of remote pools - see update_status_for_pool() */
+        GHashTable *pool_to_last_stats;
+        guint status_timeout_id;
 };
 
 G_DEFINE_TYPE (MduPoolTreeModel, mdu_pool_tree_model, GTK_TYPE_TREE_STORE)
@@ -60,6 +64,8 @@ static void on_presentable_changed (MduPool          *pool,
 static void add_presentable        (MduPoolTreeModel *model,
                                     MduPresentable   *presentable,
                                     GtkTreeIter      *iter_out);
+static void on_pool_reconnect      (MduPool          *pool,
+                                    gpointer          user_data);
 
 /* ---------------------------------------------------------------------------------------------------- */
 
@@ -71,6 +77,7 @@ disconnect_from_pool_cb (MduPool  *pool,
         g_signal_handlers_disconnect_by_func (pool, on_presentable_added, model);
         g_signal_handlers_disconnect_by_func (pool, on_presentable_removed, model);
         g_signal_handlers_disconnect_by_func (pool, on_presentable_changed, model);
+        g_signal_handlers_disconnect_by_func (pool, on_pool_reconnect, model);
 }
 
 /* ---------------------------------------------------------------------------------------------------- */
@@ -140,6 +147,10 @@ mdu_pool_tree_model_finalize (GObject *object)
                 g_ptr_array_unref (model->priv->pools);
         }
 
+        if (model->priv->status_timeout_id > 0)
+                g_source_remove (model->priv->status_timeout_id);
+        g_hash_table_unref (model->priv->pool_to_last_stats);
+
         if (G_OBJECT_CLASS (mdu_pool_tree_model_parent_class)->finalize != NULL)
                 G_OBJECT_CLASS (mdu_pool_tree_model_parent_class)->finalize (object);
 }
@@ -201,7 +212,7 @@ static void
 mdu_pool_tree_model_constructed (GObject *object)
 {
         MduPoolTreeModel *model = MDU_POOL_TREE_MODEL (object);
-        GType column_types[8];
+        GType column_types[9];
 
         column_types[0] = G_TYPE_ICON;
         column_types[1] = G_TYPE_STRING;
@@ -211,6 +222,7 @@ mdu_pool_tree_model_constructed (GObject *object)
         column_types[5] = G_TYPE_BOOLEAN;
         column_types[6] = G_TYPE_BOOLEAN;
         column_types[7] = G_TYPE_BOOLEAN;
+        column_types[8] = G_TYPE_STRING;
 
         gtk_tree_store_set_column_types (GTK_TREE_STORE (model),
                                          G_N_ELEMENTS (column_types),
@@ -234,6 +246,191 @@ mdu_pool_tree_model_constructed (GObject *object)
                 G_OBJECT_CLASS (mdu_pool_tree_model_parent_class)->constructed (object);
 }
 
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gboolean
+find_machine_iter (MduPoolTreeModel *model,
+                   MduPool          *pool,
+                   GtkTreeIter      *out_iter)
+{
+        GtkTreeIter iter;
+        gboolean ret;
+
+        ret = FALSE;
+
+        /* machines are always top-level */
+        if (!gtk_tree_model_get_iter_first (GTK_TREE_MODEL (model), &iter))
+                goto out;
+        do {
+                MduPresentable *presentable;
+                MduPool *presentable_pool;
+
+                gtk_tree_model_get (GTK_TREE_MODEL (model),
+                                    &iter,
+                                    MDU_POOL_TREE_MODEL_COLUMN_PRESENTABLE, &presentable,
+                                    -1);
+                if (presentable == NULL)
+                        continue;
+
+                presentable_pool = mdu_presentable_get_pool (presentable);
+                ret = MDU_IS_MACHINE (presentable) && presentable_pool == pool;
+                g_object_unref (presentable_pool);
+                g_object_unref (presentable);
+                if (ret) {
+                        *out_iter = iter;
+                        break;
+                }
+        } while (gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter));
+
+ out:
+        return ret;
+}
+
+static gchar *
+format_status (MduPoolTreeModel *model,
+               MduPool          *pool)
+{
+        MduPoolStats stats;
+        MduPoolStats delta;
+        MduPoolStats *last_stats;
+        const MduPoolStats *rtt_stats;
+        gdouble secs;
+        gchar *received;
+        gchar *sent;
+        gchar *ret;
+        guint n;
+
+        if (mdu_pool_is_reconnecting (pool)) {
+                /* the next rates would span the outage - start over once reconnected */
+                g_hash_table_remove (model->priv->pool_to_last_stats, pool);
+                ret = g_strdup (_("Reconnecting…"));
+                goto out;
+        }
+
+        mdu_pool_get_stats (pool, &stats);
+
+        last_stats = g_hash_table_lookup (model->priv->pool_to_last_stats, pool);
+        if (last_stats == NULL) {
+                memset (&delta, '\0', sizeof (MduPoolStats));
+                last_stats = &delta;
+        }
+
+        /* the rates are over the last interval, not since the pool was created */
+        delta.bytes_received = stats.bytes_received - last_stats->bytes_received;
+        delta.bytes_sent = stats.bytes_sent - last_stats->bytes_sent;
+        delta.messages_received = stats.messages_received - last_stats->messages_received;
+        delta.messages_sent = stats.messages_sent - last_stats->messages_sent;
+        delta.num_calls = stats.num_calls - last_stats->num_calls;
+        for (n = 0; n < MDU_POOL_STATS_NUM_RTT_BUCKETS; n++)
+                delta.rtt_histogram[n] = stats.rtt_histogram[n] - last_stats->rtt_histogram[n];
+        delta.blocked_secs = stats.blocked_secs - last_stats->blocked_secs;
+        delta.elapsed_secs = stats.elapsed_secs - last_stats->elapsed_secs;
+
+        g_hash_table_insert (model->priv->pool_to_last_stats, pool, g_memdup (&stats, sizeof (MduPoolStats)));
+
+        secs = MAX (delta.elapsed_secs, 0.001);
+        /* if no calls were made recently, show the round-trip times seen so far */
+        rtt_stats = delta.num_calls > 0 ? &delta : &stats;
+
+        received = mdu_util_get_speed_for_display ((guint64) (delta.bytes_received / secs));
+        sent = mdu_util_get_speed_for_display ((guint64) (delta.bytes_sent / secs));
+        if (rtt_stats->num_calls > 0) {
+                /* Translators: Status line for a remote host. First two %s are the rates
+                 * received and sent, e.g. "1.2 KB/s", followed by messages per second,
+                 * median and 99th percentile round-trip time in milliseconds and the
+                 * percentage of time spent waiting for the host.
+                 */
+                ret = g_strdup_printf (_("↓ %s ↑ %s · %.0f msg/s · RTT %.0f/%.0f ms · %.0f%% blocked"),
+                                       received,
+                                       sent,
+                                       (delta.messages_received + delta.messages_sent) / secs,
+                                       mdu_pool_stats_get_rtt_percentile (rtt_stats, 50.0),
+                                       mdu_pool_stats_get_rtt_percentile (rtt_stats, 99.0),
+                                       MIN (100.0 * delta.blocked_secs / secs, 100.0));
+        } else {
+                /* Translators: Status line for a remote host. First two %s are the rates
+                 * received and sent, e.g. "1.2 KB/s", followed by messages per second.
+                 */
+                ret = g_strdup_printf (_("↓ %s ↑ %s · %.0f msg/s"),
+                                       received,
+                                       sent,
+                                       (delta.messages_received + delta.messages_sent) / secs);
+        }
+        g_free (received);
+        g_free (sent);
+
+ out:
+        return ret;
+}
+
+static void
+update_status_for_pool (MduPoolTreeModel *model,
+                        MduPool          *pool)
+{
+        GtkTreeIter iter;
+        gchar *status;
+
+        if (mdu_pool_get_ssh_address (pool) == NULL)
+                goto out;
+
+        if (!find_machine_iter (model, pool, &iter))
+                goto out;
+
+        status = format_status (model, pool);
+        gtk_tree_store_set (GTK_TREE_STORE (model),
+                            &iter,
+                            MDU_POOL_TREE_MODEL_COLUMN_STATUS, status,
+                            -1);
+        g_free (status);
+
+ out:
+        ;
+}
+
+static gboolean
+on_status_timeout (gpointer user_data)
+{
+        MduPoolTreeModel *model = MDU_POOL_TREE_MODEL (user_data);
+        guint n;
+
+        for (n = 0; n < model->priv->pools->len; n++)
+                update_status_for_pool (model, MDU_POOL (model->priv->pools->pdata[n]));
+
+        return TRUE; /* keep timeout */
+}
+
+static void
+on_pool_reconnect (MduPool  *pool,
+                   gpointer  user_data)
+{
+        MduPoolTreeModel *model = MDU_POOL_TREE_MODEL (user_data);
+
+        update_status_for_pool (model, pool);
+}
+
+/* only poll the statistics if there is a remote pool to show them for */
+static void
+update_status_timeout (MduPoolTreeModel *model)
+{
+        gboolean has_remote_pool;
+        guint n;
+
+        has_remote_pool = FALSE;
+        for (n = 0; n < model->priv->pools->len; n++) {
+                if (mdu_pool_get_ssh_address (MDU_POOL (model->priv->pools->pdata[n])) != NULL) {
+                        has_remote_pool = TRUE;
+                        break;
+                }
+        }
+
+        if (has_remote_pool && model->priv->status_timeout_id == 0) {
+                model->priv->status_timeout_id = g_timeout_add_seconds (1, on_status_timeout, model);
+        } else if (!has_remote_pool && model->priv->status_timeout_id > 0) {
+                g_source_remove (model->priv->status_timeout_id);
+                model->priv->status_timeout_id = 0;
+        }
+}
+
 void
 mdu_pool_tree_model_set_pools (MduPoolTreeModel      *model,
                                GPtrArray             *pools)
@@ -245,6 +442,7 @@ mdu_pool_tree_model_set_pools (MduPoolTreeModel      *model,
                 g_ptr_array_foreach (model->priv->pools, (GFunc) disconnect_from_pool_cb, model);
                 g_ptr_array_unref (model->priv->pools);
         }
+        g_hash_table_remove_all (model->priv->pool_to_last_stats);
 
         model->priv->pools = g_ptr_array_new_with_free_func (g_object_unref);
         for (n = 0; pools != NULL && n < pools->len; n++) {
@@ -262,6 +460,14 @@ mdu_pool_tree_model_set_pools (MduPoolTreeModel      *model,
                                   "presentable-changed",
                                   G_CALLBACK (on_presentable_changed),
                                   model);
+                g_signal_connect (pool,
+                                  "reconnecting",
+                                  G_CALLBACK (on_pool_reconnect),
+                                  model);
+                g_signal_connect (pool,
+                                  "reconnected",
+                                  G_CALLBACK (on_pool_reconnect),
+                                  model);
 
                 g_ptr_array_add (model->priv->pools, g_object_ref (pool));
         }
@@ -269,6 +475,8 @@ mdu_pool_tree_model_set_pools (MduPoolTreeModel      *model,
         /* only do coldplug if we have been constructed as the result depends on the value of the flags */
         if (model->priv->constructed)
                 do_coldplug (model);
+
+        update_status_timeout (model);
 }
 
 static void
@@ -337,6 +545,11 @@ mdu_pool_tree_model_init (MduPoolTreeModel *model)
         model->priv = G_TYPE_INSTANCE_GET_PRIVATE (model,
                                                    MDU_TYPE_POOL_TREE_MODEL,
                                                    MduPoolTreeModelPrivate);
+
+        model->priv->pool_to_last_stats = g_hash_table_new_full (g_direct_hash,
+                                                                 g_direct_equal,
+                                                                 NULL,
+                                                                 g_free);
 }
 
 MduPoolTreeModel *
@@ -151,6 +151,7 @@ format_markup (GtkCellLayout   *cell_layout,
         gchar *name;
         gchar *vpd_name;
         gchar *desc;
+        gchar *status;
         MduPresentable *p;
         gchar *markup;
         gchar color[16];
@@ -164,6 +165,7 @@ format_markup (GtkCellLayout   *cell_layout,
                             MDU_POOL_TREE_MODEL_COLUMN_NAME, &name,
                             MDU_POOL_TREE_MODEL_COLUMN_VPD_NAME, &vpd_name,
                             MDU_POOL_TREE_MODEL_COLUMN_DESCRIPTION, &desc,
+                            MDU_POOL_TREE_MODEL_COLUMN_STATUS, &status,
                             -1);
 
         if (gtk_tree_selection_iter_is_selected (tree_selection, iter)) {
@@ -195,6 +197,21 @@ format_markup (GtkCellLayout   *cell_layout,
                                           desc);
         }
 
+        /* the connection status of remote hosts */
+        if (status != NULL) {
+                gchar *escaped;
+                gchar *s;
+
+                escaped = g_markup_escape_text (status, -1);
+                s = g_strdup_printf ("%s\n<small><span fgcolor=\"%s\">%s</span></small>",
+                                     markup,
+                                     color,
+                                     escaped);
+                g_free (escaped);
+                g_free (markup);
+                markup = s;
+        }
+
         g_object_set (renderer,
                       "markup", markup,
                       "ellipsize-set", TRUE,
@@ -204,6 +221,7 @@ format_markup (GtkCellLayout   *cell_layout,
         g_free (name);
         g_free (desc);
         g_free (vpd_name);
+        g_free (status);
         g_free (markup);
         g_object_unref (p);
 }
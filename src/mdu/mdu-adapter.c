@@ -90,31 +90,19 @@ adapter_properties_free (AdapterProperties *props)
 }
 
 static AdapterProperties *
-adapter_properties_get (DBusGConnection *bus,
+adapter_properties_get (MduPool *pool,
                         const char *object_path)
 {
         AdapterProperties *props;
         GError *error;
         GHashTable *hash_table;
-        DBusGProxy *prop_proxy;
         const char *ifname = "org.freedesktop.UDisks.Adapter";
 
         props = g_new0 (AdapterProperties, 1);
 
-	prop_proxy = dbus_g_proxy_new_for_name (bus,
-                                                "org.freedesktop.UDisks",
-                                                object_path,
-                                                "org.freedesktop.DBus.Properties");
         error = NULL;
-        if (!dbus_g_proxy_call (prop_proxy,
-                                "GetAll",
-                                &error,
-                                G_TYPE_STRING,
-                                ifname,
-                                G_TYPE_INVALID,
-                                dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
-                                &hash_table,
-                                G_TYPE_INVALID)) {
+        hash_table = _mdu_pool_get_all_properties (pool, object_path, ifname, &error);
+        if (hash_table == NULL) {
                 g_warning ("Couldn't call GetAll() to get properties for %s: %s", object_path, error->message);
                 g_error_free (error);
 
@@ -138,7 +126,6 @@ adapter_properties_get (DBusGConnection *bus,
 #endif
 
 out:
-        g_object_unref (prop_proxy);
         return props;
 }
 
@@ -150,6 +137,7 @@ struct _MduAdapterPrivate
         MduPool *pool;
 
         char *object_path;
+        guint handle;
 
         AdapterProperties *props;
 };
@@ -229,7 +217,7 @@ update_info (MduAdapter *adapter)
 {
         AdapterProperties *new_properties;
 
-        new_properties = adapter_properties_get (_mdu_pool_get_connection (adapter->priv->pool),
+        new_properties = adapter_properties_get (adapter->priv->pool,
                                                  adapter->priv->object_path);
         if (new_properties != NULL) {
                 if (adapter->priv->props != NULL)
@@ -242,6 +230,20 @@ update_info (MduAdapter *adapter)
 }
 
 
+static void
+create_proxy (MduAdapter *adapter)
+{
+        /* offline pools have no connection, see _mdu_pool_new_offline() */
+        if (_mdu_pool_get_connection (adapter->priv->pool) != NULL) {
+                adapter->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (adapter->priv->pool),
+                                                                  "org.freedesktop.UDisks",
+                                                                  adapter->priv->object_path,
+                                                                  "org.freedesktop.UDisks.Adapter");
+                dbus_g_proxy_set_default_timeout (adapter->priv->proxy, INT_MAX);
+                dbus_g_proxy_add_signal (adapter->priv->proxy, "Changed", G_TYPE_INVALID);
+        }
+}
+
 MduAdapter *
 _mdu_adapter_new_from_object_path (MduPool *pool, const char *object_path)
 {
@@ -250,13 +252,9 @@ _mdu_adapter_new_from_object_path (MduPool *pool, const char *object_path)
         adapter = MDU_ADAPTER (g_object_new (MDU_TYPE_ADAPTER, NULL));
         adapter->priv->object_path = g_strdup (object_path);
         adapter->priv->pool = g_object_ref (pool);
+        adapter->priv->handle = _mdu_pool_intern_object_path (pool, object_path);
 
-	adapter->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (adapter->priv->pool),
-                                                          "org.freedesktop.UDisks",
-                                                          adapter->priv->object_path,
-                                                          "org.freedesktop.UDisks.Adapter");
-        dbus_g_proxy_set_default_timeout (adapter->priv->proxy, INT_MAX);
-        dbus_g_proxy_add_signal (adapter->priv->proxy, "Changed", G_TYPE_INVALID);
+        create_proxy (adapter);
 
         /* TODO: connect signals */
 
@@ -283,12 +281,29 @@ _mdu_adapter_changed (MduAdapter *adapter)
         }
 }
 
+/* Called by the pool when it has reconnected to the daemon, see pool_handle_connection_lost() */
+void
+_mdu_adapter_rebind_proxy (MduAdapter *adapter)
+{
+        if (adapter->priv->proxy != NULL) {
+                g_object_unref (adapter->priv->proxy);
+                adapter->priv->proxy = NULL;
+        }
+        create_proxy (adapter);
+}
+
 const gchar *
 mdu_adapter_get_object_path (MduAdapter *adapter)
 {
         return adapter->priv->object_path;
 }
 
+guint
+_mdu_adapter_get_handle (MduAdapter *adapter)
+{
+        return adapter->priv->handle;
+}
+
 
 const gchar *
 mdu_adapter_get_native_path (MduAdapter *adapter)
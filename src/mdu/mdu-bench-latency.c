@@ -0,0 +1,646 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-bench-latency.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/* Measures how libmdu copes with a high-latency connection to the udisks
+ * daemon, such as the ssh bridge over a WAN link, without needing a remote
+ * host.
+ *
+ * A child process relays the D-Bus connection between us and the local
+ * system bus through a UNIX socket, holding back all data for the given
+ * delay in each direction. Over this loopback bridge we time getting the
+ * properties of all devices with one GetAll() call after another, the same
+ * with _mdu_pool_prefetch_properties() and priming a complete MduPool.
+ *
+ * Finally a burst of DeviceChanged signals, several for every device, is
+ * fed through the signal batching remote pools use. The burst must be
+ * handled in a single batch making at most one call per device, within a
+ * bound derived from the latency (or --max-burst-secs); otherwise the
+ * exit status is 1.
+ *
+ * The relay can also throttle the link to a given bandwidth and, like
+ * ssh -C, compress everything with zlib, flushing after each read. The
+ * data is still relayed uncompressed but the link is throttled by the
+ * compressed size so this shows what compressing the ssh bridge buys in
+ * bytes on the wire and time until the pool is primed, i.e. until the
+ * devices of a remote host can be shown. Compare e.g.
+ *
+ *   mdu-bench-latency --delay=50 --bandwidth=1000
+ *   mdu-bench-latency --delay=50 --bandwidth=1000 --compress
+ *
+ * Requires a running udisks daemon.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <dbus/dbus-glib.h>
+#include <dbus/dbus-glib-lowlevel.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "mdu-pool.h"
+#include "mdu-private.h"
+
+#include "udisks-daemon-glue.h"
+
+#define SYSTEM_BUS_SOCKET "/var/run/dbus/system_bus_socket"
+
+static gint opt_delay = 50;
+static gint opt_bandwidth = 0;
+static gboolean opt_compress = FALSE;
+static gchar *opt_socket = NULL;
+static gint opt_burst_repeats = 10;
+static gdouble opt_max_burst_secs = 0.0;
+
+static GOptionEntry entries[] = {
+        { "delay", 'd', 0, G_OPTION_ARG_INT, &opt_delay, "Latency to inject in each direction in milliseconds (default: 50)", "MSEC" },
+        { "bandwidth", 'b', 0, G_OPTION_ARG_INT, &opt_bandwidth, "Throttle the link to this many kbit/s in each direction (default: unlimited)", "KBIT" },
+        { "compress", 'z', 0, G_OPTION_ARG_NONE, &opt_compress, "Compress the link like ssh -C does", NULL },
+        { "socket", 's', 0, G_OPTION_ARG_FILENAME, &opt_socket, "Socket of the system bus (default: " SYSTEM_BUS_SOCKET ")", "PATH" },
+        { "burst-repeats", 'r', 0, G_OPTION_ARG_INT, &opt_burst_repeats, "DeviceChanged signals per device in the burst (default: 10)", "N" },
+        { "max-burst-secs", 'm', 0, G_OPTION_ARG_DOUBLE, &opt_max_burst_secs, "Fail if handling the burst takes longer (default: derived from the delay)", "SECS" },
+        { NULL }
+};
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct {
+        gint64 due_usec;
+        gsize len;
+        gsize offset;
+        guchar *data;
+} Chunk;
+
+enum {
+        TO_BUS,
+        FROM_BUS,
+        NUM_DIRECTIONS
+};
+
+/* shared with the relay process so we can tell how much went over the link */
+typedef struct {
+        guint64 raw_bytes[NUM_DIRECTIONS];
+        guint64 wire_bytes[NUM_DIRECTIONS];
+} LinkCounters;
+
+static LinkCounters *counters = NULL;
+
+typedef struct {
+        guint index;
+        int from_fd;
+        int to_fd;
+        GQueue *chunks;
+        /* when the throttled link is done sending what has been read so far */
+        gint64 link_free_usec;
+#ifdef HAVE_ZLIB
+        z_stream zstream;
+#endif
+} Direction;
+
+/* returns how many bytes @len bytes of data take up on the link */
+static gsize
+direction_get_wire_len (Direction *direction, guchar *data, gsize len)
+{
+#ifdef HAVE_ZLIB
+        guchar buf[65536 + 1024];
+        gsize wire_len;
+
+        if (!opt_compress)
+                return len;
+
+        wire_len = 0;
+        direction->zstream.next_in = data;
+        direction->zstream.avail_in = len;
+        do {
+                direction->zstream.next_out = buf;
+                direction->zstream.avail_out = sizeof buf;
+                deflate (&direction->zstream, Z_SYNC_FLUSH);
+                wire_len += sizeof buf - direction->zstream.avail_out;
+        } while (direction->zstream.avail_out == 0);
+
+        return wire_len;
+#else
+        return len;
+#endif
+}
+
+static gint64
+now_usec (void)
+{
+        GTimeVal now;
+
+        g_get_current_time (&now);
+        return ((gint64) now.tv_sec) * G_USEC_PER_SEC + now.tv_usec;
+}
+
+/* returns FALSE if the other end closed the connection */
+static gboolean
+direction_read (Direction *direction)
+{
+        guchar buf[65536];
+        ssize_t num_read;
+        gsize wire_len;
+        gint64 start_usec;
+        Chunk *chunk;
+
+        num_read = read (direction->from_fd, buf, sizeof buf);
+        if (num_read < 0 && errno == EINTR)
+                return TRUE;
+        if (num_read <= 0)
+                return FALSE;
+
+        wire_len = direction_get_wire_len (direction, buf, num_read);
+        counters->raw_bytes[direction->index] += num_read;
+        counters->wire_bytes[direction->index] += wire_len;
+
+        /* the data goes out once everything before it has been sent and then takes
+         * its size divided by the bandwidth to send
+         */
+        start_usec = MAX (now_usec (), direction->link_free_usec);
+        if (opt_bandwidth > 0)
+                direction->link_free_usec = start_usec + ((gint64) wire_len) * 8 * 1000 / opt_bandwidth;
+        else
+                direction->link_free_usec = start_usec;
+
+        chunk = g_new0 (Chunk, 1);
+        chunk->due_usec = direction->link_free_usec + opt_delay * 1000;
+        chunk->len = num_read;
+        chunk->data = g_memdup (buf, num_read);
+        g_queue_push_tail (direction->chunks, chunk);
+
+        return TRUE;
+}
+
+/* writes out all chunks that are due; returns FALSE on error */
+static gboolean
+direction_write (Direction *direction)
+{
+        Chunk *chunk;
+
+        while ((chunk = g_queue_peek_head (direction->chunks)) != NULL && chunk->due_usec <= now_usec ()) {
+                while (chunk->offset < chunk->len) {
+                        ssize_t num_written;
+
+                        num_written = write (direction->to_fd, chunk->data + chunk->offset, chunk->len - chunk->offset);
+                        if (num_written < 0 && errno == EINTR)
+                                continue;
+                        if (num_written < 0)
+                                return FALSE;
+                        chunk->offset += num_written;
+                }
+                g_queue_pop_head (direction->chunks);
+                g_free (chunk->data);
+                g_free (chunk);
+        }
+
+        return TRUE;
+}
+
+static gint
+direction_get_timeout (Direction *direction, gint timeout)
+{
+        Chunk *chunk;
+        gint msec;
+
+        chunk = g_queue_peek_head (direction->chunks);
+        if (chunk == NULL)
+                return timeout;
+
+        msec = MAX ((chunk->due_usec - now_usec () + 999) / 1000, 0);
+        if (timeout < 0 || msec < timeout)
+                timeout = msec;
+        return timeout;
+}
+
+/* runs in the child process */
+static void
+relay (int listen_fd, const gchar *upstream_path)
+{
+        struct sockaddr_un addr;
+        struct pollfd fds[2];
+        Direction to_bus;
+        Direction from_bus;
+        int client_fd;
+        int bus_fd;
+
+        client_fd = accept (listen_fd, NULL, NULL);
+        if (client_fd < 0)
+                _exit (1);
+        close (listen_fd);
+
+        bus_fd = socket (AF_UNIX, SOCK_STREAM, 0);
+        memset (&addr, 0, sizeof addr);
+        addr.sun_family = AF_UNIX;
+        strncpy (addr.sun_path, upstream_path, sizeof addr.sun_path - 1);
+        if (connect (bus_fd, (struct sockaddr *) &addr, sizeof addr) != 0) {
+                g_printerr ("Error connecting to %s: %s\n", upstream_path, g_strerror (errno));
+                _exit (1);
+        }
+
+        memset (&to_bus, 0, sizeof to_bus);
+        to_bus.index = TO_BUS;
+        to_bus.from_fd = client_fd;
+        to_bus.to_fd = bus_fd;
+        to_bus.chunks = g_queue_new ();
+        memset (&from_bus, 0, sizeof from_bus);
+        from_bus.index = FROM_BUS;
+        from_bus.from_fd = bus_fd;
+        from_bus.to_fd = client_fd;
+        from_bus.chunks = g_queue_new ();
+#ifdef HAVE_ZLIB
+        /* ssh uses the default compression level too */
+        if (opt_compress) {
+                deflateInit (&to_bus.zstream, Z_DEFAULT_COMPRESSION);
+                deflateInit (&from_bus.zstream, Z_DEFAULT_COMPRESSION);
+        }
+#endif
+
+        while (TRUE) {
+                gint timeout;
+
+                fds[0].fd = client_fd;
+                fds[0].events = POLLIN;
+                fds[0].revents = 0;
+                fds[1].fd = bus_fd;
+                fds[1].events = POLLIN;
+                fds[1].revents = 0;
+
+                timeout = direction_get_timeout (&to_bus, -1);
+                timeout = direction_get_timeout (&from_bus, timeout);
+
+                if (poll (fds, 2, timeout) < 0 && errno != EINTR)
+                        break;
+
+                if (fds[0].revents != 0 && !direction_read (&to_bus))
+                        break;
+                if (fds[1].revents != 0 && !direction_read (&from_bus))
+                        break;
+
+                if (!direction_write (&to_bus) || !direction_write (&from_bus))
+                        break;
+        }
+
+        _exit (0);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static DBusGConnection *
+connect_through_relay (const gchar *relay_path, GError **error)
+{
+        DBusConnection *connection;
+        DBusError dbus_error;
+        gchar *address;
+
+        address = g_strdup_printf ("unix:path=%s", relay_path);
+
+        dbus_error_init (&dbus_error);
+        connection = dbus_connection_open_private (address, &dbus_error);
+        if (connection == NULL || !dbus_bus_register (connection, &dbus_error)) {
+                g_set_error (error, DBUS_GERROR, DBUS_GERROR_FAILED,
+                             "Error connecting to %s: %s: %s",
+                             address,
+                             dbus_error.name,
+                             dbus_error.message);
+                dbus_error_free (&dbus_error);
+                if (connection != NULL) {
+                        dbus_connection_close (connection);
+                        dbus_connection_unref (connection);
+                        connection = NULL;
+                }
+                goto out;
+        }
+        dbus_connection_set_exit_on_disconnect (connection, FALSE);
+        dbus_connection_setup_with_g_main (connection, NULL);
+
+ out:
+        g_free (address);
+        return connection != NULL ? dbus_connection_get_g_connection (connection) : NULL;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gboolean
+on_burst_timeout (gpointer user_data)
+{
+        gboolean *timed_out = user_data;
+
+        *timed_out = TRUE;
+        return FALSE;
+}
+
+/* Feeds @opt_burst_repeats DeviceChanged signals for each of @devices through the signal
+ * batching of @pool and checks that they are handled in one batch with at most one call
+ * per device within @max_secs. Returns FALSE if not.
+ */
+static gboolean
+check_changed_burst (MduPool   *pool,
+                     GPtrArray *devices,
+                     gdouble    max_secs)
+{
+        MduPoolStats stats;
+        guint64 calls_before;
+        guint batches_before;
+        guint num_batches;
+        guint64 num_calls;
+        gboolean timed_out;
+        guint timeout_id;
+        GTimer *timer;
+        gdouble secs;
+        gboolean ret;
+        gint r;
+        guint n;
+
+        ret = FALSE;
+
+        _mdu_pool_set_batch_signals (pool, TRUE);
+        mdu_pool_get_stats (pool, &stats);
+        calls_before = stats.num_calls;
+        batches_before = _mdu_pool_get_num_signal_batches (pool);
+
+        timer = g_timer_new ();
+        for (r = 0; r < MAX (opt_burst_repeats, 1); r++) {
+                for (n = 0; n < devices->len; n++)
+                        _mdu_pool_emit_object_signal (pool, "DeviceChanged", devices->pdata[n]);
+        }
+
+        /* give up long after the bound so we can tell how far off we are */
+        timed_out = FALSE;
+        timeout_id = g_timeout_add ((guint) (max_secs * 10 * 1000), on_burst_timeout, &timed_out);
+        while (!timed_out && _mdu_pool_get_num_signal_batches (pool) == batches_before)
+                g_main_context_iteration (NULL, TRUE);
+        secs = g_timer_elapsed (timer, NULL);
+        if (!timed_out)
+                g_source_remove (timeout_id);
+        g_timer_destroy (timer);
+
+        /* let any further batch run so we can count it */
+        while (g_main_context_iteration (NULL, FALSE))
+                ;
+
+        mdu_pool_get_stats (pool, &stats);
+        num_calls = stats.num_calls - calls_before;
+        num_batches = _mdu_pool_get_num_signal_batches (pool) - batches_before;
+
+        g_print ("Burst of %u DeviceChanged signals:\n", MAX (opt_burst_repeats, 1) * devices->len);
+        g_print ("  handled in %u batch(es) with %" G_GUINT64_FORMAT " calls in %.3f seconds (bound %.3f)\n",
+                 num_batches, num_calls, secs, max_secs);
+
+        if (timed_out) {
+                g_printerr ("FAIL: the burst was not handled within %.3f seconds\n", max_secs * 10);
+                goto out;
+        }
+        if (num_batches != 1) {
+                g_printerr ("FAIL: the burst was handled in %u batches, expected 1\n", num_batches);
+                goto out;
+        }
+        if (num_calls > devices->len) {
+                g_printerr ("FAIL: %" G_GUINT64_FORMAT " calls for %u devices\n", num_calls, devices->len);
+                goto out;
+        }
+        if (secs > max_secs) {
+                g_printerr ("FAIL: handling the burst took %.3f seconds, more than %.3f\n", secs, max_secs);
+                goto out;
+        }
+
+        ret = TRUE;
+
+ out:
+        return ret;
+}
+
+int
+main (int argc, char *argv[])
+{
+        GOptionContext *context;
+        GError *error;
+        struct sockaddr_un addr;
+        gchar *relay_path;
+        int listen_fd;
+        pid_t relay_pid;
+        DBusGConnection *bus;
+        DBusGProxy *proxy;
+        GPtrArray *devices;
+        GTimer *timer;
+        MduPool *pool;
+        gdouble serial_secs;
+        gdouble pipelined_secs;
+        gdouble max_burst_secs;
+        LinkCounters before;
+        guint n;
+        int ret;
+
+        ret = 1;
+        relay_path = NULL;
+        listen_fd = -1;
+        relay_pid = 0;
+        bus = NULL;
+        proxy = NULL;
+        devices = NULL;
+        timer = NULL;
+        pool = NULL;
+
+        g_type_init ();
+
+        context = g_option_context_new ("- measure libmdu over a loopback bridge with injected latency");
+        g_option_context_add_main_entries (context, entries, NULL);
+        error = NULL;
+        if (!g_option_context_parse (context, &argc, &argv, &error)) {
+                g_printerr ("Could not parse arguments: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+#ifndef HAVE_ZLIB
+        if (opt_compress) {
+                g_printerr ("Compression is not supported, rebuild with zlib\n");
+                goto out;
+        }
+#endif
+
+        counters = mmap (NULL, sizeof (LinkCounters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (counters == MAP_FAILED) {
+                g_printerr ("Error mapping counters: %s\n", g_strerror (errno));
+                counters = NULL;
+                goto out;
+        }
+        memset (counters, 0, sizeof (LinkCounters));
+
+        relay_path = g_strdup_printf ("%s/mdu-bench-latency-%d", g_get_tmp_dir (), getpid ());
+        listen_fd = socket (AF_UNIX, SOCK_STREAM, 0);
+        memset (&addr, 0, sizeof addr);
+        addr.sun_family = AF_UNIX;
+        strncpy (addr.sun_path, relay_path, sizeof addr.sun_path - 1);
+        if (bind (listen_fd, (struct sockaddr *) &addr, sizeof addr) != 0 || listen (listen_fd, 1) != 0) {
+                g_printerr ("Error listening on %s: %s\n", relay_path, g_strerror (errno));
+                goto out;
+        }
+
+        relay_pid = fork ();
+        if (relay_pid < 0) {
+                g_printerr ("Error forking: %s\n", g_strerror (errno));
+                goto out;
+        } else if (relay_pid == 0) {
+                relay (listen_fd, opt_socket != NULL ? opt_socket : SYSTEM_BUS_SOCKET);
+        }
+        close (listen_fd);
+        listen_fd = -1;
+
+        bus = connect_through_relay (relay_path, &error);
+        if (bus == NULL) {
+                g_printerr ("%s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        g_print ("Injecting %d ms of latency in each direction\n", opt_delay);
+        if (opt_bandwidth > 0)
+                g_print ("Throttling to %d kbit/s in each direction\n", opt_bandwidth);
+        g_print ("Compression is %s\n", opt_compress ? "on" : "off");
+
+        timer = g_timer_new ();
+
+        proxy = dbus_g_proxy_new_for_name (bus,
+                                           "org.freedesktop.UDisks",
+                                           "/org/freedesktop/UDisks",
+                                           "org.freedesktop.UDisks");
+        if (!org_freedesktop_UDisks_enumerate_devices (proxy, &devices, &error)) {
+                g_printerr ("Error enumerating devices: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        /* one GetAll() after another, like libmdu used to do */
+        g_timer_start (timer);
+        for (n = 0; n < devices->len; n++) {
+                DBusGProxy *prop_proxy;
+                GHashTable *properties;
+
+                prop_proxy = dbus_g_proxy_new_for_name (bus,
+                                                        "org.freedesktop.UDisks",
+                                                        devices->pdata[n],
+                                                        "org.freedesktop.DBus.Properties");
+                if (dbus_g_proxy_call (prop_proxy,
+                                       "GetAll",
+                                       &error,
+                                       G_TYPE_STRING,
+                                       "org.freedesktop.UDisks.Device",
+                                       G_TYPE_INVALID,
+                                       dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
+                                       &properties,
+                                       G_TYPE_INVALID)) {
+                        g_hash_table_unref (properties);
+                } else {
+                        g_printerr ("Error getting properties for %s: %s\n",
+                                    (const gchar *) devices->pdata[n],
+                                    error->message);
+                        g_error_free (error);
+                        error = NULL;
+                }
+                g_object_unref (prop_proxy);
+        }
+        serial_secs = g_timer_elapsed (timer, NULL);
+
+        /* the same, pipelined - this also primes a pool which prefetches everything */
+        before = *counters;
+        g_timer_start (timer);
+        pool = _mdu_pool_new_for_connection (bus, &error);
+        if (pool == NULL) {
+                g_printerr ("Error creating pool: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+        /* this is what it takes until the devices of a remote host can be shown */
+        g_print ("Primed pool in %.3f seconds\n", g_timer_elapsed (timer, NULL));
+        g_print ("  received %" G_GUINT64_FORMAT " bytes on the wire (%" G_GUINT64_FORMAT " uncompressed)\n",
+                 counters->wire_bytes[FROM_BUS] - before.wire_bytes[FROM_BUS],
+                 counters->raw_bytes[FROM_BUS] - before.raw_bytes[FROM_BUS]);
+        g_print ("  sent     %" G_GUINT64_FORMAT " bytes on the wire (%" G_GUINT64_FORMAT " uncompressed)\n",
+                 counters->wire_bytes[TO_BUS] - before.wire_bytes[TO_BUS],
+                 counters->raw_bytes[TO_BUS] - before.raw_bytes[TO_BUS]);
+
+        g_timer_start (timer);
+        _mdu_pool_prefetch_properties (pool,
+                                       (const gchar * const *) devices->pdata,
+                                       devices->len,
+                                       "org.freedesktop.UDisks.Device");
+        pipelined_secs = g_timer_elapsed (timer, NULL);
+
+        g_print ("GetAll() for %u devices:\n", devices->len);
+        g_print ("  serial    %8.3f seconds (%.1f ms per device)\n",
+                 serial_secs, devices->len > 0 ? serial_secs * 1000.0 / devices->len : 0.0);
+        g_print ("  pipelined %8.3f seconds (%.1f ms per device)\n",
+                 pipelined_secs, devices->len > 0 ? pipelined_secs * 1000.0 / devices->len : 0.0);
+
+        /* The batch is handled after the flush delay with one pipelined round trip per window
+         * of GetAll() calls; allow for twice that. A throttled link needs an explicit bound.
+         */
+        max_burst_secs = opt_max_burst_secs;
+        if (max_burst_secs <= 0.0)
+                max_burst_secs = 0.1 + 2.0 * (1 + devices->len / 128) * 2.0 * opt_delay / 1000.0 +
+                        (opt_bandwidth > 0 ? pipelined_secs * 2.0 : 0.0);
+        if (!check_changed_burst (pool, devices, max_burst_secs))
+                goto out;
+
+        ret = 0;
+
+ out:
+        if (devices != NULL) {
+                g_ptr_array_foreach (devices, (GFunc) g_free, NULL);
+                g_ptr_array_free (devices, TRUE);
+        }
+        if (proxy != NULL)
+                g_object_unref (proxy);
+        if (pool != NULL)
+                _mdu_pool_free (pool);
+        if (bus != NULL) {
+                dbus_connection_close (dbus_g_connection_get_connection (bus));
+                dbus_g_connection_unref (bus);
+        }
+        if (relay_pid > 0) {
+                kill (relay_pid, SIGTERM);
+                waitpid (relay_pid, NULL, 0);
+        }
+        if (listen_fd >= 0)
+                close (listen_fd);
+        if (relay_path != NULL) {
+                unlink (relay_path);
+                g_free (relay_path);
+        }
+        if (counters != NULL)
+                munmap (counters, sizeof (LinkCounters));
+        if (timer != NULL)
+                g_timer_destroy (timer);
+        g_option_context_free (context);
+        return ret;
+}
@@ -0,0 +1,853 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-bench.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/* Micro-benchmarks for the hot paths in libmdu.
+ *
+ * The benchmarks run against offline pools (see _mdu_pool_new_offline())
+ * populated with synthetic devices so no udisks daemon is needed. Results
+ * are written as JSON and, if a baseline written by an earlier run is
+ * given, compared against it; the program exits with a non-zero status if
+ * the baseline can't be read or any benchmark got slower than the given
+ * threshold.
+ *
+ * Use "make bench-baseline" to store a baseline for this machine and
+ * "make bench" to compare against it. Timings depend on the machine so
+ * no baseline is shipped.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <dbus/dbus-glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mdu-pool.h"
+#include "mdu-presentable.h"
+#include "mdu-device.h"
+#include "mdu-drive.h"
+#include "mdu-hub.h"
+#include "mdu-adapter.h"
+#include "mdu-linux-md-drive.h"
+#include "mdu-private.h"
+
+#define DRIVES_PER_ADAPTER 32
+
+typedef struct {
+        gchar *name;
+        guint num_devices;
+        guint iterations;
+        gdouble min_usec;
+        gdouble mean_usec;
+} BenchResult;
+
+typedef struct {
+        /* object path -> GHashTable of properties */
+        GHashTable *devices;
+        GHashTable *adapters;
+        GHashTable *ports;
+        guint num_devices;
+} SyntheticSystem;
+
+static gchar *opt_sizes = NULL;
+static gint opt_iterations = 3;
+static gchar *opt_output = NULL;
+static gchar *opt_baseline = NULL;
+static gdouble opt_threshold = 10.0;
+
+static GOptionEntry entries[] = {
+        { "sizes", 's', 0, G_OPTION_ARG_STRING, &opt_sizes, "Comma-separated number of devices in each synthetic pool (default: 100,1000,10000)", "SIZES" },
+        { "iterations", 'i', 0, G_OPTION_ARG_INT, &opt_iterations, "Number of iterations for each benchmark (default: 3)", "NUM" },
+        { "output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output, "Write JSON results to FILE instead of stdout", "FILE" },
+        { "baseline", 'b', 0, G_OPTION_ARG_FILENAME, &opt_baseline, "Compare against results previously written to FILE", "FILE" },
+        { "threshold", 't', 0, G_OPTION_ARG_DOUBLE, &opt_threshold, "Maximum allowed slowdown against the baseline in percent (default: 10)", "PERCENT" },
+        { NULL }
+};
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+value_free (GValue *value)
+{
+        g_value_unset (value);
+        g_free (value);
+}
+
+static GHashTable *
+props_new (void)
+{
+        return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) value_free);
+}
+
+static GValue *
+props_add (GHashTable *props, const gchar *key, GType type)
+{
+        GValue *value;
+
+        value = g_new0 (GValue, 1);
+        g_value_init (value, type);
+        g_hash_table_insert (props, g_strdup (key), value);
+
+        return value;
+}
+
+static void
+props_add_string (GHashTable *props, const gchar *key, const gchar *str)
+{
+        g_value_set_string (props_add (props, key, G_TYPE_STRING), str);
+}
+
+static void
+props_add_object_path (GHashTable *props, const gchar *key, const gchar *object_path)
+{
+        g_value_set_boxed (props_add (props, key, DBUS_TYPE_G_OBJECT_PATH), object_path);
+}
+
+static void
+props_add_object_path_array (GHashTable *props, const gchar *key, const gchar * const *object_paths)
+{
+        GPtrArray *array;
+        guint n;
+
+        array = g_ptr_array_new ();
+        for (n = 0; object_paths != NULL && object_paths[n] != NULL; n++)
+                g_ptr_array_add (array, (gpointer) object_paths[n]);
+        g_value_set_boxed (props_add (props, key, dbus_g_type_get_collection ("GPtrArray", DBUS_TYPE_G_OBJECT_PATH)),
+                           array);
+        g_ptr_array_free (array, TRUE);
+}
+
+static void
+props_add_strv (GHashTable *props, const gchar *key, const gchar * const *strv)
+{
+        g_value_set_boxed (props_add (props, key, G_TYPE_STRV), strv);
+}
+
+static void
+props_add_boolean (GHashTable *props, const gchar *key, gboolean b)
+{
+        g_value_set_boolean (props_add (props, key, G_TYPE_BOOLEAN), b);
+}
+
+static void
+props_add_int (GHashTable *props, const gchar *key, gint i)
+{
+        g_value_set_int (props_add (props, key, G_TYPE_INT), i);
+}
+
+static void
+props_add_uint64 (GHashTable *props, const gchar *key, guint64 u)
+{
+        g_value_set_uint64 (props_add (props, key, G_TYPE_UINT64), u);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static GHashTable *
+device_props_new (const gchar *device_file, guint64 size)
+{
+        GHashTable *props;
+        const gchar *empty[] = {NULL};
+        gchar *by_id[2];
+
+        props = props_new ();
+        by_id[0] = g_strdup_printf ("/dev/disk/by-id/synthetic-%s", device_file + 5);
+        by_id[1] = NULL;
+
+        props_add_string (props, "NativePath", device_file);
+        props_add_string (props, "DeviceFile", device_file);
+        props_add_string (props, "DeviceFilePresentation", device_file);
+        props_add_strv (props, "DeviceFileById", (const gchar * const *) by_id);
+        props_add_strv (props, "DeviceFileByPath", empty);
+        props_add_strv (props, "DeviceMountPaths", empty);
+        props_add_uint64 (props, "DeviceSize", size);
+        props_add_uint64 (props, "DeviceBlockSize", 512);
+        props_add_boolean (props, "DeviceIsMediaAvailable", TRUE);
+        props_add_string (props, "IdUsage", "");
+        props_add_string (props, "IdType", "");
+        props_add_string (props, "IdUuid", "");
+        props_add_string (props, "IdLabel", "");
+
+        g_free (by_id[0]);
+        return props;
+}
+
+static void
+add_drive_props (GHashTable  *props,
+                 const gchar *port_object_path,
+                 guint        serial)
+{
+        const gchar *empty[] = {NULL};
+        const gchar *ports[2];
+        gchar *s;
+
+        ports[0] = port_object_path;
+        ports[1] = NULL;
+
+        props_add_boolean (props, "DeviceIsDrive", TRUE);
+        props_add_string (props, "DriveVendor", "ACME");
+        props_add_string (props, "DriveModel", "Synthetic Disk");
+        props_add_string (props, "DriveRevision", "1.0");
+        s = g_strdup_printf ("SYN%08u", serial);
+        props_add_string (props, "DriveSerial", s);
+        g_free (s);
+        props_add_string (props, "DriveConnectionInterface", "ata");
+        props_add_boolean (props, "DriveIsRotational", TRUE);
+        props_add_object_path_array (props, "DrivePorts", port_object_path != NULL ? ports : empty);
+        props_add_object_path_array (props, "DriveSimilarDevices", empty);
+}
+
+static gchar *
+add_device (SyntheticSystem *system, GHashTable *props)
+{
+        gchar *object_path;
+
+        object_path = g_strdup_printf ("/org/freedesktop/UDisks/devices/syn%u", system->num_devices++);
+        g_hash_table_insert (system->devices, object_path, props);
+
+        return object_path;
+}
+
+/* A disk with a MBR partition table holding one primary and one extended
+ * partition with a logical partition inside; this leaves unallocated
+ * space both in the primary and the logical space of the drive.
+ */
+static void
+add_partitioned_disk (SyntheticSystem *system,
+                      const gchar     *port_object_path,
+                      guint            disk_number)
+{
+        GHashTable *props;
+        gchar *device_file;
+        const gchar *drive_object_path;
+        guint64 gb = 1000 * 1000 * 1000;
+
+        device_file = g_strdup_printf ("/dev/sd%u", disk_number);
+        props = device_props_new (device_file, 100 * gb);
+        add_drive_props (props, port_object_path, disk_number);
+        props_add_boolean (props, "DeviceIsPartitionTable", TRUE);
+        props_add_string (props, "PartitionTableScheme", "mbr");
+        props_add_int (props, "PartitionTableCount", 3);
+        drive_object_path = add_device (system, props);
+        g_free (device_file);
+
+        device_file = g_strdup_printf ("/dev/sd%up1", disk_number);
+        props = device_props_new (device_file, 40 * gb);
+        props_add_boolean (props, "DeviceIsPartition", TRUE);
+        props_add_object_path (props, "PartitionSlave", drive_object_path);
+        props_add_string (props, "PartitionScheme", "mbr");
+        props_add_string (props, "PartitionType", "0x83");
+        props_add_int (props, "PartitionNumber", 1);
+        props_add_uint64 (props, "PartitionOffset", 1000 * 1000);
+        props_add_uint64 (props, "PartitionSize", 40 * gb);
+        add_device (system, props);
+        g_free (device_file);
+
+        device_file = g_strdup_printf ("/dev/sd%up2", disk_number);
+        props = device_props_new (device_file, 40 * gb);
+        props_add_boolean (props, "DeviceIsPartition", TRUE);
+        props_add_object_path (props, "PartitionSlave", drive_object_path);
+        props_add_string (props, "PartitionScheme", "mbr");
+        props_add_string (props, "PartitionType", "0x05");
+        props_add_int (props, "PartitionNumber", 2);
+        props_add_uint64 (props, "PartitionOffset", 50 * gb);
+        props_add_uint64 (props, "PartitionSize", 40 * gb);
+        add_device (system, props);
+        g_free (device_file);
+
+        device_file = g_strdup_printf ("/dev/sd%up5", disk_number);
+        props = device_props_new (device_file, 20 * gb);
+        props_add_boolean (props, "DeviceIsPartition", TRUE);
+        props_add_object_path (props, "PartitionSlave", drive_object_path);
+        props_add_string (props, "PartitionScheme", "mbr");
+        props_add_string (props, "PartitionType", "0x83");
+        props_add_int (props, "PartitionNumber", 5);
+        props_add_uint64 (props, "PartitionOffset", 51 * gb);
+        props_add_uint64 (props, "PartitionSize", 20 * gb);
+        add_device (system, props);
+        g_free (device_file);
+}
+
+/* A running RAID-1 array with two whole-disk components */
+static void
+add_linux_md_array (SyntheticSystem *system,
+                    guint            array_number,
+                    guint            disk_number)
+{
+        GHashTable *props;
+        gchar *device_file;
+        gchar *uuid;
+        const gchar *slaves[3];
+        guint n;
+        guint64 gb = 1000 * 1000 * 1000;
+
+        uuid = g_strdup_printf ("00000000:00000000:00000000:%08x", array_number);
+
+        for (n = 0; n < 2; n++) {
+                device_file = g_strdup_printf ("/dev/sd%u", disk_number + n);
+                props = device_props_new (device_file, 100 * gb);
+                add_drive_props (props, NULL, disk_number + n);
+                props_add_string (props, "IdUsage", "raid");
+                props_add_string (props, "IdType", "linux_raid_member");
+                props_add_boolean (props, "DeviceIsLinuxMdComponent", TRUE);
+                props_add_string (props, "LinuxMdComponentLevel", "raid1");
+                props_add_int (props, "LinuxMdComponentPosition", n);
+                props_add_int (props, "LinuxMdComponentNumRaidDevices", 2);
+                props_add_string (props, "LinuxMdComponentUuid", uuid);
+                slaves[n] = add_device (system, props);
+                g_free (device_file);
+        }
+        slaves[2] = NULL;
+
+        device_file = g_strdup_printf ("/dev/md%u", array_number);
+        props = device_props_new (device_file, 100 * gb);
+        add_drive_props (props, NULL, disk_number + 2);
+        props_add_boolean (props, "DeviceIsLinuxMd", TRUE);
+        props_add_string (props, "LinuxMdState", "clean");
+        props_add_string (props, "LinuxMdLevel", "raid1");
+        props_add_int (props, "LinuxMdNumRaidDevices", 2);
+        props_add_string (props, "LinuxMdUuid", uuid);
+        props_add_object_path_array (props, "LinuxMdSlaves", slaves);
+        props_add_string (props, "LinuxMdSyncAction", "idle");
+        add_device (system, props);
+        g_free (device_file);
+
+        g_free (uuid);
+}
+
+static gchar *
+add_adapter (SyntheticSystem *system, guint adapter_number)
+{
+        GHashTable *props;
+        gchar *object_path;
+        gchar *s;
+
+        props = props_new ();
+        s = g_strdup_printf ("/sys/devices/pci0000:00/0000:00:%02x.0", adapter_number);
+        props_add_string (props, "NativePath", s);
+        g_free (s);
+        props_add_string (props, "Vendor", "ACME");
+        props_add_string (props, "Model", "Synthetic HBA");
+        props_add_string (props, "Driver", "synthetic");
+        props_add_string (props, "Fabric", "scsi_sas");
+        g_value_set_uint (props_add (props, "NumPorts", G_TYPE_UINT), DRIVES_PER_ADAPTER);
+
+        object_path = g_strdup_printf ("/org/freedesktop/UDisks/adapters/syn%u", adapter_number);
+        g_hash_table_insert (system->adapters, object_path, props);
+
+        return object_path;
+}
+
+static gchar *
+add_port (SyntheticSystem *system,
+          const gchar     *adapter_object_path,
+          guint            port_number)
+{
+        GHashTable *props;
+        gchar *object_path;
+        gchar *s;
+
+        object_path = g_strdup_printf ("/org/freedesktop/UDisks/ports/syn%u", port_number);
+
+        props = props_new ();
+        s = g_strdup_printf ("/sys/devices/synthetic/port%u", port_number);
+        props_add_string (props, "NativePath", s);
+        g_free (s);
+        props_add_object_path (props, "Adapter", adapter_object_path);
+        props_add_object_path (props, "Parent", adapter_object_path);
+        props_add_int (props, "Number", port_number % DRIVES_PER_ADAPTER);
+        props_add_string (props, "ConnectorType", "ata");
+        g_hash_table_insert (system->ports, object_path, props);
+
+        return object_path;
+}
+
+static SyntheticSystem *
+synthetic_system_new (guint num_devices)
+{
+        SyntheticSystem *system;
+        const gchar *adapter_object_path;
+        guint group;
+        guint disk_number;
+
+        system = g_new0 (SyntheticSystem, 1);
+        system->devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+        system->adapters = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+        system->ports = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+
+        adapter_object_path = NULL;
+        disk_number = 0;
+        for (group = 0; system->num_devices < num_devices; group++) {
+                /* every tenth group is a RAID array, the rest are partitioned disks on a HBA */
+                if (group % 10 == 9) {
+                        add_linux_md_array (system, group / 10, disk_number);
+                        disk_number += 3;
+                } else {
+                        const gchar *port_object_path;
+
+                        if (disk_number % DRIVES_PER_ADAPTER == 0 || adapter_object_path == NULL)
+                                adapter_object_path = add_adapter (system, g_hash_table_size (system->adapters));
+                        port_object_path = add_port (system, adapter_object_path, disk_number);
+                        add_partitioned_disk (system, port_object_path, disk_number);
+                        disk_number += 1;
+                }
+        }
+
+        return system;
+}
+
+static void
+synthetic_system_free (SyntheticSystem *system)
+{
+        g_hash_table_unref (system->devices);
+        g_hash_table_unref (system->adapters);
+        g_hash_table_unref (system->ports);
+        g_free (system);
+}
+
+static void
+add_objects (MduPool *pool, GHashTable *objects, const gchar *interface_name)
+{
+        GHashTableIter iter;
+        const gchar *object_path;
+        GHashTable *props;
+
+        g_hash_table_iter_init (&iter, objects);
+        while (g_hash_table_iter_next (&iter, (gpointer) &object_path, (gpointer) &props))
+                _mdu_pool_offline_set_object (pool, object_path, interface_name, props);
+}
+
+static MduPool *
+synthetic_pool_new (SyntheticSystem *system)
+{
+        MduPool *pool;
+
+        pool = _mdu_pool_new_offline ();
+        add_objects (pool, system->adapters, "org.freedesktop.UDisks.Adapter");
+        add_objects (pool, system->ports, "org.freedesktop.UDisks.Port");
+        add_objects (pool, system->devices, "org.freedesktop.UDisks.Device");
+        _mdu_pool_offline_prime (pool);
+
+        return pool;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef void (*BenchFunc) (MduPool *pool, SyntheticSystem *system);
+
+static void
+bench_pool_new (MduPool *pool, SyntheticSystem *system)
+{
+        _mdu_pool_free (synthetic_pool_new (system));
+}
+
+static void
+bench_recompute_presentables (MduPool *pool, SyntheticSystem *system)
+{
+        _mdu_pool_recompute_presentables (pool);
+}
+
+static void
+free_object_list (GList *list)
+{
+        g_list_foreach (list, (GFunc) g_object_unref, NULL);
+        g_list_free (list);
+}
+
+static void
+bench_get_devices (MduPool *pool, SyntheticSystem *system)
+{
+        free_object_list (mdu_pool_get_devices (pool));
+}
+
+static void
+bench_lookups (MduPool *pool, SyntheticSystem *system)
+{
+        GList *devices;
+        GList *l;
+
+        devices = mdu_pool_get_devices (pool);
+        for (l = devices; l != NULL; l = l->next) {
+                MduDevice *device = MDU_DEVICE (l->data);
+                MduDevice *d;
+                MduPresentable *p;
+
+                d = mdu_pool_get_by_object_path (pool, mdu_device_get_object_path (device));
+                g_object_unref (d);
+
+                d = mdu_pool_get_by_device_file (pool, mdu_device_get_device_file (device));
+                g_object_unref (d);
+
+                if (mdu_device_is_drive (device))
+                        p = mdu_pool_get_drive_by_device (pool, device);
+                else
+                        p = mdu_pool_get_volume_by_device (pool, device);
+                if (p != NULL) {
+                        MduPresentable *p2;
+
+                        p2 = mdu_pool_get_presentable_by_id (pool, mdu_presentable_get_id (p));
+                        if (p2 != NULL)
+                                g_object_unref (p2);
+                        g_object_unref (p);
+                }
+
+                if (mdu_device_is_linux_md (device)) {
+                        MduLinuxMdDrive *md;
+
+                        md = mdu_pool_get_linux_md_drive_by_uuid (pool, mdu_device_linux_md_get_uuid (device));
+                        if (md != NULL)
+                                g_object_unref (md);
+                }
+        }
+        free_object_list (devices);
+
+        devices = mdu_pool_get_adapters (pool);
+        for (l = devices; l != NULL; l = l->next) {
+                MduPresentable *hub;
+
+                hub = mdu_pool_get_hub_by_object_path (pool, mdu_adapter_get_object_path (MDU_ADAPTER (l->data)));
+                if (hub != NULL)
+                        g_object_unref (hub);
+        }
+        free_object_list (devices);
+}
+
+static void
+bench_get_enclosed (MduPool *pool, SyntheticSystem *system)
+{
+        GList *presentables;
+        GList *l;
+
+        presentables = mdu_pool_get_presentables (pool);
+        for (l = presentables; l != NULL; l = l->next) {
+                MduPresentable *p = MDU_PRESENTABLE (l->data);
+
+                if (!MDU_IS_HUB (p))
+                        continue;
+
+                free_object_list (mdu_presentable_get_enclosed (p));
+        }
+        free_object_list (presentables);
+}
+
+static void
+bench_get_holes (MduPool *pool, SyntheticSystem *system)
+{
+        GList *devices;
+        GList *presentables;
+        GList *l;
+
+        devices = mdu_pool_get_devices (pool);
+        presentables = mdu_pool_get_presentables (pool);
+        for (l = presentables; l != NULL; l = l->next) {
+                MduPresentable *p = MDU_PRESENTABLE (l->data);
+
+                if (!MDU_IS_DRIVE (p) || MDU_IS_LINUX_MD_DRIVE (p))
+                        continue;
+
+                free_object_list (_mdu_pool_get_holes_for_drive (pool, devices, MDU_DRIVE (p)));
+        }
+        free_object_list (presentables);
+        free_object_list (devices);
+}
+
+static void
+bench_decode_properties (MduPool *pool, SyntheticSystem *system)
+{
+        GList *devices;
+        GList *l;
+
+        devices = mdu_pool_get_devices (pool);
+        for (l = devices; l != NULL; l = l->next)
+                _mdu_device_changed (MDU_DEVICE (l->data));
+        free_object_list (devices);
+}
+
+static BenchResult *
+run_bench (const gchar     *name,
+           BenchFunc        func,
+           MduPool         *pool,
+           SyntheticSystem *system,
+           guint            num_devices)
+{
+        BenchResult *result;
+        GTimer *timer;
+        gdouble total;
+        guint n;
+
+        result = g_new0 (BenchResult, 1);
+        result->name = g_strdup (name);
+        result->num_devices = num_devices;
+        result->iterations = MAX (opt_iterations, 1);
+
+        timer = g_timer_new ();
+        total = 0;
+        for (n = 0; n < result->iterations; n++) {
+                gdouble usec;
+
+                g_timer_start (timer);
+                func (pool, system);
+                g_timer_stop (timer);
+
+                usec = g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC;
+                if (n == 0 || usec < result->min_usec)
+                        result->min_usec = usec;
+                total += usec;
+        }
+        result->mean_usec = total / result->iterations;
+        g_timer_destroy (timer);
+
+        g_printerr ("%-28s %6u devices: min %12.1f usec, mean %12.1f usec\n",
+                    result->name,
+                    result->num_devices,
+                    result->min_usec,
+                    result->mean_usec);
+
+        return result;
+}
+
+static void
+bench_result_free (BenchResult *result)
+{
+        g_free (result->name);
+        g_free (result);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gchar *
+results_to_json (GList *results)
+{
+        GString *str;
+        GList *l;
+
+        str = g_string_new (NULL);
+        g_string_append_printf (str, "{\n");
+        g_string_append_printf (str, "  \"version\": 1,\n");
+        g_string_append_printf (str, "  \"results\": [\n");
+        for (l = results; l != NULL; l = l->next) {
+                BenchResult *result = l->data;
+                gchar min_buf[G_ASCII_DTOSTR_BUF_SIZE];
+                gchar mean_buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+                /* one result per line - load_baseline() depends on this */
+                g_string_append_printf (str,
+                                        "    {\"name\": \"%s\", \"devices\": %u, \"iterations\": %u, "
+                                        "\"min_usec\": %s, \"mean_usec\": %s}%s\n",
+                                        result->name,
+                                        result->num_devices,
+                                        result->iterations,
+                                        g_ascii_formatd (min_buf, sizeof min_buf, "%.1f", result->min_usec),
+                                        g_ascii_formatd (mean_buf, sizeof mean_buf, "%.1f", result->mean_usec),
+                                        l->next != NULL ? "," : "");
+        }
+        g_string_append_printf (str, "  ]\n");
+        g_string_append_printf (str, "}\n");
+
+        return g_string_free (str, FALSE);
+}
+
+/* Returns a hash from "name/devices" to the baseline min_usec */
+static GHashTable *
+load_baseline (const gchar *filename, GError **error)
+{
+        GHashTable *ret;
+        gchar *contents;
+        gchar **lines;
+        guint n;
+
+        ret = NULL;
+        lines = NULL;
+
+        if (!g_file_get_contents (filename, &contents, NULL, error))
+                goto out;
+
+        ret = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+        lines = g_strsplit (contents, "\n", 0);
+        for (n = 0; lines[n] != NULL; n++) {
+                gchar name[64];
+                guint num_devices;
+                guint iterations;
+                gchar *s;
+                gdouble *min_usec;
+
+                if (sscanf (lines[n],
+                            " {\"name\": \"%63[^\"]\", \"devices\": %u, \"iterations\": %u, \"min_usec\": ",
+                            name,
+                            &num_devices,
+                            &iterations) != 3)
+                        continue;
+
+                s = strstr (lines[n], "\"min_usec\": ");
+                if (s == NULL)
+                        continue;
+
+                min_usec = g_new (gdouble, 1);
+                *min_usec = g_ascii_strtod (s + strlen ("\"min_usec\": "), NULL);
+                g_hash_table_insert (ret, g_strdup_printf ("%s/%u", name, num_devices), min_usec);
+        }
+        g_free (contents);
+
+ out:
+        g_strfreev (lines);
+        return ret;
+}
+
+static gboolean
+compare_with_baseline (GList *results, GHashTable *baseline)
+{
+        gboolean ret;
+        GList *l;
+
+        ret = TRUE;
+        for (l = results; l != NULL; l = l->next) {
+                BenchResult *result = l->data;
+                gdouble *baseline_usec;
+                gdouble change;
+                gchar *key;
+
+                key = g_strdup_printf ("%s/%u", result->name, result->num_devices);
+                baseline_usec = g_hash_table_lookup (baseline, key);
+                g_free (key);
+
+                if (baseline_usec == NULL || *baseline_usec <= 0)
+                        continue;
+
+                change = (result->min_usec - *baseline_usec) * 100.0 / *baseline_usec;
+                if (change > opt_threshold) {
+                        g_printerr ("REGRESSION: %s with %u devices: %.1f usec vs. baseline %.1f usec (%+.1f%%)\n",
+                                    result->name,
+                                    result->num_devices,
+                                    result->min_usec,
+                                    *baseline_usec,
+                                    change);
+                        ret = FALSE;
+                }
+        }
+
+        return ret;
+}
+
+int
+main (int argc, char *argv[])
+{
+        GOptionContext *context;
+        GError *error;
+        gchar **sizes;
+        GList *results;
+        gchar *json;
+        guint n;
+        int ret;
+
+        ret = 1;
+        context = NULL;
+        sizes = NULL;
+        results = NULL;
+        json = NULL;
+
+        g_type_init ();
+
+        context = g_option_context_new ("- benchmark libmdu");
+        g_option_context_add_main_entries (context, entries, NULL);
+        error = NULL;
+        if (!g_option_context_parse (context, &argc, &argv, &error)) {
+                g_printerr ("Could not parse arguments: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        sizes = g_strsplit (opt_sizes != NULL ? opt_sizes : "100,1000,10000", ",", 0);
+        for (n = 0; sizes[n] != NULL; n++) {
+                SyntheticSystem *system;
+                MduPool *pool;
+                guint num_devices;
+
+                num_devices = strtoul (sizes[n], NULL, 10);
+                if (num_devices == 0) {
+                        g_printerr ("Invalid pool size `%s'\n", sizes[n]);
+                        goto out;
+                }
+
+                system = synthetic_system_new (num_devices);
+                pool = synthetic_pool_new (system);
+
+                results = g_list_append (results, run_bench ("pool_new", bench_pool_new,
+                                                             pool, system, num_devices));
+                results = g_list_append (results, run_bench ("recompute_presentables", bench_recompute_presentables,
+                                                             pool, system, num_devices));
+                results = g_list_append (results, run_bench ("pool_get_devices", bench_get_devices,
+                                                             pool, system, num_devices));
+                results = g_list_append (results, run_bench ("pool_lookups", bench_lookups,
+                                                             pool, system, num_devices));
+                results = g_list_append (results, run_bench ("presentable_get_enclosed", bench_get_enclosed,
+                                                             pool, system, num_devices));
+                results = g_list_append (results, run_bench ("get_holes", bench_get_holes,
+                                                             pool, system, num_devices));
+                results = g_list_append (results, run_bench ("decode_properties", bench_decode_properties,
+                                                             pool, system, num_devices));
+
+                _mdu_pool_free (pool);
+                synthetic_system_free (system);
+        }
+
+        json = results_to_json (results);
+        if (opt_output != NULL) {
+                if (!g_file_set_contents (opt_output, json, -1, &error)) {
+                        g_printerr ("Error writing results: %s\n", error->message);
+                        g_error_free (error);
+                        goto out;
+                }
+        } else {
+                g_print ("%s", json);
+        }
+
+        ret = 0;
+
+        if (opt_baseline != NULL) {
+                GHashTable *baseline;
+
+                baseline = load_baseline (opt_baseline, &error);
+                if (baseline == NULL) {
+                        g_printerr ("Error loading baseline: %s\n", error->message);
+                        g_printerr ("Use \"make bench-baseline\" to create one\n");
+                        g_error_free (error);
+                        ret = 1;
+                } else {
+                        if (!compare_with_baseline (results, baseline)) {
+                                g_printerr ("Regressions of more than %.1f%% against baseline %s\n",
+                                            opt_threshold,
+                                            opt_baseline);
+                                ret = 1;
+                        }
+                        g_hash_table_unref (baseline);
+                }
+        }
+
+ out:
+        g_list_foreach (results, (GFunc) bench_result_free, NULL);
+        g_list_free (results);
+        g_free (json);
+        g_strfreev (sizes);
+        if (context != NULL)
+                g_option_context_free (context);
+        return ret;
+}
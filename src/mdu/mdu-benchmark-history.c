@@ -0,0 +1,1003 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-benchmark-history.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "mdu-private.h"
+#include "mdu-benchmark-history.h"
+#include "mdu-error.h"
+
+/**
+ * SECTION:mdu-benchmark-history
+ * @title: MduBenchmarkHistory
+ * @short_description: Every benchmark run of a drive
+ *
+ * #MduBenchmarkHistory keeps the results of all benchmark runs of a
+ * drive in a single file. Runs are only ever appended, so earlier
+ * results can be compared with the latest ones.
+ *
+ * The file is memory mapped and the samples are stored in the same
+ * layout as #MduBenchmarkSample and friends, so opening a history
+ * with thousands of runs only means walking the run headers. Files
+ * written on a machine with a different byte order or struct layout
+ * are refused rather than converted; after all, they live in the
+ * cache directory.
+ */
+
+/* The file starts with a FileHeader followed by records. Every record
+ * starts with its size and type so readers can skip types they don't
+ * know about; a change to existing records needs a new HISTORY_VERSION.
+ * All sizes and offsets are multiples of 8 so the samples in the
+ * mapped file are suitably aligned.
+ */
+#define HISTORY_MAGIC "MDUBHIST"
+#define HISTORY_VERSION 1
+#define HISTORY_BYTE_ORDER 0x01020304
+
+#define RECORD_TYPE_RUN 1
+
+#define ALIGN8(n) (((n) + 7) & ~((gsize) 7))
+
+/* No benchmark comes anywhere near this many samples, results or
+ * points; the limit keeps the size of a record from overflowing
+ */
+#define RUN_RECORD_MAX_ITEMS (1 << 20)
+
+/* Regressions are looked for in this many equally sized ranges of the
+ * device so a drop confined to e.g. the inner tracks or a worn-out
+ * region of flash isn't averaged away by the rest of the device.
+ */
+#define REGRESSION_NUM_BINS 20
+/* only the most recent runs make up the baseline, drives age */
+#define REGRESSION_MAX_BASELINE_RUNS 20
+#define REGRESSION_MIN_BASELINE_RUNS 3
+/* A range is flagged if it is at least this many standard deviations
+ * and this much worse than the baseline. The standard deviation is
+ * never taken to be less than REGRESSION_MIN_DEVIATION of the mean;
+ * otherwise a drive with very consistent results would be flagged for
+ * a difference no-one would care about.
+ */
+#define REGRESSION_MIN_Z_SCORE 3.0
+#define REGRESSION_MIN_CHANGE 0.10
+#define REGRESSION_MIN_DEVIATION 0.02
+
+typedef struct
+{
+        gchar   magic[8];
+        guint32 byte_order;
+        guint32 version;
+        guint32 header_size;
+        guint32 sample_size;
+        guint32 iops_result_size;
+        guint32 sweep_point_size;
+} FileHeader;
+
+typedef struct
+{
+        guint32 size;
+        guint32 type;
+} RecordHeader;
+
+/* followed by the samples, results and points in this order */
+typedef struct
+{
+        RecordHeader header;
+        guint64 time_collected;
+        guint64 disk_size;
+        guint32 mode;
+        guint32 flags;
+        guint32 io_engine;
+        guint32 queue_depth;
+        guint32 block_size;
+        guint32 num_workers;
+        guint32 direct_io;
+        guint32 num_read_samples;
+        guint32 num_write_samples;
+        guint32 num_access_samples;
+        guint32 num_iops_results;
+        guint32 num_sweep_points;
+} RunRecord;
+
+struct _MduBenchmarkHistoryPrivate
+{
+        gchar *filename;
+
+        /* NULL if the file doesn't exist yet */
+        GMappedFile *mapped_file;
+
+        /* offsets of the RunRecords in the mapped file, oldest first */
+        GArray *run_offsets;
+
+        /* where the next record goes; anything after this is a partially written record */
+        gsize valid_size;
+};
+
+G_DEFINE_TYPE (MduBenchmarkHistory, mdu_benchmark_history, G_TYPE_OBJECT);
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Returns 0 if a record with this many items would be too big for RecordHeader */
+static gsize
+run_record_get_size (guint num_read_samples,
+                     guint num_write_samples,
+                     guint num_access_samples,
+                     guint num_iops_results,
+                     guint num_sweep_points)
+{
+        const guint nums[5] = {
+                num_read_samples,
+                num_write_samples,
+                num_access_samples,
+                num_iops_results,
+                num_sweep_points
+        };
+        const gsize item_sizes[5] = {
+                sizeof (MduBenchmarkSample),
+                sizeof (MduBenchmarkSample),
+                sizeof (MduBenchmarkSample),
+                sizeof (MduBenchmarkIopsResult),
+                sizeof (MduBenchmarkSweepPoint)
+        };
+        gsize ret;
+        gsize n;
+
+        ret = ALIGN8 (sizeof (RunRecord));
+        for (n = 0; n < G_N_ELEMENTS (nums); n++) {
+                gsize items_size;
+
+                if (nums[n] > RUN_RECORD_MAX_ITEMS) {
+                        ret = 0;
+                        goto out;
+                }
+                items_size = ((gsize) nums[n]) * item_sizes[n];
+                if (items_size > G_MAXUINT32 - ret) {
+                        ret = 0;
+                        goto out;
+                }
+                ret += items_size;
+        }
+
+ out:
+        return ret;
+}
+
+static void
+history_unmap (MduBenchmarkHistory *history)
+{
+        if (history->priv->mapped_file != NULL) {
+                g_mapped_file_unref (history->priv->mapped_file);
+                history->priv->mapped_file = NULL;
+        }
+        g_array_set_size (history->priv->run_offsets, 0);
+        history->priv->valid_size = 0;
+}
+
+/* (Re-)maps the file and indexes the runs in it */
+static gboolean
+history_map (MduBenchmarkHistory  *history,
+             GError              **error)
+{
+        const gchar *contents;
+        const FileHeader *file_header;
+        gsize length;
+        gsize offset;
+        gboolean ret;
+        GError *local_error;
+
+        ret = FALSE;
+
+        history_unmap (history);
+
+        local_error = NULL;
+        history->priv->mapped_file = g_mapped_file_new (history->priv->filename, FALSE, &local_error);
+        if (history->priv->mapped_file == NULL) {
+                if (local_error->domain == G_FILE_ERROR && local_error->code == G_FILE_ERROR_NOENT) {
+                        /* no runs yet */
+                        g_error_free (local_error);
+                        ret = TRUE;
+                } else {
+                        g_propagate_error (error, local_error);
+                }
+                goto out;
+        }
+
+        contents = g_mapped_file_get_contents (history->priv->mapped_file);
+        length = g_mapped_file_get_length (history->priv->mapped_file);
+
+        /* an empty file is what a writer leaves behind if it crashes right away */
+        if (length == 0) {
+                ret = TRUE;
+                goto out;
+        }
+
+        file_header = (const FileHeader *) contents;
+        if (length < sizeof (FileHeader) ||
+            memcmp (file_header->magic, HISTORY_MAGIC, sizeof file_header->magic) != 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "%s is not a benchmark history",
+                             history->priv->filename);
+                goto out;
+        }
+        if (file_header->byte_order != HISTORY_BYTE_ORDER ||
+            file_header->version != HISTORY_VERSION ||
+            file_header->sample_size != sizeof (MduBenchmarkSample) ||
+            file_header->iops_result_size != sizeof (MduBenchmarkIopsResult) ||
+            file_header->sweep_point_size != sizeof (MduBenchmarkSweepPoint) ||
+            file_header->header_size < sizeof (FileHeader) ||
+            file_header->header_size % 8 != 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_NOT_SUPPORTED,
+                             "%s was written by an incompatible version or on another architecture",
+                             history->priv->filename);
+                goto out;
+        }
+
+        offset = MIN (file_header->header_size, length);
+        while (offset + sizeof (RecordHeader) <= length) {
+                const RecordHeader *record_header = (const RecordHeader *) (contents + offset);
+
+                if (record_header->size < sizeof (RecordHeader) ||
+                    record_header->size % 8 != 0 ||
+                    record_header->size > length - offset)
+                        break;
+
+                if (record_header->type == RECORD_TYPE_RUN) {
+                        const RunRecord *record = (const RunRecord *) record_header;
+
+                        if (record_header->size < sizeof (RunRecord) ||
+                            record_header->size != run_record_get_size (record->num_read_samples,
+                                                                        record->num_write_samples,
+                                                                        record->num_access_samples,
+                                                                        record->num_iops_results,
+                                                                        record->num_sweep_points))
+                                break;
+
+                        g_array_append_val (history->priv->run_offsets, offset);
+                }
+
+                offset += record_header->size;
+        }
+        history->priv->valid_size = offset;
+
+        ret = TRUE;
+
+ out:
+        if (!ret)
+                history_unmap (history);
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+mdu_benchmark_history_finalize (GObject *object)
+{
+        MduBenchmarkHistory *history = MDU_BENCHMARK_HISTORY (object);
+
+        history_unmap (history);
+        g_array_free (history->priv->run_offsets, TRUE);
+        g_free (history->priv->filename);
+
+        if (G_OBJECT_CLASS (mdu_benchmark_history_parent_class)->finalize != NULL)
+                G_OBJECT_CLASS (mdu_benchmark_history_parent_class)->finalize (object);
+}
+
+static void
+mdu_benchmark_history_class_init (MduBenchmarkHistoryClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        gobject_class->finalize = mdu_benchmark_history_finalize;
+
+        g_type_class_add_private (klass, sizeof (MduBenchmarkHistoryPrivate));
+}
+
+static void
+mdu_benchmark_history_init (MduBenchmarkHistory *history)
+{
+        history->priv = G_TYPE_INSTANCE_GET_PRIVATE (history, MDU_TYPE_BENCHMARK_HISTORY, MduBenchmarkHistoryPrivate);
+        history->priv->run_offsets = g_array_new (FALSE, FALSE, sizeof (gsize));
+}
+
+/**
+ * mdu_benchmark_history_new:
+ * @filename: The file the history is kept in.
+ * @error: Return location for error or %NULL.
+ *
+ * Opens the history kept in @filename. It is not an error if the
+ * file doesn't exist; it is created when the first run is appended.
+ *
+ * Returns: A #MduBenchmarkHistory or %NULL if @error is set. Free with
+ * g_object_unref().
+ */
+MduBenchmarkHistory *
+mdu_benchmark_history_new (const gchar  *filename,
+                           GError      **error)
+{
+        MduBenchmarkHistory *history;
+
+        g_return_val_if_fail (filename != NULL, NULL);
+
+        history = MDU_BENCHMARK_HISTORY (g_object_new (MDU_TYPE_BENCHMARK_HISTORY, NULL));
+        history->priv->filename = g_strdup (filename);
+
+        if (!history_map (history, error)) {
+                g_object_unref (history);
+                history = NULL;
+        }
+
+        return history;
+}
+
+/**
+ * mdu_benchmark_history_new_for_drive:
+ * @vendor: The vendor of the drive.
+ * @model: The model of the drive.
+ * @serial: The serial number of the drive.
+ * @wwn: The World Wide Name of the drive.
+ * @error: Return location for error or %NULL.
+ *
+ * Opens the history of the drive identified by @vendor, @model,
+ * @serial and @wwn in the user's cache directory. The firmware
+ * revision is deliberately not part of the key so the history
+ * survives firmware updates; comparing before and after is one of
+ * the reasons for keeping it. Any of the strings may be %NULL.
+ *
+ * Returns: A #MduBenchmarkHistory or %NULL if @error is set. Free with
+ * g_object_unref().
+ */
+MduBenchmarkHistory *
+mdu_benchmark_history_new_for_drive (const gchar  *vendor,
+                                     const gchar  *model,
+                                     const gchar  *serial,
+                                     const gchar  *wwn,
+                                     GError      **error)
+{
+        MduBenchmarkHistory *history;
+        gchar *key;
+        gchar *filename;
+
+        key = g_strdup_printf ("%s-%s-%s-%s.history",
+                               vendor != NULL ? vendor : "",
+                               model != NULL ? model : "",
+                               serial != NULL ? serial : "",
+                               wwn != NULL ? wwn : "");
+        g_strdelimit (key, "/", '_');
+        filename = g_build_filename (g_get_user_cache_dir (),
+                                     "mate-disk-utility",
+                                     "drive-benchmark",
+                                     key,
+                                     NULL);
+
+        history = mdu_benchmark_history_new (filename, error);
+
+        g_free (filename);
+        g_free (key);
+        return history;
+}
+
+/**
+ * mdu_benchmark_history_new_for_volume:
+ * @uuid: The UUID of the filesystem.
+ * @error: Return location for error or %NULL.
+ *
+ * Opens the history of filesystem benchmarks (see
+ * %MDU_BENCHMARK_MODE_FILESYSTEM) of the volume with @uuid in the
+ * user's cache directory. These are kept apart from the histories of
+ * drives so the same filesystem can be compared across the layers it
+ * sits on, e.g. before and after setting up encryption.
+ *
+ * Returns: A #MduBenchmarkHistory or %NULL if @error is set. Free with
+ * g_object_unref().
+ */
+MduBenchmarkHistory *
+mdu_benchmark_history_new_for_volume (const gchar  *uuid,
+                                      GError      **error)
+{
+        MduBenchmarkHistory *history;
+        gchar *key;
+        gchar *filename;
+
+        g_return_val_if_fail (uuid != NULL, NULL);
+
+        key = g_strdup_printf ("%s.history", uuid);
+        g_strdelimit (key, "/", '_');
+        filename = g_build_filename (g_get_user_cache_dir (),
+                                     "mate-disk-utility",
+                                     "volume-benchmark",
+                                     key,
+                                     NULL);
+
+        history = mdu_benchmark_history_new (filename, error);
+
+        g_free (filename);
+        g_free (key);
+        return history;
+}
+
+const gchar *
+mdu_benchmark_history_get_filename (MduBenchmarkHistory *history)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK_HISTORY (history), NULL);
+        return history->priv->filename;
+}
+
+/**
+ * mdu_benchmark_history_get_num_runs:
+ * @history: A #MduBenchmarkHistory.
+ *
+ * Gets the number of runs in @history.
+ *
+ * Returns: The number of runs.
+ */
+guint
+mdu_benchmark_history_get_num_runs (MduBenchmarkHistory *history)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK_HISTORY (history), 0);
+        return history->priv->run_offsets->len;
+}
+
+/**
+ * mdu_benchmark_history_get_run:
+ * @history: A #MduBenchmarkHistory.
+ * @index: The index of the run, 0 being the oldest.
+ * @out_run: Return location for the run.
+ *
+ * Gets a run from @history. This doesn't copy any samples.
+ *
+ * Returns: %TRUE if @out_run was set, %FALSE if @index is out of range.
+ */
+gboolean
+mdu_benchmark_history_get_run (MduBenchmarkHistory    *history,
+                               guint                   index,
+                               MduBenchmarkHistoryRun *out_run)
+{
+        const gchar *contents;
+        const RunRecord *record;
+        const gchar *p;
+
+        g_return_val_if_fail (MDU_IS_BENCHMARK_HISTORY (history), FALSE);
+        g_return_val_if_fail (out_run != NULL, FALSE);
+
+        if (index >= history->priv->run_offsets->len)
+                return FALSE;
+
+        contents = g_mapped_file_get_contents (history->priv->mapped_file);
+        record = (const RunRecord *) (contents + g_array_index (history->priv->run_offsets, gsize, index));
+
+        out_run->time_collected = record->time_collected;
+        out_run->disk_size = record->disk_size;
+        out_run->mode = record->mode;
+        out_run->flags = record->flags;
+        out_run->io_engine = record->io_engine;
+        out_run->queue_depth = record->queue_depth;
+        out_run->block_size = record->block_size;
+        out_run->num_workers = record->num_workers;
+        out_run->direct_io = record->direct_io;
+
+        p = ((const gchar *) record) + ALIGN8 (sizeof (RunRecord));
+        out_run->read_samples = (const MduBenchmarkSample *) p;
+        out_run->num_read_samples = record->num_read_samples;
+        p += record->num_read_samples * sizeof (MduBenchmarkSample);
+        out_run->write_samples = (const MduBenchmarkSample *) p;
+        out_run->num_write_samples = record->num_write_samples;
+        p += record->num_write_samples * sizeof (MduBenchmarkSample);
+        out_run->access_samples = (const MduBenchmarkSample *) p;
+        out_run->num_access_samples = record->num_access_samples;
+        p += record->num_access_samples * sizeof (MduBenchmarkSample);
+        out_run->iops_results = (const MduBenchmarkIopsResult *) p;
+        out_run->num_iops_results = record->num_iops_results;
+        p += record->num_iops_results * sizeof (MduBenchmarkIopsResult);
+        out_run->sweep_points = (const MduBenchmarkSweepPoint *) p;
+        out_run->num_sweep_points = record->num_sweep_points;
+
+        return TRUE;
+}
+
+static gboolean
+write_all (gint           fd,
+           const gchar   *data,
+           gsize          size,
+           off_t          offset,
+           const gchar   *filename,
+           GError       **error)
+{
+        gssize num_written;
+
+        while (size > 0) {
+                num_written = pwrite (fd, data, size, offset);
+                if (num_written < 0) {
+                        gint errsv = errno;
+                        if (errsv == EINTR)
+                                continue;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error writing to %s: %s",
+                                     filename,
+                                     g_strerror (errsv));
+                        return FALSE;
+                }
+                data += num_written;
+                size -= num_written;
+                offset += num_written;
+        }
+        return TRUE;
+}
+
+/**
+ * mdu_benchmark_history_append_run:
+ * @history: A #MduBenchmarkHistory.
+ * @run: The run to append.
+ * @error: Return location for error or %NULL.
+ *
+ * Appends @run to @history and to the file it is kept in, creating the
+ * file and its directory if needed. Runs appended by other processes
+ * in the meantime are picked up as well.
+ *
+ * Note that this remaps the file so any #MduBenchmarkHistoryRun
+ * previously returned by mdu_benchmark_history_get_run() is invalid
+ * afterwards.
+ *
+ * Returns: %TRUE if @run was appended, %FALSE if @error is set.
+ */
+gboolean
+mdu_benchmark_history_append_run (MduBenchmarkHistory           *history,
+                                  const MduBenchmarkHistoryRun  *run,
+                                  GError                       **error)
+{
+        FileHeader file_header;
+        RunRecord *record;
+        gsize record_size;
+        gchar *buffer;
+        gchar *p;
+        gchar *dirname;
+        gint fd;
+        gint errsv;
+        gboolean ret;
+
+        g_return_val_if_fail (MDU_IS_BENCHMARK_HISTORY (history), FALSE);
+        g_return_val_if_fail (run != NULL, FALSE);
+
+        ret = FALSE;
+        fd = -1;
+        buffer = NULL;
+
+        /* build the record first so the file is locked as briefly as possible */
+        record_size = run_record_get_size (run->num_read_samples,
+                                           run->num_write_samples,
+                                           run->num_access_samples,
+                                           run->num_iops_results,
+                                           run->num_sweep_points);
+        if (record_size == 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_NOT_SUPPORTED,
+                             "Too many samples, results or points in run for %s",
+                             history->priv->filename);
+                goto out;
+        }
+        buffer = g_malloc0 (record_size);
+        record = (RunRecord *) buffer;
+        record->header.size = record_size;
+        record->header.type = RECORD_TYPE_RUN;
+        record->time_collected = run->time_collected;
+        record->disk_size = run->disk_size;
+        record->mode = run->mode;
+        record->flags = run->flags;
+        record->io_engine = run->io_engine;
+        record->queue_depth = run->queue_depth;
+        record->block_size = run->block_size;
+        record->num_workers = run->num_workers;
+        record->direct_io = run->direct_io;
+        record->num_read_samples = run->num_read_samples;
+        record->num_write_samples = run->num_write_samples;
+        record->num_access_samples = run->num_access_samples;
+        record->num_iops_results = run->num_iops_results;
+        record->num_sweep_points = run->num_sweep_points;
+        p = buffer + ALIGN8 (sizeof (RunRecord));
+        memcpy (p, run->read_samples, run->num_read_samples * sizeof (MduBenchmarkSample));
+        p += run->num_read_samples * sizeof (MduBenchmarkSample);
+        memcpy (p, run->write_samples, run->num_write_samples * sizeof (MduBenchmarkSample));
+        p += run->num_write_samples * sizeof (MduBenchmarkSample);
+        memcpy (p, run->access_samples, run->num_access_samples * sizeof (MduBenchmarkSample));
+        p += run->num_access_samples * sizeof (MduBenchmarkSample);
+        memcpy (p, run->iops_results, run->num_iops_results * sizeof (MduBenchmarkIopsResult));
+        p += run->num_iops_results * sizeof (MduBenchmarkIopsResult);
+        memcpy (p, run->sweep_points, run->num_sweep_points * sizeof (MduBenchmarkSweepPoint));
+
+        dirname = g_path_get_dirname (history->priv->filename);
+        if (g_mkdir_with_parents (dirname, 0755) != 0) {
+                errsv = errno;
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error creating directory %s: %s",
+                             dirname,
+                             g_strerror (errsv));
+                g_free (dirname);
+                goto out;
+        }
+        g_free (dirname);
+
+        fd = g_open (history->priv->filename, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+                errsv = errno;
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error opening %s: %s",
+                             history->priv->filename,
+                             g_strerror (errsv));
+                goto out;
+        }
+
+        /* serialize with other writers; readers never see more than valid_size anyway */
+        while (flock (fd, LOCK_EX) != 0) {
+                errsv = errno;
+                if (errsv == EINTR)
+                        continue;
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error locking %s: %s",
+                             history->priv->filename,
+                             g_strerror (errsv));
+                goto out;
+        }
+
+        if (!history_map (history, error))
+                goto out;
+
+        if (history->priv->valid_size == 0) {
+                memset (&file_header, 0, sizeof (FileHeader));
+                memcpy (file_header.magic, HISTORY_MAGIC, sizeof file_header.magic);
+                file_header.byte_order = HISTORY_BYTE_ORDER;
+                file_header.version = HISTORY_VERSION;
+                file_header.header_size = ALIGN8 (sizeof (FileHeader));
+                file_header.sample_size = sizeof (MduBenchmarkSample);
+                file_header.iops_result_size = sizeof (MduBenchmarkIopsResult);
+                file_header.sweep_point_size = sizeof (MduBenchmarkSweepPoint);
+                if (!write_all (fd, (const gchar *) &file_header, sizeof (FileHeader), 0,
+                                history->priv->filename, error))
+                        goto out;
+                history->priv->valid_size = ALIGN8 (sizeof (FileHeader));
+        }
+
+        /* drop whatever a crashed writer left after the last complete record */
+        if (ftruncate (fd, history->priv->valid_size) != 0 ||
+            !write_all (fd, buffer, record_size, history->priv->valid_size, history->priv->filename, error) ||
+            fdatasync (fd) != 0) {
+                if (error == NULL || *error == NULL) {
+                        errsv = errno;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error writing to %s: %s",
+                                     history->priv->filename,
+                                     g_strerror (errsv));
+                }
+                goto out;
+        }
+
+        if (!history_map (history, error))
+                goto out;
+
+        ret = TRUE;
+
+ out:
+        if (fd >= 0)
+                close (fd); /* also drops the lock */
+        g_free (buffer);
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static const MduBenchmarkSample *
+run_get_samples (const MduBenchmarkHistoryRun *run,
+                 MduBenchmarkRegressionKind    kind,
+                 guint                        *out_num_samples)
+{
+        switch (kind) {
+        case MDU_BENCHMARK_REGRESSION_KIND_READ_RATE:
+                *out_num_samples = run->num_read_samples;
+                return run->read_samples;
+        case MDU_BENCHMARK_REGRESSION_KIND_WRITE_RATE:
+                *out_num_samples = run->num_write_samples;
+                return run->write_samples;
+        case MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME:
+                *out_num_samples = run->num_access_samples;
+                return run->access_samples;
+        }
+        g_assert_not_reached ();
+        return NULL;
+}
+
+/* Runs with different settings measure different things, e.g. a
+ * queue depth of 1 vs. 32; comparing them would only flag the change
+ * of settings.
+ */
+static gboolean
+runs_are_comparable (const MduBenchmarkHistoryRun *a,
+                     const MduBenchmarkHistoryRun *b)
+{
+        return a->mode == b->mode &&
+                a->queue_depth == b->queue_depth &&
+                a->block_size == b->block_size &&
+                a->num_workers == b->num_workers &&
+                a->direct_io == b->direct_io;
+}
+
+/* Averages the samples of @kind in each bin; runs of differently sized
+ * devices (e.g. after a resize of a virtual disk) are compared by
+ * relative position.
+ */
+static gboolean
+run_get_bin_means (const MduBenchmarkHistoryRun *run,
+                   MduBenchmarkRegressionKind    kind,
+                   gdouble                      *out_means,
+                   gboolean                     *out_have)
+{
+        const MduBenchmarkSample *samples;
+        guint counts[REGRESSION_NUM_BINS];
+        guint num_samples;
+        guint bin;
+        guint n;
+
+        samples = run_get_samples (run, kind, &num_samples);
+        if (num_samples == 0 || run->disk_size == 0)
+                return FALSE;
+
+        memset (counts, 0, sizeof counts);
+        memset (out_means, 0, REGRESSION_NUM_BINS * sizeof (gdouble));
+        for (n = 0; n < num_samples; n++) {
+                bin = MIN (samples[n].offset * REGRESSION_NUM_BINS / run->disk_size, REGRESSION_NUM_BINS - 1);
+                out_means[bin] += samples[n].value;
+                counts[bin]++;
+        }
+        for (bin = 0; bin < REGRESSION_NUM_BINS; bin++) {
+                out_have[bin] = (counts[bin] > 0);
+                if (counts[bin] > 0)
+                        out_means[bin] /= counts[bin];
+        }
+        return TRUE;
+}
+
+static void
+find_regressions_for_kind (MduBenchmarkHistory          *history,
+                           guint                         index,
+                           const MduBenchmarkHistoryRun *run,
+                           MduBenchmarkRegressionKind    kind,
+                           GArray                       *regressions,
+                           guint                        *out_num_baseline_runs)
+{
+        MduBenchmarkHistoryRun other;
+        MduBenchmarkRegression regression;
+        gdouble means[REGRESSION_NUM_BINS];
+        gboolean have[REGRESSION_NUM_BINS];
+        gdouble other_means[REGRESSION_NUM_BINS];
+        gboolean other_have[REGRESSION_NUM_BINS];
+        gdouble sum[REGRESSION_NUM_BINS];
+        gdouble sum_sq[REGRESSION_NUM_BINS];
+        guint count[REGRESSION_NUM_BINS];
+        gdouble z_scores[REGRESSION_NUM_BINS];
+        gboolean flagged[REGRESSION_NUM_BINS];
+        guint num_baseline_runs;
+        guint bin;
+        guint end;
+        gint m;
+
+        *out_num_baseline_runs = 0;
+
+        if (!run_get_bin_means (run, kind, means, have))
+                return;
+
+        memset (sum, 0, sizeof sum);
+        memset (sum_sq, 0, sizeof sum_sq);
+        memset (count, 0, sizeof count);
+        num_baseline_runs = 0;
+        for (m = index - 1; m >= 0 && num_baseline_runs < REGRESSION_MAX_BASELINE_RUNS; m--) {
+                mdu_benchmark_history_get_run (history, m, &other);
+                if (!runs_are_comparable (run, &other))
+                        continue;
+                if (!run_get_bin_means (&other, kind, other_means, other_have))
+                        continue;
+                for (bin = 0; bin < REGRESSION_NUM_BINS; bin++) {
+                        if (!other_have[bin])
+                                continue;
+                        sum[bin] += other_means[bin];
+                        sum_sq[bin] += other_means[bin] * other_means[bin];
+                        count[bin]++;
+                }
+                num_baseline_runs++;
+        }
+        *out_num_baseline_runs = num_baseline_runs;
+
+        for (bin = 0; bin < REGRESSION_NUM_BINS; bin++) {
+                gdouble mean;
+                gdouble variance;
+                gdouble deviation;
+                gdouble worse_by;
+
+                flagged[bin] = FALSE;
+                if (!have[bin] || count[bin] < REGRESSION_MIN_BASELINE_RUNS)
+                        continue;
+
+                mean = sum[bin] / count[bin];
+                if (mean <= 0)
+                        continue;
+                /* sample variance of the per-run means */
+                variance = (sum_sq[bin] - count[bin] * mean * mean) / (count[bin] - 1);
+                deviation = sqrt (MAX (variance, 0.0));
+                deviation = MAX (deviation, mean * REGRESSION_MIN_DEVIATION);
+
+                if (kind == MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME)
+                        worse_by = means[bin] - mean;
+                else
+                        worse_by = mean - means[bin];
+
+                z_scores[bin] = worse_by / deviation;
+                if (z_scores[bin] >= REGRESSION_MIN_Z_SCORE && worse_by / mean >= REGRESSION_MIN_CHANGE) {
+                        flagged[bin] = TRUE;
+                        /* reuse sum as the baseline mean */
+                        sum[bin] = mean;
+                }
+        }
+
+        /* report each run of adjacent flagged bins as one range */
+        for (bin = 0; bin < REGRESSION_NUM_BINS; bin = end) {
+                guint n;
+
+                end = bin + 1;
+                if (!flagged[bin])
+                        continue;
+                while (end < REGRESSION_NUM_BINS && flagged[end])
+                        end++;
+
+                memset (&regression, 0, sizeof (MduBenchmarkRegression));
+                regression.kind = kind;
+                regression.start_offset = run->disk_size * bin / REGRESSION_NUM_BINS;
+                regression.end_offset = run->disk_size * end / REGRESSION_NUM_BINS;
+                regression.z_score = G_MAXDOUBLE;
+                regression.num_baseline_runs = num_baseline_runs;
+                for (n = bin; n < end; n++) {
+                        regression.baseline_value += sum[n];
+                        regression.value += means[n];
+                        regression.z_score = MIN (regression.z_score, z_scores[n]);
+                }
+                regression.baseline_value /= end - bin;
+                regression.value /= end - bin;
+                g_array_append_val (regressions, regression);
+        }
+}
+
+/**
+ * mdu_benchmark_history_find_regressions:
+ * @history: A #MduBenchmarkHistory.
+ * @index: The index of the run to check.
+ * @out_num_baseline_runs: Return location for the number of earlier runs
+ *   compared with or %NULL.
+ *
+ * Compares the run at @index with the earlier runs of the drive that
+ * used the same settings. The device is divided into equally sized
+ * ranges and a range is reported if the run is both significantly and
+ * considerably slower there than the runs before it, e.g. because the
+ * drive is failing or the link came up at a lower speed.
+ *
+ * At least three earlier comparable runs are needed for a baseline;
+ * if @out_num_baseline_runs is less than that, nothing was checked.
+ *
+ * Returns: A #GArray of #MduBenchmarkRegression ordered by kind and
+ * offset. Free with g_array_unref().
+ */
+GArray *
+mdu_benchmark_history_find_regressions (MduBenchmarkHistory *history,
+                                        guint                index,
+                                        guint               *out_num_baseline_runs)
+{
+        MduBenchmarkHistoryRun run;
+        GArray *regressions;
+        guint num_baseline_runs;
+        guint max_baseline_runs;
+        guint kind;
+
+        g_return_val_if_fail (MDU_IS_BENCHMARK_HISTORY (history), NULL);
+
+        regressions = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkRegression));
+        max_baseline_runs = 0;
+
+        if (!mdu_benchmark_history_get_run (history, index, &run))
+                goto out;
+
+        for (kind = MDU_BENCHMARK_REGRESSION_KIND_READ_RATE; kind <= MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME; kind++) {
+                find_regressions_for_kind (history, index, &run, kind, regressions, &num_baseline_runs);
+                max_baseline_runs = MAX (max_baseline_runs, num_baseline_runs);
+        }
+
+ out:
+        if (out_num_baseline_runs != NULL)
+                *out_num_baseline_runs = max_baseline_runs;
+        return regressions;
+}
+
+/**
+ * mdu_benchmark_history_run_init_from_benchmark:
+ * @run: The #MduBenchmarkHistoryRun to initialize.
+ * @benchmark: A #MduBenchmark that just completed a run.
+ * @flags: The flags the run was started with.
+ *
+ * Fills in @run with the results and settings of the last run of
+ * @benchmark, e.g. to pass it to mdu_benchmark_history_append_run().
+ * The samples are not copied so @run is only valid until @benchmark
+ * is run again or freed.
+ */
+void
+mdu_benchmark_history_run_init_from_benchmark (MduBenchmarkHistoryRun *run,
+                                               MduBenchmark           *benchmark,
+                                               MduBenchmarkFlags       flags)
+{
+        GArray *a;
+
+        g_return_if_fail (run != NULL);
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+
+        memset (run, 0, sizeof (MduBenchmarkHistoryRun));
+        run->time_collected = time (NULL);
+        run->disk_size = mdu_benchmark_get_size (benchmark);
+        run->mode = mdu_benchmark_get_mode (benchmark);
+        run->flags = flags;
+        run->io_engine = mdu_benchmark_get_io_engine_used (benchmark);
+        run->queue_depth = mdu_benchmark_get_queue_depth (benchmark);
+        run->block_size = mdu_benchmark_get_block_size (benchmark);
+        run->num_workers = mdu_benchmark_get_num_workers (benchmark);
+        run->direct_io = mdu_benchmark_get_direct_io (benchmark);
+
+        a = mdu_benchmark_get_read_transfer_rate_samples (benchmark);
+        run->read_samples = (const MduBenchmarkSample *) a->data;
+        run->num_read_samples = a->len;
+        a = mdu_benchmark_get_write_transfer_rate_samples (benchmark);
+        run->write_samples = (const MduBenchmarkSample *) a->data;
+        run->num_write_samples = a->len;
+        a = mdu_benchmark_get_access_time_samples (benchmark);
+        run->access_samples = (const MduBenchmarkSample *) a->data;
+        run->num_access_samples = a->len;
+        a = mdu_benchmark_get_iops_results (benchmark);
+        run->iops_results = (const MduBenchmarkIopsResult *) a->data;
+        run->num_iops_results = a->len;
+        a = mdu_benchmark_get_sweep_results (benchmark);
+        run->sweep_points = (const MduBenchmarkSweepPoint *) a->data;
+        run->num_sweep_points = a->len;
+}
@@ -0,0 +1,179 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-benchmark-history.h
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#if !defined (__MDU_INSIDE_MDU_H) && !defined (MDU_COMPILATION)
+#error "Only <mdu/mdu.h> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef __MDU_BENCHMARK_HISTORY_H
+#define __MDU_BENCHMARK_HISTORY_H
+
+#include <mdu/mdu-types.h>
+#include <mdu/mdu-benchmark.h>
+
+G_BEGIN_DECLS
+
+#define MDU_TYPE_BENCHMARK_HISTORY         (mdu_benchmark_history_get_type ())
+#define MDU_BENCHMARK_HISTORY(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), MDU_TYPE_BENCHMARK_HISTORY, MduBenchmarkHistory))
+#define MDU_BENCHMARK_HISTORY_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST ((k), MDU_BENCHMARK_HISTORY,  MduBenchmarkHistoryClass))
+#define MDU_IS_BENCHMARK_HISTORY(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), MDU_TYPE_BENCHMARK_HISTORY))
+#define MDU_IS_BENCHMARK_HISTORY_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), MDU_TYPE_BENCHMARK_HISTORY))
+#define MDU_BENCHMARK_HISTORY_GET_CLASS(k) (G_TYPE_INSTANCE_GET_CLASS ((k), MDU_TYPE_BENCHMARK_HISTORY, MduBenchmarkHistoryClass))
+
+typedef struct _MduBenchmarkHistoryClass       MduBenchmarkHistoryClass;
+typedef struct _MduBenchmarkHistoryPrivate     MduBenchmarkHistoryPrivate;
+typedef struct _MduBenchmarkHistoryRun         MduBenchmarkHistoryRun;
+typedef struct _MduBenchmarkRegression         MduBenchmarkRegression;
+
+struct _MduBenchmarkHistory
+{
+        GObject parent;
+
+        /* private */
+        MduBenchmarkHistoryPrivate *priv;
+};
+
+struct _MduBenchmarkHistoryClass
+{
+        GObjectClass parent_class;
+};
+
+/**
+ * MduBenchmarkHistoryRun:
+ * @time_collected: When the run finished, in seconds since the Epoch.
+ * @disk_size: The size of the device; the offsets of all samples are below this.
+ * @mode: What was measured.
+ * @flags: The flags the run was started with.
+ * @io_engine: The I/O engine used.
+ * @queue_depth: Requests in flight per worker, or 0 if the run was done
+ *   by the udisks daemon and the parameters are not known.
+ * @block_size: The size of the requests used for the transfer rate.
+ * @num_workers: The number of workers.
+ * @direct_io: Whether the page cache was bypassed.
+ * @read_samples: Read transfer rates, see mdu_benchmark_get_read_transfer_rate_samples().
+ * @num_read_samples: Number of elements in @read_samples.
+ * @write_samples: Write transfer rates, see mdu_benchmark_get_write_transfer_rate_samples().
+ * @num_write_samples: Number of elements in @write_samples.
+ * @access_samples: Access times, see mdu_benchmark_get_access_time_samples().
+ * @num_access_samples: Number of elements in @access_samples.
+ * @iops_results: Random read results, see mdu_benchmark_get_iops_results().
+ * @num_iops_results: Number of elements in @iops_results.
+ * @sweep_points: Block size sweep results, see mdu_benchmark_get_sweep_results().
+ * @num_sweep_points: Number of elements in @sweep_points.
+ *
+ * A benchmark run as stored in a #MduBenchmarkHistory. When returned by
+ * mdu_benchmark_history_get_run() the arrays point into the mapped
+ * file and stay valid as long as the #MduBenchmarkHistory is alive.
+ */
+struct _MduBenchmarkHistoryRun
+{
+        guint64 time_collected;
+        guint64 disk_size;
+        MduBenchmarkMode mode;
+        MduBenchmarkFlags flags;
+        MduBenchmarkIOEngine io_engine;
+        guint queue_depth;
+        guint block_size;
+        guint num_workers;
+        gboolean direct_io;
+
+        const MduBenchmarkSample *read_samples;
+        guint num_read_samples;
+        const MduBenchmarkSample *write_samples;
+        guint num_write_samples;
+        const MduBenchmarkSample *access_samples;
+        guint num_access_samples;
+        const MduBenchmarkIopsResult *iops_results;
+        guint num_iops_results;
+        const MduBenchmarkSweepPoint *sweep_points;
+        guint num_sweep_points;
+};
+
+/**
+ * MduBenchmarkRegressionKind:
+ * @MDU_BENCHMARK_REGRESSION_KIND_READ_RATE: The read transfer rate dropped.
+ * @MDU_BENCHMARK_REGRESSION_KIND_WRITE_RATE: The write transfer rate dropped.
+ * @MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME: The access time went up.
+ *
+ * What got worse in a #MduBenchmarkRegression.
+ */
+typedef enum {
+        MDU_BENCHMARK_REGRESSION_KIND_READ_RATE,
+        MDU_BENCHMARK_REGRESSION_KIND_WRITE_RATE,
+        MDU_BENCHMARK_REGRESSION_KIND_ACCESS_TIME
+} MduBenchmarkRegressionKind;
+
+/**
+ * MduBenchmarkRegression:
+ * @kind: What got worse.
+ * @start_offset: Where on the device the affected range starts.
+ * @end_offset: Where on the device the affected range ends.
+ * @baseline_value: The mean of earlier runs in the range, in bytes per
+ *   second or seconds depending on @kind.
+ * @value: The mean of the run in the range.
+ * @z_score: How many standard deviations of the earlier runs @value is
+ *   away from @baseline_value, at least.
+ * @num_baseline_runs: The number of earlier runs compared with.
+ *
+ * A range of the device where a run performed significantly worse
+ * than earlier runs, see mdu_benchmark_history_find_regressions().
+ */
+struct _MduBenchmarkRegression
+{
+        MduBenchmarkRegressionKind kind;
+        guint64 start_offset;
+        guint64 end_offset;
+        gdouble baseline_value;
+        gdouble value;
+        gdouble z_score;
+        guint num_baseline_runs;
+};
+
+GType                 mdu_benchmark_history_get_type       (void);
+MduBenchmarkHistory  *mdu_benchmark_history_new            (const gchar                   *filename,
+                                                            GError                       **error);
+MduBenchmarkHistory  *mdu_benchmark_history_new_for_drive  (const gchar                   *vendor,
+                                                            const gchar                   *model,
+                                                            const gchar                   *serial,
+                                                            const gchar                   *wwn,
+                                                            GError                       **error);
+MduBenchmarkHistory  *mdu_benchmark_history_new_for_volume (const gchar                   *uuid,
+                                                            GError                       **error);
+const gchar          *mdu_benchmark_history_get_filename   (MduBenchmarkHistory           *history);
+guint                 mdu_benchmark_history_get_num_runs   (MduBenchmarkHistory           *history);
+gboolean              mdu_benchmark_history_get_run        (MduBenchmarkHistory           *history,
+                                                            guint                          index,
+                                                            MduBenchmarkHistoryRun        *out_run);
+gboolean              mdu_benchmark_history_append_run     (MduBenchmarkHistory           *history,
+                                                            const MduBenchmarkHistoryRun  *run,
+                                                            GError                       **error);
+
+GArray               *mdu_benchmark_history_find_regressions (MduBenchmarkHistory  *history,
+                                                              guint                 index,
+                                                              guint                *out_num_baseline_runs);
+
+void                  mdu_benchmark_history_run_init_from_benchmark (MduBenchmarkHistoryRun *run,
+                                                                     MduBenchmark           *benchmark,
+                                                                     MduBenchmarkFlags       flags);
+
+G_END_DECLS
+
+#endif /* __MDU_BENCHMARK_HISTORY_H */
@@ -0,0 +1,3073 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-benchmark.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#define _GNU_SOURCE
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/sysmacros.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#include <linux/fiemap.h>
+#include <glib/gstdio.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+#ifdef HAVE_LIBAIO
+#include <libaio.h>
+#endif
+
+#include "mdu-private.h"
+#include "mdu-benchmark.h"
+#include "mdu-error.h"
+
+/**
+ * SECTION:mdu-benchmark
+ * @title: MduBenchmark
+ * @short_description: Measure the performance of a block device
+ *
+ * #MduBenchmark measures the sequential transfer rate and the access
+ * time of a block device (or a regular file) from within the calling
+ * process. Unlike the DriveBenchmark method of the udisks daemon, I/O
+ * is issued with O_DIRECT and several requests in flight per worker,
+ * see mdu_benchmark_set_queue_depth(), so the numbers reflect what the
+ * device can do rather than what a single synchronous reader sees.
+ *
+ * The benchmark runs in a separate thread so the GLib thread system
+ * must be initialized before calling mdu_benchmark_run_async().
+ */
+
+/* number of evenly spread regions the transfer rate is measured at */
+#define NUM_TRANSFER_RATE_SAMPLES 100
+
+/* the size of each such region */
+#define TRANSFER_RATE_SAMPLE_SIZE (32 * 1024 * 1024)
+
+/* number of random reads for measuring the access time, issued in
+ * batches to be able to report progress
+ */
+#define NUM_ACCESS_TIME_SAMPLES 1000
+#define NUM_ACCESS_TIME_BATCHES 10
+
+/* the queue depths random reads are measured at and for how long */
+static const guint random_queue_depths[] = {1, 4, 32};
+#define RANDOM_PASS_USEC (10 * G_USEC_PER_SEC)
+
+/* size of the random reads */
+#define RANDOM_REQUEST_SIZE 4096
+
+/* the request sizes the sweep goes through, doubling each time, and
+ * for how long each is measured
+ */
+#define SWEEP_MIN_BLOCK_SIZE (4 * 1024)
+#define SWEEP_MAX_BLOCK_SIZE (8 * 1024 * 1024)
+#define SWEEP_PASS_USEC (2 * G_USEC_PER_SEC)
+
+/* each sweep pass reads this region over and over; it's much larger
+ * than the cache of any drive so cache hits don't inflate the numbers
+ */
+#define SWEEP_REGION_SIZE G_GUINT64_CONSTANT (1073741824)
+
+/* the queue depth is lowered for large requests to keep the buffers
+ * of a worker below this size
+ */
+#define SWEEP_MAX_BYTES_IN_FLIGHT (64 * 1024 * 1024)
+
+/* the optimal block size is the smallest one getting this close to the peak */
+#define SWEEP_OPTIMUM_FRACTION 0.95
+
+/* MDU_BENCHMARK_MODE_SEQUENTIAL reads for this long, taking a sample every second */
+#define SEQUENTIAL_USEC (30 * G_USEC_PER_SEC)
+#define SEQUENTIAL_SAMPLE_USEC G_USEC_PER_SEC
+
+/* the minimum alignment for O_DIRECT buffers, offsets and sizes */
+#define MIN_ALIGNMENT 4096
+
+/* unallocated space next to partitions may still hold partition table
+ * structures, e.g. the GPT at either end of the device or the EBRs of
+ * logical partitions, so writes keep this far from the edges of the
+ * regions passed to mdu_benchmark_set_write_regions()
+ */
+#define WRITE_REGION_MARGIN (1024 * 1024)
+
+/* the largest temporary file written with mdu_benchmark_set_scratch_directory(),
+ * it never takes more than half of the free space
+ */
+#define SCRATCH_FILE_SIZE G_GUINT64_CONSTANT (1073741824)
+
+/* MDU_BENCHMARK_MODE_FILESYSTEM measures random reads and writes at this
+ * queue depth, for RANDOM_PASS_USEC each, and times this many fsync() calls
+ */
+#define FILESYSTEM_QUEUE_DEPTH 32
+#define NUM_FSYNC_SAMPLES 100
+
+struct _MduBenchmarkPrivate
+{
+        gchar *device_file;
+
+        MduBenchmarkMode mode;
+        MduBenchmarkIOEngine io_engine;
+        guint queue_depth;
+        guint block_size;
+        guint num_workers;
+        GArray *write_regions;
+        gchar *scratch_directory;
+        guint64 scratch_offset;
+
+        /* accessed from the benchmark thread */
+        volatile gint running;
+        volatile gint progress;         /* per mille */
+        GStaticMutex bytes_lock;
+        guint64 bytes_transferred;      /* protected by bytes_lock */
+
+        /* results of the last run */
+        guint64 size;
+        MduBenchmarkIOEngine io_engine_used;
+        gboolean direct_io;
+        GArray *read_samples;
+        GArray *write_samples;
+        GArray *access_samples;
+        GArray *iops_results;
+        GArray *sweep_results;
+};
+
+enum
+{
+        PROGRESS_CHANGED_SIGNAL,
+        SAMPLE_ADDED_SIGNAL,
+        LAST_SIGNAL,
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (MduBenchmark, mdu_benchmark, G_TYPE_OBJECT);
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct
+{
+        guint64  offset;
+        gsize    length;
+        gchar   *buffer;
+        gboolean is_write;
+
+        /* filled in when the request completes; the number of bytes transferred or -errno */
+        gssize   result;
+
+        gint64   submit_usec;
+
+#ifdef HAVE_LIBAIO
+        struct iocb iocb;
+#endif
+} IORequest;
+
+/* An I/O engine. A context is created per worker and is only used from
+ * that worker's thread. Requests are queued and then submitted in a
+ * batch; reap() waits for at least one request to complete.
+ */
+typedef struct
+{
+        MduBenchmarkIOEngine engine;
+        gboolean is_async;
+        gpointer (*open)   (gint       fd,
+                            guint      queue_depth,
+                            GError   **error);
+        void     (*queue)  (gpointer   ctx,
+                            IORequest *request);
+        guint    (*submit) (gpointer   ctx,
+                            GError   **error);
+        gint     (*reap)   (gpointer   ctx,
+                            IORequest **completed,
+                            guint      max_completed,
+                            GError   **error);
+        void     (*close)  (gpointer   ctx);
+} IOBackend;
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gint64
+get_monotonic_usec (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return ((gint64) ts.tv_sec) * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+static gchar *
+alloc_aligned (gsize size)
+{
+        void *p;
+
+        if (posix_memalign (&p, MIN_ALIGNMENT, size) != 0)
+                g_error ("%s: failed to allocate %" G_GSIZE_FORMAT " bytes", G_STRLOC, size);
+        return p;
+}
+
+/* for what we write; not all zeroes since some drives and filesystems compress data */
+static void
+fill_random (gchar *buffer,
+             gsize  size)
+{
+        GRand *rand;
+        gsize n;
+
+        rand = g_rand_new ();
+        for (n = 0; n < size / sizeof (guint32); n++)
+                ((guint32 *) buffer)[n] = g_rand_int (rand);
+        g_rand_free (rand);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_LIBURING
+
+typedef struct
+{
+        struct io_uring ring;
+        gint fd;
+        guint num_queued;
+} UringContext;
+
+static gpointer
+uring_open (gint       fd,
+            guint      queue_depth,
+            GError   **error)
+{
+        UringContext *ctx;
+        gint rc;
+
+        ctx = g_new0 (UringContext, 1);
+        ctx->fd = fd;
+        rc = io_uring_queue_init (queue_depth, &ctx->ring, 0);
+        if (rc < 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error setting up io_uring: %s",
+                             g_strerror (-rc));
+                g_free (ctx);
+                ctx = NULL;
+        }
+        return ctx;
+}
+
+static void
+uring_queue (gpointer   _ctx,
+             IORequest *request)
+{
+        UringContext *ctx = _ctx;
+        struct io_uring_sqe *sqe;
+
+        /* cannot fail; we never have more than queue_depth requests in flight */
+        sqe = io_uring_get_sqe (&ctx->ring);
+        if (request->is_write)
+                io_uring_prep_write (sqe, ctx->fd, request->buffer, request->length, request->offset);
+        else
+                io_uring_prep_read (sqe, ctx->fd, request->buffer, request->length, request->offset);
+        io_uring_sqe_set_data (sqe, request);
+        ctx->num_queued++;
+}
+
+static guint
+uring_submit (gpointer   _ctx,
+              GError   **error)
+{
+        UringContext *ctx = _ctx;
+        guint num_submitted;
+        gint rc;
+
+        num_submitted = 0;
+        while (num_submitted < ctx->num_queued) {
+                rc = io_uring_submit (&ctx->ring);
+                if (rc == -EINTR || rc == -EAGAIN)
+                        continue;
+                if (rc < 0) {
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error submitting I/O: %s",
+                                     g_strerror (-rc));
+                        break;
+                }
+                num_submitted += rc;
+        }
+        ctx->num_queued = 0;
+        return num_submitted;
+}
+
+static gint
+uring_reap (gpointer    _ctx,
+            IORequest **completed,
+            guint       max_completed,
+            GError    **error)
+{
+        UringContext *ctx = _ctx;
+        struct io_uring_cqe *cqe;
+        IORequest *request;
+        gint num_completed;
+        gint rc;
+
+        do
+                rc = io_uring_wait_cqe (&ctx->ring, &cqe);
+        while (rc == -EINTR);
+        if (rc < 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error waiting for I/O: %s",
+                             g_strerror (-rc));
+                return -1;
+        }
+
+        num_completed = 0;
+        do {
+                request = io_uring_cqe_get_data (cqe);
+                request->result = cqe->res;
+                io_uring_cqe_seen (&ctx->ring, cqe);
+                completed[num_completed++] = request;
+        } while (num_completed < (gint) max_completed && io_uring_peek_cqe (&ctx->ring, &cqe) == 0);
+
+        return num_completed;
+}
+
+static void
+uring_close (gpointer _ctx)
+{
+        UringContext *ctx = _ctx;
+
+        io_uring_queue_exit (&ctx->ring);
+        g_free (ctx);
+}
+
+static const IOBackend uring_backend = {
+        MDU_BENCHMARK_IO_ENGINE_IO_URING,
+        TRUE,
+        uring_open,
+        uring_queue,
+        uring_submit,
+        uring_reap,
+        uring_close
+};
+
+#endif /* HAVE_LIBURING */
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_LIBAIO
+
+typedef struct
+{
+        io_context_t aio_ctx;
+        gint fd;
+        struct iocb **queued;
+        guint num_queued;
+        struct io_event *events;
+} AioContext;
+
+static gpointer
+aio_open (gint       fd,
+          guint      queue_depth,
+          GError   **error)
+{
+        AioContext *ctx;
+        gint rc;
+
+        ctx = g_new0 (AioContext, 1);
+        ctx->fd = fd;
+        rc = io_setup (queue_depth, &ctx->aio_ctx);
+        if (rc < 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error setting up AIO context: %s",
+                             g_strerror (-rc));
+                g_free (ctx);
+                ctx = NULL;
+                goto out;
+        }
+        ctx->queued = g_new0 (struct iocb *, queue_depth);
+        ctx->events = g_new0 (struct io_event, queue_depth);
+
+ out:
+        return ctx;
+}
+
+static void
+aio_queue (gpointer   _ctx,
+           IORequest *request)
+{
+        AioContext *ctx = _ctx;
+
+        if (request->is_write)
+                io_prep_pwrite (&request->iocb, ctx->fd, request->buffer, request->length, request->offset);
+        else
+                io_prep_pread (&request->iocb, ctx->fd, request->buffer, request->length, request->offset);
+        request->iocb.data = request;
+        ctx->queued[ctx->num_queued++] = &request->iocb;
+}
+
+static guint
+aio_submit (gpointer   _ctx,
+            GError   **error)
+{
+        AioContext *ctx = _ctx;
+        guint num_submitted;
+        gint rc;
+
+        num_submitted = 0;
+        while (num_submitted < ctx->num_queued) {
+                rc = io_submit (ctx->aio_ctx, ctx->num_queued - num_submitted, ctx->queued + num_submitted);
+                if (rc == -EINTR || rc == -EAGAIN)
+                        continue;
+                if (rc < 0) {
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error submitting I/O: %s",
+                                     g_strerror (-rc));
+                        break;
+                }
+                num_submitted += rc;
+        }
+        ctx->num_queued = 0;
+        return num_submitted;
+}
+
+static gint
+aio_reap (gpointer    _ctx,
+          IORequest **completed,
+          guint       max_completed,
+          GError    **error)
+{
+        AioContext *ctx = _ctx;
+        gint rc;
+        gint n;
+
+        do
+                rc = io_getevents (ctx->aio_ctx, 1, max_completed, ctx->events, NULL);
+        while (rc == -EINTR);
+        if (rc < 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error waiting for I/O: %s",
+                             g_strerror (-rc));
+                return -1;
+        }
+
+        for (n = 0; n < rc; n++) {
+                completed[n] = ctx->events[n].data;
+                completed[n]->result = (glong) ctx->events[n].res;
+        }
+
+        return rc;
+}
+
+static void
+aio_close (gpointer _ctx)
+{
+        AioContext *ctx = _ctx;
+
+        /* waits for requests still in flight */
+        io_destroy (ctx->aio_ctx);
+        g_free (ctx->queued);
+        g_free (ctx->events);
+        g_free (ctx);
+}
+
+static const IOBackend aio_backend = {
+        MDU_BENCHMARK_IO_ENGINE_LIBAIO,
+        TRUE,
+        aio_open,
+        aio_queue,
+        aio_submit,
+        aio_reap,
+        aio_close
+};
+
+#endif /* HAVE_LIBAIO */
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Blocking I/O; the queue depth is achieved by running a thread per request in flight */
+
+typedef struct
+{
+        gint fd;
+        GQueue queued;
+        GQueue completed;
+} SyncContext;
+
+static gpointer
+sync_open (gint       fd,
+           guint      queue_depth,
+           GError   **error)
+{
+        SyncContext *ctx;
+
+        ctx = g_new0 (SyncContext, 1);
+        ctx->fd = fd;
+        return ctx;
+}
+
+static void
+sync_queue (gpointer   _ctx,
+            IORequest *request)
+{
+        SyncContext *ctx = _ctx;
+
+        g_queue_push_tail (&ctx->queued, request);
+}
+
+static guint
+sync_submit (gpointer   _ctx,
+             GError   **error)
+{
+        SyncContext *ctx = _ctx;
+        IORequest *request;
+        guint num_submitted;
+        gsize done;
+        gssize rc;
+
+        num_submitted = 0;
+        while ((request = g_queue_pop_head (&ctx->queued)) != NULL) {
+                done = 0;
+                rc = 0;
+                while (done < request->length) {
+                        if (request->is_write)
+                                rc = pwrite (ctx->fd, request->buffer + done, request->length - done, request->offset + done);
+                        else
+                                rc = pread (ctx->fd, request->buffer + done, request->length - done, request->offset + done);
+                        if (rc < 0 && errno == EINTR)
+                                continue;
+                        if (rc <= 0)
+                                break;
+                        done += rc;
+                }
+                request->result = rc < 0 ? -errno : (gssize) done;
+                g_queue_push_tail (&ctx->completed, request);
+                num_submitted++;
+        }
+        return num_submitted;
+}
+
+static gint
+sync_reap (gpointer    _ctx,
+           IORequest **completed,
+           guint       max_completed,
+           GError    **error)
+{
+        SyncContext *ctx = _ctx;
+        gint num_completed;
+
+        num_completed = 0;
+        while (num_completed < (gint) max_completed && !g_queue_is_empty (&ctx->completed))
+                completed[num_completed++] = g_queue_pop_head (&ctx->completed);
+
+        return num_completed;
+}
+
+static void
+sync_close (gpointer _ctx)
+{
+        SyncContext *ctx = _ctx;
+
+        g_queue_clear (&ctx->queued);
+        g_queue_clear (&ctx->completed);
+        g_free (ctx);
+}
+
+static const IOBackend sync_backend = {
+        MDU_BENCHMARK_IO_ENGINE_THREADS,
+        FALSE,
+        sync_open,
+        sync_queue,
+        sync_submit,
+        sync_reap,
+        sync_close
+};
+
+/* in order of preference */
+static const IOBackend *backends[] = {
+#ifdef HAVE_LIBURING
+        &uring_backend,
+#endif
+#ifdef HAVE_LIBAIO
+        &aio_backend,
+#endif
+        &sync_backend,
+};
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct
+{
+        MduBenchmark *benchmark;
+        MduBenchmarkFlags flags;
+        GCancellable *cancellable;
+
+        /* settings, copied when the run is started */
+        gchar *device_file;
+        MduBenchmarkMode mode;
+        MduBenchmarkIOEngine io_engine;
+        guint queue_depth;
+        guint block_size;
+        guint num_workers;
+        GArray *write_regions;
+        gchar *scratch_directory;
+        guint64 scratch_offset;
+
+        gint fd;
+        gboolean direct_io;
+        gboolean is_block_device;
+        dev_t rdev;
+        guint64 size;
+        guint alignment;
+        const IOBackend *backend;
+
+        /* if writes are limited to some regions or a scratch file, the WriteSlot
+         * for each write transfer rate sample; otherwise the read samples are
+         * written back
+         */
+        GArray *write_slots;
+        gint scratch_fd;
+
+        guint64 sample_size;
+        guint num_samples;
+
+        gdouble units_done;
+        guint units_total;
+
+        GArray *read_samples;
+        GArray *write_samples;
+        GArray *access_samples;
+        GArray *iops_results;
+        GArray *sweep_results;
+} Run;
+
+typedef struct
+{
+        /* where to write, on the device or in the scratch file */
+        guint64 offset;
+        /* where that is on the device, used as the offset of the sample */
+        guint64 position;
+} WriteSlot;
+
+/* A batch of requests issued by one or more workers in parallel.
+ *
+ * If @buffer is set, the phase transfers @num_requests consecutive
+ * requests starting at @offset from/to @buffer. Otherwise @num_requests
+ * requests are issued in the @num_slots * @request_size bytes starting
+ * at @offset, either in order from @first_slot and wrapping around if
+ * @sequential is set or at random aligned offsets.
+ *
+ * If @deadline_usec is set, no requests are issued after that time.
+ * Such a phase reports progress as it goes.
+ *
+ * Requests go to the device unless @to_scratch_file is set.
+ */
+typedef struct
+{
+        Run *run;
+        gboolean is_write;
+        gboolean to_scratch_file;
+        guint queue_depth;
+        guint num_workers;
+        gsize request_size;
+        guint64 num_requests;
+        guint64 offset;
+        gchar *buffer;
+        guint64 num_slots;
+        gboolean sequential;
+        guint64 first_slot;
+
+        gint64 deadline_usec;
+        gint64 begin_usec;
+
+        /* if set, the latency of every request is appended */
+        GArray *latency_samples;
+
+        /* if set, the latency of every request is recorded */
+        MduBenchmarkHistogram *histogram;
+
+        /* filled in when the phase is done */
+        guint64 num_completed;
+
+        volatile gint aborted;
+} Phase;
+
+typedef struct
+{
+        Phase *phase;
+        guint index;
+        guint stride;
+        guint queue_depth;
+        guint64 num_requests;
+        guint64 num_issued;
+        GRand *rand;
+        GArray *latency_samples;
+        MduBenchmarkHistogram *histogram;
+        guint64 num_completed;
+        GError *error;
+} Worker;
+
+static gboolean
+worker_next_request (Worker    *worker,
+                     IORequest *request)
+{
+        Phase *phase = worker->phase;
+        guint64 index;
+        guint64 slot;
+
+        if (worker->num_issued == worker->num_requests)
+                return FALSE;
+
+        if (phase->buffer != NULL) {
+                index = worker->index + worker->num_issued * worker->stride;
+                request->offset = phase->offset + index * phase->request_size;
+                request->buffer = phase->buffer + index * phase->request_size;
+        } else if (phase->sequential) {
+                slot = (phase->first_slot + worker->index + worker->num_issued * worker->stride) % phase->num_slots;
+                request->offset = phase->offset + slot * phase->request_size;
+        } else {
+                slot = (((guint64) g_rand_int (worker->rand)) << 32) | g_rand_int (worker->rand);
+                slot %= phase->num_slots;
+                request->offset = phase->offset + slot * phase->request_size;
+        }
+        request->length = phase->request_size;
+        request->is_write = phase->is_write;
+        worker->num_issued++;
+
+        return TRUE;
+}
+
+static void run_report_progress (Run *run, gdouble units_done);
+static void run_add_bytes_transferred (Run *run, guint64 num_bytes);
+
+static gboolean
+phase_should_stop (Phase *phase)
+{
+        return g_atomic_int_get (&phase->aborted) || g_cancellable_is_cancelled (phase->run->cancellable);
+}
+
+static gpointer
+worker_run (Worker *worker)
+{
+        Phase *phase = worker->phase;
+        const IOBackend *backend = phase->run->backend;
+        gpointer ctx;
+        IORequest *requests;
+        IORequest **free_requests;
+        IORequest **completed;
+        gchar *request_buffers;
+        guint num_free;
+        guint num_queued;
+        guint num_in_flight;
+        gint num_completed;
+        guint64 num_bytes;
+        gint64 now;
+        gint n;
+
+        requests = NULL;
+        free_requests = NULL;
+        completed = NULL;
+        request_buffers = NULL;
+
+        ctx = backend->open (phase->to_scratch_file ? phase->run->scratch_fd : phase->run->fd,
+                             worker->queue_depth,
+                             &worker->error);
+        if (ctx == NULL)
+                goto out;
+
+        requests = g_new0 (IORequest, worker->queue_depth);
+        free_requests = g_new0 (IORequest *, worker->queue_depth);
+        completed = g_new0 (IORequest *, worker->queue_depth);
+        if (phase->buffer == NULL) {
+                request_buffers = alloc_aligned (worker->queue_depth * phase->request_size);
+                if (phase->is_write)
+                        fill_random (request_buffers, worker->queue_depth * phase->request_size);
+        }
+        for (n = 0; n < (gint) worker->queue_depth; n++) {
+                if (request_buffers != NULL)
+                        requests[n].buffer = request_buffers + n * phase->request_size;
+                free_requests[n] = &requests[n];
+        }
+        num_free = worker->queue_depth;
+        num_in_flight = 0;
+
+        while (TRUE) {
+                if (phase->deadline_usec != 0) {
+                        now = get_monotonic_usec ();
+                        if (now >= phase->deadline_usec)
+                                worker->num_requests = worker->num_issued;
+                        /* the other workers are doing the same, so one reporting is enough */
+                        if (worker->index == 0) {
+                                run_report_progress (phase->run,
+                                                     phase->run->units_done +
+                                                     MIN (1.0, ((gdouble) (now - phase->begin_usec)) /
+                                                          (phase->deadline_usec - phase->begin_usec)));
+                        }
+                }
+
+                if (worker->error == NULL && !phase_should_stop (phase)) {
+                        num_queued = 0;
+                        while (num_free > 0 && worker_next_request (worker, free_requests[num_free - 1])) {
+                                IORequest *request = free_requests[--num_free];
+                                request->submit_usec = get_monotonic_usec ();
+                                backend->queue (ctx, request);
+                                num_queued++;
+                        }
+                        if (num_queued > 0)
+                                num_in_flight += backend->submit (ctx, &worker->error);
+                }
+
+                if (num_in_flight == 0)
+                        break;
+
+                /* If this fails we can't know what is still in flight; closing the context
+                 * below waits for or cancels the outstanding requests.
+                 */
+                num_completed = backend->reap (ctx,
+                                               completed,
+                                               worker->queue_depth,
+                                               worker->error == NULL ? &worker->error : NULL);
+                if (num_completed < 0)
+                        break;
+
+                now = get_monotonic_usec ();
+                num_bytes = 0;
+                for (n = 0; n < num_completed; n++) {
+                        IORequest *request = completed[n];
+
+                        num_in_flight--;
+                        free_requests[num_free++] = request;
+
+                        if (request->result != (gssize) request->length) {
+                                if (worker->error == NULL) {
+                                        g_set_error (&worker->error,
+                                                     MDU_ERROR,
+                                                     MDU_ERROR_FAILED,
+                                                     "Error %s %" G_GSIZE_FORMAT " bytes at offset %" G_GUINT64_FORMAT ": %s",
+                                                     request->is_write ? "writing" : "reading",
+                                                     request->length,
+                                                     request->offset,
+                                                     request->result < 0 ? g_strerror (-request->result) : "Short transfer");
+                                }
+                                continue;
+                        }
+
+                        worker->num_completed++;
+                        num_bytes += request->length;
+                        if (worker->histogram != NULL)
+                                mdu_benchmark_histogram_add_value (worker->histogram, now - request->submit_usec);
+                        if (worker->latency_samples != NULL) {
+                                MduBenchmarkSample sample;
+                                sample.offset = request->offset;
+                                sample.value = (now - request->submit_usec) / ((gdouble) G_USEC_PER_SEC);
+                                g_array_append_val (worker->latency_samples, sample);
+                        }
+                }
+                if (num_bytes > 0)
+                        run_add_bytes_transferred (phase->run, num_bytes);
+        }
+
+ out:
+        if (ctx != NULL)
+                backend->close (ctx);
+        if (worker->error != NULL)
+                g_atomic_int_set (&phase->aborted, 1);
+        g_free (requests);
+        g_free (free_requests);
+        g_free (completed);
+        free (request_buffers);
+        return NULL;
+}
+
+static gboolean
+phase_run (Phase   *phase,
+           GError **error)
+{
+        Worker *workers;
+        GThread **threads;
+        guint num_threads;
+        guint queue_depth;
+        gboolean ret;
+        guint n;
+
+        ret = FALSE;
+
+        num_threads = phase->num_workers;
+        queue_depth = phase->queue_depth;
+        if (!phase->run->backend->is_async) {
+                num_threads *= queue_depth;
+                queue_depth = 1;
+        }
+        num_threads = MAX (1, MIN (num_threads, phase->num_requests));
+
+        workers = g_new0 (Worker, num_threads);
+        threads = g_new0 (GThread *, num_threads);
+        for (n = 0; n < num_threads; n++) {
+                Worker *worker = &workers[n];
+
+                worker->phase = phase;
+                worker->index = n;
+                worker->stride = num_threads;
+                worker->queue_depth = queue_depth;
+                worker->num_requests = phase->num_requests / num_threads;
+                if (n < phase->num_requests % num_threads)
+                        worker->num_requests++;
+                if (phase->buffer == NULL && !phase->sequential)
+                        worker->rand = g_rand_new ();
+                if (phase->latency_samples != NULL)
+                        worker->latency_samples = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSample));
+                if (phase->histogram != NULL)
+                        worker->histogram = g_new0 (MduBenchmarkHistogram, 1);
+        }
+
+        phase->begin_usec = get_monotonic_usec ();
+
+        if (num_threads == 1) {
+                worker_run (&workers[0]);
+        } else {
+                for (n = 0; n < num_threads; n++) {
+                        threads[n] = g_thread_create ((GThreadFunc) worker_run,
+                                                      &workers[n],
+                                                      TRUE,
+                                                      &workers[n].error);
+                        if (threads[n] == NULL) {
+                                g_atomic_int_set (&phase->aborted, 1);
+                                break;
+                        }
+                }
+                for (n = 0; n < num_threads; n++) {
+                        if (threads[n] != NULL)
+                                g_thread_join (threads[n]);
+                }
+        }
+
+        for (n = 0; n < num_threads; n++) {
+                Worker *worker = &workers[n];
+                if (worker->error != NULL) {
+                        g_propagate_error (error, worker->error);
+                        worker->error = NULL;
+                        goto out;
+                }
+        }
+
+        if (g_cancellable_is_cancelled (phase->run->cancellable)) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_CANCELLED,
+                             "The benchmark was cancelled");
+                goto out;
+        }
+
+        for (n = 0; n < num_threads; n++) {
+                Worker *worker = &workers[n];
+                phase->num_completed += worker->num_completed;
+                if (phase->latency_samples != NULL)
+                        g_array_append_vals (phase->latency_samples,
+                                             worker->latency_samples->data,
+                                             worker->latency_samples->len);
+                if (phase->histogram != NULL)
+                        mdu_benchmark_histogram_merge (phase->histogram, worker->histogram);
+        }
+
+        ret = TRUE;
+
+ out:
+        for (n = 0; n < num_threads; n++) {
+                Worker *worker = &workers[n];
+                if (worker->rand != NULL)
+                        g_rand_free (worker->rand);
+                if (worker->latency_samples != NULL)
+                        g_array_free (worker->latency_samples, TRUE);
+                g_free (worker->histogram);
+                if (worker->error != NULL)
+                        g_error_free (worker->error);
+        }
+        g_free (workers);
+        g_free (threads);
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static gboolean
+emit_progress_changed_in_idle (gpointer user_data)
+{
+        MduBenchmark *benchmark = MDU_BENCHMARK (user_data);
+
+        g_signal_emit (benchmark, signals[PROGRESS_CHANGED_SIGNAL], 0);
+        g_object_unref (benchmark);
+        return FALSE;
+}
+
+static void
+run_report_progress (Run     *run,
+                     gdouble  units_done)
+{
+        MduBenchmarkPrivate *priv = run->benchmark->priv;
+        gint progress;
+
+        progress = (gint) (units_done * 1000 / run->units_total);
+        if (progress != g_atomic_int_get (&priv->progress)) {
+                g_atomic_int_set (&priv->progress, progress);
+                g_idle_add (emit_progress_changed_in_idle, g_object_ref (run->benchmark));
+        }
+}
+
+typedef struct
+{
+        MduBenchmark *benchmark;
+        MduBenchmarkSampleKind kind;
+        MduBenchmarkSample sample;
+} SampleAddedData;
+
+static gboolean
+emit_sample_added_in_idle (gpointer user_data)
+{
+        SampleAddedData *data = user_data;
+
+        g_signal_emit (data->benchmark, signals[SAMPLE_ADDED_SIGNAL], 0, data->kind, &data->sample);
+        g_object_unref (data->benchmark);
+        g_free (data);
+        return FALSE;
+}
+
+/* Samples are only published as a whole when the run is done, this passes
+ * a copy of each to the main loop as soon as it is taken
+ */
+static void
+run_report_sample (Run                      *run,
+                   MduBenchmarkSampleKind    kind,
+                   const MduBenchmarkSample *sample)
+{
+        SampleAddedData *data;
+
+        data = g_new0 (SampleAddedData, 1);
+        data->benchmark = g_object_ref (run->benchmark);
+        data->kind = kind;
+        data->sample = *sample;
+        g_idle_add (emit_sample_added_in_idle, data);
+}
+
+static void
+run_add_bytes_transferred (Run     *run,
+                           guint64  num_bytes)
+{
+        MduBenchmarkPrivate *priv = run->benchmark->priv;
+
+        g_static_mutex_lock (&priv->bytes_lock);
+        priv->bytes_transferred += num_bytes;
+        g_static_mutex_unlock (&priv->bytes_lock);
+}
+
+static void
+run_unit_done (Run *run)
+{
+        run->units_done += 1.0;
+        run_report_progress (run, run->units_done);
+}
+
+static gboolean
+run_open (Run     *run,
+          GError **error)
+{
+        struct stat statbuf;
+        gint open_flags;
+        gint logical_block_size;
+        gint errsv;
+        gboolean ret;
+
+        ret = FALSE;
+
+        if (stat (run->device_file, &statbuf) != 0) {
+                errsv = errno;
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error statting %s: %s",
+                             run->device_file,
+                             g_strerror (errsv));
+                goto out;
+        }
+        if (!S_ISBLK (statbuf.st_mode) && !S_ISREG (statbuf.st_mode)) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_NOT_SUPPORTED,
+                             "%s is neither a block device nor a regular file",
+                             run->device_file);
+                goto out;
+        }
+
+        open_flags = O_RDONLY;
+        if ((run->flags & MDU_BENCHMARK_FLAGS_WRITE) && run->scratch_directory == NULL) {
+                open_flags = O_RDWR;
+                /* refuse to write to a block device that is mounted or otherwise in use,
+                 * unless we only write to space that isn't, see run_check_unallocated()
+                 */
+                if (S_ISBLK (statbuf.st_mode) && run->write_regions == NULL)
+                        open_flags |= O_EXCL;
+        }
+        run->is_block_device = S_ISBLK (statbuf.st_mode);
+        run->rdev = statbuf.st_rdev;
+
+        run->direct_io = TRUE;
+        run->fd = open (run->device_file, open_flags | O_DIRECT);
+        if (run->fd < 0 && errno == EINVAL) {
+                /* e.g. a file on tmpfs; fall back to buffered I/O and drop the cache as we go */
+                run->direct_io = FALSE;
+                run->fd = open (run->device_file, open_flags);
+        }
+        if (run->fd < 0) {
+                errsv = errno;
+                g_set_error (error,
+                             MDU_ERROR,
+                             errsv == EACCES || errsv == EPERM ? MDU_ERROR_PERMISSION_DENIED :
+                             errsv == EBUSY ? MDU_ERROR_BUSY : MDU_ERROR_FAILED,
+                             "Error opening %s: %s",
+                             run->device_file,
+                             g_strerror (errsv));
+                goto out;
+        }
+
+        run->alignment = MIN_ALIGNMENT;
+        if (S_ISBLK (statbuf.st_mode)) {
+                if (ioctl (run->fd, BLKGETSIZE64, &run->size) != 0) {
+                        errsv = errno;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error determining size of %s: %s",
+                                     run->device_file,
+                                     g_strerror (errsv));
+                        goto out;
+                }
+                if (ioctl (run->fd, BLKSSZGET, &logical_block_size) == 0 && logical_block_size > MIN_ALIGNMENT)
+                        run->alignment = logical_block_size;
+        } else {
+                run->size = statbuf.st_size;
+        }
+        run->size -= run->size % run->alignment;
+
+        /* the block size must be a multiple of the alignment for O_DIRECT */
+        run->block_size -= run->block_size % run->alignment;
+        run->block_size = MAX (run->block_size, run->alignment);
+
+        if (run->size < run->block_size) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "%s is too small to benchmark",
+                             run->device_file);
+                goto out;
+        }
+
+        run->sample_size = MIN (TRANSFER_RATE_SAMPLE_SIZE, run->size);
+        run->sample_size -= run->sample_size % run->block_size;
+        run->num_samples = MIN (NUM_TRANSFER_RATE_SAMPLES, run->size / run->sample_size);
+
+        ret = TRUE;
+
+ out:
+        return ret;
+}
+
+static gboolean
+run_select_backend (Run     *run,
+                    GError **error)
+{
+        GError *local_error;
+        gpointer ctx;
+        guint n;
+
+        for (n = 0; n < G_N_ELEMENTS (backends); n++) {
+                if (run->io_engine != MDU_BENCHMARK_IO_ENGINE_AUTO && backends[n]->engine != run->io_engine)
+                        continue;
+
+                /* io_uring may be compiled in but disabled in the running kernel */
+                local_error = NULL;
+                ctx = backends[n]->open (run->fd, run->queue_depth, &local_error);
+                if (ctx != NULL) {
+                        backends[n]->close (ctx);
+                        run->backend = backends[n];
+                        return TRUE;
+                }
+
+                if (run->io_engine != MDU_BENCHMARK_IO_ENGINE_AUTO) {
+                        g_propagate_error (error, local_error);
+                        return FALSE;
+                }
+                g_error_free (local_error);
+        }
+
+        g_set_error (error,
+                     MDU_ERROR,
+                     MDU_ERROR_NOT_SUPPORTED,
+                     "The requested I/O engine is not available");
+        return FALSE;
+}
+
+/* Makes sure no partition overlaps the @size bytes at @offset and the
+ * device isn't used as a whole. This asks the kernel rather than going
+ * by the regions we were given since those may be outdated by now.
+ */
+static gboolean
+run_check_unallocated (Run      *run,
+                       guint64   offset,
+                       guint64   size,
+                       GError  **error)
+{
+        gchar *sysfs_path;
+        gchar *path;
+        gchar *contents;
+        GDir *dir;
+        const gchar *name;
+        guint64 partition_offset;
+        guint64 partition_size;
+        gboolean ret;
+
+        ret = FALSE;
+        sysfs_path = NULL;
+        dir = NULL;
+
+        /* a regular file doesn't have partitions */
+        if (!run->is_block_device) {
+                ret = TRUE;
+                goto out;
+        }
+
+        sysfs_path = g_strdup_printf ("/sys/dev/block/%u:%u", major (run->rdev), minor (run->rdev));
+
+        path = g_build_filename (sysfs_path, "holders", NULL);
+        dir = g_dir_open (path, 0, NULL);
+        g_free (path);
+        if (dir != NULL && (name = g_dir_read_name (dir)) != NULL) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_BUSY,
+                             "%s is in use by %s",
+                             run->device_file,
+                             name);
+                goto out;
+        }
+        if (dir != NULL)
+                g_dir_close (dir);
+
+        dir = g_dir_open (sysfs_path, 0, error);
+        if (dir == NULL)
+                goto out;
+        while ((name = g_dir_read_name (dir)) != NULL) {
+                /* the start and size of partitions are in 512 byte sectors */
+                path = g_build_filename (sysfs_path, name, "start", NULL);
+                if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+                        /* not a partition */
+                        g_free (path);
+                        continue;
+                }
+                g_free (path);
+                partition_offset = g_ascii_strtoull (contents, NULL, 10) * 512;
+                g_free (contents);
+
+                path = g_build_filename (sysfs_path, name, "size", NULL);
+                if (!g_file_get_contents (path, &contents, NULL, error)) {
+                        g_free (path);
+                        goto out;
+                }
+                g_free (path);
+                partition_size = g_ascii_strtoull (contents, NULL, 10) * 512;
+                g_free (contents);
+
+                if (partition_offset < offset + size && offset < partition_offset + partition_size) {
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_BUSY,
+                                     "The %" G_GUINT64_FORMAT " bytes at offset %" G_GUINT64_FORMAT " of %s "
+                                     "are no longer unallocated, they overlap %s",
+                                     size,
+                                     offset,
+                                     run->device_file,
+                                     name);
+                        goto out;
+                }
+        }
+
+        ret = TRUE;
+
+ out:
+        if (dir != NULL)
+                g_dir_close (dir);
+        g_free (sysfs_path);
+        return ret;
+}
+
+/* Spreads the write samples evenly over the regions we may write to */
+static gboolean
+run_prepare_write_regions (Run     *run,
+                           GError **error)
+{
+        WriteSlot slot;
+        guint64 *starts;
+        guint64 *num_slots;
+        guint64 total;
+        guint64 begin;
+        guint64 end;
+        guint64 index;
+        guint num;
+        guint n;
+        guint m;
+
+        starts = g_new0 (guint64, run->write_regions->len);
+        num_slots = g_new0 (guint64, run->write_regions->len);
+        total = 0;
+        for (n = 0; n < run->write_regions->len; n++) {
+                MduBenchmarkRegion *region = &g_array_index (run->write_regions, MduBenchmarkRegion, n);
+
+                begin = region->offset + WRITE_REGION_MARGIN;
+                begin += (run->alignment - begin % run->alignment) % run->alignment;
+                end = MIN (region->offset + region->size, run->size);
+                if (end < WRITE_REGION_MARGIN)
+                        continue;
+                end -= WRITE_REGION_MARGIN;
+                if (end <= begin)
+                        continue;
+
+                starts[n] = begin;
+                num_slots[n] = (end - begin) / run->sample_size;
+                total += num_slots[n];
+        }
+
+        if (total == 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_NOT_SUPPORTED,
+                             "Not enough unallocated space on %s to measure the write rate",
+                             run->device_file);
+                goto out;
+        }
+
+        num = MIN (run->num_samples, total);
+        run->write_slots = g_array_sized_new (FALSE, FALSE, sizeof (WriteSlot), num);
+        for (n = 0; n < num; n++) {
+                index = total * n / num;
+                for (m = 0; index >= num_slots[m]; m++)
+                        index -= num_slots[m];
+
+                slot.offset = starts[m] + index * run->sample_size;
+                slot.position = slot.offset;
+                g_array_append_val (run->write_slots, slot);
+        }
+
+ out:
+        g_free (starts);
+        g_free (num_slots);
+        return run->write_slots != NULL;
+}
+
+/* Where @offset of the scratch file is on the device, so the write samples
+ * can be shown next to the read samples
+ */
+static guint64
+run_get_scratch_position (Run     *run,
+                          guint64  offset)
+{
+        struct fiemap *fiemap;
+        guint64 ret;
+
+        fiemap = g_malloc0 (sizeof (struct fiemap) + sizeof (struct fiemap_extent));
+        fiemap->fm_start = offset;
+        fiemap->fm_length = run->sample_size;
+        fiemap->fm_extent_count = 1;
+
+        if (ioctl (run->scratch_fd, FS_IOC_FIEMAP, fiemap) == 0 &&
+            fiemap->fm_mapped_extents > 0 &&
+            fiemap->fm_extents[0].fe_logical <= offset) {
+                ret = run->scratch_offset + fiemap->fm_extents[0].fe_physical + (offset - fiemap->fm_extents[0].fe_logical);
+        } else {
+                /* e.g. a filesystem not supporting FIEMAP; the best guess is a file in one piece */
+                ret = run->scratch_offset + offset;
+        }
+
+        g_free (fiemap);
+        return MIN (ret, run->size - 1);
+}
+
+/* The size of a temporary file in @directory, leaving at least half of the free space */
+static gboolean
+get_scratch_space (const gchar  *directory,
+                   guint64      *out_size,
+                   GError      **error)
+{
+        struct statvfs statvfsbuf;
+        gint errsv;
+
+        if (statvfs (directory, &statvfsbuf) != 0) {
+                errsv = errno;
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error statting filesystem of %s: %s",
+                             directory,
+                             g_strerror (errsv));
+                return FALSE;
+        }
+        *out_size = MIN (SCRATCH_FILE_SIZE, ((guint64) statvfsbuf.f_bavail) * statvfsbuf.f_frsize / 2);
+        return TRUE;
+}
+
+/* Creates a file of @size bytes in @directory. It's deleted right away so
+ * it goes away when we are done, no matter how.
+ *
+ * Returns: The file descriptor or -1 if @error is set.
+ */
+static gint
+create_scratch_file (const gchar  *directory,
+                     guint64       size,
+                     gboolean     *out_direct_io,
+                     GError      **error)
+{
+        gchar *path;
+        gint errsv;
+        gint rc;
+        gint fd;
+
+        path = g_build_filename (directory, ".mdu-benchmark-XXXXXX", NULL);
+        fd = g_mkstemp_full (path, O_RDWR, 0600);
+        if (fd < 0) {
+                errsv = errno;
+                g_set_error (error,
+                             MDU_ERROR,
+                             errsv == EACCES || errsv == EPERM || errsv == EROFS ? MDU_ERROR_PERMISSION_DENIED : MDU_ERROR_FAILED,
+                             "Error creating a file in %s: %s",
+                             directory,
+                             g_strerror (errsv));
+                goto out;
+        }
+        g_unlink (path);
+
+        /* like for the device, fall back to buffered I/O if the filesystem doesn't do O_DIRECT */
+        *out_direct_io = (fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_DIRECT) == 0);
+
+        rc = posix_fallocate (fd, 0, size);
+        if (rc != 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error allocating %" G_GUINT64_FORMAT " bytes in %s: %s",
+                             size,
+                             directory,
+                             g_strerror (rc));
+                close (fd);
+                fd = -1;
+                goto out;
+        }
+
+ out:
+        g_free (path);
+        return fd;
+}
+
+/* Creates the file the write transfer rate is measured on */
+static gboolean
+run_open_scratch_file (Run     *run,
+                       GError **error)
+{
+        WriteSlot slot;
+        gboolean direct_io;
+        guint64 size;
+        guint n;
+
+        if (!get_scratch_space (run->scratch_directory, &size, error))
+                goto out;
+        size = MIN (size, ((guint64) run->num_samples) * run->sample_size);
+        size -= size % run->sample_size;
+        if (size == 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Not enough free space in %s to measure the write rate",
+                             run->scratch_directory);
+                goto out;
+        }
+
+        run->scratch_fd = create_scratch_file (run->scratch_directory, size, &direct_io, error);
+        if (run->scratch_fd < 0)
+                goto out;
+
+        run->write_slots = g_array_new (FALSE, FALSE, sizeof (WriteSlot));
+        for (n = 0; n < size / run->sample_size; n++) {
+                slot.offset = n * run->sample_size;
+                slot.position = run_get_scratch_position (run, slot.offset);
+                g_array_append_val (run->write_slots, slot);
+        }
+
+ out:
+        return run->write_slots != NULL;
+}
+
+/* For MDU_BENCHMARK_MODE_FILESYSTEM everything happens in a scratch file in
+ * the directory we were given, so it stands in for the device
+ */
+static gboolean
+run_open_filesystem (Run     *run,
+                     GError **error)
+{
+        struct stat statbuf;
+        gint errsv;
+
+        if (stat (run->device_file, &statbuf) != 0) {
+                errsv = errno;
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error statting %s: %s",
+                             run->device_file,
+                             g_strerror (errsv));
+                return FALSE;
+        }
+        if (!S_ISDIR (statbuf.st_mode)) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_NOT_SUPPORTED,
+                             "%s is not a directory",
+                             run->device_file);
+                return FALSE;
+        }
+
+        if (!get_scratch_space (run->device_file, &run->size, error))
+                return FALSE;
+
+        run->alignment = MIN_ALIGNMENT;
+        run->block_size -= run->block_size % run->alignment;
+        run->block_size = MAX (run->block_size, run->alignment);
+
+        run->sample_size = MIN (TRANSFER_RATE_SAMPLE_SIZE, run->size);
+        run->sample_size -= run->sample_size % run->block_size;
+        if (run->sample_size == 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Not enough free space in %s to benchmark",
+                             run->device_file);
+                return FALSE;
+        }
+        run->num_samples = run->size / run->sample_size;
+        run->size = run->num_samples * run->sample_size;
+
+        run->fd = create_scratch_file (run->device_file, run->size, &run->direct_io, error);
+        return run->fd >= 0;
+}
+
+static gboolean
+run_prepare_writes (Run     *run,
+                    GError **error)
+{
+        if (run->scratch_directory != NULL)
+                return run_open_scratch_file (run, error);
+        else if (run->write_regions != NULL)
+                return run_prepare_write_regions (run, error);
+        return TRUE;
+}
+
+/* Measures the write transfer rate at each WriteSlot. What is on the device
+ * is read and written back, after checking once more that the space is
+ * still unallocated; the scratch file is just overwritten.
+ */
+static gboolean
+run_write_slots (Run      *run,
+                 gchar    *buffer,
+                 GError  **error)
+{
+        Phase phase;
+        WriteSlot *slot;
+        MduBenchmarkSample sample;
+        gint64 begin_usec;
+        gint fd;
+        guint n;
+
+        /* don't copy what's on the device into the scratch file */
+        if (run->scratch_fd >= 0)
+                fill_random (buffer, run->sample_size);
+
+        for (n = 0; n < run->write_slots->len; n++) {
+                slot = &g_array_index (run->write_slots, WriteSlot, n);
+
+                memset (&phase, 0, sizeof (Phase));
+                phase.run = run;
+                phase.queue_depth = run->queue_depth;
+                phase.num_workers = run->num_workers;
+                phase.request_size = run->block_size;
+                phase.num_requests = run->sample_size / run->block_size;
+                phase.offset = slot->offset;
+                phase.buffer = buffer;
+
+                if (run->scratch_fd >= 0) {
+                        phase.to_scratch_file = TRUE;
+                        fd = run->scratch_fd;
+                } else {
+                        if (!phase_run (&phase, error))
+                                return FALSE;
+                        if (!run_check_unallocated (run, slot->offset, run->sample_size, error))
+                                return FALSE;
+                        fd = run->fd;
+                }
+
+                phase.is_write = TRUE;
+                phase.aborted = 0;
+                phase.num_completed = 0;
+
+                begin_usec = get_monotonic_usec ();
+                if (!phase_run (&phase, error))
+                        return FALSE;
+                if (fdatasync (fd) != 0) {
+                        gint errsv = errno;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error syncing %s: %s",
+                                     run->scratch_fd >= 0 ? run->scratch_directory : run->device_file,
+                                     g_strerror (errsv));
+                        return FALSE;
+                }
+                sample.offset = slot->position;
+                sample.value = run->sample_size / ((get_monotonic_usec () - begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                g_array_append_val (run->write_samples, sample);
+                run_report_sample (run, MDU_BENCHMARK_SAMPLE_KIND_WRITE_TRANSFER_RATE, &sample);
+                run_unit_done (run);
+        }
+
+        return TRUE;
+}
+
+static gboolean
+run_transfer_rate (Run     *run,
+                   GError **error)
+{
+        Phase phase;
+        gchar *buffer;
+        guint64 sample_size;
+        guint num_samples;
+        guint64 offset;
+        gint64 begin_usec;
+        MduBenchmarkSample sample;
+        gboolean ret;
+        guint n;
+
+        ret = FALSE;
+
+        sample_size = run->sample_size;
+        num_samples = run->num_samples;
+        buffer = alloc_aligned (sample_size);
+
+        for (n = 0; n < num_samples; n++) {
+                offset = 0;
+                if (num_samples > 1)
+                        offset = (run->size - sample_size) * n / (num_samples - 1);
+                offset -= offset % run->alignment;
+
+                if (!run->direct_io)
+                        posix_fadvise (run->fd, offset, sample_size, POSIX_FADV_DONTNEED);
+
+                memset (&phase, 0, sizeof (Phase));
+                phase.run = run;
+                phase.queue_depth = run->queue_depth;
+                phase.num_workers = run->num_workers;
+                phase.request_size = run->block_size;
+                phase.num_requests = sample_size / run->block_size;
+                phase.offset = offset;
+                phase.buffer = buffer;
+
+                begin_usec = get_monotonic_usec ();
+                if (!phase_run (&phase, error))
+                        goto out;
+                sample.offset = offset;
+                sample.value = sample_size / ((get_monotonic_usec () - begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                g_array_append_val (run->read_samples, sample);
+                run_report_sample (run, MDU_BENCHMARK_SAMPLE_KIND_READ_TRANSFER_RATE, &sample);
+                run_unit_done (run);
+
+                if (!(run->flags & MDU_BENCHMARK_FLAGS_WRITE) || run->write_slots != NULL)
+                        continue;
+
+                /* write back what we just read so the contents are preserved */
+                phase.is_write = TRUE;
+                phase.aborted = 0;
+
+                begin_usec = get_monotonic_usec ();
+                if (!phase_run (&phase, error))
+                        goto out;
+                if (fdatasync (run->fd) != 0) {
+                        gint errsv = errno;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error syncing %s: %s",
+                                     run->device_file,
+                                     g_strerror (errsv));
+                        goto out;
+                }
+                sample.offset = offset;
+                sample.value = sample_size / ((get_monotonic_usec () - begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                g_array_append_val (run->write_samples, sample);
+                run_report_sample (run, MDU_BENCHMARK_SAMPLE_KIND_WRITE_TRANSFER_RATE, &sample);
+                run_unit_done (run);
+        }
+
+        if (run->write_slots != NULL && !run_write_slots (run, buffer, error))
+                goto out;
+
+        ret = TRUE;
+
+ out:
+        free (buffer);
+        return ret;
+}
+
+static gboolean
+run_access_time (Run     *run,
+                 GError **error)
+{
+        Phase phase;
+        guint first;
+        guint n;
+        guint m;
+
+        for (n = 0; n < NUM_ACCESS_TIME_BATCHES; n++) {
+                memset (&phase, 0, sizeof (Phase));
+                phase.run = run;
+                phase.queue_depth = 1;
+                phase.num_workers = 1;
+                phase.request_size = run->alignment;
+                phase.num_requests = NUM_ACCESS_TIME_SAMPLES / NUM_ACCESS_TIME_BATCHES;
+                phase.offset = 0;
+                phase.num_slots = run->size / run->alignment;
+                phase.latency_samples = run->access_samples;
+
+                first = run->access_samples->len;
+                if (!phase_run (&phase, error))
+                        return FALSE;
+                for (m = first; m < run->access_samples->len; m++)
+                        run_report_sample (run,
+                                           MDU_BENCHMARK_SAMPLE_KIND_ACCESS_TIME,
+                                           &g_array_index (run->access_samples, MduBenchmarkSample, m));
+                run_unit_done (run);
+        }
+
+        return TRUE;
+}
+
+/* the returned result is only valid until the next one is added */
+static MduBenchmarkIopsResult *
+run_add_iops_result (Run   *run,
+                     guint  queue_depth)
+{
+        MduBenchmarkIopsResult *result;
+
+        g_array_set_size (run->iops_results, run->iops_results->len + 1);
+        result = &g_array_index (run->iops_results, MduBenchmarkIopsResult, run->iops_results->len - 1);
+        memset (result, 0, sizeof (MduBenchmarkIopsResult));
+        result->queue_depth = queue_depth;
+        return result;
+}
+
+static gboolean
+run_random_iops (Run     *run,
+                 GError **error)
+{
+        Phase phase;
+        MduBenchmarkIopsResult *result;
+        guint n;
+
+        for (n = 0; n < G_N_ELEMENTS (random_queue_depths); n++) {
+                result = run_add_iops_result (run, random_queue_depths[n]);
+
+                memset (&phase, 0, sizeof (Phase));
+                phase.run = run;
+                phase.queue_depth = random_queue_depths[n];
+                phase.num_workers = 1;
+                phase.request_size = MAX (RANDOM_REQUEST_SIZE, run->alignment);
+                phase.num_requests = G_MAXUINT64;
+                phase.offset = 0;
+                phase.num_slots = run->size / phase.request_size;
+                phase.deadline_usec = get_monotonic_usec () + RANDOM_PASS_USEC;
+                phase.histogram = &result->latency;
+
+                if (!phase_run (&phase, error))
+                        return FALSE;
+
+                result->iops = phase.num_completed / ((get_monotonic_usec () - phase.begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                run_unit_done (run);
+        }
+
+        return TRUE;
+}
+
+static guint
+run_get_num_sweep_passes (Run *run)
+{
+        guint64 region_size;
+        guint block_size;
+        guint ret;
+
+        ret = 0;
+        region_size = MIN (SWEEP_REGION_SIZE, run->size);
+        for (block_size = MAX (SWEEP_MIN_BLOCK_SIZE, run->alignment);
+             block_size <= SWEEP_MAX_BLOCK_SIZE && block_size <= region_size;
+             block_size *= 2)
+                ret++;
+        return ret;
+}
+
+static gboolean
+run_sweep (Run     *run,
+           GError **error)
+{
+        Phase phase;
+        MduBenchmarkSweepPoint point;
+        guint64 region_size;
+        guint num_passes;
+        guint block_size;
+        guint n;
+
+        region_size = MIN (SWEEP_REGION_SIZE, run->size);
+        num_passes = run_get_num_sweep_passes (run);
+
+        block_size = MAX (SWEEP_MIN_BLOCK_SIZE, run->alignment);
+        for (n = 0; n < num_passes; n++, block_size *= 2) {
+                memset (&phase, 0, sizeof (Phase));
+                phase.run = run;
+                phase.queue_depth = CLAMP (SWEEP_MAX_BYTES_IN_FLIGHT / block_size, 1, run->queue_depth);
+                phase.num_workers = run->num_workers;
+                phase.request_size = block_size;
+                phase.num_requests = G_MAXUINT64;
+                /* use a fresh region for every pass if the device is big enough, so
+                 * the drive can't serve a pass from what the previous one read
+                 */
+                phase.offset = 0;
+                if (run->size / region_size >= num_passes)
+                        phase.offset = n * region_size;
+                phase.num_slots = region_size / block_size;
+                phase.sequential = TRUE;
+
+                if (!run->direct_io)
+                        posix_fadvise (run->fd, phase.offset, region_size, POSIX_FADV_DONTNEED);
+
+                phase.deadline_usec = get_monotonic_usec () + SWEEP_PASS_USEC;
+                if (!phase_run (&phase, error))
+                        return FALSE;
+
+                point.block_size = block_size;
+                point.transfer_rate = phase.num_completed * block_size /
+                        ((get_monotonic_usec () - phase.begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                g_array_append_val (run->sweep_results, point);
+                run_unit_done (run);
+        }
+
+        return TRUE;
+}
+
+/* Reads the device from the start in one long stream, taking a sample
+ * every second. Unlike run_transfer_rate() the drive is kept busy all
+ * the time, which is what's needed when measuring several drives at
+ * once to find the limits of the controller they are on.
+ */
+static gboolean
+run_sequential (Run     *run,
+                GError **error)
+{
+        Phase phase;
+        MduBenchmarkSample sample;
+        guint64 num_slots;
+        guint64 slot;
+        guint n;
+
+        num_slots = run->size / run->block_size;
+        if (num_slots == 0) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_NOT_SUPPORTED,
+                             "%s is smaller than the block size",
+                             run->device_file);
+                return FALSE;
+        }
+
+        if (!run->direct_io)
+                posix_fadvise (run->fd, 0, 0, POSIX_FADV_DONTNEED);
+
+        slot = 0;
+        for (n = 0; n < run->units_total; n++) {
+                memset (&phase, 0, sizeof (Phase));
+                phase.run = run;
+                phase.queue_depth = run->queue_depth;
+                phase.num_workers = run->num_workers;
+                phase.request_size = run->block_size;
+                phase.num_requests = G_MAXUINT64;
+                phase.offset = 0;
+                phase.num_slots = num_slots;
+                phase.sequential = TRUE;
+                phase.first_slot = slot;
+                phase.deadline_usec = get_monotonic_usec () + SEQUENTIAL_SAMPLE_USEC;
+
+                if (!phase_run (&phase, error))
+                        return FALSE;
+
+                sample.offset = slot * run->block_size;
+                sample.value = phase.num_completed * run->block_size /
+                        ((get_monotonic_usec () - phase.begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                g_array_append_val (run->read_samples, sample);
+                run_report_sample (run, MDU_BENCHMARK_SAMPLE_KIND_READ_TRANSFER_RATE, &sample);
+                run_unit_done (run);
+
+                slot = (slot + phase.num_completed) % num_slots;
+        }
+
+        return TRUE;
+}
+
+/* Times 4 KiB writes each followed by fsync(), one block after the other
+ * like a database appending to its log
+ */
+static gboolean
+run_fsync_latency (Run     *run,
+                   GError **error)
+{
+        MduBenchmarkIopsResult *result;
+        gchar *buffer;
+        gint64 begin_usec;
+        gint64 usec;
+        gint64 total_usec;
+        gssize num_written;
+        gint errsv;
+        gboolean ret;
+        guint n;
+
+        ret = FALSE;
+        buffer = alloc_aligned (run->alignment);
+        fill_random (buffer, run->alignment);
+
+        result = run_add_iops_result (run, 1);
+        total_usec = 0;
+        for (n = 0; n < NUM_FSYNC_SAMPLES; n++) {
+                if (g_cancellable_is_cancelled (run->cancellable)) {
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_CANCELLED,
+                                     "The benchmark was cancelled");
+                        goto out;
+                }
+
+                begin_usec = get_monotonic_usec ();
+                num_written = pwrite (run->fd, buffer, run->alignment, ((guint64) n) * run->alignment);
+                if (num_written != (gssize) run->alignment) {
+                        errsv = num_written < 0 ? errno : EIO;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error writing to a file in %s: %s",
+                                     run->device_file,
+                                     g_strerror (errsv));
+                        goto out;
+                }
+                if (fsync (run->fd) != 0) {
+                        errsv = errno;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error syncing a file in %s: %s",
+                                     run->device_file,
+                                     g_strerror (errsv));
+                        goto out;
+                }
+                usec = get_monotonic_usec () - begin_usec;
+
+                mdu_benchmark_histogram_add_value (&result->latency, usec);
+                total_usec += usec;
+                run_add_bytes_transferred (run, run->alignment);
+                run_report_progress (run, run->units_done + (n + 1.0) / NUM_FSYNC_SAMPLES);
+        }
+        result->iops = NUM_FSYNC_SAMPLES / (MAX (total_usec, 1) / ((gdouble) G_USEC_PER_SEC));
+        run_unit_done (run);
+
+        ret = TRUE;
+
+ out:
+        free (buffer);
+        return ret;
+}
+
+/* Measures the filesystem through the scratch file, see run_open_filesystem().
+ * The file is written sequentially first since reading space that was only
+ * allocated wouldn't touch the disk at all. Random writes aren't done until
+ * they are on the disk so the fdatasync() is part of the time taken.
+ */
+static gboolean
+run_filesystem (Run     *run,
+                GError **error)
+{
+        Phase phase;
+        MduBenchmarkSample sample;
+        MduBenchmarkIopsResult *result;
+        gchar *buffer;
+        gint64 begin_usec;
+        gboolean is_write;
+        gint errsv;
+        gboolean ret;
+        guint pass;
+        guint n;
+
+        ret = FALSE;
+        buffer = alloc_aligned (run->sample_size);
+        fill_random (buffer, run->sample_size);
+
+        for (pass = 0; pass < 2; pass++) {
+                is_write = (pass == 0);
+
+                /* what we wrote must come from the disk, not the page cache */
+                if (!is_write && !run->direct_io)
+                        posix_fadvise (run->fd, 0, 0, POSIX_FADV_DONTNEED);
+
+                for (n = 0; n < run->num_samples; n++) {
+                        memset (&phase, 0, sizeof (Phase));
+                        phase.run = run;
+                        phase.is_write = is_write;
+                        phase.queue_depth = run->queue_depth;
+                        phase.num_workers = run->num_workers;
+                        phase.request_size = run->block_size;
+                        phase.num_requests = run->sample_size / run->block_size;
+                        phase.offset = n * run->sample_size;
+                        phase.buffer = buffer;
+
+                        begin_usec = get_monotonic_usec ();
+                        if (!phase_run (&phase, error))
+                                goto out;
+                        if (is_write && fdatasync (run->fd) != 0) {
+                                errsv = errno;
+                                g_set_error (error,
+                                             MDU_ERROR,
+                                             MDU_ERROR_FAILED,
+                                             "Error syncing a file in %s: %s",
+                                             run->device_file,
+                                             g_strerror (errsv));
+                                goto out;
+                        }
+                        sample.offset = phase.offset;
+                        sample.value = run->sample_size / ((get_monotonic_usec () - begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                        if (is_write) {
+                                g_array_append_val (run->write_samples, sample);
+                                run_report_sample (run, MDU_BENCHMARK_SAMPLE_KIND_WRITE_TRANSFER_RATE, &sample);
+                        } else {
+                                g_array_append_val (run->read_samples, sample);
+                                run_report_sample (run, MDU_BENCHMARK_SAMPLE_KIND_READ_TRANSFER_RATE, &sample);
+                        }
+                        run_unit_done (run);
+                }
+        }
+
+        for (pass = 0; pass < 2; pass++) {
+                is_write = (pass == 1);
+
+                if (!run->direct_io)
+                        posix_fadvise (run->fd, 0, 0, POSIX_FADV_DONTNEED);
+
+                result = run_add_iops_result (run, FILESYSTEM_QUEUE_DEPTH);
+
+                memset (&phase, 0, sizeof (Phase));
+                phase.run = run;
+                phase.is_write = is_write;
+                phase.queue_depth = FILESYSTEM_QUEUE_DEPTH;
+                phase.num_workers = 1;
+                phase.request_size = MAX (RANDOM_REQUEST_SIZE, run->alignment);
+                phase.num_requests = G_MAXUINT64;
+                phase.offset = 0;
+                phase.num_slots = run->size / phase.request_size;
+                phase.deadline_usec = get_monotonic_usec () + RANDOM_PASS_USEC;
+                phase.histogram = &result->latency;
+
+                if (!phase_run (&phase, error))
+                        goto out;
+                if (is_write && fdatasync (run->fd) != 0) {
+                        errsv = errno;
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "Error syncing a file in %s: %s",
+                                     run->device_file,
+                                     g_strerror (errsv));
+                        goto out;
+                }
+
+                result->iops = phase.num_completed / ((get_monotonic_usec () - phase.begin_usec) / ((gdouble) G_USEC_PER_SEC));
+                run_unit_done (run);
+        }
+
+        if (!run_fsync_latency (run, error))
+                goto out;
+
+        ret = TRUE;
+
+ out:
+        free (buffer);
+        return ret;
+}
+
+static void
+run_free (Run *run)
+{
+        if (run->read_samples != NULL)
+                g_array_free (run->read_samples, TRUE);
+        if (run->write_samples != NULL)
+                g_array_free (run->write_samples, TRUE);
+        if (run->access_samples != NULL)
+                g_array_free (run->access_samples, TRUE);
+        if (run->iops_results != NULL)
+                g_array_free (run->iops_results, TRUE);
+        if (run->sweep_results != NULL)
+                g_array_free (run->sweep_results, TRUE);
+        if (run->write_regions != NULL)
+                g_array_free (run->write_regions, TRUE);
+        if (run->write_slots != NULL)
+                g_array_free (run->write_slots, TRUE);
+        g_free (run->scratch_directory);
+        g_free (run->device_file);
+        g_free (run);
+}
+
+static void
+run_in_thread (GSimpleAsyncResult *simple,
+               GObject            *object,
+               GCancellable       *cancellable)
+{
+        MduBenchmark *benchmark = MDU_BENCHMARK (object);
+        MduBenchmarkPrivate *priv = benchmark->priv;
+        Run *run;
+        GError *error;
+
+        run = g_object_get_data (G_OBJECT (simple), "mdu-run");
+        run->cancellable = cancellable;
+        run->fd = -1;
+        run->scratch_fd = -1;
+
+        error = NULL;
+        if (run->mode == MDU_BENCHMARK_MODE_FILESYSTEM) {
+                if (!run_open_filesystem (run, &error))
+                        goto out;
+        } else if (!run_open (run, &error)) {
+                goto out;
+        }
+        if (!run_select_backend (run, &error))
+                goto out;
+
+        switch (run->mode) {
+        case MDU_BENCHMARK_MODE_TRANSFER_RATE:
+                run->units_total = run->num_samples + NUM_ACCESS_TIME_BATCHES;
+                if (run->flags & MDU_BENCHMARK_FLAGS_WRITE) {
+                        if (!run_prepare_writes (run, &error))
+                                goto out;
+                        run->units_total += run->write_slots != NULL ? run->write_slots->len : run->num_samples;
+                }
+                if (!run_transfer_rate (run, &error))
+                        goto out;
+                if (!run_access_time (run, &error))
+                        goto out;
+                break;
+
+        case MDU_BENCHMARK_MODE_RANDOM:
+                run->units_total = G_N_ELEMENTS (random_queue_depths);
+                if (!run_random_iops (run, &error))
+                        goto out;
+                break;
+
+        case MDU_BENCHMARK_MODE_SWEEP:
+                run->units_total = run_get_num_sweep_passes (run);
+                if (!run_sweep (run, &error))
+                        goto out;
+                break;
+
+        case MDU_BENCHMARK_MODE_SEQUENTIAL:
+                run->units_total = SEQUENTIAL_USEC / SEQUENTIAL_SAMPLE_USEC;
+                if (!run_sequential (run, &error))
+                        goto out;
+                break;
+
+        case MDU_BENCHMARK_MODE_FILESYSTEM:
+                /* writing and reading each sample, random reads and writes, fsync() */
+                run->units_total = 2 * run->num_samples + 3;
+                if (!run_filesystem (run, &error))
+                        goto out;
+                break;
+        }
+
+        /* publish the results; they are only looked at once the run is finished */
+        priv->size = run->size;
+        priv->io_engine_used = run->backend->engine;
+        priv->direct_io = run->direct_io;
+        g_array_free (priv->read_samples, TRUE);
+        g_array_free (priv->write_samples, TRUE);
+        g_array_free (priv->access_samples, TRUE);
+        g_array_free (priv->iops_results, TRUE);
+        g_array_free (priv->sweep_results, TRUE);
+        priv->read_samples = run->read_samples;
+        priv->write_samples = run->write_samples;
+        priv->access_samples = run->access_samples;
+        priv->iops_results = run->iops_results;
+        priv->sweep_results = run->sweep_results;
+        run->read_samples = NULL;
+        run->write_samples = NULL;
+        run->access_samples = NULL;
+        run->iops_results = NULL;
+        run->sweep_results = NULL;
+
+ out:
+        if (error != NULL) {
+                g_simple_async_result_set_from_error (simple, error);
+                g_error_free (error);
+        }
+        if (run->fd >= 0)
+                close (run->fd);
+        if (run->scratch_fd >= 0)
+                close (run->scratch_fd);
+        g_atomic_int_set (&priv->running, 0);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+mdu_benchmark_finalize (GObject *object)
+{
+        MduBenchmark *benchmark = MDU_BENCHMARK (object);
+
+        g_free (benchmark->priv->device_file);
+        g_free (benchmark->priv->scratch_directory);
+        if (benchmark->priv->write_regions != NULL)
+                g_array_free (benchmark->priv->write_regions, TRUE);
+        g_static_mutex_free (&benchmark->priv->bytes_lock);
+        g_array_free (benchmark->priv->read_samples, TRUE);
+        g_array_free (benchmark->priv->write_samples, TRUE);
+        g_array_free (benchmark->priv->access_samples, TRUE);
+        g_array_free (benchmark->priv->iops_results, TRUE);
+        g_array_free (benchmark->priv->sweep_results, TRUE);
+
+        if (G_OBJECT_CLASS (mdu_benchmark_parent_class)->finalize != NULL)
+                G_OBJECT_CLASS (mdu_benchmark_parent_class)->finalize (object);
+}
+
+static void
+mdu_benchmark_class_init (MduBenchmarkClass *klass)
+{
+        GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+        gobject_class->finalize = mdu_benchmark_finalize;
+
+        g_type_class_add_private (klass, sizeof (MduBenchmarkPrivate));
+
+        /**
+         * MduBenchmark::progress-changed:
+         * @benchmark: A #MduBenchmark.
+         *
+         * Emitted in the main loop when the value returned by
+         * mdu_benchmark_get_progress() changes.
+         */
+        signals[PROGRESS_CHANGED_SIGNAL] =
+                g_signal_new ("progress-changed",
+                              G_TYPE_FROM_CLASS (klass),
+                              G_SIGNAL_RUN_LAST,
+                              G_STRUCT_OFFSET (MduBenchmarkClass, progress_changed),
+                              NULL, NULL,
+                              g_cclosure_marshal_VOID__VOID,
+                              G_TYPE_NONE, 0);
+
+        /**
+         * MduBenchmark::sample-added:
+         * @benchmark: A #MduBenchmark.
+         * @kind: A #MduBenchmarkSampleKind.
+         * @sample: The #MduBenchmarkSample, only valid during the emission.
+         *
+         * Emitted in the main loop for every sample as it is taken so
+         * results can be shown while the benchmark is running. The
+         * samples returned by e.g. mdu_benchmark_get_read_transfer_rate_samples()
+         * are only updated once the run is finished.
+         */
+        signals[SAMPLE_ADDED_SIGNAL] =
+                g_signal_new ("sample-added",
+                              G_TYPE_FROM_CLASS (klass),
+                              G_SIGNAL_RUN_LAST,
+                              G_STRUCT_OFFSET (MduBenchmarkClass, sample_added),
+                              NULL, NULL,
+                              g_cclosure_marshal_VOID__UINT_POINTER,
+                              G_TYPE_NONE, 2,
+                              G_TYPE_UINT,
+                              G_TYPE_POINTER);
+}
+
+static void
+mdu_benchmark_init (MduBenchmark *benchmark)
+{
+        benchmark->priv = G_TYPE_INSTANCE_GET_PRIVATE (benchmark, MDU_TYPE_BENCHMARK, MduBenchmarkPrivate);
+
+        benchmark->priv->io_engine = MDU_BENCHMARK_IO_ENGINE_AUTO;
+        benchmark->priv->queue_depth = 32;
+        benchmark->priv->block_size = 1024 * 1024;
+        benchmark->priv->num_workers = 1;
+        g_static_mutex_init (&benchmark->priv->bytes_lock);
+        benchmark->priv->read_samples = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSample));
+        benchmark->priv->write_samples = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSample));
+        benchmark->priv->access_samples = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSample));
+        benchmark->priv->iops_results = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkIopsResult));
+        benchmark->priv->sweep_results = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSweepPoint));
+}
+
+/**
+ * mdu_benchmark_new:
+ * @device_file: The block device or regular file to benchmark.
+ *
+ * Creates a new #MduBenchmark for @device_file. Regular files, for
+ * example a file backing a loop device, are supported for testing.
+ * For %MDU_BENCHMARK_MODE_FILESYSTEM @device_file is a directory on
+ * the filesystem to measure instead.
+ *
+ * Returns: A #MduBenchmark. Free with g_object_unref().
+ */
+MduBenchmark *
+mdu_benchmark_new (const gchar *device_file)
+{
+        MduBenchmark *benchmark;
+
+        g_return_val_if_fail (device_file != NULL, NULL);
+
+        benchmark = MDU_BENCHMARK (g_object_new (MDU_TYPE_BENCHMARK, NULL));
+        benchmark->priv->device_file = g_strdup (device_file);
+
+        return benchmark;
+}
+
+const gchar *
+mdu_benchmark_get_device_file (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), NULL);
+        return benchmark->priv->device_file;
+}
+
+/**
+ * mdu_benchmark_set_mode:
+ * @benchmark: A #MduBenchmark.
+ * @mode: What to measure.
+ *
+ * Sets what to measure. The default is %MDU_BENCHMARK_MODE_TRANSFER_RATE.
+ */
+void
+mdu_benchmark_set_mode (MduBenchmark     *benchmark,
+                        MduBenchmarkMode  mode)
+{
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+        benchmark->priv->mode = mode;
+}
+
+MduBenchmarkMode
+mdu_benchmark_get_mode (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), MDU_BENCHMARK_MODE_TRANSFER_RATE);
+        return benchmark->priv->mode;
+}
+
+/**
+ * mdu_benchmark_set_io_engine:
+ * @benchmark: A #MduBenchmark.
+ * @io_engine: The I/O engine to use.
+ *
+ * Sets the I/O engine to use. The default is
+ * %MDU_BENCHMARK_IO_ENGINE_AUTO which picks io_uring, then libaio and
+ * then threads depending on what is available.
+ */
+void
+mdu_benchmark_set_io_engine (MduBenchmark         *benchmark,
+                             MduBenchmarkIOEngine  io_engine)
+{
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+        benchmark->priv->io_engine = io_engine;
+}
+
+MduBenchmarkIOEngine
+mdu_benchmark_get_io_engine (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), MDU_BENCHMARK_IO_ENGINE_AUTO);
+        return benchmark->priv->io_engine;
+}
+
+/**
+ * mdu_benchmark_set_queue_depth:
+ * @benchmark: A #MduBenchmark.
+ * @queue_depth: Number of requests in flight per worker.
+ *
+ * Sets the number of requests each worker keeps in flight when
+ * measuring the transfer rate. The default is 32.
+ */
+void
+mdu_benchmark_set_queue_depth (MduBenchmark *benchmark,
+                               guint         queue_depth)
+{
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+        g_return_if_fail (queue_depth > 0);
+        benchmark->priv->queue_depth = queue_depth;
+}
+
+guint
+mdu_benchmark_get_queue_depth (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), 0);
+        return benchmark->priv->queue_depth;
+}
+
+/**
+ * mdu_benchmark_set_block_size:
+ * @benchmark: A #MduBenchmark.
+ * @block_size: Size of each request, in bytes.
+ *
+ * Sets the size of the requests used when measuring the transfer
+ * rate. It is rounded to a multiple of the logical block size of the
+ * device. The default is 1 MiB.
+ */
+void
+mdu_benchmark_set_block_size (MduBenchmark *benchmark,
+                              guint         block_size)
+{
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+        g_return_if_fail (block_size > 0);
+        benchmark->priv->block_size = block_size;
+}
+
+guint
+mdu_benchmark_get_block_size (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), 0);
+        return benchmark->priv->block_size;
+}
+
+/**
+ * mdu_benchmark_set_num_workers:
+ * @benchmark: A #MduBenchmark.
+ * @num_workers: Number of workers.
+ *
+ * Sets the number of threads submitting I/O in parallel when
+ * measuring the transfer rate. The default is 1.
+ */
+void
+mdu_benchmark_set_num_workers (MduBenchmark *benchmark,
+                               guint         num_workers)
+{
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+        g_return_if_fail (num_workers > 0);
+        benchmark->priv->num_workers = num_workers;
+}
+
+guint
+mdu_benchmark_get_num_workers (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), 0);
+        return benchmark->priv->num_workers;
+}
+
+/**
+ * mdu_benchmark_set_write_regions:
+ * @benchmark: A #MduBenchmark.
+ * @regions: The regions of the device that may be written to.
+ * @num_regions: Number of elements in @regions or 0 to allow writing anywhere.
+ *
+ * Limits the writes of %MDU_BENCHMARK_FLAGS_WRITE to @regions, typically
+ * the unallocated space on a partitioned device as found in the
+ * #MduVolumeHole objects of a #MduPool. The device may then be in use.
+ *
+ * Right before writing, the kernel is asked whether the space is still
+ * unallocated; if not, the benchmark fails with %MDU_ERROR_BUSY. The
+ * data is read and written back like for the whole device and a margin
+ * is kept to the edges of the regions.
+ */
+void
+mdu_benchmark_set_write_regions (MduBenchmark             *benchmark,
+                                 const MduBenchmarkRegion *regions,
+                                 guint                     num_regions)
+{
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+        g_return_if_fail (regions != NULL || num_regions == 0);
+
+        if (benchmark->priv->write_regions != NULL) {
+                g_array_free (benchmark->priv->write_regions, TRUE);
+                benchmark->priv->write_regions = NULL;
+        }
+        if (num_regions > 0) {
+                benchmark->priv->write_regions = g_array_sized_new (FALSE, FALSE, sizeof (MduBenchmarkRegion), num_regions);
+                g_array_append_vals (benchmark->priv->write_regions, regions, num_regions);
+        }
+}
+
+/**
+ * mdu_benchmark_set_scratch_directory:
+ * @benchmark: A #MduBenchmark.
+ * @directory: A directory on a mounted filesystem of the device or %NULL.
+ * @device_offset: Where that filesystem starts on the device.
+ *
+ * Makes %MDU_BENCHMARK_FLAGS_WRITE write to a temporary file in @directory
+ * instead of to the device, which is then only read from. The file takes
+ * up to 1 GB but never more than half of the free space, and is deleted
+ * when the benchmark is done. This takes precedence over
+ * mdu_benchmark_set_write_regions().
+ *
+ * The offset of the write samples is where the file is on the device,
+ * as far as the filesystem tells.
+ */
+void
+mdu_benchmark_set_scratch_directory (MduBenchmark *benchmark,
+                                     const gchar  *directory,
+                                     guint64       device_offset)
+{
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+        g_free (benchmark->priv->scratch_directory);
+        benchmark->priv->scratch_directory = g_strdup (directory);
+        benchmark->priv->scratch_offset = device_offset;
+}
+
+/**
+ * mdu_benchmark_run_async:
+ * @benchmark: A #MduBenchmark.
+ * @flags: Flags from #MduBenchmarkFlags.
+ * @cancellable: A #GCancellable or %NULL.
+ * @callback: Function to call when the benchmark is done.
+ * @user_data: User data to pass to @callback.
+ *
+ * Runs the benchmark in a separate thread. The settings are copied so
+ * changing them does not affect a benchmark that is already running.
+ * Progress is reported through #MduBenchmark::progress-changed and
+ * samples through #MduBenchmark::sample-added.
+ *
+ * When done, @callback is invoked in the main loop and you can call
+ * mdu_benchmark_run_finish() to get the result.
+ */
+void
+mdu_benchmark_run_async (MduBenchmark         *benchmark,
+                         MduBenchmarkFlags     flags,
+                         GCancellable         *cancellable,
+                         GAsyncReadyCallback   callback,
+                         gpointer              user_data)
+{
+        GSimpleAsyncResult *simple;
+        Run *run;
+
+        g_return_if_fail (MDU_IS_BENCHMARK (benchmark));
+
+        simple = g_simple_async_result_new (G_OBJECT (benchmark),
+                                            callback,
+                                            user_data,
+                                            mdu_benchmark_run_async);
+
+        if (!g_atomic_int_compare_and_exchange (&benchmark->priv->running, 0, 1)) {
+                g_simple_async_result_set_error (simple,
+                                                 MDU_ERROR,
+                                                 MDU_ERROR_BUSY,
+                                                 "A benchmark is already running");
+                g_simple_async_result_complete_in_idle (simple);
+                goto out;
+        }
+        g_atomic_int_set (&benchmark->priv->progress, 0);
+        g_static_mutex_lock (&benchmark->priv->bytes_lock);
+        benchmark->priv->bytes_transferred = 0;
+        g_static_mutex_unlock (&benchmark->priv->bytes_lock);
+
+        run = g_new0 (Run, 1);
+        run->benchmark = benchmark;
+        run->flags = flags;
+        run->device_file = g_strdup (benchmark->priv->device_file);
+        run->mode = benchmark->priv->mode;
+        run->io_engine = benchmark->priv->io_engine;
+        run->queue_depth = benchmark->priv->queue_depth;
+        run->block_size = benchmark->priv->block_size;
+        run->num_workers = benchmark->priv->num_workers;
+        if (benchmark->priv->write_regions != NULL) {
+                run->write_regions = g_array_sized_new (FALSE, FALSE, sizeof (MduBenchmarkRegion),
+                                                        benchmark->priv->write_regions->len);
+                g_array_append_vals (run->write_regions,
+                                     benchmark->priv->write_regions->data,
+                                     benchmark->priv->write_regions->len);
+        }
+        run->scratch_directory = g_strdup (benchmark->priv->scratch_directory);
+        run->scratch_offset = benchmark->priv->scratch_offset;
+        run->read_samples = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSample));
+        run->write_samples = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSample));
+        run->access_samples = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSample));
+        run->iops_results = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkIopsResult));
+        run->sweep_results = g_array_new (FALSE, FALSE, sizeof (MduBenchmarkSweepPoint));
+        g_object_set_data_full (G_OBJECT (simple), "mdu-run", run, (GDestroyNotify) run_free);
+
+        g_simple_async_result_run_in_thread (simple,
+                                             run_in_thread,
+                                             G_PRIORITY_DEFAULT,
+                                             cancellable);
+
+ out:
+        g_object_unref (simple);
+}
+
+/**
+ * mdu_benchmark_run_finish:
+ * @benchmark: A #MduBenchmark.
+ * @res: A #GAsyncResult.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes a benchmark started with mdu_benchmark_run_async(). If the
+ * operation was cancelled, @error is set to %MDU_ERROR_CANCELLED.
+ *
+ * Returns: %TRUE if the benchmark completed and the results are
+ * available, %FALSE if @error is set.
+ */
+gboolean
+mdu_benchmark_run_finish (MduBenchmark  *benchmark,
+                          GAsyncResult  *res,
+                          GError       **error)
+{
+        GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (res);
+
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), FALSE);
+        g_return_val_if_fail (res != NULL, FALSE);
+
+        g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == mdu_benchmark_run_async);
+
+        if (g_simple_async_result_propagate_error (simple, error))
+                return FALSE;
+
+        return TRUE;
+}
+
+gboolean
+mdu_benchmark_is_running (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), FALSE);
+        return g_atomic_int_get (&benchmark->priv->running);
+}
+
+/**
+ * mdu_benchmark_get_progress:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the progress of the running benchmark.
+ *
+ * Returns: A number between 0.0 and 1.0.
+ */
+gdouble
+mdu_benchmark_get_progress (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), 0.0);
+        return g_atomic_int_get (&benchmark->priv->progress) / 1000.0;
+}
+
+/**
+ * mdu_benchmark_get_bytes_transferred:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the number of bytes read or written so far by the running
+ * benchmark, or by the last one if none is running. This can be
+ * polled to follow the throughput over time, e.g. of several drives
+ * benchmarked at once.
+ *
+ * Returns: The number of bytes transferred.
+ */
+guint64
+mdu_benchmark_get_bytes_transferred (MduBenchmark *benchmark)
+{
+        guint64 ret;
+
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), 0);
+
+        g_static_mutex_lock (&benchmark->priv->bytes_lock);
+        ret = benchmark->priv->bytes_transferred;
+        g_static_mutex_unlock (&benchmark->priv->bytes_lock);
+
+        return ret;
+}
+
+/**
+ * mdu_benchmark_get_size:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the size of the device as seen by the last completed run. The
+ * offsets of all samples are between 0 and this value.
+ *
+ * Returns: The size in bytes or 0 if no run has completed.
+ */
+guint64
+mdu_benchmark_get_size (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), 0);
+        return benchmark->priv->size;
+}
+
+/**
+ * mdu_benchmark_get_io_engine_used:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the I/O engine the last completed run used. This is useful
+ * with %MDU_BENCHMARK_IO_ENGINE_AUTO.
+ *
+ * Returns: A #MduBenchmarkIOEngine.
+ */
+MduBenchmarkIOEngine
+mdu_benchmark_get_io_engine_used (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), MDU_BENCHMARK_IO_ENGINE_AUTO);
+        return benchmark->priv->io_engine_used;
+}
+
+/**
+ * mdu_benchmark_get_direct_io:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Checks whether the last completed run bypassed the page cache. This
+ * is not the case for files on filesystems without O_DIRECT support.
+ *
+ * Returns: %TRUE if O_DIRECT was used.
+ */
+gboolean
+mdu_benchmark_get_direct_io (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), FALSE);
+        return benchmark->priv->direct_io;
+}
+
+/**
+ * mdu_benchmark_get_read_transfer_rate_samples:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the read transfer rates, in bytes per second, measured by the
+ * last completed run.
+ *
+ * Returns: A #GArray of #MduBenchmarkSample owned by @benchmark.
+ */
+GArray *
+mdu_benchmark_get_read_transfer_rate_samples (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), NULL);
+        return benchmark->priv->read_samples;
+}
+
+/**
+ * mdu_benchmark_get_write_transfer_rate_samples:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the write transfer rates, in bytes per second, measured by the
+ * last completed run. Empty unless %MDU_BENCHMARK_FLAGS_WRITE was passed.
+ *
+ * Returns: A #GArray of #MduBenchmarkSample owned by @benchmark.
+ */
+GArray *
+mdu_benchmark_get_write_transfer_rate_samples (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), NULL);
+        return benchmark->priv->write_samples;
+}
+
+/**
+ * mdu_benchmark_get_access_time_samples:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the access times, in seconds, of the random reads issued by
+ * the last completed run.
+ *
+ * Returns: A #GArray of #MduBenchmarkSample owned by @benchmark.
+ */
+GArray *
+mdu_benchmark_get_access_time_samples (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), NULL);
+        return benchmark->priv->access_samples;
+}
+
+/**
+ * mdu_benchmark_get_iops_results:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the results of the random reads issued by the last completed
+ * run, one per queue depth. Empty unless the mode was
+ * %MDU_BENCHMARK_MODE_RANDOM.
+ *
+ * Returns: A #GArray of #MduBenchmarkIopsResult owned by @benchmark.
+ */
+GArray *
+mdu_benchmark_get_iops_results (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), NULL);
+        return benchmark->priv->iops_results;
+}
+
+/**
+ * mdu_benchmark_get_sweep_results:
+ * @benchmark: A #MduBenchmark.
+ *
+ * Gets the read transfer rate for each request size measured by the
+ * last completed run, smallest size first. Empty unless the mode was
+ * %MDU_BENCHMARK_MODE_SWEEP.
+ *
+ * Returns: A #GArray of #MduBenchmarkSweepPoint owned by @benchmark.
+ */
+GArray *
+mdu_benchmark_get_sweep_results (MduBenchmark *benchmark)
+{
+        g_return_val_if_fail (MDU_IS_BENCHMARK (benchmark), NULL);
+        return benchmark->priv->sweep_results;
+}
+
+/**
+ * mdu_benchmark_samples_get_max_min_avg:
+ * @samples: A #GArray of #MduBenchmarkSample.
+ * @out_max: Return location for the largest value or %NULL.
+ * @out_min: Return location for the smallest value or %NULL.
+ * @out_avg: Return location for the mean value or %NULL.
+ *
+ * Summarizes transfer rate or access time samples such as those returned
+ * by mdu_benchmark_get_read_transfer_rate_samples(). All values are 0 if
+ * @samples is empty.
+ */
+void
+mdu_benchmark_samples_get_max_min_avg (GArray  *samples,
+                                       gdouble *out_max,
+                                       gdouble *out_min,
+                                       gdouble *out_avg)
+{
+        guint n;
+        gdouble max;
+        gdouble min;
+        gdouble avg;
+        gdouble sum;
+
+        g_return_if_fail (samples != NULL);
+
+        if (samples->len == 0) {
+                max = 0;
+                min = 0;
+                avg = 0;
+                goto out;
+        }
+        max = -G_MAXDOUBLE;
+        min = G_MAXDOUBLE;
+        sum = 0;
+
+        for (n = 0; n < samples->len; n++) {
+                MduBenchmarkSample *sample = &g_array_index (samples, MduBenchmarkSample, n);
+                if (sample->value > max)
+                        max = sample->value;
+                if (sample->value < min)
+                        min = sample->value;
+                sum += sample->value;
+        }
+        avg = sum / samples->len;
+
+ out:
+        if (out_max != NULL)
+                *out_max = max;
+        if (out_min != NULL)
+                *out_min = min;
+        if (out_avg != NULL)
+                *out_avg = avg;
+}
+
+/**
+ * mdu_benchmark_sweep_get_optimal_block_size:
+ * @sweep_results: A #GArray of #MduBenchmarkSweepPoint.
+ *
+ * Picks the smallest request size in @sweep_results that gets within
+ * 5% of the highest transfer rate measured. Larger requests don't make
+ * the drive any faster, so this is a good choice for the alignment of
+ * partitions and the chunk size of RAID arrays.
+ *
+ * Returns: The request size in bytes or 0 if @sweep_results is empty.
+ */
+guint
+mdu_benchmark_sweep_get_optimal_block_size (GArray *sweep_results)
+{
+        gdouble peak;
+        guint ret;
+        guint n;
+
+        g_return_val_if_fail (sweep_results != NULL, 0);
+
+        peak = 0.0;
+        for (n = 0; n < sweep_results->len; n++) {
+                MduBenchmarkSweepPoint *point = &g_array_index (sweep_results, MduBenchmarkSweepPoint, n);
+                peak = MAX (peak, point->transfer_rate);
+        }
+
+        ret = 0;
+        for (n = 0; n < sweep_results->len; n++) {
+                MduBenchmarkSweepPoint *point = &g_array_index (sweep_results, MduBenchmarkSweepPoint, n);
+                if (point->transfer_rate >= peak * SWEEP_OPTIMUM_FRACTION &&
+                    (ret == 0 || point->block_size < ret))
+                        ret = point->block_size;
+        }
+
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* see the description of MduBenchmarkHistogram */
+#define HISTOGRAM_LINEAR_LIMIT 64
+#define HISTOGRAM_SUB_BUCKET_BITS 5
+#define HISTOGRAM_MAX_MSB 35
+
+static guint
+histogram_get_bucket (guint64 usec)
+{
+        guint msb;
+
+        if (usec < HISTOGRAM_LINEAR_LIMIT)
+                return usec;
+
+        for (msb = HISTOGRAM_MAX_MSB; msb > 6; msb--) {
+                if (usec & (G_GUINT64_CONSTANT (1) << msb))
+                        break;
+        }
+        if (usec >> (HISTOGRAM_MAX_MSB + 1))
+                return MDU_BENCHMARK_HISTOGRAM_NUM_BUCKETS - 1;
+
+        return HISTOGRAM_LINEAR_LIMIT +
+                (msb - 6) * (1 << HISTOGRAM_SUB_BUCKET_BITS) +
+                ((usec >> (msb - HISTOGRAM_SUB_BUCKET_BITS)) & ((1 << HISTOGRAM_SUB_BUCKET_BITS) - 1));
+}
+
+/* the largest value that goes into @bucket */
+static guint64
+histogram_get_bucket_max (guint bucket)
+{
+        guint msb;
+        guint sub;
+
+        if (bucket < HISTOGRAM_LINEAR_LIMIT)
+                return bucket;
+
+        msb = (bucket - HISTOGRAM_LINEAR_LIMIT) / (1 << HISTOGRAM_SUB_BUCKET_BITS) + 6;
+        sub = (bucket - HISTOGRAM_LINEAR_LIMIT) % (1 << HISTOGRAM_SUB_BUCKET_BITS);
+        return (((guint64) ((1 << HISTOGRAM_SUB_BUCKET_BITS) + sub + 1)) << (msb - HISTOGRAM_SUB_BUCKET_BITS)) - 1;
+}
+
+/**
+ * mdu_benchmark_histogram_add_value:
+ * @histogram: A #MduBenchmarkHistogram.
+ * @usec: The value to record, in microseconds.
+ *
+ * Records @usec in @histogram. A zero-filled #MduBenchmarkHistogram
+ * is an empty histogram.
+ */
+void
+mdu_benchmark_histogram_add_value (MduBenchmarkHistogram *histogram,
+                                   guint64                usec)
+{
+        g_return_if_fail (histogram != NULL);
+
+        if (histogram->num_values == 0 || usec < histogram->min_usec)
+                histogram->min_usec = usec;
+        if (usec > histogram->max_usec)
+                histogram->max_usec = usec;
+        histogram->sum_usec += usec;
+        histogram->num_values++;
+        histogram->counts[histogram_get_bucket (usec)]++;
+}
+
+/**
+ * mdu_benchmark_histogram_merge:
+ * @histogram: A #MduBenchmarkHistogram.
+ * @other: Another #MduBenchmarkHistogram.
+ *
+ * Adds all values recorded in @other to @histogram.
+ */
+void
+mdu_benchmark_histogram_merge (MduBenchmarkHistogram       *histogram,
+                               const MduBenchmarkHistogram *other)
+{
+        guint n;
+
+        g_return_if_fail (histogram != NULL);
+        g_return_if_fail (other != NULL);
+
+        if (other->num_values == 0)
+                return;
+
+        if (histogram->num_values == 0 || other->min_usec < histogram->min_usec)
+                histogram->min_usec = other->min_usec;
+        if (other->max_usec > histogram->max_usec)
+                histogram->max_usec = other->max_usec;
+        histogram->sum_usec += other->sum_usec;
+        histogram->num_values += other->num_values;
+        for (n = 0; n < MDU_BENCHMARK_HISTOGRAM_NUM_BUCKETS; n++)
+                histogram->counts[n] += other->counts[n];
+}
+
+/**
+ * mdu_benchmark_histogram_get_percentile:
+ * @histogram: A #MduBenchmarkHistogram.
+ * @percentile: A number between 0 and 100, e.g. 99.9.
+ *
+ * Estimates the value that @percentile percent of the values in
+ * @histogram did not exceed. This is the largest value of the bucket
+ * the percentile falls in, but never more than the largest value
+ * recorded.
+ *
+ * Returns: The value in seconds or 0 if @histogram is empty.
+ */
+gdouble
+mdu_benchmark_histogram_get_percentile (const MduBenchmarkHistogram *histogram,
+                                        gdouble                      percentile)
+{
+        gdouble ret;
+        gdouble exact_target;
+        guint64 target;
+        guint64 seen;
+        guint n;
+
+        g_return_val_if_fail (histogram != NULL, 0.0);
+
+        ret = 0.0;
+        if (histogram->num_values == 0)
+                goto out;
+
+        /* the number of values at or below the percentile, rounded up */
+        exact_target = histogram->num_values * CLAMP (percentile, 0.0, 100.0) / 100.0;
+        target = (guint64) exact_target;
+        if (target < exact_target)
+                target++;
+        target = MAX (target, 1);
+        seen = 0;
+        for (n = 0; n < MDU_BENCHMARK_HISTOGRAM_NUM_BUCKETS - 1; n++) {
+                seen += histogram->counts[n];
+                if (seen >= target)
+                        break;
+        }
+        ret = CLAMP (histogram_get_bucket_max (n), histogram->min_usec, histogram->max_usec) / ((gdouble) G_USEC_PER_SEC);
+
+ out:
+        return ret;
+}
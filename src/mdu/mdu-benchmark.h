@@ -0,0 +1,291 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-benchmark.h
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#if !defined (__MDU_INSIDE_MDU_H) && !defined (MDU_COMPILATION)
+#error "Only <mdu/mdu.h> can be included directly, this file may disappear or change contents."
+#endif
+
+#ifndef __MDU_BENCHMARK_H
+#define __MDU_BENCHMARK_H
+
+#include <mdu/mdu-types.h>
+
+G_BEGIN_DECLS
+
+#define MDU_TYPE_BENCHMARK         (mdu_benchmark_get_type ())
+#define MDU_BENCHMARK(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), MDU_TYPE_BENCHMARK, MduBenchmark))
+#define MDU_BENCHMARK_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST ((k), MDU_BENCHMARK,  MduBenchmarkClass))
+#define MDU_IS_BENCHMARK(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), MDU_TYPE_BENCHMARK))
+#define MDU_IS_BENCHMARK_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), MDU_TYPE_BENCHMARK))
+#define MDU_BENCHMARK_GET_CLASS(k) (G_TYPE_INSTANCE_GET_CLASS ((k), MDU_TYPE_BENCHMARK, MduBenchmarkClass))
+
+typedef struct _MduBenchmarkClass       MduBenchmarkClass;
+typedef struct _MduBenchmarkPrivate     MduBenchmarkPrivate;
+typedef struct _MduBenchmarkSample      MduBenchmarkSample;
+typedef struct _MduBenchmarkHistogram   MduBenchmarkHistogram;
+typedef struct _MduBenchmarkIopsResult  MduBenchmarkIopsResult;
+typedef struct _MduBenchmarkSweepPoint  MduBenchmarkSweepPoint;
+typedef struct _MduBenchmarkRegion      MduBenchmarkRegion;
+
+/**
+ * MduBenchmarkSampleKind:
+ * @MDU_BENCHMARK_SAMPLE_KIND_READ_TRANSFER_RATE: A read transfer rate, see mdu_benchmark_get_read_transfer_rate_samples().
+ * @MDU_BENCHMARK_SAMPLE_KIND_WRITE_TRANSFER_RATE: A write transfer rate, see mdu_benchmark_get_write_transfer_rate_samples().
+ * @MDU_BENCHMARK_SAMPLE_KIND_ACCESS_TIME: An access time, see mdu_benchmark_get_access_time_samples().
+ *
+ * What a sample passed to #MduBenchmark::sample-added measures.
+ */
+typedef enum {
+        MDU_BENCHMARK_SAMPLE_KIND_READ_TRANSFER_RATE,
+        MDU_BENCHMARK_SAMPLE_KIND_WRITE_TRANSFER_RATE,
+        MDU_BENCHMARK_SAMPLE_KIND_ACCESS_TIME
+} MduBenchmarkSampleKind;
+
+struct _MduBenchmark
+{
+        GObject parent;
+
+        /* private */
+        MduBenchmarkPrivate *priv;
+};
+
+struct _MduBenchmarkClass
+{
+        GObjectClass parent_class;
+
+        /* signals */
+        void (*progress_changed) (MduBenchmark             *benchmark);
+        void (*sample_added)     (MduBenchmark             *benchmark,
+                                  MduBenchmarkSampleKind    kind,
+                                  const MduBenchmarkSample *sample);
+};
+
+/**
+ * MduBenchmarkIOEngine:
+ * @MDU_BENCHMARK_IO_ENGINE_AUTO: Use the best engine available at run time.
+ * @MDU_BENCHMARK_IO_ENGINE_IO_URING: Use Linux io_uring.
+ * @MDU_BENCHMARK_IO_ENGINE_LIBAIO: Use Linux native AIO.
+ * @MDU_BENCHMARK_IO_ENGINE_THREADS: Use blocking I/O with one thread per request in flight.
+ *
+ * How a #MduBenchmark submits I/O to the device.
+ */
+typedef enum {
+        MDU_BENCHMARK_IO_ENGINE_AUTO,
+        MDU_BENCHMARK_IO_ENGINE_IO_URING,
+        MDU_BENCHMARK_IO_ENGINE_LIBAIO,
+        MDU_BENCHMARK_IO_ENGINE_THREADS
+} MduBenchmarkIOEngine;
+
+/**
+ * MduBenchmarkMode:
+ * @MDU_BENCHMARK_MODE_TRANSFER_RATE: Measure the sequential transfer rate
+ *   across the device and the access time of random reads.
+ * @MDU_BENCHMARK_MODE_RANDOM: Measure the number of random 4 KiB reads per
+ *   second and their latency at queue depths 1, 4 and 32. This mode never writes.
+ * @MDU_BENCHMARK_MODE_SWEEP: Measure the sequential read transfer rate
+ *   for each power-of-two request size from 4 KiB to 8 MiB, see
+ *   mdu_benchmark_get_sweep_results(). This mode never writes.
+ * @MDU_BENCHMARK_MODE_SEQUENTIAL: Read the device sequentially from the
+ *   start for 30 seconds, with one read transfer rate sample per second.
+ *   This mode never writes.
+ * @MDU_BENCHMARK_MODE_FILESYSTEM: Measure a mounted filesystem through a
+ *   temporary file in the directory passed to mdu_benchmark_new(): the
+ *   sequential write and read transfer rate, random 4 KiB reads and
+ *   writes and the latency of fsync(). The results of
+ *   mdu_benchmark_get_iops_results() are, in this order, random reads,
+ *   random writes with the time to sync them included and 4 KiB writes
+ *   each followed by fsync(). This mode always writes, but only to the
+ *   temporary file.
+ *
+ * What a #MduBenchmark measures.
+ */
+typedef enum {
+        MDU_BENCHMARK_MODE_TRANSFER_RATE,
+        MDU_BENCHMARK_MODE_RANDOM,
+        MDU_BENCHMARK_MODE_SWEEP,
+        MDU_BENCHMARK_MODE_SEQUENTIAL,
+        MDU_BENCHMARK_MODE_FILESYSTEM
+} MduBenchmarkMode;
+
+/**
+ * MduBenchmarkFlags:
+ * @MDU_BENCHMARK_FLAGS_NONE: No flags set.
+ * @MDU_BENCHMARK_FLAGS_WRITE: Also measure the write transfer rate. Data
+ *   is read and then written back so the contents of the device are
+ *   preserved, however the device must not be in use unless writes are
+ *   limited with mdu_benchmark_set_write_regions() or
+ *   mdu_benchmark_set_scratch_directory().
+ *
+ * Flags used in mdu_benchmark_run_async().
+ */
+typedef enum {
+        MDU_BENCHMARK_FLAGS_NONE = 0x00,
+        MDU_BENCHMARK_FLAGS_WRITE = (1<<0)
+} MduBenchmarkFlags;
+
+/**
+ * MduBenchmarkSample:
+ * @offset: The offset on the device the sample was taken at.
+ * @value: The transfer rate in bytes per second or the access time in seconds.
+ *
+ * A single measurement taken by #MduBenchmark.
+ */
+struct _MduBenchmarkSample
+{
+        guint64 offset;
+        gdouble value;
+};
+
+/**
+ * MDU_BENCHMARK_HISTOGRAM_NUM_BUCKETS:
+ *
+ * Number of buckets in a #MduBenchmarkHistogram.
+ */
+#define MDU_BENCHMARK_HISTOGRAM_NUM_BUCKETS 1024
+
+/**
+ * MduBenchmarkHistogram:
+ * @num_values: Number of values recorded.
+ * @min_usec: The smallest value recorded, in microseconds.
+ * @max_usec: The largest value recorded, in microseconds.
+ * @sum_usec: The sum of all values recorded, in microseconds.
+ * @counts: Number of values in each bucket.
+ *
+ * A latency histogram with log-linear buckets in the style of
+ * HdrHistogram. Values below 64 µs get a bucket each; above that every
+ * power of two is split into 32 buckets so values are recorded with a
+ * precision of about 3% up to many hours.
+ */
+struct _MduBenchmarkHistogram
+{
+        guint64 num_values;
+        guint64 min_usec;
+        guint64 max_usec;
+        guint64 sum_usec;
+        guint64 counts[MDU_BENCHMARK_HISTOGRAM_NUM_BUCKETS];
+};
+
+/**
+ * MduBenchmarkIopsResult:
+ * @queue_depth: The number of requests that were kept in flight.
+ * @iops: Completed requests per second.
+ * @latency: The latency of the requests.
+ *
+ * The result of measuring random reads at one queue depth, see
+ * %MDU_BENCHMARK_MODE_RANDOM.
+ */
+struct _MduBenchmarkIopsResult
+{
+        guint queue_depth;
+        gdouble iops;
+        MduBenchmarkHistogram latency;
+};
+
+/**
+ * MduBenchmarkSweepPoint:
+ * @block_size: The size of the requests, in bytes.
+ * @transfer_rate: The read transfer rate in bytes per second.
+ *
+ * The result of reading with one request size, see
+ * %MDU_BENCHMARK_MODE_SWEEP.
+ */
+struct _MduBenchmarkSweepPoint
+{
+        guint block_size;
+        gdouble transfer_rate;
+};
+
+/**
+ * MduBenchmarkRegion:
+ * @offset: Where the region starts on the device, in bytes.
+ * @size: The size of the region, in bytes.
+ *
+ * A range of the device, see mdu_benchmark_set_write_regions().
+ */
+struct _MduBenchmarkRegion
+{
+        guint64 offset;
+        guint64 size;
+};
+
+GType                 mdu_benchmark_get_type        (void);
+MduBenchmark         *mdu_benchmark_new             (const gchar          *device_file);
+const gchar          *mdu_benchmark_get_device_file (MduBenchmark         *benchmark);
+
+void                  mdu_benchmark_set_mode        (MduBenchmark         *benchmark,
+                                                     MduBenchmarkMode      mode);
+MduBenchmarkMode      mdu_benchmark_get_mode        (MduBenchmark         *benchmark);
+void                  mdu_benchmark_set_io_engine   (MduBenchmark         *benchmark,
+                                                     MduBenchmarkIOEngine  io_engine);
+MduBenchmarkIOEngine  mdu_benchmark_get_io_engine   (MduBenchmark         *benchmark);
+void                  mdu_benchmark_set_queue_depth (MduBenchmark         *benchmark,
+                                                     guint                 queue_depth);
+guint                 mdu_benchmark_get_queue_depth (MduBenchmark         *benchmark);
+void                  mdu_benchmark_set_block_size  (MduBenchmark         *benchmark,
+                                                     guint                 block_size);
+guint                 mdu_benchmark_get_block_size  (MduBenchmark         *benchmark);
+void                  mdu_benchmark_set_num_workers (MduBenchmark         *benchmark,
+                                                     guint                 num_workers);
+guint                 mdu_benchmark_get_num_workers (MduBenchmark         *benchmark);
+void                  mdu_benchmark_set_write_regions     (MduBenchmark             *benchmark,
+                                                           const MduBenchmarkRegion *regions,
+                                                           guint                     num_regions);
+void                  mdu_benchmark_set_scratch_directory (MduBenchmark             *benchmark,
+                                                           const gchar              *directory,
+                                                           guint64                   device_offset);
+
+void                  mdu_benchmark_run_async       (MduBenchmark         *benchmark,
+                                                     MduBenchmarkFlags     flags,
+                                                     GCancellable         *cancellable,
+                                                     GAsyncReadyCallback   callback,
+                                                     gpointer              user_data);
+gboolean              mdu_benchmark_run_finish      (MduBenchmark         *benchmark,
+                                                     GAsyncResult         *res,
+                                                     GError              **error);
+gboolean              mdu_benchmark_is_running      (MduBenchmark         *benchmark);
+gdouble               mdu_benchmark_get_progress    (MduBenchmark         *benchmark);
+guint64               mdu_benchmark_get_bytes_transferred (MduBenchmark   *benchmark);
+
+guint64               mdu_benchmark_get_size                        (MduBenchmark *benchmark);
+MduBenchmarkIOEngine  mdu_benchmark_get_io_engine_used              (MduBenchmark *benchmark);
+gboolean              mdu_benchmark_get_direct_io                   (MduBenchmark *benchmark);
+GArray               *mdu_benchmark_get_read_transfer_rate_samples  (MduBenchmark *benchmark);
+GArray               *mdu_benchmark_get_write_transfer_rate_samples (MduBenchmark *benchmark);
+GArray               *mdu_benchmark_get_access_time_samples         (MduBenchmark *benchmark);
+GArray               *mdu_benchmark_get_iops_results                (MduBenchmark *benchmark);
+GArray               *mdu_benchmark_get_sweep_results               (MduBenchmark *benchmark);
+
+void                  mdu_benchmark_samples_get_max_min_avg      (GArray  *samples,
+                                                                  gdouble *out_max,
+                                                                  gdouble *out_min,
+                                                                  gdouble *out_avg);
+guint                 mdu_benchmark_sweep_get_optimal_block_size (GArray *sweep_results);
+
+void                  mdu_benchmark_histogram_add_value      (MduBenchmarkHistogram       *histogram,
+                                                              guint64                      usec);
+void                  mdu_benchmark_histogram_merge          (MduBenchmarkHistogram       *histogram,
+                                                              const MduBenchmarkHistogram *other);
+gdouble               mdu_benchmark_histogram_get_percentile (const MduBenchmarkHistogram *histogram,
+                                                              gdouble                      percentile);
+
+G_END_DECLS
+
+#endif /* __MDU_BENCHMARK_H */
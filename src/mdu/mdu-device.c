@@ -196,6 +196,12 @@ typedef struct
 
   gchar *linux_loop_filename;
 
+  /* object paths above resolved to pool handles, see _mdu_pool_intern_object_path() */
+  guint partition_slave_handle;
+  guint luks_cleartext_slave_handle;
+  guint drive_port_handle;
+  guint *linux_md_slave_handles;
+
 } DeviceProperties;
 
 static void
@@ -619,33 +625,25 @@ device_properties_free (DeviceProperties *props)
 
   g_free (props->linux_loop_filename);
 
+  g_free (props->linux_md_slave_handles);
+
   g_free (props);
 }
 
 static DeviceProperties *
-device_properties_get (DBusGConnection *bus,
+device_properties_get (MduPool *pool,
                        const char *object_path)
 {
   DeviceProperties *props;
   GError *error;
   GHashTable *hash_table;
-  DBusGProxy *prop_proxy;
   const char *ifname = "org.freedesktop.UDisks.Device";
 
   props = g_new0 (DeviceProperties, 1);
 
-  prop_proxy
-    = dbus_g_proxy_new_for_name (bus, "org.freedesktop.UDisks", object_path, "org.freedesktop.DBus.Properties");
   error = NULL;
-  if (!dbus_g_proxy_call (prop_proxy,
-                          "GetAll",
-                          &error,
-                          G_TYPE_STRING,
-                          ifname,
-                          G_TYPE_INVALID,
-                          dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
-                          &hash_table,
-                          G_TYPE_INVALID))
+  hash_table = _mdu_pool_get_all_properties (pool, object_path, ifname, &error);
+  if (hash_table == NULL)
     {
       g_warning ("Couldn't call GetAll() to get properties for %s: %s", object_path, error->message);
       g_error_free (error);
@@ -659,8 +657,20 @@ device_properties_get (DBusGConnection *bus,
 
   g_hash_table_unref (hash_table);
 
+  props->partition_slave_handle = _mdu_pool_intern_object_path (pool, props->partition_slave);
+  props->luks_cleartext_slave_handle = _mdu_pool_intern_object_path (pool, props->luks_cleartext_slave);
+  if (props->drive_ports != NULL)
+    props->drive_port_handle = _mdu_pool_intern_object_path (pool, props->drive_ports[0]);
+  if (props->linux_md_slaves != NULL)
+    {
+      guint n;
+
+      props->linux_md_slave_handles = g_new0 (guint, g_strv_length (props->linux_md_slaves) + 1);
+      for (n = 0; props->linux_md_slaves[n] != NULL; n++)
+        props->linux_md_slave_handles[n] = _mdu_pool_intern_object_path (pool, props->linux_md_slaves[n]);
+    }
+
  out:
-  g_object_unref (prop_proxy);
   return props;
 }
 
@@ -672,6 +682,7 @@ struct _MduDevicePrivate
         MduPool *pool;
 
         char *object_path;
+        guint handle;
 
         DeviceProperties *props;
 };
@@ -760,7 +771,7 @@ update_info (MduDevice *device)
 {
         DeviceProperties *new_properties;
 
-        new_properties = device_properties_get (_mdu_pool_get_connection (device->priv->pool),
+        new_properties = device_properties_get (device->priv->pool,
                                                 device->priv->object_path);
         if (new_properties != NULL) {
                 if (device->priv->props != NULL)
@@ -773,6 +784,20 @@ update_info (MduDevice *device)
 }
 
 
+static void
+create_proxy (MduDevice *device)
+{
+        /* offline pools have no connection, see _mdu_pool_new_offline() */
+        if (_mdu_pool_get_connection (device->priv->pool) != NULL) {
+                device->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (device->priv->pool),
+                                                                 "org.freedesktop.UDisks",
+                                                                 device->priv->object_path,
+                                                                 "org.freedesktop.UDisks.Device");
+                dbus_g_proxy_set_default_timeout (device->priv->proxy, INT_MAX);
+                dbus_g_proxy_add_signal (device->priv->proxy, "Changed", G_TYPE_INVALID);
+        }
+}
+
 MduDevice *
 _mdu_device_new_from_object_path (MduPool *pool, const char *object_path)
 {
@@ -781,13 +806,9 @@ _mdu_device_new_from_object_path (MduPool *pool, const char *object_path)
         device = MDU_DEVICE (g_object_new (MDU_TYPE_DEVICE, NULL));
         device->priv->object_path = g_strdup (object_path);
         device->priv->pool = g_object_ref (pool);
+        device->priv->handle = _mdu_pool_intern_object_path (pool, object_path);
 
-	device->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (device->priv->pool),
-                                                         "org.freedesktop.UDisks",
-                                                         device->priv->object_path,
-                                                         "org.freedesktop.UDisks.Device");
-        dbus_g_proxy_set_default_timeout (device->priv->proxy, INT_MAX);
-        dbus_g_proxy_add_signal (device->priv->proxy, "Changed", G_TYPE_INVALID);
+        create_proxy (device);
 
         /* TODO: connect signals */
 
@@ -814,6 +835,17 @@ _mdu_device_changed (MduDevice *device)
         }
 }
 
+/* Called by the pool when it has reconnected to the daemon, see pool_handle_connection_lost() */
+void
+_mdu_device_rebind_proxy (MduDevice *device)
+{
+        if (device->priv->proxy != NULL) {
+                g_object_unref (device->priv->proxy);
+                device->priv->proxy = NULL;
+        }
+        create_proxy (device);
+}
+
 void
 _mdu_device_job_changed (MduDevice   *device,
                          gboolean     job_in_progress,
@@ -840,6 +872,12 @@ mdu_device_get_object_path (MduDevice *device)
         return device->priv->object_path;
 }
 
+guint
+_mdu_device_get_handle (MduDevice *device)
+{
+        return device->priv->handle;
+}
+
 /* ---------------------------------------------------------------------------------------------------- */
 
 /* TODO:
@@ -1151,6 +1189,12 @@ mdu_device_partition_get_slave (MduDevice *device)
         return device->priv->props->partition_slave;
 }
 
+guint
+_mdu_device_partition_get_slave_handle (MduDevice *device)
+{
+        return device->priv->props->partition_slave_handle;
+}
+
 const char *
 mdu_device_partition_get_scheme (MduDevice *device)
 {
@@ -1230,6 +1274,12 @@ mdu_device_luks_cleartext_get_slave (MduDevice *device)
         return device->priv->props->luks_cleartext_slave;
 }
 
+guint
+_mdu_device_luks_cleartext_get_slave_handle (MduDevice *device)
+{
+        return device->priv->props->luks_cleartext_slave_handle;
+}
+
 uid_t
 mdu_device_luks_cleartext_unlocked_by_uid (MduDevice *device)
 {
@@ -1327,6 +1377,13 @@ mdu_device_drive_get_ports (MduDevice *device)
         return device->priv->props->drive_ports;
 }
 
+/* handle of the first port, see mdu_device_drive_get_ports() */
+guint
+_mdu_device_drive_get_port_handle (MduDevice *device)
+{
+        return device->priv->props->drive_port_handle;
+}
+
 char **
 mdu_device_drive_get_similar_devices (MduDevice *device)
 {
@@ -1508,6 +1565,13 @@ mdu_device_linux_md_get_slaves (MduDevice *device)
         return device->priv->props->linux_md_slaves;
 }
 
+/* 0-terminated, may be NULL */
+const guint *
+_mdu_device_linux_md_get_slave_handles (MduDevice *device)
+{
+        return device->priv->props->linux_md_slave_handles;
+}
+
 gboolean
 mdu_device_linux_md_is_degraded (MduDevice *device)
 {
@@ -1719,12 +1783,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceFilesystemCreateCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } FilesystemCreateData;
 
 static void
 op_mkfs_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         FilesystemCreateData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         data->callback (data->device, error, data->user_data);
         g_object_unref (data->device);
@@ -1762,6 +1828,7 @@ mdu_device_op_filesystem_create (MduDevice                              *device,
         }
         options[n] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_filesystem_create_async (device->priv->proxy,
                                                                fstype,
                                                                (const char **) options,
@@ -1777,12 +1844,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceFilesystemMountCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } FilesystemMountData;
 
 static void
 op_mount_cb (DBusGProxy *proxy, char *mount_path, GError *error, gpointer user_data)
 {
         FilesystemMountData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, mount_path, error, data->user_data);
@@ -1811,6 +1880,7 @@ mdu_device_op_filesystem_mount (MduDevice                   *device,
         if (options == NULL)
                 options = null_options;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_filesystem_mount_async (device->priv->proxy,
                                                               fstype,
                                                               (const char **) options,
@@ -1824,12 +1894,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceFilesystemUnmountCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } FilesystemUnmountData;
 
 static void
 op_unmount_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         FilesystemUnmountData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -1851,6 +1923,7 @@ mdu_device_op_filesystem_unmount (MduDevice                     *device,
         data->user_data = user_data;
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_filesystem_unmount_async (device->priv->proxy,
                                                                 (const char **) options,
                                                                 op_unmount_cb,
@@ -1863,12 +1936,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceFilesystemCheckCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } FilesystemCheckData;
 
 static void
 op_check_cb (DBusGProxy *proxy, gboolean is_clean, GError *error, gpointer user_data)
 {
         FilesystemCheckData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, is_clean, error, data->user_data);
@@ -1890,6 +1965,7 @@ mdu_device_op_filesystem_check (MduDevice                             *device,
         data->user_data = user_data;
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_filesystem_check_async (device->priv->proxy,
                                                               (const char **) options,
                                                               op_check_cb,
@@ -1902,12 +1978,14 @@ typedef struct {
         MduDevice *device;
         MduDevicePartitionDeleteCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } PartitionDeleteData;
 
 static void
 op_partition_delete_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         PartitionDeleteData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -1932,6 +2010,7 @@ mdu_device_op_partition_delete (MduDevice                             *device,
         n = 0;
         options[n] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_partition_delete_async (device->priv->proxy,
                                                               (const char **) options,
                                                               op_partition_delete_cb,
@@ -1947,12 +2026,14 @@ typedef struct {
         MduDevice *device;
         MduDevicePartitionCreateCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } PartitionCreateData;
 
 static void
 op_create_partition_cb (DBusGProxy *proxy, char *created_device_object_path, GError *error, gpointer user_data)
 {
         PartitionCreateData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, created_device_object_path, error, data->user_data);
@@ -1999,6 +2080,7 @@ mdu_device_op_partition_create (MduDevice   *device,
         }
         fsoptions[n] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_partition_create_async (device->priv->proxy,
                                                               offset,
                                                               size,
@@ -2021,12 +2103,14 @@ typedef struct {
         MduDevice *device;
         MduDevicePartitionModifyCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } PartitionModifyData;
 
 static void
 op_partition_modify_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         PartitionModifyData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2049,6 +2133,7 @@ mdu_device_op_partition_modify (MduDevice                             *device,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_partition_modify_async (device->priv->proxy,
                                                               type,
                                                               label,
@@ -2063,12 +2148,14 @@ typedef struct {
         MduDevice *device;
         MduDevicePartitionTableCreateCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } CreatePartitionTableData;
 
 static void
 op_create_partition_table_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         CreatePartitionTableData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2094,6 +2181,7 @@ mdu_device_op_partition_table_create (MduDevice
         n = 0;
         options[n] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_partition_table_create_async (device->priv->proxy,
                                                                     scheme,
                                                                     (const char **) options,
@@ -2110,12 +2198,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLuksUnlockCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } UnlockData;
 
 static void
 op_unlock_luks_cb (DBusGProxy *proxy, char *cleartext_object_path, GError *error, gpointer user_data)
 {
         UnlockData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, cleartext_object_path, error, data->user_data);
@@ -2138,6 +2228,7 @@ mdu_device_op_luks_unlock (MduDevice *device,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_luks_unlock_async (device->priv->proxy,
                                                          secret,
                                                          (const char **) options,
@@ -2152,12 +2243,14 @@ typedef struct {
 
         MduDeviceLuksChangePassphraseCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } ChangeSecretData;
 
 static void
 op_change_secret_for_luks_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         ChangeSecretData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2179,6 +2272,7 @@ mdu_device_op_luks_change_passphrase (MduDevice   *device,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_luks_change_passphrase_async (device->priv->proxy,
                                                                     old_secret,
                                                                     new_secret,
@@ -2192,12 +2286,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLuksLockCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LockLuksData;
 
 static void
 op_lock_luks_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LockLuksData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2219,6 +2315,7 @@ mdu_device_op_luks_lock (MduDevice                           *device,
         data->user_data = user_data;
 
         options[0] = NULL;
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_luks_lock_async (device->priv->proxy,
                                                        (const char **) options,
                                                        op_lock_luks_cb,
@@ -2231,12 +2328,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceFilesystemSetLabelCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } FilesystemSetLabelData;
 
 static void
 op_change_filesystem_label_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         FilesystemSetLabelData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2257,6 +2356,7 @@ mdu_device_op_filesystem_set_label (MduDevice                                *de
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_filesystem_set_label_async (device->priv->proxy,
                                                                   new_label,
                                                                   op_change_filesystem_label_cb,
@@ -2269,6 +2369,7 @@ typedef struct {
         MduDevice *device;
         MduDeviceFilesystemListOpenFilesCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } FilesystemListOpenFilesData;
 
 static GList *
@@ -2291,6 +2392,7 @@ op_filesystem_list_open_files_cb (DBusGProxy *proxy, GPtrArray *processes, GErro
         FilesystemListOpenFilesData *data = user_data;
         GList *ret;
 
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
 
         ret = NULL;
@@ -2316,6 +2418,7 @@ mdu_device_filesystem_list_open_files (MduDevice
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_filesystem_list_open_files_async (device->priv->proxy,
                                                                         op_filesystem_list_open_files_cb,
                                                                         data);
@@ -2345,12 +2448,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceDriveAtaSmartRefreshDataCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } RetrieveAtaSmartDataData;
 
 static void
 op_retrieve_ata_smart_data_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         RetrieveAtaSmartDataData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2373,6 +2478,7 @@ mdu_device_drive_ata_smart_refresh_data (MduDevice
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_drive_ata_smart_refresh_data_async (device->priv->proxy,
                                                                           (const char **) options,
                                                                           op_retrieve_ata_smart_data_cb,
@@ -2385,12 +2491,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceDriveAtaSmartInitiateSelftestCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } DriveAtaSmartInitiateSelftestData;
 
 static void
 op_run_ata_smart_selftest_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         DriveAtaSmartInitiateSelftestData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2412,6 +2520,7 @@ mdu_device_op_drive_ata_smart_initiate_selftest (MduDevice
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_drive_ata_smart_initiate_selftest_async (device->priv->proxy,
                                                                                test,
                                                                                (const gchar **) options,
@@ -2425,12 +2534,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLinuxMdStopCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxMdStopData;
 
 static void
 op_stop_linux_md_array_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxMdStopData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2453,6 +2564,7 @@ mdu_device_op_linux_md_stop (MduDevice                         *device,
 
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_linux_md_stop_async (device->priv->proxy,
                                                            (const char **) options,
                                                            op_stop_linux_md_array_cb,
@@ -2465,12 +2577,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLinuxMdCheckCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxMdCheckData;
 
 static void
 op_check_linux_md_array_cb (DBusGProxy *proxy, guint64 num_errors, GError *error, gpointer user_data)
 {
         LinuxMdCheckData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, num_errors, error, data->user_data);
@@ -2496,6 +2610,7 @@ mdu_device_op_linux_md_check (MduDevice                           *device,
         if (options == NULL)
                 options = null_options;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_linux_md_check_async (device->priv->proxy,
                                                             (const char **) options,
                                                             op_check_linux_md_array_cb,
@@ -2508,12 +2623,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLinuxMdAddSpareCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxMdAddSpareData;
 
 static void
 op_add_spare_to_linux_md_array_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxMdAddSpareData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2537,6 +2654,7 @@ mdu_device_op_linux_md_add_spare (MduDevice                                 *dev
 
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_linux_md_add_spare_async (device->priv->proxy,
                                                                 component_objpath,
                                                                 (const char **) options,
@@ -2550,12 +2668,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLinuxMdExpandCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxMdExpandData;
 
 static void
 op_expand_to_linux_md_array_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxMdExpandData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2579,6 +2699,7 @@ mdu_device_op_linux_md_expand (MduDevice                            *device,
 
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_linux_md_expand_async (device->priv->proxy,
                                                              component_objpaths,
                                                              (const char **) options,
@@ -2592,12 +2713,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLinuxMdRemoveComponentCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxMdRemoveComponentData;
 
 static void
 op_remove_component_from_linux_md_array_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxMdRemoveComponentData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2623,6 +2746,7 @@ mdu_device_op_linux_md_remove_component (MduDevice
         n = 0;
         options[n] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_linux_md_remove_component_async (device->priv->proxy,
                                                                        component_objpath,
                                                                        (const char **) options,
@@ -2639,12 +2763,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceCancelJobCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } CancelJobData;
 
 static void
 op_cancel_job_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         CancelJobData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2662,6 +2788,7 @@ mdu_device_op_cancel_job (MduDevice *device, MduDeviceCancelJobCompletedFunc cal
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_job_cancel_async (device->priv->proxy,
                                                         op_cancel_job_cb,
                                                         data);
@@ -2673,12 +2800,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceDriveEjectCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } DriveEjectData;
 
 static void
 op_eject_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         DriveEjectData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2700,6 +2829,7 @@ mdu_device_op_drive_eject (MduDevice                        *device,
         data->user_data = user_data;
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_drive_eject_async (device->priv->proxy,
                                                          (const char **) options,
                                                          op_eject_cb,
@@ -2712,12 +2842,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceDriveDetachCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } DriveDetachData;
 
 static void
 op_detach_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         DriveDetachData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2739,6 +2871,7 @@ mdu_device_op_drive_detach (MduDevice                        *device,
         data->user_data = user_data;
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_drive_detach_async (device->priv->proxy,
                                                           (const char **) options,
                                                           op_detach_cb,
@@ -2751,12 +2884,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceDrivePollMediaCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } DrivePollMediaData;
 
 static void
 op_poll_media_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         DrivePollMediaData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2776,6 +2911,7 @@ mdu_device_op_drive_poll_media (MduDevice                        *device,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_drive_poll_media_async (device->priv->proxy,
                                                               op_poll_media_cb,
                                                               data);
@@ -2787,6 +2923,7 @@ typedef struct {
         MduDevice *device;
         MduDeviceDriveBenchmarkCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } DriveBenchmarkData;
 
 static void
@@ -2798,6 +2935,7 @@ op_drive_benchmark_cb (DBusGProxy *proxy,
                        gpointer user_data)
 {
         DriveBenchmarkData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
 
         if (data->callback != NULL) {
@@ -2825,6 +2963,7 @@ void mdu_device_op_drive_benchmark (MduDevice                             *devic
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_drive_benchmark_async (device->priv->proxy,
                                                              do_write_benchmark,
                                                              (const gchar **) options,
@@ -2839,12 +2978,14 @@ typedef struct {
         MduDevice *device;
         MduDeviceLinuxLvm2LVStopCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2LVStopData;
 
 static void
 op_stop_linux_lvm2_lv_array_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2LVStopData *data = user_data;
+        _mdu_pool_stats_end_call (data->device->priv->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->device, error, data->user_data);
@@ -2867,6 +3008,7 @@ mdu_device_op_linux_lvm2_lv_stop (MduDevice                             *device,
 
         options[0] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (device->priv->pool);
         org_freedesktop_UDisks_Device_linux_lvm2_lv_stop_async (device->priv->proxy,
                                                                 (const char **) options,
                                                                 op_stop_linux_lvm2_lv_array_cb,
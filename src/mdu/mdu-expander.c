@@ -52,6 +52,8 @@ typedef struct
         guint num_ports;
         gchar **upstream_ports;
         gchar *adapter;
+
+        guint upstream_port_handle;
 } ExpanderProperties;
 
 static void
@@ -104,31 +106,19 @@ expander_properties_free (ExpanderProperties *props)
 }
 
 static ExpanderProperties *
-expander_properties_get (DBusGConnection *bus,
+expander_properties_get (MduPool *pool,
                            const char *object_path)
 {
         ExpanderProperties *props;
         GError *error;
         GHashTable *hash_table;
-        DBusGProxy *prop_proxy;
         const char *ifname = "org.freedesktop.UDisks.Expander";
 
         props = g_new0 (ExpanderProperties, 1);
 
-	prop_proxy = dbus_g_proxy_new_for_name (bus,
-                                                "org.freedesktop.UDisks",
-                                                object_path,
-                                                "org.freedesktop.DBus.Properties");
         error = NULL;
-        if (!dbus_g_proxy_call (prop_proxy,
-                                "GetAll",
-                                &error,
-                                G_TYPE_STRING,
-                                ifname,
-                                G_TYPE_INVALID,
-                                dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
-                                &hash_table,
-                                G_TYPE_INVALID)) {
+        hash_table = _mdu_pool_get_all_properties (pool, object_path, ifname, &error);
+        if (hash_table == NULL) {
                 g_warning ("Couldn't call GetAll() to get properties for %s: %s", object_path, error->message);
                 g_error_free (error);
 
@@ -141,6 +131,9 @@ expander_properties_get (DBusGConnection *bus,
 
         g_hash_table_unref (hash_table);
 
+        if (props->upstream_ports != NULL)
+                props->upstream_port_handle = _mdu_pool_intern_object_path (pool, props->upstream_ports[0]);
+
 #if 0
         g_print ("----------------------------------------------------------------------\n");
         g_print ("native_path: %s\n", props->native_path);
@@ -159,7 +152,6 @@ expander_properties_get (DBusGConnection *bus,
 #endif
 
 out:
-        g_object_unref (prop_proxy);
         return props;
 }
 
@@ -171,6 +163,7 @@ struct _MduExpanderPrivate
         MduPool *pool;
 
         char *object_path;
+        guint handle;
 
         ExpanderProperties *props;
 };
@@ -250,7 +243,7 @@ update_info (MduExpander *expander)
 {
         ExpanderProperties *new_properties;
 
-        new_properties = expander_properties_get (_mdu_pool_get_connection (expander->priv->pool),
+        new_properties = expander_properties_get (expander->priv->pool,
                                                   expander->priv->object_path);
         if (new_properties != NULL) {
                 if (expander->priv->props != NULL)
@@ -263,6 +256,20 @@ update_info (MduExpander *expander)
 }
 
 
+static void
+create_proxy (MduExpander *expander)
+{
+        /* offline pools have no connection, see _mdu_pool_new_offline() */
+        if (_mdu_pool_get_connection (expander->priv->pool) != NULL) {
+                expander->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (expander->priv->pool),
+                                                                   "org.freedesktop.UDisks",
+                                                                   expander->priv->object_path,
+                                                                   "org.freedesktop.UDisks.Expander");
+                dbus_g_proxy_set_default_timeout (expander->priv->proxy, INT_MAX);
+                dbus_g_proxy_add_signal (expander->priv->proxy, "Changed", G_TYPE_INVALID);
+        }
+}
+
 MduExpander *
 _mdu_expander_new_from_object_path (MduPool *pool, const char *object_path)
 {
@@ -271,13 +278,9 @@ _mdu_expander_new_from_object_path (MduPool *pool, const char *object_path)
         expander = MDU_EXPANDER (g_object_new (MDU_TYPE_EXPANDER, NULL));
         expander->priv->object_path = g_strdup (object_path);
         expander->priv->pool = g_object_ref (pool);
+        expander->priv->handle = _mdu_pool_intern_object_path (pool, object_path);
 
-	expander->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (expander->priv->pool),
-                                                           "org.freedesktop.UDisks",
-                                                           expander->priv->object_path,
-                                                           "org.freedesktop.UDisks.Expander");
-        dbus_g_proxy_set_default_timeout (expander->priv->proxy, INT_MAX);
-        dbus_g_proxy_add_signal (expander->priv->proxy, "Changed", G_TYPE_INVALID);
+        create_proxy (expander);
 
         /* TODO: connect signals */
 
@@ -304,12 +307,29 @@ _mdu_expander_changed (MduExpander *expander)
         }
 }
 
+/* Called by the pool when it has reconnected to the daemon, see pool_handle_connection_lost() */
+void
+_mdu_expander_rebind_proxy (MduExpander *expander)
+{
+        if (expander->priv->proxy != NULL) {
+                g_object_unref (expander->priv->proxy);
+                expander->priv->proxy = NULL;
+        }
+        create_proxy (expander);
+}
+
 const gchar *
 mdu_expander_get_object_path (MduExpander *expander)
 {
         return expander->priv->object_path;
 }
 
+guint
+_mdu_expander_get_handle (MduExpander *expander)
+{
+        return expander->priv->handle;
+}
+
 
 const gchar *
 mdu_expander_get_native_path (MduExpander *expander)
@@ -347,6 +367,13 @@ mdu_expander_get_upstream_ports (MduExpander *expander)
         return expander->priv->props->upstream_ports;
 }
 
+/* handle of the first upstream port, see mdu_expander_get_upstream_ports() */
+guint
+_mdu_expander_get_upstream_port_handle (MduExpander *expander)
+{
+        return expander->priv->props->upstream_port_handle;
+}
+
 const gchar *
 mdu_expander_get_adapter (MduExpander *expander)
 {
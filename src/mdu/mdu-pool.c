@@ -23,6 +23,7 @@
 #include <glib/gi18n-lib.h>
 
 #include <dbus/dbus-glib.h>
+#include <dbus/dbus-glib-lowlevel.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -44,6 +45,7 @@
 #include "mdu-linux-lvm2-volume-hole.h"
 
 #include "mdu-ssh-bridge.h"
+#include "mdu-trace.h"
 #include "mdu-error.h"
 
 #include "udisks-daemon-glue.h"
@@ -76,6 +78,8 @@ enum {
         PRESENTABLE_REMOVED,
         PRESENTABLE_CHANGED,
         PRESENTABLE_JOB_CHANGED,
+        RECONNECTING,
+        RECONNECTED,
         LAST_SIGNAL,
 };
 
@@ -92,8 +96,7 @@ struct _MduPoolPrivate
 
         gchar *ssh_user_name;
         gchar *ssh_address;
-        GPid ssh_pid;
-        guint ssh_child_watch_id;
+        MduPoolConnectFlags connect_flags;
 
         DBusGConnection *bus;
         DBusGProxy *proxy;
@@ -105,45 +108,141 @@ struct _MduPoolPrivate
         /* the current set of presentables we know about */
         GList *presentables;
 
-        /* the current set of devices we know about */
-        GHashTable *object_path_to_device;
+        /* object paths interned as handles - see _mdu_pool_intern_object_path() */
+        GHashTable *object_path_to_handle;
+        GPtrArray *handle_to_object_path;
 
-        /* the current set of adapters we know about */
-        GHashTable *object_path_to_adapter;
+        /* the current set of devices we know about, keyed by handle */
+        GHashTable *handle_to_device;
 
-        /* the current set of expanders we know about */
-        GHashTable *object_path_to_expander;
+        /* the current set of adapters we know about, keyed by handle */
+        GHashTable *handle_to_adapter;
 
-        /* the current set of ports we know about */
-        GHashTable *object_path_to_port;
+        /* the current set of expanders we know about, keyed by handle */
+        GHashTable *handle_to_expander;
+
+        /* the current set of ports we know about, keyed by handle */
+        GHashTable *handle_to_port;
+
+        /* for pools not backed by a D-Bus connection - see _mdu_pool_new_offline() */
+        gboolean is_offline;
+        GHashTable *offline_objects;
+
+        /* non-NULL if recording a trace - see mdu-trace.c */
+        MduTrace *trace;
+
+        /* TRUE if only tracking the objects around one device - see mdu_pool_new_for_device_file() */
+        gboolean is_scoped;
+
+        /* automatic reconnect of remote pools - see pool_handle_connection_lost() */
+        guint connection_lost_idle_id;
+        gboolean is_reconnecting;
+        guint reconnect_attempt;
+        guint reconnect_timeout_id;
+
+        /* checksums of the last GetAll() reply for each object of a remote pool, keyed by handle */
+        GHashTable *handle_to_properties_checksum;
+
+        /* GetAll() replies fetched ahead of time, keyed by object path - consumed by
+         * _mdu_pool_get_all_properties()
+         */
+        GHashTable *prefetched_properties;
+
+        /* TRUE while recompute_presentables() is deferred - see pool_resync() */
+        gboolean presentables_frozen;
+
+        /* object signals of remote pools waiting to be handled in one batch - see queue_signal() */
+        GQueue *queued_signals;
+        GHashTable *queued_changes;
+        guint flush_signals_timeout_id;
+        /* TRUE for remote pools, see _mdu_pool_set_batch_signals() */
+        gboolean batch_signals;
+        /* number of times queued signals were handled */
+        guint num_signal_batches;
+        /* signal name -> ObjectSignalClosure, see _mdu_pool_emit_object_signal() */
+        GHashTable *object_signal_closures;
+        /* TRUE while pool_prime_async() runs; object signals are queued until it's done */
+        gboolean is_priming;
+
+        /* traffic statistics - see mdu_pool_get_stats() */
+        MduPoolStats stats;
+        GTimer *stats_timer;
+        gboolean connection_filter_added;
+        /* TRUE if the bytes of the current connection are counted by the ssh bridge */
+        gboolean stats_bridge_counts_bytes;
 };
 
+typedef struct {
+        gchar *interface_name;
+        GHashTable *properties;
+} OfflineObject;
+
+static void
+offline_object_free (OfflineObject *object)
+{
+        g_free (object->interface_name);
+        g_hash_table_unref (object->properties);
+        g_free (object);
+}
+
+typedef void (*ObjectSignalHandler) (DBusGProxy  *proxy,
+                                     const char  *object_path,
+                                     gpointer     user_data);
+
+typedef struct {
+        ObjectSignalHandler handler;
+        gchar *object_path;
+        /* NULL if the handler does not need the properties of the object */
+        const gchar *interface_name;
+} QueuedSignal;
+
+static void
+queued_signal_free (QueuedSignal *queued)
+{
+        g_free (queued->object_path);
+        g_free (queued);
+}
+
 G_DEFINE_TYPE (MduPool, mdu_pool, G_TYPE_OBJECT);
 
 static void remove_all_objects_and_dbus_proxies (MduPool *pool);
+static void pool_unref_bus (MduPool *pool);
 
 static void
 mdu_pool_finalize (MduPool *pool)
 {
-        g_print ("in mdu_pool_finalize()\n");
-
         remove_all_objects_and_dbus_proxies (pool);
 
-        g_hash_table_unref (pool->priv->object_path_to_device);
-        g_hash_table_unref (pool->priv->object_path_to_adapter);
-        g_hash_table_unref (pool->priv->object_path_to_expander);
-        g_hash_table_unref (pool->priv->object_path_to_port);
-
-        if (pool->priv->ssh_child_watch_id > 0) {
-                g_source_remove (pool->priv->ssh_child_watch_id);
-                pool->priv->ssh_child_watch_id = 0;
-        }
-        if (pool->priv->ssh_pid > 0) {
-                kill (pool->priv->ssh_pid, SIGTERM);
-                pool->priv->ssh_pid = 0;
-        }
-
-        g_object_unref (pool->priv->machine);
+        g_hash_table_unref (pool->priv->handle_to_device);
+        g_hash_table_unref (pool->priv->handle_to_adapter);
+        g_hash_table_unref (pool->priv->handle_to_expander);
+        g_hash_table_unref (pool->priv->handle_to_port);
+        g_hash_table_unref (pool->priv->object_path_to_handle);
+        g_ptr_array_foreach (pool->priv->handle_to_object_path, (GFunc) g_free, NULL);
+        g_ptr_array_free (pool->priv->handle_to_object_path, TRUE);
+        g_hash_table_unref (pool->priv->offline_objects);
+        g_hash_table_unref (pool->priv->handle_to_properties_checksum);
+        g_hash_table_unref (pool->priv->prefetched_properties);
+
+        if (pool->priv->flush_signals_timeout_id > 0)
+                g_source_remove (pool->priv->flush_signals_timeout_id);
+        g_queue_foreach (pool->priv->queued_signals, (GFunc) queued_signal_free, NULL);
+        g_queue_free (pool->priv->queued_signals);
+        g_hash_table_unref (pool->priv->queued_changes);
+        g_hash_table_unref (pool->priv->object_signal_closures);
+
+        g_timer_destroy (pool->priv->stats_timer);
+
+        if (pool->priv->reconnect_timeout_id > 0)
+                g_source_remove (pool->priv->reconnect_timeout_id);
+        if (pool->priv->connection_lost_idle_id > 0)
+                g_source_remove (pool->priv->connection_lost_idle_id);
+
+        if (pool->priv->trace != NULL)
+                _mdu_trace_free (pool->priv->trace);
+
+        if (pool->priv->machine != NULL)
+                g_object_unref (pool->priv->machine);
 
         if (G_OBJECT_CLASS (parent_class)->finalize)
                 (* G_OBJECT_CLASS (parent_class)->finalize) (G_OBJECT (pool));
@@ -473,6 +572,45 @@ mdu_pool_class_init (MduPoolClass *klass)
                               g_cclosure_marshal_VOID__OBJECT,
                               G_TYPE_NONE, 1,
                               MDU_TYPE_PRESENTABLE);
+
+        /**
+         * MduPool::reconnecting
+         * @pool: The #MduPool emitting the signal.
+         *
+         * Emitted when the connection to a remote host has been lost and
+         * @pool starts trying to reconnect. All objects are kept (but
+         * operations on them will fail) until either #MduPool::reconnected
+         * or #MduPool::disconnected is emitted.
+         */
+        signals[RECONNECTING] =
+                g_signal_new ("reconnecting",
+                              G_TYPE_FROM_CLASS (klass),
+                              G_SIGNAL_RUN_LAST,
+                              G_STRUCT_OFFSET (MduPoolClass, reconnecting),
+                              NULL,
+                              NULL,
+                              g_cclosure_marshal_VOID__VOID,
+                              G_TYPE_NONE,
+                              0);
+
+        /**
+         * MduPool::reconnected
+         * @pool: The #MduPool emitting the signal.
+         *
+         * Emitted when @pool has reconnected to the remote host and brought
+         * its objects up to date. Objects that did not change while the
+         * connection was down are the same instances as before.
+         */
+        signals[RECONNECTED] =
+                g_signal_new ("reconnected",
+                              G_TYPE_FROM_CLASS (klass),
+                              G_SIGNAL_RUN_LAST,
+                              G_STRUCT_OFFSET (MduPoolClass, reconnected),
+                              NULL,
+                              NULL,
+                              g_cclosure_marshal_VOID__VOID,
+                              G_TYPE_NONE,
+                              0);
 }
 
 static void
@@ -512,25 +650,162 @@ mdu_pool_init (MduPool *pool)
 
         pool->priv = G_TYPE_INSTANCE_GET_PRIVATE (pool, MDU_TYPE_POOL, MduPoolPrivate);
 
-        pool->priv->object_path_to_device = g_hash_table_new_full (g_str_hash,
+        /* the strings are owned by handle_to_object_path; handle 0 is never used */
+        pool->priv->object_path_to_handle = g_hash_table_new (g_str_hash, g_str_equal);
+        pool->priv->handle_to_object_path = g_ptr_array_new ();
+        g_ptr_array_add (pool->priv->handle_to_object_path, NULL);
+
+        pool->priv->handle_to_device = g_hash_table_new_full (g_direct_hash,
+                                                              g_direct_equal,
+                                                              NULL,
+                                                              g_object_unref);
+
+        pool->priv->handle_to_properties_checksum = g_hash_table_new_full (g_direct_hash,
+                                                                           g_direct_equal,
+                                                                           NULL,
+                                                                           g_free);
+
+        pool->priv->prefetched_properties = g_hash_table_new_full (g_str_hash,
                                                                    g_str_equal,
-                                                                   NULL,
-                                                                   g_object_unref);
+                                                                   g_free,
+                                                                   (GDestroyNotify) g_hash_table_unref);
+
+        pool->priv->queued_signals = g_queue_new ();
+        pool->priv->object_signal_closures = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+        pool->priv->stats_timer = g_timer_new ();
+        pool->priv->queued_changes = g_hash_table_new_full (g_str_hash,
+                                                            g_str_equal,
+                                                            g_free,
+                                                            NULL);
+
+        pool->priv->handle_to_adapter = g_hash_table_new_full (g_direct_hash,
+                                                               g_direct_equal,
+                                                               NULL,
+                                                               g_object_unref);
+
+        pool->priv->handle_to_expander = g_hash_table_new_full (g_direct_hash,
+                                                                g_direct_equal,
+                                                                NULL,
+                                                                g_object_unref);
+
+        pool->priv->handle_to_port = g_hash_table_new_full (g_direct_hash,
+                                                            g_direct_equal,
+                                                            NULL,
+                                                            g_object_unref);
+
+        pool->priv->offline_objects = g_hash_table_new_full (g_str_hash,
+                                                             g_str_equal,
+                                                             g_free,
+                                                             (GDestroyNotify) offline_object_free);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/**
+ * _mdu_pool_intern_object_path:
+ * @pool: A #MduPool.
+ * @object_path: A D-Bus object path or %NULL.
+ *
+ * Gets the handle for @object_path, assigning a new one if @object_path
+ * hasn't been seen before. Handles are small integers that are unique
+ * within @pool and never reused so references between objects can be
+ * resolved without hashing or comparing strings.
+ *
+ * Returns: The handle for @object_path or 0 if @object_path is %NULL or
+ * "/" (used by the daemon to mean "no object").
+ */
+guint
+_mdu_pool_intern_object_path (MduPool     *pool,
+                              const gchar *object_path)
+{
+        gpointer value;
+        gchar *interned;
+        guint ret;
 
-        pool->priv->object_path_to_adapter = g_hash_table_new_full (g_str_hash,
-                                                                    g_str_equal,
-                                                                    NULL,
-                                                                    g_object_unref);
+        if (object_path == NULL || object_path[0] == '\0' || strcmp (object_path, "/") == 0) {
+                ret = 0;
+                goto out;
+        }
+
+        if (g_hash_table_lookup_extended (pool->priv->object_path_to_handle, object_path, NULL, &value)) {
+                ret = GPOINTER_TO_UINT (value);
+                goto out;
+        }
+
+        interned = g_strdup (object_path);
+        ret = pool->priv->handle_to_object_path->len;
+        g_ptr_array_add (pool->priv->handle_to_object_path, interned);
+        g_hash_table_insert (pool->priv->object_path_to_handle, interned, GUINT_TO_POINTER (ret));
+
+ out:
+        return ret;
+}
+
+const gchar *
+_mdu_pool_get_object_path_for_handle (MduPool *pool,
+                                      guint    handle)
+{
+        if (handle == 0 || handle >= pool->priv->handle_to_object_path->len)
+                return NULL;
+        return pool->priv->handle_to_object_path->pdata[handle];
+}
+
+/* like _mdu_pool_intern_object_path() but doesn't assign new handles; returns 0 if not found */
+static guint
+lookup_handle (MduPool     *pool,
+               const gchar *object_path)
+{
+        if (object_path == NULL)
+                return 0;
+        return GPOINTER_TO_UINT (g_hash_table_lookup (pool->priv->object_path_to_handle, object_path));
+}
+
+/* note: does not ref the result */
+static MduDevice *
+lookup_device (MduPool *pool,
+               guint    handle)
+{
+        return g_hash_table_lookup (pool->priv->handle_to_device, GUINT_TO_POINTER (handle));
+}
+
+/* note: does not ref the result */
+static MduPort *
+lookup_port (MduPool *pool,
+             guint    handle)
+{
+        return g_hash_table_lookup (pool->priv->handle_to_port, GUINT_TO_POINTER (handle));
+}
+
+/* for scoped pools: whether @device is stacked on, or part of, a device we already track */
+static gboolean
+scope_is_attached (MduPool   *pool,
+                   MduDevice *device)
+{
+        const guint *slaves;
+        gchar **dmmp_slaves;
+        guint n;
+
+        if (lookup_device (pool, _mdu_device_partition_get_slave_handle (device)) != NULL)
+                return TRUE;
+        if (lookup_device (pool, _mdu_device_luks_cleartext_get_slave_handle (device)) != NULL)
+                return TRUE;
+
+        slaves = _mdu_device_linux_md_get_slave_handles (device);
+        for (n = 0; slaves != NULL && slaves[n] != 0; n++) {
+                if (lookup_device (pool, slaves[n]) != NULL)
+                        return TRUE;
+        }
+
+        dmmp_slaves = mdu_device_linux_dmmp_get_slaves (device);
+        for (n = 0; dmmp_slaves != NULL && dmmp_slaves[n] != NULL; n++) {
+                if (lookup_device (pool, lookup_handle (pool, dmmp_slaves[n])) != NULL)
+                        return TRUE;
+        }
 
-        pool->priv->object_path_to_expander = g_hash_table_new_full (g_str_hash,
-                                                                     g_str_equal,
-                                                                     NULL,
-                                                                     g_object_unref);
+        if (lookup_device (pool, lookup_handle (pool, mdu_device_linux_md_component_get_holder (device))) != NULL)
+                return TRUE;
 
-        pool->priv->object_path_to_port = g_hash_table_new_full (g_str_hash,
-                                                                 g_str_equal,
-                                                                 NULL,
-                                                                 g_object_unref);
+        return FALSE;
 }
 
 /* ---------------------------------------------------------------------------------------------------- */
@@ -579,37 +854,6 @@ diff_sorted_lists (GList         *list1,
     }
 }
 
-/* note: does not ref the result */
-static MduPresentable *
-find_presentable_by_object_path (GList *presentables, const gchar *object_path)
-{
-        MduPresentable *ret;
-        GList *l;
-
-        ret = NULL;
-
-        for (l = presentables; l != NULL; l = l->next) {
-                MduPresentable *p = MDU_PRESENTABLE (l->data);
-                MduDevice *d;
-                const gchar *d_object_path;
-
-                d = mdu_presentable_get_device (p);
-                if (d == NULL)
-                        continue;
-
-                d_object_path = mdu_device_get_object_path (d);
-                g_object_unref (d);
-
-                if (g_strcmp0 (object_path, d_object_path) == 0) {
-                        ret = p;
-                        goto out;
-                }
-        }
-
- out:
-        return ret;
-}
-
 static gboolean
 is_msdos_extended_partition (MduDevice *device)
 {
@@ -702,8 +946,7 @@ get_holes (MduPool        *pool,
 
                 if (!mdu_device_is_partition (partition_device))
                         continue;
-                if (g_strcmp0 (mdu_device_get_object_path (drive_device),
-                               mdu_device_partition_get_slave (partition_device)) != 0)
+                if (_mdu_device_partition_get_slave_handle (partition_device) != _mdu_device_get_handle (drive_device))
                         continue;
 
                 partition_offset = mdu_device_partition_get_offset (partition_device);
@@ -923,12 +1166,17 @@ recompute_presentables (MduPool *pool)
         GHashTable *hash_map_from_drive_to_extended_partition;
         GHashTable *hash_map_from_linux_md_uuid_to_drive;
         GHashTable *hash_map_from_linux_lvm2_group_uuid_to_vg;
-        GHashTable *hash_map_from_adapter_objpath_to_hub;
-        GHashTable *hash_map_from_expander_objpath_to_hub;
+        GHashTable *hash_map_from_adapter_handle_to_hub;
+        GHashTable *hash_map_from_expander_handle_to_hub;
+        GHashTable *hash_map_from_device_handle_to_presentable;
         MduPresentable *hub_raid_lvm;
         MduPresentable *hub_multipath;
         MduPresentable *hub_peripheral;
 
+        /* done once at the end when resyncing, see pool_resync() */
+        if (pool->priv->presentables_frozen)
+                return;
+
         /* The general strategy for (re-)computing presentables is rather brute force; we
          * compute the complete set of presentables every time and diff it against the
          * presentables we computed the last time. Then we send out add/remove events
@@ -959,15 +1207,14 @@ recompute_presentables (MduPool *pool)
                                                                            NULL,
                                                                            NULL);
 
-        hash_map_from_adapter_objpath_to_hub = g_hash_table_new_full (g_str_hash,
-                                                                      g_str_equal,
-                                                                      NULL,
-                                                                      NULL);
+        hash_map_from_adapter_handle_to_hub = g_hash_table_new (g_direct_hash, g_direct_equal);
 
-        hash_map_from_expander_objpath_to_hub = g_hash_table_new_full (g_str_hash,
-                                                                       g_str_equal,
-                                                                       NULL,
-                                                                       NULL);
+        hash_map_from_expander_handle_to_hub = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+        /* the most recently created presentable for a device, e.g. the volume rather than the
+         * drive for a whole-disk device - used to find the enclosing presentable of a device
+         */
+        hash_map_from_device_handle_to_presentable = g_hash_table_new (g_direct_hash, g_direct_equal);
 
         hub_raid_lvm = NULL;
         hub_multipath = NULL;
@@ -988,8 +1235,8 @@ recompute_presentables (MduPool *pool)
                                     NULL,      /* icon */
                                     pool->priv->machine);  /* enclosing_presentable */
 
-                g_hash_table_insert (hash_map_from_adapter_objpath_to_hub,
-                                     (gpointer) mdu_adapter_get_object_path (adapter),
+                g_hash_table_insert (hash_map_from_adapter_handle_to_hub,
+                                     GUINT_TO_POINTER (_mdu_adapter_get_handle (adapter)),
                                      hub);
 
                 new_presentables = g_list_prepend (new_presentables, hub);
@@ -1001,30 +1248,27 @@ recompute_presentables (MduPool *pool)
                 MduExpander *expander = MDU_EXPANDER (l->data);
                 MduAdapter *adapter;
                 MduHub *hub;
-                gchar **port_object_paths;
+                MduPort *port;
                 MduPresentable *expander_parent;
 
                 /* we are guaranteed that upstream ports all stem from the same expander or
                  * host adapter - so just pick the first one */
                 expander_parent = NULL;
-                port_object_paths = mdu_expander_get_upstream_ports (expander);
-                if (port_object_paths != NULL && port_object_paths[0] != NULL) {
-                        MduPort *port;
+                adapter = NULL;
+                port = lookup_port (pool, _mdu_expander_get_upstream_port_handle (expander));
 
-                        port = mdu_pool_get_port_by_object_path (pool, port_object_paths[0]);
-
-                        /* For now, always choose the adapter as the parent - this is *probably*
-                         * the right thing (e.g. what people expect) to do _anyway_ because of
-                         * the way expanders are daisy-chained
-                         */
-                        if (port != NULL) {
-                                const gchar *adapter_object_path;
-                                adapter_object_path = mdu_port_get_adapter (port);
-                                adapter = mdu_pool_get_adapter_by_object_path (pool, adapter_object_path);
-                                expander_parent = g_hash_table_lookup (hash_map_from_adapter_objpath_to_hub,
-                                                                       adapter_object_path);
-                                g_object_unref (port);
-                        }
+                /* For now, always choose the adapter as the parent - this is *probably*
+                 * the right thing (e.g. what people expect) to do _anyway_ because of
+                 * the way expanders are daisy-chained
+                 */
+                if (port != NULL) {
+                        guint adapter_handle;
+
+                        adapter_handle = _mdu_port_get_adapter_handle (port);
+                        adapter = g_hash_table_lookup (pool->priv->handle_to_adapter,
+                                                       GUINT_TO_POINTER (adapter_handle));
+                        expander_parent = g_hash_table_lookup (hash_map_from_adapter_handle_to_hub,
+                                                               GUINT_TO_POINTER (adapter_handle));
                 }
 
                 g_warn_if_fail (expander_parent != NULL);
@@ -1038,10 +1282,9 @@ recompute_presentables (MduPool *pool)
                                     NULL,      /* vpd_name */
                                     NULL,      /* icon */
                                     expander_parent);
-                g_object_unref (adapter);
 
-                g_hash_table_insert (hash_map_from_expander_objpath_to_hub,
-                                     (gpointer) mdu_expander_get_object_path (expander),
+                g_hash_table_insert (hash_map_from_expander_handle_to_hub,
+                                     GUINT_TO_POINTER (_mdu_expander_get_handle (expander)),
                                      hub);
 
                 new_presentables = g_list_prepend (new_presentables, hub);
@@ -1104,32 +1347,26 @@ recompute_presentables (MduPool *pool)
 
                         } else {
                                 MduPresentable *drive_parent;
-                                gchar **port_object_paths;
+                                MduPort *port;
 
                                 drive_parent = NULL;
 
                                 /* we are guaranteed that upstream ports all stem from the same expander or
                                  * host adapter - so just pick the first one */
-                                port_object_paths = mdu_device_drive_get_ports (device);
-                                if (port_object_paths != NULL && port_object_paths[0] != NULL) {
-                                        MduPort *port;
-
-                                        port = mdu_pool_get_port_by_object_path (pool, port_object_paths[0]);
-                                        /* choose the expander, if available, otherwise the adapter */
-                                        if (port != NULL) {
-                                                const gchar *parent_object_path;
-                                                const gchar *adapter_object_path;
-
-                                                parent_object_path = mdu_port_get_parent (port);
-                                                adapter_object_path = mdu_port_get_adapter (port);
-                                                if (g_strcmp0 (parent_object_path, adapter_object_path) != 0) {
-                                                        drive_parent = g_hash_table_lookup (hash_map_from_expander_objpath_to_hub,
-                                                                                            parent_object_path);
-                                                } else {
-                                                        drive_parent = g_hash_table_lookup (hash_map_from_adapter_objpath_to_hub,
-                                                                                            adapter_object_path);
-                                                }
-                                                g_object_unref (port);
+                                port = lookup_port (pool, _mdu_device_drive_get_port_handle (device));
+                                /* choose the expander, if available, otherwise the adapter */
+                                if (port != NULL) {
+                                        guint parent_handle;
+                                        guint adapter_handle;
+
+                                        parent_handle = _mdu_port_get_parent_handle (port);
+                                        adapter_handle = _mdu_port_get_adapter_handle (port);
+                                        if (parent_handle != adapter_handle) {
+                                                drive_parent = g_hash_table_lookup (hash_map_from_expander_handle_to_hub,
+                                                                                    GUINT_TO_POINTER (parent_handle));
+                                        } else {
+                                                drive_parent = g_hash_table_lookup (hash_map_from_adapter_handle_to_hub,
+                                                                                    GUINT_TO_POINTER (adapter_handle));
                                         }
                                 }
 
@@ -1156,6 +1393,9 @@ recompute_presentables (MduPool *pool)
                                 drive = _mdu_drive_new_from_device (pool, device, drive_parent);
                         }
                         new_presentables = g_list_prepend (new_presentables, drive);
+                        g_hash_table_insert (hash_map_from_device_handle_to_presentable,
+                                             GUINT_TO_POINTER (_mdu_device_get_handle (device)),
+                                             drive);
 
                         if (mdu_device_is_partition_table (device)) {
                                 new_partitioned_drives = g_list_prepend (new_partitioned_drives, drive);
@@ -1167,6 +1407,9 @@ recompute_presentables (MduPool *pool)
                                         MduVolume *volume;
                                         volume = _mdu_volume_new_from_device (pool, device, MDU_PRESENTABLE (drive));
                                         new_presentables = g_list_prepend (new_presentables, volume);
+                                        g_hash_table_insert (hash_map_from_device_handle_to_presentable,
+                                                             GUINT_TO_POINTER (_mdu_device_get_handle (device)),
+                                                             volume);
                                 }
                         }
 
@@ -1175,9 +1418,10 @@ recompute_presentables (MduPool *pool)
                         MduVolume *volume;
                         MduPresentable *enclosing_presentable;
 
+                        enclosing_presentable = g_hash_table_lookup (hash_map_from_device_handle_to_presentable,
+                                                                     GUINT_TO_POINTER (_mdu_device_partition_get_slave_handle (device)));
+
                         if (is_msdos_extended_partition (device)) {
-                                enclosing_presentable = find_presentable_by_object_path (new_presentables,
-                                                                                         mdu_device_partition_get_slave (device));
 
                                 if (enclosing_presentable == NULL) {
                                         g_warning ("Partition %s claims to be a partition of %s which does not exist",
@@ -1192,8 +1436,6 @@ recompute_presentables (MduPool *pool)
                                                      enclosing_presentable,
                                                      volume);
                         } else {
-                                enclosing_presentable = find_presentable_by_object_path (new_presentables,
-                                                                                         mdu_device_partition_get_slave (device));
                                 if (enclosing_presentable == NULL) {
                                         g_warning ("Partition %s claims to be a partition of %s which does not exist",
                                                    mdu_device_get_object_path (device),
@@ -1223,6 +1465,9 @@ recompute_presentables (MduPool *pool)
                           mdu_presentable_get_id (enclosing_presentable));*/
 
                         new_presentables = g_list_prepend (new_presentables, volume);
+                        g_hash_table_insert (hash_map_from_device_handle_to_presentable,
+                                             GUINT_TO_POINTER (_mdu_device_get_handle (device)),
+                                             volume);
 
                 } else if (mdu_device_is_luks_cleartext (device)) {
 
@@ -1233,7 +1478,8 @@ recompute_presentables (MduPool *pool)
 
                         luks_cleartext_slave = mdu_device_luks_cleartext_get_slave (device);
 
-                        enclosing_luks_device = find_presentable_by_object_path (new_presentables, luks_cleartext_slave);
+                        enclosing_luks_device = g_hash_table_lookup (hash_map_from_device_handle_to_presentable,
+                                                                     GUINT_TO_POINTER (_mdu_device_luks_cleartext_get_slave_handle (device)));
                         if (enclosing_luks_device == NULL) {
                                 g_warning ("Cannot find enclosing device %s for LUKS cleartext device %s",
                                            luks_cleartext_slave,
@@ -1243,6 +1489,9 @@ recompute_presentables (MduPool *pool)
 
                         volume = _mdu_volume_new_from_device (pool, device, enclosing_luks_device);
                         new_presentables = g_list_prepend (new_presentables, volume);
+                        g_hash_table_insert (hash_map_from_device_handle_to_presentable,
+                                             GUINT_TO_POINTER (_mdu_device_get_handle (device)),
+                                             volume);
 
                 } else if (mdu_device_is_linux_lvm2_lv (device)) {
 
@@ -1298,6 +1547,7 @@ recompute_presentables (MduPool *pool)
 
                                         if (name != NULL && uuid != NULL && size > 0) {
                                                 MduLinuxLvm2Volume *volume;
+                                                MduDevice *lv_device;
 
                                                 volume = _mdu_linux_lvm2_volume_new (pool,
                                                                                      vg_uuid,
@@ -1306,6 +1556,15 @@ recompute_presentables (MduPool *pool)
 
                                                 new_presentables = g_list_prepend (new_presentables, volume);
 
+                                                /* partitions and LUKS cleartext devices may be stacked on a running LV */
+                                                lv_device = mdu_presentable_get_device (MDU_PRESENTABLE (volume));
+                                                if (lv_device != NULL) {
+                                                        g_hash_table_insert (hash_map_from_device_handle_to_presentable,
+                                                                             GUINT_TO_POINTER (_mdu_device_get_handle (lv_device)),
+                                                                             volume);
+                                                        g_object_unref (lv_device);
+                                                }
+
                                         } else {
                                                 g_warning ("Malformed LMV2 LV in group with UUID %s: "
                                                            "pos=%d name=%s uuid=%s size=%" G_GUINT64_FORMAT,
@@ -1377,8 +1636,9 @@ recompute_presentables (MduPool *pool)
         g_hash_table_unref (hash_map_from_drive_to_extended_partition);
         g_hash_table_unref (hash_map_from_linux_md_uuid_to_drive);
         g_hash_table_unref (hash_map_from_linux_lvm2_group_uuid_to_vg);
-        g_hash_table_unref (hash_map_from_adapter_objpath_to_hub);
-        g_hash_table_unref (hash_map_from_expander_objpath_to_hub);
+        g_hash_table_unref (hash_map_from_adapter_handle_to_hub);
+        g_hash_table_unref (hash_map_from_expander_handle_to_hub);
+        g_hash_table_unref (hash_map_from_device_handle_to_presentable);
 
         /* figure out the diff */
         new_presentables = g_list_sort (new_presentables, (GCompareFunc) mdu_presentable_compare);
@@ -1463,11 +1723,15 @@ device_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpointe
 
         pool = MDU_POOL (user_data);
 
+        /* proxy is NULL when called from another handler or when replaying */
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "DeviceAdded", object_path);
+
         device = mdu_pool_get_by_object_path (pool, object_path);
         if (device != NULL) {
                 g_object_unref (device);
                 g_warning ("Treating add for previously added device %s as change", object_path);
-                device_changed_signal_handler (proxy, object_path, user_data);
+                device_changed_signal_handler (NULL, object_path, user_data);
                 goto out;
         }
 
@@ -1475,8 +1739,13 @@ device_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpointe
         if (device == NULL)
                 goto out;
 
-        g_hash_table_insert (pool->priv->object_path_to_device,
-                             (gpointer) mdu_device_get_object_path (device),
+        if (pool->priv->is_scoped && !scope_is_attached (pool, device)) {
+                g_object_unref (device);
+                goto out;
+        }
+
+        g_hash_table_insert (pool->priv->handle_to_device,
+                             GUINT_TO_POINTER (_mdu_device_get_handle (device)),
                              device);
         g_signal_emit (pool, signals[DEVICE_ADDED], 0, device);
         //g_debug ("Added device %s", object_path);
@@ -1495,6 +1764,9 @@ device_removed_signal_handler (DBusGProxy *proxy, const char *object_path, gpoin
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "DeviceRemoved", object_path);
+
         device = mdu_pool_get_by_object_path (pool, object_path);
         if (device == NULL) {
                 /* This is not fatal - the device may have been removed when GetAll() failed
@@ -1504,8 +1776,8 @@ device_removed_signal_handler (DBusGProxy *proxy, const char *object_path, gpoin
                 goto out;
         }
 
-        g_hash_table_remove (pool->priv->object_path_to_device,
-                             mdu_device_get_object_path (device));
+        g_hash_table_remove (pool->priv->handle_to_device,
+                             GUINT_TO_POINTER (_mdu_device_get_handle (device)));
         g_signal_emit (pool, signals[DEVICE_REMOVED], 0, device);
         g_signal_emit_by_name (device, "removed");
         g_object_unref (device);
@@ -1525,9 +1797,13 @@ device_changed_signal_handler (DBusGProxy *proxy, const char *object_path, gpoin
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "DeviceChanged", object_path);
+
         device = mdu_pool_get_by_object_path (pool, object_path);
         if (device == NULL) {
-                g_warning ("Ignoring change event on non-existant device %s", object_path);
+                if (!pool->priv->is_scoped)
+                        g_warning ("Ignoring change event on non-existant device %s", object_path);
                 goto out;
         }
 
@@ -1556,6 +1832,15 @@ device_job_changed_signal_handler (DBusGProxy *proxy,
         MduPool *pool = MDU_POOL (user_data);
         MduDevice *device;
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_job_changed (pool->priv->trace,
+                                               object_path,
+                                               job_in_progress,
+                                               job_id,
+                                               job_initiated_by_uid,
+                                               job_is_cancellable,
+                                               job_percentage);
+
         if ((device = mdu_pool_get_by_object_path (pool, object_path)) != NULL) {
                 _mdu_device_job_changed (device,
                                          job_in_progress,
@@ -1565,7 +1850,7 @@ device_job_changed_signal_handler (DBusGProxy *proxy,
                                          job_percentage);
                 g_signal_emit_by_name (pool, "device-job-changed", device);
                 g_object_unref (device);
-        } else {
+        } else if (!pool->priv->is_scoped) {
                 g_warning ("Unknown device %s on job-change", object_path);
         }
 }
@@ -1583,11 +1868,18 @@ adapter_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpoint
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "AdapterAdded", object_path);
+
+        /* scoped pools only track the hardware found when the pool was created */
+        if (pool->priv->is_scoped)
+                goto out;
+
         adapter = mdu_pool_get_adapter_by_object_path (pool, object_path);
         if (adapter != NULL) {
                 g_object_unref (adapter);
                 g_warning ("Treating add for previously added adapter %s as change", object_path);
-                adapter_changed_signal_handler (proxy, object_path, user_data);
+                adapter_changed_signal_handler (NULL, object_path, user_data);
                 goto out;
         }
 
@@ -1595,8 +1887,8 @@ adapter_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpoint
         if (adapter == NULL)
                 goto out;
 
-        g_hash_table_insert (pool->priv->object_path_to_adapter,
-                             (gpointer) mdu_adapter_get_object_path (adapter),
+        g_hash_table_insert (pool->priv->handle_to_adapter,
+                             GUINT_TO_POINTER (_mdu_adapter_get_handle (adapter)),
                              adapter);
         g_signal_emit (pool, signals[ADAPTER_ADDED], 0, adapter);
         //g_debug ("Added adapter %s", object_path);
@@ -1615,14 +1907,18 @@ adapter_removed_signal_handler (DBusGProxy *proxy, const char *object_path, gpoi
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "AdapterRemoved", object_path);
+
         adapter = mdu_pool_get_adapter_by_object_path (pool, object_path);
         if (adapter == NULL) {
-                g_warning ("No adapter to remove for remove %s", object_path);
+                if (!pool->priv->is_scoped)
+                        g_warning ("No adapter to remove for remove %s", object_path);
                 goto out;
         }
 
-        g_hash_table_remove (pool->priv->object_path_to_adapter,
-                             mdu_adapter_get_object_path (adapter));
+        g_hash_table_remove (pool->priv->handle_to_adapter,
+                             GUINT_TO_POINTER (_mdu_adapter_get_handle (adapter)));
         g_signal_emit (pool, signals[ADAPTER_REMOVED], 0, adapter);
         g_signal_emit_by_name (adapter, "removed");
         g_object_unref (adapter);
@@ -1642,9 +1938,13 @@ adapter_changed_signal_handler (DBusGProxy *proxy, const char *object_path, gpoi
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "AdapterChanged", object_path);
+
         adapter = mdu_pool_get_adapter_by_object_path (pool, object_path);
         if (adapter == NULL) {
-                g_warning ("Ignoring change event on non-existant adapter %s", object_path);
+                if (!pool->priv->is_scoped)
+                        g_warning ("Ignoring change event on non-existant adapter %s", object_path);
                 goto out;
         }
 
@@ -1673,11 +1973,18 @@ expander_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpoin
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "ExpanderAdded", object_path);
+
+        /* scoped pools only track the hardware found when the pool was created */
+        if (pool->priv->is_scoped)
+                goto out;
+
         expander = mdu_pool_get_expander_by_object_path (pool, object_path);
         if (expander != NULL) {
                 g_object_unref (expander);
                 g_warning ("Treating add for previously added expander %s as change", object_path);
-                expander_changed_signal_handler (proxy, object_path, user_data);
+                expander_changed_signal_handler (NULL, object_path, user_data);
                 goto out;
         }
 
@@ -1685,8 +1992,8 @@ expander_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpoin
         if (expander == NULL)
                 goto out;
 
-        g_hash_table_insert (pool->priv->object_path_to_expander,
-                             (gpointer) mdu_expander_get_object_path (expander),
+        g_hash_table_insert (pool->priv->handle_to_expander,
+                             GUINT_TO_POINTER (_mdu_expander_get_handle (expander)),
                              expander);
         g_signal_emit (pool, signals[EXPANDER_ADDED], 0, expander);
         //g_debug ("Added expander %s", object_path);
@@ -1705,14 +2012,18 @@ expander_removed_signal_handler (DBusGProxy *proxy, const char *object_path, gpo
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "ExpanderRemoved", object_path);
+
         expander = mdu_pool_get_expander_by_object_path (pool, object_path);
         if (expander == NULL) {
-                g_warning ("No expander to remove for remove %s", object_path);
+                if (!pool->priv->is_scoped)
+                        g_warning ("No expander to remove for remove %s", object_path);
                 goto out;
         }
 
-        g_hash_table_remove (pool->priv->object_path_to_expander,
-                             mdu_expander_get_object_path (expander));
+        g_hash_table_remove (pool->priv->handle_to_expander,
+                             GUINT_TO_POINTER (_mdu_expander_get_handle (expander)));
         g_signal_emit (pool, signals[EXPANDER_REMOVED], 0, expander);
         g_signal_emit_by_name (expander, "removed");
         g_object_unref (expander);
@@ -1732,9 +2043,13 @@ expander_changed_signal_handler (DBusGProxy *proxy, const char *object_path, gpo
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "ExpanderChanged", object_path);
+
         expander = mdu_pool_get_expander_by_object_path (pool, object_path);
         if (expander == NULL) {
-                g_warning ("Ignoring change event on non-existant expander %s", object_path);
+                if (!pool->priv->is_scoped)
+                        g_warning ("Ignoring change event on non-existant expander %s", object_path);
                 goto out;
         }
 
@@ -1763,11 +2078,18 @@ port_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpointer
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "PortAdded", object_path);
+
+        /* scoped pools only track the hardware found when the pool was created */
+        if (pool->priv->is_scoped)
+                goto out;
+
         port = mdu_pool_get_port_by_object_path (pool, object_path);
         if (port != NULL) {
                 g_object_unref (port);
                 g_warning ("Treating add for previously added port %s as change", object_path);
-                port_changed_signal_handler (proxy, object_path, user_data);
+                port_changed_signal_handler (NULL, object_path, user_data);
                 goto out;
         }
 
@@ -1775,8 +2097,8 @@ port_added_signal_handler (DBusGProxy *proxy, const char *object_path, gpointer
         if (port == NULL)
                 goto out;
 
-        g_hash_table_insert (pool->priv->object_path_to_port,
-                             (gpointer) mdu_port_get_object_path (port),
+        g_hash_table_insert (pool->priv->handle_to_port,
+                             GUINT_TO_POINTER (_mdu_port_get_handle (port)),
                              port);
         g_signal_emit (pool, signals[PORT_ADDED], 0, port);
         //g_debug ("Added port %s", object_path);
@@ -1795,14 +2117,18 @@ port_removed_signal_handler (DBusGProxy *proxy, const char *object_path, gpointe
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "PortRemoved", object_path);
+
         port = mdu_pool_get_port_by_object_path (pool, object_path);
         if (port == NULL) {
-                g_warning ("No port to remove for remove %s", object_path);
+                if (!pool->priv->is_scoped)
+                        g_warning ("No port to remove for remove %s", object_path);
                 goto out;
         }
 
-        g_hash_table_remove (pool->priv->object_path_to_port,
-                             mdu_port_get_object_path (port));
+        g_hash_table_remove (pool->priv->handle_to_port,
+                             GUINT_TO_POINTER (_mdu_port_get_handle (port)));
         g_signal_emit (pool, signals[PORT_REMOVED], 0, port);
         g_signal_emit_by_name (port, "removed");
         g_object_unref (port);
@@ -1822,9 +2148,13 @@ port_changed_signal_handler (DBusGProxy *proxy, const char *object_path, gpointe
 
         pool = MDU_POOL (user_data);
 
+        if (proxy != NULL && pool->priv->trace != NULL)
+                _mdu_trace_record_signal (pool->priv->trace, "PortChanged", object_path);
+
         port = mdu_pool_get_port_by_object_path (pool, object_path);
         if (port == NULL) {
-                g_warning ("Ignoring change event on non-existant port %s", object_path);
+                if (!pool->priv->is_scoped)
+                        g_warning ("Ignoring change event on non-existant port %s", object_path);
                 goto out;
         }
 
@@ -1842,55 +2172,312 @@ port_changed_signal_handler (DBusGProxy *proxy, const char *object_path, gpointe
 
 /* ---------------------------------------------------------------------------------------------------- */
 
+/* called for every method call the pool waited for, @rtt is in seconds */
+static void
+pool_stats_record_call (MduPool *pool,
+                        gdouble  rtt)
+{
+        gdouble msec;
+        guint bucket;
+
+        pool->priv->stats.num_calls++;
+        pool->priv->stats.messages_sent++;
+        pool->priv->stats.messages_received++;
+
+        msec = rtt * 1000.0;
+        for (bucket = 0; bucket < MDU_POOL_STATS_NUM_RTT_BUCKETS - 1; bucket++) {
+                if (msec < (gdouble) (1 << bucket))
+                        break;
+        }
+        pool->priv->stats.rtt_histogram[bucket]++;
+}
+
+/**
+ * _mdu_pool_stats_begin_call:
+ * @pool: A #MduPool.
+ *
+ * Gets the time a method call to the daemon is made, to pass to
+ * _mdu_pool_stats_end_call() when the reply arrives.
+ *
+ * Returns: The time, in seconds.
+ */
+gdouble
+_mdu_pool_stats_begin_call (MduPool *pool)
+{
+        return g_timer_elapsed (pool->priv->stats_timer, NULL);
+}
+
+/**
+ * _mdu_pool_stats_end_call:
+ * @pool: A #MduPool.
+ * @begin_time: The time returned by _mdu_pool_stats_begin_call().
+ * @blocked: Whether the pool blocked waiting for the reply.
+ *
+ * Records a method call to the daemon in the statistics of @pool, see
+ * mdu_pool_get_stats().
+ */
+void
+_mdu_pool_stats_end_call (MduPool  *pool,
+                          gdouble   begin_time,
+                          gboolean  blocked)
+{
+        gdouble rtt;
+
+        rtt = g_timer_elapsed (pool->priv->stats_timer, NULL) - begin_time;
+        pool_stats_record_call (pool, rtt);
+        if (blocked)
+                pool->priv->stats.blocked_secs += rtt;
+}
+
+/* calls one of the Enumerate*() methods, blocking */
 static gboolean
-get_properties (MduPool *pool)
+pool_enumerate (MduPool     *pool,
+                gboolean   (*enumerate) (DBusGProxy  *proxy,
+                                         GPtrArray  **out_object_paths,
+                                         GError     **error),
+                GPtrArray  **out_object_paths,
+                GError     **error)
 {
+        gdouble begin_time;
         gboolean ret;
-        GError *error;
-        GHashTable *hash_table;
+
+        begin_time = _mdu_pool_stats_begin_call (pool);
+        ret = enumerate (pool->priv->proxy, out_object_paths, error);
+        _mdu_pool_stats_end_call (pool, begin_time, TRUE);
+
+        return ret;
+}
+
+/* called for every reply to GetAll() from the daemon, @properties is NULL if the call failed */
+static void
+got_properties (MduPool      *pool,
+                const gchar  *object_path,
+                const gchar  *interface_name,
+                GHashTable   *properties)
+{
+        if (pool->priv->trace != NULL)
+                _mdu_trace_record_get_all (pool->priv->trace, object_path, interface_name, properties);
+
+        /* remember what we got so we can tell what changed when reconnecting */
+        if (properties != NULL && pool->priv->ssh_address != NULL) {
+                g_hash_table_insert (pool->priv->handle_to_properties_checksum,
+                                     GUINT_TO_POINTER (_mdu_pool_intern_object_path (pool, object_path)),
+                                     _mdu_trace_checksum_properties (object_path, properties));
+        }
+}
+
+/**
+ * _mdu_pool_get_all_properties:
+ * @pool: A #MduPool.
+ * @object_path: The object to get properties for.
+ * @interface_name: The D-Bus interface to get properties for.
+ * @error: Return location for error.
+ *
+ * Gets all properties of @interface_name on @object_path, either by
+ * invoking GetAll() on the udisks daemon or, for offline pools, by
+ * looking up the properties previously passed to
+ * _mdu_pool_offline_set_object(). If the properties were fetched with
+ * _mdu_pool_prefetch_properties() that reply is used instead.
+ *
+ * Returns: A #GHashTable from property names to #GValue instances or
+ * %NULL if @error is set. Free with g_hash_table_unref().
+ */
+GHashTable *
+_mdu_pool_get_all_properties (MduPool      *pool,
+                              const gchar  *object_path,
+                              const gchar  *interface_name,
+                              GError      **error)
+{
+        GHashTable *ret;
         DBusGProxy *prop_proxy;
-        GValue *value;
-        GPtrArray *known_filesystems_array;
-        int n;
+        gpointer prefetched_object_path;
+        gdouble begin_time;
 
-        ret = FALSE;
+        ret = NULL;
+
+        if (pool->priv->is_offline) {
+                OfflineObject *object;
+
+                object = g_hash_table_lookup (pool->priv->offline_objects, object_path);
+                if (object == NULL || g_strcmp0 (object->interface_name, interface_name) != 0) {
+                        g_set_error (error,
+                                     MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     "No properties for interface %s on object %s",
+                                     interface_name,
+                                     object_path);
+                        goto out;
+                }
+                ret = g_hash_table_ref (object->properties);
+                goto out;
+        }
+
+        /* see _mdu_pool_prefetch_properties() */
+        if (g_hash_table_lookup_extended (pool->priv->prefetched_properties,
+                                          object_path,
+                                          &prefetched_object_path,
+                                          (gpointer *) &ret)) {
+                g_hash_table_steal (pool->priv->prefetched_properties, object_path);
+                g_free (prefetched_object_path);
+                goto out;
+        }
 
 	prop_proxy = dbus_g_proxy_new_for_name (pool->priv->bus,
                                                 "org.freedesktop.UDisks",
-                                                "/org/freedesktop/UDisks",
+                                                object_path,
                                                 "org.freedesktop.DBus.Properties");
-        error = NULL;
+        begin_time = _mdu_pool_stats_begin_call (pool);
         if (!dbus_g_proxy_call (prop_proxy,
                                 "GetAll",
-                                &error,
+                                error,
                                 G_TYPE_STRING,
-                                "org.freedesktop.UDisks",
+                                interface_name,
                                 G_TYPE_INVALID,
                                 dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
-                                &hash_table,
+                                &ret,
                                 G_TYPE_INVALID)) {
-                g_debug ("Error calling GetAll() retrieving properties for /org/freedesktop/UDisks: %s",
-                         error->message);
-                g_error_free (error);
-                goto out;
+                ret = NULL;
         }
+        _mdu_pool_stats_end_call (pool, begin_time, TRUE);
+        g_object_unref (prop_proxy);
 
-        value = g_hash_table_lookup (hash_table, "DaemonVersion");
-        if (value == NULL) {
-                g_warning ("No property 'DaemonVersion'");
-                goto out;
-        }
-        pool->priv->daemon_version = g_strdup (g_value_get_string (value));
+        got_properties (pool, object_path, interface_name, ret);
 
-        value = g_hash_table_lookup (hash_table, "SupportsLuksDevices");
-        if (value == NULL) {
-                g_warning ("No property 'SupportsLuksDevices'");
+ out:
+        return ret;
+}
+
+/* max number of GetAll() calls in flight, see _mdu_pool_prefetch_properties() */
+#define PREFETCH_WINDOW 128
+
+/**
+ * _mdu_pool_prefetch_properties:
+ * @pool: A #MduPool.
+ * @object_paths: The objects to get properties for.
+ * @num_object_paths: Number of elements in @object_paths.
+ * @interface_name: The D-Bus interface to get properties for.
+ *
+ * Gets the properties of @interface_name on all of @object_paths. All
+ * GetAll() calls (up to a window of 128) are sent before waiting for the
+ * first reply, so over a high-latency link (e.g. the ssh bridge) a batch
+ * costs about one round trip instead of one per object.
+ *
+ * The replies are kept until _mdu_pool_get_all_properties() is called for
+ * the object. Failed calls are not kept so the error is reported by
+ * _mdu_pool_get_all_properties(). Does nothing for offline pools.
+ */
+void
+_mdu_pool_prefetch_properties (MduPool             *pool,
+                               const gchar * const *object_paths,
+                               guint                num_object_paths,
+                               const gchar         *interface_name)
+{
+        DBusGProxy *proxies[PREFETCH_WINDOW];
+        DBusGProxyCall *calls[PREFETCH_WINDOW];
+        const gchar *call_object_paths[PREFETCH_WINDOW];
+        gdouble begin_times[PREFETCH_WINDOW];
+        gdouble blocked_since;
+        guint num_calls;
+        guint n;
+        guint m;
+
+        if (pool->priv->is_offline || pool->priv->bus == NULL)
                 goto out;
-        }
-        pool->priv->supports_luks_devices = g_value_get_boolean (value);
 
-        value = g_hash_table_lookup (hash_table, "KnownFilesystems");
-        if (value == NULL) {
+        n = 0;
+        while (n < num_object_paths) {
+                num_calls = 0;
+                blocked_since = g_timer_elapsed (pool->priv->stats_timer, NULL);
+                for (; n < num_object_paths && num_calls < PREFETCH_WINDOW; n++) {
+                        if (g_hash_table_lookup (pool->priv->prefetched_properties, object_paths[n]) != NULL)
+                                continue;
+
+                        proxies[num_calls] = dbus_g_proxy_new_for_name (pool->priv->bus,
+                                                                         "org.freedesktop.UDisks",
+                                                                         object_paths[n],
+                                                                         "org.freedesktop.DBus.Properties");
+                        calls[num_calls] = dbus_g_proxy_begin_call (proxies[num_calls],
+                                                                    "GetAll",
+                                                                    NULL, NULL, NULL,
+                                                                    G_TYPE_STRING,
+                                                                    interface_name,
+                                                                    G_TYPE_INVALID);
+                        call_object_paths[num_calls] = object_paths[n];
+                        begin_times[num_calls] = g_timer_elapsed (pool->priv->stats_timer, NULL);
+                        num_calls++;
+                }
+
+                for (m = 0; m < num_calls; m++) {
+                        GHashTable *properties;
+                        GError *error;
+
+                        error = NULL;
+                        if (!dbus_g_proxy_end_call (proxies[m],
+                                                    calls[m],
+                                                    &error,
+                                                    dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
+                                                    &properties,
+                                                    G_TYPE_INVALID)) {
+                                g_error_free (error);
+                                properties = NULL;
+                        }
+                        /* the replies arrive in order so this is close to the real round-trip time */
+                        pool_stats_record_call (pool, g_timer_elapsed (pool->priv->stats_timer, NULL) - begin_times[m]);
+                        if (properties != NULL) {
+                                got_properties (pool, call_object_paths[m], interface_name, properties);
+                                g_hash_table_insert (pool->priv->prefetched_properties,
+                                                     g_strdup (call_object_paths[m]),
+                                                     properties);
+                        }
+                        g_object_unref (proxies[m]);
+                }
+                pool->priv->stats.blocked_secs += g_timer_elapsed (pool->priv->stats_timer, NULL) - blocked_since;
+        }
+
+ out:
+        ;
+}
+
+static gboolean
+get_properties (MduPool *pool)
+{
+        gboolean ret;
+        GError *error;
+        GHashTable *hash_table;
+        GValue *value;
+        GPtrArray *known_filesystems_array;
+        int n;
+
+        ret = FALSE;
+
+        error = NULL;
+        hash_table = _mdu_pool_get_all_properties (pool,
+                                                   "/org/freedesktop/UDisks",
+                                                   "org.freedesktop.UDisks",
+                                                   &error);
+        if (hash_table == NULL) {
+                g_debug ("Error calling GetAll() retrieving properties for /org/freedesktop/UDisks: %s",
+                         error->message);
+                g_error_free (error);
+                goto out;
+        }
+
+        value = g_hash_table_lookup (hash_table, "DaemonVersion");
+        if (value == NULL) {
+                g_warning ("No property 'DaemonVersion'");
+                goto out;
+        }
+        pool->priv->daemon_version = g_strdup (g_value_get_string (value));
+
+        value = g_hash_table_lookup (hash_table, "SupportsLuksDevices");
+        if (value == NULL) {
+                g_warning ("No property 'SupportsLuksDevices'");
+                goto out;
+        }
+        pool->priv->supports_luks_devices = g_value_get_boolean (value);
+
+        value = g_hash_table_lookup (hash_table, "KnownFilesystems");
+        if (value == NULL) {
                 g_warning ("No property 'KnownFilesystems'");
                 goto out;
         }
@@ -1903,11 +2490,10 @@ get_properties (MduPool *pool)
         }
         pool->priv->known_filesystems = g_list_reverse (pool->priv->known_filesystems);
 
-        g_hash_table_unref (hash_table);
-
         ret = TRUE;
 out:
-        g_object_unref (prop_proxy);
+        if (hash_table != NULL)
+                g_hash_table_unref (hash_table);
         return ret;
 }
 
@@ -1946,255 +2532,2449 @@ _mdu_pool_get_connection (MduPool *pool)
         return pool->priv->bus;
 }
 
-static void
-on_ssh_process_terminated (GPid     pid,
-                           gint     status,
-                           gpointer user_data)
+static void pool_schedule_reconnect (MduPool *pool);
+static void pool_clear_queued_signals (MduPool *pool);
+static gboolean on_connection_lost_idle (gpointer user_data);
+
+/* counts the signals received over the connection of a remote pool and notices when
+ * the connection goes away
+ */
+static DBusHandlerResult
+connection_filter_func (DBusConnection *connection,
+                        DBusMessage    *message,
+                        void           *user_data)
+{
+        MduPool *pool = MDU_POOL (user_data);
+        char *data;
+        int len;
+
+        /* the connection may be shared with other pools - see mdu-ssh-bridge.c */
+        if (dbus_message_is_signal (message, DBUS_INTERFACE_LOCAL, "Disconnected")) {
+                if (pool->priv->connection_lost_idle_id == 0)
+                        pool->priv->connection_lost_idle_id = g_idle_add (on_connection_lost_idle, pool);
+                goto out;
+        }
+
+        /* replies to our own calls never get here, see pool_stats_record_call() */
+        pool->priv->stats.messages_received++;
+
+        if (!pool->priv->stats_bridge_counts_bytes && dbus_message_marshal (message, &data, &len)) {
+                pool->priv->stats.bytes_received += len;
+                dbus_free (data);
+        }
+
+ out:
+        return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static void
+pool_add_connection_filter (MduPool *pool)
+{
+        guint64 bytes_received;
+        guint64 bytes_sent;
+
+        pool->priv->stats_bridge_counts_bytes = _mdu_ssh_bridge_get_bytes_transferred (pool->priv->bus,
+                                                                                       &bytes_received,
+                                                                                       &bytes_sent);
+        dbus_connection_add_filter (dbus_g_connection_get_connection (pool->priv->bus),
+                                    connection_filter_func,
+                                    pool,
+                                    NULL);
+        pool->priv->connection_filter_added = TRUE;
+}
+
+static void
+pool_unref_bus (MduPool *pool)
+{
+        guint64 bytes_received;
+        guint64 bytes_sent;
+
+        if (pool->priv->bus == NULL)
+                goto out;
+
+        if (pool->priv->connection_filter_added) {
+                /* keep the totals of this connection around when reconnecting */
+                if (pool->priv->stats_bridge_counts_bytes &&
+                    _mdu_ssh_bridge_get_bytes_transferred (pool->priv->bus, &bytes_received, &bytes_sent)) {
+                        pool->priv->stats.bytes_received += bytes_received;
+                        pool->priv->stats.bytes_sent += bytes_sent;
+                }
+                dbus_connection_remove_filter (dbus_g_connection_get_connection (pool->priv->bus),
+                                               connection_filter_func,
+                                               pool);
+                pool->priv->connection_filter_added = FALSE;
+                pool->priv->stats_bridge_counts_bytes = FALSE;
+        }
+
+        if (pool->priv->ssh_address != NULL)
+                _mdu_ssh_bridge_release (pool->priv->bus);
+        else
+                dbus_g_connection_unref (pool->priv->bus);
+        pool->priv->bus = NULL;
+
+ out:
+        ;
+}
+
+/* Drops the connection to the daemon but keeps all objects around */
+static void
+pool_drop_connection (MduPool *pool)
+{
+        /* pool_resync() will catch up on these */
+        pool_clear_queued_signals (pool);
+
+        if (pool->priv->proxy != NULL) {
+                g_object_unref (pool->priv->proxy);
+                pool->priv->proxy = NULL;
+        }
+
+        pool_unref_bus (pool);
+}
+
+static void
+pool_handle_connection_lost (MduPool *pool)
+{
+        /* need to take a temp ref since receivers of the ::disconnected signal
+         * may unref the pool
+         */
+        g_object_ref (pool);
+
+        /* Instead of tearing down all objects, try to get the connection back and only
+         * update what changed in the meantime - see pool_resync()
+         */
+        pool_drop_connection (pool);
+        if (!pool->priv->is_reconnecting) {
+                pool->priv->is_reconnecting = TRUE;
+                pool->priv->reconnect_attempt = 0;
+                g_signal_emit (pool, signals[RECONNECTING], 0);
+        }
+        pool_schedule_reconnect (pool);
+
+        g_object_unref (pool);
+}
+
+/* the ssh process went away, see connection_filter_func() */
+static gboolean
+on_connection_lost_idle (gpointer user_data)
+{
+        MduPool *pool = MDU_POOL (user_data);
+
+        pool->priv->connection_lost_idle_id = 0;
+        pool_handle_connection_lost (pool);
+
+        return FALSE;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Scoped pools - see mdu_pool_new_for_device_file()
+ *
+ * Starting from the target device, slaves (partition tables, LUKS and RAID components, multipath
+ * paths) are always followed while holders are only followed from the target and what is stacked
+ * on top of it. This way we never end up pulling in e.g. LUKS devices on other partitions of the
+ * disks of a RAID array the target is part of. All partitions of every partition table we track
+ * are included, however, as free space (e.g. MduVolumeHole) can't be computed otherwise.
+ */
+
+typedef struct {
+        gchar *object_path;
+        gboolean descend;
+} ScopeEntry;
+
+/* the daemon uses "/" for "no object" */
+static gboolean
+scope_object_path_is_set (const gchar *object_path)
+{
+        return object_path != NULL && object_path[0] != '\0' && strcmp (object_path, "/") != 0;
+}
+
+static void
+scope_push (GQueue      *pending,
+            const gchar *object_path,
+            gboolean     descend)
+{
+        ScopeEntry *entry;
+
+        if (!scope_object_path_is_set (object_path))
+                return;
+
+        entry = g_new0 (ScopeEntry, 1);
+        entry->object_path = g_strdup (object_path);
+        entry->descend = descend;
+        g_queue_push_tail (pending, entry);
+}
+
+static void
+scope_push_strv (GQueue   *pending,
+                 gchar   **object_paths,
+                 gboolean  descend)
+{
+        guint n;
+
+        for (n = 0; object_paths != NULL && object_paths[n] != NULL; n++)
+                scope_push (pending, object_paths[n], descend);
+}
+
+static void scope_add_port (MduPool *pool, const gchar *object_path);
+
+static void
+scope_add_adapter (MduPool     *pool,
+                   const gchar *object_path)
+{
+        MduAdapter *adapter;
+
+        if (!scope_object_path_is_set (object_path) ||
+            g_hash_table_lookup (pool->priv->handle_to_adapter,
+                                 GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                return;
+
+        adapter = _mdu_adapter_new_from_object_path (pool, object_path);
+        if (adapter == NULL)
+                return;
+
+        g_hash_table_insert (pool->priv->handle_to_adapter,
+                             GUINT_TO_POINTER (_mdu_adapter_get_handle (adapter)),
+                             adapter);
+}
+
+static void
+scope_add_expander (MduPool     *pool,
+                    const gchar *object_path)
+{
+        MduExpander *expander;
+        gchar **ports;
+        guint n;
+
+        if (!scope_object_path_is_set (object_path) ||
+            g_hash_table_lookup (pool->priv->handle_to_expander,
+                                 GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                return;
+
+        expander = _mdu_expander_new_from_object_path (pool, object_path);
+        if (expander == NULL)
+                return;
+
+        g_hash_table_insert (pool->priv->handle_to_expander,
+                             GUINT_TO_POINTER (_mdu_expander_get_handle (expander)),
+                             expander);
+
+        scope_add_adapter (pool, mdu_expander_get_adapter (expander));
+        ports = mdu_expander_get_upstream_ports (expander);
+        for (n = 0; ports != NULL && ports[n] != NULL; n++)
+                scope_add_port (pool, ports[n]);
+}
+
+static void
+scope_add_port (MduPool     *pool,
+                const gchar *object_path)
+{
+        MduPort *port;
+
+        if (!scope_object_path_is_set (object_path) ||
+            lookup_port (pool, lookup_handle (pool, object_path)) != NULL)
+                return;
+
+        port = _mdu_port_new_from_object_path (pool, object_path);
+        if (port == NULL)
+                return;
+
+        g_hash_table_insert (pool->priv->handle_to_port,
+                             GUINT_TO_POINTER (_mdu_port_get_handle (port)),
+                             port);
+
+        scope_add_adapter (pool, mdu_port_get_adapter (port));
+        if (_mdu_port_get_parent_handle (port) != _mdu_port_get_adapter_handle (port))
+                scope_add_expander (pool, mdu_port_get_parent (port));
+}
+
+/* The daemon derives object paths from the kernel name by escaping every byte not
+ * in [A-Za-z0-9] as _<two hex digits>, e.g. dm-0 becomes dm_2d0
+ */
+static gchar *
+scope_object_path_to_kernel_name (const gchar *object_path)
+{
+        const gchar *basename;
+        GString *s;
+        guint n;
+
+        basename = strrchr (object_path, '/');
+        basename = basename != NULL ? basename + 1 : object_path;
+
+        s = g_string_new (NULL);
+        for (n = 0; basename[n] != '\0'; n++) {
+                if (basename[n] == '_' && g_ascii_isxdigit (basename[n + 1]) && g_ascii_isxdigit (basename[n + 2])) {
+                        g_string_append_c (s, g_ascii_xdigit_value (basename[n + 1]) * 16 +
+                                           g_ascii_xdigit_value (basename[n + 2]));
+                        n += 2;
+                } else {
+                        g_string_append_c (s, basename[n]);
+                }
+        }
+        return g_string_free (s, FALSE);
+}
+
+static void
+scope_add_candidate (GPtrArray   *candidates,
+                     const gchar *table_object_path,
+                     const gchar *kernel_name)
+{
+        const gchar *basename;
+        GString *s;
+        guint n;
+
+        basename = strrchr (table_object_path, '/');
+        s = g_string_new_len (table_object_path, basename != NULL ? basename + 1 - table_object_path : 0);
+        for (n = 0; kernel_name[n] != '\0'; n++) {
+                if (g_ascii_isalnum (kernel_name[n]))
+                        g_string_append_c (s, kernel_name[n]);
+                else
+                        g_string_append_printf (s, "_%02x", (guchar) kernel_name[n]);
+        }
+        g_ptr_array_add (candidates, g_string_free (s, FALSE));
+}
+
+/* Returns the object paths of the devices that may be partitions of the partition table at
+ * @table_object_path according to sysfs: the partitions the kernel knows about and the
+ * holders of the device (e.g. partitions of a dm-multipath device set up by kpartx).
+ * Returns %NULL if sysfs can't be read.
+ */
+static GPtrArray *
+scope_get_candidates_from_sysfs (const gchar *table_object_path)
+{
+        GPtrArray *ret;
+        gchar *kernel_name;
+        gchar *dir_name;
+        GDir *dir;
+        const gchar *name;
+
+        ret = NULL;
+        kernel_name = scope_object_path_to_kernel_name (table_object_path);
+
+        dir_name = g_build_filename ("/sys/class/block", kernel_name, NULL);
+        dir = g_dir_open (dir_name, 0, NULL);
+        if (dir == NULL)
+                goto out;
+        ret = g_ptr_array_new ();
+        while ((name = g_dir_read_name (dir)) != NULL) {
+                gchar *partition_file;
+
+                partition_file = g_build_filename (dir_name, name, "partition", NULL);
+                if (g_file_test (partition_file, G_FILE_TEST_EXISTS))
+                        scope_add_candidate (ret, table_object_path, name);
+                g_free (partition_file);
+        }
+        g_dir_close (dir);
+        g_free (dir_name);
+
+        dir_name = g_build_filename ("/sys/class/block", kernel_name, "holders", NULL);
+        dir = g_dir_open (dir_name, 0, NULL);
+        if (dir != NULL) {
+                while ((name = g_dir_read_name (dir)) != NULL)
+                        scope_add_candidate (ret, table_object_path, name);
+                g_dir_close (dir);
+        }
+
+ out:
+        g_free (dir_name);
+        g_free (kernel_name);
+        return ret;
+}
+
+/* Fallback if sysfs isn't available: object paths are derived from the kernel name and
+ * partitions are usually named like their table, e.g. sda1, nvme0n1p1 or mmcblk0p1
+ */
+static GPtrArray *
+scope_get_candidates_by_name (const gchar *table_object_path,
+                              GPtrArray   *all_object_paths)
+{
+        GPtrArray *ret;
+        const gchar *basename;
+        guint n;
+
+        basename = strrchr (table_object_path, '/');
+        basename = basename != NULL ? basename + 1 : table_object_path;
+
+        ret = g_ptr_array_new ();
+        for (n = 0; n < all_object_paths->len; n++) {
+                const gchar *candidate_path = all_object_paths->pdata[n];
+                const gchar *candidate_basename;
+
+                candidate_basename = strrchr (candidate_path, '/');
+                candidate_basename = candidate_basename != NULL ? candidate_basename + 1 : candidate_path;
+                if (g_str_has_prefix (candidate_basename, basename) &&
+                    strcmp (candidate_basename, basename) != 0)
+                        g_ptr_array_add (ret, g_strdup (candidate_path));
+        }
+        return ret;
+}
+
+/* Removes the devices from @candidates whose PartitionSlave property isn't @table_object_path;
+ * the Get() calls are pipelined like in _mdu_pool_prefetch_properties()
+ */
+static void
+scope_filter_partitions (MduPool     *pool,
+                         const gchar *table_object_path,
+                         GPtrArray   *candidates)
+{
+        DBusGProxy *proxies[PREFETCH_WINDOW];
+        DBusGProxyCall *calls[PREFETCH_WINDOW];
+        gboolean is_partition[PREFETCH_WINDOW];
+        gdouble begin_times[PREFETCH_WINDOW];
+        gdouble blocked_since;
+        guint num_calls;
+        guint first;
+        guint n;
+        guint m;
+
+        n = 0;
+        while (n < candidates->len) {
+                num_calls = 0;
+                first = n;
+                blocked_since = g_timer_elapsed (pool->priv->stats_timer, NULL);
+                for (; n < candidates->len && num_calls < PREFETCH_WINDOW; n++) {
+                        proxies[num_calls] = dbus_g_proxy_new_for_name (pool->priv->bus,
+                                                                         "org.freedesktop.UDisks",
+                                                                         candidates->pdata[n],
+                                                                         "org.freedesktop.DBus.Properties");
+                        calls[num_calls] = dbus_g_proxy_begin_call (proxies[num_calls],
+                                                                    "Get",
+                                                                    NULL, NULL, NULL,
+                                                                    G_TYPE_STRING,
+                                                                    "org.freedesktop.UDisks.Device",
+                                                                    G_TYPE_STRING,
+                                                                    "PartitionSlave",
+                                                                    G_TYPE_INVALID);
+                        begin_times[num_calls] = g_timer_elapsed (pool->priv->stats_timer, NULL);
+                        num_calls++;
+                }
+
+                for (m = 0; m < num_calls; m++) {
+                        GValue value = {0};
+                        GError *error;
+
+                        is_partition[m] = FALSE;
+                        error = NULL;
+                        if (!dbus_g_proxy_end_call (proxies[m],
+                                                    calls[m],
+                                                    &error,
+                                                    G_TYPE_VALUE,
+                                                    &value,
+                                                    G_TYPE_INVALID)) {
+                                /* not a device known to the daemon */
+                                g_error_free (error);
+                        } else {
+                                is_partition[m] = G_VALUE_HOLDS (&value, DBUS_TYPE_G_OBJECT_PATH) &&
+                                        g_strcmp0 (g_value_get_boxed (&value), table_object_path) == 0;
+                                g_value_unset (&value);
+                        }
+                        pool_stats_record_call (pool, g_timer_elapsed (pool->priv->stats_timer, NULL) - begin_times[m]);
+                        g_object_unref (proxies[m]);
+                }
+                pool->priv->stats.blocked_secs += g_timer_elapsed (pool->priv->stats_timer, NULL) - blocked_since;
+
+                /* drop the ones that aren't partitions of the table, back to front */
+                for (m = num_calls; m > 0; m--) {
+                        if (!is_partition[m - 1]) {
+                                g_free (candidates->pdata[first + m - 1]);
+                                g_ptr_array_remove_index (candidates, first + m - 1);
+                                n--;
+                        }
+                }
+        }
+}
+
+static void
+scope_add_partitions (MduPool   *pool,
+                      MduDevice *device,
+                      GPtrArray *all_object_paths,
+                      GQueue    *pending,
+                      gboolean   descend)
+{
+        const gchar *object_path;
+        GPtrArray *partitions;
+        guint n;
+
+        /* The daemon doesn't tell us the partitions of a partition table, only the table of a
+         * partition. Rather than asking every device on the system, only the devices sysfs
+         * lists below or on top of the table are checked.
+         */
+        object_path = mdu_device_get_object_path (device);
+        partitions = scope_get_candidates_from_sysfs (object_path);
+        if (partitions == NULL)
+                partitions = scope_get_candidates_by_name (object_path, all_object_paths);
+        scope_filter_partitions (pool, object_path, partitions);
+
+        _mdu_pool_prefetch_properties (pool,
+                                       (const gchar * const *) partitions->pdata,
+                                       partitions->len,
+                                       "org.freedesktop.UDisks.Device");
+
+        for (n = 0; n < partitions->len; n++) {
+                const gchar *partition_path = partitions->pdata[n];
+                MduDevice *partition;
+
+                partition = lookup_device (pool, lookup_handle (pool, partition_path));
+                if (partition == NULL) {
+                        partition = _mdu_device_new_from_object_path (pool, partition_path);
+                        if (partition == NULL)
+                                continue;
+
+                        g_hash_table_insert (pool->priv->handle_to_device,
+                                             GUINT_TO_POINTER (_mdu_device_get_handle (partition)),
+                                             partition);
+                }
+
+                if (descend)
+                        scope_push (pending, partition_path, TRUE);
+        }
+
+        g_ptr_array_foreach (partitions, (GFunc) g_free, NULL);
+        g_ptr_array_free (partitions, TRUE);
+}
+
+static gboolean
+prime_scope (MduPool      *pool,
+             const gchar  *device_file,
+             GError      **error)
+{
+        gboolean ret;
+        gchar *target_object_path;
+        GPtrArray *all_object_paths;
+        GHashTable *descended;
+        GQueue *pending;
+        ScopeEntry *entry;
+        GError *local_error;
+
+        ret = FALSE;
+        target_object_path = NULL;
+        all_object_paths = NULL;
+        descended = g_hash_table_new (g_direct_hash, g_direct_equal);
+        pending = g_queue_new ();
+
+        local_error = NULL;
+        if (!org_freedesktop_UDisks_find_device_by_device_file (pool->priv->proxy,
+                                                                device_file,
+                                                                &target_object_path,
+                                                                &local_error)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             _("Error finding device for %s: %s"),
+                             device_file,
+                             local_error->message);
+                g_error_free (local_error);
+                goto out;
+        }
+
+        /* only the object paths - this doesn't fetch any properties */
+        if (!pool_enumerate (pool, org_freedesktop_UDisks_enumerate_devices, &all_object_paths, &local_error)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             _("Error enumerating devices: %s"),
+                             local_error->message);
+                g_error_free (local_error);
+                goto out;
+        }
+
+        scope_push (pending, target_object_path, TRUE);
+        while ((entry = g_queue_pop_head (pending)) != NULL) {
+                MduDevice *device;
+
+                device = lookup_device (pool, lookup_handle (pool, entry->object_path));
+                if (device == NULL) {
+                        device = _mdu_device_new_from_object_path (pool, entry->object_path);
+                        if (device == NULL)
+                                goto next;
+
+                        g_hash_table_insert (pool->priv->handle_to_device,
+                                             GUINT_TO_POINTER (_mdu_device_get_handle (device)),
+                                             device);
+
+                        scope_push (pending, mdu_device_partition_get_slave (device), FALSE);
+                        scope_push (pending, mdu_device_luks_cleartext_get_slave (device), FALSE);
+                        scope_push_strv (pending, mdu_device_linux_md_get_slaves (device), FALSE);
+                        scope_push_strv (pending, mdu_device_linux_dmmp_get_slaves (device), FALSE);
+
+                        if (mdu_device_is_partition_table (device))
+                                scope_add_partitions (pool, device, all_object_paths, pending, FALSE);
+
+                        if (mdu_device_is_drive (device)) {
+                                gchar **ports;
+                                guint n;
+
+                                scope_add_adapter (pool, mdu_device_drive_get_adapter (device));
+                                ports = mdu_device_drive_get_ports (device);
+                                for (n = 0; ports != NULL && ports[n] != NULL; n++)
+                                        scope_add_port (pool, ports[n]);
+                        }
+                }
+
+                if (!entry->descend || g_hash_table_lookup (descended, device) != NULL)
+                        goto next;
+                g_hash_table_insert (descended, device, device);
+
+                scope_push (pending, mdu_device_luks_get_holder (device), TRUE);
+                scope_push (pending, mdu_device_linux_md_component_get_holder (device), TRUE);
+                scope_push (pending, mdu_device_linux_dmmp_component_get_holder (device), TRUE);
+                if (mdu_device_is_partition_table (device))
+                        scope_add_partitions (pool, device, all_object_paths, pending, TRUE);
+
+        next:
+                g_free (entry->object_path);
+                g_free (entry);
+        }
+
+        if (lookup_device (pool, lookup_handle (pool, target_object_path)) == NULL) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             _("Error getting properties for %s"),
+                             device_file);
+                goto out;
+        }
+
+        pool->priv->is_scoped = TRUE;
+        ret = TRUE;
+
+ out:
+        g_queue_free (pending);
+        g_hash_table_unref (descended);
+        if (all_object_paths != NULL) {
+                g_ptr_array_foreach (all_object_paths, (GFunc) g_free, NULL);
+                g_ptr_array_free (all_object_paths, TRUE);
+        }
+        g_free (target_object_path);
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+pool_start_trace (MduPool     *pool,
+                  const gchar *ssh_address)
+{
+        gchar *trace_filename;
+        GError *local_error;
+
+        if (g_getenv ("MDU_POOL_TRACE") == NULL)
+                return;
+
+        if (ssh_address == NULL)
+                trace_filename = g_strdup (g_getenv ("MDU_POOL_TRACE"));
+        else
+                trace_filename = g_strdup_printf ("%s.%s", g_getenv ("MDU_POOL_TRACE"), ssh_address);
+        local_error = NULL;
+        pool->priv->trace = _mdu_trace_new (trace_filename, &local_error);
+        if (pool->priv->trace == NULL) {
+                g_warning ("Not recording trace: %s", local_error->message);
+                g_error_free (local_error);
+        }
+        g_free (trace_filename);
+}
+
+static void
+pool_set_ssh_connection (MduPool         *pool,
+                         const gchar     *ssh_user_name,
+                         const gchar     *ssh_address,
+                         DBusGConnection *bus)
+{
+        gchar *old_ssh_user_name;
+        gchar *old_ssh_address;
+
+        /* may be called with our own strings when reconnecting */
+        old_ssh_user_name = pool->priv->ssh_user_name;
+        old_ssh_address = pool->priv->ssh_address;
+
+        pool->priv->bus = bus;
+        pool->priv->ssh_user_name = g_strdup (ssh_user_name);
+        pool->priv->ssh_address  = g_strdup (ssh_address);
+
+        g_free (old_ssh_user_name);
+        g_free (old_ssh_address);
+
+        /* Watch the connection, see connection_filter_func() */
+        pool_add_connection_filter (pool);
+
+        pool->priv->batch_signals = TRUE;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Batching of object signals for remote pools
+ *
+ * A change on the remote side (e.g. partitioning a disk) typically results in a burst of
+ * *Added, *Removed and *Changed signals, each of which costs a GetAll() round trip to
+ * handle. For remote pools the signals are therefore queued for a short while and then
+ * handled in order in one go, with the properties of all objects fetched up front with
+ * _mdu_pool_prefetch_properties(). Repeated change signals for the same object are only
+ * handled once and presentables are recomputed once per batch.
+ *
+ * Signals received while a pool is primed asynchronously are queued the same way, for
+ * local pools too, and handled right after the objects are created, see pool_prime_async().
+ */
+
+#define FLUSH_SIGNALS_DELAY_MSEC 20
+
+typedef struct {
+        MduPool *pool;
+        ObjectSignalHandler handler;
+        const gchar *interface_name;
+        gboolean is_change;
+} ObjectSignalClosure;
+
+static void
+pool_clear_queued_signals (MduPool *pool)
+{
+        if (pool->priv->flush_signals_timeout_id > 0) {
+                g_source_remove (pool->priv->flush_signals_timeout_id);
+                pool->priv->flush_signals_timeout_id = 0;
+        }
+        g_queue_foreach (pool->priv->queued_signals, (GFunc) queued_signal_free, NULL);
+        g_queue_clear (pool->priv->queued_signals);
+        g_hash_table_remove_all (pool->priv->queued_changes);
+}
+
+static gboolean
+on_flush_signals_timeout (gpointer user_data)
+{
+        MduPool *pool = MDU_POOL (user_data);
+        GHashTable *object_paths_by_interface;
+        GHashTableIter iter;
+        const gchar *interface_name;
+        GPtrArray *object_paths;
+        GQueue *queued_signals;
+        GList *l;
+
+        pool->priv->flush_signals_timeout_id = 0;
+
+        /* need to take a temp ref since receivers of our signals may unref the pool */
+        g_object_ref (pool);
+
+        queued_signals = pool->priv->queued_signals;
+        pool->priv->queued_signals = g_queue_new ();
+        g_hash_table_remove_all (pool->priv->queued_changes);
+
+        object_paths_by_interface = g_hash_table_new (g_str_hash, g_str_equal);
+        for (l = queued_signals->head; l != NULL; l = l->next) {
+                QueuedSignal *queued = l->data;
+
+                if (queued->interface_name == NULL)
+                        continue;
+                object_paths = g_hash_table_lookup (object_paths_by_interface, queued->interface_name);
+                if (object_paths == NULL) {
+                        object_paths = g_ptr_array_new ();
+                        g_hash_table_insert (object_paths_by_interface, (gpointer) queued->interface_name, object_paths);
+                }
+                g_ptr_array_add (object_paths, queued->object_path);
+        }
+        g_hash_table_iter_init (&iter, object_paths_by_interface);
+        while (g_hash_table_iter_next (&iter, (gpointer) &interface_name, (gpointer) &object_paths)) {
+                _mdu_pool_prefetch_properties (pool,
+                                               (const gchar * const *) object_paths->pdata,
+                                               object_paths->len,
+                                               interface_name);
+                g_ptr_array_free (object_paths, TRUE);
+        }
+        g_hash_table_unref (object_paths_by_interface);
+
+        pool->priv->presentables_frozen = TRUE;
+        for (l = queued_signals->head; l != NULL; l = l->next) {
+                QueuedSignal *queued = l->data;
+
+                queued->handler (pool->priv->proxy, queued->object_path, pool);
+        }
+        pool->priv->presentables_frozen = FALSE;
+        g_hash_table_remove_all (pool->priv->prefetched_properties);
+        recompute_presentables (pool);
+        pool->priv->num_signal_batches++;
+
+        g_queue_foreach (queued_signals, (GFunc) queued_signal_free, NULL);
+        g_queue_free (queued_signals);
+
+        g_object_unref (pool);
+
+        return FALSE;
+}
+
+static void
+on_object_signal (DBusGProxy  *proxy,
+                  const char  *object_path,
+                  gpointer     user_data)
+{
+        ObjectSignalClosure *closure = user_data;
+        MduPool *pool = closure->pool;
+        QueuedSignal *queued;
+
+        if (!pool->priv->batch_signals && !pool->priv->is_priming) {
+                closure->handler (proxy, object_path, pool);
+                goto out;
+        }
+
+        if (closure->is_change) {
+                /* the properties fetched for the queued change will be new enough */
+                if (g_hash_table_lookup (pool->priv->queued_changes, object_path) != NULL)
+                        goto out;
+                g_hash_table_insert (pool->priv->queued_changes, g_strdup (object_path), GUINT_TO_POINTER (1));
+        } else {
+                g_hash_table_remove (pool->priv->queued_changes, object_path);
+        }
+
+        queued = g_new0 (QueuedSignal, 1);
+        queued->handler = closure->handler;
+        queued->object_path = g_strdup (object_path);
+        queued->interface_name = closure->interface_name;
+        g_queue_push_tail (pool->priv->queued_signals, queued);
+
+        if (pool->priv->flush_signals_timeout_id == 0 && !pool->priv->is_priming)
+                pool->priv->flush_signals_timeout_id = g_timeout_add (FLUSH_SIGNALS_DELAY_MSEC,
+                                                                      on_flush_signals_timeout,
+                                                                      pool);
+
+ out:
+        ;
+}
+
+/* @interface_name is the interface to prefetch properties for, if any */
+static void
+connect_object_signal (MduPool             *pool,
+                       const gchar         *signal_name,
+                       ObjectSignalHandler  handler,
+                       const gchar         *interface_name,
+                       gboolean             is_change)
+{
+        ObjectSignalClosure *closure;
+
+        /* local pools handle signals right away unless priming, see on_object_signal() */
+        closure = g_new0 (ObjectSignalClosure, 1);
+        closure->pool = pool;
+        closure->handler = handler;
+        closure->interface_name = interface_name;
+        closure->is_change = is_change;
+        dbus_g_proxy_connect_signal (pool->priv->proxy, signal_name,
+                                     G_CALLBACK (on_object_signal), closure, g_free);
+
+        g_hash_table_insert (pool->priv->object_signal_closures,
+                             g_strdup (signal_name),
+                             g_memdup (closure, sizeof (ObjectSignalClosure)));
+}
+
+/**
+ * _mdu_pool_set_batch_signals:
+ * @pool: A #MduPool.
+ * @batch_signals: Whether to batch object signals.
+ *
+ * Makes @pool queue object signals and handle them in batches, like remote
+ * pools always do. This is used to measure the batching over a local
+ * connection with injected latency, see mdu-bench-latency.c.
+ */
+void
+_mdu_pool_set_batch_signals (MduPool  *pool,
+                             gboolean  batch_signals)
+{
+        pool->priv->batch_signals = batch_signals;
+}
+
+/**
+ * _mdu_pool_emit_object_signal:
+ * @pool: A #MduPool with a D-Bus connection.
+ * @signal_name: The name of a signal on the org.freedesktop.UDisks interface, e.g. DeviceChanged.
+ * @object_path: The object path passed in the signal.
+ *
+ * Handles @signal_name as if it had been received from the daemon, including queueing
+ * it if @pool batches signals.
+ */
+void
+_mdu_pool_emit_object_signal (MduPool     *pool,
+                              const gchar *signal_name,
+                              const gchar *object_path)
+{
+        ObjectSignalClosure *closure;
+
+        closure = g_hash_table_lookup (pool->priv->object_signal_closures, signal_name);
+        g_return_if_fail (closure != NULL);
+
+        on_object_signal (pool->priv->proxy, object_path, closure);
+}
+
+/**
+ * _mdu_pool_get_num_signal_batches:
+ * @pool: A #MduPool.
+ *
+ * Gets the number of times @pool handled a batch of queued object signals.
+ *
+ * Returns: The number of batches.
+ */
+guint
+_mdu_pool_get_num_signal_batches (MduPool *pool)
+{
+        return pool->priv->num_signal_batches;
+}
+
+/* Creates the proxy for the daemon object on the current connection and connects to its signals */
+static void
+pool_setup_proxy (MduPool *pool)
+{
+        dbus_g_object_register_marshaller (
+                mdu_marshal_VOID__STRING_BOOLEAN_STRING_UINT_BOOLEAN_DOUBLE,
+                G_TYPE_NONE,
+                DBUS_TYPE_G_OBJECT_PATH,
+                G_TYPE_BOOLEAN,
+                G_TYPE_STRING,
+                G_TYPE_UINT,
+                G_TYPE_BOOLEAN,
+                G_TYPE_DOUBLE,
+                G_TYPE_INVALID);
+
+	pool->priv->proxy = dbus_g_proxy_new_for_name (pool->priv->bus,
+                                                       "org.freedesktop.UDisks",
+                                                       "/org/freedesktop/UDisks",
+                                                       "org.freedesktop.UDisks");
+        dbus_g_proxy_add_signal (pool->priv->proxy, "DeviceAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "DeviceRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "DeviceChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy,
+                                 "DeviceJobChanged",
+                                 DBUS_TYPE_G_OBJECT_PATH,
+                                 G_TYPE_BOOLEAN,
+                                 G_TYPE_STRING,
+                                 G_TYPE_UINT,
+                                 G_TYPE_BOOLEAN,
+                                 G_TYPE_DOUBLE,
+                                 G_TYPE_INVALID);
+
+        connect_object_signal (pool, "DeviceAdded", device_added_signal_handler, "org.freedesktop.UDisks.Device", FALSE);
+        connect_object_signal (pool, "DeviceRemoved", device_removed_signal_handler, NULL, FALSE);
+        connect_object_signal (pool, "DeviceChanged", device_changed_signal_handler, "org.freedesktop.UDisks.Device", TRUE);
+        dbus_g_proxy_connect_signal (pool->priv->proxy, "DeviceJobChanged",
+                                     G_CALLBACK (device_job_changed_signal_handler), pool, NULL);
+
+        dbus_g_proxy_add_signal (pool->priv->proxy, "AdapterAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "AdapterRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "AdapterChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        connect_object_signal (pool, "AdapterAdded", adapter_added_signal_handler, "org.freedesktop.UDisks.Adapter", FALSE);
+        connect_object_signal (pool, "AdapterRemoved", adapter_removed_signal_handler, NULL, FALSE);
+        connect_object_signal (pool, "AdapterChanged", adapter_changed_signal_handler, "org.freedesktop.UDisks.Adapter", TRUE);
+
+        dbus_g_proxy_add_signal (pool->priv->proxy, "ExpanderAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "ExpanderRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "ExpanderChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        connect_object_signal (pool, "ExpanderAdded", expander_added_signal_handler, "org.freedesktop.UDisks.Expander", FALSE);
+        connect_object_signal (pool, "ExpanderRemoved", expander_removed_signal_handler, NULL, FALSE);
+        connect_object_signal (pool, "ExpanderChanged", expander_changed_signal_handler, "org.freedesktop.UDisks.Expander", TRUE);
+
+        dbus_g_proxy_add_signal (pool->priv->proxy, "PortAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "PortRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        dbus_g_proxy_add_signal (pool->priv->proxy, "PortChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
+        connect_object_signal (pool, "PortAdded", port_added_signal_handler, "org.freedesktop.UDisks.Port", FALSE);
+        connect_object_signal (pool, "PortRemoved", port_removed_signal_handler, NULL, FALSE);
+        connect_object_signal (pool, "PortChanged", port_changed_signal_handler, "org.freedesktop.UDisks.Port", TRUE);
+}
+
+/* Creates the devices, adapters, expanders and ports from the object paths returned by
+ * the Enumerate*() methods and computes the presentables. Their properties are usually
+ * prefetched by now, see _mdu_pool_prefetch_properties(). Frees the arrays.
+ */
+static void
+pool_add_objects (MduPool   *pool,
+                  GPtrArray *devices,
+                  GPtrArray *adapters,
+                  GPtrArray *expanders,
+                  GPtrArray *ports)
+{
+        int n;
+
+        /* to check that topological sorting works, enumerate backwards by commenting out the for statement below */
+        //for (n = devices->len - 1; n >= 0; n--) {
+        for (n = 0; n < (int) devices->len; n++) {
+                const char *object_path;
+                MduDevice *device;
+
+                object_path = devices->pdata[n];
+
+                /* the object may be gone already */
+                if (g_hash_table_lookup (pool->priv->handle_to_device,
+                                         GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                        continue;
+
+                device = _mdu_device_new_from_object_path (pool, object_path);
+                if (device == NULL)
+                        continue;
+
+                g_hash_table_insert (pool->priv->handle_to_device,
+                                     GUINT_TO_POINTER (_mdu_device_get_handle (device)),
+                                     device);
+        }
+        g_ptr_array_foreach (devices, (GFunc) g_free, NULL);
+        g_ptr_array_free (devices, TRUE);
+
+        for (n = 0; n < (int) adapters->len; n++) {
+                const char *object_path;
+                MduAdapter *adapter;
+
+                object_path = adapters->pdata[n];
+
+                if (g_hash_table_lookup (pool->priv->handle_to_adapter,
+                                         GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                        continue;
+
+                adapter = _mdu_adapter_new_from_object_path (pool, object_path);
+                if (adapter == NULL)
+                        continue;
+
+                g_hash_table_insert (pool->priv->handle_to_adapter,
+                                     GUINT_TO_POINTER (_mdu_adapter_get_handle (adapter)),
+                                     adapter);
+        }
+        g_ptr_array_foreach (adapters, (GFunc) g_free, NULL);
+        g_ptr_array_free (adapters, TRUE);
+
+        for (n = 0; n < (int) expanders->len; n++) {
+                const char *object_path;
+                MduExpander *expander;
+
+                object_path = expanders->pdata[n];
+
+                if (g_hash_table_lookup (pool->priv->handle_to_expander,
+                                         GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                        continue;
+
+                expander = _mdu_expander_new_from_object_path (pool, object_path);
+                if (expander == NULL)
+                        continue;
+
+                g_hash_table_insert (pool->priv->handle_to_expander,
+                                     GUINT_TO_POINTER (_mdu_expander_get_handle (expander)),
+                                     expander);
+        }
+        g_ptr_array_foreach (expanders, (GFunc) g_free, NULL);
+        g_ptr_array_free (expanders, TRUE);
+
+        for (n = 0; n < (int) ports->len; n++) {
+                const char *object_path;
+                MduPort *port;
+
+                object_path = ports->pdata[n];
+
+                if (g_hash_table_lookup (pool->priv->handle_to_port,
+                                         GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                        continue;
+
+                port = _mdu_port_new_from_object_path (pool, object_path);
+                if (port == NULL)
+                        continue;
+
+                g_hash_table_insert (pool->priv->handle_to_port,
+                                     GUINT_TO_POINTER (_mdu_port_get_handle (port)),
+                                     port);
+        }
+        g_ptr_array_foreach (ports, (GFunc) g_free, NULL);
+        g_ptr_array_free (ports, TRUE);
+
+        /* and finally compute all presentables */
+        recompute_presentables (pool);
+}
+
+/* Sets up signals and gets all objects for a pool with a D-Bus connection. Consumes
+ * the reference to @pool on failure.
+ */
+static MduPool *
+pool_prime (MduPool      *pool,
+            const gchar  *scope_device_file,
+            GError      **error)
+{
+        GPtrArray *devices;
+        GPtrArray *adapters;
+        GPtrArray *expanders;
+        GPtrArray *ports;
+        GError *local_error;
+
+        local_error = NULL;
+        devices = NULL;
+        adapters = NULL;
+        expanders = NULL;
+        ports = NULL;
+
+        pool->priv->machine = MDU_PRESENTABLE (_mdu_machine_new (pool));
+
+        pool_setup_proxy (pool);
+
+        /* get the properties on the daemon object */
+        if (!get_properties (pool)) {
+                g_warning ("Couldn't get daemon properties");
+                goto error;
+        }
+
+        if (scope_device_file != NULL) {
+                if (!prime_scope (pool, scope_device_file, error))
+                        goto error;
+                recompute_presentables (pool);
+                goto primed;
+        }
+
+        /* prime the list of devices */
+        if (!pool_enumerate (pool, org_freedesktop_UDisks_enumerate_devices, &devices, &local_error)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             _("Error enumerating devices: %s"),
+                             local_error->message);
+                g_error_free (local_error);
+                goto error;
+        }
+        _mdu_pool_prefetch_properties (pool,
+                                       (const gchar * const *) devices->pdata,
+                                       devices->len,
+                                       "org.freedesktop.UDisks.Device");
+
+        /* prime the list of adapters */
+        if (!pool_enumerate (pool, org_freedesktop_UDisks_enumerate_adapters, &adapters, &local_error)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             _("Error enumerating adapters: %s"),
+                             local_error->message);
+                g_error_free (local_error);
+                goto error;
+        }
+        _mdu_pool_prefetch_properties (pool,
+                                       (const gchar * const *) adapters->pdata,
+                                       adapters->len,
+                                       "org.freedesktop.UDisks.Adapter");
+
+        /* prime the list of expanders */
+        if (!pool_enumerate (pool, org_freedesktop_UDisks_enumerate_expanders, &expanders, &local_error)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             _("Error enumerating expanders: %s"),
+                             local_error->message);
+                g_error_free (local_error);
+                goto error;
+        }
+        _mdu_pool_prefetch_properties (pool,
+                                       (const gchar * const *) expanders->pdata,
+                                       expanders->len,
+                                       "org.freedesktop.UDisks.Expander");
+
+        /* prime the list of ports */
+        if (!pool_enumerate (pool, org_freedesktop_UDisks_enumerate_ports, &ports, &local_error)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             _("Error enumerating ports: %s"),
+                             local_error->message);
+                g_error_free (local_error);
+                goto error;
+        }
+        _mdu_pool_prefetch_properties (pool,
+                                       (const gchar * const *) ports->pdata,
+                                       ports->len,
+                                       "org.freedesktop.UDisks.Port");
+
+        pool_add_objects (pool, devices, adapters, expanders, ports);
+
+ primed:
+        g_hash_table_remove_all (pool->priv->prefetched_properties);
+
+        return pool;
+
+error:
+        if (devices != NULL) {
+                g_ptr_array_foreach (devices, (GFunc) g_free, NULL);
+                g_ptr_array_free (devices, TRUE);
+        }
+        if (adapters != NULL) {
+                g_ptr_array_foreach (adapters, (GFunc) g_free, NULL);
+                g_ptr_array_free (adapters, TRUE);
+        }
+        if (expanders != NULL) {
+                g_ptr_array_foreach (expanders, (GFunc) g_free, NULL);
+                g_ptr_array_free (expanders, TRUE);
+        }
+        g_hash_table_remove_all (pool->priv->prefetched_properties);
+        g_object_unref (pool);
+        if (error != NULL && *error == NULL) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "(unspecified error)");
+        }
+        return NULL;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Priming a pool without blocking
+ *
+ * pool_prime_async() does the same as pool_prime() but sends all calls from the main
+ * loop and never waits for a reply: the daemon object and the Enumerate*() methods are
+ * called at once and, as the object paths come in, GetAll() is called for each object
+ * with up to PREFETCH_WINDOW calls in flight - the asynchronous version of
+ * _mdu_pool_prefetch_properties(). Once all replies are in, the objects are created
+ * from the prefetched properties as usual, which doesn't involve the daemon anymore.
+ * Object signals received while the calls are in flight are queued and handled once
+ * the objects exist, so objects removed or changed in the meantime don't come back or
+ * keep the properties of the snapshot, see on_object_signal().
+ */
+
+typedef enum {
+        PRIME_KIND_DEVICES,
+        PRIME_KIND_ADAPTERS,
+        PRIME_KIND_EXPANDERS,
+        PRIME_KIND_PORTS,
+        PRIME_KIND_NUM
+} PrimeKind;
+
+static const struct {
+        const gchar *method;
+        const gchar *interface_name;
+        const gchar *what;
+} prime_kinds[PRIME_KIND_NUM] = {
+        { "EnumerateDevices",   "org.freedesktop.UDisks.Device",   "devices" },
+        { "EnumerateAdapters",  "org.freedesktop.UDisks.Adapter",  "adapters" },
+        { "EnumerateExpanders", "org.freedesktop.UDisks.Expander", "expanders" },
+        { "EnumeratePorts",     "org.freedesktop.UDisks.Port",     "ports" },
+};
+
+typedef struct {
+        MduPool *pool;
+        GSimpleAsyncResult *simple;
+
+        /* results of the Enumerate*() methods */
+        GPtrArray *object_paths[PRIME_KIND_NUM];
+
+        /* PrimeCall instances for GetAll() calls not sent yet */
+        GQueue *queue;
+        /* number of calls in flight */
+        guint num_calls;
+        /* proxies of finished GetAll() calls, not freed from within their own reply callback */
+        GList *proxies;
+
+        /* the first error, if any */
+        GError *error;
+} PrimeData;
+
+typedef struct {
+        PrimeData *data;
+        DBusGProxy *proxy;
+        gchar *object_path;
+        const gchar *interface_name;
+        PrimeKind kind;
+        gdouble begin_time;
+} PrimeCall;
+
+static void prime_send_calls (PrimeData *data);
+
+static void
+prime_call_free (PrimeCall *call)
+{
+        if (call->proxy != NULL)
+                g_object_unref (call->proxy);
+        g_free (call->object_path);
+        g_free (call);
+}
+
+static void
+prime_data_free (PrimeData *data)
+{
+        guint n;
+
+        for (n = 0; n < PRIME_KIND_NUM; n++) {
+                if (data->object_paths[n] != NULL) {
+                        g_ptr_array_foreach (data->object_paths[n], (GFunc) g_free, NULL);
+                        g_ptr_array_free (data->object_paths[n], TRUE);
+                }
+        }
+        g_queue_foreach (data->queue, (GFunc) prime_call_free, NULL);
+        g_queue_free (data->queue);
+        g_list_foreach (data->proxies, (GFunc) g_object_unref, NULL);
+        g_list_free (data->proxies);
+        if (data->error != NULL)
+                g_error_free (data->error);
+        if (data->pool != NULL)
+                g_object_unref (data->pool);
+        g_object_unref (data->simple);
+        g_free (data);
+}
+
+static void
+prime_queue_get_all (PrimeData   *data,
+                     const gchar *object_path,
+                     const gchar *interface_name)
+{
+        PrimeCall *call;
+
+        call = g_new0 (PrimeCall, 1);
+        call->data = data;
+        call->object_path = g_strdup (object_path);
+        call->interface_name = interface_name;
+        g_queue_push_tail (data->queue, call);
+}
+
+/* called in idle once the last reply is in */
+static gboolean
+prime_complete_in_idle (gpointer user_data)
+{
+        PrimeData *data = user_data;
+        MduPool *pool;
+        guint n;
+
+        pool = data->pool;
+        data->pool = NULL;
+
+        if (data->error != NULL) {
+                g_simple_async_result_set_from_error (data->simple, data->error);
+                goto error;
+        }
+
+        /* served from the prefetched properties */
+        if (!get_properties (pool)) {
+                g_warning ("Couldn't get daemon properties");
+                g_simple_async_result_set_error (data->simple,
+                                                 MDU_ERROR,
+                                                 MDU_ERROR_FAILED,
+                                                 "(unspecified error)");
+                goto error;
+        }
+
+        pool_add_objects (pool,
+                          data->object_paths[PRIME_KIND_DEVICES],
+                          data->object_paths[PRIME_KIND_ADAPTERS],
+                          data->object_paths[PRIME_KIND_EXPANDERS],
+                          data->object_paths[PRIME_KIND_PORTS]);
+        for (n = 0; n < PRIME_KIND_NUM; n++)
+                data->object_paths[n] = NULL;
+        g_hash_table_remove_all (pool->priv->prefetched_properties);
+
+        /* now handle what changed while priming */
+        pool->priv->is_priming = FALSE;
+        if (!g_queue_is_empty (pool->priv->queued_signals))
+                on_flush_signals_timeout (pool);
+
+        g_simple_async_result_set_op_res_gpointer (data->simple, pool, g_object_unref);
+        goto out;
+
+ error:
+        g_hash_table_remove_all (pool->priv->prefetched_properties);
+        g_object_unref (pool);
+
+ out:
+        g_simple_async_result_complete (data->simple);
+        prime_data_free (data);
+        return FALSE;
+}
+
+static void
+on_prime_get_all_reply (DBusGProxy     *proxy,
+                        DBusGProxyCall *call_id,
+                        gpointer        user_data)
+{
+        PrimeCall *call = user_data;
+        PrimeData *data = call->data;
+        MduPool *pool = data->pool;
+        GHashTable *properties;
+        GError *error;
+
+        error = NULL;
+        if (!dbus_g_proxy_end_call (proxy,
+                                    call_id,
+                                    &error,
+                                    dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
+                                    &properties,
+                                    G_TYPE_INVALID)) {
+                /* like _mdu_pool_prefetch_properties(), the error is reported when the object is created */
+                g_error_free (error);
+                properties = NULL;
+        }
+        pool_stats_record_call (pool, g_timer_elapsed (pool->priv->stats_timer, NULL) - call->begin_time);
+        if (properties != NULL) {
+                got_properties (pool, call->object_path, call->interface_name, properties);
+                g_hash_table_insert (pool->priv->prefetched_properties,
+                                     g_strdup (call->object_path),
+                                     properties);
+        }
+
+        data->proxies = g_list_prepend (data->proxies, call->proxy);
+        call->proxy = NULL;
+        prime_call_free (call);
+        data->num_calls--;
+        prime_send_calls (data);
+}
+
+static void
+on_prime_enumerate_reply (DBusGProxy     *proxy,
+                          DBusGProxyCall *call_id,
+                          gpointer        user_data)
+{
+        PrimeCall *call = user_data;
+        PrimeData *data = call->data;
+        GPtrArray *object_paths;
+        GError *error;
+        guint n;
+
+        error = NULL;
+        if (!dbus_g_proxy_end_call (proxy,
+                                    call_id,
+                                    &error,
+                                    dbus_g_type_get_collection ("GPtrArray", DBUS_TYPE_G_OBJECT_PATH),
+                                    &object_paths,
+                                    G_TYPE_INVALID)) {
+                if (data->error == NULL) {
+                        data->error = g_error_new (MDU_ERROR,
+                                                   MDU_ERROR_FAILED,
+                                                   _("Error enumerating %s: %s"),
+                                                   prime_kinds[call->kind].what,
+                                                   error->message);
+                }
+                g_error_free (error);
+        } else {
+                data->object_paths[call->kind] = object_paths;
+                for (n = 0; n < object_paths->len; n++)
+                        prime_queue_get_all (data, object_paths->pdata[n], prime_kinds[call->kind].interface_name);
+        }
+        _mdu_pool_stats_end_call (data->pool, call->begin_time, FALSE);
+
+        prime_call_free (call);
+        data->num_calls--;
+        prime_send_calls (data);
+}
+
+/* sends queued GetAll() calls while there is room in the window, completes when all is done */
+static void
+prime_send_calls (PrimeData *data)
+{
+        MduPool *pool = data->pool;
+        PrimeCall *call;
+
+        while (data->num_calls < PREFETCH_WINDOW &&
+               data->error == NULL &&
+               (call = g_queue_pop_head (data->queue)) != NULL) {
+                call->proxy = dbus_g_proxy_new_for_name (pool->priv->bus,
+                                                         "org.freedesktop.UDisks",
+                                                         call->object_path,
+                                                         "org.freedesktop.DBus.Properties");
+                call->begin_time = g_timer_elapsed (pool->priv->stats_timer, NULL);
+                dbus_g_proxy_begin_call (call->proxy,
+                                         "GetAll",
+                                         on_prime_get_all_reply,
+                                         call,
+                                         NULL,
+                                         G_TYPE_STRING,
+                                         call->interface_name,
+                                         G_TYPE_INVALID);
+                data->num_calls++;
+        }
+
+        if (data->num_calls == 0)
+                g_idle_add (prime_complete_in_idle, data);
+}
+
+/* The asynchronous version of pool_prime() for a pool tracking all devices, see the
+ * comment above. Consumes the reference to @pool; use pool_prime_finish() in @callback
+ * to get it back.
+ */
+static void
+pool_prime_async (MduPool             *pool,
+                  GAsyncReadyCallback  callback,
+                  gpointer             user_data)
+{
+        PrimeData *data;
+        guint n;
+
+        data = g_new0 (PrimeData, 1);
+        data->pool = pool;
+        data->simple = g_simple_async_result_new (NULL, callback, user_data, pool_prime_async);
+        data->queue = g_queue_new ();
+
+        pool->priv->machine = MDU_PRESENTABLE (_mdu_machine_new (pool));
+
+        pool->priv->is_priming = TRUE;
+        pool_setup_proxy (pool);
+
+        /* see get_properties() */
+        prime_queue_get_all (data, "/org/freedesktop/UDisks", "org.freedesktop.UDisks");
+
+        for (n = 0; n < PRIME_KIND_NUM; n++) {
+                PrimeCall *call;
+
+                call = g_new0 (PrimeCall, 1);
+                call->data = data;
+                call->kind = n;
+                call->begin_time = _mdu_pool_stats_begin_call (pool);
+                dbus_g_proxy_begin_call (pool->priv->proxy,
+                                         prime_kinds[n].method,
+                                         on_prime_enumerate_reply,
+                                         call,
+                                         NULL,
+                                         G_TYPE_INVALID);
+                data->num_calls++;
+        }
+
+        prime_send_calls (data);
+}
+
+static MduPool *
+pool_prime_finish (GAsyncResult  *res,
+                   GError       **error)
+{
+        GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (res);
+        MduPool *ret;
+
+        g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == pool_prime_async);
+
+        ret = NULL;
+        if (g_simple_async_result_propagate_error (simple, error))
+                goto out;
+
+        ret = g_object_ref (g_simple_async_result_get_op_res_gpointer (simple));
+
+ out:
+        return ret;
+}
+
+static MduPool *
+pool_new_internal (const gchar     *ssh_user_name,
+                   const gchar     *ssh_address,
+                   const gchar     *scope_device_file,
+                   GError         **error)
+{
+        MduPool *pool;
+
+        /* see mdu-trace.c */
+        if (ssh_address == NULL && g_getenv ("MDU_POOL_REPLAY") != NULL) {
+                return _mdu_trace_replay (g_getenv ("MDU_POOL_REPLAY"),
+                                          g_getenv ("MDU_POOL_REPLAY_FAST") == NULL,
+                                          NULL,
+                                          NULL,
+                                          error);
+        }
+
+        pool = MDU_POOL (g_object_new (MDU_TYPE_POOL, NULL));
+        pool_start_trace (pool, ssh_address);
+
+        if (ssh_address == NULL) {
+                pool->priv->bus = dbus_g_bus_get (DBUS_BUS_SYSTEM, error);
+                if (pool->priv->bus == NULL) {
+                        g_object_unref (pool);
+                        return NULL;
+                }
+        } else {
+                DBusGConnection *bus;
+
+                pool->priv->connect_flags = MDU_POOL_CONNECT_FLAGS_COMPRESS;
+                bus = _mdu_ssh_bridge_connect (ssh_user_name,
+                                               ssh_address,
+                                               TRUE,
+                                               error);
+                if (bus == NULL) {
+                        g_object_unref (pool);
+                        return NULL;
+                }
+                pool_set_ssh_connection (pool, ssh_user_name, ssh_address, bus);
+        }
+
+        return pool_prime (pool, scope_device_file, error);
+}
+
+/**
+ * mdu_pool_new_for_address:
+ * @ssh_user_name: The user name to connect as or %NULL for the current user.
+ * @ssh_address: The host to connect to or %NULL for the local machine.
+ * @error: Return location for error or %NULL.
+ *
+ * Creates a #MduPool tracking all storage objects on the local machine
+ * or, if @ssh_address is not %NULL, on a remote machine reached via ssh.
+ * The traffic to a remote machine is compressed.
+ *
+ * Returns: A #MduPool or %NULL if @error is set. Free with g_object_unref().
+ */
+MduPool *
+mdu_pool_new_for_address (const gchar     *ssh_user_name,
+                          const gchar     *ssh_address,
+                          GError         **error)
+{
+        return pool_new_internal (ssh_user_name, ssh_address, NULL, error);
+}
+
+/**
+ * _mdu_pool_new_for_connection:
+ * @bus: A connection to a message bus the udisks daemon is on.
+ * @error: Return location for error.
+ *
+ * Creates a pool for the daemon reachable through @bus. This is used by
+ * tools that need to talk to the daemon through something other than
+ * the system bus or the ssh bridge, see mdu-bench-latency.c.
+ *
+ * Returns: A #MduPool or %NULL if @error is set. Free with g_object_unref().
+ */
+MduPool *
+_mdu_pool_new_for_connection (DBusGConnection  *bus,
+                              GError          **error)
+{
+        MduPool *pool;
+
+        pool = MDU_POOL (g_object_new (MDU_TYPE_POOL, NULL));
+        pool->priv->bus = dbus_g_connection_ref (bus);
+
+        return pool_prime (pool, NULL, error);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* Reconnecting remote pools
+ *
+ * When the connection to the host is lost we keep all objects and try to reconnect with exponential
+ * backoff, giving up (and emitting ::disconnected) after RECONNECT_MAX_ATTEMPTS attempts.
+ * Once reconnected, the objects are reconciled against what the daemon has now: objects
+ * that went away are removed, new objects are added, and for the rest the checksum of a
+ * fresh GetAll() reply (all fetched in one batch) is compared against the one of the last
+ * reply. Only objects whose properties differ are updated (from the reply we already have)
+ * and emit ::changed, and presentables are recomputed once at the end, so unchanged
+ * presentables keep their identity.
+ */
+
+#define RECONNECT_MAX_ATTEMPTS   8
+#define RECONNECT_MAX_DELAY     60
+
+typedef struct {
+        const gchar *interface_name;
+        gboolean (*enumerate) (DBusGProxy  *proxy,
+                               GPtrArray  **out_object_paths,
+                               GError     **error);
+        ObjectSignalHandler added;
+        ObjectSignalHandler removed;
+        ObjectSignalHandler changed;
+} ResyncClass;
+
+static const ResyncClass resync_devices = {
+        "org.freedesktop.UDisks.Device",
+        org_freedesktop_UDisks_enumerate_devices,
+        device_added_signal_handler,
+        device_removed_signal_handler,
+        device_changed_signal_handler
+};
+
+static const ResyncClass resync_adapters = {
+        "org.freedesktop.UDisks.Adapter",
+        org_freedesktop_UDisks_enumerate_adapters,
+        adapter_added_signal_handler,
+        adapter_removed_signal_handler,
+        adapter_changed_signal_handler
+};
+
+static const ResyncClass resync_expanders = {
+        "org.freedesktop.UDisks.Expander",
+        org_freedesktop_UDisks_enumerate_expanders,
+        expander_added_signal_handler,
+        expander_removed_signal_handler,
+        expander_changed_signal_handler
+};
+
+static const ResyncClass resync_ports = {
+        "org.freedesktop.UDisks.Port",
+        org_freedesktop_UDisks_enumerate_ports,
+        port_added_signal_handler,
+        port_removed_signal_handler,
+        port_changed_signal_handler
+};
+
+/* @objects is one of the handle_to_* maps */
+static gboolean
+resync_objects (MduPool            *pool,
+                const ResyncClass  *klass,
+                GHashTable         *objects,
+                GError            **error)
+{
+        gboolean ret;
+        GPtrArray *object_paths;
+        GHashTable *present;
+        GHashTable *old_checksums;
+        GHashTableIter iter;
+        gpointer handle;
+        GList *removed;
+        GList *l;
+        GError *local_error;
+        guint n;
+
+        ret = FALSE;
+        removed = NULL;
+
+        local_error = NULL;
+        if (!pool_enumerate (pool, klass->enumerate, &object_paths, &local_error)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
+                             "Error enumerating %s objects: %s",
+                             klass->interface_name,
+                             local_error->message);
+                g_error_free (local_error);
+                goto out;
+        }
+
+        present = g_hash_table_new (g_direct_hash, g_direct_equal);
+        for (n = 0; n < object_paths->len; n++) {
+                g_hash_table_insert (present,
+                                     GUINT_TO_POINTER (_mdu_pool_intern_object_path (pool, object_paths->pdata[n])),
+                                     GUINT_TO_POINTER (1));
+        }
+
+        /* objects that went away while we were disconnected */
+        g_hash_table_iter_init (&iter, objects);
+        while (g_hash_table_iter_next (&iter, &handle, NULL)) {
+                if (g_hash_table_lookup (present, handle) == NULL)
+                        removed = g_list_prepend (removed, handle);
+        }
+        for (l = removed; l != NULL; l = l->next) {
+                g_hash_table_remove (pool->priv->handle_to_properties_checksum, l->data);
+                klass->removed (NULL,
+                                _mdu_pool_get_object_path_for_handle (pool, GPOINTER_TO_UINT (l->data)),
+                                pool);
+        }
+
+        /* new objects and objects that may have changed - get all their properties in one go */
+        old_checksums = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+        g_hash_table_iter_init (&iter, objects);
+        while (g_hash_table_iter_next (&iter, &handle, NULL)) {
+                g_hash_table_insert (old_checksums,
+                                     handle,
+                                     g_strdup (g_hash_table_lookup (pool->priv->handle_to_properties_checksum, handle)));
+        }
+        _mdu_pool_prefetch_properties (pool,
+                                       (const gchar * const *) object_paths->pdata,
+                                       object_paths->len,
+                                       klass->interface_name);
+
+        for (n = 0; n < object_paths->len; n++) {
+                const gchar *object_path = object_paths->pdata[n];
+                const gchar *old_checksum;
+                const gchar *new_checksum;
+
+                handle = GUINT_TO_POINTER (_mdu_pool_intern_object_path (pool, object_path));
+                if (g_hash_table_lookup (objects, handle) == NULL) {
+                        klass->added (NULL, object_path, pool);
+                        continue;
+                }
+
+                old_checksum = g_hash_table_lookup (old_checksums, handle);
+                new_checksum = g_hash_table_lookup (pool->priv->handle_to_properties_checksum, handle);
+                if (g_strcmp0 (old_checksum, new_checksum) != 0) {
+                        /* the object picks up the prefetched reply */
+                        klass->changed (NULL, object_path, pool);
+                } else {
+                        g_hash_table_remove (pool->priv->prefetched_properties, object_path);
+                }
+        }
+
+        g_hash_table_unref (old_checksums);
+        g_hash_table_unref (present);
+        g_ptr_array_foreach (object_paths, (GFunc) g_free, NULL);
+        g_ptr_array_free (object_paths, TRUE);
+
+        ret = TRUE;
+
+ out:
+        g_list_free (removed);
+        return ret;
+}
+
+static void
+rebind_proxies (GHashTable *objects,
+                GFunc       rebind_func)
+{
+        GList *values;
+
+        values = g_hash_table_get_values (objects);
+        g_list_foreach (values, rebind_func, NULL);
+        g_list_free (values);
+}
+
+/* Brings all objects up to date after the pool has reconnected to the daemon */
+static gboolean
+pool_resync (MduPool  *pool,
+             GError  **error)
+{
+        gboolean ret;
+
+        ret = FALSE;
+
+        pool_setup_proxy (pool);
+
+        g_free (pool->priv->daemon_version);
+        pool->priv->daemon_version = NULL;
+        g_list_foreach (pool->priv->known_filesystems, (GFunc) g_object_unref, NULL);
+        g_list_free (pool->priv->known_filesystems);
+        pool->priv->known_filesystems = NULL;
+        if (!get_properties (pool)) {
+                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED, "Couldn't get daemon properties");
+                goto out;
+        }
+
+        rebind_proxies (pool->priv->handle_to_device, (GFunc) _mdu_device_rebind_proxy);
+        rebind_proxies (pool->priv->handle_to_adapter, (GFunc) _mdu_adapter_rebind_proxy);
+        rebind_proxies (pool->priv->handle_to_expander, (GFunc) _mdu_expander_rebind_proxy);
+        rebind_proxies (pool->priv->handle_to_port, (GFunc) _mdu_port_rebind_proxy);
+
+        pool->priv->presentables_frozen = TRUE;
+
+        if (!resync_objects (pool, &resync_devices, pool->priv->handle_to_device, error))
+                goto out;
+        if (!resync_objects (pool, &resync_adapters, pool->priv->handle_to_adapter, error))
+                goto out;
+        if (!resync_objects (pool, &resync_expanders, pool->priv->handle_to_expander, error))
+                goto out;
+        if (!resync_objects (pool, &resync_ports, pool->priv->handle_to_port, error))
+                goto out;
+
+        ret = TRUE;
+
+ out:
+        g_hash_table_remove_all (pool->priv->prefetched_properties);
+        if (pool->priv->presentables_frozen) {
+                pool->priv->presentables_frozen = FALSE;
+                recompute_presentables (pool);
+        }
+        return ret;
+}
+
+static void
+on_reconnect_bridge_connected (GObject      *source_object,
+                               GAsyncResult *res,
+                               gpointer      user_data)
+{
+        MduPool *pool = MDU_POOL (user_data);
+        DBusGConnection *bus;
+        GError *error;
+
+        error = NULL;
+        bus = _mdu_ssh_bridge_connect_finish (res, &error);
+        if (bus == NULL) {
+                g_warning ("Error reconnecting to %s: %s", pool->priv->ssh_address, error->message);
+                g_error_free (error);
+                pool_schedule_reconnect (pool);
+                goto out;
+        }
+
+        pool_set_ssh_connection (pool,
+                                 pool->priv->ssh_user_name,
+                                 pool->priv->ssh_address,
+                                 bus);
+
+        if (!pool_resync (pool, &error)) {
+                g_warning ("Error resyncing with %s: %s", pool->priv->ssh_address, error->message);
+                g_error_free (error);
+                pool_handle_connection_lost (pool);
+                goto out;
+        }
+
+        pool->priv->is_reconnecting = FALSE;
+        pool->priv->reconnect_attempt = 0;
+        g_signal_emit (pool, signals[RECONNECTED], 0);
+
+ out:
+        g_object_unref (pool);
+}
+
+static gboolean
+on_reconnect_timeout (gpointer user_data)
+{
+        MduPool *pool = MDU_POOL (user_data);
+
+        pool->priv->reconnect_timeout_id = 0;
+
+        /* the reference is released in on_reconnect_bridge_connected() */
+        _mdu_ssh_bridge_connect_async (pool->priv->ssh_user_name,
+                                       pool->priv->ssh_address,
+                                       pool->priv->connect_flags & MDU_POOL_CONNECT_FLAGS_COMPRESS,
+                                       NULL,
+                                       on_reconnect_bridge_connected,
+                                       g_object_ref (pool));
+
+        return FALSE;
+}
+
+static void
+pool_schedule_reconnect (MduPool *pool)
+{
+        guint delay;
+
+        if (pool->priv->reconnect_attempt >= RECONNECT_MAX_ATTEMPTS) {
+                g_warning ("Giving up reconnecting to %s", pool->priv->ssh_address);
+                pool->priv->is_reconnecting = FALSE;
+                _mdu_pool_disconnect (pool);
+                return;
+        }
+
+        delay = MIN (1 << pool->priv->reconnect_attempt, RECONNECT_MAX_DELAY);
+        pool->priv->reconnect_attempt++;
+        pool->priv->reconnect_timeout_id = g_timeout_add_seconds (delay, on_reconnect_timeout, pool);
+}
+
+/**
+ * mdu_pool_is_reconnecting:
+ * @pool: A #MduPool.
+ *
+ * Checks whether @pool has lost the connection to its remote host and
+ * is trying to reconnect. See #MduPool::reconnecting.
+ *
+ * Returns: %TRUE if @pool is reconnecting.
+ */
+gboolean
+mdu_pool_is_reconnecting (MduPool *pool)
+{
+        g_return_val_if_fail (MDU_IS_POOL (pool), FALSE);
+        return pool->priv->is_reconnecting;
+}
+
+/**
+ * mdu_pool_get_stats:
+ * @pool: A #MduPool.
+ * @out_stats: Return location for the statistics.
+ *
+ * Gets traffic statistics for @pool. This is mostly useful for remote
+ * pools where the numbers tell how busy and how slow the link to the
+ * remote host is. To get rates, take the difference of two snapshots.
+ *
+ * The number of bytes is only available for remote pools. On systems
+ * where the ssh bridge cannot count them, only signals are counted.
+ * Pools connected to the same host share one connection and thus
+ * report the same number of bytes.
+ */
+void
+mdu_pool_get_stats (MduPool      *pool,
+                    MduPoolStats *out_stats)
+{
+        guint64 bytes_received;
+        guint64 bytes_sent;
+
+        g_return_if_fail (MDU_IS_POOL (pool));
+        g_return_if_fail (out_stats != NULL);
+
+        *out_stats = pool->priv->stats;
+
+        if (pool->priv->stats_bridge_counts_bytes &&
+            _mdu_ssh_bridge_get_bytes_transferred (pool->priv->bus, &bytes_received, &bytes_sent)) {
+                out_stats->bytes_received += bytes_received;
+                out_stats->bytes_sent += bytes_sent;
+        }
+
+        out_stats->elapsed_secs = g_timer_elapsed (pool->priv->stats_timer, NULL);
+}
+
+/**
+ * mdu_pool_stats_get_rtt_percentile:
+ * @stats: Statistics from mdu_pool_get_stats().
+ * @percentile: A number between 0 and 100, e.g. 99.0.
+ *
+ * Estimates the round-trip time that @percentile percent of the calls
+ * in @stats did not exceed. As the histogram only has power-of-two
+ * buckets, this is the upper bound of the bucket the percentile falls in.
+ *
+ * Returns: The round-trip time in milliseconds or 0 if no calls were made.
+ */
+gdouble
+mdu_pool_stats_get_rtt_percentile (const MduPoolStats *stats,
+                                   gdouble             percentile)
+{
+        gdouble ret;
+        guint64 target;
+        guint64 seen;
+        guint n;
+
+        g_return_val_if_fail (stats != NULL, 0.0);
+
+        ret = 0.0;
+        if (stats->num_calls == 0)
+                goto out;
+
+        target = (guint64) (stats->num_calls * CLAMP (percentile, 0.0, 100.0) / 100.0 + 0.5);
+        target = MAX (target, 1);
+        seen = 0;
+        for (n = 0; n < MDU_POOL_STATS_NUM_RTT_BUCKETS - 1; n++) {
+                seen += stats->rtt_histogram[n];
+                if (seen >= target)
+                        break;
+        }
+        ret = (gdouble) (1 << n);
+
+ out:
+        return ret;
+}
+
+typedef struct {
+        MduPool *pool;
+        gchar *ssh_user_name;
+        gchar *ssh_address;
+        GSimpleAsyncResult *simple;
+} NewForAddressData;
+
+static void
+new_for_address_data_free (NewForAddressData *data)
+{
+        if (data->pool != NULL)
+                g_object_unref (data->pool);
+        g_free (data->ssh_user_name);
+        g_free (data->ssh_address);
+        g_object_unref (data->simple);
+        g_free (data);
+}
+
+static void
+new_for_address_prime_cb (GObject      *source_object,
+                          GAsyncResult *res,
+                          gpointer      user_data)
+{
+        NewForAddressData *data = user_data;
+        GError *error;
+        MduPool *pool;
+
+        error = NULL;
+        pool = pool_prime_finish (res, &error);
+        if (pool == NULL) {
+                g_simple_async_result_set_from_error (data->simple, error);
+                g_error_free (error);
+                goto out;
+        }
+        g_simple_async_result_set_op_res_gpointer (data->simple, pool, g_object_unref);
+
+ out:
+        g_simple_async_result_complete (data->simple);
+        new_for_address_data_free (data);
+}
+
+/* pool_prime_async() consumes the reference to data->pool */
+static void
+new_for_address_prime (NewForAddressData *data)
+{
+        MduPool *pool;
+
+        pool = data->pool;
+        data->pool = NULL;
+        pool_prime_async (pool, new_for_address_prime_cb, data);
+}
+
+static void
+new_for_address_bridge_cb (GObject      *source_object,
+                           GAsyncResult *res,
+                           gpointer      user_data)
+{
+        NewForAddressData *data = user_data;
+        DBusGConnection *bus;
+        GError *error;
+
+        error = NULL;
+        bus = _mdu_ssh_bridge_connect_finish (res, &error);
+        if (bus == NULL) {
+                g_simple_async_result_set_from_error (data->simple, error);
+                g_error_free (error);
+                g_simple_async_result_complete (data->simple);
+                new_for_address_data_free (data);
+                goto out;
+        }
+
+        pool_set_ssh_connection (data->pool, data->ssh_user_name, data->ssh_address, bus);
+        new_for_address_prime (data);
+
+ out:
+        ;
+}
+
+/**
+ * mdu_pool_new_for_address_async:
+ * @ssh_user_name: The user name to connect as or %NULL for the current user.
+ * @ssh_address: The host to connect to or %NULL for the local machine.
+ * @flags: Flags from #MduPoolConnectFlags, ignored for the local machine.
+ * @cancellable: A #GCancellable or %NULL.
+ * @callback: Function to call when the pool is ready.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronous version of mdu_pool_new_for_address(). Neither setting up
+ * the ssh connection nor getting the initial set of objects blocks, so any
+ * number of pools can be connecting at the same time and the main loop
+ * keeps running while the daemon is enumerated. Use
+ * mdu_pool_new_for_address_finish() in @callback to get the result.
+ * Cancelling @cancellable aborts connecting to @ssh_address.
+ */
+void
+mdu_pool_new_for_address_async (const gchar         *ssh_user_name,
+                                const gchar         *ssh_address,
+                                MduPoolConnectFlags  flags,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+        NewForAddressData *data;
+
+        data = g_new0 (NewForAddressData, 1);
+        data->simple = g_simple_async_result_new (NULL,
+                                                  callback,
+                                                  user_data,
+                                                  mdu_pool_new_for_address_async);
+
+        if (ssh_address == NULL) {
+                GError *error;
+
+                error = NULL;
+                /* replaying a trace doesn't talk to a daemon, see mdu-trace.c */
+                if (g_getenv ("MDU_POOL_REPLAY") != NULL) {
+                        MduPool *pool;
+
+                        pool = mdu_pool_new_for_address (NULL, NULL, &error);
+                        if (pool == NULL) {
+                                g_simple_async_result_set_from_error (data->simple, error);
+                                g_error_free (error);
+                        } else {
+                                g_simple_async_result_set_op_res_gpointer (data->simple, pool, g_object_unref);
+                        }
+                        g_simple_async_result_complete_in_idle (data->simple);
+                        new_for_address_data_free (data);
+                        goto out;
+                }
+
+                data->pool = MDU_POOL (g_object_new (MDU_TYPE_POOL, NULL));
+                pool_start_trace (data->pool, NULL);
+                data->pool->priv->bus = dbus_g_bus_get (DBUS_BUS_SYSTEM, &error);
+                if (data->pool->priv->bus == NULL) {
+                        g_simple_async_result_set_from_error (data->simple, error);
+                        g_error_free (error);
+                        g_simple_async_result_complete_in_idle (data->simple);
+                        new_for_address_data_free (data);
+                        goto out;
+                }
+                new_for_address_prime (data);
+                goto out;
+        }
+
+        data->ssh_user_name = g_strdup (ssh_user_name);
+        data->ssh_address = g_strdup (ssh_address);
+        data->pool = MDU_POOL (g_object_new (MDU_TYPE_POOL, NULL));
+        data->pool->priv->connect_flags = flags;
+        pool_start_trace (data->pool, ssh_address);
+
+        _mdu_ssh_bridge_connect_async (ssh_user_name,
+                                       ssh_address,
+                                       flags & MDU_POOL_CONNECT_FLAGS_COMPRESS,
+                                       cancellable,
+                                       new_for_address_bridge_cb,
+                                       data);
+
+ out:
+        ;
+}
+
+/**
+ * mdu_pool_new_for_address_finish:
+ * @res: A #GAsyncResult.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mdu_pool_new_for_address_async().
+ *
+ * Returns: A #MduPool or %NULL if @error is set. Free with g_object_unref().
+ */
+MduPool *
+mdu_pool_new_for_address_finish (GAsyncResult  *res,
+                                 GError       **error)
 {
-        MduPool *pool = MDU_POOL (user_data);
+        GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (res);
+        MduPool *ret;
 
-        g_print ("wohoo, ssh process has been terminated\n");
+        g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == mdu_pool_new_for_address_async);
 
-        /* need to take a temp ref since receivers of the ::disconnected signal
-         * may unref the pool
-         */
-        g_object_ref (pool);
-
-        _mdu_pool_disconnect (pool);
+        ret = NULL;
+        if (g_simple_async_result_propagate_error (simple, error))
+                goto out;
 
-        g_spawn_close_pid (pid);
+        ret = g_object_ref (g_simple_async_result_get_op_res_gpointer (simple));
 
-        g_source_remove (pool->priv->ssh_child_watch_id);
-        pool->priv->ssh_child_watch_id = 0;
-        pool->priv->ssh_pid = 0;
+ out:
+        return ret;
+}
 
-        g_object_unref (pool);
+/**
+ * mdu_pool_new_for_device_file:
+ * @device_file: A device file, e.g. <literal>/dev/sda1</literal>.
+ * @error: Return location for error or %NULL.
+ *
+ * Creates a #MduPool on the local machine that only tracks @device_file,
+ * the devices it is stacked on (partition table, LUKS, RAID or multipath
+ * components), the devices stacked on it (partitions, LUKS cleartext
+ * devices, RAID arrays) and the hardware its drive is attached to. This
+ * is a lot cheaper than mdu_pool_new() on systems with many devices and
+ * is intended for tools that operate on a single device.
+ *
+ * Presentables for the tracked devices are the same as in a full pool.
+ * Devices added later are only picked up if they are stacked on a
+ * tracked device.
+ *
+ * Returns: A #MduPool or %NULL if @error is set. Free with g_object_unref().
+ */
+MduPool *
+mdu_pool_new_for_device_file (const gchar  *device_file,
+                              GError      **error)
+{
+        g_return_val_if_fail (device_file != NULL, NULL);
+        return pool_new_internal (NULL, NULL, device_file, error);
 }
 
+/* ---------------------------------------------------------------------------------------------------- */
+
+/**
+ * _mdu_pool_new_offline:
+ *
+ * Creates a #MduPool that is not backed by a D-Bus connection. Objects are
+ * described with _mdu_pool_offline_set_object() and instantiated with
+ * _mdu_pool_offline_prime(). This is used for benchmarking and for
+ * replaying recorded traces; operations on objects in an offline pool
+ * are not supported.
+ *
+ * Returns: A #MduPool. Free with g_object_unref().
+ */
 MduPool *
-mdu_pool_new_for_address (const gchar     *ssh_user_name,
-                          const gchar     *ssh_address,
-                          GError         **error)
+_mdu_pool_new_offline (void)
 {
-        int n;
-        GPtrArray *devices;
-        GPtrArray *adapters;
-        GPtrArray *expanders;
-        GPtrArray *ports;
         MduPool *pool;
-        GError *local_error;
-
-        local_error = NULL;
 
         pool = MDU_POOL (g_object_new (MDU_TYPE_POOL, NULL));
-
-        if (ssh_address == NULL) {
-                pool->priv->bus = dbus_g_bus_get (DBUS_BUS_SYSTEM, error);
-                if (pool->priv->bus == NULL) {
-                        goto error;
-                }
-        } else {
-                pool->priv->bus = _mdu_ssh_bridge_connect (ssh_user_name,
-                                                           ssh_address,
-                                                           &(pool->priv->ssh_pid),
-                                                           error);
-                if (pool->priv->bus == NULL) {
-                        goto error;
-                }
-                pool->priv->ssh_user_name = g_strdup (ssh_user_name);
-                pool->priv->ssh_address  = g_strdup (ssh_address);
-
-                /* Watch the ssh process */
-                //g_print ("pid is %d\n", pool->priv->ssh_pid);
-                pool->priv->ssh_child_watch_id = g_child_watch_add (pool->priv->ssh_pid,
-                                                                    on_ssh_process_terminated,
-                                                                    pool);
-        }
-
+        pool->priv->is_offline = TRUE;
+        pool->priv->daemon_version = g_strdup ("offline");
         pool->priv->machine = MDU_PRESENTABLE (_mdu_machine_new (pool));
 
-        dbus_g_object_register_marshaller (
-                mdu_marshal_VOID__STRING_BOOLEAN_STRING_UINT_BOOLEAN_DOUBLE,
-                G_TYPE_NONE,
-                DBUS_TYPE_G_OBJECT_PATH,
-                G_TYPE_BOOLEAN,
-                G_TYPE_STRING,
-                G_TYPE_UINT,
-                G_TYPE_BOOLEAN,
-                G_TYPE_DOUBLE,
-                G_TYPE_INVALID);
+        return pool;
+}
 
-	pool->priv->proxy = dbus_g_proxy_new_for_name (pool->priv->bus,
-                                                       "org.freedesktop.UDisks",
-                                                       "/org/freedesktop/UDisks",
-                                                       "org.freedesktop.UDisks");
-        dbus_g_proxy_add_signal (pool->priv->proxy, "DeviceAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "DeviceRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "DeviceChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy,
-                                 "DeviceJobChanged",
-                                 DBUS_TYPE_G_OBJECT_PATH,
-                                 G_TYPE_BOOLEAN,
-                                 G_TYPE_STRING,
-                                 G_TYPE_UINT,
-                                 G_TYPE_BOOLEAN,
-                                 G_TYPE_DOUBLE,
-                                 G_TYPE_INVALID);
+gboolean
+_mdu_pool_is_offline (MduPool *pool)
+{
+        return pool->priv->is_offline;
+}
 
-        /* get the properties on the daemon object */
-        if (!get_properties (pool)) {
-                g_warning ("Couldn't get daemon properties");
-                goto error;
+/**
+ * _mdu_pool_free:
+ * @pool: A #MduPool.
+ *
+ * Drops all objects and presentables in @pool as well as its connection
+ * and then releases the reference to @pool. Since every object holds a
+ * reference to its pool, g_object_unref() alone never frees a pool with
+ * objects in it. Used by the benchmarks.
+ */
+void
+_mdu_pool_free (MduPool *pool)
+{
+        remove_all_objects_and_dbus_proxies (pool);
+        if (pool->priv->machine != NULL) {
+                g_object_unref (pool->priv->machine);
+                pool->priv->machine = NULL;
         }
+        g_object_unref (pool);
+}
 
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "DeviceAdded",
-                                     G_CALLBACK (device_added_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "DeviceRemoved",
-                                     G_CALLBACK (device_removed_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "DeviceChanged",
-                                     G_CALLBACK (device_changed_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "DeviceJobChanged",
-                                     G_CALLBACK (device_job_changed_signal_handler), pool, NULL);
-
-        dbus_g_proxy_add_signal (pool->priv->proxy, "AdapterAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "AdapterRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "AdapterChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "AdapterAdded",
-                                     G_CALLBACK (adapter_added_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "AdapterRemoved",
-                                     G_CALLBACK (adapter_removed_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "AdapterChanged",
-                                     G_CALLBACK (adapter_changed_signal_handler), pool, NULL);
-
-        dbus_g_proxy_add_signal (pool->priv->proxy, "ExpanderAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "ExpanderRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "ExpanderChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "ExpanderAdded",
-                                     G_CALLBACK (expander_added_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "ExpanderRemoved",
-                                     G_CALLBACK (expander_removed_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "ExpanderChanged",
-                                     G_CALLBACK (expander_changed_signal_handler), pool, NULL);
+/**
+ * _mdu_pool_offline_set_object:
+ * @pool: An offline #MduPool.
+ * @object_path: The object path.
+ * @interface_name: One of the org.freedesktop.UDisks.Device, .Adapter, .Expander or .Port interfaces.
+ * @properties: A #GHashTable from property names to #GValue instances (as returned by GetAll()) or
+ * %NULL to forget about @object_path.
+ *
+ * Sets the properties that will be returned for @object_path the next time they are requested.
+ */
+void
+_mdu_pool_offline_set_object (MduPool     *pool,
+                              const gchar *object_path,
+                              const gchar *interface_name,
+                              GHashTable  *properties)
+{
+        OfflineObject *object;
 
-        dbus_g_proxy_add_signal (pool->priv->proxy, "PortAdded", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "PortRemoved", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_add_signal (pool->priv->proxy, "PortChanged", DBUS_TYPE_G_OBJECT_PATH, G_TYPE_INVALID);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "PortAdded",
-                                     G_CALLBACK (port_added_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "PortRemoved",
-                                     G_CALLBACK (port_removed_signal_handler), pool, NULL);
-        dbus_g_proxy_connect_signal (pool->priv->proxy, "PortChanged",
-                                     G_CALLBACK (port_changed_signal_handler), pool, NULL);
+        g_return_if_fail (pool->priv->is_offline);
 
-        /* prime the list of devices */
-        if (!org_freedesktop_UDisks_enumerate_devices (pool->priv->proxy, &devices, &local_error)) {
-                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
-                             _("Error enumerating devices: %s"),
-                             local_error->message);
-                g_error_free (local_error);
-                goto error;
+        if (properties == NULL) {
+                g_hash_table_remove (pool->priv->offline_objects, object_path);
+                goto out;
         }
 
-        /* to check that topological sorting works, enumerate backwards by commenting out the for statement below */
-        //for (n = devices->len - 1; n >= 0; n--) {
-        for (n = 0; n < (int) devices->len; n++) {
-                const char *object_path;
-                MduDevice *device;
-
-                object_path = devices->pdata[n];
-
-                device = _mdu_device_new_from_object_path (pool, object_path);
+        object = g_new0 (OfflineObject, 1);
+        object->interface_name = g_strdup (interface_name);
+        object->properties = g_hash_table_ref (properties);
+        g_hash_table_insert (pool->priv->offline_objects, g_strdup (object_path), object);
 
-                g_hash_table_insert (pool->priv->object_path_to_device,
-                                     (gpointer) mdu_device_get_object_path (device),
-                                     device);
-        }
-        g_ptr_array_foreach (devices, (GFunc) g_free, NULL);
-        g_ptr_array_free (devices, TRUE);
+ out:
+        ;
+}
 
-        /* prime the list of adapters */
-        if (!org_freedesktop_UDisks_enumerate_adapters (pool->priv->proxy, &adapters, &local_error)) {
-                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
-                             _("Error enumerating adapters: %s"),
-                             local_error->message);
-                g_error_free (local_error);
-                goto error;
+/**
+ * _mdu_pool_offline_prime:
+ * @pool: An offline #MduPool.
+ *
+ * Instantiates objects for everything passed to _mdu_pool_offline_set_object() not
+ * already known to @pool and then computes the presentables. This is the offline
+ * equivalent of the enumeration done in mdu_pool_new_for_address().
+ */
+void
+_mdu_pool_offline_prime (MduPool *pool)
+{
+        GHashTableIter iter;
+        const gchar *object_path;
+        OfflineObject *object;
+
+        g_return_if_fail (pool->priv->is_offline);
+
+        /* daemon properties are only available when replaying a trace */
+        if (pool->priv->known_filesystems == NULL &&
+            g_hash_table_lookup (pool->priv->offline_objects, "/org/freedesktop/UDisks") != NULL) {
+                g_free (pool->priv->daemon_version);
+                pool->priv->daemon_version = NULL;
+                if (!get_properties (pool))
+                        pool->priv->daemon_version = g_strdup ("offline");
         }
-        for (n = 0; n < (int) adapters->len; n++) {
-                const char *object_path;
-                MduAdapter *adapter;
 
-                object_path = adapters->pdata[n];
-
-                adapter = _mdu_adapter_new_from_object_path (pool, object_path);
+        g_hash_table_iter_init (&iter, pool->priv->offline_objects);
+        while (g_hash_table_iter_next (&iter, (gpointer) &object_path, (gpointer) &object)) {
+                if (g_strcmp0 (object->interface_name, "org.freedesktop.UDisks.Device") == 0) {
+                        MduDevice *device;
 
-                g_hash_table_insert (pool->priv->object_path_to_adapter,
-                                     (gpointer) mdu_adapter_get_object_path (adapter),
-                                     adapter);
-        }
-        g_ptr_array_foreach (adapters, (GFunc) g_free, NULL);
-        g_ptr_array_free (adapters, TRUE);
+                        if (g_hash_table_lookup (pool->priv->handle_to_device, GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                                continue;
+                        device = _mdu_device_new_from_object_path (pool, object_path);
+                        if (device != NULL)
+                                g_hash_table_insert (pool->priv->handle_to_device,
+                                                     GUINT_TO_POINTER (_mdu_device_get_handle (device)),
+                                                     device);
+                } else if (g_strcmp0 (object->interface_name, "org.freedesktop.UDisks.Adapter") == 0) {
+                        MduAdapter *adapter;
+
+                        if (g_hash_table_lookup (pool->priv->handle_to_adapter, GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                                continue;
+                        adapter = _mdu_adapter_new_from_object_path (pool, object_path);
+                        if (adapter != NULL)
+                                g_hash_table_insert (pool->priv->handle_to_adapter,
+                                                     GUINT_TO_POINTER (_mdu_adapter_get_handle (adapter)),
+                                                     adapter);
+                } else if (g_strcmp0 (object->interface_name, "org.freedesktop.UDisks.Expander") == 0) {
+                        MduExpander *expander;
+
+                        if (g_hash_table_lookup (pool->priv->handle_to_expander, GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                                continue;
+                        expander = _mdu_expander_new_from_object_path (pool, object_path);
+                        if (expander != NULL)
+                                g_hash_table_insert (pool->priv->handle_to_expander,
+                                                     GUINT_TO_POINTER (_mdu_expander_get_handle (expander)),
+                                                     expander);
+                } else if (g_strcmp0 (object->interface_name, "org.freedesktop.UDisks.Port") == 0) {
+                        MduPort *port;
 
-        /* prime the list of expanders */
-        if (!org_freedesktop_UDisks_enumerate_expanders (pool->priv->proxy, &expanders, &local_error)) {
-                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
-                             _("Error enumerating expanders: %s"),
-                             local_error->message);
-                g_error_free (local_error);
-                goto error;
+                        if (g_hash_table_lookup (pool->priv->handle_to_port, GUINT_TO_POINTER (lookup_handle (pool, object_path))) != NULL)
+                                continue;
+                        port = _mdu_port_new_from_object_path (pool, object_path);
+                        if (port != NULL)
+                                g_hash_table_insert (pool->priv->handle_to_port,
+                                                     GUINT_TO_POINTER (_mdu_port_get_handle (port)),
+                                                     port);
+                }
         }
-        for (n = 0; n < (int) expanders->len; n++) {
-                const char *object_path;
-                MduExpander *expander;
-
-                object_path = expanders->pdata[n];
 
-                expander = _mdu_expander_new_from_object_path (pool, object_path);
+        recompute_presentables (pool);
+}
 
-                g_hash_table_insert (pool->priv->object_path_to_expander,
-                                     (gpointer) mdu_expander_get_object_path (expander),
-                                     expander);
-        }
-        g_ptr_array_foreach (expanders, (GFunc) g_free, NULL);
-        g_ptr_array_free (expanders, TRUE);
+/**
+ * _mdu_pool_offline_dispatch_signal:
+ * @pool: An offline #MduPool.
+ * @member: The name of a signal on the org.freedesktop.UDisks interface, e.g. DeviceChanged.
+ * @object_path: The object path passed in the signal.
+ *
+ * Handles @member as if it had been received from the daemon.
+ */
+void
+_mdu_pool_offline_dispatch_signal (MduPool     *pool,
+                                   const gchar *member,
+                                   const gchar *object_path)
+{
+        g_return_if_fail (pool->priv->is_offline);
+
+        if (strcmp (member, "DeviceAdded") == 0)
+                device_added_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "DeviceRemoved") == 0)
+                device_removed_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "DeviceChanged") == 0)
+                device_changed_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "AdapterAdded") == 0)
+                adapter_added_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "AdapterRemoved") == 0)
+                adapter_removed_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "AdapterChanged") == 0)
+                adapter_changed_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "ExpanderAdded") == 0)
+                expander_added_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "ExpanderRemoved") == 0)
+                expander_removed_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "ExpanderChanged") == 0)
+                expander_changed_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "PortAdded") == 0)
+                port_added_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "PortRemoved") == 0)
+                port_removed_signal_handler (NULL, object_path, pool);
+        else if (strcmp (member, "PortChanged") == 0)
+                port_changed_signal_handler (NULL, object_path, pool);
+        else
+                g_warning ("Ignoring unknown signal %s", member);
+}
 
-        /* prime the list of ports */
-        if (!org_freedesktop_UDisks_enumerate_ports (pool->priv->proxy, &ports, &local_error)) {
-                g_set_error (error, MDU_ERROR, MDU_ERROR_FAILED,
-                             _("Error enumerating ports: %s"),
-                             local_error->message);
-                g_error_free (local_error);
-                goto error;
-        }
-        for (n = 0; n < (int) ports->len; n++) {
-                const char *object_path;
-                MduPort *port;
+void
+_mdu_pool_offline_dispatch_job_changed (MduPool     *pool,
+                                        const gchar *object_path,
+                                        gboolean     job_in_progress,
+                                        const gchar *job_id,
+                                        uid_t        job_initiated_by_uid,
+                                        gboolean     job_is_cancellable,
+                                        gdouble      job_percentage)
+{
+        g_return_if_fail (pool->priv->is_offline);
+
+        device_job_changed_signal_handler (NULL,
+                                           object_path,
+                                           job_in_progress,
+                                           job_id,
+                                           job_initiated_by_uid,
+                                           job_is_cancellable,
+                                           job_percentage,
+                                           pool);
+}
 
-                object_path = ports->pdata[n];
+void
+_mdu_pool_recompute_presentables (MduPool *pool)
+{
+        recompute_presentables (pool);
+}
 
-                port = _mdu_port_new_from_object_path (pool, object_path);
+/**
+ * _mdu_pool_get_holes_for_drive:
+ * @pool: A #MduPool.
+ * @devices: The result of mdu_pool_get_devices().
+ * @drive: A #MduDrive in @pool.
+ *
+ * Computes the unallocated space on @drive exactly like it is done when
+ * recomputing presentables.
+ *
+ * Returns: A list of new #MduVolumeHole objects. Free with g_object_unref()
+ * and g_list_free().
+ */
+GList *
+_mdu_pool_get_holes_for_drive (MduPool  *pool,
+                               GList    *devices,
+                               MduDrive *drive)
+{
+        GList *l;
+        MduVolume *extended_partition;
 
-                g_hash_table_insert (pool->priv->object_path_to_port,
-                                     (gpointer) mdu_port_get_object_path (port),
-                                     port);
-        }
-        g_ptr_array_foreach (ports, (GFunc) g_free, NULL);
-        g_ptr_array_free (ports, TRUE);
+        extended_partition = NULL;
+        for (l = pool->priv->presentables; l != NULL && extended_partition == NULL; l = l->next) {
+                MduPresentable *p = MDU_PRESENTABLE (l->data);
+                MduPresentable *e;
+                MduDevice *d;
 
-        /* and finally compute all presentables */
-        recompute_presentables (pool);
+                if (!MDU_IS_VOLUME (p))
+                        continue;
 
-        return pool;
+                e = mdu_presentable_get_enclosing_presentable (p);
+                if (e == NULL)
+                        continue;
+                g_object_unref (e);
+                if (e != MDU_PRESENTABLE (drive))
+                        continue;
 
-error:
-        g_object_unref (pool);
-        if (error != NULL && *error == NULL) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             "(unspecified error)");
+                d = mdu_presentable_get_device (p);
+                if (d != NULL) {
+                        if (is_msdos_extended_partition (d))
+                                extended_partition = MDU_VOLUME (p);
+                        g_object_unref (d);
+                }
         }
-        return NULL;
+
+        return get_holes_for_drive (pool, devices, drive, extended_partition);
 }
 
 /**
@@ -2214,7 +4994,7 @@ mdu_pool_get_by_object_path (MduPool *pool, const char *object_path)
 
         g_assert (pool != NULL);
 
-        ret = g_hash_table_lookup (pool->priv->object_path_to_device, object_path);
+        ret = g_hash_table_lookup (pool->priv->handle_to_device, GUINT_TO_POINTER (lookup_handle (pool, object_path)));
         if (ret != NULL) {
                 g_object_ref (ret);
         }
@@ -2238,7 +5018,7 @@ mdu_pool_get_adapter_by_object_path (MduPool *pool, const char *object_path)
 
         g_assert (pool != NULL);
 
-        ret = g_hash_table_lookup (pool->priv->object_path_to_adapter, object_path);
+        ret = g_hash_table_lookup (pool->priv->handle_to_adapter, GUINT_TO_POINTER (lookup_handle (pool, object_path)));
         if (ret != NULL) {
                 g_object_ref (ret);
         }
@@ -2262,7 +5042,7 @@ mdu_pool_get_expander_by_object_path (MduPool *pool, const char *object_path)
 
         g_assert (pool != NULL);
 
-        ret = g_hash_table_lookup (pool->priv->object_path_to_expander, object_path);
+        ret = g_hash_table_lookup (pool->priv->handle_to_expander, GUINT_TO_POINTER (lookup_handle (pool, object_path)));
         if (ret != NULL) {
                 g_object_ref (ret);
         }
@@ -2286,7 +5066,7 @@ mdu_pool_get_port_by_object_path (MduPool *pool, const char *object_path)
 
         g_assert (pool != NULL);
 
-        ret = g_hash_table_lookup (pool->priv->object_path_to_port, object_path);
+        ret = g_hash_table_lookup (pool->priv->handle_to_port, GUINT_TO_POINTER (lookup_handle (pool, object_path)));
         if (ret != NULL) {
                 g_object_ref (ret);
         }
@@ -2316,7 +5096,7 @@ mdu_pool_get_by_device_file (MduPool *pool, const char *device_file)
 
         /* TODO: use lookaside hash table */
 
-        g_hash_table_iter_init (&iter, pool->priv->object_path_to_device);
+        g_hash_table_iter_init (&iter, pool->priv->handle_to_device);
         while (g_hash_table_iter_next (&iter, NULL, (gpointer) &device)) {
 
                 if (g_strcmp0 (mdu_device_get_device_file (device), device_file) == 0) {
@@ -2330,7 +5110,7 @@ mdu_pool_get_by_device_file (MduPool *pool, const char *device_file)
 }
 
 static MduDevice *
-find_extended_partition (MduPool *pool, const gchar *partition_table_object_path)
+find_extended_partition (MduPool *pool, guint partition_table_handle)
 {
         GHashTableIter iter;
         MduDevice *device;
@@ -2338,13 +5118,13 @@ find_extended_partition (MduPool *pool, const gchar *partition_table_object_path
 
         ret = NULL;
 
-        g_hash_table_iter_init (&iter, pool->priv->object_path_to_device);
+        g_hash_table_iter_init (&iter, pool->priv->handle_to_device);
         while (g_hash_table_iter_next (&iter, NULL, (gpointer) &device)) {
 
                 if (!mdu_device_is_partition (device))
                         continue;
 
-                if (g_strcmp0 (mdu_device_partition_get_slave (device), partition_table_object_path) == 0) {
+                if (_mdu_device_partition_get_slave_handle (device) == partition_table_handle) {
                         gint type;
 
                         type = strtol (mdu_device_partition_get_type (device), NULL, 0);
@@ -2361,7 +5141,7 @@ find_extended_partition (MduPool *pool, const gchar *partition_table_object_path
 }
 
 static void
-device_recurse (MduPool *pool, MduDevice *device, GList **ret, guint depth)
+device_recurse (MduPool *pool, MduDevice *device, GList **ret, GHashTable *visited, guint depth)
 {
         gboolean insert_after;
 
@@ -2371,66 +5151,58 @@ device_recurse (MduPool *pool, MduDevice *device, GList **ret, guint depth)
         insert_after = FALSE;
 
         if (mdu_device_is_partition (device)) {
-                const gchar *partition_table_object_path;
+                guint partition_table_handle;
                 MduDevice *partition_table;
 
-                partition_table_object_path = mdu_device_partition_get_slave (device);
-                partition_table = mdu_pool_get_by_object_path (pool, partition_table_object_path);
+                partition_table_handle = _mdu_device_partition_get_slave_handle (device);
+                partition_table = lookup_device (pool, partition_table_handle);
 
                 /* we want the partition table to come before any partition */
                 if (partition_table != NULL)
-                        device_recurse (pool, partition_table, ret, depth + 1);
+                        device_recurse (pool, partition_table, ret, visited, depth + 1);
 
                 if (g_strcmp0 (mdu_device_partition_get_scheme (device), "mbr") == 0 &&
                     mdu_device_partition_get_number (device) >= 5) {
                         MduDevice *extended_partition;
 
                         /* logical MSDOS partition, ensure that the extended partition comes before us */
-                        extended_partition = find_extended_partition (pool, partition_table_object_path);
+                        extended_partition = find_extended_partition (pool, partition_table_handle);
                         if (extended_partition != NULL) {
-                                device_recurse (pool, extended_partition, ret, depth + 1);
+                                device_recurse (pool, extended_partition, ret, visited, depth + 1);
                         }
                 }
-
-                if (partition_table != NULL)
-                        g_object_unref (partition_table);
         }
 
         if (mdu_device_is_luks_cleartext (device)) {
-                const gchar *luks_device_object_path;
                 MduDevice *luks_device;
 
-                luks_device_object_path = mdu_device_luks_cleartext_get_slave (device);
-                luks_device = mdu_pool_get_by_object_path (pool, luks_device_object_path);
+                luks_device = lookup_device (pool, _mdu_device_luks_cleartext_get_slave_handle (device));
 
                 /* the LUKS device must be before the cleartext device */
-                if (luks_device != NULL) {
-                        device_recurse (pool, luks_device, ret, depth + 1);
-                        g_object_unref (luks_device);
-                }
+                if (luks_device != NULL)
+                        device_recurse (pool, luks_device, ret, visited, depth + 1);
         }
 
         if (mdu_device_is_linux_md (device)) {
-                gchar **slaves;
+                const guint *slaves;
                 guint n;
 
                 /* Linux-MD slaves must come *after* the array itself */
                 insert_after = TRUE;
 
-                slaves = mdu_device_linux_md_get_slaves (device);
-                for (n = 0; slaves != NULL && slaves[n] != NULL; n++) {
+                slaves = _mdu_device_linux_md_get_slave_handles (device);
+                for (n = 0; slaves != NULL && slaves[n] != 0; n++) {
                         MduDevice *slave;
 
-                        slave = mdu_pool_get_by_object_path (pool, slaves[n]);
-                        if (slave != NULL) {
-                                device_recurse (pool, slave, ret, depth + 1);
-                                g_object_unref (slave);
-                        }
+                        slave = lookup_device (pool, slaves[n]);
+                        if (slave != NULL)
+                                device_recurse (pool, slave, ret, visited, depth + 1);
                 }
 
         }
 
-        if (!g_list_find (*ret, device)) {
+        if (g_hash_table_lookup (visited, device) == NULL) {
+                g_hash_table_insert (visited, device, device);
                 if (insert_after)
                         *ret = g_list_append (*ret, device);
                 else
@@ -2455,21 +5227,24 @@ mdu_pool_get_devices (MduPool *pool)
         GList *list;
         GList *ret;
         GList *l;
+        GHashTable *visited;
 
         g_assert (pool != NULL);
 
         ret = NULL;
 
-        list = g_hash_table_get_values (pool->priv->object_path_to_device);
+        list = g_hash_table_get_values (pool->priv->handle_to_device);
+        visited = g_hash_table_new (g_direct_hash, g_direct_equal);
 
         for (l = list; l != NULL; l = l->next) {
                 MduDevice *device = MDU_DEVICE (l->data);
 
-                device_recurse (pool, device, &ret, 0);
+                device_recurse (pool, device, &ret, visited, 0);
         }
 
         g_assert (g_list_length (ret) == g_list_length (list));
 
+        g_hash_table_unref (visited);
         g_list_free (list);
 
         g_list_foreach (ret, (GFunc) g_object_ref, NULL);
@@ -2497,7 +5272,7 @@ mdu_pool_get_adapters (MduPool *pool)
 
         ret = NULL;
 
-        ret = g_hash_table_get_values (pool->priv->object_path_to_adapter);
+        ret = g_hash_table_get_values (pool->priv->handle_to_adapter);
         g_list_foreach (ret, (GFunc) g_object_ref, NULL);
         return ret;
 }
@@ -2520,7 +5295,7 @@ mdu_pool_get_expanders (MduPool *pool)
 
         ret = NULL;
 
-        ret = g_hash_table_get_values (pool->priv->object_path_to_expander);
+        ret = g_hash_table_get_values (pool->priv->handle_to_expander);
         g_list_foreach (ret, (GFunc) g_object_ref, NULL);
         return ret;
 }
@@ -2543,7 +5318,7 @@ mdu_pool_get_ports (MduPool *pool)
 
         ret = NULL;
 
-        ret = g_hash_table_get_values (pool->priv->object_path_to_port);
+        ret = g_hash_table_get_values (pool->priv->handle_to_port);
         g_list_foreach (ret, (GFunc) g_object_ref, NULL);
         return ret;
 }
@@ -2619,7 +5394,7 @@ mdu_pool_get_volume_by_device (MduPool *pool, MduDevice *device)
         for (l = pool->priv->presentables; l != NULL; l = l->next) {
                 MduPresentable *p = MDU_PRESENTABLE (l->data);
                 MduDevice *d;
-                const gchar *object_path;
+                guint handle;
 
                 if (!MDU_IS_VOLUME (p))
                         continue;
@@ -2628,10 +5403,10 @@ mdu_pool_get_volume_by_device (MduPool *pool, MduDevice *device)
                 if (d == NULL)
                         continue;
 
-                object_path = mdu_device_get_object_path (d);
+                handle = _mdu_device_get_handle (d);
                 g_object_unref (d);
 
-                if (g_strcmp0 (object_path, mdu_device_get_object_path (device)) == 0) {
+                if (handle == _mdu_device_get_handle (device)) {
                         ret = g_object_ref (p);
                         goto out;
                 }
@@ -2666,7 +5441,7 @@ mdu_pool_get_drive_by_device (MduPool *pool, MduDevice *device)
         for (l = pool->priv->presentables; l != NULL; l = l->next) {
                 MduPresentable *p = MDU_PRESENTABLE (l->data);
                 MduDevice *d;
-                const gchar *object_path;
+                guint handle;
 
                 if (!MDU_IS_DRIVE (p))
                         continue;
@@ -2675,10 +5450,10 @@ mdu_pool_get_drive_by_device (MduPool *pool, MduDevice *device)
                 if (d == NULL)
                         continue;
 
-                object_path = mdu_device_get_object_path (d);
+                handle = _mdu_device_get_handle (d);
                 g_object_unref (d);
 
-                if (g_strcmp0 (object_path, mdu_device_get_object_path (device)) == 0) {
+                if (handle == _mdu_device_get_handle (device)) {
                         ret = g_object_ref (p);
                         goto out;
                 }
@@ -2760,12 +5535,16 @@ mdu_pool_get_hub_by_object_path (MduPool *pool, const gchar *object_path)
 {
         MduPresentable *ret;
         GList *l;
+        guint handle;
 
         g_assert (pool != NULL);
 
         /* TODO: use lookaside hash table */
 
         ret = NULL;
+        handle = lookup_handle (pool, object_path);
+        if (handle == 0)
+                goto out;
         for (l = pool->priv->presentables; l != NULL && ret == NULL; l = l->next) {
                 MduPresentable *p = MDU_PRESENTABLE (l->data);
                 MduAdapter *a;
@@ -2777,9 +5556,9 @@ mdu_pool_get_hub_by_object_path (MduPool *pool, const gchar *object_path)
                 a = mdu_hub_get_adapter (MDU_HUB (p));
                 e = mdu_hub_get_expander (MDU_HUB (p));
 
-                if (a != NULL && g_strcmp0 (mdu_adapter_get_object_path (a), object_path) == 0) {
+                if (a != NULL && _mdu_adapter_get_handle (a) == handle) {
                         ret = g_object_ref (p);
-                } else if (e != NULL && g_strcmp0 (mdu_expander_get_object_path (e), object_path) == 0) {
+                } else if (e != NULL && _mdu_expander_get_handle (e) == handle) {
                         ret = g_object_ref (p);
                 }
 
@@ -2789,6 +5568,7 @@ mdu_pool_get_hub_by_object_path (MduPool *pool, const gchar *object_path)
                         g_object_unref (e);
         }
 
+ out:
         return ret;
 }
 
@@ -2798,12 +5578,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxMdStartCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxMdStartData;
 
 static void
 op_linux_md_start_cb (DBusGProxy *proxy, char *assembled_array_object_path, GError *error, gpointer user_data)
 {
         LinuxMdStartData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, assembled_array_object_path, error, data->user_data);
@@ -2838,6 +5620,7 @@ mdu_pool_op_linux_md_start (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_md_start_async (pool->priv->proxy,
                                                      component_objpaths,
                                                      (const char **) options,
@@ -2851,12 +5634,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxMdCreateCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxMdCreateData;
 
 static void
 op_linux_md_create_cb (DBusGProxy *proxy, char *assembled_array_object_path, GError *error, gpointer user_data)
 {
         LinuxMdCreateData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, assembled_array_object_path, error, data->user_data);
@@ -2896,6 +5681,7 @@ mdu_pool_op_linux_md_create (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_md_create_async (pool->priv->proxy,
                                                       component_objpaths,
                                                       level,
@@ -2912,12 +5698,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2VGStartCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2VGStartData;
 
 static void
 op_linux_lvm2_vg_start_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2VGStartData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -2943,6 +5731,7 @@ mdu_pool_op_linux_lvm2_vg_start (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_vg_start_async (pool->priv->proxy,
                                                           uuid,
                                                           (const char **) options,
@@ -2957,12 +5746,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2VGStopCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2VGStopData;
 
 static void
 op_linux_lvm2_vg_stop_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2VGStopData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -2988,6 +5779,7 @@ mdu_pool_op_linux_lvm2_vg_stop (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_vg_stop_async (pool->priv->proxy,
                                                           uuid,
                                                           (const char **) options,
@@ -3001,12 +5793,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2LVStartCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2LVStartData;
 
 static void
 op_linux_lvm2_lv_start_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2LVStartData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -3033,6 +5827,7 @@ mdu_pool_op_linux_lvm2_lv_start (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_lv_start_async (pool->priv->proxy,
                                                           group_uuid,
                                                           uuid,
@@ -3048,12 +5843,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2VGSetNameCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2VGSetNameData;
 
 static void
 op_linux_lvm2_vg_set_name_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2VGSetNameData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -3077,6 +5874,7 @@ mdu_pool_op_linux_lvm2_vg_set_name (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_vg_set_name_async (pool->priv->proxy,
                                                              uuid,
                                                              new_name,
@@ -3090,12 +5888,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2LVSetNameCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2LVSetNameData;
 
 static void
 op_linux_lvm2_lv_set_name_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2LVSetNameData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -3120,6 +5920,7 @@ mdu_pool_op_linux_lvm2_lv_set_name (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_lv_set_name_async (pool->priv->proxy,
                                                              group_uuid,
                                                              uuid,
@@ -3134,12 +5935,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2LVRemoveCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2LVRemoveData;
 
 static void
 op_linux_lvm2_lv_remove_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2LVRemoveData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -3166,6 +5969,7 @@ mdu_pool_op_linux_lvm2_lv_remove (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_lv_remove_async (pool->priv->proxy,
                                                            group_uuid,
                                                            uuid,
@@ -3180,6 +5984,7 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2LVCreateCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2LVCreateData;
 
 static void
@@ -3189,6 +5994,7 @@ op_linux_lvm2_lv_create_cb (DBusGProxy *proxy,
                             gpointer user_data)
 {
         LinuxLvm2LVCreateData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, create_logical_volume_object_path, error, data->user_data);
@@ -3238,6 +6044,7 @@ mdu_pool_op_linux_lvm2_lv_create (MduPool *pool,
         }
         fsoptions[n] = NULL;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_lv_create_async (pool->priv->proxy,
                                                            group_uuid,
                                                            name,
@@ -3258,12 +6065,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2VGAddPVCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2VGAddPVData;
 
 static void
 op_linux_lvm2_vg_add_pv_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2VGAddPVData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -3290,6 +6099,7 @@ mdu_pool_op_linux_lvm2_vg_add_pv (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_vg_add_pv_async (pool->priv->proxy,
                                                            uuid,
                                                            physical_volume_object_path,
@@ -3304,12 +6114,14 @@ typedef struct {
         MduPool *pool;
         MduPoolLinuxLvm2VGRemovePVCompletedFunc callback;
         gpointer user_data;
+        gdouble begin_time;
 } LinuxLvm2VGRemovePVData;
 
 static void
 op_linux_lvm2_vg_remove_pv_cb (DBusGProxy *proxy, GError *error, gpointer user_data)
 {
         LinuxLvm2VGRemovePVData *data = user_data;
+        _mdu_pool_stats_end_call (data->pool, data->begin_time, FALSE);
         _mdu_error_fixup (error);
         if (data->callback != NULL)
                 data->callback (data->pool, error, data->user_data);
@@ -3336,6 +6148,7 @@ mdu_pool_op_linux_lvm2_vg_remove_pv (MduPool *pool,
         data->callback = callback;
         data->user_data = user_data;
 
+        data->begin_time = _mdu_pool_stats_begin_call (pool);
         org_freedesktop_UDisks_linux_lvm2_vg_remove_pv_async (pool->priv->proxy,
                                                               vg_uuid,
                                                               pv_uuid,
@@ -3383,6 +6196,11 @@ mdu_pool_is_daemon_inhibited (MduPool *pool)
 
         ret = TRUE;
 
+        if (pool->priv->is_offline) {
+                ret = FALSE;
+                goto out_offline;
+        }
+
 	prop_proxy = dbus_g_proxy_new_for_name (pool->priv->bus,
                                                 "org.freedesktop.UDisks",
                                                 "/org/freedesktop/UDisks",
@@ -3409,6 +6227,7 @@ mdu_pool_is_daemon_inhibited (MduPool *pool)
 
  out:
         g_object_unref (prop_proxy);
+ out_offline:
         return ret;
 }
 
@@ -3504,10 +6323,10 @@ remove_all_objects_and_dbus_proxies (MduPool *pool)
         g_list_free (pool->priv->known_filesystems);
         pool->priv->known_filesystems = NULL;
 
-        g_hash_table_remove_all (pool->priv->object_path_to_device);
-        g_hash_table_remove_all (pool->priv->object_path_to_adapter);
-        g_hash_table_remove_all (pool->priv->object_path_to_expander);
-        g_hash_table_remove_all (pool->priv->object_path_to_port);
+        g_hash_table_remove_all (pool->priv->handle_to_device);
+        g_hash_table_remove_all (pool->priv->handle_to_adapter);
+        g_hash_table_remove_all (pool->priv->handle_to_expander);
+        g_hash_table_remove_all (pool->priv->handle_to_port);
 
         g_list_foreach (pool->priv->presentables, (GFunc) g_object_unref, NULL);
         g_list_free (pool->priv->presentables);
@@ -3518,10 +6337,7 @@ remove_all_objects_and_dbus_proxies (MduPool *pool)
                 pool->priv->proxy = NULL;
         }
 
-        if (pool->priv->bus != NULL) {
-                dbus_g_connection_unref (pool->priv->bus);
-                pool->priv->bus = NULL;
-        }
+        pool_unref_bus (pool);
 }
 
 static void
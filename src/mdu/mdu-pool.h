@@ -40,6 +40,7 @@ G_BEGIN_DECLS
 
 typedef struct _MduPoolClass       MduPoolClass;
 typedef struct _MduPoolPrivate     MduPoolPrivate;
+typedef struct _MduPoolStats       MduPoolStats;
 
 struct _MduPool
 {
@@ -77,6 +78,58 @@ struct _MduPoolClass
         void (*presentable_removed) (MduPool *pool, MduPresentable *presentable);
         void (*presentable_changed) (MduPool *pool, MduPresentable *presentable);
         void (*presentable_job_changed) (MduPool *pool, MduPresentable *presentable);
+
+        void (*reconnecting) (MduPool *pool);
+        void (*reconnected) (MduPool *pool);
+};
+
+/**
+ * MduPoolConnectFlags:
+ * @MDU_POOL_CONNECT_FLAGS_NONE: No flags set.
+ * @MDU_POOL_CONNECT_FLAGS_COMPRESS: Compress the traffic to the remote host. This
+ *   reduces the time to get the initial set of objects over slow links.
+ *
+ * Flags used when connecting to a remote host, see mdu_pool_new_for_address_async().
+ */
+typedef enum {
+        MDU_POOL_CONNECT_FLAGS_NONE = 0x00,
+        MDU_POOL_CONNECT_FLAGS_COMPRESS = (1<<0)
+} MduPoolConnectFlags;
+
+/**
+ * MDU_POOL_STATS_NUM_RTT_BUCKETS:
+ *
+ * Number of buckets in the round-trip time histogram of #MduPoolStats.
+ */
+#define MDU_POOL_STATS_NUM_RTT_BUCKETS 16
+
+/**
+ * MduPoolStats:
+ * @bytes_received: Bytes of D-Bus traffic received from the daemon. Only available for remote pools.
+ * @bytes_sent: Bytes of D-Bus traffic sent to the daemon. Only available for remote pools.
+ * @messages_received: Number of messages (replies and signals) received from the daemon.
+ * @messages_sent: Number of method calls sent to the daemon.
+ * @num_calls: Number of method calls the pool made to the daemon and waited for.
+ * @rtt_histogram: Round-trip times of the calls in @num_calls. Bucket 0
+ *   counts calls faster than 1 ms and bucket n counts calls taking between
+ *   2^(n-1) and 2^n ms. The last bucket also counts all slower calls.
+ * @blocked_secs: Time, in seconds, the pool blocked waiting for the daemon.
+ * @elapsed_secs: Time, in seconds, since the pool was created.
+ *
+ * Traffic statistics for a #MduPool, see mdu_pool_get_stats(). All
+ * counters are totals since the pool was created, including traffic
+ * sent over earlier connections of a pool that reconnected.
+ */
+struct _MduPoolStats
+{
+        guint64 bytes_received;
+        guint64 bytes_sent;
+        guint64 messages_received;
+        guint64 messages_sent;
+        guint64 num_calls;
+        guint64 rtt_histogram[MDU_POOL_STATS_NUM_RTT_BUCKETS];
+        gdouble blocked_secs;
+        gdouble elapsed_secs;
 };
 
 GType       mdu_pool_get_type           (void);
@@ -84,9 +137,25 @@ MduPool    *mdu_pool_new                (void);
 MduPool    *mdu_pool_new_for_address    (const gchar  *ssh_user_name,
                                          const gchar  *ssh_address,
                                          GError      **error);
+void        mdu_pool_new_for_address_async  (const gchar          *ssh_user_name,
+                                             const gchar          *ssh_address,
+                                             MduPoolConnectFlags   flags,
+                                             GCancellable         *cancellable,
+                                             GAsyncReadyCallback   callback,
+                                             gpointer              user_data);
+MduPool    *mdu_pool_new_for_address_finish (GAsyncResult         *res,
+                                             GError              **error);
+MduPool    *mdu_pool_new_for_device_file (const gchar  *device_file,
+                                          GError      **error);
 
 const gchar *mdu_pool_get_ssh_user_name (MduPool *pool);
 const gchar *mdu_pool_get_ssh_address   (MduPool *pool);
+gboolean     mdu_pool_is_reconnecting   (MduPool *pool);
+
+void         mdu_pool_get_stats                (MduPool            *pool,
+                                                MduPoolStats       *out_stats);
+gdouble      mdu_pool_stats_get_rtt_percentile (const MduPoolStats *stats,
+                                                gdouble             percentile);
 
 char       *mdu_pool_get_daemon_version (MduPool *pool);
 gboolean    mdu_pool_is_daemon_inhibited (MduPool *pool);
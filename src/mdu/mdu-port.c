@@ -51,6 +51,9 @@ typedef struct
         gchar *parent;
         gint number;
         gchar *connector_type;
+
+        guint adapter_handle;
+        guint parent_handle;
 } PortProperties;
 
 static void
@@ -87,31 +90,19 @@ port_properties_free (PortProperties *props)
 }
 
 static PortProperties *
-port_properties_get (DBusGConnection *bus,
+port_properties_get (MduPool *pool,
                      const char *object_path)
 {
         PortProperties *props;
         GError *error;
         GHashTable *hash_table;
-        DBusGProxy *prop_proxy;
         const char *ifname = "org.freedesktop.UDisks.Port";
 
         props = g_new0 (PortProperties, 1);
 
-	prop_proxy = dbus_g_proxy_new_for_name (bus,
-                                                "org.freedesktop.UDisks",
-                                                object_path,
-                                                "org.freedesktop.DBus.Properties");
         error = NULL;
-        if (!dbus_g_proxy_call (prop_proxy,
-                                "GetAll",
-                                &error,
-                                G_TYPE_STRING,
-                                ifname,
-                                G_TYPE_INVALID,
-                                dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE),
-                                &hash_table,
-                                G_TYPE_INVALID)) {
+        hash_table = _mdu_pool_get_all_properties (pool, object_path, ifname, &error);
+        if (hash_table == NULL) {
                 g_warning ("Couldn't call GetAll() to get properties for %s: %s", object_path, error->message);
                 g_error_free (error);
 
@@ -124,6 +115,9 @@ port_properties_get (DBusGConnection *bus,
 
         g_hash_table_unref (hash_table);
 
+        props->adapter_handle = _mdu_pool_intern_object_path (pool, props->adapter);
+        props->parent_handle = _mdu_pool_intern_object_path (pool, props->parent);
+
 #if 0
         g_print ("----------------------------------------------------------------------\n");
         g_print ("native_path:    %s\n", props->native_path);
@@ -134,7 +128,6 @@ port_properties_get (DBusGConnection *bus,
 #endif
 
 out:
-        g_object_unref (prop_proxy);
         return props;
 }
 
@@ -146,6 +139,7 @@ struct _MduPortPrivate
         MduPool *pool;
 
         char *object_path;
+        guint handle;
 
         PortProperties *props;
 };
@@ -225,7 +219,7 @@ update_info (MduPort *port)
 {
         PortProperties *new_properties;
 
-        new_properties = port_properties_get (_mdu_pool_get_connection (port->priv->pool),
+        new_properties = port_properties_get (port->priv->pool,
                                               port->priv->object_path);
         if (new_properties != NULL) {
                 if (port->priv->props != NULL)
@@ -238,6 +232,20 @@ update_info (MduPort *port)
 }
 
 
+static void
+create_proxy (MduPort *port)
+{
+        /* offline pools have no connection, see _mdu_pool_new_offline() */
+        if (_mdu_pool_get_connection (port->priv->pool) != NULL) {
+                port->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (port->priv->pool),
+                                                               "org.freedesktop.UDisks",
+                                                               port->priv->object_path,
+                                                               "org.freedesktop.UDisks.Port");
+                dbus_g_proxy_set_default_timeout (port->priv->proxy, INT_MAX);
+                dbus_g_proxy_add_signal (port->priv->proxy, "Changed", G_TYPE_INVALID);
+        }
+}
+
 MduPort *
 _mdu_port_new_from_object_path (MduPool *pool, const char *object_path)
 {
@@ -246,13 +254,9 @@ _mdu_port_new_from_object_path (MduPool *pool, const char *object_path)
         port = MDU_PORT (g_object_new (MDU_TYPE_PORT, NULL));
         port->priv->object_path = g_strdup (object_path);
         port->priv->pool = g_object_ref (pool);
+        port->priv->handle = _mdu_pool_intern_object_path (pool, object_path);
 
-	port->priv->proxy = dbus_g_proxy_new_for_name (_mdu_pool_get_connection (port->priv->pool),
-                                                       "org.freedesktop.UDisks",
-                                                       port->priv->object_path,
-                                                       "org.freedesktop.UDisks.Port");
-        dbus_g_proxy_set_default_timeout (port->priv->proxy, INT_MAX);
-        dbus_g_proxy_add_signal (port->priv->proxy, "Changed", G_TYPE_INVALID);
+        create_proxy (port);
 
         /* TODO: connect signals */
 
@@ -279,12 +283,29 @@ _mdu_port_changed (MduPort *port)
         }
 }
 
+/* Called by the pool when it has reconnected to the daemon, see pool_handle_connection_lost() */
+void
+_mdu_port_rebind_proxy (MduPort *port)
+{
+        if (port->priv->proxy != NULL) {
+                g_object_unref (port->priv->proxy);
+                port->priv->proxy = NULL;
+        }
+        create_proxy (port);
+}
+
 const gchar *
 mdu_port_get_object_path (MduPort *port)
 {
         return port->priv->object_path;
 }
 
+guint
+_mdu_port_get_handle (MduPort *port)
+{
+        return port->priv->handle;
+}
+
 
 const gchar *
 mdu_port_get_native_path (MduPort *port)
@@ -304,6 +325,18 @@ mdu_port_get_parent (MduPort *port)
         return port->priv->props->parent;
 }
 
+guint
+_mdu_port_get_adapter_handle (MduPort *port)
+{
+        return port->priv->props->adapter_handle;
+}
+
+guint
+_mdu_port_get_parent_handle (MduPort *port)
+{
+        return port->priv->props->parent_handle;
+}
+
 gint
 mdu_port_get_number (MduPort *port)
 {
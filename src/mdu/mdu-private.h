@@ -76,6 +76,53 @@
                                                      G_TYPE_INVALID))
 
 DBusGConnection *_mdu_pool_get_connection (MduPool *pool);
+GHashTable      *_mdu_pool_get_all_properties (MduPool      *pool,
+                                               const gchar  *object_path,
+                                               const gchar  *interface_name,
+                                               GError      **error);
+void             _mdu_pool_prefetch_properties (MduPool             *pool,
+                                                const gchar * const *object_paths,
+                                                guint                num_object_paths,
+                                                const gchar         *interface_name);
+gdouble          _mdu_pool_stats_begin_call   (MduPool      *pool);
+void             _mdu_pool_stats_end_call     (MduPool      *pool,
+                                               gdouble       begin_time,
+                                               gboolean      blocked);
+MduPool         *_mdu_pool_new_for_connection (DBusGConnection  *bus,
+                                               GError          **error);
+void             _mdu_pool_free               (MduPool          *pool);
+void             _mdu_pool_set_batch_signals  (MduPool          *pool,
+                                               gboolean          batch_signals);
+void             _mdu_pool_emit_object_signal (MduPool          *pool,
+                                               const gchar      *signal_name,
+                                               const gchar      *object_path);
+guint            _mdu_pool_get_num_signal_batches (MduPool      *pool);
+
+MduPool  *_mdu_pool_new_offline            (void);
+gboolean  _mdu_pool_is_offline             (MduPool     *pool);
+void      _mdu_pool_offline_set_object     (MduPool     *pool,
+                                            const gchar *object_path,
+                                            const gchar *interface_name,
+                                            GHashTable  *properties);
+void      _mdu_pool_offline_prime          (MduPool     *pool);
+void      _mdu_pool_offline_dispatch_signal (MduPool     *pool,
+                                             const gchar *member,
+                                             const gchar *object_path);
+void      _mdu_pool_offline_dispatch_job_changed (MduPool     *pool,
+                                                  const gchar *object_path,
+                                                  gboolean     job_in_progress,
+                                                  const gchar *job_id,
+                                                  uid_t        job_initiated_by_uid,
+                                                  gboolean     job_is_cancellable,
+                                                  gdouble      job_percentage);
+void      _mdu_pool_recompute_presentables (MduPool     *pool);
+GList    *_mdu_pool_get_holes_for_drive    (MduPool     *pool,
+                                            GList       *devices,
+                                            MduDrive    *drive);
+guint        _mdu_pool_intern_object_path         (MduPool     *pool,
+                                                   const gchar *object_path);
+const gchar *_mdu_pool_get_object_path_for_handle (MduPool     *pool,
+                                                   guint        handle);
 
 MduKnownFilesystem    *_mdu_known_filesystem_new       (gpointer data);
 
@@ -84,6 +131,11 @@ MduProcess            * _mdu_process_new               (gpointer data);
 void _mdu_error_fixup (GError *error);
 
 MduDevice  *_mdu_device_new_from_object_path  (MduPool     *pool, const char  *object_path);
+guint        _mdu_device_get_handle                      (MduDevice *device);
+guint        _mdu_device_partition_get_slave_handle      (MduDevice *device);
+guint        _mdu_device_luks_cleartext_get_slave_handle (MduDevice *device);
+guint        _mdu_device_drive_get_port_handle           (MduDevice *device);
+const guint *_mdu_device_linux_md_get_slave_handles      (MduDevice *device);
 
 MduVolume   *_mdu_volume_new_from_device      (MduPool *pool, MduDevice *volume, MduPresentable *enclosing_presentable);
 MduDrive    *_mdu_drive_new_from_device       (MduPool *pool, MduDevice *drive, MduPresentable *enclosing_presentable);
@@ -100,6 +152,7 @@ gboolean _mdu_linux_md_drive_has_uuid (MduLinuxMdDrive  *drive,
 
 
 gboolean    _mdu_device_changed               (MduDevice   *device);
+void        _mdu_device_rebind_proxy          (MduDevice   *device);
 void        _mdu_device_job_changed           (MduDevice   *device,
                                                gboolean     job_in_progress,
                                                const char  *job_id,
@@ -109,9 +162,14 @@ void        _mdu_device_job_changed           (MduDevice   *device,
 
 MduAdapter *_mdu_adapter_new_from_object_path (MduPool *pool, const char *object_path);
 gboolean    _mdu_adapter_changed              (MduAdapter   *adapter);
+void        _mdu_adapter_rebind_proxy         (MduAdapter   *adapter);
+guint       _mdu_adapter_get_handle           (MduAdapter   *adapter);
 
 MduExpander *_mdu_expander_new_from_object_path (MduPool *pool, const char *object_path);
 gboolean    _mdu_expander_changed               (MduExpander   *expander);
+void        _mdu_expander_rebind_proxy          (MduExpander   *expander);
+guint       _mdu_expander_get_handle            (MduExpander   *expander);
+guint       _mdu_expander_get_upstream_port_handle (MduExpander *expander);
 
 MduHub     *_mdu_hub_new                        (MduPool        *pool,
                                                  MduHubUsage     usage,
@@ -124,6 +182,10 @@ MduHub     *_mdu_hub_new                        (MduPool        *pool,
 
 MduPort    *_mdu_port_new_from_object_path (MduPool *pool, const char *object_path);
 gboolean    _mdu_port_changed               (MduPort   *port);
+void        _mdu_port_rebind_proxy          (MduPort   *port);
+guint       _mdu_port_get_handle            (MduPort   *port);
+guint       _mdu_port_get_adapter_handle    (MduPort   *port);
+guint       _mdu_port_get_parent_handle     (MduPort   *port);
 
 MduMachine *_mdu_machine_new (MduPool *pool);
 
@@ -0,0 +1,217 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-ssh-bridge-check.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/* Checks that connecting to a host through the ssh bridge works both
+ * when a new ssh master connection is set up and when an existing one is
+ * reused, see the comment at the top of mdu-ssh-bridge.c, e.g.
+ *
+ *   mdu-ssh-bridge-check --user=root storage.example.com
+ *
+ * The host is connected to, the connection is released and the host is
+ * connected to again while the master connection is still alive. Each
+ * time the udisks daemon is asked for its version over the bridge. The
+ * remote host needs udisks-tcp-bridge and authentication must work
+ * without a password prompt, e.g. through ssh-agent.
+ *
+ * The exit status is 0 if both connections worked and 1 otherwise.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <unistd.h>
+#include <sys/wait.h>
+#include <dbus/dbus-glib.h>
+
+#include "mdu-ssh-bridge.h"
+
+static gchar *opt_user = NULL;
+static gboolean opt_compress = FALSE;
+static gchar **opt_hosts = NULL;
+
+static GOptionEntry entries[] = {
+        { "user", 'u', 0, G_OPTION_ARG_STRING, &opt_user, "User to connect as (default: current user)", "NAME" },
+        { "compress", 'z', 0, G_OPTION_ARG_NONE, &opt_compress, "Have ssh compress the traffic", NULL },
+        { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &opt_hosts, NULL, "HOST" },
+        { NULL }
+};
+
+/* asks the udisks daemon on the other end of @connection for its version */
+static gboolean
+check_connection (DBusGConnection  *connection,
+                  GError          **error)
+{
+        DBusGProxy *prop_proxy;
+        GValue value = {0};
+        gboolean ret;
+
+        prop_proxy = dbus_g_proxy_new_for_name (connection,
+                                                "org.freedesktop.UDisks",
+                                                "/org/freedesktop/UDisks",
+                                                "org.freedesktop.DBus.Properties");
+        ret = dbus_g_proxy_call (prop_proxy,
+                                 "Get",
+                                 error,
+                                 G_TYPE_STRING,
+                                 "org.freedesktop.UDisks",
+                                 G_TYPE_STRING,
+                                 "DaemonVersion",
+                                 G_TYPE_INVALID,
+                                 G_TYPE_VALUE,
+                                 &value,
+                                 G_TYPE_INVALID);
+        if (ret) {
+                g_print ("  udisks daemon version %s\n",
+                         G_VALUE_HOLDS_STRING (&value) ? g_value_get_string (&value) : "(unknown)");
+                g_value_unset (&value);
+        }
+        g_object_unref (prop_proxy);
+
+        return ret;
+}
+
+/* Whether ssh has a master connection to @host, using the same control
+ * path as bridge_spawn_async()
+ */
+static gboolean
+has_master_connection (const gchar *host)
+{
+        gchar *argv[7];
+        gchar *destination;
+        gint exit_status;
+        gboolean ret;
+
+        if (opt_user != NULL)
+                destination = g_strdup_printf ("%s@%s", opt_user, host);
+        else
+                destination = g_strdup (host);
+
+        argv[0] = "ssh";
+        argv[1] = "-o";
+        argv[2] = g_strdup_printf ("ControlPath=%s/mdu-ssh-%d/%%r@%%h:%%p%s",
+                                   g_get_tmp_dir (),
+                                   (gint) getuid (),
+                                   opt_compress ? "-z" : "");
+        argv[3] = "-O";
+        argv[4] = "check";
+        argv[5] = destination;
+        argv[6] = NULL;
+
+        ret = FALSE;
+        if (g_spawn_sync (NULL,
+                          argv,
+                          NULL,
+                          G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+                          NULL,
+                          NULL,
+                          NULL,
+                          NULL,
+                          &exit_status,
+                          NULL))
+                ret = WIFEXITED (exit_status) && WEXITSTATUS (exit_status) == 0;
+
+        g_free (argv[2]);
+        g_free (destination);
+        return ret;
+}
+
+static gboolean
+connect_and_check (const gchar *host,
+                   const gchar *what)
+{
+        DBusGConnection *connection;
+        GError *error;
+        GTimer *timer;
+        gboolean ret;
+
+        ret = FALSE;
+        timer = g_timer_new ();
+
+        g_print ("%s: connecting (%s)\n", host, what);
+        error = NULL;
+        connection = _mdu_ssh_bridge_connect (opt_user, host, opt_compress, &error);
+        if (connection == NULL) {
+                g_printerr ("%s: error connecting: %s\n", host, error->message);
+                g_error_free (error);
+                goto out;
+        }
+        g_print ("  connected in %.2f s\n", g_timer_elapsed (timer, NULL));
+
+        if (!check_connection (connection, &error)) {
+                g_printerr ("%s: error talking to the udisks daemon: %s\n", host, error->message);
+                g_error_free (error);
+        } else {
+                ret = TRUE;
+        }
+
+        _mdu_ssh_bridge_release (connection);
+
+ out:
+        g_timer_destroy (timer);
+        return ret;
+}
+
+int
+main (int argc, char *argv[])
+{
+        GOptionContext *context;
+        GError *error;
+        const gchar *host;
+        gint ret;
+
+        ret = 1;
+
+        g_type_init ();
+
+        context = g_option_context_new ("- check connecting to a host through the ssh bridge");
+        g_option_context_add_main_entries (context, entries, NULL);
+        error = NULL;
+        if (!g_option_context_parse (context, &argc, &argv, &error)) {
+                g_printerr ("Could not parse arguments: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+        if (opt_hosts == NULL || opt_hosts[0] == NULL || opt_hosts[1] != NULL) {
+                g_printerr ("Exactly one host must be given\n");
+                goto out;
+        }
+        host = opt_hosts[0];
+
+        if (!connect_and_check (host, has_master_connection (host) ? "existing master" : "new master"))
+                goto out;
+
+        /* ControlPersist keeps the master around after the session ended */
+        if (!has_master_connection (host)) {
+                g_printerr ("%s: no ssh master connection after the first connection\n", host);
+                goto out;
+        }
+
+        if (!connect_and_check (host, "existing master"))
+                goto out;
+
+        ret = 0;
+
+ out:
+        g_strfreev (opt_hosts);
+        g_free (opt_user);
+        g_option_context_free (context);
+        return ret;
+}
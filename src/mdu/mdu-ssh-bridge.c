@@ -23,6 +23,7 @@
 #include <glib/gi18n-lib.h>
 
 #include <stdio.h>
+#include <errno.h>
 #include <sys/types.h>
 #include <signal.h>
 #include <sys/ioctl.h>
@@ -30,7 +31,11 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
+#include <glib/gstdio.h>
 #include <gio/gunixinputstream.h>
 #include <gio/gunixoutputstream.h>
 #include <dbus/dbus-glib-lowlevel.h>
@@ -60,30 +65,93 @@
  *  malicious users on both the Client and Server may interfere.
  */
 
-/* TODO: Need to do all this async (or in a thread) so we can have API like this
+/* All of the above is done asynchronously - the only blocking operations are listening on
+ * the local port, spawning ssh and writing a line or two to its stdin - so connections to
+ * any number of hosts can be in progress at the same time, see
+ * mdu_pool_new_for_address_async(). The synchronous _mdu_ssh_bridge_connect() is implemented
+ * on top of the async version.
+ */
+
+/* Sharing bridges
+ *
+ * All pools in a process connecting to the same host as the same user share one ssh
+ * process and one D-Bus connection - see SharedBridge. The connection is torn down when
+ * the last user calls _mdu_ssh_bridge_release(). Users find out about the ssh process
+ * going away through the org.freedesktop.DBus.Local.Disconnected signal on the connection.
+ *
+ * On top of that ssh is asked to multiplex all sessions to a host over one master
+ * connection that stays around for a minute after the last session ended, see
+ * get_control_path_dir(). This way other processes connecting to the same host, e.g.
+ * the format tool, don't have to authenticate again and the udisks-tcp-bridge program
+ * is started over an already established connection.
  *
- *   void mdu_pool_new_for_address            (const gchar         *ssh_user_name,
- *                                             const gchar         *ssh_address,
- *                                             GMountOperation     *connect_operation,
- *                                             GCancellable        *cancellable,
- *                                             GAsyncReadyCallback  callback,
- *                                             gpointer             user_data);
+ * When multiplexing, the session is started without -R. A session attached to an
+ * existing master doesn't report the allocated port on stderr, and forwards set up
+ * through the master outlive the session. Instead, once the session is up (see
+ * CONNECTED_MARKER), the forward is requested from the master with
  *
- *   MduPool *mdu_pool_new_for_address_finish (GAsyncResult        *res,
- *                                             GError             **error);
+ *   ssh -O forward -R 0:localhost:LOCAL_PORT
  *
- * on the MduPool object. Also, we won't initially use the @connect_operation parameter for
- * now - but can do if (or once) we supply our own program to use in $SSH_ASKPASS.
+ * which prints REMOTE_PORT on stdout, and it is cancelled with -O cancel when the
+ * session goes away, see RemoteForward.
  */
 
+/* echoed to stderr by the remote shell once a multiplexed session is up */
+#define CONNECTED_MARKER "mdu-ssh-bridge: Connected"
+
+typedef enum {
+        BRIDGE_STATE_WAITING_FOR_PORT,
+        BRIDGE_STATE_WAITING_FOR_FORWARD,
+        BRIDGE_STATE_WAITING_FOR_BRIDGE,
+        BRIDGE_STATE_WAITING_FOR_CONNECT,
+        BRIDGE_STATE_WAITING_FOR_AUTHORIZATION,
+        BRIDGE_STATE_COLLECTING_ERROR,
+        BRIDGE_STATE_DONE
+} BridgeState;
+
+/* a forward requested from an ssh master connection */
+typedef struct {
+        gchar *control_path;
+        /* [user@]host, for ssh to find the master */
+        gchar *destination;
+        gint local_port;
+        /* 0 until the master allocated a port */
+        gint remote_port;
+} RemoteForward;
+
+typedef struct {
+        DBusGConnection *connection;
+        GPid pid;
+        RemoteForward *forward;
+} BridgeResult;
+
 typedef struct {
         gchar *secret;
 
+        GSimpleAsyncResult *simple;
+        BridgeState state;
+
         GCancellable *cancellable;
-        GMainLoop *loop;
+        gulong cancelled_handler_id;
+        guint cancelled_idle_id;
+
+        DBusServer *server;
         DBusConnection *server_connection;
+        gboolean authorization_done;
         gboolean authorized;
 
+        GPid ssh_pid;
+        guint kill_ssh_timeout_id;
+        GDataOutputStream *stdin_data_stream;
+        GDataInputStream *stdout_data_stream;
+        GDataInputStream *stderr_data_stream;
+        gint remote_port;
+
+        /* non-NULL if the session is multiplexed over a master connection */
+        RemoteForward *forward;
+        GDataInputStream *forward_data_stream;
+
+        GString *full_error_message;
         gchar *error_message;
 } BridgeData;
 
@@ -91,6 +159,79 @@ static DBusHandlerResult connection_filter_func (DBusConnection  *connection,
                                                  DBusMessage     *message,
                                                  void            *user_data);
 
+static void bridge_read_line (BridgeData *data);
+static void child_setup (gpointer user_data);
+
+static void
+remote_forward_free (RemoteForward *forward)
+{
+        g_free (forward->control_path);
+        g_free (forward->destination);
+        g_free (forward);
+}
+
+/* runs `ssh -O <command> -R <spec>' against the master connection of @forward */
+static gchar **
+remote_forward_get_argv (RemoteForward *forward,
+                         const gchar   *command,
+                         const gchar   *spec)
+{
+        gchar **argv;
+
+        argv = g_new0 (gchar *, 9);
+        argv[0] = g_strdup ("ssh");
+        argv[1] = g_strdup ("-o");
+        argv[2] = g_strdup_printf ("ControlPath=%s", forward->control_path);
+        argv[3] = g_strdup ("-O");
+        argv[4] = g_strdup (command);
+        argv[5] = g_strdup ("-R");
+        argv[6] = g_strdup (spec);
+        argv[7] = g_strdup (forward->destination);
+        return argv;
+}
+
+/* Asks the master to stop listening on the remote port and frees @forward. The
+ * master may be gone already in which case there is nothing to cancel.
+ */
+static void
+remote_forward_cancel (RemoteForward *forward)
+{
+        gchar **argv;
+        gchar *spec;
+        GError *error;
+
+        if (forward->remote_port == 0)
+                goto out;
+
+        spec = g_strdup_printf ("%d:localhost:%d", forward->remote_port, forward->local_port);
+        argv = remote_forward_get_argv (forward, "cancel", spec);
+        error = NULL;
+        if (!g_spawn_async (NULL,
+                            argv,
+                            NULL,
+                            G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+                            child_setup,
+                            NULL,
+                            NULL,
+                            &error)) {
+                g_warning ("Error cancelling remote forward of port %d: %s", forward->remote_port, error->message);
+                g_error_free (error);
+        }
+        g_strfreev (argv);
+        g_free (spec);
+
+ out:
+        remote_forward_free (forward);
+}
+
+static void
+on_failed_ssh_process_terminated (GPid     pid,
+                                  gint     status,
+                                  gpointer user_data)
+{
+        g_spawn_close_pid (pid);
+}
+
 static void
 bridge_data_free (BridgeData *data)
 {
@@ -98,19 +239,104 @@ bridge_data_free (BridgeData *data)
                 memset (data->secret, '\0', strlen (data->secret));
         g_free (data->secret);
         g_free (data->error_message);
-        if (data->loop != NULL)
-                g_main_loop_unref (data->loop);
+        if (data->full_error_message != NULL)
+                g_string_free (data->full_error_message, TRUE);
         if (data->server_connection != NULL) {
                 dbus_connection_remove_filter (data->server_connection,
                                                connection_filter_func,
                                                data);
                 dbus_connection_unref (data->server_connection);
         }
+        if (data->server != NULL) {
+                dbus_server_disconnect (data->server);
+                dbus_server_unref (data->server);
+        }
+        if (data->kill_ssh_timeout_id > 0)
+                g_source_remove (data->kill_ssh_timeout_id);
+        if (data->cancelled_idle_id > 0)
+                g_source_remove (data->cancelled_idle_id);
+        if (data->cancelled_handler_id > 0)
+                g_signal_handler_disconnect (data->cancellable, data->cancelled_handler_id);
         if (data->cancellable != NULL)
                 g_object_unref (data->cancellable);
+        if (data->stdin_data_stream != NULL)
+                g_object_unref (data->stdin_data_stream);
+        if (data->stdout_data_stream != NULL)
+                g_object_unref (data->stdout_data_stream);
+        if (data->stderr_data_stream != NULL)
+                g_object_unref (data->stderr_data_stream);
+        if (data->forward_data_stream != NULL)
+                g_object_unref (data->forward_data_stream);
+        if (data->forward != NULL)
+                remote_forward_free (data->forward);
+        if (data->simple != NULL)
+                g_object_unref (data->simple);
         g_free (data);
 }
 
+static void
+bridge_result_free (BridgeResult *result)
+{
+        if (result->connection != NULL)
+                dbus_g_connection_unref (result->connection);
+        if (result->forward != NULL)
+                remote_forward_cancel (result->forward);
+        g_free (result);
+}
+
+/* Completes the operation and frees @data. If @error is NULL the connection was established. */
+static void
+bridge_complete (BridgeData *data,
+                 GError     *error)
+{
+        data->state = BRIDGE_STATE_DONE;
+
+        if (error != NULL) {
+                g_simple_async_result_set_from_error (data->simple, error);
+                g_error_free (error);
+
+                /* kill ssh connection if we failed */
+                if (data->ssh_pid > 0) {
+                        kill (data->ssh_pid, SIGTERM);
+                        g_child_watch_add (data->ssh_pid, on_failed_ssh_process_terminated, NULL);
+                }
+                if (data->forward != NULL) {
+                        remote_forward_cancel (data->forward);
+                        data->forward = NULL;
+                }
+        } else {
+                BridgeResult *result;
+
+                result = g_new0 (BridgeResult, 1);
+                result->connection = dbus_connection_get_g_connection (dbus_connection_ref (data->server_connection));
+                result->pid = data->ssh_pid;
+                result->forward = data->forward;
+                data->forward = NULL;
+                g_simple_async_result_set_op_res_gpointer (data->simple,
+                                                           result,
+                                                           (GDestroyNotify) bridge_result_free);
+        }
+
+        g_simple_async_result_complete_in_idle (data->simple);
+        bridge_data_free (data);
+}
+
+static void
+bridge_finish_authorization (BridgeData *data)
+{
+        GError *error;
+
+        error = NULL;
+        if (!data->authorized) {
+                dbus_connection_close (data->server_connection);
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("The udisks-tcp-bridge program failed to prove it was authorized: %s"),
+                                     data->error_message != NULL ? data->error_message : "(no detail)");
+        }
+        bridge_complete (data, error);
+}
+
 static DBusHandlerResult
 connection_filter_func (DBusConnection  *connection,
                         DBusMessage     *message,
@@ -120,6 +346,12 @@ connection_filter_func (DBusConnection  *connection,
 
         //g_print ("Filter func!\n");
 
+        /* The bridge may connect before we've read its `Attempting to connect' line */
+        if (data->authorization_done ||
+            (data->state != BRIDGE_STATE_WAITING_FOR_CONNECT &&
+             data->state != BRIDGE_STATE_WAITING_FOR_AUTHORIZATION))
+                return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
         if (dbus_message_is_method_call (message, "org.freedesktop.UDisks.Client", "Authorize") &&
             dbus_message_has_path (message, "/org/freedesktop/UDisks/Client")) {
                 const gchar *secret;
@@ -155,7 +387,9 @@ connection_filter_func (DBusConnection  *connection,
                                                        dbus_message_get_member (message));
         }
 
-        g_main_loop_quit (data->loop);
+        data->authorization_done = TRUE;
+        if (data->state == BRIDGE_STATE_WAITING_FOR_AUTHORIZATION)
+                bridge_finish_authorization (data);
 
         return DBUS_HANDLER_RESULT_HANDLED;
 }
@@ -220,207 +454,260 @@ fixup_newlines (gchar *s)
 }
 
 
-DBusGConnection *
-_mdu_ssh_bridge_connect (const gchar      *ssh_user_name,
-                         const gchar      *ssh_address,
-                         GPid             *out_pid,
-                         GError          **error)
+static gboolean
+on_cancelled_idle (gpointer user_data)
 {
-        BridgeData *data;
-        DBusGConnection *ret;
-        GError *local_error;
-        gchar *command_line;
-        gint ssh_argc;
-        gchar **ssh_argv;
-        GPid ssh_pid;
-        gchar *dbus_address;
-        gint stdin_fd;
-        gint stdout_fd;
-        gint stderr_fd;
-        gint local_port;
-        gint remote_port;
-        GOutputStream *stdin_stream;
-        GInputStream *stdout_stream;
-        GInputStream *stderr_stream;
-        GDataOutputStream *stdin_data_stream;
-        GDataInputStream *stdout_data_stream;
-        GDataInputStream *stderr_data_stream;
-        gchar *s;
-        DBusError dbus_error;
-        DBusServer *server;
-        const gchar *auth_mechanisms[] = {"ANONYMOUS", NULL};
-        GString *str;
-        guint n;
+        BridgeData *data = user_data;
+        GError *error;
 
-        local_error = NULL;
+        data->cancelled_idle_id = 0;
+        error = NULL;
+        g_cancellable_set_error_if_cancelled (data->cancellable, &error);
+        bridge_complete (data, error);
+        return FALSE;
+}
 
-        ret = NULL;
+static void
+on_cancelled (GCancellable *cancellable,
+              gpointer      user_data)
+{
+        BridgeData *data = user_data;
 
-        data = NULL;
-        ssh_argv = NULL;
-        command_line = NULL;
-        dbus_address = NULL;
-        server = NULL;
-        stdin_data_stream = NULL;
-        stdout_data_stream = NULL;
-        stderr_data_stream = NULL;
-        ssh_pid = 0;
+        /* Pending reads are cancelled by the cancellable itself and complete the operation
+         * from their callback - we only need to handle waiting for the D-Bus connection
+         */
+        if (data->state == BRIDGE_STATE_WAITING_FOR_AUTHORIZATION && data->cancelled_idle_id == 0)
+                data->cancelled_idle_id = g_idle_add (on_cancelled_idle, data);
+}
 
-        data = g_new0 (BridgeData, 1);
-        str = g_string_new (NULL);
-        for (n = 0; n < 32; n++) {
-                guint32 r = g_random_int ();
-                g_string_append_printf (str, "%08x", r);
-        }
-        data->secret = g_string_free (str, FALSE);
-        data->cancellable = g_cancellable_new ();
-        data->loop = g_main_loop_new (NULL, FALSE);
+static gboolean
+on_kill_ssh_timeout (gpointer user_data)
+{
+        BridgeData *data = user_data;
 
-        /* Create and start the local DBusServer */
-        for (local_port = 9000; local_port < 10000; local_port++) {
-                s = g_strdup_printf ("tcp:host=localhost,port=%d", local_port);
-                dbus_error_init (&dbus_error);
-                server = dbus_server_listen (s, &dbus_error);
-                g_free (s);
-                if (server == NULL) {
-                        if (g_strcmp0 (dbus_error.name, "org.freedesktop.DBus.Error.AddressInUse") == 0) {
-                                continue;
-                        } else {
-                                g_set_error (error,
-                                             MDU_ERROR,
-                                             MDU_ERROR_FAILED,
-                                             _("Error listening to address `localhost:%d': %s: %s\n"),
-                                             local_port,
-                                             dbus_error.name,
-                                             dbus_error.message);
-                                dbus_error_free (&dbus_error);
-                                goto out;
-                        }
-                } else {
-                        break;
-                }
-        }
-        if (server == NULL) {
+        data->kill_ssh_timeout_id = 0;
+
+        /* kill ssh process so we won't wait for additional data if there is none */
+        if (data->ssh_pid > 0)
+                kill (data->ssh_pid, SIGTERM);
+
+        return FALSE;
+}
+
+static gboolean
+bridge_write_line (BridgeData  *data,
+                   const gchar *line,
+                   const gchar *what,
+                   GError     **error)
+{
+        GError *local_error;
+
+        local_error = NULL;
+        if (!g_data_output_stream_put_string (data->stdin_data_stream,
+                                              line,
+                                              data->cancellable,
+                                              &local_error)) {
                 g_set_error (error,
                              MDU_ERROR,
                              MDU_ERROR_FAILED,
-                             _("Error creating a local TCP server, tried binding to ports 9000-10000 on localhost"));
-                dbus_error_free (&dbus_error);
+                             _("Error sending `%s': %s"),
+                             what,
+                             local_error->message);
+                g_error_free (local_error);
+                return FALSE;
+        }
+        return TRUE;
+}
+
+/* Starts the bridge - the udisks-tcp-bridge program will connect to the
+ * remote port which is forwarded to the local port by ssh
+ */
+static gboolean
+bridge_start_tcp_bridge (BridgeData  *data,
+                         GError     **error)
+{
+        gchar *command;
+        gboolean ret;
+
+        command = g_strdup_printf ("udisks-tcp-bridge -p %d\n", data->remote_port);
+        ret = bridge_write_line (data, command, command, error);
+        g_free (command);
+        if (ret)
+                data->state = BRIDGE_STATE_WAITING_FOR_BRIDGE;
+        return ret;
+}
+
+static void
+on_forward_read_line (GObject      *source_object,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+        BridgeData *data = user_data;
+        GError *local_error;
+        GError *error;
+        gchar *endp;
+        gint64 port;
+        gchar *s;
+
+        error = NULL;
+        local_error = NULL;
+        s = g_data_input_stream_read_line_finish (data->forward_data_stream, res, NULL, &local_error);
+        if (s != NULL)
+                fixup_newlines (s);
+
+        if (local_error != NULL && g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                error = local_error;
+                local_error = NULL;
                 goto out;
         }
 
-        dbus_server_setup_with_g_main (server, NULL);
-        dbus_server_set_new_connection_function (server,
-                                                 on_new_connection,
-                                                 data,
-                                                 NULL);
-        /* Allow only anonymous auth */
-        if (!dbus_server_set_auth_mechanisms (server, auth_mechanisms)) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Error setting auth mechanisms on local DBusServer\n"));
+        if (s == NULL) {
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("Error requesting port forward from ssh: %s"),
+                                     local_error != NULL ? local_error->message : "No content");
                 goto out;
         }
 
-        command_line = g_strdup_printf ("ssh "
-                                        "-T "
-                                        "-C "
-                                        "-R 0:localhost:%d "
-                                        "-o \"ForwardX11 no\" "
-                                        "-o \"ForwardAgent no\" "
-                                        "-o \"Protocol 2\" "
-                                        "-o \"NoHostAuthenticationForLocalhost yes\" "
-                                        "%s%c%s",
-                                        local_port,
-                                        ssh_user_name != NULL ? ssh_user_name : "",
-                                        ssh_user_name != NULL ? '@' : ' ',
-                                        ssh_address);
-        //g_print ("command line: `%s'\n", command_line);
-        if (!g_shell_parse_argv (command_line,
-                                 &ssh_argc,
-                                 &ssh_argv,
-                                 &local_error)) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Unable to parse command-line `%s' (Malformed address?): %s"),
-                             command_line,
-                             local_error->message);
-                g_error_free (local_error);
+        /* the port on success, otherwise the error message of ssh */
+        port = g_ascii_strtoll (s, &endp, 10);
+        if (*endp != '\0' || port <= 0 || port > 65535) {
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("Error requesting port forward from ssh: %s"),
+                                     s);
                 goto out;
         }
+        data->remote_port = port;
+        data->forward->remote_port = port;
+
+        if (!bridge_start_tcp_bridge (data, &error))
+                goto out;
+        bridge_read_line (data);
+
+ out:
+        g_free (s);
+        if (local_error != NULL)
+                g_error_free (local_error);
+        if (error != NULL)
+                bridge_complete (data, error);
+}
 
+static void
+forward_child_setup (gpointer user_data)
+{
+        child_setup (user_data);
+        /* error messages end up on stdout as well, see on_forward_read_line() */
+        dup2 (STDOUT_FILENO, STDERR_FILENO);
+}
+
+/* Asks the master connection for a remote forward to our DBusServer, see the
+ * comment at the top of this file
+ */
+static void
+bridge_request_forward (BridgeData *data)
+{
+        GInputStream *stream;
+        GError *local_error;
+        GError *error;
+        gchar **argv;
+        gchar *spec;
+        gint stdout_fd;
+
+        error = NULL;
+        local_error = NULL;
 
+        spec = g_strdup_printf ("0:localhost:%d", data->forward->local_port);
+        argv = remote_forward_get_argv (data->forward, "forward", spec);
         if (!g_spawn_async_with_pipes (NULL,
-                                       ssh_argv,
+                                       argv,
+                                       NULL,
+                                       G_SPAWN_SEARCH_PATH,
+                                       forward_child_setup,
+                                       NULL,
                                        NULL,
-                                       G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
-                                       child_setup,
                                        NULL,
-                                       &ssh_pid,
-                                       &stdin_fd,
                                        &stdout_fd,
-                                       &stderr_fd,
+                                       NULL,
                                        &local_error)) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Unable to spawn ssh program: %s"),
-                             local_error->message);
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("Unable to spawn ssh program: %s"),
+                                     local_error->message);
                 g_error_free (local_error);
                 goto out;
         }
 
-        stdin_stream = g_unix_output_stream_new (stdin_fd, TRUE);
-        stdout_stream = g_unix_input_stream_new (stdout_fd, TRUE);
-        stderr_stream = g_unix_input_stream_new (stderr_fd, TRUE);
-        stdin_data_stream = g_data_output_stream_new (stdin_stream);
-        stdout_data_stream = g_data_input_stream_new (stdout_stream);
-        stderr_data_stream = g_data_input_stream_new (stderr_stream);
-        g_object_unref (stdin_stream);
-        g_object_unref (stdout_stream);
-        g_object_unref (stderr_stream);
+        stream = g_unix_input_stream_new (stdout_fd, TRUE);
+        data->forward_data_stream = g_data_input_stream_new (stream);
+        g_object_unref (stream);
 
-        /* Read and parse output from ssh */
-        while (TRUE) {
-                //g_print (" - Reading...\n");
+        data->state = BRIDGE_STATE_WAITING_FOR_FORWARD;
+        g_data_input_stream_read_line_async (data->forward_data_stream,
+                                             G_PRIORITY_DEFAULT,
+                                             data->cancellable,
+                                             on_forward_read_line,
+                                             data);
 
-                s = g_data_input_stream_read_line (stderr_data_stream,
-                                                   NULL, /* gsize *length */
-                                                   data->cancellable,
-                                                   &local_error);
-                if (s == NULL) {
-                        if (local_error != NULL) {
-                                g_set_error (error,
-                                             MDU_ERROR,
-                                             MDU_ERROR_FAILED,
-                                             _("Error reading stderr output: %s"),
-                                             local_error->message);
-                                g_error_free (local_error);
-                        } else {
-                                g_set_error_literal (error,
-                                                     MDU_ERROR,
-                                                     MDU_ERROR_FAILED,
-                                                     _("Error reading stderr output: No content"));
-                        }
-                        goto out;
-                }
+ out:
+        g_strfreev (argv);
+        g_free (spec);
+        if (error != NULL)
+                bridge_complete (data, error);
+}
+
+static void
+on_read_line (GObject      *source_object,
+              GAsyncResult *res,
+              gpointer      user_data)
+{
+        BridgeData *data = user_data;
+        GError *local_error;
+        GError *error;
+        gchar *s;
 
+        error = NULL;
+        local_error = NULL;
+        s = g_data_input_stream_read_line_finish (data->stderr_data_stream, res, NULL, &local_error);
+        if (s != NULL)
                 fixup_newlines (s);
-                //g_print (" - Read `%s'\n", s);
+        //g_print (" - Read `%s'\n", s);
 
-                if (sscanf (s, "Allocated port %d for remote forward to", &remote_port) == 1) {
-                        /* got it */
-                        g_free (s);
-                        break;
+        if (local_error != NULL && g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                error = local_error;
+                local_error = NULL;
+                goto out;
+        }
+
+        switch (data->state) {
+        case BRIDGE_STATE_WAITING_FOR_PORT:
+                if (s == NULL) {
+                        if (local_error != NULL) {
+                                error = g_error_new (MDU_ERROR,
+                                                     MDU_ERROR_FAILED,
+                                                     _("Error reading stderr output: %s"),
+                                                     local_error->message);
+                        } else {
+                                error = g_error_new_literal (MDU_ERROR,
+                                                             MDU_ERROR_FAILED,
+                                                             _("Error reading stderr output: No content"));
+                        }
+                        goto out;
+                }
+
+                if (data->forward != NULL && g_strcmp0 (s, CONNECTED_MARKER) == 0) {
+                        /* stderr is read again once the bridge is started, see on_forward_read_line() */
+                        bridge_request_forward (data);
+                        goto out;
+                } else if (data->forward == NULL &&
+                           sscanf (s, "Allocated port %d for remote forward to", &data->remote_port) == 1) {
+                        //g_print ("Yay, remote port is %d\n", data->remote_port);
+                        if (!bridge_start_tcp_bridge (data, &error))
+                                goto out;
                 } else if (strstr (s, "Permanently added") != NULL &&
                            strstr (s, "to the list of known hosts") != NULL) {
                         /* just continue */
-                        g_free (s);
                 } else {
-                        GString *full_error_message;
-
                         /* otherwise assume error - Keep reading output as it may be
                          * multi-line, e.g.
                          *
@@ -429,196 +716,827 @@ _mdu_ssh_bridge_connect (const gchar      *ssh_user_name,
                          *   @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
                          *   IT IS POSSIBLE THAT SOMEONE IS DOING SOMETHING NASTY!
                          *   Someone could be eavesdropping on you right now (man-in-the-middle attack)!
+                         *
+                         * Give ssh a bit of time to write it all and then kill it so we
+                         * get EOF (TODO: this is slightly racy)
                          */
-                        full_error_message = g_string_new (s);
-                        g_free (s);
-
-                        /* sleep for a bit to ensure we've buffered all the data from ssh's
-                         * stderr stream (TODO: this is slightly racy
-                         */
-                        usleep (100 * 1000);
+                        data->full_error_message = g_string_new (s);
+                        data->state = BRIDGE_STATE_COLLECTING_ERROR;
+                        data->kill_ssh_timeout_id = g_timeout_add (100, on_kill_ssh_timeout, data);
+                }
+                break;
 
-                        /* kill ssh process early so we won't block on reading additional data if there is none */
-                        if (ssh_pid > 0) {
-                                kill (ssh_pid, SIGTERM);
-                                ssh_pid = 0;
+        case BRIDGE_STATE_COLLECTING_ERROR:
+                if (s != NULL) {
+                        g_string_append (data->full_error_message, s);
+                        g_string_append_c (data->full_error_message, '\n');
+                } else {
+                        if (data->full_error_message->len > 0) {
+                                error = g_error_new_literal (MDU_ERROR,
+                                                             MDU_ERROR_FAILED,
+                                                             data->full_error_message->str);
+                        } else {
+                                error = g_error_new_literal (MDU_ERROR,
+                                                             MDU_ERROR_FAILED,
+                                                             _("Error logging in"));
                         }
+                        goto out;
+                }
+                break;
 
-                        while (TRUE) {
-                                s = g_data_input_stream_read_line (stderr_data_stream,
-                                                                   NULL, /* gsize *length */
-                                                                   data->cancellable,
-                                                                   NULL);
-                                if (s != NULL) {
-                                        fixup_newlines (s);
-                                        g_string_append (full_error_message, s);
-                                        g_string_append_c (full_error_message, '\n');
-                                } else {
-                                        break;
-                                }
-                        }
+        case BRIDGE_STATE_WAITING_FOR_BRIDGE:
+                /* Check that the udisks program is waiting for secret */
+                if (s == NULL) {
+                        error = g_error_new (MDU_ERROR,
+                                             MDU_ERROR_FAILED,
+                                             _("Error reading stderr output: %s"),
+                                             local_error != NULL ? local_error->message : "EOF");
+                        goto out;
+                }
+                if (g_strcmp0 (s, "udisks-tcp-bridge: Waiting for secret") != 0) {
+                        error = g_error_new (MDU_ERROR,
+                                             MDU_ERROR_FAILED,
+                                             _("Unexpected stderr output - expected `udisks-tcp-bridge: Waiting for secret' but got `%s'"),
+                                             s);
+                        goto out;
+                }
 
-                        s = g_string_free (full_error_message, FALSE);
-                        if (strlen (s) > 0) {
-                                g_set_error_literal (error,
-                                                     MDU_ERROR,
-                                                     MDU_ERROR_FAILED,
-                                                     s);
-                        } else {
-                                g_set_error_literal (error,
-                                                     MDU_ERROR,
-                                                     MDU_ERROR_FAILED,
-                                                     _("Error logging in"));
-                        }
-                        g_free (s);
+                /* Pass the secret */
+                {
+                        gchar *secret_line;
+                        gboolean written;
+
+                        secret_line = g_strdup_printf ("%s\n", data->secret);
+                        written = bridge_write_line (data, secret_line, "authorization secret", &error);
+                        memset (secret_line, '\0', strlen (secret_line));
+                        g_free (secret_line);
+                        if (!written)
+                                goto out;
+                }
+                data->state = BRIDGE_STATE_WAITING_FOR_CONNECT;
+                break;
+
+        case BRIDGE_STATE_WAITING_FOR_CONNECT:
+                /* Check that the udisks program really is attempting to connect (for cases
+                 * where the program doesn't exist on the host
+                 */
+                if (s == NULL) {
+                        error = g_error_new (MDU_ERROR,
+                                             MDU_ERROR_FAILED,
+                                             _("Error reading stderr from: %s"),
+                                             local_error != NULL ? local_error->message : "EOF");
                         goto out;
                 }
+                if (sscanf (s, "udisks-tcp-bridge: Attempting to connect to port %d", &data->remote_port) != 1) {
+                        error = g_error_new (MDU_ERROR,
+                                             MDU_ERROR_FAILED,
+                                             _("Unexpected stderr output - expected `udisks-tcp-bridge: Attempting to connect to port %d' but got `%s'"),
+                                             data->remote_port,
+                                             s);
+                        goto out;
+                }
+
+                /* Wait for D-Bus connection and authorization, see connection_filter_func() */
+                data->state = BRIDGE_STATE_WAITING_FOR_AUTHORIZATION;
+                if (data->authorization_done)
+                        bridge_finish_authorization (data);
+                else if (g_cancellable_is_cancelled (data->cancellable))
+                        on_cancelled (data->cancellable, data);
+                goto out;
+
+        default:
+                g_assert_not_reached ();
+                break;
         }
 
-        //g_print ("Yay, remote port is %d (forwarding to local port %d)\n", remote_port, local_port);
+        bridge_read_line (data);
 
-        /* Now start the bridge - the udisks-tcp-bridge program will connect to the remote port
-         * which is forwarded to the local port by ssh
-         */
-        s = g_strdup_printf ("udisks-tcp-bridge -p %d\n", remote_port);
-        if (!g_data_output_stream_put_string (stdin_data_stream,
-                                              s,
-                                              data->cancellable,
-                                              &local_error)) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Error sending `%s': %s"),
-                             s,
-                             local_error->message);
+ out:
+        g_free (s);
+        if (local_error != NULL)
                 g_error_free (local_error);
+        if (error != NULL)
+                bridge_complete (data, error);
+}
+
+static void
+bridge_read_line (BridgeData *data)
+{
+        g_data_input_stream_read_line_async (data->stderr_data_stream,
+                                             G_PRIORITY_DEFAULT,
+                                             /* don't cancel while collecting the error message */
+                                             data->state == BRIDGE_STATE_COLLECTING_ERROR ? NULL : data->cancellable,
+                                             on_read_line,
+                                             data);
+}
+
+/* Returns the directory for the control sockets of ssh master connections or NULL if
+ * there is no directory only we can write to
+ */
+static gchar *
+get_control_path_dir (void)
+{
+        gchar *dir;
+        struct stat statbuf;
+
+        dir = g_strdup_printf ("%s/mdu-ssh-%d", g_get_tmp_dir (), (gint) getuid ());
+        if (g_mkdir (dir, 0700) != 0 && errno != EEXIST) {
+                g_warning ("Not sharing ssh connections: Error creating %s: %s", dir, g_strerror (errno));
+                goto fail;
+        }
+
+        /* don't let anyone else hijack our connections */
+        if (g_lstat (dir, &statbuf) != 0 ||
+            !S_ISDIR (statbuf.st_mode) ||
+            statbuf.st_uid != getuid () ||
+            (statbuf.st_mode & 0077) != 0) {
+                g_warning ("Not sharing ssh connections: %s is not a private directory", dir);
+                goto fail;
+        }
+
+        return dir;
+
+ fail:
+        g_free (dir);
+        return NULL;
+}
+
+/* Spawns ssh and sets up the D-Bus connection, see the comment at the top of this file.
+ *
+ * Compression pays off on slow links as property maps and the lists of
+ * device file symlinks repeat a lot; on fast links it only costs CPU on
+ * both ends. It is turned off explicitly if @compress is %FALSE so it is
+ * not enabled behind our back by the user's ssh configuration.
+ */
+static void
+bridge_spawn_async (const gchar         *ssh_user_name,
+                    const gchar         *ssh_address,
+                    gboolean             compress,
+                    GCancellable        *cancellable,
+                    GAsyncReadyCallback  callback,
+                    gpointer             user_data)
+{
+        BridgeData *data;
+        GError *local_error;
+        GError *error;
+        gchar *command_line;
+        gint ssh_argc;
+        gchar **ssh_argv;
+        gint stdin_fd;
+        gint stdout_fd;
+        gint stderr_fd;
+        gint local_port;
+        GOutputStream *stdin_stream;
+        GInputStream *stdout_stream;
+        GInputStream *stderr_stream;
+        gchar *s;
+        DBusError dbus_error;
+        const gchar *auth_mechanisms[] = {"ANONYMOUS", NULL};
+        GString *str;
+        gchar *control_path_dir;
+        gchar *control_options;
+        gchar *forward_options;
+        guint n;
+
+        local_error = NULL;
+        error = NULL;
+
+        ssh_argv = NULL;
+        command_line = NULL;
+        control_options = NULL;
+        forward_options = NULL;
+
+        data = g_new0 (BridgeData, 1);
+        data->simple = g_simple_async_result_new (NULL,
+                                                  callback,
+                                                  user_data,
+                                                  bridge_spawn_async);
+        str = g_string_new (NULL);
+        for (n = 0; n < 32; n++) {
+                guint32 r = g_random_int ();
+                g_string_append_printf (str, "%08x", r);
+        }
+        data->secret = g_string_free (str, FALSE);
+        data->cancellable = cancellable != NULL ? g_object_ref (cancellable) : g_cancellable_new ();
+
+        /* Create and start the local DBusServer */
+        for (local_port = 9000; local_port < 10000; local_port++) {
+                s = g_strdup_printf ("tcp:host=localhost,port=%d", local_port);
+                dbus_error_init (&dbus_error);
+                data->server = dbus_server_listen (s, &dbus_error);
                 g_free (s);
+                if (data->server == NULL) {
+                        if (g_strcmp0 (dbus_error.name, "org.freedesktop.DBus.Error.AddressInUse") == 0) {
+                                dbus_error_free (&dbus_error);
+                                continue;
+                        } else {
+                                error = g_error_new (MDU_ERROR,
+                                                     MDU_ERROR_FAILED,
+                                                     _("Error listening to address `localhost:%d': %s: %s\n"),
+                                                     local_port,
+                                                     dbus_error.name,
+                                                     dbus_error.message);
+                                dbus_error_free (&dbus_error);
+                                goto out;
+                        }
+                } else {
+                        break;
+                }
+        }
+        if (data->server == NULL) {
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("Error creating a local TCP server, tried binding to ports 9000-10000 on localhost"));
                 goto out;
         }
-        g_free (s);
 
-        /* Check that the udisks program is waiting for secret
-         */
-        s = g_data_input_stream_read_line (stderr_data_stream,
-                                           NULL, /* gsize *length */
-                                           data->cancellable,
-                                           &local_error);
-        if (s == NULL) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Error reading stderr output: %s"),
-                             local_error->message);
-                g_error_free (local_error);
+        dbus_server_setup_with_g_main (data->server, NULL);
+        dbus_server_set_new_connection_function (data->server,
+                                                 on_new_connection,
+                                                 data,
+                                                 NULL);
+        /* Allow only anonymous auth */
+        if (!dbus_server_set_auth_mechanisms (data->server, auth_mechanisms)) {
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("Error setting auth mechanisms on local DBusServer\n"));
                 goto out;
         }
-        if (g_strcmp0 (s, "udisks-tcp-bridge: Waiting for secret") != 0) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Unexpected stderr output - expected `udisks-tcp-bridge: Waiting for secret' but got `%s'"),
-                             s);
-                g_free (s);
-                goto out;
+
+        /* the master connection is specific to the compression setting */
+        control_path_dir = get_control_path_dir ();
+        if (control_path_dir != NULL) {
+                gchar *control_path;
+                gchar *quoted;
+
+                data->forward = g_new0 (RemoteForward, 1);
+                data->forward->control_path = g_strdup_printf ("%s/%%r@%%h:%%p%s",
+                                                               control_path_dir,
+                                                               compress ? "-z" : "");
+                if (ssh_user_name != NULL)
+                        data->forward->destination = g_strdup_printf ("%s@%s", ssh_user_name, ssh_address);
+                else
+                        data->forward->destination = g_strdup (ssh_address);
+                data->forward->local_port = local_port;
+
+                control_path = g_strdup_printf ("ControlPath=%s", data->forward->control_path);
+                quoted = g_shell_quote (control_path);
+                control_options = g_strdup_printf ("-o ControlMaster=auto -o ControlPersist=60 -o %s ", quoted);
+                g_free (quoted);
+                g_free (control_path);
+                g_free (control_path_dir);
+
+                /* requested from the master instead, see bridge_request_forward() */
+                forward_options = g_strdup ("");
+        } else {
+                forward_options = g_strdup_printf ("-R 0:localhost:%d ", local_port);
         }
-        g_free (s);
 
-        /* Pass the secret
-         */
-        s = g_strdup_printf ("%s\n", data->secret);
-        if (!g_data_output_stream_put_string (stdin_data_stream,
-                                              s,
-                                              data->cancellable,
-                                              &local_error)) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Error passing authorization secret: %s"),
-                             local_error->message);
+        command_line = g_strdup_printf ("ssh "
+                                        "-T "
+                                        "-o \"Compression %s\" "
+                                        "%s"
+                                        "%s"
+                                        "-o \"ForwardX11 no\" "
+                                        "-o \"ForwardAgent no\" "
+                                        "-o \"Protocol 2\" "
+                                        "-o \"NoHostAuthenticationForLocalhost yes\" "
+                                        "%s%c%s",
+                                        compress ? "yes" : "no",
+                                        control_options != NULL ? control_options : "",
+                                        forward_options,
+                                        ssh_user_name != NULL ? ssh_user_name : "",
+                                        ssh_user_name != NULL ? '@' : ' ',
+                                        ssh_address);
+        //g_print ("command line: `%s'\n", command_line);
+        if (!g_shell_parse_argv (command_line,
+                                 &ssh_argc,
+                                 &ssh_argv,
+                                 &local_error)) {
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("Unable to parse command-line `%s' (Malformed address?): %s"),
+                                     command_line,
+                                     local_error->message);
                 g_error_free (local_error);
-                memset (s, '\0', strlen (s));
-                g_free (s);
                 goto out;
         }
-        memset (s, '\0', strlen (s));
-        g_free (s);
 
-        /* Check that the udisks program really is attempting to connect (for cases
-         * where the program doesn't exist on the host
-         */
-        s = g_data_input_stream_read_line (stderr_data_stream,
-                                           NULL, /* gsize *length */
-                                           data->cancellable,
-                                           &local_error);
-        if (s == NULL) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Error reading stderr from: %s"),
-                             local_error->message);
+        if (!g_spawn_async_with_pipes (NULL,
+                                       ssh_argv,
+                                       NULL,
+                                       G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+                                       child_setup,
+                                       NULL,
+                                       &data->ssh_pid,
+                                       &stdin_fd,
+                                       &stdout_fd,
+                                       &stderr_fd,
+                                       &local_error)) {
+                error = g_error_new (MDU_ERROR,
+                                     MDU_ERROR_FAILED,
+                                     _("Unable to spawn ssh program: %s"),
+                                     local_error->message);
                 g_error_free (local_error);
                 goto out;
         }
-        if (sscanf (s, "udisks-tcp-bridge: Attempting to connect to port %d", &remote_port) != 1) {
-                g_set_error (error,
-                             MDU_ERROR,
-                             MDU_ERROR_FAILED,
-                             _("Unexpected stderr output - expected `udisks-tcp-bridge: Attempting to connect to port %d' but got `%s'"),
-                             remote_port,
-                             s);
-                g_free (s);
+
+        stdin_stream = g_unix_output_stream_new (stdin_fd, TRUE);
+        stdout_stream = g_unix_input_stream_new (stdout_fd, TRUE);
+        stderr_stream = g_unix_input_stream_new (stderr_fd, TRUE);
+        data->stdin_data_stream = g_data_output_stream_new (stdin_stream);
+        data->stdout_data_stream = g_data_input_stream_new (stdout_stream);
+        data->stderr_data_stream = g_data_input_stream_new (stderr_stream);
+        g_object_unref (stdin_stream);
+        g_object_unref (stdout_stream);
+        g_object_unref (stderr_stream);
+
+        data->cancelled_handler_id = g_signal_connect (data->cancellable,
+                                                       "cancelled",
+                                                       G_CALLBACK (on_cancelled),
+                                                       data);
+
+        /* have the remote shell tell us when the session is up, see on_read_line() */
+        if (data->forward != NULL &&
+            !bridge_write_line (data, "echo '" CONNECTED_MARKER "' >&2\n", "connected marker", &error))
+                goto out;
+
+        /* Read and parse output from ssh, see on_read_line() */
+        data->state = BRIDGE_STATE_WAITING_FOR_PORT;
+        bridge_read_line (data);
+
+ out:
+        if (error != NULL)
+                bridge_complete (data, error);
+        g_strfreev (ssh_argv);
+        g_free (forward_options);
+        g_free (control_options);
+        g_free (command_line);
+}
+
+static DBusGConnection *
+bridge_spawn_finish (GAsyncResult   *res,
+                     GPid           *out_pid,
+                     RemoteForward **out_forward,
+                     GError        **error)
+{
+        GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (res);
+        BridgeResult *result;
+        DBusGConnection *ret;
+
+        g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == bridge_spawn_async);
+
+        ret = NULL;
+        if (out_pid != NULL)
+                *out_pid = 0;
+        if (out_forward != NULL)
+                *out_forward = NULL;
+
+        if (g_simple_async_result_propagate_error (simple, error))
                 goto out;
+
+        result = g_simple_async_result_get_op_res_gpointer (simple);
+        ret = dbus_g_connection_ref (result->connection);
+        if (out_pid != NULL)
+                *out_pid = result->pid;
+        if (out_forward != NULL) {
+                *out_forward = result->forward;
+                result->forward = NULL;
         }
-        g_free (s);
 
-        /* Wait for D-Bus connection and authorization */
-        g_main_loop_run (data->loop);
+ out:
+        return ret;
+}
 
-        if (data->server_connection != NULL) {
-                if (data->authorized) {
-                        ret = dbus_connection_get_g_connection (dbus_connection_ref (data->server_connection));
-                } else {
-                        dbus_connection_close (data->server_connection);
-                        g_set_error (error,
-                                     MDU_ERROR,
-                                     MDU_ERROR_FAILED,
-                                     _("The udisks-tcp-bridge program failed to prove it was authorized: %s"),
-                                     data->error_message != NULL ? data->error_message : "(no detail)");
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct {
+        /* user@host, see get_shared_bridge_key() */
+        gchar *key;
+
+        /* NULL until connected */
+        DBusGConnection *connection;
+        GPid pid;
+        guint child_watch_id;
+        /* non-NULL if the session is multiplexed, see RemoteForward */
+        RemoteForward *forward;
+
+        /* number of users that haven't called _mdu_ssh_bridge_release() yet */
+        guint use_count;
+
+        /* callers waiting for the connection to be set up, see Waiter */
+        GList *waiters;
+        GCancellable *cancellable;
+} SharedBridge;
+
+typedef struct {
+        SharedBridge *bridge;
+        GSimpleAsyncResult *simple;
+        GCancellable *cancellable;
+        gulong cancelled_handler_id;
+} Waiter;
+
+/* bridges being set up or connected, keyed by get_shared_bridge_key() */
+static GHashTable *key_to_shared_bridge = NULL;
+
+/* connected bridges that are still used, keyed by connection */
+static GHashTable *connection_to_shared_bridge = NULL;
+
+static gchar *
+get_shared_bridge_key (const gchar *ssh_user_name,
+                       const gchar *ssh_address,
+                       gboolean     compress)
+{
+        return g_strdup_printf ("%s@%s%s",
+                                ssh_user_name != NULL ? ssh_user_name : g_get_user_name (),
+                                ssh_address,
+                                compress ? " (compressed)" : "");
+}
+
+static void
+shared_bridge_free (SharedBridge *bridge)
+{
+        g_warn_if_fail (bridge->waiters == NULL);
+        if (bridge->connection != NULL)
+                dbus_g_connection_unref (bridge->connection);
+        if (bridge->cancellable != NULL)
+                g_object_unref (bridge->cancellable);
+        if (bridge->forward != NULL)
+                remote_forward_free (bridge->forward);
+        g_free (bridge->key);
+        g_free (bridge);
+}
+
+static void
+waiter_free (Waiter *waiter)
+{
+        if (waiter->cancelled_handler_id > 0)
+                g_signal_handler_disconnect (waiter->cancellable, waiter->cancelled_handler_id);
+        if (waiter->cancellable != NULL)
+                g_object_unref (waiter->cancellable);
+        g_object_unref (waiter->simple);
+        g_free (waiter);
+}
+
+static void
+on_waiter_cancelled (GCancellable *cancellable,
+                     gpointer      user_data)
+{
+        Waiter *waiter = user_data;
+        SharedBridge *bridge = waiter->bridge;
+        GError *error;
+
+        bridge->waiters = g_list_remove (bridge->waiters, waiter);
+
+        error = NULL;
+        g_cancellable_set_error_if_cancelled (cancellable, &error);
+        g_simple_async_result_set_from_error (waiter->simple, error);
+        g_simple_async_result_complete_in_idle (waiter->simple);
+        g_error_free (error);
+        waiter_free (waiter);
+
+        /* only give up on connecting if nobody else is waiting for it */
+        if (bridge->waiters == NULL)
+                g_cancellable_cancel (bridge->cancellable);
+}
+
+static void
+on_shared_ssh_process_terminated (GPid     pid,
+                                  gint     status,
+                                  gpointer user_data)
+{
+        SharedBridge *bridge = user_data;
+
+        g_spawn_close_pid (pid);
+        bridge->pid = 0;
+        bridge->child_watch_id = 0;
+
+        /* the master may still be listening on the remote port for us */
+        if (bridge->forward != NULL) {
+                remote_forward_cancel (bridge->forward);
+                bridge->forward = NULL;
+        }
+
+        /* connect to the host from scratch next time */
+        if (g_hash_table_lookup (key_to_shared_bridge, bridge->key) == bridge)
+                g_hash_table_remove (key_to_shared_bridge, bridge->key);
+
+        if (bridge->use_count == 0)
+                shared_bridge_free (bridge);
+}
+
+/* closes the connection and terminates ssh once the last user is gone */
+static void
+shared_bridge_close (SharedBridge *bridge)
+{
+        g_hash_table_remove (connection_to_shared_bridge, bridge->connection);
+        if (g_hash_table_lookup (key_to_shared_bridge, bridge->key) == bridge)
+                g_hash_table_remove (key_to_shared_bridge, bridge->key);
+
+        dbus_connection_close (dbus_g_connection_get_connection (bridge->connection));
+
+        if (bridge->forward != NULL) {
+                remote_forward_cancel (bridge->forward);
+                bridge->forward = NULL;
+        }
+
+        /* freed in on_shared_ssh_process_terminated() if ssh is still running */
+        if (bridge->pid > 0)
+                kill (bridge->pid, SIGTERM);
+        else
+                shared_bridge_free (bridge);
+}
+
+static void
+on_bridge_spawned (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+        SharedBridge *bridge = user_data;
+        DBusGConnection *connection;
+        GError *error;
+        GList *waiters;
+        GList *l;
+
+        waiters = bridge->waiters;
+        bridge->waiters = NULL;
+
+        error = NULL;
+        connection = bridge_spawn_finish (res, &bridge->pid, &bridge->forward, &error);
+        if (connection == NULL) {
+                g_hash_table_remove (key_to_shared_bridge, bridge->key);
+                for (l = waiters; l != NULL; l = l->next) {
+                        Waiter *waiter = l->data;
+
+                        g_simple_async_result_set_from_error (waiter->simple, error);
+                        g_simple_async_result_complete (waiter->simple);
+                        waiter_free (waiter);
                 }
-        } else {
-                g_set_error_literal (error,
-                                     MDU_ERROR,
-                                     MDU_ERROR_FAILED,
-                                     _("The udisks-tcp-bridge program failed to prove it was authorized"));
+                g_error_free (error);
+                shared_bridge_free (bridge);
+                goto out;
+        }
+
+        bridge->connection = connection;
+        bridge->child_watch_id = g_child_watch_add (bridge->pid, on_shared_ssh_process_terminated, bridge);
+        g_hash_table_insert (connection_to_shared_bridge, connection, bridge);
+
+        for (l = waiters; l != NULL; l = l->next) {
+                Waiter *waiter = l->data;
+
+                bridge->use_count++;
+                g_simple_async_result_set_op_res_gpointer (waiter->simple,
+                                                           dbus_g_connection_ref (connection),
+                                                           (GDestroyNotify) dbus_g_connection_unref);
+                g_simple_async_result_complete (waiter->simple);
+                waiter_free (waiter);
         }
 
+        /* everybody gave up while we were connecting */
+        if (bridge->use_count == 0)
+                shared_bridge_close (bridge);
+
  out:
-        if (ret == NULL) {
-                /* kill ssh connection if we failed */
-                if (ssh_pid > 0) {
-                        kill (ssh_pid, SIGTERM);
-                }
-                if (out_pid != NULL)
-                        *out_pid = 0;
+        g_list_free (waiters);
+}
+
+/**
+ * _mdu_ssh_bridge_connect_async:
+ * @ssh_user_name: The user name to connect as or %NULL for the current user.
+ * @ssh_address: The host to connect to.
+ * @compress: Whether to have ssh compress the traffic.
+ * @cancellable: A #GCancellable or %NULL.
+ * @callback: Function to call when the operation is complete.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously sets up a D-Bus connection to the udisks daemon on
+ * @ssh_address via ssh, see the comment at the top of this file. Use
+ * _mdu_ssh_bridge_connect_finish() in @callback to get the result.
+ *
+ * If there already is a connection to @ssh_address as @ssh_user_name
+ * with the same @compress setting, or one is being set up, it is shared.
+ * The connection must be released with _mdu_ssh_bridge_release().
+ */
+void
+_mdu_ssh_bridge_connect_async (const gchar         *ssh_user_name,
+                               const gchar         *ssh_address,
+                               gboolean             compress,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+        SharedBridge *bridge;
+        Waiter *waiter;
+        GSimpleAsyncResult *simple;
+        GError *error;
+        gchar *key;
+
+        if (key_to_shared_bridge == NULL) {
+                key_to_shared_bridge = g_hash_table_new (g_str_hash, g_str_equal);
+                connection_to_shared_bridge = g_hash_table_new (g_direct_hash, g_direct_equal);
+        }
+
+        simple = g_simple_async_result_new (NULL,
+                                            callback,
+                                            user_data,
+                                            _mdu_ssh_bridge_connect_async);
+
+        error = NULL;
+        if (g_cancellable_set_error_if_cancelled (cancellable, &error)) {
+                g_simple_async_result_set_from_error (simple, error);
+                g_simple_async_result_complete_in_idle (simple);
+                g_object_unref (simple);
+                g_error_free (error);
+                goto out;
+        }
+
+        key = get_shared_bridge_key (ssh_user_name, ssh_address, compress);
+        bridge = g_hash_table_lookup (key_to_shared_bridge, key);
+
+        /* already connected - this is what makes the second and later pools for a host cheap */
+        if (bridge != NULL && bridge->connection != NULL) {
+                bridge->use_count++;
+                g_simple_async_result_set_op_res_gpointer (simple,
+                                                           dbus_g_connection_ref (bridge->connection),
+                                                           (GDestroyNotify) dbus_g_connection_unref);
+                g_simple_async_result_complete_in_idle (simple);
+                g_object_unref (simple);
+                g_free (key);
+                goto out;
+        }
+
+        if (bridge == NULL) {
+                bridge = g_new0 (SharedBridge, 1);
+                bridge->key = key;
+                bridge->cancellable = g_cancellable_new ();
+                g_hash_table_insert (key_to_shared_bridge, bridge->key, bridge);
+                bridge_spawn_async (ssh_user_name,
+                                    ssh_address,
+                                    compress,
+                                    bridge->cancellable,
+                                    on_bridge_spawned,
+                                    bridge);
         } else {
-                if (out_pid != NULL)
-                        *out_pid = ssh_pid;
-        }
-
-        if (data != NULL)
-                bridge_data_free (data);
-        if (server != NULL) {
-                dbus_server_disconnect (server);
-                dbus_server_unref (server);
-        }
-        if (stdin_data_stream != NULL)
-                g_object_unref (stdin_data_stream);
-        if (stdout_data_stream != NULL)
-                g_object_unref (stdout_data_stream);
-        if (stderr_data_stream != NULL)
-                g_object_unref (stderr_data_stream);
-        g_strfreev (ssh_argv);
-        g_free (command_line);
-        g_free (dbus_address);
+                g_free (key);
+        }
+
+        waiter = g_new0 (Waiter, 1);
+        waiter->bridge = bridge;
+        waiter->simple = simple;
+        if (cancellable != NULL) {
+                waiter->cancellable = g_object_ref (cancellable);
+                waiter->cancelled_handler_id = g_signal_connect (cancellable,
+                                                                 "cancelled",
+                                                                 G_CALLBACK (on_waiter_cancelled),
+                                                                 waiter);
+        }
+        bridge->waiters = g_list_append (bridge->waiters, waiter);
+
+ out:
+        ;
+}
+
+/**
+ * _mdu_ssh_bridge_connect_finish:
+ * @res: A #GAsyncResult.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with _mdu_ssh_bridge_connect_async().
+ *
+ * Returns: A #DBusGConnection or %NULL if @error is set. Release with
+ * _mdu_ssh_bridge_release().
+ */
+DBusGConnection *
+_mdu_ssh_bridge_connect_finish (GAsyncResult  *res,
+                                GError       **error)
+{
+        GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (res);
+        DBusGConnection *ret;
+
+        g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == _mdu_ssh_bridge_connect_async);
+
+        ret = NULL;
+        if (g_simple_async_result_propagate_error (simple, error))
+                goto out;
+
+        ret = dbus_g_connection_ref (g_simple_async_result_get_op_res_gpointer (simple));
+
+ out:
+        return ret;
+}
+
+/**
+ * _mdu_ssh_bridge_release:
+ * @connection: A connection returned by _mdu_ssh_bridge_connect() or _mdu_ssh_bridge_connect_finish().
+ *
+ * Releases @connection. When the last user of a connection releases
+ * it, the connection is closed and the ssh process is terminated.
+ */
+void
+_mdu_ssh_bridge_release (DBusGConnection *connection)
+{
+        SharedBridge *bridge;
+
+        bridge = NULL;
+        if (connection_to_shared_bridge != NULL)
+                bridge = g_hash_table_lookup (connection_to_shared_bridge, connection);
+        dbus_g_connection_unref (connection);
+        if (bridge == NULL)
+                goto out;
+
+        g_warn_if_fail (bridge->use_count > 0);
+        if (bridge->use_count > 0)
+                bridge->use_count--;
+        if (bridge->use_count == 0)
+                shared_bridge_close (bridge);
+
+ out:
+        ;
+}
+
+typedef struct {
+        GMainLoop *loop;
+        GAsyncResult *res;
+} SyncData;
+
+static void
+on_sync_connect_done (GObject      *source_object,
+                      GAsyncResult *res,
+                      gpointer      user_data)
+{
+        SyncData *data = user_data;
+
+        data->res = g_object_ref (res);
+        g_main_loop_quit (data->loop);
+}
+
+DBusGConnection *
+_mdu_ssh_bridge_connect (const gchar      *ssh_user_name,
+                         const gchar      *ssh_address,
+                         gboolean          compress,
+                         GError          **error)
+{
+        SyncData data;
+        DBusGConnection *ret;
+
+        data.loop = g_main_loop_new (NULL, FALSE);
+        data.res = NULL;
+
+        _mdu_ssh_bridge_connect_async (ssh_user_name,
+                                       ssh_address,
+                                       compress,
+                                       NULL,
+                                       on_sync_connect_done,
+                                       &data);
+        g_main_loop_run (data.loop);
+
+        ret = _mdu_ssh_bridge_connect_finish (data.res, error);
+
+        g_object_unref (data.res);
+        g_main_loop_unref (data.loop);
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/**
+ * _mdu_ssh_bridge_get_bytes_transferred:
+ * @connection: A connection returned by _mdu_ssh_bridge_connect() or _mdu_ssh_bridge_connect_finish().
+ * @out_bytes_received: Return location for the number of bytes received.
+ * @out_bytes_sent: Return location for the number of bytes sent.
+ *
+ * Gets the number of bytes of D-Bus traffic that went over the bridge.
+ * This is what is handed to ssh, e.g. before ssh compresses it.
+ *
+ * Returns: %FALSE if the numbers are not available on this system.
+ */
+gboolean
+_mdu_ssh_bridge_get_bytes_transferred (DBusGConnection *connection,
+                                       guint64         *out_bytes_received,
+                                       guint64         *out_bytes_sent)
+{
+        gboolean ret;
+#if defined (HAVE_STRUCT_TCP_INFO_TCPI_BYTES_ACKED) && defined (HAVE_STRUCT_TCP_INFO_TCPI_BYTES_RECEIVED)
+        struct tcp_info info;
+        socklen_t len;
+        int fd;
+
+        ret = FALSE;
+
+        if (!dbus_connection_get_socket (dbus_g_connection_get_connection (connection), &fd))
+                goto out;
+
+        len = sizeof info;
+        if (getsockopt (fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0 || len < sizeof info)
+                goto out;
+
+        *out_bytes_received = info.tcpi_bytes_received;
+        *out_bytes_sent = info.tcpi_bytes_acked;
+        ret = TRUE;
+
+ out:
+#else
+        ret = FALSE;
+#endif
         return ret;
 }
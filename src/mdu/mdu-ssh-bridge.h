@@ -31,7 +31,19 @@
 
 DBusGConnection * _mdu_ssh_bridge_connect (const gchar      *ssh_user_name,
                                            const gchar      *ssh_address,
-                                           GPid             *out_pid,
+                                           gboolean          compress,
                                            GError          **error);
+void              _mdu_ssh_bridge_connect_async  (const gchar          *ssh_user_name,
+                                                  const gchar          *ssh_address,
+                                                  gboolean              compress,
+                                                  GCancellable         *cancellable,
+                                                  GAsyncReadyCallback   callback,
+                                                  gpointer              user_data);
+DBusGConnection * _mdu_ssh_bridge_connect_finish (GAsyncResult         *res,
+                                                  GError              **error);
+void              _mdu_ssh_bridge_release        (DBusGConnection      *connection);
+gboolean          _mdu_ssh_bridge_get_bytes_transferred (DBusGConnection *connection,
+                                                         guint64         *out_bytes_received,
+                                                         guint64         *out_bytes_sent);
 
 #endif /* __MDU_SSH_BRIDGE_H */
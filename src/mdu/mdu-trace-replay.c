@@ -0,0 +1,137 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-trace-replay.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/* Replays a trace recorded with MDU_POOL_TRACE into an offline pool
+ * without any UI and reports how long it took and how many signals the
+ * pool emitted. Useful for profiling the pool with e.g. perf or
+ * valgrind --tool=callgrind. To profile the UI, run the application with
+ * MDU_POOL_REPLAY set instead - see mdu-trace.c.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <dbus/dbus-glib.h>
+#include <stdio.h>
+
+#include "mdu-pool.h"
+#include "mdu-private.h"
+#include "mdu-trace.h"
+
+static gboolean opt_real_time = FALSE;
+
+static GOptionEntry entries[] = {
+        { "real-time", 'r', 0, G_OPTION_ARG_NONE, &opt_real_time, "Replay with the timing of the original trace instead of as fast as possible", NULL },
+        { NULL }
+};
+
+static const gchar *pool_signals[] = {
+        "device-added",
+        "device-removed",
+        "device-changed",
+        "device-job-changed",
+        "presentable-added",
+        "presentable-removed",
+        "presentable-changed",
+        "presentable-job-changed",
+        NULL
+};
+
+static guint signal_counts[G_N_ELEMENTS (pool_signals)];
+
+static void
+on_pool_signal (MduPool *pool, gpointer object, gpointer user_data)
+{
+        signal_counts[GPOINTER_TO_UINT (user_data)]++;
+}
+
+static void
+on_replay_done (MduPool *pool, gpointer user_data)
+{
+        GMainLoop *loop = user_data;
+
+        g_main_loop_quit (loop);
+}
+
+int
+main (int argc, char *argv[])
+{
+        GOptionContext *context;
+        GError *error;
+        GMainLoop *loop;
+        GTimer *timer;
+        MduPool *pool;
+        guint n;
+        int ret;
+
+        ret = 1;
+        loop = NULL;
+        timer = NULL;
+        pool = NULL;
+
+        g_type_init ();
+
+        context = g_option_context_new ("TRACE-FILE - replay a trace into an offline pool");
+        g_option_context_add_main_entries (context, entries, NULL);
+        error = NULL;
+        if (!g_option_context_parse (context, &argc, &argv, &error)) {
+                g_printerr ("Could not parse arguments: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+        if (argc != 2) {
+                g_printerr ("No trace file given\n");
+                goto out;
+        }
+
+        loop = g_main_loop_new (NULL, FALSE);
+
+        timer = g_timer_new ();
+        pool = _mdu_trace_replay (argv[1], opt_real_time, on_replay_done, loop, &error);
+        if (pool == NULL) {
+                g_printerr ("Error loading trace: %s\n", error->message);
+                g_error_free (error);
+                goto out;
+        }
+        g_print ("Loaded trace and primed pool in %.3f seconds\n", g_timer_elapsed (timer, NULL));
+
+        for (n = 0; pool_signals[n] != NULL; n++)
+                g_signal_connect (pool, pool_signals[n], G_CALLBACK (on_pool_signal), GUINT_TO_POINTER (n));
+
+        g_timer_start (timer);
+        g_main_loop_run (loop);
+        g_print ("Replayed trace in %.3f seconds\n", g_timer_elapsed (timer, NULL));
+
+        for (n = 0; pool_signals[n] != NULL; n++)
+                g_print ("  %-24s %8u\n", pool_signals[n], signal_counts[n]);
+
+        ret = 0;
+
+ out:
+        if (pool != NULL)
+                g_object_unref (pool);
+        if (timer != NULL)
+                g_timer_destroy (timer);
+        if (loop != NULL)
+                g_main_loop_unref (loop);
+        g_option_context_free (context);
+        return ret;
+}
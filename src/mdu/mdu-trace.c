@@ -0,0 +1,1168 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-trace.c
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/* Recording of the traffic between a MduPool and the udisks daemon and
+ * replaying it into an offline pool.
+ *
+ * A trace is started for the local pool when the MDU_POOL_TRACE
+ * environment variable is set to a file name (remote pools use the file
+ * name with the address appended). Every further pool recording to the
+ * same file name in a process gets its own file with a counter appended,
+ * e.g. trace, trace.2, trace.3 and so on. Setting MDU_POOL_REPLAY to the name of
+ * a trace file makes mdu_pool_new() return a pool replaying that trace
+ * instead of connecting to the daemon; the trace is replayed with the
+ * original timing unless MDU_POOL_REPLAY_FAST is set.
+ *
+ * The file format is (all integers are little endian)
+ *
+ *   header:  "MDUTRACE" guint32 version
+ *   record:  guint8 kind, guint64 usec since start of trace, payload
+ *
+ * where the payload depends on the kind
+ *
+ *   RECORD_GET_ALL:      string object_path, string interface_name,
+ *                        guint32 num_properties (G_MAXUINT32 if GetAll() failed),
+ *                        num_properties * (string name, value)
+ *   RECORD_SIGNAL:       string member, string object_path
+ *   RECORD_JOB_CHANGED:  string object_path, guint8 job_in_progress, string job_id,
+ *                        guint32 job_initiated_by_uid, guint8 job_is_cancellable,
+ *                        double job_percentage
+ *
+ * and strings are a guint32 length followed by the bytes (without the
+ * terminating NUL). Values are a string with the D-Bus signature followed
+ * by the data; arrays are a guint32 count followed by the elements and
+ * structs are the members one after another.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <dbus/dbus-glib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "mdu-pool.h"
+#include "mdu-error.h"
+#include "mdu-private.h"
+#include "mdu-trace.h"
+
+#define TRACE_MAGIC   "MDUTRACE"
+#define TRACE_VERSION 1
+
+enum {
+        RECORD_GET_ALL     = 1,
+        RECORD_SIGNAL      = 2,
+        RECORD_JOB_CHANGED = 3
+};
+
+struct _MduTrace
+{
+        FILE *file;
+        GTimer *timer;
+};
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+static void
+append_u8 (GString *s, guint8 val)
+{
+        g_string_append_c (s, val);
+}
+
+static void
+append_u32 (GString *s, guint32 val)
+{
+        val = GUINT32_TO_LE (val);
+        g_string_append_len (s, (const gchar *) &val, sizeof val);
+}
+
+static void
+append_u64 (GString *s, guint64 val)
+{
+        val = GUINT64_TO_LE (val);
+        g_string_append_len (s, (const gchar *) &val, sizeof val);
+}
+
+static void
+append_double (GString *s, gdouble val)
+{
+        guint64 bits;
+
+        memcpy (&bits, &val, sizeof bits);
+        append_u64 (s, bits);
+}
+
+static void
+append_string (GString *s, const gchar *str)
+{
+        gsize len;
+
+        len = str != NULL ? strlen (str) : 0;
+        append_u32 (s, len);
+        g_string_append_len (s, str, len);
+}
+
+static gboolean
+is_fixed_type (GType type)
+{
+        return type == G_TYPE_BOOLEAN ||
+                type == G_TYPE_UCHAR ||
+                type == G_TYPE_INT ||
+                type == G_TYPE_UINT ||
+                type == G_TYPE_INT64 ||
+                type == G_TYPE_UINT64 ||
+                type == G_TYPE_DOUBLE;
+}
+
+static gboolean
+append_signature (GString *s, GType type)
+{
+        gboolean ret;
+
+        ret = TRUE;
+        if (type == G_TYPE_BOOLEAN) {
+                g_string_append_c (s, 'b');
+        } else if (type == G_TYPE_UCHAR) {
+                g_string_append_c (s, 'y');
+        } else if (type == G_TYPE_INT) {
+                g_string_append_c (s, 'i');
+        } else if (type == G_TYPE_UINT) {
+                g_string_append_c (s, 'u');
+        } else if (type == G_TYPE_INT64) {
+                g_string_append_c (s, 'x');
+        } else if (type == G_TYPE_UINT64) {
+                g_string_append_c (s, 't');
+        } else if (type == G_TYPE_DOUBLE) {
+                g_string_append_c (s, 'd');
+        } else if (type == G_TYPE_STRING) {
+                g_string_append_c (s, 's');
+        } else if (type == DBUS_TYPE_G_OBJECT_PATH) {
+                g_string_append_c (s, 'o');
+        } else if (type == G_TYPE_STRV) {
+                g_string_append (s, "as");
+        } else if (dbus_g_type_is_collection (type)) {
+                g_string_append_c (s, 'a');
+                ret = append_signature (s, dbus_g_type_get_collection_specialization (type));
+        } else if (dbus_g_type_is_struct (type)) {
+                guint n;
+
+                g_string_append_c (s, '(');
+                for (n = 0; n < dbus_g_type_get_struct_size (type) && ret; n++)
+                        ret = append_signature (s, dbus_g_type_get_struct_member_type (type, n));
+                g_string_append_c (s, ')');
+        } else {
+                ret = FALSE;
+        }
+
+        return ret;
+}
+
+static void append_value_data (GString *s, const GValue *value);
+
+typedef struct {
+        GString *s;
+        guint count;
+} AppendElementData;
+
+static void
+append_element (const GValue *value, gpointer user_data)
+{
+        AppendElementData *data = user_data;
+
+        append_value_data (data->s, value);
+        data->count++;
+}
+
+/* the type of @value must have been checked with append_signature() */
+static void
+append_value_data (GString *s, const GValue *value)
+{
+        GType type;
+
+        type = G_VALUE_TYPE (value);
+        if (type == G_TYPE_BOOLEAN) {
+                append_u8 (s, g_value_get_boolean (value) ? 1 : 0);
+        } else if (type == G_TYPE_UCHAR) {
+                append_u8 (s, g_value_get_uchar (value));
+        } else if (type == G_TYPE_INT) {
+                append_u32 (s, g_value_get_int (value));
+        } else if (type == G_TYPE_UINT) {
+                append_u32 (s, g_value_get_uint (value));
+        } else if (type == G_TYPE_INT64) {
+                append_u64 (s, g_value_get_int64 (value));
+        } else if (type == G_TYPE_UINT64) {
+                append_u64 (s, g_value_get_uint64 (value));
+        } else if (type == G_TYPE_DOUBLE) {
+                append_double (s, g_value_get_double (value));
+        } else if (type == G_TYPE_STRING) {
+                append_string (s, g_value_get_string (value));
+        } else if (type == DBUS_TYPE_G_OBJECT_PATH) {
+                append_string (s, g_value_get_boxed (value));
+        } else if (type == G_TYPE_STRV) {
+                gchar **strv;
+                guint n;
+
+                strv = g_value_get_boxed (value);
+                append_u32 (s, strv != NULL ? g_strv_length (strv) : 0);
+                for (n = 0; strv != NULL && strv[n] != NULL; n++)
+                        append_string (s, strv[n]);
+        } else if (dbus_g_type_is_collection (type)) {
+                AppendElementData data;
+
+                data.s = g_string_new (NULL);
+                data.count = 0;
+                dbus_g_type_collection_value_iterate (value, append_element, &data);
+                append_u32 (s, data.count);
+                g_string_append_len (s, data.s->str, data.s->len);
+                g_string_free (data.s, TRUE);
+        } else if (dbus_g_type_is_struct (type)) {
+                guint n;
+
+                for (n = 0; n < dbus_g_type_get_struct_size (type); n++) {
+                        GValue member = {0};
+
+                        g_value_init (&member, dbus_g_type_get_struct_member_type (type, n));
+                        dbus_g_type_struct_get_member (value, n, &member);
+                        append_value_data (s, &member);
+                        g_value_unset (&member);
+                }
+        } else {
+                g_assert_not_reached ();
+        }
+}
+
+/* appends (name, value) pairs for all properties we can serialize; if @sorted is
+ * TRUE they are appended ordered by name so equal property sets give equal output
+ */
+static guint
+append_properties (GString      *s,
+                   const gchar  *object_path,
+                   GHashTable   *properties,
+                   gboolean      sorted)
+{
+        GList *names;
+        GList *l;
+        guint num_props;
+
+        names = g_hash_table_get_keys (properties);
+        if (sorted)
+                names = g_list_sort (names, (GCompareFunc) strcmp);
+
+        num_props = 0;
+        for (l = names; l != NULL; l = l->next) {
+                const gchar *name = l->data;
+                GValue *value;
+                GString *signature;
+
+                value = g_hash_table_lookup (properties, name);
+                signature = g_string_new (NULL);
+                if (!append_signature (signature, G_VALUE_TYPE (value))) {
+                        g_warning ("Not recording property %s of type %s on %s",
+                                   name,
+                                   G_VALUE_TYPE_NAME (value),
+                                   object_path);
+                        g_string_free (signature, TRUE);
+                        continue;
+                }
+                append_string (s, name);
+                append_string (s, signature->str);
+                append_value_data (s, value);
+                g_string_free (signature, TRUE);
+                num_props++;
+        }
+        g_list_free (names);
+
+        return num_props;
+}
+
+/**
+ * _mdu_trace_checksum_properties:
+ * @object_path: The object the properties are for, used in warnings.
+ * @properties: A #GHashTable from property names to #GValue instances as returned by GetAll().
+ *
+ * Computes a checksum of @properties using the same serialization as
+ * traces. Two replies with the same properties and values give the same
+ * checksum regardless of the order of the hash table.
+ *
+ * Returns: The checksum as a hex string. Free with g_free().
+ */
+gchar *
+_mdu_trace_checksum_properties (const gchar *object_path,
+                                GHashTable  *properties)
+{
+        GString *s;
+        gchar *ret;
+
+        s = g_string_new (NULL);
+        append_properties (s, object_path, properties, TRUE);
+        ret = g_compute_checksum_for_data (G_CHECKSUM_SHA1, (const guchar *) s->str, s->len);
+        g_string_free (s, TRUE);
+
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+/* file name -> number of traces started for it by this process */
+static GHashTable *filename_to_num_traces = NULL;
+
+/**
+ * _mdu_trace_new:
+ * @filename: The file to write the trace to.
+ * @error: Return location for error.
+ *
+ * Creates a new trace writing to @filename. Any existing file is truncated.
+ * If a trace was already started for @filename in this process, the
+ * trace is written to @filename with a counter appended instead so the
+ * traces of different pools don't overwrite each other.
+ *
+ * Returns: A #MduTrace or %NULL if @error is set. Free with _mdu_trace_free().
+ */
+MduTrace *
+_mdu_trace_new (const gchar  *filename,
+                GError      **error)
+{
+        MduTrace *trace;
+        GString *s;
+        gchar *actual_filename;
+        guint num_traces;
+
+        trace = NULL;
+
+        if (filename_to_num_traces == NULL)
+                filename_to_num_traces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        num_traces = GPOINTER_TO_UINT (g_hash_table_lookup (filename_to_num_traces, filename)) + 1;
+        g_hash_table_insert (filename_to_num_traces, g_strdup (filename), GUINT_TO_POINTER (num_traces));
+        if (num_traces == 1)
+                actual_filename = g_strdup (filename);
+        else
+                actual_filename = g_strdup_printf ("%s.%u", filename, num_traces);
+
+        s = g_string_new (TRACE_MAGIC);
+        append_u32 (s, TRACE_VERSION);
+
+        trace = g_new0 (MduTrace, 1);
+        trace->file = fopen (actual_filename, "w");
+        if (trace->file == NULL) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Error opening trace file %s: %s",
+                             actual_filename,
+                             g_strerror (errno));
+                g_free (trace);
+                trace = NULL;
+                goto out;
+        }
+        fwrite (s->str, 1, s->len, trace->file);
+        trace->timer = g_timer_new ();
+
+ out:
+        g_free (actual_filename);
+        g_string_free (s, TRUE);
+        return trace;
+}
+
+void
+_mdu_trace_free (MduTrace *trace)
+{
+        fclose (trace->file);
+        g_timer_destroy (trace->timer);
+        g_free (trace);
+}
+
+static GString *
+record_new (MduTrace *trace, guint8 kind)
+{
+        GString *s;
+
+        s = g_string_new (NULL);
+        append_u8 (s, kind);
+        append_u64 (s, g_timer_elapsed (trace->timer, NULL) * G_USEC_PER_SEC);
+
+        return s;
+}
+
+static void
+record_write (MduTrace *trace, GString *s)
+{
+        /* flush every record so the trace is complete even if the process crashes */
+        fwrite (s->str, 1, s->len, trace->file);
+        fflush (trace->file);
+        g_string_free (s, TRUE);
+}
+
+/**
+ * _mdu_trace_record_get_all:
+ * @trace: A #MduTrace.
+ * @object_path: The object GetAll() was invoked on.
+ * @interface_name: The interface GetAll() was invoked for.
+ * @properties: The result of GetAll() or %NULL if the call failed.
+ *
+ * Records the reply of a GetAll() call.
+ */
+void
+_mdu_trace_record_get_all (MduTrace     *trace,
+                           const gchar  *object_path,
+                           const gchar  *interface_name,
+                           GHashTable   *properties)
+{
+        GString *s;
+        GString *props;
+        guint num_props;
+
+        s = record_new (trace, RECORD_GET_ALL);
+        append_string (s, object_path);
+        append_string (s, interface_name);
+
+        if (properties == NULL) {
+                append_u32 (s, G_MAXUINT32);
+                goto out;
+        }
+
+        props = g_string_new (NULL);
+        num_props = append_properties (props, object_path, properties, FALSE);
+        append_u32 (s, num_props);
+        g_string_append_len (s, props->str, props->len);
+        g_string_free (props, TRUE);
+
+ out:
+        record_write (trace, s);
+}
+
+/**
+ * _mdu_trace_record_signal:
+ * @trace: A #MduTrace.
+ * @member: The name of the signal, e.g. DeviceChanged.
+ * @object_path: The object path passed in the signal.
+ *
+ * Records one of the *Added, *Removed or *Changed signals from the daemon.
+ */
+void
+_mdu_trace_record_signal (MduTrace     *trace,
+                          const gchar  *member,
+                          const gchar  *object_path)
+{
+        GString *s;
+
+        s = record_new (trace, RECORD_SIGNAL);
+        append_string (s, member);
+        append_string (s, object_path);
+        record_write (trace, s);
+}
+
+void
+_mdu_trace_record_job_changed (MduTrace     *trace,
+                               const gchar  *object_path,
+                               gboolean      job_in_progress,
+                               const gchar  *job_id,
+                               uid_t         job_initiated_by_uid,
+                               gboolean      job_is_cancellable,
+                               gdouble       job_percentage)
+{
+        GString *s;
+
+        s = record_new (trace, RECORD_JOB_CHANGED);
+        append_string (s, object_path);
+        append_u8 (s, job_in_progress ? 1 : 0);
+        append_string (s, job_id);
+        append_u32 (s, job_initiated_by_uid);
+        append_u8 (s, job_is_cancellable ? 1 : 0);
+        append_double (s, job_percentage);
+        record_write (trace, s);
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct {
+        const guchar *data;
+        gsize len;
+        gsize pos;
+} Reader;
+
+static gboolean
+read_bytes (Reader *r, gsize num_bytes, const guchar **out_bytes)
+{
+        if (r->len - r->pos < num_bytes)
+                return FALSE;
+        *out_bytes = r->data + r->pos;
+        r->pos += num_bytes;
+        return TRUE;
+}
+
+static gboolean
+read_u8 (Reader *r, guint8 *out_val)
+{
+        const guchar *bytes;
+
+        if (!read_bytes (r, 1, &bytes))
+                return FALSE;
+        *out_val = bytes[0];
+        return TRUE;
+}
+
+static gboolean
+read_u32 (Reader *r, guint32 *out_val)
+{
+        const guchar *bytes;
+        guint32 val;
+
+        if (!read_bytes (r, sizeof val, &bytes))
+                return FALSE;
+        memcpy (&val, bytes, sizeof val);
+        *out_val = GUINT32_FROM_LE (val);
+        return TRUE;
+}
+
+static gboolean
+read_u64 (Reader *r, guint64 *out_val)
+{
+        const guchar *bytes;
+        guint64 val;
+
+        if (!read_bytes (r, sizeof val, &bytes))
+                return FALSE;
+        memcpy (&val, bytes, sizeof val);
+        *out_val = GUINT64_FROM_LE (val);
+        return TRUE;
+}
+
+static gboolean
+read_double (Reader *r, gdouble *out_val)
+{
+        guint64 bits;
+
+        if (!read_u64 (r, &bits))
+                return FALSE;
+        memcpy (out_val, &bits, sizeof bits);
+        return TRUE;
+}
+
+static gboolean
+read_string (Reader *r, gchar **out_str)
+{
+        const guchar *bytes;
+        guint32 len;
+
+        if (!read_u32 (r, &len))
+                return FALSE;
+        if (!read_bytes (r, len, &bytes))
+                return FALSE;
+        *out_str = g_strndup ((const gchar *) bytes, len);
+        return TRUE;
+}
+
+static GType
+parse_signature (const gchar **signature)
+{
+        GType ret;
+
+        ret = G_TYPE_INVALID;
+        switch (*(*signature)++) {
+        case 'b':
+                ret = G_TYPE_BOOLEAN;
+                break;
+        case 'y':
+                ret = G_TYPE_UCHAR;
+                break;
+        case 'i':
+                ret = G_TYPE_INT;
+                break;
+        case 'u':
+                ret = G_TYPE_UINT;
+                break;
+        case 'x':
+                ret = G_TYPE_INT64;
+                break;
+        case 't':
+                ret = G_TYPE_UINT64;
+                break;
+        case 'd':
+                ret = G_TYPE_DOUBLE;
+                break;
+        case 's':
+                ret = G_TYPE_STRING;
+                break;
+        case 'o':
+                ret = DBUS_TYPE_G_OBJECT_PATH;
+                break;
+        case 'a':
+                if (**signature == 's') {
+                        (*signature)++;
+                        ret = G_TYPE_STRV;
+                } else {
+                        GType element_type;
+
+                        /* same container types as dbus-glib uses when demarshalling */
+                        element_type = parse_signature (signature);
+                        if (element_type != G_TYPE_INVALID)
+                                ret = dbus_g_type_get_collection (is_fixed_type (element_type) ? "GArray" : "GPtrArray",
+                                                                  element_type);
+                }
+                break;
+        case '(': {
+                GArray *types;
+
+                types = g_array_new (FALSE, FALSE, sizeof (GType));
+                while (**signature != ')' && **signature != '\0') {
+                        GType member_type;
+
+                        member_type = parse_signature (signature);
+                        if (member_type == G_TYPE_INVALID)
+                                break;
+                        g_array_append_val (types, member_type);
+                }
+                if (**signature == ')') {
+                        (*signature)++;
+                        ret = dbus_g_type_get_structv ("GValueArray", types->len, (GType *) types->data);
+                }
+                g_array_free (types, TRUE);
+                break;
+        }
+        default:
+                break;
+        }
+
+        return ret;
+}
+
+static gboolean
+read_value_data (Reader *r, GType type, GValue *value)
+{
+        gboolean ret;
+
+        ret = FALSE;
+
+        if (type == G_TYPE_BOOLEAN || type == G_TYPE_UCHAR) {
+                guint8 val;
+
+                if (!read_u8 (r, &val))
+                        goto out;
+                g_value_init (value, type);
+                if (type == G_TYPE_BOOLEAN)
+                        g_value_set_boolean (value, val != 0);
+                else
+                        g_value_set_uchar (value, val);
+        } else if (type == G_TYPE_INT || type == G_TYPE_UINT) {
+                guint32 val;
+
+                if (!read_u32 (r, &val))
+                        goto out;
+                g_value_init (value, type);
+                if (type == G_TYPE_INT)
+                        g_value_set_int (value, (gint32) val);
+                else
+                        g_value_set_uint (value, val);
+        } else if (type == G_TYPE_INT64 || type == G_TYPE_UINT64) {
+                guint64 val;
+
+                if (!read_u64 (r, &val))
+                        goto out;
+                g_value_init (value, type);
+                if (type == G_TYPE_INT64)
+                        g_value_set_int64 (value, (gint64) val);
+                else
+                        g_value_set_uint64 (value, val);
+        } else if (type == G_TYPE_DOUBLE) {
+                gdouble val;
+
+                if (!read_double (r, &val))
+                        goto out;
+                g_value_init (value, type);
+                g_value_set_double (value, val);
+        } else if (type == G_TYPE_STRING || type == DBUS_TYPE_G_OBJECT_PATH) {
+                gchar *str;
+
+                if (!read_string (r, &str))
+                        goto out;
+                g_value_init (value, type);
+                if (type == G_TYPE_STRING)
+                        g_value_take_string (value, str);
+                else
+                        g_value_take_boxed (value, str);
+        } else if (type == G_TYPE_STRV) {
+                gchar **strv;
+                guint32 count;
+                guint n;
+
+                if (!read_u32 (r, &count) || count > r->len - r->pos)
+                        goto out;
+                strv = g_new0 (gchar *, count + 1);
+                for (n = 0; n < count; n++) {
+                        if (!read_string (r, &(strv[n]))) {
+                                g_strfreev (strv);
+                                goto out;
+                        }
+                }
+                g_value_init (value, type);
+                g_value_take_boxed (value, strv);
+        } else if (dbus_g_type_is_collection (type)) {
+                GType element_type;
+                GArray *array;
+                GPtrArray *ptr_array;
+                guint32 count;
+                guint n;
+
+                element_type = dbus_g_type_get_collection_specialization (type);
+                if (!read_u32 (r, &count) || count > r->len - r->pos)
+                        goto out;
+
+                array = NULL;
+                ptr_array = NULL;
+                if (is_fixed_type (element_type)) {
+                        gsize element_size;
+
+                        if (element_type == G_TYPE_UCHAR)
+                                element_size = sizeof (guchar);
+                        else if (element_type == G_TYPE_BOOLEAN)
+                                element_size = sizeof (gboolean);
+                        else if (element_type == G_TYPE_INT || element_type == G_TYPE_UINT)
+                                element_size = sizeof (guint32);
+                        else
+                                element_size = sizeof (guint64);
+                        array = g_array_sized_new (FALSE, TRUE, element_size, count);
+                } else {
+                        ptr_array = g_ptr_array_sized_new (count);
+                }
+
+                for (n = 0; n < count; n++) {
+                        GValue element = {0};
+
+                        if (!read_value_data (r, element_type, &element)) {
+                                if (array != NULL) {
+                                        g_array_free (array, TRUE);
+                                } else {
+                                        g_value_init (value, type);
+                                        g_value_take_boxed (value, ptr_array);
+                                        g_value_unset (value);
+                                }
+                                goto out;
+                        }
+
+                        if (element_type == G_TYPE_UCHAR) {
+                                guchar val = g_value_get_uchar (&element);
+                                g_array_append_val (array, val);
+                        } else if (element_type == G_TYPE_BOOLEAN) {
+                                gboolean val = g_value_get_boolean (&element);
+                                g_array_append_val (array, val);
+                        } else if (element_type == G_TYPE_INT) {
+                                gint32 val = g_value_get_int (&element);
+                                g_array_append_val (array, val);
+                        } else if (element_type == G_TYPE_UINT) {
+                                guint32 val = g_value_get_uint (&element);
+                                g_array_append_val (array, val);
+                        } else if (element_type == G_TYPE_INT64) {
+                                gint64 val = g_value_get_int64 (&element);
+                                g_array_append_val (array, val);
+                        } else if (element_type == G_TYPE_UINT64) {
+                                guint64 val = g_value_get_uint64 (&element);
+                                g_array_append_val (array, val);
+                        } else if (element_type == G_TYPE_DOUBLE) {
+                                gdouble val = g_value_get_double (&element);
+                                g_array_append_val (array, val);
+                        } else if (element_type == G_TYPE_STRING) {
+                                g_ptr_array_add (ptr_array, g_value_dup_string (&element));
+                        } else {
+                                g_ptr_array_add (ptr_array, g_value_dup_boxed (&element));
+                        }
+                        g_value_unset (&element);
+                }
+
+                g_value_init (value, type);
+                if (array != NULL)
+                        g_value_take_boxed (value, array);
+                else
+                        g_value_take_boxed (value, ptr_array);
+        } else if (dbus_g_type_is_struct (type)) {
+                guint n;
+
+                g_value_init (value, type);
+                g_value_take_boxed (value, dbus_g_type_specialized_construct (type));
+                for (n = 0; n < dbus_g_type_get_struct_size (type); n++) {
+                        GValue member = {0};
+
+                        if (!read_value_data (r, dbus_g_type_get_struct_member_type (type, n), &member)) {
+                                g_value_unset (value);
+                                goto out;
+                        }
+                        dbus_g_type_struct_set_member (value, n, &member);
+                        g_value_unset (&member);
+                }
+        } else {
+                goto out;
+        }
+
+        ret = TRUE;
+
+ out:
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct {
+        guint8 kind;
+        guint64 usec;
+
+        gchar *object_path;
+
+        /* RECORD_GET_ALL */
+        gchar *interface_name;
+        GHashTable *properties;
+
+        /* RECORD_SIGNAL */
+        gchar *member;
+
+        /* RECORD_JOB_CHANGED */
+        gboolean job_in_progress;
+        gchar *job_id;
+        guint32 job_initiated_by_uid;
+        gboolean job_is_cancellable;
+        gdouble job_percentage;
+} TraceRecord;
+
+static void
+trace_record_free (TraceRecord *record)
+{
+        g_free (record->object_path);
+        g_free (record->interface_name);
+        if (record->properties != NULL)
+                g_hash_table_unref (record->properties);
+        g_free (record->member);
+        g_free (record->job_id);
+        g_free (record);
+}
+
+static void
+value_free (GValue *value)
+{
+        g_value_unset (value);
+        g_free (value);
+}
+
+static gboolean
+read_get_all_payload (Reader *r, TraceRecord *record)
+{
+        gboolean ret;
+        guint32 num_props;
+        guint n;
+
+        ret = FALSE;
+
+        if (!read_string (r, &record->object_path) ||
+            !read_string (r, &record->interface_name) ||
+            !read_u32 (r, &num_props))
+                goto out;
+
+        /* GetAll() failed */
+        if (num_props == G_MAXUINT32) {
+                ret = TRUE;
+                goto out;
+        }
+
+        record->properties = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) value_free);
+        for (n = 0; n < num_props; n++) {
+                gchar *name;
+                gchar *signature;
+                const gchar *s;
+                GType type;
+                GValue *value;
+
+                if (!read_string (r, &name))
+                        goto out;
+                if (!read_string (r, &signature)) {
+                        g_free (name);
+                        goto out;
+                }
+
+                s = signature;
+                type = parse_signature (&s);
+                g_free (signature);
+                if (type == G_TYPE_INVALID || *s != '\0') {
+                        g_free (name);
+                        goto out;
+                }
+
+                value = g_new0 (GValue, 1);
+                if (!read_value_data (r, type, value)) {
+                        g_free (value);
+                        g_free (name);
+                        goto out;
+                }
+                g_hash_table_insert (record->properties, name, value);
+        }
+
+        ret = TRUE;
+
+ out:
+        return ret;
+}
+
+static GPtrArray *
+trace_load (const gchar *filename, GError **error)
+{
+        GPtrArray *ret;
+        GMappedFile *mapped_file;
+        Reader r;
+        const guchar *magic;
+        guint32 version;
+
+        ret = NULL;
+
+        mapped_file = g_mapped_file_new (filename, FALSE, error);
+        if (mapped_file == NULL)
+                goto out;
+
+        r.data = (const guchar *) g_mapped_file_get_contents (mapped_file);
+        r.len = g_mapped_file_get_length (mapped_file);
+        r.pos = 0;
+
+        if (!read_bytes (&r, strlen (TRACE_MAGIC), &magic) ||
+            memcmp (magic, TRACE_MAGIC, strlen (TRACE_MAGIC)) != 0 ||
+            !read_u32 (&r, &version)) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "%s is not a trace file",
+                             filename);
+                goto out;
+        }
+        if (version != TRACE_VERSION) {
+                g_set_error (error,
+                             MDU_ERROR,
+                             MDU_ERROR_FAILED,
+                             "Unsupported trace version %d in %s",
+                             version,
+                             filename);
+                goto out;
+        }
+
+        ret = g_ptr_array_new ();
+        while (r.pos < r.len) {
+                TraceRecord *record;
+                gboolean ok;
+                guint8 u8;
+
+                record = g_new0 (TraceRecord, 1);
+                ok = read_u8 (&r, &record->kind) && read_u64 (&r, &record->usec);
+                if (ok) {
+                        switch (record->kind) {
+                        case RECORD_GET_ALL:
+                                ok = read_get_all_payload (&r, record);
+                                break;
+                        case RECORD_SIGNAL:
+                                ok = read_string (&r, &record->member) &&
+                                        read_string (&r, &record->object_path);
+                                break;
+                        case RECORD_JOB_CHANGED:
+                                ok = read_string (&r, &record->object_path) &&
+                                        read_u8 (&r, &u8) &&
+                                        read_string (&r, &record->job_id) &&
+                                        read_u32 (&r, &record->job_initiated_by_uid);
+                                record->job_in_progress = (u8 != 0);
+                                ok = ok && read_u8 (&r, &u8) && read_double (&r, &record->job_percentage);
+                                record->job_is_cancellable = (u8 != 0);
+                                break;
+                        default:
+                                ok = FALSE;
+                                break;
+                        }
+                }
+
+                if (!ok) {
+                        /* a trace cut short by a crash is still useful - replay what we have */
+                        g_warning ("Ignoring malformed or truncated record at offset %" G_GSIZE_FORMAT " in %s",
+                                   r.pos,
+                                   filename);
+                        trace_record_free (record);
+                        break;
+                }
+
+                g_ptr_array_add (ret, record);
+        }
+
+ out:
+        if (mapped_file != NULL)
+                g_mapped_file_unref (mapped_file);
+        return ret;
+}
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct {
+        MduPool *pool;
+        GPtrArray *records;
+        guint next_record;
+        gboolean real_time;
+        GTimer *timer;
+        guint64 start_usec;
+        MduTraceReplayDoneFunc done_func;
+        gpointer user_data;
+} Replay;
+
+static void
+replay_free (Replay *replay)
+{
+        g_ptr_array_foreach (replay->records, (GFunc) trace_record_free, NULL);
+        g_ptr_array_free (replay->records, TRUE);
+        g_timer_destroy (replay->timer);
+        g_object_unref (replay->pool);
+        g_free (replay);
+}
+
+/* GetAll() replies following an event were made while handling that event
+ * so they must be available before the event is dispatched
+ */
+static void
+replay_apply_get_all_records (Replay *replay)
+{
+        while (replay->next_record < replay->records->len) {
+                TraceRecord *record = replay->records->pdata[replay->next_record];
+
+                if (record->kind != RECORD_GET_ALL)
+                        break;
+
+                _mdu_pool_offline_set_object (replay->pool,
+                                              record->object_path,
+                                              record->interface_name,
+                                              record->properties);
+                replay->next_record++;
+        }
+}
+
+static void
+replay_dispatch_next (Replay *replay)
+{
+        TraceRecord *record;
+
+        record = replay->records->pdata[replay->next_record++];
+        replay_apply_get_all_records (replay);
+
+        switch (record->kind) {
+        case RECORD_SIGNAL:
+                _mdu_pool_offline_dispatch_signal (replay->pool,
+                                                   record->member,
+                                                   record->object_path);
+                break;
+        case RECORD_JOB_CHANGED:
+                _mdu_pool_offline_dispatch_job_changed (replay->pool,
+                                                        record->object_path,
+                                                        record->job_in_progress,
+                                                        record->job_id,
+                                                        record->job_initiated_by_uid,
+                                                        record->job_is_cancellable,
+                                                        record->job_percentage);
+                break;
+        default:
+                break;
+        }
+}
+
+static gboolean
+on_replay_timeout (gpointer user_data)
+{
+        Replay *replay = user_data;
+
+        while (replay->next_record < replay->records->len) {
+                if (replay->real_time) {
+                        TraceRecord *record;
+                        gint64 usec_until_due;
+
+                        record = replay->records->pdata[replay->next_record];
+                        usec_until_due = (gint64) (record->usec - replay->start_usec) -
+                                (gint64) (g_timer_elapsed (replay->timer, NULL) * G_USEC_PER_SEC);
+                        if (usec_until_due > 0) {
+                                g_timeout_add (MAX (usec_until_due / 1000, 1), on_replay_timeout, replay);
+                                goto out;
+                        }
+                        replay_dispatch_next (replay);
+                } else {
+                        /* dispatch one event per main loop iteration so idle handlers
+                         * (e.g. redrawing the UI) get to run just like with a real bus
+                         */
+                        replay_dispatch_next (replay);
+                        g_idle_add (on_replay_timeout, replay);
+                        goto out;
+                }
+        }
+
+        if (replay->done_func != NULL)
+                replay->done_func (replay->pool, replay->user_data);
+        replay_free (replay);
+
+ out:
+        return FALSE;
+}
+
+/**
+ * _mdu_trace_replay:
+ * @filename: A trace file written by #MduTrace.
+ * @real_time: %TRUE to replay with the timing of the original trace, %FALSE to replay as fast as possible.
+ * @done_func: Function to call when the whole trace has been replayed or %NULL.
+ * @user_data: User data to pass to @done_func.
+ * @error: Return location for error.
+ *
+ * Creates an offline #MduPool with the objects present when the trace in
+ * @filename was started and then replays the recorded signals into it from
+ * the main loop.
+ *
+ * Returns: A #MduPool or %NULL if @error is set. Free with g_object_unref().
+ */
+MduPool *
+_mdu_trace_replay (const gchar             *filename,
+                   gboolean                 real_time,
+                   MduTraceReplayDoneFunc   done_func,
+                   gpointer                 user_data,
+                   GError                 **error)
+{
+        MduPool *pool;
+        Replay *replay;
+
+        pool = NULL;
+
+        replay = g_new0 (Replay, 1);
+        replay->records = trace_load (filename, error);
+        if (replay->records == NULL) {
+                g_free (replay);
+                goto out;
+        }
+
+        pool = _mdu_pool_new_offline ();
+
+        replay->pool = g_object_ref (pool);
+        replay->real_time = real_time;
+        replay->done_func = done_func;
+        replay->user_data = user_data;
+
+        /* everything before the first signal is the enumeration done when the pool was created */
+        replay_apply_get_all_records (replay);
+        _mdu_pool_offline_prime (pool);
+
+        if (replay->next_record < replay->records->len)
+                replay->start_usec = ((TraceRecord *) replay->records->pdata[replay->next_record])->usec;
+        replay->timer = g_timer_new ();
+
+        g_idle_add (on_replay_timeout, replay);
+
+ out:
+        return pool;
+}
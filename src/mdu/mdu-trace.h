@@ -0,0 +1,63 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 8 -*- */
+/* mdu-trace.h
+ *
+ * Copyright (C) 2026 MATE Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#if defined (__MDU_INSIDE_MDU_H)
+#error "Can't include a private header in the public header file."
+#endif
+
+#ifndef __MDU_TRACE_H
+#define __MDU_TRACE_H
+
+#include <sys/types.h>
+#include "mdu-types.h"
+
+typedef struct _MduTrace MduTrace;
+
+typedef void (*MduTraceReplayDoneFunc) (MduPool  *pool,
+                                        gpointer  user_data);
+
+MduTrace *_mdu_trace_new                (const gchar  *filename,
+                                         GError      **error);
+void      _mdu_trace_free               (MduTrace     *trace);
+void      _mdu_trace_record_get_all     (MduTrace     *trace,
+                                         const gchar  *object_path,
+                                         const gchar  *interface_name,
+                                         GHashTable   *properties);
+void      _mdu_trace_record_signal      (MduTrace     *trace,
+                                         const gchar  *member,
+                                         const gchar  *object_path);
+void      _mdu_trace_record_job_changed (MduTrace     *trace,
+                                         const gchar  *object_path,
+                                         gboolean      job_in_progress,
+                                         const gchar  *job_id,
+                                         uid_t         job_initiated_by_uid,
+                                         gboolean      job_is_cancellable,
+                                         gdouble       job_percentage);
+gchar    *_mdu_trace_checksum_properties (const gchar  *object_path,
+                                         GHashTable   *properties);
+
+MduPool  *_mdu_trace_replay             (const gchar             *filename,
+                                         gboolean                 real_time,
+                                         MduTraceReplayDoneFunc   done_func,
+                                         gpointer                 user_data,
+                                         GError                 **error);
+
+#endif /* __MDU_TRACE_H */
@@ -63,6 +63,8 @@ typedef struct _MduMachine                MduMachine;
 
 typedef struct _MduKnownFilesystem        MduKnownFilesystem;
 typedef struct _MduProcess                MduProcess;
+typedef struct _MduBenchmark              MduBenchmark;
+typedef struct _MduBenchmarkHistory       MduBenchmarkHistory;
 
 G_END_DECLS
 
@@ -48,6 +48,8 @@
 #include <mdu/mdu-volume-hole.h>
 #include <mdu/mdu-hub.h>
 #include <mdu/mdu-machine.h>
+#include <mdu/mdu-benchmark.h>
+#include <mdu/mdu-benchmark-history.h>
 #include <mdu/mdu-callbacks.h>
 
 #undef __MDU_INSIDE_MDU_H